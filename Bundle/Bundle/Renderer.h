@@ -8,6 +8,7 @@
 #include "../../Core/includes/Mesh.h"
 #include "../../Core/includes/Model.h"
 #include "../../Core/includes/Shader.h"
+#include "../../Core/includes/ShaderCache.h"
 #include "../../Core/includes/Stdafx.h"
 #include "../../Core/includes/SwapChain.h"
 #include "../../Core/includes/Texture.h"
@@ -69,9 +70,11 @@ struct SceneConstant
 {
 	DirectX::XMFLOAT4X4 view;
 	DirectX::XMFLOAT4X4 proj;
+	DirectX::XMFLOAT4X4 viewProj;
+	DirectX::XMFLOAT4X4 invView;
 
 	DirectX::XMFLOAT3 cameraPosition;
-	float pad0;
+	float farDepth = 1.0f;
 
 	DirectX::XMFLOAT4 ambientLight;
 	std::array<Light, Light::maxNumLights> lights;
@@ -182,6 +185,7 @@ private:
 	CbvSrvUavDescriptor mCbvSrvUavDescriptor;
 
 	std::unordered_map<std::string, Shader> mShaders;
+	ShaderCache mShaderCache{ "ShaderCache" }; // bytecode of previous runs
 
 	std::unordered_map<std::string, RootSignature> mRootSignatures; // default count is 1
 	std::unordered_map<std::string, PipelineStateObject> mPSOs; // default count is 1
@@ -2,63 +2,89 @@
 
 const int BlurFilter::maxBlurRadius = 5;
 
-BlurFilter::BlurFilter(
-	ID3D12Device* device,
-	UINT width, UINT height, 
-	DXGI_FORMAT format)
+BlurFilter::BlurFilter(UINT width, UINT height, DXGI_FORMAT format)
 	: mWidth(width), mHeight(height), mFormat(format)
 {
-	BuildResources(device);
+
 }
 
-void BlurFilter::BuildResources(ID3D12Device* device)
+void BlurFilter::AddPasses(
+	RenderGraph& renderGraph,
+	D3D12RenderGraphBackend& renderGraphBackend,
+	GpuProfiler& gpuProfiler,
+	uint32_t inputTexture,
+	ID3D12RootSignature* rootSignature,
+	ID3D12PipelineState* horzBlurPSO,
+	ID3D12PipelineState* vertBlurPSO,
+	CbvSrvUavDescriptor& descriptorBuilder,
+	UINT descriptorSize,
+	int blurCount)
 {
-	D3D12_RESOURCE_DESC textureDesc;
-	textureDesc.Alignment = 0;
-	textureDesc.DepthOrArraySize = 1;
-	textureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-	textureDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
-	textureDesc.Format = mFormat;
-	textureDesc.Height = mHeight;
-	textureDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
-	textureDesc.MipLevels = 0;
-	textureDesc.SampleDesc.Count = 1;
-	textureDesc.SampleDesc.Quality = 0;
-	textureDesc.Width = mWidth;
+	assert(blurCount > 0);
 
-	ThrowIfFailed(device->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-		D3D12_HEAP_FLAG_NONE,
-		&textureDesc,
-		D3D12_RESOURCE_STATE_COMMON,
-		nullptr,
-		IID_PPV_ARGS(&mBlurMap0)));
-
-	ThrowIfFailed(device->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-		D3D12_HEAP_FLAG_NONE,
-		&textureDesc,
-		D3D12_RESOURCE_STATE_COMMON,
-		nullptr,
-		IID_PPV_ARGS(&mBlurMap1)));
+	D3D12_RESOURCE_DESC blurMapDesc = GetBlurMapDesc();
+	mBlurMap0 = renderGraphBackend.CreateTexture(renderGraph, "BlurMap0", blurMapDesc);
+	mBlurMap1 = renderGraphBackend.CreateTexture(renderGraph, "BlurMap1", blurMapDesc);
+
+	auto copyPass = renderGraph.AddPass("BlurCopy", [this, &renderGraphBackend, &gpuProfiler, inputTexture]()
+		{
+			gpuProfiler.BeginScope("Blur");
+
+			renderGraphBackend.GetCommandList()->CopyResource(renderGraphBackend.GetResource(mBlurMap0),
+				renderGraphBackend.GetResource(inputTexture));
+		});
+	renderGraph.Read(copyPass, inputTexture, RenderGraphState::CopySource);
+	renderGraph.Write(copyPass, mBlurMap0, RenderGraphState::CopyDest);
+
+	UINT numGroupsX = static_cast<UINT>(ceilf(static_cast<float>(mWidth) / 256.0f));
+	UINT numGroupsY = static_cast<UINT>(ceilf(static_cast<float>(mHeight) / 256.0f));
+
+	for (int i = 0; i < blurCount; i++)
+	{
+		auto horzPass = renderGraph.AddPass("HorzBlur", [=, &renderGraphBackend, &descriptorBuilder]()
+			{
+				Blur(renderGraphBackend.GetCommandList(), rootSignature, horzBlurPSO,
+					mBlurMap0SrvDescriptorIndex, mBlurMap1UavDescriptorIndex,
+					descriptorBuilder, descriptorSize, numGroupsX, mHeight);
+			});
+		renderGraph.Read(horzPass, mBlurMap0, RenderGraphState::ShaderResource);
+		renderGraph.Write(horzPass, mBlurMap1, RenderGraphState::UnorderedAccess);
+
+		bool isLast = i == blurCount - 1;
+		auto vertPass = renderGraph.AddPass("VertBlur", [=, &renderGraphBackend, &gpuProfiler, &descriptorBuilder]()
+			{
+				Blur(renderGraphBackend.GetCommandList(), rootSignature, vertBlurPSO,
+					mBlurMap1SrvDescriptorIndex, mBlurMap0UavDescriptorIndex,
+					descriptorBuilder, descriptorSize, mWidth, numGroupsY);
+
+				if (isLast)
+					gpuProfiler.EndScope();
+			});
+		renderGraph.Read(vertPass, mBlurMap1, RenderGraphState::ShaderResource);
+		renderGraph.Write(vertPass, mBlurMap0, RenderGraphState::UnorderedAccess);
+	}
 }
 
 void BlurFilter::BuildDescriptors(
 	ID3D12Device* device,
+	D3D12RenderGraphBackend& renderGraphBackend,
 	CbvSrvUavDescriptor& descriptorBuilder, 
 	UINT cbvSrvUavDescriptorSize)
 {
 	int currentDescriptorIndex = descriptorBuilder.GetCurrentDescriptorIndex();
 
+	auto blurMap0 = renderGraphBackend.GetResource(mBlurMap0);
+	auto blurMap1 = renderGraphBackend.GetResource(mBlurMap1);
+
 	descriptorBuilder.CreateShaderResourceView(device, cbvSrvUavDescriptorSize,
-		mFormat, D3D12_SRV_DIMENSION_TEXTURE2D, mBlurMap0.Get());
+		mFormat, D3D12_SRV_DIMENSION_TEXTURE2D, blurMap0);
 	descriptorBuilder.CreateUnorderedAccessView(device, cbvSrvUavDescriptorSize,
-		mFormat, D3D12_UAV_DIMENSION_TEXTURE2D, mBlurMap0.Get(), nullptr);
+		mFormat, D3D12_UAV_DIMENSION_TEXTURE2D, blurMap0, nullptr);
 
 	descriptorBuilder.CreateShaderResourceView(device, cbvSrvUavDescriptorSize,
-		mFormat, D3D12_SRV_DIMENSION_TEXTURE2D, mBlurMap1.Get());
+		mFormat, D3D12_SRV_DIMENSION_TEXTURE2D, blurMap1);
 	descriptorBuilder.CreateUnorderedAccessView(device, cbvSrvUavDescriptorSize,
-		mFormat, D3D12_UAV_DIMENSION_TEXTURE2D, mBlurMap1.Get(), nullptr);
+		mFormat, D3D12_UAV_DIMENSION_TEXTURE2D, blurMap1, nullptr);
 
 	mBlurMap0SrvDescriptorIndex = currentDescriptorIndex + 1;
 	mBlurMap0UavDescriptorIndex = currentDescriptorIndex + 2;
@@ -66,136 +92,77 @@ void BlurFilter::BuildDescriptors(
 	mBlurMap1UavDescriptorIndex = currentDescriptorIndex + 4;
 }
 
-void BlurFilter::Execute(
-	ID3D12GraphicsCommandList* commandList,
-	ID3D12RootSignature* rootSignature,
-	ID3D12PipelineState* horzBlurPSO,
-	ID3D12PipelineState* vertBlurPSO,
-	ID3D12Resource* inputTexture,
-	CbvSrvUavDescriptor& descriptorBuilder,
-	UINT descriptorSize,
-	int blurCount)
-{
-	CD3DX12_GPU_DESCRIPTOR_HANDLE gpuBlurMap0Srv = descriptorBuilder.GetStartGPUDescriptorHandle();
-	CD3DX12_GPU_DESCRIPTOR_HANDLE gpuBlurMap0Uav = descriptorBuilder.GetStartGPUDescriptorHandle();
-	CD3DX12_GPU_DESCRIPTOR_HANDLE gpuBlurMap1Srv = descriptorBuilder.GetStartGPUDescriptorHandle();
-	CD3DX12_GPU_DESCRIPTOR_HANDLE gpuBlurMap1Uav = descriptorBuilder.GetStartGPUDescriptorHandle();
-	gpuBlurMap0Srv.Offset(mBlurMap0SrvDescriptorIndex, descriptorSize);
-	gpuBlurMap0Uav.Offset(mBlurMap0UavDescriptorIndex, descriptorSize);
-	gpuBlurMap1Srv.Offset(mBlurMap1SrvDescriptorIndex, descriptorSize);
-	gpuBlurMap1Uav.Offset(mBlurMap1UavDescriptorIndex, descriptorSize);
-
-	auto weights = CalculateGaussWeights(2.5f);
-	int blurRadius = static_cast<int>(weights.size()) / 2;
-
-	commandList->SetComputeRootSignature(rootSignature);
-
-	commandList->SetComputeRoot32BitConstants(0, 1, &blurRadius, 0);
-	commandList->SetComputeRoot32BitConstants(0, static_cast<UINT>(weights.size()),
-		weights.data(), 1);
-
-	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(inputTexture,
-		D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_SOURCE));
-
-	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mBlurMap0.Get(),
-		D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST));
-
-	commandList->CopyResource(mBlurMap0.Get(), inputTexture);
-
-	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mBlurMap0.Get(),
-		D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ));
-
-	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mBlurMap1.Get(),
-		D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
-
-	for (int i = 0; i < blurCount; i++)
-	{
-		// horizontal blur pass
-		commandList->SetPipelineState(horzBlurPSO);
-
-		commandList->SetComputeRootDescriptorTable(1, gpuBlurMap0Srv);
-		commandList->SetComputeRootDescriptorTable(2, gpuBlurMap1Uav);
-
-		UINT numGroupsX = static_cast<UINT>(ceilf(static_cast<float>(mWidth) / 256.0f));
-		commandList->Dispatch(numGroupsX, mHeight, 1);
-
-		commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mBlurMap0.Get(),
-			D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
-
-		commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mBlurMap1.Get(),
-			D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_GENERIC_READ));
-
-		// vertical blur pass
-		commandList->SetPipelineState(vertBlurPSO);
-
-		commandList->SetComputeRootDescriptorTable(1, gpuBlurMap1Srv);
-		commandList->SetComputeRootDescriptorTable(2, gpuBlurMap0Uav);
-
-		UINT numGroupsY = static_cast<UINT>(ceilf(static_cast<float>(mHeight) / 256.0f));
-		commandList->Dispatch(mWidth, numGroupsY, 1);
-
-		commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mBlurMap0.Get(),
-			D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
-
-		commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mBlurMap1.Get(),
-			D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_GENERIC_READ));
-	}
-}
-
-void BlurFilter::ResizeBlurMap(UINT newWidth, UINT newHeight, 
-	ID3D12Device* device, 
-	CbvSrvUavDescriptor& descriptorBuilder, 
-	UINT cbvSrvUavDescriptorSize)
+void BlurFilter::ResizeBlurMap(UINT newWidth, UINT newHeight)
 {
-	if (mWidth != newWidth || mHeight != newHeight)
-	{
-		mWidth = newWidth;
-		mHeight = newHeight;
-
-		BuildResources(device);
-
-		BuildDescriptors(device, descriptorBuilder, cbvSrvUavDescriptorSize);
-	}
+	mWidth = newWidth;
+	mHeight = newHeight;
 }
 
-ID3D12Resource* BlurFilter::GetBlurMap()
+uint32_t BlurFilter::GetBlurMap()
 {
-	return mBlurMap0.Get();
+	return mBlurMap0;
 }
 int BlurFilter::GetBlurMapDescriptorIndex()
 {
 	return mBlurMap0SrvDescriptorIndex;
 }
 
-std::vector<float> BlurFilter::CalculateGaussWeights(float sigma)
+const std::vector<float>& BlurFilter::CalculateGaussWeights(float sigma)
 {
-	float twoSigma2 = 2.0f * sigma * sigma;
+	// Weights are cached per sigma, so calling this every frame doesn't recompute them.
+	const auto& weights = GaussWeightCache::GetWeights(sigma);
 
-	// Estimate the blur radius based on sigma since sigma controls the "width" of the bell curve.
-	// For example, for sigma = 3, the width of the bell curve is 
-	int blurRadius = static_cast<int>(ceil(2.0f * sigma));
+	assert(static_cast<int>(weights.size()) / 2 <= maxBlurRadius);
 
-	assert(blurRadius <= maxBlurRadius);
+	return weights;
+}
 
-	std::vector<float> weights;
-	weights.resize(2 * blurRadius + 1);
+D3D12_RESOURCE_DESC BlurFilter::GetBlurMapDesc()
+{
+	D3D12_RESOURCE_DESC textureDesc;
+	textureDesc.Alignment = 0;
+	textureDesc.DepthOrArraySize = 1;
+	textureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	textureDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+	textureDesc.Format = mFormat;
+	textureDesc.Height = mHeight;
+	textureDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+	textureDesc.MipLevels = 0;
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.SampleDesc.Quality = 0;
+	textureDesc.Width = mWidth;
 
-	float weightSum = 0.0f;
+	return textureDesc;
+}
 
-	for (int i = -blurRadius; i <= blurRadius; i++)
-	{
-		float x = static_cast<float>(i);
+void BlurFilter::Blur(
+	ID3D12GraphicsCommandList* commandList,
+	ID3D12RootSignature* rootSignature,
+	ID3D12PipelineState* blurPSO,
+	int inputSrvDescriptorIndex,
+	int outputUavDescriptorIndex,
+	CbvSrvUavDescriptor& descriptorBuilder,
+	UINT descriptorSize,
+	UINT numGroupsX, UINT numGroupsY)
+{
+	CD3DX12_GPU_DESCRIPTOR_HANDLE gpuInputSrv = descriptorBuilder.GetStartGPUDescriptorHandle();
+	CD3DX12_GPU_DESCRIPTOR_HANDLE gpuOutputUav = descriptorBuilder.GetStartGPUDescriptorHandle();
+	gpuInputSrv.Offset(inputSrvDescriptorIndex, descriptorSize);
+	gpuOutputUav.Offset(outputUavDescriptorIndex, descriptorSize);
 
-		weights[i + blurRadius] = expf(-x * x / twoSigma2);
+	const auto& weights = CalculateGaussWeights(2.5f);
+	int blurRadius = static_cast<int>(weights.size()) / 2;
 
-		weightSum += weights[i + blurRadius];
-	}
+	commandList->SetComputeRootSignature(rootSignature);
 
-	// Divide by the sum so all the weights add up to 1.0.
-	for (int i = 0; i < weights.size(); i++)
-	{
-		weights[i] /= weightSum;
-	}
+	commandList->SetComputeRoot32BitConstants(0, 1, &blurRadius, 0);
+	commandList->SetComputeRoot32BitConstants(0, static_cast<UINT>(weights.size()),
+		weights.data(), 1);
 
-	return weights;
+	commandList->SetPipelineState(blurPSO);
+
+	commandList->SetComputeRootDescriptorTable(1, gpuInputSrv);
+	commandList->SetComputeRootDescriptorTable(2, gpuOutputUav);
+
+	commandList->Dispatch(numGroupsX, numGroupsY, 1);
 }
\ No newline at end of file
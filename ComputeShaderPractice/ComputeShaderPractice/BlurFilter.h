@@ -1,46 +1,60 @@
 #pragma once
 #include "../../Core/includes/Stdafx.h"
+#include "../../Core/includes/D3D12RenderGraph.h"
 #include "../../Core/includes/Descriptor.h"
+#include "../../Core/includes/ImageFilter.h"
+#include "../../Core/includes/Profiler.h"
 
+// Separable gaussian blur as render graph passes, the blur maps are transients of the graph.
 class BlurFilter
 {
 public:
-	BlurFilter(
-		ID3D12Device* device,
-		UINT width, UINT height,
-		DXGI_FORMAT format);
-
-	void BuildResources(ID3D12Device* device);
+	BlurFilter(UINT width, UINT height, DXGI_FORMAT format);
 
-	void BuildDescriptors(
-		ID3D12Device* device,
-		CbvSrvUavDescriptor& descriptorBuilder, 
-		UINT cbvSrvUavDescriptorSize);
-
-	void Execute( 
-		ID3D12GraphicsCommandList* commandList,
+	// Declares the blur maps and adds a pass copying inputTexture into blur map 0, followed by blurCount
+	// horizontal and vertical passes. inputTexture has the filter's size and format.
+	void AddPasses(
+		RenderGraph& renderGraph,
+		D3D12RenderGraphBackend& renderGraphBackend,
+		GpuProfiler& gpuProfiler,
+		uint32_t inputTexture,
 		ID3D12RootSignature* rootSignature,
 		ID3D12PipelineState* horzBlurPSO,
 		ID3D12PipelineState* vertBlurPSO,
-		ID3D12Resource* inputTexture,
 		CbvSrvUavDescriptor& descriptorBuilder,
 		UINT descriptorSize,
 		int blurCount);
 
-	void ResizeBlurMap(UINT newWidth, UINT newHeight,
+	// After the graph created its transient resources.
+	void BuildDescriptors(
 		ID3D12Device* device,
-		CbvSrvUavDescriptor& descriptorBuilder,
+		D3D12RenderGraphBackend& renderGraphBackend,
+		CbvSrvUavDescriptor& descriptorBuilder, 
 		UINT cbvSrvUavDescriptorSize);
 
-	ID3D12Resource* GetBlurMap();
+	// The passes have to be added again.
+	void ResizeBlurMap(UINT newWidth, UINT newHeight);
+
+	uint32_t GetBlurMap(); // graph resource with the result
 	int GetBlurMapDescriptorIndex();
 
-	std::vector<float> CalculateGaussWeights(float sigma);
+	const std::vector<float>& CalculateGaussWeights(float sigma);
+private:
+	D3D12_RESOURCE_DESC GetBlurMapDesc();
+	void Blur(
+		ID3D12GraphicsCommandList* commandList,
+		ID3D12RootSignature* rootSignature,
+		ID3D12PipelineState* blurPSO,
+		int inputSrvDescriptorIndex,
+		int outputUavDescriptorIndex,
+		CbvSrvUavDescriptor& descriptorBuilder,
+		UINT descriptorSize,
+		UINT numGroupsX, UINT numGroupsY);
 private:
 	static const int maxBlurRadius;
 
-	Microsoft::WRL::ComPtr<ID3D12Resource> mBlurMap0 = nullptr;
-	Microsoft::WRL::ComPtr<ID3D12Resource> mBlurMap1 = nullptr;
+	uint32_t mBlurMap0 = RenderGraph::invalidIndex;
+	uint32_t mBlurMap1 = RenderGraph::invalidIndex;
 
 	UINT mWidth = 0;
 	UINT mHeight = 0;
@@ -1,7 +1,9 @@
 #include "FrameResource.h"
 
 FrameResource::FrameResource(ID3D12Device* device, UINT objectCount, 
-	UINT sceneCount, UINT materialCount, UINT instanceCount)
+	UINT sceneCount, UINT materialCount, UINT instanceCount,
+	UINT clusterCount, UINT clusterLightCount, UINT lightIndexCount,
+	UINT shadowInstanceCount)
 {
 	ThrowIfFailed(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT,
 		IID_PPV_ARGS(&mDirectCommandAllocator)));
@@ -21,6 +23,14 @@ FrameResource::FrameResource(ID3D12Device* device, UINT objectCount,
 	mSceneCBs = std::make_unique<UploadBuffer<SceneConstant>>(device, sceneCount, true);
 	mMaterialBuffers = std::make_unique<UploadBuffer<MaterialData>>(device, materialCount, false);
 	mInstanceBuffers = std::make_unique<UploadBuffer<InstanceData>>(device, instanceCount, false);
+
+	mClusterCBs = std::make_unique<UploadBuffer<ClusterConstant>>(device, 1, true);
+	mClusterLightBuffers = std::make_unique<UploadBuffer<Light>>(device, clusterLightCount, false);
+	mLightClusterBuffers = std::make_unique<UploadBuffer<LightCluster>>(device, clusterCount, false);
+	mLightIndexBuffers = std::make_unique<UploadBuffer<uint32_t>>(device, lightIndexCount, false);
+
+	mShadowCBs = std::make_unique<UploadBuffer<ShadowConstant>>(device, 1, true);
+	mShadowInstanceBuffers = std::make_unique<UploadBuffer<InstanceData>>(device, shadowInstanceCount, false);
 }
 
 UploadBuffer<ObjectConstant>* FrameResource::GetObjectConstantBuffers()
@@ -40,6 +50,32 @@ UploadBuffer<InstanceData>* FrameResource::GetInstanceBuffers()
 	return mInstanceBuffers.get();
 }
 
+UploadBuffer<ClusterConstant>* FrameResource::GetClusterConstantBuffers()
+{
+	return mClusterCBs.get();
+}
+UploadBuffer<Light>* FrameResource::GetClusterLightBuffers()
+{
+	return mClusterLightBuffers.get();
+}
+UploadBuffer<LightCluster>* FrameResource::GetLightClusterBuffers()
+{
+	return mLightClusterBuffers.get();
+}
+UploadBuffer<uint32_t>* FrameResource::GetLightIndexBuffers()
+{
+	return mLightIndexBuffers.get();
+}
+
+UploadBuffer<ShadowConstant>* FrameResource::GetShadowConstantBuffers()
+{
+	return mShadowCBs.get();
+}
+UploadBuffer<InstanceData>* FrameResource::GetShadowInstanceBuffers()
+{
+	return mShadowInstanceBuffers.get();
+}
+
 ID3D12CommandAllocator* FrameResource::GetDirectCommandAllocator()
 {
 	return mDirectCommandAllocator.Get();
@@ -1,4 +1,6 @@
 #pragma once
+#include "../../Core/includes/CascadedShadows.h"
+#include "../../Core/includes/ClusteredLightCuller.h"
 #include "../../Core/includes/Command.h"
 #include "../../Core/includes/Stdafx.h"
 #include "../../Core/includes/UploadBuffer.h"
@@ -7,7 +9,9 @@ class FrameResource
 {
 public:
 	FrameResource(ID3D12Device* device, UINT objectCount, UINT sceneCount, 
-		UINT materialCount, UINT instanceCount);
+		UINT materialCount, UINT instanceCount,
+		UINT clusterCount, UINT clusterLightCount, UINT lightIndexCount,
+		UINT shadowInstanceCount);
 	FrameResource(const FrameResource& rhs) = default;
 	FrameResource& operator=(const FrameResource& rhs) = default;
 	~FrameResource() = default;
@@ -17,6 +21,14 @@ public:
 	UploadBuffer<MaterialData>* GetMaterialBuffers();
 	UploadBuffer<InstanceData>* GetInstanceBuffers();
 
+	UploadBuffer<ClusterConstant>* GetClusterConstantBuffers();
+	UploadBuffer<Light>* GetClusterLightBuffers();
+	UploadBuffer<LightCluster>* GetLightClusterBuffers();
+	UploadBuffer<uint32_t>* GetLightIndexBuffers();
+
+	UploadBuffer<ShadowConstant>* GetShadowConstantBuffers();
+	UploadBuffer<InstanceData>* GetShadowInstanceBuffers();
+
 	ID3D12CommandAllocator* GetDirectCommandAllocator();
 	ID3D12GraphicsCommandList* GetDirectCommandList();
 	ID3D12CommandAllocator* GetBundleAllocator();
@@ -32,6 +44,14 @@ private:
 	std::unique_ptr<UploadBuffer<MaterialData>> mMaterialBuffers = nullptr;
 	std::unique_ptr<UploadBuffer<InstanceData>> mInstanceBuffers = nullptr;
 
+	std::unique_ptr<UploadBuffer<ClusterConstant>> mClusterCBs = nullptr;
+	std::unique_ptr<UploadBuffer<Light>> mClusterLightBuffers = nullptr;
+	std::unique_ptr<UploadBuffer<LightCluster>> mLightClusterBuffers = nullptr;
+	std::unique_ptr<UploadBuffer<uint32_t>> mLightIndexBuffers = nullptr;
+
+	std::unique_ptr<UploadBuffer<ShadowConstant>> mShadowCBs = nullptr;
+	std::unique_ptr<UploadBuffer<InstanceData>> mShadowInstanceBuffers = nullptr;
+
 	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> mDirectCommandAllocator = nullptr;
 	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> mDirectCommandList = nullptr;
 	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> mBundleAllocator = nullptr;
@@ -4,6 +4,8 @@ using namespace DirectX::PackedVector;
 using namespace Microsoft::WRL;
 
 const UINT Renderer::mFrameResourceCount = 3;
+const UINT Renderer::mClusterLightCount = 1024;
+const UINT Renderer::mMaxLightIndexCount = 64 * 1024;
 
 Renderer* Renderer::renderer = nullptr;
 
@@ -65,6 +67,10 @@ void Renderer::Initialize()
 
 	CreateDirectCommandQueue(device);
 
+	// Create GPU timestamp queries, one slot per frame resource
+	mTimestampQueries = std::make_unique<D3D12TimestampQueries>(device, mDirectCommandQueue.Get(), mFrameResourceCount);
+	mGpuProfiler = std::make_unique<GpuProfiler>(*mTimestampQueries, mFrameResourceCount);
+
 	auto commandList = mInitializeCommandObject.GetCommandList();
 	auto commandQueue = mDirectCommandQueue.Get();
 
@@ -92,29 +98,35 @@ void Renderer::Initialize()
 
 	// Create meshes
 	BasicGeometryGenerator geoGenerator;
-	auto box = geoGenerator.CreateBox(2.0f, 2.0f, 2.0f);
+	Mesh box = geoGenerator.CreateBox(2.0f, 2.0f, 2.0f);
 	box.ConfigureMesh(device, commandList);
 	mMeshes.insert({ "box", std::move(box) });
 
-	auto grid = geoGenerator.CreateGrid(10.0f, 20.0f, 10, 20);
+	Mesh grid = geoGenerator.CreateGrid(10.0f, 20.0f, 10, 20);
 	grid.ConfigureMesh(device, commandList);
 	mMeshes.insert({ "grid", std::move(grid) });
 
-	auto sphere = geoGenerator.CreateSphere(0.5f, 20, 20);
+	Mesh sphere = geoGenerator.CreateSphere(0.5f, 20, 20);
 	sphere.ConfigureMesh(device, commandList);
 	mMeshes.insert({ "sphere", std::move(sphere) });
 
-	auto quad = geoGenerator.CreateQuad(0.0f, 0.0f, 1.0f, 1.0f, 0.0f);
+	Mesh quad = geoGenerator.CreateQuad(0.0f, 0.0f, 1.0f, 1.0f, 0.0f);
 	quad.ConfigureMesh(device, commandList);
 	mMeshes.insert({ "quad", std::move(quad) });
 
+	// Occluder meshes, the grid needs one quad instead of 10x20.
+	mOccluderMeshes.insert({ "box", geoGenerator.CreateBox(2.0f, 2.0f, 2.0f) });
+	mOccluderMeshes.insert({ "grid", geoGenerator.CreateGrid(10.0f, 20.0f, 2, 2) });
+
 	// Initialize constant buffer
 	// Build frameresources
 	for (UINT i = 0; i < mFrameResourceCount; i++)
-		mFrameResources.push_back(std::make_unique<FrameResource>(device, 5, 1, 4, 100));
+		mFrameResources.push_back(std::make_unique<FrameResource>(device, 5, 1 + ShadowConstant::maxCascadeCount, 4, 100,
+			mLightCuller.GetClusterCount(), mClusterLightCount, mMaxLightIndexCount,
+			100 * ShadowConstant::maxCascadeCount));
 
 	// Create cbvsrvuav descriptor heap
-	mCbvSrvUavDescriptor.CreateDescriptorHeap(device, 11);
+	mCbvSrvUavDescriptor.CreateDescriptorHeap(device, 12);
 
 	// Load Textures
 	LoadTextures();
@@ -142,65 +154,76 @@ void Renderer::Initialize()
 	mCbvSrvUavDescriptor.CreateShaderResourceView(device, mDirect3D.GetCbvSrvUavDescriptorSize(),
 		DXGI_FORMAT_R8G8B8A8_UNORM, D3D12_SRV_DIMENSION_TEXTURE2D, renderTexture);
 
-	// Initialize blur filter
-	mBlurFilter = std::make_unique<BlurFilter>(device, mWindowWidth, mWindowHeight, DXGI_FORMAT_R8G8B8A8_UNORM);
-	mBlurFilter->BuildDescriptors(device, mCbvSrvUavDescriptor, mDirect3D.GetCbvSrvUavDescriptorSize());
-
-	// Initialize sobel filter
-	mSobelFilter = std::make_unique<SobelFilter>(device, mWindowWidth, mWindowHeight, DXGI_FORMAT_R8G8B8A8_UNORM);
-	mSobelFilter->BuildDescriptors(device, mCbvSrvUavDescriptor, mDirect3D.GetCbvSrvUavDescriptorSize());
-
-	// Create vertex and pixel shader
-	Shader vertexShader;
-	Shader pixelShader; 
-	vertexShader.CompileShader(L"../../Shaders/dynamicIndexing.hlsl", nullptr, "VSMain", "vs_5_1");
-	pixelShader.CompileShader(L"../../Shaders/dynamicIndexing.hlsl", nullptr, "PSMain", "ps_5_1");
-	mShaders.insert({ "opaqueVS", std::move(vertexShader) });
-	mShaders.insert({ "opaquePS", std::move(pixelShader) });
-
-	Shader instancingVertexShader;
-	Shader instancingPixelShader;
-	instancingVertexShader.CompileShader(L"../../Shaders/instancing.hlsl", nullptr, "VSMain", "vs_5_1");
-	instancingPixelShader.CompileShader(L"../../Shaders/instancing.hlsl", nullptr, "PSMain", "ps_5_1");
-	mShaders.insert({ "instancingVS", std::move(instancingVertexShader) });
-	mShaders.insert({ "instancingPS", std::move(instancingPixelShader) });
-
-	Shader skyVertexShader;
-	Shader skyPixelShader;
-	skyVertexShader.CompileShader(L"../../Shaders/sky.hlsl", nullptr, "VSMain", "vs_5_1");
-	skyPixelShader.CompileShader(L"../../Shaders/sky.hlsl", nullptr, "PSMain", "ps_5_1");
-	mShaders.insert({ "skyVS", std::move(skyVertexShader) });
-	mShaders.insert({ "skyPS", std::move(skyPixelShader) });
-
-	Shader horzBlurComputeShader;
-	Shader vertBlurComputeShader;
-	horzBlurComputeShader.CompileShader(L"../../Shaders/blur.hlsl", nullptr, "HorzCSMain", "cs_5_1");
-	vertBlurComputeShader.CompileShader(L"../../Shaders/blur.hlsl", nullptr, "VertCSMain", "cs_5_1");
-	mShaders.insert({ "horzBlurCS", std::move(horzBlurComputeShader) });
-	mShaders.insert({ "vertBlurCS", std::move(vertBlurComputeShader) });
-
-	Shader sobelComputeShader;
-	sobelComputeShader.CompileShader(L"../../Shaders/sobel.hlsl", nullptr, "SobelCSMain", "cs_5_1");
-	mShaders.insert({ "sobelCS", std::move(sobelComputeShader) });
-
-	Shader compositeVertexShader;
-	Shader compositePixelShader;
-	compositeVertexShader.CompileShader(L"../../Shaders/composite.hlsl", nullptr, "VSMain", "vs_5_1");
-	compositePixelShader.CompileShader(L"../../Shaders/composite.hlsl", nullptr, "PSMain", "ps_5_1");
-	mShaders.insert({ "compositeVS", std::move(compositeVertexShader) });
-	mShaders.insert({ "compositePS", std::move(compositePixelShader) });
+	// Create shadow map, before the filters so that its descriptor doesn't move when they are resized
+	mCascadedShadows.SetShadowDistance(80.0f);
+	mShadowMap = std::make_unique<ShadowMap>(device, mCascadedShadows.GetResolution(), mCascadedShadows.GetCascadeCount());
+	mShadowMap->BuildDescriptors(device, mCbvSrvUavDescriptor, mDirect3D.GetCbvSrvUavDescriptorSize(),
+		mDirect3D.GetDsvDescriptorSize());
 
+	// Initialize filters, their maps and descriptors come with the render graph
+	mBlurFilter = std::make_unique<BlurFilter>(mWindowWidth, mWindowHeight, DXGI_FORMAT_R8G8B8A8_UNORM);
+	mSobelFilter = std::make_unique<SobelFilter>(mWindowWidth, mWindowHeight, DXGI_FORMAT_R8G8B8A8_UNORM);
+	mRenderGraphBackend = std::make_unique<D3D12RenderGraphBackend>(device);
+
+	// Compile shaders and create PSOs in parallel, a PSO starts as soon as its shaders are ready
 	ConfigureInputElements();
 	CreateDefaultRootSignature(device);
 	CreatePostProcessRootSignature(device);
-	CreateDefaultPSO(device, "opaque", "default", "opaque");
-	CreateDefaultPSO(device, "instancing", "default", "instancing");
-	CreateDefaultPSO(device, "composite", "default", "composite");
-	CreateSkyboxPSO(device, "sky", "default", "sky");
-	CreateBlurPSO(device);
-	CreateSobelPSO(device);
+
+	StartupTaskGraph startupTaskGraph;
+	auto compileShader = [this, &startupTaskGraph](const std::string& shaderName,
+		const std::wstring& filename, const std::string& entrypoint, const std::string& target,
+		const std::vector<ShaderDefine>& defines = {})
+	{
+		// Inserted here on the main thread, the task only writes the element.
+		Shader* shader = &mShaders[shaderName];
+		return startupTaskGraph.AddTask(shaderName, [this, shader, filename, entrypoint, target, defines]()
+			{
+				shader->CompileShader(filename, defines, entrypoint, target, &mShaderCache);
+			});
+	};
+	const std::vector<ShaderDefine> lightingDefines = { { "CLUSTERED_LIGHTING", "1" }, { "SHADOWS", "1" } };
+
+	auto opaqueVS = compileShader("opaqueVS", L"../../Shaders/dynamicIndexing.hlsl", "VSMain", "vs_5_1");
+	auto opaquePS = compileShader("opaquePS", L"../../Shaders/dynamicIndexing.hlsl", "PSMain", "ps_5_1", lightingDefines);
+	auto instancingVS = compileShader("instancingVS", L"../../Shaders/instancing.hlsl", "VSMain", "vs_5_1");
+	auto instancingPS = compileShader("instancingPS", L"../../Shaders/instancing.hlsl", "PSMain", "ps_5_1", lightingDefines);
+	auto shadowVS = compileShader("shadowVS", L"../../Shaders/shadow.hlsl", "VSMain", "vs_5_1");
+	auto shadowInstancingVS = compileShader("shadowInstancingVS", L"../../Shaders/shadow.hlsl", "VSMain", "vs_5_1",
+		{ { "INSTANCING", "1" } });
+	auto skyVS = compileShader("skyVS", L"../../Shaders/sky.hlsl", "VSMain", "vs_5_1");
+	auto skyPS = compileShader("skyPS", L"../../Shaders/sky.hlsl", "PSMain", "ps_5_1");
+	auto horzBlurCS = compileShader("horzBlurCS", L"../../Shaders/blur.hlsl", "HorzCSMain", "cs_5_1");
+	auto vertBlurCS = compileShader("vertBlurCS", L"../../Shaders/blur.hlsl", "VertCSMain", "cs_5_1");
+	auto sobelCS = compileShader("sobelCS", L"../../Shaders/sobel.hlsl", "SobelCSMain", "cs_5_1");
+	auto compositeVS = compileShader("compositeVS", L"../../Shaders/composite.hlsl", "VSMain", "vs_5_1");
+	auto compositePS = compileShader("compositePS", L"../../Shaders/composite.hlsl", "PSMain", "ps_5_1");
+
+	startupTaskGraph.AddTask("opaquePSO", [this, device]() { CreateDefaultPSO(device, "opaque", "default", "opaque"); },
+		{ opaqueVS, opaquePS });
+	startupTaskGraph.AddTask("instancingPSO", [this, device]() { CreateDefaultPSO(device, "instancing", "default", "instancing"); },
+		{ instancingVS, instancingPS });
+	startupTaskGraph.AddTask("compositePSO", [this, device]() { CreateDefaultPSO(device, "composite", "default", "composite"); },
+		{ compositeVS, compositePS });
+	startupTaskGraph.AddTask("shadowPSO", [this, device]() { CreateShadowPSO(device, "shadow", "default", "shadow"); },
+		{ shadowVS });
+	startupTaskGraph.AddTask("shadowInstancingPSO", [this, device]() { CreateShadowPSO(device, "shadowInstancing", "default", "shadowInstancing"); },
+		{ shadowInstancingVS });
+	startupTaskGraph.AddTask("skyPSO", [this, device]() { CreateSkyboxPSO(device, "sky", "default", "sky"); },
+		{ skyVS, skyPS });
+	startupTaskGraph.AddTask("blurPSO", [this, device]() { CreateBlurPSO(device); }, { horzBlurCS, vertBlurCS });
+	startupTaskGraph.AddTask("sobelPSO", [this, device]() { CreateSobelPSO(device); }, { sobelCS });
+
+	startupTaskGraph.Run();
+	::OutputDebugStringA(startupTaskGraph.GetTimelineReport().c_str());
+
+	BuildRenderGraph();
 
 	BuildRenderItems();
+	BuildInstanceBvh();
+	BuildOccluders();
+	BuildClusterLights();
+	BuildShadowCasters();
 
 	ExecuteCommandLists(commandList, commandQueue);
 
@@ -212,6 +235,7 @@ int Renderer::RenderLoop()
 	MSG msg = { 0 };
 
 	mTimer.Reset();
+	Profiler::Get().SetThreadName("Main");
 
 	while (msg.message != WM_QUIT)
 	{
@@ -226,9 +250,14 @@ int Renderer::RenderLoop()
 
 			if (!mAppPaused)
 			{
+				Profiler::Get().BeginFrame();
+
+				UpdateFrameStatistics();
 				ProcessKeyboardInput();
 				UpdateData();
 				DrawScene();
+
+				Profiler::Get().EndFrame();
 			}
 			else
 			{
@@ -443,11 +472,10 @@ void Renderer::Resize()
 
 	ConfigureViewportAndScissorRect();
 
-	mBlurFilter->ResizeBlurMap(mWindowWidth, mWindowHeight, device, 
-		mCbvSrvUavDescriptor, mDirect3D.GetCbvSrvUavDescriptorSize());
+	mBlurFilter->ResizeBlurMap(mWindowWidth, mWindowHeight);
+	mSobelFilter->ResizeSobelMap(mWindowWidth, mWindowHeight);
 
-	mSobelFilter->ResizeSobelMap(mWindowWidth, mWindowHeight, device,
-		mCbvSrvUavDescriptor, mDirect3D.GetCbvSrvUavDescriptorSize());
+	BuildRenderGraph();
 }
 
 void Renderer::ExecuteCommandLists(ID3D12GraphicsCommandList* commandList, 
@@ -463,6 +491,9 @@ void Renderer::MouseDown(WPARAM btnState, int x, int y)
 	mLastMousePos.x = x;
 	mLastMousePos.y = y;
 
+	if ((btnState & MK_RBUTTON) != 0)
+		PickInstance(x, y);
+
 	SetCapture(mhWnd);
 }
 void Renderer::MouseUp(WPARAM btnState, int x, int y)
@@ -483,6 +514,21 @@ void Renderer::MouseMove(WPARAM btnState, int x, int y)
 	mLastMousePos.x = x;
 	mLastMousePos.y = y;
 }
+void Renderer::PickInstance(int x, int y)
+{
+	XMFLOAT3 origin;
+	XMFLOAT3 direction;
+	mCamera.GetPickingRay(static_cast<float>(x), static_cast<float>(y),
+		static_cast<float>(mViewportWidth), static_cast<float>(mViewportHeight), origin, direction);
+
+	BvhRayHit hit;
+	if (mInstanceBvh.RayCast(XMLoadFloat3(&origin), XMLoadFloat3(&direction), 1000.0f, hit))
+	{
+		std::ostringstream message;
+		message << "Picked instance " << hit.userData << " at distance " << hit.distance << "\n";
+		::OutputDebugStringA(message.str().c_str());
+	}
+}
 
 void Renderer::ProcessKeyboardInput()
 {
@@ -500,8 +546,43 @@ void Renderer::ProcessKeyboardInput()
 	if (GetAsyncKeyState('D') & 0x8000)
 		mCamera.Strafe(10.0f * dt);
 }
+void Renderer::UpdateFrameStatistics()
+{
+	mFrameStatistics.AddFrame(mTimer.DeltaTime());
+
+	// Refresh the window title twice per second.
+	if (mTimer.TotalTime() - mFrameStatisticsTime < 0.5f)
+		return;
+
+	mFrameStatisticsTime = mTimer.TotalTime();
+
+	auto summary = mFrameStatistics.GetSummary();
+
+	std::wostringstream windowText;
+	windowText.precision(1);
+	windowText << std::fixed << L"MainWindow    fps: " << mFrameStatistics.GetSmoothedFps()
+		<< L"    p50: " << summary.p50Milliseconds << L" ms    p99: " << summary.p99Milliseconds
+		<< L" ms    hitches: " << mFrameStatistics.GetHitchCount();
+
+	auto occlusionStatistics = mOcclusionCuller.GetStatistics();
+	windowText << L"    occluded: " << occlusionStatistics.culledPercentage << L"% in "
+		<< occlusionStatistics.rasterMilliseconds + occlusionStatistics.testMilliseconds << L" ms";
+
+	auto lightStatistics = mLightCuller.GetStatistics();
+	windowText << L"    lights: " << lightStatistics.visibleLightCount << L"/" << lightStatistics.lightCount
+		<< L" (max " << lightStatistics.maxLightsPerCluster << L" per cluster) in "
+		<< lightStatistics.assignMilliseconds << L" ms";
+
+	auto shadowStatistics = mCascadedShadows.GetStatistics();
+	windowText << L"    shadow cascades redrawn: " << shadowStatistics.renderedCascadeCount << L" in "
+		<< shadowStatistics.updateMilliseconds << L" ms";
+
+	SetWindowText(mhWnd, windowText.str().c_str());
+}
 void Renderer::UpdateData()
 {
+	PROFILE_SCOPE("UpdateData");
+
 	// Move to the next frame resource.
 	mCurrentFrameResourceIndex = (mCurrentFrameResourceIndex + 1) % mFrameResourceCount;
 	mCurrentFrameResource = mFrameResources[mCurrentFrameResourceIndex].get();
@@ -519,31 +600,60 @@ void Renderer::UpdateData()
 		CloseHandle(eventHandle);
 	}
 
+	// The timestamps of the frame that last used this frame resource are ready now.
+	mGpuProfiler->BeginFrame(mCurrentFrameResourceIndex);
+
 	UpdateObjectConstants();
 	UpdateSceneConstants();
 	UpdateMaterialDatas();
 	UpdateInstanceDatas();
+	UpdateClusterDatas();
+	UpdateShadowDatas();
 }
 void Renderer::DrawScene()
 {
-	auto device = mDirect3D.GetDevice();
+	PROFILE_SCOPE("DrawScene");
+
 	auto commandQueue = mDirectCommandQueue.Get();
 
 	auto commandAllocator = mCurrentFrameResource->GetDirectCommandAllocator();
 	auto commandList = mCurrentFrameResource->GetDirectCommandList();
-	
-	auto currentBackBuffer = mSwapChain.GetCurrentBackBuffer();
 
 	ThrowIfFailed(commandAllocator->Reset());
 
 	ThrowIfFailed(commandList->Reset(commandAllocator, mPSOs["opaque"].Get()));
 
+	mTimestampQueries->SetCommandList(commandList);
+	mGpuProfiler->BeginScope("Frame");
+
+	ID3D12DescriptorHeap* descriptorHeaps[] = { mCbvSrvUavDescriptor.GetDescriptorHeap() };
+	commandList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
+
+	// The graph records every barrier between the passes, the back buffer returns to the present state.
+	mRenderGraphBackend->SetCommandList(commandList);
+	mRenderGraphBackend->SetImportedResource(mBackBufferResource, mSwapChain.GetCurrentBackBuffer());
+	mRenderGraph.Execute(*mRenderGraphBackend);
+
+	mGpuProfiler->EndScope();
+	mGpuProfiler->EndFrame();
+
+	ExecuteCommandLists(commandList, commandQueue);
+
+	ThrowIfFailed(mSwapChain.GetSwapChain()->Present(0, 0));
+	mSwapChain.SwitchBackBuffer();
+
+	// mDirect3D.WaitForPreviousFrame(commandQueue);
+
+	mDirect3D.PlusOneFenceValue();
+	mCurrentFrameResource->SetFenceValue(mDirect3D.GetFenceValue());
+
+	commandQueue->Signal(mDirect3D.GetFence(), mDirect3D.GetFenceValue());
+}
+void Renderer::DrawScenePass(ID3D12GraphicsCommandList* commandList)
+{
 	commandList->RSSetScissorRects(1, &mScissorRect);
 	commandList->RSSetViewports(1, &mScreenViewport);
 
-	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(currentBackBuffer,
-		D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET));
-
 	D3D12_CPU_DESCRIPTOR_HANDLE currentRenderTargetView =
 		CD3DX12_CPU_DESCRIPTOR_HANDLE(mRtvDescriptor.GetStartCPUDescriptorHandle(), 
 		mSwapChain.GetCurrentBackBufferIndex(), mDirect3D.GetRtvDescriptorSize());
@@ -553,9 +663,6 @@ void Renderer::DrawScene()
 
 	commandList->OMSetRenderTargets(1, &currentRenderTargetView, true, &mDsvDescriptor.GetStartCPUDescriptorHandle());
 
-	ID3D12DescriptorHeap* descriptorHeaps[] = { mCbvSrvUavDescriptor.GetDescriptorHeap() };
-	commandList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
-
 	commandList->SetGraphicsRootSignature(mRootSignatures["default"].Get());
 
 	auto sceneCBAddress = mCurrentFrameResource->GetSceneConstantBuffers()
@@ -570,6 +677,34 @@ void Renderer::DrawScene()
 	cbvSrvUavDescriptor.Offset(3, mDirect3D.GetCbvSrvUavDescriptorSize());
 	commandList->SetGraphicsRootDescriptorTable(5, cbvSrvUavDescriptor);
 
+	auto clusterCBAddress = mCurrentFrameResource->GetClusterConstantBuffers()
+		->GetUploadBuffer()->GetGPUVirtualAddress();
+	commandList->SetGraphicsRootConstantBufferView(7, clusterCBAddress);
+	commandList->SetGraphicsRootShaderResourceView(8, mCurrentFrameResource->GetClusterLightBuffers()
+		->GetUploadBuffer()->GetGPUVirtualAddress());
+	commandList->SetGraphicsRootShaderResourceView(9, mCurrentFrameResource->GetLightClusterBuffers()
+		->GetUploadBuffer()->GetGPUVirtualAddress());
+	commandList->SetGraphicsRootShaderResourceView(10, mCurrentFrameResource->GetLightIndexBuffers()
+		->GetUploadBuffer()->GetGPUVirtualAddress());
+
+	auto shadowCBAddress = mCurrentFrameResource->GetShadowConstantBuffers()
+		->GetUploadBuffer()->GetGPUVirtualAddress();
+	commandList->SetGraphicsRootConstantBufferView(11, shadowCBAddress);
+
+	cbvSrvUavDescriptor = mCbvSrvUavDescriptor.GetStartGPUDescriptorHandle();
+	cbvSrvUavDescriptor.Offset(mShadowMap->GetShadowMapSrvDescriptorIndex(), mDirect3D.GetCbvSrvUavDescriptorSize());
+	commandList->SetGraphicsRootDescriptorTable(12, cbvSrvUavDescriptor);
+
+	mGpuProfiler->BeginScope("Shadows");
+	DrawShadowMaps(commandList);
+	mGpuProfiler->EndScope();
+
+	commandList->RSSetScissorRects(1, &mScissorRect);
+	commandList->RSSetViewports(1, &mScreenViewport);
+	commandList->OMSetRenderTargets(1, &currentRenderTargetView, true, &mDsvDescriptor.GetStartCPUDescriptorHandle());
+
+	mGpuProfiler->BeginScope("Scene");
+
 	auto currentPipelineState = mPSOs["sky"].Get();
 	DrawRenderItems(RenderLayer::Sky, commandList, currentPipelineState);
 
@@ -579,49 +714,25 @@ void Renderer::DrawScene()
 	currentPipelineState = mPSOs["instancing"].Get();
 	DrawRenderItems(RenderLayer::Instancing, commandList, currentPipelineState);
 
-	mBlurFilter->Execute(commandList, mRootSignatures["postprocess"].Get(), 
-		mPSOs["horzBlur"].Get(), mPSOs["vertBlur"].Get(), currentBackBuffer, 
-		mCbvSrvUavDescriptor, mDirect3D.GetCbvSrvUavDescriptorSize(), 4);
-
-	mSobelFilter->Execute(commandList, mRootSignatures["postprocess"].Get(),
-		mPSOs["sobel"].Get(), mBlurFilter->GetBlurMap(), mBlurFilter->GetBlurMapDescriptorIndex(),
-		mCbvSrvUavDescriptor, mDirect3D.GetCbvSrvUavDescriptorSize());
-
-	auto renderTexture = mRenderTexture.GetTextureResource();
-
-	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(renderTexture,
-		D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST));
-
-	commandList->CopyResource(renderTexture, currentBackBuffer);
-
-	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(currentBackBuffer,
-		D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET));
-
-	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(renderTexture,
-		D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ));
+	mGpuProfiler->EndScope();
+}
+void Renderer::DrawCompositePass(ID3D12GraphicsCommandList* commandList)
+{
+	// The filters bound their compute state in between, the graphics state of the scene pass is still set.
+	D3D12_CPU_DESCRIPTOR_HANDLE currentRenderTargetView =
+		CD3DX12_CPU_DESCRIPTOR_HANDLE(mRtvDescriptor.GetStartCPUDescriptorHandle(), 
+		mSwapChain.GetCurrentBackBufferIndex(), mDirect3D.GetRtvDescriptorSize());
+	commandList->OMSetRenderTargets(1, &currentRenderTargetView, true, &mDsvDescriptor.GetStartCPUDescriptorHandle());
 
-	cbvSrvUavDescriptor = mCbvSrvUavDescriptor.GetStartGPUDescriptorHandle();
+	CD3DX12_GPU_DESCRIPTOR_HANDLE cbvSrvUavDescriptor = mCbvSrvUavDescriptor.GetStartGPUDescriptorHandle();
 	cbvSrvUavDescriptor.Offset(mSobelFilter->GetSobelMapSrvDescriptorIndex(),
 		mDirect3D.GetCbvSrvUavDescriptorSize());
 	commandList->SetGraphicsRootDescriptorTable(6, cbvSrvUavDescriptor);
 
-	currentPipelineState = mPSOs["composite"].Get();
+	mGpuProfiler->BeginScope("Composite");
+	auto currentPipelineState = mPSOs["composite"].Get();
 	DrawRenderItems(RenderLayer::Composite, commandList, currentPipelineState);
-
-	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(currentBackBuffer,
-		D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
-
-	ExecuteCommandLists(commandList, commandQueue);
-
-	ThrowIfFailed(mSwapChain.GetSwapChain()->Present(0, 0));
-	mSwapChain.SwitchBackBuffer();
-
-	// mDirect3D.WaitForPreviousFrame(commandQueue);
-
-	mDirect3D.PlusOneFenceValue();
-	mCurrentFrameResource->SetFenceValue(mDirect3D.GetFenceValue());
-
-	commandQueue->Signal(mDirect3D.GetFence(), mDirect3D.GetFenceValue());
+	mGpuProfiler->EndScope();
 }
 
 void Renderer::UpdateObjectConstants()
@@ -656,19 +767,15 @@ void Renderer::UpdateSceneConstants()
 
 	SceneConstant sceneConstant;
 
-	XMFLOAT4X4 view = mCamera.GetView();
-	XMFLOAT4X4 proj = mCamera.GetProj();
-
-	XMMATRIX v = XMLoadFloat4x4(&view);
-	XMMATRIX p = XMLoadFloat4x4(&proj);
-
-	XMStoreFloat4x4(&sceneConstant.view, XMMatrixTranspose(v));
-	XMStoreFloat4x4(&sceneConstant.proj, XMMatrixTranspose(p));
+	XMStoreFloat4x4(&sceneConstant.view, XMMatrixTranspose(XMLoadFloat4x4(&mCamera.GetView())));
+	XMStoreFloat4x4(&sceneConstant.proj, XMMatrixTranspose(XMLoadFloat4x4(&mCamera.GetProj())));
+	XMStoreFloat4x4(&sceneConstant.viewProj, XMMatrixTranspose(XMLoadFloat4x4(&mCamera.GetViewProj())));
+	XMStoreFloat4x4(&sceneConstant.invView, XMMatrixTranspose(XMLoadFloat4x4(&mCamera.GetInverseView())));
 
 	sceneConstant.cameraPosition = mCamera.GetPosition();
 
 	sceneConstant.ambientLight = XMFLOAT4{ 0.25f, 0.15f, 0.35f, 1.0f };
-	sceneConstant.lights[0].direction = XMFLOAT3{ 0.0f, -1.0f, -1.0f };
+	sceneConstant.lights[0].direction = mLightDirection;
 	sceneConstant.lights[0].strength = XMFLOAT3{ 1.0f, 0.8f, 0.9f };
 
 	sceneConstantBuffers->CopyData(0, sceneConstant);
@@ -696,6 +803,28 @@ void Renderer::UpdateInstanceDatas()
 {
 	auto instanceBuffers = mCurrentFrameResource->GetInstanceBuffers();
 
+	mVisibleInstances.clear();
+	mInstanceBvh.QueryFrustum(mCamera.GetFrustum(), mVisibleInstances);
+	std::sort(mVisibleInstances.begin(), mVisibleInstances.end());
+
+	mOcclusionCuller.RenderOccluders(mCamera.GetViewProj());
+
+	mOcclusionCandidates.clear();
+	for (auto i : mVisibleInstances)
+		mOcclusionCandidates.push_back(mInstanceBounds[i]);
+
+	mOcclusionResults.resize(mOcclusionCandidates.size());
+	mOcclusionCuller.TestVisibility(mOcclusionCandidates.data(),
+		static_cast<uint32_t>(mOcclusionCandidates.size()), mOcclusionResults.data());
+
+	uint32_t visibleCount = 0;
+	for (size_t i = 0; i < mVisibleInstances.size(); i++)
+	{
+		if (mOcclusionResults[i] != 0)
+			mVisibleInstances[visibleCount++] = mVisibleInstances[i];
+	}
+	mVisibleInstances.resize(visibleCount);
+
 	InstanceData instanceData;
 	UINT elementIndex = 0;
 
@@ -703,9 +832,9 @@ void Renderer::UpdateInstanceDatas()
 	{
 		for (auto& renderItem : renderItems.second)
 		{
-			if (renderItem.instanceCount > 1 && renderItem.numFrameDirty > 0)
+			if (renderItem.instanceCount > 1)
 			{
-				for (UINT i = 0; i < (UINT)renderItem.instanceDatas.size(); i++)
+				for (auto i : mVisibleInstances)
 				{
 					XMMATRIX world = XMLoadFloat4x4(&renderItem.instanceDatas[i].world);
 					XMStoreFloat4x4(&instanceData.world, XMMatrixTranspose(world));
@@ -714,13 +843,83 @@ void Renderer::UpdateInstanceDatas()
 
 					instanceBuffers->CopyData(elementIndex, instanceData);
 					elementIndex++;
-
-					renderItem.numFrameDirty--;
 				}
+
+				renderItem.visibleInstanceCount = static_cast<UINT>(mVisibleInstances.size());
 			}
 		}
 	}
 }
+void Renderer::UpdateClusterDatas()
+{
+	mLightCuller.AssignLights(mCamera, mClusterLights);
+
+	mCurrentFrameResource->GetClusterConstantBuffers()->CopyData(0, mLightCuller.GetClusterConstant());
+	mCurrentFrameResource->GetClusterLightBuffers()->CopyData(0, mClusterLights.data(),
+		static_cast<UINT>(mClusterLights.size()));
+
+	auto lightClusterBuffers = mCurrentFrameResource->GetLightClusterBuffers();
+	auto lightIndexBuffers = mCurrentFrameResource->GetLightIndexBuffers();
+
+	const auto& clusters = mLightCuller.GetClusters();
+	const auto& lightIndices = mLightCuller.GetLightIndices();
+
+	if (lightIndices.size() <= mMaxLightIndexCount)
+	{
+		lightClusterBuffers->CopyData(0, clusters.data(), static_cast<UINT>(clusters.size()));
+		lightIndexBuffers->CopyData(0, lightIndices.data(), static_cast<UINT>(lightIndices.size()));
+		return;
+	}
+
+	// Too many lights for the index buffer, the clusters past the end lose theirs instead of reading out of bounds.
+	for (UINT i = 0; i < static_cast<UINT>(clusters.size()); i++)
+	{
+		LightCluster cluster = clusters[i];
+		cluster.offset = std::min(cluster.offset, mMaxLightIndexCount);
+		cluster.count = std::min(cluster.count, mMaxLightIndexCount - cluster.offset);
+		lightClusterBuffers->CopyData(i, cluster);
+	}
+	lightIndexBuffers->CopyData(0, lightIndices.data(), mMaxLightIndexCount);
+}
+void Renderer::UpdateShadowDatas()
+{
+	mCascadedShadows.Update(mCamera, mLightDirection);
+
+	mCurrentFrameResource->GetShadowConstantBuffers()->CopyData(0, mCascadedShadows.GetShadowConstant());
+
+	auto sceneConstantBuffers = mCurrentFrameResource->GetSceneConstantBuffers();
+	auto shadowInstanceBuffers = mCurrentFrameResource->GetShadowInstanceBuffers();
+	auto& instancingRenderItem = mAllRenderItems[RenderLayer::Instancing][0];
+
+	// Only the view projection of the cascade is read by shadow.hlsl.
+	SceneConstant sceneConstant;
+	InstanceData instanceData;
+
+	for (UINT i = 0; i < mCascadedShadows.GetCascadeCount(); i++)
+	{
+		mShadowInstanceCounts[i] = 0;
+		if (!mCascadedShadows.NeedsRender(i))
+			continue;
+
+		XMMATRIX viewProj = XMLoadFloat4x4(&mCascadedShadows.GetCascade(i).viewProj);
+		XMStoreFloat4x4(&sceneConstant.viewProj, XMMatrixTranspose(viewProj));
+		sceneConstantBuffers->CopyData(1 + i, sceneConstant);
+
+		UINT firstElement = i * instancingRenderItem.instanceCount;
+		for (auto caster : mCascadedShadows.GetCasters(i))
+		{
+			if (caster < mOpaqueCasterCount)
+				continue;
+
+			const auto& casterData = instancingRenderItem.instanceDatas[caster - mOpaqueCasterCount];
+			XMStoreFloat4x4(&instanceData.world, XMMatrixTranspose(XMLoadFloat4x4(&casterData.world)));
+			instanceData.materialIndex = casterData.materialIndex;
+
+			shadowInstanceBuffers->CopyData(firstElement + mShadowInstanceCounts[i], instanceData);
+			mShadowInstanceCounts[i]++;
+		}
+	}
+}
 
 void Renderer::EnableDebugLayer()
 {
@@ -753,6 +952,8 @@ void Renderer::ConfigureViewportAndScissorRect()
 	mScreenViewport.MinDepth = 0.0f;
 	mScreenViewport.MaxDepth = 1.0f;
 
+	mLightCuller.SetViewport(mViewportWidth, mViewportHeight);
+
 	// Configure scissor rectangle
 	mScissorRect.left = 0;
 	mScissorRect.right = static_cast<LONG>(mViewportWidth);
@@ -793,7 +994,10 @@ void Renderer::CreateDefaultRootSignature(ID3D12Device* device)
 	CD3DX12_DESCRIPTOR_RANGE texTable2;
 	texTable2.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 2);
 
-	CD3DX12_ROOT_PARAMETER slotRootParameters[7];
+	CD3DX12_DESCRIPTOR_RANGE shadowMapTable;
+	shadowMapTable.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 3);
+
+	CD3DX12_ROOT_PARAMETER slotRootParameters[13];
 	slotRootParameters[0].InitAsConstantBufferView(0);
 	slotRootParameters[1].InitAsConstantBufferView(1);
 	slotRootParameters[2].InitAsShaderResourceView(0, 1);
@@ -801,10 +1005,18 @@ void Renderer::CreateDefaultRootSignature(ID3D12Device* device)
 	slotRootParameters[4].InitAsDescriptorTable(1, &texTable0, D3D12_SHADER_VISIBILITY_PIXEL);
 	slotRootParameters[5].InitAsDescriptorTable(1, &texTable1, D3D12_SHADER_VISIBILITY_PIXEL);
 	slotRootParameters[6].InitAsDescriptorTable(1, &texTable2, D3D12_SHADER_VISIBILITY_PIXEL);
+	// Clustered lighting: cluster constants, lights, clusters and light indices.
+	slotRootParameters[7].InitAsConstantBufferView(3, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+	slotRootParameters[8].InitAsShaderResourceView(2, 1, D3D12_SHADER_VISIBILITY_PIXEL);
+	slotRootParameters[9].InitAsShaderResourceView(3, 1, D3D12_SHADER_VISIBILITY_PIXEL);
+	slotRootParameters[10].InitAsShaderResourceView(4, 1, D3D12_SHADER_VISIBILITY_PIXEL);
+	// Cascaded shadows: shadow constants and the shadow map array.
+	slotRootParameters[11].InitAsConstantBufferView(4, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+	slotRootParameters[12].InitAsDescriptorTable(1, &shadowMapTable, D3D12_SHADER_VISIBILITY_PIXEL);
 
 	auto samplers = Texture::GetStaticSamplers();
 
-	CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc(7, slotRootParameters,
+	CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc(13, slotRootParameters,
 		(UINT)samplers.size(), samplers.data(), 
 		D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
 
@@ -872,9 +1084,9 @@ void Renderer::CreateDefaultPSO(ID3D12Device* device, const std::string& psoName
 	psoDesc.InputLayout = { mInputLayout.data(), (UINT)mInputLayout.size() };
 	psoDesc.NumRenderTargets = 1;
 	psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-	psoDesc.pRootSignature = mRootSignatures[rootSignatureName].Get();
-	psoDesc.VS = CD3DX12_SHADER_BYTECODE(mShaders[shaderName + "VS"].GetShader());
-	psoDesc.PS = CD3DX12_SHADER_BYTECODE(mShaders[shaderName + "PS"].GetShader());
+	psoDesc.pRootSignature = mRootSignatures.at(rootSignatureName).Get();
+	psoDesc.VS = CD3DX12_SHADER_BYTECODE(mShaders.at(shaderName + "VS").GetShader());
+	psoDesc.PS = CD3DX12_SHADER_BYTECODE(mShaders.at(shaderName + "PS").GetShader());
 	psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
 	psoDesc.RTVFormats[0] = mSwapChain.GetBackBufferFormat();
 	psoDesc.SampleDesc.Count = m4xMsaaState ? 4 : 1;
@@ -883,6 +1095,7 @@ void Renderer::CreateDefaultPSO(ID3D12Device* device, const std::string& psoName
 	
 	ThrowIfFailed(device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&pso)));
 	
+	std::lock_guard<std::mutex> lock(mPSOMutex);
 	mPSOs.insert({ psoName, pso });
 }
 void Renderer::CreateSkyboxPSO(ID3D12Device* device, const std::string& psoName, 
@@ -901,9 +1114,9 @@ void Renderer::CreateSkyboxPSO(ID3D12Device* device, const std::string& psoName,
 	psoDesc.InputLayout = { mInputLayout.data(), (UINT)mInputLayout.size() };
 	psoDesc.NumRenderTargets = 1;
 	psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-	psoDesc.pRootSignature = mRootSignatures[rootSignatureName].Get();
-	psoDesc.VS = CD3DX12_SHADER_BYTECODE(mShaders[shaderName + "VS"].GetShader());
-	psoDesc.PS = CD3DX12_SHADER_BYTECODE(mShaders[shaderName + "PS"].GetShader());
+	psoDesc.pRootSignature = mRootSignatures.at(rootSignatureName).Get();
+	psoDesc.VS = CD3DX12_SHADER_BYTECODE(mShaders.at(shaderName + "VS").GetShader());
+	psoDesc.PS = CD3DX12_SHADER_BYTECODE(mShaders.at(shaderName + "PS").GetShader());
 
 	psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
 	psoDesc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
@@ -915,6 +1128,7 @@ void Renderer::CreateSkyboxPSO(ID3D12Device* device, const std::string& psoName,
 
 	ThrowIfFailed(device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&pso)));
 
+	std::lock_guard<std::mutex> lock(mPSOMutex);
 	mPSOs.insert({ psoName, pso });
 }
 void Renderer::CreateBlurPSO(ID3D12Device* device)
@@ -923,18 +1137,20 @@ void Renderer::CreateBlurPSO(ID3D12Device* device)
 
 	D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc;
 	ZeroMemory(&psoDesc, sizeof(D3D12_COMPUTE_PIPELINE_STATE_DESC));
-	psoDesc.CS = CD3DX12_SHADER_BYTECODE(mShaders["horzBlurCS"].GetShader());
+	psoDesc.CS = CD3DX12_SHADER_BYTECODE(mShaders.at("horzBlurCS").GetShader());
 	psoDesc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
-	psoDesc.pRootSignature = mRootSignatures["postprocess"].Get();
+	psoDesc.pRootSignature = mRootSignatures.at("postprocess").Get();
 
 	ThrowIfFailed(device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&pso)));
 
-	mPSOs.insert({ "horzBlur", pso });
+	PipelineStateObject horzBlurPSO = pso;
 
-	psoDesc.CS = CD3DX12_SHADER_BYTECODE(mShaders["vertBlurCS"].GetShader());
+	psoDesc.CS = CD3DX12_SHADER_BYTECODE(mShaders.at("vertBlurCS").GetShader());
 
 	ThrowIfFailed(device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&pso)));
 
+	std::lock_guard<std::mutex> lock(mPSOMutex);
+	mPSOs.insert({ "horzBlur", horzBlurPSO });
 	mPSOs.insert({ "vertBlur", pso });
 }
 void Renderer::CreateSobelPSO(ID3D12Device* device)
@@ -943,15 +1159,48 @@ void Renderer::CreateSobelPSO(ID3D12Device* device)
 
 	D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc;
 	ZeroMemory(&psoDesc, sizeof(D3D12_COMPUTE_PIPELINE_STATE_DESC));
-	psoDesc.CS = CD3DX12_SHADER_BYTECODE(mShaders["sobelCS"].GetShader());
+	psoDesc.CS = CD3DX12_SHADER_BYTECODE(mShaders.at("sobelCS").GetShader());
 	psoDesc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
-	psoDesc.pRootSignature = mRootSignatures["postprocess"].Get();
+	psoDesc.pRootSignature = mRootSignatures.at("postprocess").Get();
 
 	ThrowIfFailed(device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&pso)));
 
+	std::lock_guard<std::mutex> lock(mPSOMutex);
 	mPSOs.insert({ "sobel", pso });
 }
 
+void Renderer::CreateShadowPSO(ID3D12Device* device, const std::string& psoName,
+	const std::string& rootSignatureName, const std::string& shaderName)
+{
+	PipelineStateObject pso = nullptr;
+
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc;
+	ZeroMemory(&psoDesc, sizeof(D3D12_GRAPHICS_PIPELINE_STATE_DESC));
+	psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+	psoDesc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
+	psoDesc.DSVFormat = ShadowMap::depthFormat;
+	psoDesc.InputLayout = { mInputLayout.data(), (UINT)mInputLayout.size() };
+	psoDesc.NumRenderTargets = 0;
+	psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+	psoDesc.pRootSignature = mRootSignatures.at(rootSignatureName).Get();
+	psoDesc.VS = CD3DX12_SHADER_BYTECODE(mShaders.at(shaderName + "VS").GetShader());
+
+	// Depth only. The bias grows with the slope, the lit shaders also offset along the normal.
+	psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+	psoDesc.RasterizerState.DepthBias = 1000;
+	psoDesc.RasterizerState.DepthBiasClamp = 0.0f;
+	psoDesc.RasterizerState.SlopeScaledDepthBias = 1.5f;
+
+	psoDesc.RTVFormats[0] = DXGI_FORMAT_UNKNOWN;
+	psoDesc.SampleDesc.Count = 1;
+	psoDesc.SampleDesc.Quality = 0;
+	psoDesc.SampleMask = UINT_MAX;
+
+	ThrowIfFailed(device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&pso)));
+
+	std::lock_guard<std::mutex> lock(mPSOMutex);
+	mPSOs.insert({ psoName, pso });
+}
 void Renderer::LoadTextures()
 {
 	// cache the d3d12 object
@@ -1010,6 +1259,7 @@ void Renderer::BuildRenderItems()
 	RenderItem renderItem;
 
 	renderItem.mesh = mMeshes["box"];
+	renderItem.occluderMesh = &mOccluderMeshes["box"];
 	XMMATRIX world = XMMatrixTranslation(3.0f, 2.0f, 0.0f);
 	XMStoreFloat4x4(&renderItem.world, world);
 	renderItem.objectCBIndex = 0;
@@ -1028,6 +1278,7 @@ void Renderer::BuildRenderItems()
 	mOpaqueRenderItems.push_back(renderItem);
 
 	renderItem.mesh = mMeshes["grid"];
+	renderItem.occluderMesh = &mOccluderMeshes["grid"];
 	world = XMMatrixTranslation(0.0f, -7.0f, 0.0f);
 	XMStoreFloat4x4(&renderItem.world, world);
 	renderItem.objectCBIndex = 2;
@@ -1037,6 +1288,7 @@ void Renderer::BuildRenderItems()
 	mOpaqueRenderItems.push_back(renderItem);
 
 	mAllRenderItems.insert({ RenderLayer::Opaque, mOpaqueRenderItems });
+	renderItem.occluderMesh = nullptr;
 
 	std::random_device randomDevice;
 	std::mt19937 generator(randomDevice());
@@ -1061,6 +1313,7 @@ void Renderer::BuildRenderItems()
 		XMStoreFloat4x4(&renderItem.instanceDatas[i].world, world);
 		renderItem.instanceDatas[i].materialIndex = materialIndexDistribution(generator);
 	}
+	renderItem.bounds = renderItem.mesh.GetBoundingBox();
 	mInstancingRenderItems.push_back(renderItem);
 
 	mAllRenderItems.insert({ RenderLayer::Instancing, mInstancingRenderItems });
@@ -1087,6 +1340,84 @@ void Renderer::BuildRenderItems()
 
 	mAllRenderItems.insert({ RenderLayer::Composite, mCompositeRenderItems });
 }
+void Renderer::BuildInstanceBvh()
+{
+	mInstanceBvh.Clear();
+	mInstanceBounds.clear();
+
+	// There is a single instanced render item, so the instance index identifies an instance.
+	for (const auto& renderItem : mAllRenderItems[RenderLayer::Instancing])
+	{
+		for (UINT i = 0; i < renderItem.instanceCount; i++)
+		{
+			BoundingBox worldBounds;
+			renderItem.bounds.Transform(worldBounds, XMLoadFloat4x4(&renderItem.instanceDatas[i].world));
+			mInstanceBvh.Insert(worldBounds, i);
+			mInstanceBounds.push_back(worldBounds);
+		}
+	}
+
+	// The instances don't move, build the tree once with the SAH.
+	mInstanceBvh.Rebuild();
+}
+void Renderer::BuildOccluders()
+{
+	mOcclusionCuller.ClearOccluders();
+
+	for (const auto& renderItem : mAllRenderItems[RenderLayer::Opaque])
+	{
+		if (renderItem.occluderMesh)
+			mOcclusionCuller.AddOccluder(*renderItem.occluderMesh, renderItem.world);
+	}
+}
+void Renderer::BuildClusterLights()
+{
+	std::mt19937 generator(7);
+
+	std::uniform_real_distribution<float> positionDistribution(-20.0f, 20.0f);
+	std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+	std::uniform_real_distribution<float> rangeDistribution(1.5f, 4.0f);
+	std::uniform_real_distribution<float> spotPowerDistribution(8.0f, 64.0f);
+
+	// Two thirds point lights, the rest spot lights pointing downwards.
+	mClusterLights.resize(mClusterLightCount);
+	for (UINT i = 0; i < mClusterLightCount; i++)
+	{
+		Light& light = mClusterLights[i];
+		light.strength = XMFLOAT3(unitDistribution(generator), unitDistribution(generator), unitDistribution(generator));
+		light.position = XMFLOAT3(positionDistribution(generator), positionDistribution(generator), positionDistribution(generator));
+		light.falloffEnd = rangeDistribution(generator);
+		light.falloffStart = 0.25f * light.falloffEnd;
+
+		if (i % 3 == 2)
+		{
+			XMVECTOR direction = XMVectorSet(unitDistribution(generator) - 0.5f, -1.0f, unitDistribution(generator) - 0.5f, 0.0f);
+			XMStoreFloat3(&light.direction, XMVector3Normalize(direction));
+			light.spotPower = spotPowerDistribution(generator);
+		}
+		else
+		{
+			light.direction = XMFLOAT3(0.0f, -1.0f, 0.0f);
+			light.spotPower = 0.0f;
+		}
+	}
+}
+void Renderer::BuildShadowCasters()
+{
+	mCascadedShadows.ClearCasters();
+
+	// Nothing moves, every caster is static and a cascade is only redrawn when it moves with the camera.
+	for (auto& renderItem : mAllRenderItems[RenderLayer::Opaque])
+	{
+		BoundingBox worldBounds;
+		renderItem.mesh.GetBoundingBox().Transform(worldBounds, XMLoadFloat4x4(&renderItem.world));
+		mCascadedShadows.AddCaster(worldBounds, true);
+	}
+	mOpaqueCasterCount = static_cast<UINT>(mAllRenderItems[RenderLayer::Opaque].size());
+
+	for (const auto& worldBounds : mInstanceBounds)
+		mCascadedShadows.AddCaster(worldBounds, true);
+}
 void Renderer::DrawRenderItems(RenderLayer renderLayer, ID3D12GraphicsCommandList* commandList,
 	ID3D12PipelineState* pipelineState)
 {
@@ -1097,6 +1428,10 @@ void Renderer::DrawRenderItems(RenderLayer renderLayer, ID3D12GraphicsCommandLis
 
 	for (auto& renderItem : renderItems)
 	{
+		UINT instanceCount = renderItem.instanceCount > 1 ? renderItem.visibleInstanceCount : renderItem.instanceCount;
+		if (instanceCount == 0)
+			continue;
+
 		mCurrentFrameResource->ResetBundle();
 
 		auto bundle = mCurrentFrameResource->GetBundle();
@@ -1134,10 +1469,127 @@ void Renderer::DrawRenderItems(RenderLayer renderLayer, ID3D12GraphicsCommandLis
 		bundle->SetGraphicsRootDescriptorTable(4, cbvSrvUavDescriptor);
 
 		bundle->DrawIndexedInstanced(renderItem.mesh.GetIndexCount(), 
-			renderItem.instanceCount, 0, 0, 0);
+			instanceCount, 0, 0, 0);
 
 		ThrowIfFailed(bundle->Close());
 
 		commandList->ExecuteBundle(bundle);
 	}
+}
+void Renderer::DrawShadowMaps(ID3D12GraphicsCommandList* commandList)
+{
+	if (mCascadedShadows.GetStatistics().renderedCascadeCount == 0)
+		return;
+
+	UINT sceneCBByteSize = D3D12Utility::CalculateConstantBufferSize(sizeof(SceneConstant));
+	UINT objectCBByteSize = D3D12Utility::CalculateConstantBufferSize(sizeof(ObjectConstant));
+
+	auto sceneCBAddress = mCurrentFrameResource->GetSceneConstantBuffers()
+		->GetUploadBuffer()->GetGPUVirtualAddress();
+	auto objectCBAddress = mCurrentFrameResource->GetObjectConstantBuffers()
+		->GetUploadBuffer()->GetGPUVirtualAddress();
+	auto shadowInstanceBufferAddress = mCurrentFrameResource->GetShadowInstanceBuffers()
+		->GetUploadBuffer()->GetGPUVirtualAddress();
+
+	auto& opaqueRenderItems = mAllRenderItems[RenderLayer::Opaque];
+	auto& instancingRenderItem = mAllRenderItems[RenderLayer::Instancing][0];
+
+	mShadowMap->BeginRender(commandList);
+
+	for (UINT i = 0; i < mCascadedShadows.GetCascadeCount(); i++)
+	{
+		if (!mCascadedShadows.NeedsRender(i))
+			continue;
+
+		mShadowMap->SetRenderTarget(commandList, i);
+		commandList->SetGraphicsRootConstantBufferView(1, sceneCBAddress + (1 + i) * sceneCBByteSize);
+
+		// The caster list is sorted, the opaque render items come first.
+		commandList->SetPipelineState(mPSOs["shadow"].Get());
+		for (auto caster : mCascadedShadows.GetCasters(i))
+		{
+			if (caster >= mOpaqueCasterCount)
+				break;
+
+			auto& renderItem = opaqueRenderItems[caster];
+			auto vbv = renderItem.mesh.GetVertexBufferView();
+			auto ibv = renderItem.mesh.GetIndexBufferView();
+
+			commandList->IASetVertexBuffers(0, 1, &vbv);
+			commandList->IASetIndexBuffer(&ibv);
+			commandList->IASetPrimitiveTopology(renderItem.mesh.GetPrimitiveType());
+			commandList->SetGraphicsRootConstantBufferView(0, objectCBAddress + renderItem.objectCBIndex * objectCBByteSize);
+
+			commandList->DrawIndexedInstanced(renderItem.mesh.GetIndexCount(), 1, 0, 0, 0);
+		}
+
+		if (mShadowInstanceCounts[i] == 0)
+			continue;
+
+		auto vbv = instancingRenderItem.mesh.GetVertexBufferView();
+		auto ibv = instancingRenderItem.mesh.GetIndexBufferView();
+
+		commandList->SetPipelineState(mPSOs["shadowInstancing"].Get());
+		commandList->IASetVertexBuffers(0, 1, &vbv);
+		commandList->IASetIndexBuffer(&ibv);
+		commandList->IASetPrimitiveTopology(instancingRenderItem.mesh.GetPrimitiveType());
+		commandList->SetGraphicsRootShaderResourceView(3, shadowInstanceBufferAddress +
+			i * instancingRenderItem.instanceCount * sizeof(InstanceData));
+
+		commandList->DrawIndexedInstanced(instancingRenderItem.mesh.GetIndexCount(), mShadowInstanceCounts[i], 0, 0, 0);
+	}
+
+	mShadowMap->EndRender(commandList);
+
+	commandList->SetGraphicsRootConstantBufferView(1, sceneCBAddress);
+}
+
+void Renderer::BuildRenderGraph()
+{
+	auto device = mDirect3D.GetDevice();
+	auto descriptorSize = mDirect3D.GetCbvSrvUavDescriptorSize();
+	auto postProcessRootSignature = mRootSignatures["postprocess"].Get();
+
+	mRenderGraph.Reset();
+
+	mBackBufferResource = mRenderGraph.ImportResource("BackBuffer", RenderGraphState::Common, RenderGraphState::Common);
+	mRenderTextureResource = mRenderGraph.ImportResource("RenderTexture", RenderGraphState::Common, RenderGraphState::Common);
+	mRenderGraphBackend->SetImportedResource(mRenderTextureResource, mRenderTexture.GetTextureResource());
+
+	auto scenePass = mRenderGraph.AddPass("Scene", [this]() { DrawScenePass(mRenderGraphBackend->GetCommandList()); });
+	mRenderGraph.Write(scenePass, mBackBufferResource, RenderGraphState::RenderTarget);
+
+	mBlurFilter->AddPasses(mRenderGraph, *mRenderGraphBackend, *mGpuProfiler, mBackBufferResource,
+		postProcessRootSignature, mPSOs["horzBlur"].Get(), mPSOs["vertBlur"].Get(),
+		mCbvSrvUavDescriptor, descriptorSize, 4);
+
+	mSobelFilter->AddPasses(mRenderGraph, *mRenderGraphBackend, *mGpuProfiler, mBlurFilter->GetBlurMap(),
+		postProcessRootSignature, mPSOs["sobel"].Get(), mCbvSrvUavDescriptor, descriptorSize);
+
+	auto copyPass = mRenderGraph.AddPass("CopyToRenderTexture", [this]()
+		{
+			mRenderGraphBackend->GetCommandList()->CopyResource(mRenderGraphBackend->GetResource(mRenderTextureResource),
+				mRenderGraphBackend->GetResource(mBackBufferResource));
+		});
+	mRenderGraph.Read(copyPass, mBackBufferResource, RenderGraphState::CopySource);
+	mRenderGraph.Write(copyPass, mRenderTextureResource, RenderGraphState::CopyDest);
+
+	auto compositePass = mRenderGraph.AddPass("Composite", [this]() { DrawCompositePass(mRenderGraphBackend->GetCommandList()); });
+	mRenderGraph.Read(compositePass, mRenderTextureResource, RenderGraphState::ShaderResource);
+	mRenderGraph.Read(compositePass, mSobelFilter->GetSobelMap(), RenderGraphState::ShaderResource);
+	mRenderGraph.Write(compositePass, mBackBufferResource, RenderGraphState::RenderTarget);
+
+	mRenderGraph.Compile();
+	mRenderGraphBackend->CreateTransientResources(mRenderGraph);
+
+	mBlurFilter->BuildDescriptors(device, *mRenderGraphBackend, mCbvSrvUavDescriptor, descriptorSize);
+	mSobelFilter->BuildDescriptors(device, *mRenderGraphBackend, mCbvSrvUavDescriptor, descriptorSize,
+		mBlurFilter->GetBlurMapDescriptorIndex());
+
+	// The blur maps and the sobel map live in one heap, the sobel map takes blur map 1's memory.
+	auto statistics = mRenderGraph.GetStatistics();
+	::OutputDebugStringA(("Render graph: " + std::to_string(statistics.passCount - statistics.culledPassCount) +
+		" passes, " + std::to_string(statistics.barrierCount) + " barriers in " +
+		std::to_string(statistics.barrierBatchCount) + " batches, " + std::to_string(statistics.transientBytes) +
+		" transient bytes in " + std::to_string(statistics.heapBytes) + " heap bytes\n").c_str());
 }
\ No newline at end of file
@@ -1,13 +1,24 @@
 #pragma once
 #include "../../Core/includes/BasicGeometryGenerator.h"
+#include "../../Core/includes/BoundingVolumeHierarchy.h"
 #include "../../Core/includes/Camera.h"
+#include "../../Core/includes/CascadedShadows.h"
+#include "../../Core/includes/ClusteredLightCuller.h"
 #include "../../Core/includes/Command.h"
+#include "../../Core/includes/D3D12RenderGraph.h"
+#include "../../Core/includes/D3D12TimestampQueries.h"
 #include "../../Core/includes/DepthStencil.h"
+#include "../../Core/includes/FrameStatistics.h"
 #include "../../Core/includes/Descriptor.h"
 #include "../../Core/includes/Direct3d.h"
 #include "../../Core/includes/Mesh.h"
 #include "../../Core/includes/Model.h"
+#include "../../Core/includes/OcclusionCuller.h"
+#include "../../Core/includes/Profiler.h"
 #include "../../Core/includes/Shader.h"
+#include "../../Core/includes/ShaderCache.h"
+#include "../../Core/includes/ShadowMap.h"
+#include "../../Core/includes/StartupTaskGraph.h"
 #include "../../Core/includes/Stdafx.h"
 #include "../../Core/includes/SwapChain.h"
 #include "../../Core/includes/Texture.h"
@@ -26,7 +37,10 @@ struct RenderItem
 	UINT materialCBIndex = -1;
 	UINT diffuseMapIndex = -1;
 	UINT instanceCount = 0;
+	UINT visibleInstanceCount = 0; // instances that passed culling this frame
 	std::vector<InstanceData> instanceDatas;
+	DirectX::BoundingBox bounds; // local space
+	const MeshData* occluderMesh = nullptr; // coarse mesh for occlusion culling, nullptr if it doesn't occlude
 
 	UINT numFrameDirty = 3;
 };
@@ -51,6 +65,8 @@ public:
 	static Renderer* GetRendererPointer();
 
 	static const UINT mFrameResourceCount;
+	static const UINT mClusterLightCount;
+	static const UINT mMaxLightIndexCount; // per frame, clusters past it lose their lights
 private:
 	bool InitializeWindow();
 
@@ -62,15 +78,21 @@ private:
 	void MouseDown(WPARAM btnState, int x, int y);
 	void MouseUp(WPARAM btnState, int x, int y);
 	void MouseMove(WPARAM btnState, int x, int y);
+	void PickInstance(int x, int y);
 
 	void ProcessKeyboardInput();
+	void UpdateFrameStatistics();
 	void UpdateData();
 	void DrawScene();
+	void DrawScenePass(ID3D12GraphicsCommandList* commandList);
+	void DrawCompositePass(ID3D12GraphicsCommandList* commandList);
 
 	void UpdateObjectConstants();
 	void UpdateSceneConstants();
 	void UpdateMaterialDatas();
 	void UpdateInstanceDatas();
+	void UpdateClusterDatas();
+	void UpdateShadowDatas();
 
 	void EnableDebugLayer();
 	void CheckMultiSamplingSupport(ID3D12Device* device, DXGI_FORMAT backBufferFormat);
@@ -87,13 +109,22 @@ private:
 		const std::string& rootSignatureName, const std::string& shaderName);
 	void CreateBlurPSO(ID3D12Device* device);
 	void CreateSobelPSO(ID3D12Device* device);
+	void CreateShadowPSO(ID3D12Device* device, const std::string& psoName,
+		const std::string& rootSignatureName, const std::string& shaderName);
 
 	void LoadTextures();
 	void BuildMaterials();
 
 	void BuildRenderItems();
+	void BuildInstanceBvh();
+	void BuildOccluders();
+	void BuildClusterLights();
+	void BuildShadowCasters();
 	void DrawRenderItems(RenderLayer renderLayer, ID3D12GraphicsCommandList* commandList, 
 		ID3D12PipelineState* pipelineState);
+	void DrawShadowMaps(ID3D12GraphicsCommandList* commandList);
+
+	void BuildRenderGraph();
 private:
 	// Window size variables.
 	UINT mWindowWidth;
@@ -118,6 +149,7 @@ private:
 	CbvSrvUavDescriptor mCbvSrvUavDescriptor;
 
 	std::unordered_map<std::string, Shader> mShaders;
+	ShaderCache mShaderCache{ "ShaderCache" }; // bytecode of previous runs
 
 	std::vector<std::unique_ptr<FrameResource>> mFrameResources;
 	FrameResource* mCurrentFrameResource = nullptr;
@@ -125,19 +157,32 @@ private:
 
 	std::unordered_map<std::string, RootSignature> mRootSignatures; // default count is 1
 	std::unordered_map<std::string, PipelineStateObject> mPSOs; // default count is 1
+	std::mutex mPSOMutex; // PSOs are created on the startup task graph
 
 	std::unique_ptr<BlurFilter> mBlurFilter = nullptr;
 	std::unique_ptr<SobelFilter> mSobelFilter = nullptr;
 
+	// Scene, blur, sobel and composite passes. Rebuilt on resize, the filter maps are its transients.
+	RenderGraph mRenderGraph;
+	std::unique_ptr<D3D12RenderGraphBackend> mRenderGraphBackend = nullptr;
+	uint32_t mBackBufferResource = RenderGraph::invalidIndex;
+	uint32_t mRenderTextureResource = RenderGraph::invalidIndex;
+
 	std::vector<InputElement> mInputLayout;
 
 	Camera mCamera;
 	
 	Timer mTimer;
+	FrameStatistics mFrameStatistics;
+	float mFrameStatisticsTime = 0.0f;
+
+	std::unique_ptr<D3D12TimestampQueries> mTimestampQueries = nullptr;
+	std::unique_ptr<GpuProfiler> mGpuProfiler = nullptr;
 
 	Texture mRenderTexture;
 
 	std::unordered_map<std::string, Mesh> mMeshes;
+	std::unordered_map<std::string, MeshData> mOccluderMeshes;
 	std::unordered_map<std::string, Texture> mTextures;
 	std::unordered_map<std::string, Material> mMaterials;
 
@@ -147,6 +192,28 @@ private:
 	std::vector<RenderItem> mCompositeRenderItems;
 	std::unordered_map<RenderLayer, std::vector<RenderItem>> mAllRenderItems;
 
+	// World bounds of the instances of the instancing render item, the user data is the instance index.
+	BoundingVolumeHierarchy mInstanceBvh;
+	std::vector<DirectX::BoundingBox> mInstanceBounds;
+	std::vector<uint32_t> mVisibleInstances;
+
+	// The frustum culling survivors are tested against the opaque render items.
+	OcclusionCuller mOcclusionCuller;
+	std::vector<DirectX::BoundingBox> mOcclusionCandidates;
+	std::vector<uint8_t> mOcclusionResults;
+
+	// Point and spot lights around the instances, assigned to clusters every frame.
+	ClusteredLightCuller mLightCuller;
+	std::vector<Light> mClusterLights;
+
+	// Cascaded shadows of lights[0]. The casters are the opaque render items followed by the instances,
+	// the instance casters of cascade i start at element i * instanceCount of the shadow instance buffer.
+	CascadedShadows mCascadedShadows;
+	std::unique_ptr<ShadowMap> mShadowMap = nullptr;
+	std::array<UINT, ShadowConstant::maxCascadeCount> mShadowInstanceCounts = {};
+	UINT mOpaqueCasterCount = 0;
+	DirectX::XMFLOAT3 mLightDirection = { 0.0f, -1.0f, -1.0f };
+
 	POINT mLastMousePos = { 0, 0 };
 
 	D3D12_VIEWPORT mScreenViewport;
@@ -1,16 +1,21 @@
 #include "SobelFilter.h"
 
-SobelFilter::SobelFilter(
-	ID3D12Device* device, 
-	UINT width, UINT height, 
-	DXGI_FORMAT format)
+SobelFilter::SobelFilter(UINT width, UINT height, DXGI_FORMAT format)
 	: mWidth(width), mHeight(height),
 	mFormat(format)
 {
-	BuildResources(device);
+
 }
 
-void SobelFilter::BuildResources(ID3D12Device* device)
+void SobelFilter::AddPasses(
+	RenderGraph& renderGraph,
+	D3D12RenderGraphBackend& renderGraphBackend,
+	GpuProfiler& gpuProfiler,
+	uint32_t inputTexture,
+	ID3D12RootSignature* rootSignature,
+	ID3D12PipelineState* sobelPSO,
+	CbvSrvUavDescriptor& descriptorBuilder,
+	UINT descriptorSize)
 {
 	D3D12_RESOURCE_DESC textureDesc;
 	textureDesc.Alignment = 0;
@@ -25,85 +30,66 @@ void SobelFilter::BuildResources(ID3D12Device* device)
 	textureDesc.SampleDesc.Quality = 0;
 	textureDesc.Width = mWidth;
 
-	ThrowIfFailed(device->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-		D3D12_HEAP_FLAG_NONE,
-		&textureDesc,
-		D3D12_RESOURCE_STATE_COMMON,
-		nullptr,
-		IID_PPV_ARGS(&mSobelMap)));
+	mSobelMap = renderGraphBackend.CreateTexture(renderGraph, "SobelMap", textureDesc);
+
+	auto sobelPass = renderGraph.AddPass("Sobel", [=, &renderGraphBackend, &gpuProfiler, &descriptorBuilder]()
+		{
+			auto commandList = renderGraphBackend.GetCommandList();
+
+			CD3DX12_GPU_DESCRIPTOR_HANDLE gpuInputSrv = descriptorBuilder.GetStartGPUDescriptorHandle();
+			CD3DX12_GPU_DESCRIPTOR_HANDLE gpuSobelMapUav = descriptorBuilder.GetStartGPUDescriptorHandle();
+			gpuInputSrv.Offset(mInputDescriptorIndex, descriptorSize);
+			gpuSobelMapUav.Offset(mSobelMapUavDescriptorIndex, descriptorSize);
+
+			gpuProfiler.BeginScope("Sobel");
+
+			commandList->SetComputeRootSignature(rootSignature);
+
+			commandList->SetComputeRootDescriptorTable(1, gpuInputSrv);
+			commandList->SetComputeRootDescriptorTable(2, gpuSobelMapUav);
+
+			commandList->SetPipelineState(sobelPSO);
+
+			commandList->Dispatch(16, 16, 1);
+
+			gpuProfiler.EndScope();
+		});
+	renderGraph.Read(sobelPass, inputTexture, RenderGraphState::ShaderResource);
+	renderGraph.Write(sobelPass, mSobelMap, RenderGraphState::UnorderedAccess);
 }
 
 void SobelFilter::BuildDescriptors(
 	ID3D12Device* device, 
+	D3D12RenderGraphBackend& renderGraphBackend,
 	CbvSrvUavDescriptor& descriptorBuilder, 
-	UINT cbvSrvUavDescriptorSize)
+	UINT cbvSrvUavDescriptorSize,
+	int inputDescriptorIndex)
 {
 	int currentDescriptorIndex = descriptorBuilder.GetCurrentDescriptorIndex();
 
+	auto sobelMap = renderGraphBackend.GetResource(mSobelMap);
+
 	descriptorBuilder.CreateShaderResourceView(device, cbvSrvUavDescriptorSize, mFormat,
-		D3D12_SRV_DIMENSION_TEXTURE2D, mSobelMap.Get());
+		D3D12_SRV_DIMENSION_TEXTURE2D, sobelMap);
 	descriptorBuilder.CreateUnorderedAccessView(device, cbvSrvUavDescriptorSize, mFormat,
-		D3D12_UAV_DIMENSION_TEXTURE2D, mSobelMap.Get(), nullptr);
+		D3D12_UAV_DIMENSION_TEXTURE2D, sobelMap, nullptr);
 
+	mInputDescriptorIndex = inputDescriptorIndex;
 	mSobelMapSrvDescriptorIndex = currentDescriptorIndex + 1;
 	mSobelMapUavDescriptorIndex = currentDescriptorIndex + 2;
 }
 
-void SobelFilter::Execute(
-	ID3D12GraphicsCommandList* commandList, 
-	ID3D12RootSignature* rootSignature, 
-	ID3D12PipelineState* sobelPSO, 
-	ID3D12Resource* inputTexture,
-	int inputDescriptorIndex,
-	CbvSrvUavDescriptor& descriptorBuilder, 
-	UINT descriptorSize)
-{
-	CD3DX12_GPU_DESCRIPTOR_HANDLE gpuBlurMapSrv = descriptorBuilder.GetStartGPUDescriptorHandle();
-	CD3DX12_GPU_DESCRIPTOR_HANDLE gpuSobelMapUav = descriptorBuilder.GetStartGPUDescriptorHandle();
-	gpuBlurMapSrv.Offset(inputDescriptorIndex, descriptorSize);
-	gpuSobelMapUav.Offset(mSobelMapUavDescriptorIndex, descriptorSize);
-
-	commandList->SetComputeRootSignature(rootSignature);
-
-	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(inputTexture,
-		D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_GENERIC_READ));
-	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mSobelMap.Get(),
-		D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
-
-	commandList->SetComputeRootDescriptorTable(1, gpuBlurMapSrv);
-	commandList->SetComputeRootDescriptorTable(2, gpuSobelMapUav);
-
-	commandList->SetPipelineState(sobelPSO);
-
-	commandList->Dispatch(16, 16, 1);
-
-	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mSobelMap.Get(),
-		D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_GENERIC_READ));
-}
-
-void SobelFilter::ResizeSobelMap(
-	UINT newWidth, UINT newHeight, 
-	ID3D12Device* device, 
-	CbvSrvUavDescriptor& descriptorBuilder, 
-	UINT cbvSrvUavDescriptorSize)
+void SobelFilter::ResizeSobelMap(UINT newWidth, UINT newHeight)
 {
-	if (mWidth != newWidth || mHeight != newHeight)
-	{
-		mWidth = newWidth;
-		mHeight = newHeight;
-
-		BuildResources(device);
-
-		BuildDescriptors(device, descriptorBuilder, cbvSrvUavDescriptorSize);
-	}
+	mWidth = newWidth;
+	mHeight = newHeight;
 }
 
-ID3D12Resource* SobelFilter::GetSobelMap()
+uint32_t SobelFilter::GetSobelMap()
 {
-	return mSobelMap.Get();
+	return mSobelMap;
 }
 int SobelFilter::GetSobelMapSrvDescriptorIndex()
 {
 	return mSobelMapSrvDescriptorIndex;
-}
+}
\ No newline at end of file
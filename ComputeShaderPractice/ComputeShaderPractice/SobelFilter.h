@@ -1,48 +1,47 @@
 #pragma once
-#pragma once
 #include "../../Core/includes/Stdafx.h"
+#include "../../Core/includes/D3D12RenderGraph.h"
 #include "../../Core/includes/Descriptor.h"
+#include "../../Core/includes/Profiler.h"
 
+// Sobel edge detection as a render graph pass, the sobel map is a transient of the graph.
 class SobelFilter
 {
 public:
-	SobelFilter(
-		ID3D12Device* device,
-		UINT width, UINT height,
-		DXGI_FORMAT format);
-
-	void BuildResources(ID3D12Device* device);
-
-	void BuildDescriptors(
-		ID3D12Device* device,
-		CbvSrvUavDescriptor& descriptorBuilder,
-		UINT cbvSrvUavDescriptorSize);
-
-	void Execute(
-		ID3D12GraphicsCommandList* commandList,
+	SobelFilter(UINT width, UINT height, DXGI_FORMAT format);
+
+	// Declares the sobel map and adds the pass filtering inputTexture into it.
+	void AddPasses(
+		RenderGraph& renderGraph,
+		D3D12RenderGraphBackend& renderGraphBackend,
+		GpuProfiler& gpuProfiler,
+		uint32_t inputTexture,
 		ID3D12RootSignature* rootSignature,
 		ID3D12PipelineState* sobelPSO,
-		ID3D12Resource* inputTexture,
-		int inputDescriptorIndex,
 		CbvSrvUavDescriptor& descriptorBuilder,
 		UINT descriptorSize);
 
-	void ResizeSobelMap(UINT newWidth, UINT newHeight,
+	// After the graph created its transient resources, inputDescriptorIndex is the SRV of the input texture.
+	void BuildDescriptors(
 		ID3D12Device* device,
+		D3D12RenderGraphBackend& renderGraphBackend,
 		CbvSrvUavDescriptor& descriptorBuilder,
-		UINT cbvSrvUavDescriptorSize);
+		UINT cbvSrvUavDescriptorSize,
+		int inputDescriptorIndex);
 
-	ID3D12Resource* GetSobelMap();
+	// The passes have to be added again.
+	void ResizeSobelMap(UINT newWidth, UINT newHeight);
+
+	uint32_t GetSobelMap(); // graph resource with the result
 	int GetSobelMapSrvDescriptorIndex();
 private:
-	static const int maxBlurRadius;
-
-	Microsoft::WRL::ComPtr<ID3D12Resource> mSobelMap = nullptr;
+	uint32_t mSobelMap = RenderGraph::invalidIndex;
 
 	UINT mWidth = 0;
 	UINT mHeight = 0;
 	DXGI_FORMAT mFormat = DXGI_FORMAT_UNKNOWN;
 
+	int mInputDescriptorIndex = -1;
 	int mSobelMapSrvDescriptorIndex = -1;
 	int mSobelMapUavDescriptorIndex = -1;
 };
\ No newline at end of file
@@ -1,27 +1,25 @@
 #pragma once
-#include "Stdafx.h"
-#include "Utility.h"
-
-class Mesh;
+#include "CoreTypes.h"
 
 class BasicGeometryGenerator
 {
 public:
 	BasicGeometryGenerator() = default;
 
-	Mesh CreateBox(float width, float height, float depth);
-	Mesh CreateGrid(float width, float depth, uint32_t m, uint32_t n);
-	Mesh CreateSphere(float radius, uint32_t sliceCount, uint32_t stackCount);
+	MeshData CreateBox(float width, float height, float depth);
+	MeshData CreateGrid(float width, float depth, uint32_t m, uint32_t n);
+	MeshData CreateSphere(float radius, uint32_t sliceCount, uint32_t stackCount);
 
-	Mesh CreateTerrain(const unsigned char* heightValues, 
+	// Triangle list with a vertex per texel, TerrainBuilder also streams big 16 bit heightmaps in tiles.
+	MeshData CreateTerrain(const unsigned char* heightValues, 
 		int width, int height, int nChannels);
-	Mesh CreateTerrainPatches(int width, int height, UINT countOfPatches);
+	MeshData CreateTerrainPatches(int width, int height, uint32_t countOfPatches);
 
-	Mesh CreateQuad(float x, float y, float w, float h, float depth);
+	MeshData CreateQuad(float x, float y, float w, float h, float depth);
 private:
 	std::vector<Vertex> mVertices;
-	UINT mVertexCount;
+	uint32_t mVertexCount;
 
 	std::vector<uint32_t> mIndices;
-	UINT mIndexCount;
+	uint32_t mIndexCount;
 };
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+#include "CoreTypes.h"
+
+struct BvhRayHit
+{
+	uint32_t proxy = 0xffffffff;
+	uint32_t userData = 0;
+	float distance = 0.0f;
+};
+
+// Dynamic tree of axis aligned boxes. Every object is a leaf, its node index is the proxy returned by Insert
+// and stays valid until Remove, also across Rebuild. Insert picks the sibling with the lowest surface area
+// heuristic cost, Update only refits the ancestors, so after many moves Rebuild rebuilds the tree top down
+// with a binned SAH. Nodes are tested with DirectXMath vectors, the frustum test four planes at a time.
+class BoundingVolumeHierarchy
+{
+public:
+	static const uint32_t invalidNode = 0xffffffff;
+	static const uint32_t sahBinCount = 16;
+
+	BoundingVolumeHierarchy() = default;
+
+	uint32_t Insert(const DirectX::BoundingBox& bounds, uint32_t userData);
+	void Remove(uint32_t proxy);
+	void Update(uint32_t proxy, const DirectX::BoundingBox& bounds);
+	void Rebuild();
+	void Clear();
+
+	DirectX::BoundingBox GetBounds(uint32_t proxy);
+	uint32_t GetUserData(uint32_t proxy);
+	uint32_t GetProxyCount();
+	uint32_t GetHeight();
+	// Surface area of all inner nodes relative to the root, lower is better.
+	// Compare it with the value right after Rebuild to decide when to rebuild again.
+	float GetSurfaceAreaCost();
+
+	// Append the user data of every object whose box overlaps the volume.
+	void QueryFrustum(const DirectX::BoundingFrustum& frustum, std::vector<uint32_t>& results);
+	void QuerySphere(const DirectX::BoundingSphere& sphere, std::vector<uint32_t>& results);
+
+	// Closest box hit along the ray within maxDistance. intersect refines a box hit, e.g. against the mesh:
+	// it gets the user data and the box distance, returns false for a miss or true with the exact distance.
+	bool RayCast(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction, float maxDistance, BvhRayHit& hit,
+		const std::function<bool(uint32_t, float&)>& intersect = nullptr);
+private:
+	struct Node
+	{
+		DirectX::XMFLOAT4 boundsMin; // w unused, four floats per load
+		DirectX::XMFLOAT4 boundsMax;
+		uint32_t parent = invalidNode;
+		uint32_t child0 = invalidNode; // invalidNode for a leaf
+		uint32_t child1 = invalidNode; // next free node while the node is on the free list
+		uint32_t userData = 0;
+		int height = 0; // 0 for a leaf, -1 for a free node
+	};
+
+	uint32_t AllocateNode();
+	void FreeNode(uint32_t node);
+	bool IsLeaf(uint32_t node);
+
+	void InsertLeaf(uint32_t leaf);
+	void RemoveLeaf(uint32_t leaf);
+	uint32_t FindBestSibling(uint32_t leaf);
+	void RefitAncestors(uint32_t node);
+
+	uint32_t BuildRange(uint32_t* leaves, uint32_t count, uint32_t parent);
+	void CollectLeaves(uint32_t node, std::vector<uint32_t>& results);
+private:
+	std::vector<Node> mNodes;
+	uint32_t mRoot = invalidNode;
+	uint32_t mFreeList = invalidNode;
+	uint32_t mProxyCount = 0;
+
+	std::vector<std::pair<float, uint32_t>> mSiblingCandidates; // scratch of FindBestSibling
+};
\ No newline at end of file
@@ -1,5 +1,27 @@
 #pragma once
-#include "Stdafx.h"
+#include "CoreTypes.h"
+
+// Standard maps the near plane to depth 0 and the far plane to 1. Reversed maps near to 1 and far to 0, with a
+// float depth buffer that keeps the precision roughly constant over distance. ReversedInfinite also moves the
+// far plane of the projection to infinity, the far plane given to SetLens is then only the culling distance.
+enum class DepthMode : int
+{
+	Standard = 0,
+	Reversed,
+	ReversedInfinite
+};
+
+// The depth test of a depth mode, LESS or GREATER.
+enum class DepthComparison : int
+{
+	Less = 0,
+	Greater
+};
+
+// A depth buffer is cleared to the far value of its depth mode and a fragment passes when it is nearer than
+// the stored depth. DepthStencil and SoftwareRasterizer take both from here, so they always flip together.
+float GetClearDepth(DepthMode depthMode);
+DepthComparison GetDepthComparison(DepthMode depthMode);
 
 class Camera
 {
@@ -14,8 +36,19 @@ public:
 	DirectX::XMFLOAT3 GetUp();
 	DirectX::XMFLOAT3 GetLook();
 
-	DirectX::XMFLOAT4X4 GetView();
-	DirectX::XMFLOAT4X4 GetProj();
+	// The matrices and the frustum are cached, they are rebuilt on the first query after the camera
+	// moved or the lens changed.
+	const DirectX::XMFLOAT4X4& GetView();
+	const DirectX::XMFLOAT4X4& GetProj();
+	const DirectX::XMFLOAT4X4& GetViewProj();
+	const DirectX::XMFLOAT4X4& GetInverseView();
+	const DirectX::XMFLOAT4X4& GetInverseProj();
+	const DirectX::XMFLOAT4X4& GetInverseViewProj();
+
+	const DirectX::BoundingFrustum& GetFrustum(); // world space
+	// World space planes in near, far, left, right, top, bottom order, normalized and facing inwards,
+	// a point p is inside when dot(plane, float4(p, 1)) >= 0 for all six.
+	const std::array<DirectX::XMFLOAT4, 6>& GetFrustumPlanes();
 
 	void LookAt(
 		const DirectX::XMFLOAT3& position,
@@ -32,13 +65,26 @@ public:
 		float zn,
 		float zf);
 
+	void SetDepthMode(DepthMode depthMode);
+	DepthMode GetDepthMode();
+	bool IsReversedZ();
+
+	float GetNearZ();
+	float GetFarZ();
+
 	void Strafe(float distance);
 	void Walk(float distance);
 
 	void Pitch(float angle);
 	void RotateY(float angle);
+
+	// World space ray through a pixel of the viewport, e.g. the mouse position for picking.
+	void GetPickingRay(float screenX, float screenY, float viewportWidth, float viewportHeight,
+		DirectX::XMFLOAT3& origin, DirectX::XMFLOAT3& direction);
 private:
 	void UpdateViewMatrix();
+	void UpdateProjMatrix();
+	void UpdateMatrices();
 private:
 	DirectX::XMFLOAT3 mPosition;
 
@@ -51,6 +97,19 @@ private:
 	float mNearZ = 0.0f;
 	float mFarZ = 0.0f;
 
+	DepthMode mDepthMode = DepthMode::Standard;
+
 	DirectX::XMFLOAT4X4 mView;
 	DirectX::XMFLOAT4X4 mProj;
+	DirectX::XMFLOAT4X4 mViewProj;
+	DirectX::XMFLOAT4X4 mInverseView;
+	DirectX::XMFLOAT4X4 mInverseProj;
+	DirectX::XMFLOAT4X4 mInverseViewProj;
+
+	DirectX::BoundingFrustum mViewSpaceFrustum;
+	DirectX::BoundingFrustum mFrustum;
+	std::array<DirectX::XMFLOAT4, 6> mFrustumPlanes;
+
+	bool mViewDirty = true;
+	bool mProjDirty = true;
 };
\ No newline at end of file
@@ -0,0 +1,139 @@
+#pragma once
+#include "Camera.h"
+#include "CoreTypes.h"
+#include "JobSystem.h"
+
+// Mirrors cbShadow in common.hlsl.
+struct ShadowConstant
+{
+	static constexpr uint32_t maxCascadeCount = 4;
+
+	DirectX::XMFLOAT4X4 shadowTransforms[maxCascadeCount]; // world to shadow map uv and depth per cascade, transposed
+	DirectX::XMFLOAT4 cascadeSplits; // view depth where each cascade ends
+	DirectX::XMFLOAT4 cascadeTexelSizes; // world size of a shadow map texel, for the normal offset
+	uint32_t cascadeCount;
+	float shadowMapTexelSize; // 1 / resolution
+	float pad0;
+	float pad1;
+};
+
+struct ShadowCascade
+{
+	DirectX::XMFLOAT4X4 viewProj; // light view and orthographic projection, not transposed
+	DirectX::XMFLOAT4X4 shadowTransform; // viewProj followed by the NDC to texture transform
+
+	float splitNear = 0.0f; // view depth range of the camera covered by the cascade
+	float splitFar = 0.0f;
+	float worldTexelSize = 0.0f;
+
+	// Orthographic volume in light view space, casters outside of it are culled.
+	DirectX::XMFLOAT3 lightSpaceMin;
+	DirectX::XMFLOAT3 lightSpaceMax;
+};
+
+struct CascadedShadowsStatistics
+{
+	uint32_t casterCount = 0;
+	uint32_t culledCasterCount = 0; // in no cascade
+	std::array<uint32_t, ShadowConstant::maxCascadeCount> cascadeCasterCounts = {};
+	uint32_t renderedCascadeCount = 0; // cascades that need a render this frame
+
+	double updateMilliseconds = 0.0;
+};
+
+// Cascaded shadow maps for a directional light. The camera's depth range up to the shadow distance is
+// split with the practical scheme (a blend of logarithmic and uniform splits), every cascade is fitted
+// to the bounding sphere of its frustum slice and snapped to whole shadow map texels, so the shadows
+// don't shimmer while the camera moves or turns. Shadow casters are culled per cascade in parallel.
+// A cascade whose projection didn't change and whose casters are all static keeps last frame's
+// contents, NeedsRender tells which cascades have to be drawn again.
+class CascadedShadows
+{
+public:
+	CascadedShadows(uint32_t cascadeCount = 4, uint32_t resolution = 2048,
+		JobSystem& jobSystem = JobSystem::GetDefault());
+
+	void SetCascadeCount(uint32_t cascadeCount); // up to ShadowConstant::maxCascadeCount
+	uint32_t GetCascadeCount();
+	uint32_t GetResolution();
+
+	void SetSplitLambda(float lambda); // 0 uniform, 1 logarithmic, 0.75 by default
+	// The cascades move in steps of this many texels, bigger steps redraw them less often while the
+	// camera moves but waste more of the shadow map. 1 is plain texel snapping, 16 by default.
+	void SetSnapTexels(uint32_t snapTexels);
+	void SetShadowDistance(float distance); // the cascades end at min(camera far plane, distance), 100 by default
+	// The cascades' depth range starts at the side facing the light. Grows with the casters, set it
+	// when there is more than the casters between the light and the cascades.
+	void SetSceneBounds(const DirectX::BoundingBox& worldBounds);
+
+	// Static casters are cached, moving one with SetCasterBounds redraws the cascades it left and entered.
+	// Dynamic casters redraw their cascades every frame.
+	uint32_t AddCaster(const DirectX::BoundingBox& worldBounds, bool isStatic);
+	void SetCasterBounds(uint32_t caster, const DirectX::BoundingBox& worldBounds);
+	void ClearCasters();
+	void Invalidate(); // redraw every cascade on the next Update
+
+	// Fits the cascades to the camera and culls the casters. lightDirection points away from the light.
+	void Update(Camera& camera, const DirectX::XMFLOAT3& lightDirection);
+
+	const ShadowCascade& GetCascade(uint32_t cascade);
+	bool NeedsRender(uint32_t cascade);
+	const std::vector<uint32_t>& GetCasters(uint32_t cascade); // sorted caster indices
+	ShadowConstant GetShadowConstant();
+
+	CascadedShadowsStatistics GetStatistics(); // of the last Update
+
+	// splits[i] is the view depth where cascade i ends, splits[count - 1] is farZ.
+	static void ComputeSplitDistances(float nearZ, float farZ, uint32_t count, float lambda, float* splits);
+	// Smallest sphere around the slice [sliceNear, sliceFar] of a symmetric frustum with the given
+	// slopes, its center is on the view axis. Independent of the camera orientation.
+	static void ComputeSliceSphere(float slopeX, float slopeY, float sliceNear, float sliceFar,
+		float& centerZ, float& radius);
+
+	static const uint32_t castersPerJob = 256;
+private:
+	struct Caster
+	{
+		DirectX::BoundingBox worldBounds;
+		bool isStatic;
+		bool moved;
+	};
+
+	// What a cascade was rendered with, the cached contents are valid while it doesn't change.
+	struct CascadeKey
+	{
+		float left, bottom, nearZ, farZ, radius;
+	};
+
+	void GrowSceneBounds(const DirectX::BoundingBox& worldBounds);
+	void UpdateLightView(const DirectX::XMFLOAT3& lightDirection);
+	void FitCascade(uint32_t cascade, Camera& camera, float slopeX, float slopeY, float sliceNear, float sliceFar,
+		const DirectX::XMFLOAT3& sceneMin, const DirectX::XMFLOAT3& sceneMax);
+	void CullCasters(uint32_t begin, uint32_t end);
+private:
+	JobSystem& mJobSystem;
+
+	uint32_t mCascadeCount;
+	uint32_t mResolution;
+	float mSplitLambda = 0.75f;
+	uint32_t mSnapTexels = 16;
+	float mShadowDistance = 100.0f;
+
+	DirectX::BoundingBox mSceneBounds;
+	bool mHasSceneBounds = false;
+
+	DirectX::XMFLOAT3 mLightDirection = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+	DirectX::XMFLOAT4X4 mLightView;
+
+	std::array<ShadowCascade, ShadowConstant::maxCascadeCount> mCascades;
+	std::array<CascadeKey, ShadowConstant::maxCascadeCount> mCascadeKeys;
+	std::array<std::vector<uint32_t>, ShadowConstant::maxCascadeCount> mCascadeCasters;
+	uint32_t mRenderMask = 0; // bit per cascade that needs a render
+	bool mInvalidated = true;
+
+	std::vector<Caster> mCasters;
+	std::vector<uint8_t> mCasterMasks; // bit per cascade the caster touches
+	std::vector<uint8_t> mPreviousCasterMasks;
+
+	CascadedShadowsStatistics mStatistics;
+};
\ No newline at end of file
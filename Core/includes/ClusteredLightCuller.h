@@ -0,0 +1,128 @@
+#pragma once
+#include "Camera.h"
+#include "CoreTypes.h"
+#include "JobSystem.h"
+
+// Range of one cluster in the light index list, mirrors LightCluster in common.hlsl.
+struct LightCluster
+{
+	uint32_t offset;
+	uint32_t count;
+};
+
+// Mirrors cbClusters in common.hlsl. A pixel's cluster is (SV_Position.xy * tileScale,
+// log(viewZ) * depthScale + depthBias).
+struct ClusterConstant
+{
+	uint32_t clusterCountX;
+	uint32_t clusterCountY;
+	uint32_t clusterCountZ;
+	float depthScale;
+	float tileScaleX;
+	float tileScaleY;
+	float depthBias;
+	float pad0;
+};
+
+struct ClusteredLightCullerStatistics
+{
+	uint32_t lightCount = 0;
+	uint32_t visibleLightCount = 0; // touching at least one slice
+	uint32_t lightIndexCount = 0;
+	uint32_t maxLightsPerCluster = 0;
+	uint32_t nonEmptyClusterCount = 0;
+
+	double assignMilliseconds = 0.0;
+};
+
+// Clustered (froxel) light assignment. The view frustum is split into screen tiles and exponential
+// depth slices between the camera's near and far planes, and every cluster gets the sorted list of
+// point/spot lights touching its view space bounds. Slices are assigned in parallel, four clusters of
+// a row are tested at a time: point lights as spheres against the cluster boxes, spot lights also as
+// cones against the cluster bounding spheres.
+class ClusteredLightCuller
+{
+public:
+	ClusteredLightCuller(uint32_t clusterCountX = 16, uint32_t clusterCountY = 9, uint32_t clusterCountZ = 24,
+		JobSystem& jobSystem = JobSystem::GetDefault());
+
+	void SetViewport(uint32_t width, uint32_t height); // only used by GetClusterConstant
+
+	// Lights with spotPower > 0 are spot lights, the others point lights, falloffEnd is the range.
+	// A spot cone ends where pow(cos, spotPower) drops below 1/256. The cluster bounds are rebuilt
+	// when the lens changed.
+	void AssignLights(Camera& camera, const Light* lights, uint32_t lightCount);
+	void AssignLights(Camera& camera, const std::vector<Light>& lights);
+
+	const std::vector<LightCluster>& GetClusters(); // x fastest, then y (top row first), then z
+	const std::vector<uint32_t>& GetLightIndices();
+	ClusterConstant GetClusterConstant();
+
+	uint32_t GetClusterIndex(uint32_t x, uint32_t y, uint32_t z);
+	uint32_t GetClusterCount();
+	DirectX::BoundingBox GetClusterBounds(uint32_t cluster); // view space
+
+	ClusteredLightCullerStatistics GetStatistics(); // of the last AssignLights
+
+	static float GetSpotCosAngle(float spotPower);
+private:
+	// Four consecutive clusters of a row, structure of arrays.
+	struct ClusterGroup
+	{
+		DirectX::XMFLOAT4 minX, minY, minZ;
+		DirectX::XMFLOAT4 maxX, maxY, maxZ;
+		DirectX::XMFLOAT4 centerX, centerY, centerZ, radius;
+	};
+
+	struct ViewLight
+	{
+		DirectX::XMFLOAT3 position;
+		float range;
+		DirectX::XMFLOAT3 direction;
+		float cosAngle; // 0 for point lights
+		float sinAngle;
+		bool spot;
+		uint32_t index; // into the lights passed to AssignLights
+		uint32_t minX, maxX, minY, maxY, minZ, maxZ; // cluster range, inclusive
+	};
+
+	struct ClusterHit
+	{
+		uint32_t cluster; // in the slice
+		uint32_t light;
+	};
+
+	void BuildClusters(Camera& camera);
+	bool SetupLight(const Light& light, const DirectX::XMFLOAT4X4& view, ViewLight& viewLight);
+	uint32_t GetSlice(float viewZ);
+	void AssignSlice(uint32_t slice);
+private:
+	JobSystem& mJobSystem;
+
+	uint32_t mClusterCountX;
+	uint32_t mClusterCountY;
+	uint32_t mClusterCountZ;
+	uint32_t mGroupsPerRow;
+
+	uint32_t mViewportWidth = 1;
+	uint32_t mViewportHeight = 1;
+
+	// Lens the cluster bounds were built for.
+	float mProjScaleX = 0.0f;
+	float mProjScaleY = 0.0f;
+	float mNearZ = 0.0f;
+	float mFarZ = 0.0f;
+	float mDepthScale = 0.0f; // slices per unit of log(viewZ)
+	float mDepthBias = 0.0f;
+
+	std::vector<ClusterGroup> mGroups;
+	std::vector<ViewLight> mViewLights;
+
+	std::vector<std::vector<ClusterHit>> mSliceHits;
+	std::vector<std::vector<uint32_t>> mSliceIndices;
+
+	std::vector<LightCluster> mClusters;
+	std::vector<uint32_t> mLightIndices;
+
+	ClusteredLightCullerStatistics mStatistics;
+};
\ No newline at end of file
@@ -0,0 +1,136 @@
+#pragma once
+// Platform neutral part of Core: standard library, DirectXMath and the plain data types shared by the
+// renderers and the CPU-side systems. Headers that only include this file (Camera, Timer, JobSystem,
+// BasicGeometryGenerator, ImageFilter, SoftwareRasterizer, Profiler, FrameStatistics) build without
+// the Windows SDK, the D3D12 backend includes Stdafx.h instead.
+#include <DirectXCollision.h>
+#include <DirectXColors.h>
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <codecvt>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <locale>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct EnumHash
+{
+	template <typename T>
+	std::size_t operator()(T t) const
+	{
+		return static_cast<std::size_t>(t);
+	}
+};
+
+struct Vertex
+{
+	Vertex() = default;
+	Vertex(float px, float py, float pz, 
+		float nx, float ny, float nz, 
+		float u, float v)
+		: position(DirectX::XMFLOAT3(px, py, pz)),
+		normal(DirectX::XMFLOAT3(nx, ny, nz)),
+		texCoord(DirectX::XMFLOAT2(u, v))
+	{ }
+
+	DirectX::XMFLOAT3 position;
+	DirectX::XMFLOAT3 normal;
+	DirectX::XMFLOAT2 texCoord;
+};
+
+// Mirrors the D3D_PRIMITIVE_TOPOLOGY values the engine uses, Mesh translates it.
+enum class PrimitiveTopology : int
+{
+	TriangleList = 0,
+	PatchList4 // 4 control point patches for the tessellation samples
+};
+
+// CPU side geometry, what BasicGeometryGenerator produces and Mesh uploads.
+struct MeshData
+{
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	PrimitiveTopology topology = PrimitiveTopology::TriangleList;
+};
+
+struct Light
+{
+	DirectX::XMFLOAT3 strength;
+	float falloffStart; // point/spot light only
+	DirectX::XMFLOAT3 direction; // directional/spot light only
+	float falloffEnd; // point/spot light only
+	DirectX::XMFLOAT3 position; // point light only
+	float spotPower; // spot light only
+
+	static constexpr int maxNumLights = 16;
+};
+
+struct Material
+{
+	std::string name;
+	DirectX::XMFLOAT4 diffuseAlbedo;
+	DirectX::XMFLOAT3 fresnelR0;
+	float roughness;
+};
+
+enum class RenderLayer : int
+{
+	Opaque = 0,
+	Instancing,
+	Sky,
+	Composite,
+	Count
+};
+
+struct ObjectConstant
+{
+	DirectX::XMFLOAT4X4 world;
+	uint32_t materialIndex;
+};
+
+struct SceneConstant
+{
+	DirectX::XMFLOAT4X4 view;
+	DirectX::XMFLOAT4X4 proj;
+	DirectX::XMFLOAT4X4 viewProj; // precomputed so the shaders don't multiply view and proj per vertex
+	DirectX::XMFLOAT4X4 invView;
+
+	DirectX::XMFLOAT3 cameraPosition;
+	float farDepth = 1.0f; // depth of the far plane, 0 with reversed-Z
+
+	DirectX::XMFLOAT4 ambientLight;
+	std::array<Light, Light::maxNumLights> lights;
+};
+
+struct MaterialData
+{
+	DirectX::XMFLOAT4 diffuseAlbedo;
+	DirectX::XMFLOAT3 fresnelR0;
+	float roughness;
+};
+
+struct InstanceData
+{
+	DirectX::XMFLOAT4X4 world;
+	uint32_t materialIndex;
+};
\ No newline at end of file
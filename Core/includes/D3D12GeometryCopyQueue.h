@@ -0,0 +1,44 @@
+#pragma once
+#include "Stdafx.h"
+#include "Utility.h"
+#include "GeometryUploader.h"
+
+// Upload heap staging buffer, mapped for its whole life, and a command list that copies out of it on
+// commandQueue. Buffers promote from the common state to copy destination and decay back once the copies
+// are done, so the copies need no barriers. On the direct queue later command lists see the copies, with
+// a copy queue the caller waits for the fence before using the buffers.
+class D3D12GeometryCopyQueue : public GeometryCopyQueue
+{
+public:
+	D3D12GeometryCopyQueue(ID3D12Device* device, ID3D12CommandQueue* commandQueue, UINT64 stagingSize = 16 * 1024 * 1024);
+	~D3D12GeometryCopyQueue(); // waits for the submitted copies
+
+	uint64_t GetStagingSize() override;
+	uint8_t* GetStagingData() override;
+
+	void RecordCopies(const GeometryCopy* copies, uint32_t count) override;
+	uint64_t Submit() override;
+	uint64_t GetCompletedFenceValue() override;
+	void WaitForFenceValue(uint64_t fenceValue) override;
+private:
+	struct SubmittedAllocator
+	{
+		CommandAllocator allocator;
+		UINT64 fenceValue;
+	};
+
+	ID3D12Device* mDevice = nullptr;
+	ID3D12CommandQueue* mCommandQueue = nullptr;
+	D3D12_COMMAND_LIST_TYPE mCommandListType = D3D12_COMMAND_LIST_TYPE_DIRECT;
+
+	Microsoft::WRL::ComPtr<ID3D12Resource> mStagingBuffer = nullptr;
+	UINT64 mStagingSize = 0;
+	BYTE* mStagingData = nullptr;
+
+	GraphicsCommandList mCommandList = nullptr;
+	CommandAllocator mRecordingAllocator = nullptr; // while copies are recorded
+	std::deque<SubmittedAllocator> mSubmittedAllocators; // oldest first, reused once their fence passed
+
+	Microsoft::WRL::ComPtr<ID3D12Fence> mFence = nullptr;
+	UINT64 mFenceValue = 0;
+};
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+#include "Stdafx.h"
+#include "Utility.h"
+#include "GpuMemoryAllocator.h"
+
+// ID3D12Heaps for GpuMemoryAllocator, restricted to the resource class of their pool.
+class D3D12HeapFactory : public GpuHeapFactory
+{
+public:
+	explicit D3D12HeapFactory(ID3D12Device* device);
+
+	void* CreateHeap(GpuHeapType heapType, GpuResourceClass resourceClass, uint64_t byteSize, uint64_t alignment) override;
+	void DestroyHeap(void* heap) override;
+private:
+	ID3D12Device* mDevice = nullptr;
+};
+
+// Creates resources as placed resources in the heaps of a GpuMemoryAllocator instead of one implicit heap
+// per committed resource. The allocation travels with the resource as private data and is freed when the
+// resource is destroyed, so callers keep their ComPtr and release it like before. Placed render targets
+// and depth stencil buffers have to be cleared or discarded before their first use.
+class D3D12MemoryAllocator
+{
+public:
+	explicit D3D12MemoryAllocator(ID3D12Device* device);
+
+	// Shared by Core's resources, created with the first device passed in.
+	static D3D12MemoryAllocator& GetDefault(ID3D12Device* device);
+
+	// Throws when the budget of the heap type doesn't allow the resource.
+	Microsoft::WRL::ComPtr<ID3D12Resource> CreateResource(
+		D3D12_HEAP_TYPE heapType,
+		const D3D12_RESOURCE_DESC& resourceDesc,
+		D3D12_RESOURCE_STATES initialState,
+		const D3D12_CLEAR_VALUE* optimizedClearValue = nullptr);
+	Microsoft::WRL::ComPtr<ID3D12Resource> CreateBuffer(
+		D3D12_HEAP_TYPE heapType,
+		UINT64 byteSize,
+		D3D12_RESOURCE_STATES initialState,
+		D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE);
+
+	// The local video memory budget DXGI reports for the default heaps, the non-local one for upload and
+	// readback heaps. On UMA adapters every heap type gets the local budget.
+	void SetBudgetsFromAdapter();
+	void SetBudget(D3D12_HEAP_TYPE heapType, UINT64 budgetBytes);
+	void SetHeapSize(D3D12_HEAP_TYPE heapType, UINT64 heapSize);
+	GpuMemoryStatistics GetStatistics();
+private:
+	struct State
+	{
+		explicit State(ID3D12Device* device)
+			: heapFactory(device), allocator(heapFactory)
+		{ }
+
+		D3D12HeapFactory heapFactory;
+		GpuMemoryAllocator allocator;
+	};
+
+	static GpuHeapType ToGpuHeapType(D3D12_HEAP_TYPE heapType);
+private:
+	ID3D12Device* mDevice = nullptr;
+	std::shared_ptr<State> mState; // the resources share it, it lives until the last one is destroyed
+};
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+#include "Stdafx.h"
+#include "Utility.h"
+#include "D3D12MemoryAllocator.h"
+#include "RenderGraph.h"
+
+// D3D12 side of a RenderGraph: owns the transient textures and their heaps, and records the graph's
+// barriers on the command list the passes use.
+class D3D12RenderGraphBackend : public RenderGraphBackend
+{
+public:
+	explicit D3D12RenderGraphBackend(ID3D12Device* device);
+	~D3D12RenderGraphBackend();
+	D3D12RenderGraphBackend(const D3D12RenderGraphBackend& rhs) = delete;
+	D3D12RenderGraphBackend& operator=(const D3D12RenderGraphBackend& rhs) = delete;
+
+	// Declares a transient of the size and alignment the device needs for the resource. Its heap group is
+	// its GpuResourceClass, since tier 1 heaps can't mix buffers, textures and render targets.
+	uint32_t CreateTexture(RenderGraph& renderGraph, const char* name, const D3D12_RESOURCE_DESC& resourceDesc);
+	// After Compile, places the transients that are used in one heap per group. Releases the previous
+	// heaps and transients, the GPU has to be done with them.
+	void CreateTransientResources(RenderGraph& renderGraph);
+
+	void SetImportedResource(uint32_t resource, ID3D12Resource* d3dResource);
+	ID3D12Resource* GetResource(uint32_t resource);
+
+	// Barriers are recorded into this command list until the next call.
+	void SetCommandList(ID3D12GraphicsCommandList* commandList);
+	ID3D12GraphicsCommandList* GetCommandList();
+
+	void RecordBarriers(const RenderGraphBarrier* barriers, uint32_t count) override;
+
+	static D3D12_RESOURCE_STATES ToResourceStates(RenderGraphState state);
+private:
+	void ResizeResourceArrays(uint32_t resourceCount);
+	void ReleaseTransientResources();
+private:
+	ID3D12Device* mDevice = nullptr;
+	D3D12HeapFactory mHeapFactory;
+	std::vector<void*> mHeaps; // by heap group
+
+	// By graph resource. Imported resources aren't referenced, so the swap chain can resize its buffers.
+	std::vector<D3D12_RESOURCE_DESC> mResourceDescs;
+	std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> mTransients;
+	std::vector<ID3D12Resource*> mResources;
+	std::vector<bool> mNeedsDiscard; // contents undefined until the first write
+
+	ID3D12GraphicsCommandList* mCommandList = nullptr;
+	std::vector<D3D12_RESOURCE_BARRIER> mBarriers;
+	std::vector<ID3D12Resource*> mDiscards;
+};
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+#include "Stdafx.h"
+#include "Utility.h"
+#include "ResourceStateTracker.h"
+
+// ResourceStateTracker of one D3D12 command list, the flushed barriers go to the list in one
+// ResourceBarrier call. Resources are tracked once RegisterResource gave their state after creation.
+class D3D12ResourceStateTracker : public ResourceBarrierSink
+{
+public:
+	D3D12ResourceStateTracker();
+
+	static void RegisterResource(ID3D12Resource* resource, D3D12_RESOURCE_STATES state);
+	static void UnregisterResource(ID3D12Resource* resource);
+	static ResourceStateRules GetStateRules();
+
+	// Starts tracking a newly reset command list.
+	void SetCommandList(ID3D12GraphicsCommandList* commandList);
+	ID3D12GraphicsCommandList* GetCommandList();
+
+	void TransitionResource(ID3D12Resource* resource, D3D12_RESOURCE_STATES state);
+	void UAVBarrier(ID3D12Resource* resource);
+	void FlushResourceBarriers();
+
+	ResourceStateTracker& GetTracker();
+
+	void RecordBarriers(const ResourceBarrierDesc* barriers, uint32_t count) override;
+private:
+	ResourceStateTracker mTracker;
+	ID3D12GraphicsCommandList* mCommandList = nullptr;
+	std::vector<D3D12_RESOURCE_BARRIER> mBarriers;
+};
+
+// Submits tracked command lists to commandQueue. The first uses of a list are resolved against the
+// global states, the barriers they need are recorded into a small command list executed right before
+// it. Lists have to be submitted through here in the order they should see each other's states.
+class D3D12ResourceStateSubmitter
+{
+public:
+	D3D12ResourceStateSubmitter(ID3D12Device* device, ID3D12CommandQueue* commandQueue);
+	~D3D12ResourceStateSubmitter(); // waits for the submitted barrier lists
+
+	// Closes the command list, every barrier has to be flushed.
+	void ExecuteCommandList(D3D12ResourceStateTracker& stateTracker);
+
+	uint32_t GetBarrierListCount(); // submitted so far
+private:
+	struct SubmittedAllocator
+	{
+		CommandAllocator allocator;
+		UINT64 fenceValue;
+	};
+
+	ID3D12Device* mDevice = nullptr;
+	ID3D12CommandQueue* mCommandQueue = nullptr;
+	D3D12_COMMAND_LIST_TYPE mCommandListType = D3D12_COMMAND_LIST_TYPE_DIRECT;
+
+	std::mutex mMutex; // keeps resolving and executing in the same order
+	std::vector<ResourceBarrierDesc> mResolvedBarriers;
+
+	D3D12ResourceStateTracker mBarrierList;
+	GraphicsCommandList mBarrierCommandList = nullptr;
+	std::deque<SubmittedAllocator> mSubmittedAllocators; // oldest first, reused once their fence passed
+	uint32_t mBarrierListCount = 0;
+
+	Microsoft::WRL::ComPtr<ID3D12Fence> mFence = nullptr;
+	UINT64 mFenceValue = 0;
+};
\ No newline at end of file
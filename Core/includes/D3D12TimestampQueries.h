@@ -0,0 +1,34 @@
+#pragma once
+#include "Stdafx.h"
+#include "Utility.h"
+#include "Profiler.h"
+
+// Timestamp query heap and readback buffer for GpuProfiler, one block of queries per frame slot.
+class D3D12TimestampQueries : public GpuTimestampQueries
+{
+public:
+	D3D12TimestampQueries(ID3D12Device* device, ID3D12CommandQueue* commandQueue,
+		UINT frameSlotCount, UINT timestampCapacity = 256);
+
+	// Queries are recorded into this command list until the next call.
+	void SetCommandList(ID3D12GraphicsCommandList* commandList);
+
+	uint32_t GetTimestampCapacity() override;
+	uint64_t GetTimestampFrequency() override;
+
+	void WriteTimestamp(uint32_t slot, uint32_t index) override;
+	void Resolve(uint32_t slot, uint32_t count) override;
+	void ReadTimestamps(uint32_t slot, uint32_t count, uint64_t* timestamps) override;
+
+	void BeginEvent(const char* name) override;
+	void EndEvent() override;
+private:
+	Microsoft::WRL::ComPtr<ID3D12QueryHeap> mQueryHeap = nullptr;
+	Microsoft::WRL::ComPtr<ID3D12Resource> mReadbackBuffer = nullptr;
+
+	ID3D12GraphicsCommandList* mCommandList = nullptr;
+
+	UINT mFrameSlotCount = 0;
+	UINT mTimestampCapacity = 0;
+	UINT64 mTimestampFrequency = 0;
+};
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include "Stdafx.h"
 #include "Utility.h"
+#include "Camera.h"
 
 class DepthStencil
 {
@@ -13,9 +14,21 @@ public:
 
 	void ResetDepthStencilBuffer();
 
+	// Matches Camera::IsReversedZ, call before CreateDepthStencilBuffer since the clear value and the format are
+	// baked into the resource. Reversed-Z uses a float depth format, with D24 it gains nothing.
+	void SetReversedZ(bool reversedZ);
+	bool IsReversedZ();
+
+	DepthMode GetDepthMode(); // Reversed with reversed-Z, the infinite projection needs the same buffer
+	float GetClearDepth(); // 0 with reversed-Z, 1 otherwise
+	D3D12_COMPARISON_FUNC GetDepthFunc(bool orEqual = false); // LESS or GREATER
+	D3D12_DEPTH_STENCIL_DESC GetDepthStencilDesc(bool orEqual = false);
+
 	ID3D12Resource* GetDepthStencilBuffer();
 	DXGI_FORMAT GetDepthStencilBufferFormat();
 private:
 	Microsoft::WRL::ComPtr<ID3D12Resource> mDepthStencilBuffer = nullptr;
 	DXGI_FORMAT mDepthStencilBufferFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
+
+	bool mReversedZ = false;
 };
\ No newline at end of file
@@ -46,8 +46,9 @@ public:
 
 	virtual void CreateDescriptorHeap(ID3D12Device* device, UINT descriptorCount) override;
 
+	// arraySlice selects the slice of a TEXTURE2DARRAY view.
 	void CreateDepthStencilView(ID3D12Device* device, UINT descriptorSize, DXGI_FORMAT viewFormat,
-		D3D12_DSV_DIMENSION viewDimension, ID3D12Resource* resource);
+		D3D12_DSV_DIMENSION viewDimension, ID3D12Resource* resource, UINT arraySlice = 0);
 };
 
 class CbvSrvUavDescriptor : public Descriptor
@@ -0,0 +1,74 @@
+#pragma once
+#include "CoreTypes.h"
+
+// Reports watched files whose content may have changed since the previous Poll.
+// Paths are reported exactly as they were passed to Watch.
+class FileWatcher
+{
+public:
+	virtual ~FileWatcher() = default;
+
+	virtual void Watch(const std::string& filename) = 0;
+	virtual void Unwatch(const std::string& filename) = 0;
+
+	virtual void Poll(std::vector<std::string>& changedFiles) = 0; // appends, every file at most once
+
+	static std::unique_ptr<FileWatcher> CreateDefault(); // inotify on Linux, polling elsewhere
+};
+
+// Compares modification time and size, works everywhere but costs a stat per file and Poll.
+class PollingFileWatcher : public FileWatcher
+{
+public:
+	void Watch(const std::string& filename) override;
+	void Unwatch(const std::string& filename) override;
+
+	void Poll(std::vector<std::string>& changedFiles) override;
+private:
+	struct FileState
+	{
+		bool exists;
+		int64_t modificationTime; // nanoseconds
+		int64_t size;
+
+		bool operator!=(const FileState& rhs) const
+		{
+			return exists != rhs.exists || modificationTime != rhs.modificationTime || size != rhs.size;
+		}
+	};
+
+	static FileState GetFileState(const std::string& filename);
+private:
+	std::unordered_map<std::string, FileState> mFiles;
+};
+
+#if defined(__linux__)
+// Watches the directories of the files, so editors that save by writing a new file and renaming it
+// over the old one are caught as well. Poll never blocks.
+class InotifyFileWatcher : public FileWatcher
+{
+public:
+	InotifyFileWatcher();
+	~InotifyFileWatcher();
+	InotifyFileWatcher(const InotifyFileWatcher& rhs) = delete;
+	InotifyFileWatcher& operator=(const InotifyFileWatcher& rhs) = delete;
+
+	void Watch(const std::string& filename) override;
+	void Unwatch(const std::string& filename) override;
+
+	void Poll(std::vector<std::string>& changedFiles) override;
+private:
+	struct WatchedDirectory
+	{
+		int watchDescriptor;
+		std::unordered_map<std::string, std::string> files; // name in the directory -> watched path
+	};
+
+	static void SplitPath(const std::string& filename, std::string& directory, std::string& name);
+private:
+	int mFileDescriptor = -1;
+
+	std::unordered_map<std::string, WatchedDirectory> mDirectories;
+	std::unordered_map<int, std::string> mWatchDescriptors;
+};
+#endif
\ No newline at end of file
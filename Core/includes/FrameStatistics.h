@@ -0,0 +1,69 @@
+#pragma once
+#include "CoreTypes.h"
+
+struct FrameTimeSummary
+{
+	float averageMilliseconds = 0.0f;
+	float minMilliseconds = 0.0f;
+	float maxMilliseconds = 0.0f;
+	float p50Milliseconds = 0.0f;
+	float p95Milliseconds = 0.0f;
+	float p99Milliseconds = 0.0f;
+
+	uint32_t sampleCount = 0;
+};
+
+// Rolling frame-time statistics over the last windowSize frames. All storage is fixed size,
+// AddFrame and the queries never allocate.
+class FrameStatistics
+{
+public:
+	static const uint32_t windowSize = 512;
+	static const uint32_t histogramBucketCount = 101;
+
+	FrameStatistics();
+
+	void AddFrame(float deltaTime); // in seconds, usually Timer::DeltaTime
+	void Reset();
+
+	// Percentile in [0, 100] of the frames in the window, in milliseconds.
+	float GetPercentile(float percentile);
+	FrameTimeSummary GetSummary();
+
+	float GetSmoothedFps(); // exponential moving average of the frame time
+	float GetSmoothedFrameTime(); // in milliseconds
+
+	// A hitch is a frame slower than hitchFactor times the smoothed frame time and the budget.
+	void SetHitchThreshold(float hitchFactor, float budgetMilliseconds);
+	uint64_t GetHitchCount();
+	uint64_t GetLastHitchFrame();
+	bool IsLastFrameHitch();
+
+	uint64_t GetFrameCount();
+	uint64_t GetOverBudgetFrameCount();
+
+	// Histogram of the frames in the window, bucket i counts [i, i + 1) ms, the last bucket everything above.
+	const std::array<uint32_t, histogramBucketCount>& GetHistogram();
+private:
+	static uint32_t GetBucket(float milliseconds);
+private:
+	std::array<float, windowSize> mFrameTimes; // milliseconds, ring buffer
+	std::array<float, windowSize> mSortScratch;
+	std::array<uint32_t, histogramBucketCount> mHistogram;
+
+	uint32_t mNextFrame = 0;
+	uint32_t mSampleCount = 0;
+	double mWindowSum = 0.0;
+
+	float mSmoothedFrameTime = 0.0f;
+	float mSmoothingFactor = 0.1f;
+
+	float mHitchFactor = 2.0f;
+	float mBudgetMilliseconds = 1000.0f / 60.0f;
+
+	uint64_t mFrameCount = 0;
+	uint64_t mOverBudgetFrameCount = 0;
+	uint64_t mHitchCount = 0;
+	uint64_t mLastHitchFrame = 0;
+	bool mLastFrameHitch = false;
+};
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+#include "Stdafx.h"
+#include "GeometryUploader.h"
+#include "TlsfAllocator.h"
+#include "Utility.h"
+
+// Where a mesh lives in the pool, in vertices and indices. Indices are relative to baseVertex.
+struct GeometryRange
+{
+	UINT baseVertex;
+	UINT vertexCount;
+	UINT startIndex;
+	UINT indexCount;
+};
+
+struct GeometryPoolStatistics
+{
+	uint32_t meshCount = 0;
+	uint32_t vertexCount = 0;
+	uint32_t vertexCapacity = 0;
+	uint32_t indexCount = 0;
+	uint32_t indexCapacity = 0;
+
+	float vertexFragmentation = 0.0f; // see TlsfAllocatorStatistics
+	float indexFragmentation = 0.0f;
+	uint32_t defragmentCount = 0;
+};
+
+// One vertex buffer and one index buffer shared by many meshes. Every mesh gets a vertex and an index
+// range from a TlsfAllocator, draws pass its baseVertex and startIndex to DrawIndexedInstanced, so
+// meshes drawn one after another bind the buffers once. Meshes are referenced by handle, their ranges
+// change when the pool is defragmented.
+class GeometryPool
+{
+public:
+	GeometryPool(ID3D12Device* device, UINT vertexCapacity, UINT indexCapacity);
+
+	// Sub-allocates the mesh and uploads it. Throws when no free range is big enough, Defragment joins the
+	// free ranges.
+	uint32_t Add(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, GeometryUploader& uploader);
+	// The ranges are reused by the next Add, the caller makes sure the GPU is done with the mesh.
+	void Remove(uint32_t handle);
+	const GeometryRange& GetRange(uint32_t handle);
+
+	ID3D12Resource* GetVertexBuffer();
+	D3D12_VERTEX_BUFFER_VIEW GetVertexBufferView();
+	ID3D12Resource* GetIndexBuffer();
+	D3D12_INDEX_BUFFER_VIEW GetIndexBufferView();
+
+	// Packs the meshes to the start of new buffers, the copies and the barriers into the vertex and index
+	// buffer states are recorded on commandList. Pending uploads into the pool have to be flushed before
+	// commandList executes, and the old buffers stay alive until ReleaseRetiredBuffers. Returns false and
+	// records nothing when no mesh would move.
+	bool Defragment(ID3D12GraphicsCommandList* commandList);
+	void ReleaseRetiredBuffers(); // once the command list of the last Defragment is done
+
+	GeometryPoolStatistics GetStatistics();
+private:
+	struct Entry
+	{
+		GeometryRange range;
+		bool isLive;
+	};
+
+	void CreateBuffers();
+	// Copies the live ranges of one buffer to the packed places moves describes, neighbouring ranges
+	// that stay neighbours are copied together.
+	void RecordCopies(ID3D12GraphicsCommandList* commandList, ID3D12Resource* destination, ID3D12Resource* source,
+		const std::vector<TlsfMove>& moves, UINT usedSize, UINT stride);
+private:
+	ID3D12Device* mDevice = nullptr;
+
+	TlsfAllocator mVertexAllocator;
+	TlsfAllocator mIndexAllocator;
+
+	Microsoft::WRL::ComPtr<ID3D12Resource> mVertexBuffer = nullptr;
+	Microsoft::WRL::ComPtr<ID3D12Resource> mIndexBuffer = nullptr;
+	std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> mRetiredBuffers;
+
+	std::vector<Entry> mEntries; // by handle
+	std::vector<uint32_t> mFreeHandles;
+
+	uint32_t mDefragmentCount = 0;
+};
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+#include "CoreTypes.h"
+
+// A copy out of the staging memory into a GPU buffer. destination is the backend's buffer, an
+// ID3D12Resource* for D3D12GeometryCopyQueue.
+struct GeometryCopy
+{
+	void* destination;
+	uint64_t destinationOffset;
+	uint64_t stagingOffset;
+	uint64_t byteSize;
+};
+
+// Backend of GeometryUploader: persistently mapped staging memory, a queue that copies out of it and
+// a fence that tells which submissions are done.
+class GeometryCopyQueue
+{
+public:
+	virtual ~GeometryCopyQueue() = default;
+
+	virtual uint64_t GetStagingSize() = 0;
+	virtual uint8_t* GetStagingData() = 0;
+
+	virtual void RecordCopies(const GeometryCopy* copies, uint32_t count) = 0;
+	// Executes the copies recorded since the last Submit, the fence reaches the returned value once they are done.
+	virtual uint64_t Submit() = 0;
+	virtual uint64_t GetCompletedFenceValue() = 0;
+	virtual void WaitForFenceValue(uint64_t fenceValue) = 0;
+};
+
+struct GeometryUploaderStatistics
+{
+	uint64_t uploadedBytes = 0;
+	uint32_t copyCount = 0; // after merging neighbouring copies
+	uint32_t batchCount = 0; // submissions
+	uint32_t stallCount = 0; // waits for the GPU to free staging memory
+
+	uint64_t stagingBytesInUse = 0; // written or in flight
+	uint64_t peakStagingBytes = 0;
+};
+
+// Packs the data of many buffers into one staging ring and copies it to the GPU in batches. The staging
+// memory of a batch is reused once the fence passed it. Uploads bigger than a quarter of the ring are
+// split, so a small ring streams any amount of geometry while the GPU copies the previous parts.
+class GeometryUploader
+{
+public:
+	explicit GeometryUploader(GeometryCopyQueue& copyQueue);
+
+	// data is copied into the ring right away and can be freed on return, the copy into destination is
+	// submitted with the next Flush or earlier when the ring runs full.
+	void Upload(void* destination, uint64_t destinationOffset, const void* data, uint64_t byteSize);
+
+	uint64_t Flush(); // submits the pending copies as one batch, returns the fence value of the latest batch
+	void Retire(); // frees the staging memory of the batches the GPU finished
+	void WaitIdle(); // flushes and waits until every copy is done
+
+	GeometryUploaderStatistics GetStatistics();
+
+	static const uint64_t stagingAlignment = 16;
+private:
+	// Offset of byteSize bytes in the ring, flushes and waits for the GPU while the ring is full.
+	uint64_t Allocate(uint64_t byteSize);
+	bool TryAllocate(uint64_t byteSize, uint64_t& offset);
+private:
+	struct Batch
+	{
+		uint64_t fenceValue;
+		uint64_t end; // the ring's head after the batch
+		uint64_t byteCount; // including the bytes skipped when the ring wrapped
+	};
+
+	GeometryCopyQueue& mCopyQueue;
+	uint64_t mStagingSize = 0;
+	uint8_t* mStagingData = nullptr;
+
+	// The bytes in use run from the tail to the head, around the end of the ring.
+	uint64_t mHead = 0;
+	uint64_t mTail = 0;
+	uint64_t mUsedBytes = 0;
+
+	std::vector<GeometryCopy> mPendingCopies;
+	uint64_t mPendingBytes = 0;
+	std::deque<Batch> mBatches; // submitted, oldest first
+	uint64_t mLastFenceValue = 0;
+
+	GeometryUploaderStatistics mStatistics;
+};
\ No newline at end of file
@@ -0,0 +1,126 @@
+#pragma once
+#include "CoreTypes.h"
+#include "TlsfAllocator.h"
+
+// Mirror the D3D12 heap types the engine places resources in.
+enum class GpuHeapType : int
+{
+	Default = 0,
+	Upload,
+	Readback,
+	Count
+};
+
+// Resources a heap may hold. Resource heap tier 1 hardware can't mix these in one heap, so every class
+// gets its own heaps.
+enum class GpuResourceClass : int
+{
+	Buffer = 0,
+	Texture, // without render target or depth stencil use
+	RenderTargetTexture, // render targets and depth stencil buffers
+	Count
+};
+
+// A range of a heap. heap is the backend's heap, an ID3D12Heap* for D3D12MemoryAllocator.
+struct GpuAllocation
+{
+	void* heap = nullptr;
+	uint64_t offset = 0;
+	uint64_t byteSize = 0; // rounded up to the alignment
+	uint64_t requestedByteSize = 0;
+	GpuHeapType heapType = GpuHeapType::Default;
+	uint32_t pool = 0;
+	uint32_t heapIndex = 0; // in the pool
+	bool isDedicated = false; // the heap holds only this allocation
+
+	bool IsValid() const { return heap != nullptr; }
+};
+
+// Backend of GpuMemoryAllocator: creates and destroys the heaps.
+class GpuHeapFactory
+{
+public:
+	virtual ~GpuHeapFactory() = default;
+
+	virtual void* CreateHeap(GpuHeapType heapType, GpuResourceClass resourceClass, uint64_t byteSize, uint64_t alignment) = 0;
+	virtual void DestroyHeap(void* heap) = 0;
+};
+
+struct GpuHeapTypeStatistics
+{
+	uint32_t heapCount = 0; // including the dedicated heaps
+	uint32_t dedicatedHeapCount = 0;
+	uint32_t allocationCount = 0;
+
+	uint64_t heapBytes = 0; // reserved from the device
+	uint64_t allocatedBytes = 0; // given to allocations, heapBytes - allocatedBytes is free
+	uint64_t requestedBytes = 0; // allocatedBytes - requestedBytes is lost to alignment
+	uint64_t peakHeapBytes = 0;
+	uint64_t budgetBytes = 0;
+	uint32_t budgetFailureCount = 0; // allocations refused because a new heap would exceed the budget
+};
+
+struct GpuMemoryStatistics
+{
+	std::array<GpuHeapTypeStatistics, static_cast<size_t>(GpuHeapType::Count)> heapTypes;
+};
+
+// Sub-allocates placed resources out of big heaps. There is a pool of heaps for every heap type, resource
+// class and placement alignment (4 KB small textures, 64 KB for everything else, 4 MB for MSAA). A pool
+// counts in units of its alignment, so a TlsfAllocator per heap needs no alignment handling of its own.
+// Every heap type has its own heap size, upload and readback heaps are small since few resources live there.
+// Resources bigger than half a heap get a dedicated heap. Heaps are created on demand while they fit in
+// the budget of their heap type, and a pool frees a heap that became empty as long as it has another one.
+// Allocate and Free may be called from any thread.
+class GpuMemoryAllocator
+{
+public:
+	explicit GpuMemoryAllocator(GpuHeapFactory& heapFactory);
+	~GpuMemoryAllocator(); // destroys the remaining heaps, every allocation has to be freed
+
+	// An invalid allocation when the budget doesn't allow another heap. alignment is 4 KB, 64 KB or 4 MB.
+	GpuAllocation Allocate(GpuHeapType heapType, GpuResourceClass resourceClass, uint64_t byteSize, uint64_t alignment);
+	void Free(const GpuAllocation& allocation);
+
+	void SetBudget(GpuHeapType heapType, uint64_t budgetBytes); // unlimited by default
+	// For the heaps created from now on, rounded up to the pool's alignment. 64 MB default heaps, 8 MB upload
+	// heaps and 1 MB readback heaps by default.
+	void SetHeapSize(GpuHeapType heapType, uint64_t heapSize);
+	uint64_t GetHeapSize(GpuHeapType heapType);
+
+	GpuMemoryStatistics GetStatistics();
+
+	static const uint64_t smallAlignment = 4 * 1024;
+	static const uint64_t defaultAlignment = 64 * 1024;
+	static const uint64_t msaaAlignment = 4 * 1024 * 1024;
+	static const uint32_t alignmentClassCount = 3;
+private:
+	struct Heap
+	{
+		void* heap = nullptr; // nullptr for a slot of a destroyed heap
+		uint64_t byteSize = 0;
+		TlsfAllocator allocator;
+	};
+
+	struct Pool
+	{
+		GpuHeapType heapType;
+		GpuResourceClass resourceClass;
+		uint64_t alignment;
+		std::vector<Heap> heaps;
+		uint32_t liveHeapCount = 0;
+	};
+
+	static uint32_t GetAlignmentClass(uint64_t alignment);
+	bool FitsBudget(GpuHeapType heapType, uint64_t byteSize); // counts a budget failure when it doesn't
+	void AddHeapBytes(GpuHeapType heapType, uint64_t byteSize);
+	void ReleaseHeapBytes(GpuHeapType heapType, uint64_t byteSize);
+	GpuHeapTypeStatistics& GetHeapTypeStatistics(GpuHeapType heapType);
+private:
+	GpuHeapFactory& mHeapFactory;
+	std::array<uint64_t, static_cast<size_t>(GpuHeapType::Count)> mHeapSizes;
+
+	std::mutex mMutex;
+	std::vector<Pool> mPools;
+	GpuMemoryStatistics mStatistics;
+};
\ No newline at end of file
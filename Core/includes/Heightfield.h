@@ -0,0 +1,103 @@
+#pragma once
+#include "CoreTypes.h"
+#include "JobSystem.h"
+
+struct HeightfieldStatistics
+{
+	uint32_t tileCount = 0;
+	uint32_t levelCount = 0; // of the min/max hierarchy
+	size_t memoryBytes = 0; // samples and hierarchy
+
+	double buildMilliseconds = 0.0;
+};
+
+// CPU copy of a heightmap for gameplay queries: the height and normal under a point, batches of them,
+// and rays against the terrain. Heights are quantized to 16 bits between the map's min and max height
+// and stored in tiles of tileSize * tileSize samples with Morton order inside of a tile, so the four
+// samples of a bilinear lookup are almost always in the same 128 bytes. Every tile of cells keeps its
+// min/max height in a pyramid that rays walk front to back, skipping tiles they pass above or below.
+// Sample (x, y) is at world x = (x - (width - 1) / 2) * sampleSpacing and z = (y - (height - 1) / 2) *
+// sampleSpacing like the terrain meshes, the surface between samples is bilinear like the GPU's filtering.
+class Heightfield
+{
+public:
+	static const uint32_t tileSize = 8;
+	static const uint32_t maxLevelCount = 16;
+
+	explicit Heightfield(JobSystem& jobSystem = JobSystem::GetDefault());
+
+	// width * height world heights in rows, at least 2 * 2.
+	void Build(const float* heights, uint32_t width, uint32_t height, float sampleSpacing = 1.0f);
+	// 8 bit heightmap as stbi_load returns it, the height is the first channel / 255 * heightScale + heightOffset.
+	void Build(const unsigned char* heightValues, int width, int height, int nChannels,
+		float heightScale = 64.0f, float heightOffset = -16.0f, float sampleSpacing = 1.0f);
+
+	bool IsEmpty();
+	uint32_t GetWidth();
+	uint32_t GetHeight();
+	float GetSampleSpacing();
+	DirectX::BoundingBox GetBounds();
+
+	float GetSample(uint32_t x, uint32_t y); // dequantized height of a sample
+
+	// Points outside of the map are clamped to its edge.
+	float GetHeight(float x, float z);
+	DirectX::XMFLOAT3 GetNormal(float x, float z);
+	float GetHeightAndNormal(float x, float z, DirectX::XMFLOAT3& normal);
+
+	// count points (x, z), four at a time with SIMD.
+	void GetHeights(const DirectX::XMFLOAT2* points, uint32_t count, float* heights);
+	void GetNormals(const DirectX::XMFLOAT2* points, uint32_t count, DirectX::XMFLOAT3* normals);
+
+	// Nearest hit within maxDistance of the ray with the surface above the map, distance is in units of
+	// direction, which needn't be normalized. A ray that starts below the surface hits where it enters the map.
+	bool Intersects(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction, float maxDistance,
+		float& distance);
+
+	HeightfieldStatistics GetStatistics(); // of the last Build
+
+	static const uint32_t rowsPerJob = 16;
+private:
+	struct Level
+	{
+		uint32_t tileCountX = 0;
+		uint32_t tileCountY = 0;
+		std::vector<DirectX::XMFLOAT2> heightRanges; // min and max height per tile of cells
+	};
+
+	// A bilinear cell, q00 at the smaller sample coordinates, u and v are inside of it. The corners are
+	// still quantized, the result of the interpolation is scaled once.
+	struct CellSample
+	{
+		float q00, q10, q01, q11;
+		float u, v;
+	};
+
+	uint32_t GetSampleIndex(uint32_t x, uint32_t y);
+	void GetCellSample(float x, float z, CellSample& cell);
+	void BuildTileRows(const float* heights, uint32_t begin, uint32_t end);
+	void BuildLevels();
+
+	void GetTileBox(uint32_t level, uint32_t x, uint32_t y, DirectX::XMFLOAT3& boxMin, DirectX::XMFLOAT3& boxMax);
+	// Walks the cells of a tile of level 0 the ray crosses in [enter, exit].
+	bool IntersectTile(uint32_t x, uint32_t y, const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction,
+		float enter, float exit, float& distance);
+	bool IntersectCell(uint32_t x, uint32_t y, const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction,
+		float enter, float exit, float& distance);
+private:
+	JobSystem& mJobSystem;
+
+	uint32_t mWidth = 0;
+	uint32_t mHeight = 0;
+	float mSampleSpacing = 1.0f;
+	float mMinHeight = 0.0f;
+	float mMaxHeight = 0.0f;
+	float mQuantizationStep = 0.0f; // world height of a 16 bit step
+
+	uint32_t mTileCountX = 0; // sample tiles
+	std::vector<uint16_t> mSamples;
+
+	std::vector<Level> mLevels;
+
+	HeightfieldStatistics mStatistics;
+};
\ No newline at end of file
@@ -0,0 +1,100 @@
+#pragma once
+#include "CoreTypes.h"
+#include "JobSystem.h"
+
+// RGBA32F image used by the CPU filters.
+class Image
+{
+public:
+	Image() = default;
+	Image(uint32_t width, uint32_t height);
+
+	void Resize(uint32_t width, uint32_t height);
+
+	// 8-bit RGBA data (DXGI_FORMAT_R8G8B8A8_UNORM), e.g. a read back texture with a padded row pitch.
+	void LoadRGBA8(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t rowPitch);
+	void StoreRGBA8(uint8_t* pixels, uint32_t rowPitch) const;
+
+	uint32_t GetWidth() const;
+	uint32_t GetHeight() const;
+
+	DirectX::XMFLOAT4A* GetRow(uint32_t y);
+	const DirectX::XMFLOAT4A* GetRow(uint32_t y) const;
+private:
+	uint32_t mWidth = 0;
+	uint32_t mHeight = 0;
+
+	std::vector<DirectX::XMFLOAT4A> mPixels;
+};
+
+// Normalized Gaussian weights, computed once per sigma and shared by the GPU and CPU blur.
+class GaussWeightCache
+{
+public:
+	static const std::vector<float>& GetWeights(float sigma);
+
+	static std::vector<float> CalculateWeights(float sigma);
+};
+
+struct FilterStatistics
+{
+	double milliseconds = 0.0;
+	double megapixelsPerSecond = 0.0;
+};
+
+// CPU reference of BlurFilter: separable Gaussian with clamp-to-edge addressing,
+// horizontal then vertical pass, repeated blurCount times.
+class CpuBlurFilter
+{
+public:
+	explicit CpuBlurFilter(JobSystem& jobSystem = JobSystem::GetDefault());
+
+	void Execute(const Image& input, Image& output, float sigma, int blurCount);
+
+	FilterStatistics GetStatistics();
+private:
+	void HorizontalPass(const Image& source, Image& destination, const std::vector<float>& weights);
+	void VerticalPass(const Image& source, Image& destination, const std::vector<float>& weights);
+private:
+	JobSystem& mJobSystem;
+
+	Image mIntermediate;
+	FilterStatistics mStatistics;
+};
+
+// CPU reference of SobelFilter: 3x3 Sobel on every channel, out-of-bounds texels read as zero,
+// output is 1 - saturate(luminance(|G|)).
+class CpuSobelFilter
+{
+public:
+	explicit CpuSobelFilter(JobSystem& jobSystem = JobSystem::GetDefault());
+
+	void Execute(const Image& input, Image& output);
+
+	FilterStatistics GetStatistics();
+private:
+	JobSystem& mJobSystem;
+
+	FilterStatistics mStatistics;
+};
+
+struct FilterBenchmarkResult
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+	float sigma = 0.0f;
+	int blurRadius = 0;
+
+	double blurMegapixelsPerSecond = 0.0;
+	double sobelMegapixelsPerSecond = 0.0;
+};
+
+class FilterBenchmark
+{
+public:
+	// Runs one blur pass and one sobel pass per iteration for every resolution/sigma pair.
+	static std::vector<FilterBenchmarkResult> Run(
+		const std::vector<std::pair<uint32_t, uint32_t>>& resolutions,
+		const std::vector<float>& sigmas,
+		int iterations);
+};
\ No newline at end of file
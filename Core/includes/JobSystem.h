@@ -0,0 +1,38 @@
+#pragma once
+#include "CoreTypes.h"
+
+// Persistent worker pool shared by the CPU-side systems (image filters, culling, etc).
+// The calling thread always takes part in ParallelFor, so nested calls can't deadlock.
+class JobSystem
+{
+public:
+	explicit JobSystem(uint32_t workerCount = 0); // 0 means hardware_concurrency - 1
+	~JobSystem();
+	JobSystem(const JobSystem& rhs) = delete;
+	JobSystem& operator=(const JobSystem& rhs) = delete;
+
+	void Execute(std::function<void()> job);
+	void Wait(); // Wait until every job passed to Execute has finished.
+
+	// Split [0, count) into chunks of grainSize and run job(begin, end) on every chunk.
+	void ParallelFor(uint32_t count, uint32_t grainSize,
+		const std::function<void(uint32_t, uint32_t)>& job);
+
+	uint32_t GetWorkerCount();
+	uint32_t GetThreadCount(); // workers + calling thread
+
+	static JobSystem& GetDefault();
+private:
+	void WorkerLoop();
+	bool RunPendingJob();
+private:
+	std::vector<std::thread> mWorkers;
+
+	std::deque<std::function<void()>> mJobs;
+	std::mutex mJobMutex;
+	std::condition_variable mJobAvailable;
+	std::condition_variable mJobsFinished;
+
+	uint32_t mPendingJobCount = 0;
+	bool mShutdown = false;
+};
\ No newline at end of file
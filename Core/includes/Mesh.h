@@ -1,5 +1,7 @@
 #pragma once
 #include "Stdafx.h"
+#include "GeometryPool.h"
+#include "GeometryUploader.h"
 #include "Utility.h"
 
 class Mesh
@@ -8,8 +10,16 @@ public:
 	Mesh() = default;
 	Mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, 
 		D3D_PRIMITIVE_TOPOLOGY primitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	Mesh(const MeshData& meshData); // implicit, so BasicGeometryGenerator results convert directly
 
 	void ConfigureMesh(ID3D12Device* device, ID3D12GraphicsCommandList* commandList);
+	// The data goes through the uploader's staging ring, the buffers are usable once its copies are done.
+	void ConfigureMesh(ID3D12Device* device, GeometryUploader& uploader);
+	// The mesh gets ranges of the pool's buffers instead of its own, copies of the mesh share them. The pool
+	// outlives the mesh, removing the mesh from it is up to the owner.
+	void ConfigureMesh(GeometryPool& pool, GeometryUploader& uploader);
+	// Frees the vertices and indices after ConfigureMesh, GetVertices and GetIndices are empty afterwards.
+	void ReleaseCpuData();
 
 	ID3D12Resource* GetVertexBuffer();
 	D3D12_VERTEX_BUFFER_VIEW GetVertexBufferView();
@@ -17,6 +27,12 @@ public:
 	ID3D12Resource* GetIndexBuffer();
 	D3D12_INDEX_BUFFER_VIEW GetIndexBufferView();
 	UINT GetIndexCount();
+	// Arguments of DrawIndexedInstanced, 0 unless the mesh is in a GeometryPool.
+	UINT GetStartIndexLocation();
+	INT GetBaseVertexLocation();
+
+	const std::vector<Vertex>& GetVertices();
+	const std::vector<uint32_t>& GetIndices();
 
 	D3D_PRIMITIVE_TOPOLOGY GetPrimitiveType();
 
@@ -25,6 +41,7 @@ public:
 private:
 	void CreateVertexBuffer(ID3D12Device* device, ID3D12GraphicsCommandList* commandList);
 	void CreateIndexBuffer(ID3D12Device* device, ID3D12GraphicsCommandList* commandList);
+	void CreateBufferViews();
 
 	void CreateBoundingBox();
 	void CreateBoundingSphere();
@@ -34,6 +51,7 @@ private:
 
 	std::vector<uint32_t> mIndices;
 	UINT indexByteSize = 0;
+	UINT mIndexCount = 0;
 	DXGI_FORMAT indexFormat = DXGI_FORMAT_R32_UINT;
 
 	D3D_PRIMITIVE_TOPOLOGY mPrimitiveType;
@@ -46,6 +64,9 @@ private:
 	Microsoft::WRL::ComPtr<ID3D12Resource> mIndexBufferUpload = nullptr;
 	D3D12_INDEX_BUFFER_VIEW mIndexBufferView{};
 
+	GeometryPool* mGeometryPool = nullptr;
+	uint32_t mGeometryHandle = 0;
+
 	DirectX::XMFLOAT3 mVertexMin{ 0.0f, 0.0f, 0.0f };
 	DirectX::XMFLOAT3 mVertexMax{ 0.0f, 0.0f, 0.0f };
 	DirectX::BoundingBox mBoundingBox;
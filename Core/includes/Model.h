@@ -3,6 +3,7 @@
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 #include "Stdafx.h"
+#include "TransformHierarchy.h"
 
 class Mesh;
 class Texture;
@@ -17,12 +18,20 @@ public:
 
 	std::vector<Mesh> GetMeshes();
 	std::vector<Texture> GetRawTextures();
+
+	// Node transforms of the file, world matrices are up to date after LoadModel.
+	TransformHierarchy& GetHierarchy();
+	uint32_t GetMeshNode(uint32_t meshIndex); // node that references mesh meshIndex
+	DirectX::XMFLOAT4X4 GetMeshWorld(uint32_t meshIndex);
 private:
-	void ProcessNode(aiNode* node, const aiScene* scene);
+	void ProcessNode(aiNode* node, const aiScene* scene, uint32_t parentNode);
 	Mesh ProcessMesh(aiMesh* mesh, const aiScene* scene);
 
 	void LoadTexture(aiMaterial* mat, aiTextureType textureType);
 private:
 	std::vector<Mesh> mMeshes; // Meshes that configure model.
 	std::vector<Texture> mRawTextures; // Textures that don't create DirectX resource yet.
+
+	TransformHierarchy mHierarchy;
+	std::vector<uint32_t> mMeshNodes; // parallel to mMeshes
 };
\ No newline at end of file
@@ -0,0 +1,92 @@
+#pragma once
+#include "CoreTypes.h"
+#include "JobSystem.h"
+
+struct OcclusionCullerStatistics
+{
+	uint32_t occluderCount = 0;
+	uint32_t occluderTriangleCount = 0;
+	uint32_t rasterizedTriangleCount = 0; // after clipping and culling against the screen
+
+	uint32_t testedCount = 0;
+	uint32_t culledCount = 0;
+	float culledPercentage = 0.0f;
+
+	double rasterMilliseconds = 0.0; // occluder transform, rasterization and hierarchy build
+	double testMilliseconds = 0.0;
+};
+
+// CPU occlusion culling against a low resolution depth buffer. A few simple occluder meshes
+// (coarse versions of the scene geometry) are rasterized every frame, then a hierarchy of
+// farthest depths is built on top so that a bounding box is tested against a handful of texels.
+// Boxes are conservatively visible when they cross the near plane.
+// Rows are rasterized in parallel bands, four pixels at a time.
+class OcclusionCuller
+{
+public:
+	OcclusionCuller(uint32_t width = 256, uint32_t height = 128, JobSystem& jobSystem = JobSystem::GetDefault());
+
+	void Resize(uint32_t width, uint32_t height); // width is rounded up to a multiple of 4
+
+	// Occluders stay until ClearOccluders. Triangle lists only, both faces occlude.
+	uint32_t AddOccluder(const MeshData& meshData, const DirectX::XMFLOAT4X4& world);
+	void SetOccluderWorld(uint32_t occluder, const DirectX::XMFLOAT4X4& world);
+	void ClearOccluders();
+
+	// viewProj is not transposed, the depth range is [0, 1] with 0 at the near plane.
+	void RenderOccluders(const DirectX::XMFLOAT4X4& viewProj);
+
+	// Against the last RenderOccluders. Boxes outside the screen aren't visible.
+	bool IsVisible(const DirectX::BoundingBox& worldBounds);
+	// visible[i] is set to 1 or 0, split across the job system. Returns the visible count.
+	uint32_t TestVisibility(const DirectX::BoundingBox* worldBounds, uint32_t count, uint8_t* visible);
+
+	uint32_t GetWidth();
+	uint32_t GetHeight();
+	uint32_t GetLevelCount();
+	const std::vector<float>& GetDepthLevel(uint32_t level); // level 0 is the full resolution
+
+	OcclusionCullerStatistics GetStatistics(); // of the last frame
+
+	static const uint32_t bandHeight = 8;
+	static const uint32_t testsPerJob = 64;
+private:
+	struct Occluder
+	{
+		std::vector<DirectX::XMFLOAT3> positions;
+		std::vector<uint32_t> indices;
+		DirectX::XMFLOAT4X4 world;
+	};
+
+	// Screen space triangle with counterclockwise winding and a depth plane.
+	struct ScreenTriangle
+	{
+		float x[3];
+		float y[3];
+		float depthX, depthY, depthOffset; // depth = depthX * x + depthY * y + depthOffset
+		uint32_t minY, maxY; // pixels, inclusive
+	};
+
+	void SetupTriangle(const DirectX::XMFLOAT4* clipVertices);
+	void EmitTriangle(DirectX::FXMVECTOR v0, DirectX::FXMVECTOR v1, DirectX::FXMVECTOR v2);
+	void RasterizeBand(uint32_t band);
+	void BuildLevels();
+private:
+	JobSystem& mJobSystem;
+
+	uint32_t mWidth = 0;
+	uint32_t mHeight = 0;
+
+	DirectX::XMFLOAT4X4 mViewProj;
+
+	std::vector<Occluder> mOccluders;
+	std::vector<DirectX::XMFLOAT4> mClipVertices;
+	std::vector<ScreenTriangle> mTriangles;
+
+	// Farthest depth per texel, mLevels[0] is the rasterized depth buffer.
+	std::vector<std::vector<float>> mLevels;
+	std::vector<uint32_t> mLevelWidths;
+	std::vector<uint32_t> mLevelHeights;
+
+	OcclusionCullerStatistics mStatistics;
+};
\ No newline at end of file
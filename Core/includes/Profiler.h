@@ -0,0 +1,263 @@
+#pragma once
+#include "CoreTypes.h"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#if defined(USE_PIX)
+#include <pix3.h>
+#endif
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) CpuProfileScope PROFILE_CONCAT(cpuProfileScope, __LINE__)(name)
+
+// Names are stored by pointer, so they have to outlive the profiler (string literals).
+struct ProfileEvent
+{
+	const char* name;
+	uint64_t begin; // ticks, see Profiler::Now
+	uint64_t end;
+	uint32_t depth;
+	uint32_t threadIndex;
+};
+
+struct ProfileNode
+{
+	const char* name;
+	int parent; // -1 for the outermost scopes of a thread
+	uint32_t depth;
+	uint32_t threadIndex;
+	uint32_t callCount;
+	double totalMilliseconds;
+	double selfMilliseconds;
+};
+
+struct ProfileFrame
+{
+	uint64_t frameNumber = 0;
+	uint64_t begin = 0;
+	uint64_t end = 0;
+
+	std::vector<ProfileEvent> cpuEvents;
+	std::vector<ProfileEvent> gpuEvents; // already converted to CPU ticks by GpuProfiler
+	std::vector<ProfileNode> nodes; // scopes merged by call path, parents before children
+
+	uint32_t droppedEventCount = 0;
+};
+
+class Profiler
+{
+public:
+	static Profiler& Get()
+	{
+		static Profiler profiler;
+		return profiler;
+	}
+
+	// rdtsc where available, otherwise steady_clock nanoseconds.
+	static uint64_t Now()
+	{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#else
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+	}
+
+	double GetTicksPerSecond();
+	double TicksToMilliseconds(uint64_t ticks);
+	double TicksToMicroseconds(uint64_t ticks);
+
+	void SetEnabled(bool enabled);
+	bool IsEnabled()
+	{
+		return mEnabled.load(std::memory_order_relaxed);
+	}
+
+	void SetThreadName(const std::string& name); // names the calling thread in the trace
+
+	// Called by the thread that drives the frame. EndFrame drains every thread's ring buffer.
+	void BeginFrame();
+	void EndFrame();
+
+	const ProfileFrame& GetLastFrame();
+	uint64_t GetFrameNumber();
+
+	void AddGpuEvents(const std::vector<ProfileEvent>& events);
+
+	// Writes the last captured frames in the Chrome trace event format (chrome://tracing, Perfetto).
+	bool ExportChromeTrace(const std::string& filename);
+
+	void Record(const char* name, uint64_t begin, uint64_t end, uint32_t depth)
+	{
+		ThreadBuffer* buffer = sThreadBuffer != nullptr ? sThreadBuffer : GetThreadBuffer();
+
+		// The consumer's tail is only loaded again once the ring looks full.
+		uint32_t head = buffer->head.load(std::memory_order_relaxed);
+		if (head - buffer->cachedTail == ringCapacity)
+		{
+			buffer->cachedTail = buffer->tail.load(std::memory_order_acquire);
+			if (head - buffer->cachedTail == ringCapacity)
+			{
+				buffer->droppedEventCount.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+		}
+
+		buffer->events[head & (ringCapacity - 1)] = { name, begin, end, depth, buffer->threadIndex };
+		buffer->head.store(head + 1, std::memory_order_release);
+	}
+
+	static const uint32_t ringCapacity = 1 << 14; // events per thread and frame
+	static const uint32_t maxCapturedFrameCount = 120;
+	static const uint32_t gpuThreadIndex = 0xffffffff;
+private:
+	Profiler();
+
+	// Single producer (the owning thread), single consumer (EndFrame).
+	struct ThreadBuffer
+	{
+		std::unique_ptr<ProfileEvent[]> events{ new ProfileEvent[ringCapacity] };
+		std::atomic<uint32_t> head{ 0 };
+		std::atomic<uint32_t> tail{ 0 };
+		std::atomic<uint32_t> droppedEventCount{ 0 };
+		uint32_t cachedTail = 0; // producer's copy of tail
+
+		uint32_t threadIndex = 0;
+		std::string name;
+	};
+
+	ThreadBuffer* GetThreadBuffer();
+	void Calibrate();
+	void BuildNodes(ProfileFrame& frame);
+private:
+	static thread_local ThreadBuffer* sThreadBuffer;
+
+	std::atomic<bool> mEnabled{ true };
+
+	std::mutex mThreadMutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> mThreadBuffers;
+
+	uint64_t mStartTicks = 0;
+	std::chrono::steady_clock::time_point mStartTime;
+	double mTicksPerSecond = 1.0e9;
+
+	uint64_t mFrameNumber = 0;
+	ProfileFrame mCurrentFrame;
+	std::deque<ProfileFrame> mCapturedFrames;
+	ProfileFrame mEmptyFrame;
+};
+
+class CpuProfileScope
+{
+public:
+	explicit CpuProfileScope(const char* name)
+		: mProfiler(Profiler::Get()), mName(name), mActive(mProfiler.IsEnabled())
+	{
+		if (mActive)
+		{
+#if defined(USE_PIX)
+			PIXBeginEvent(PIX_COLOR_DEFAULT, name);
+#endif
+			mDepth = sDepth++;
+			mBegin = Profiler::Now();
+		}
+	}
+	~CpuProfileScope()
+	{
+		if (mActive)
+		{
+			uint64_t end = Profiler::Now();
+			sDepth--;
+			mProfiler.Record(mName, mBegin, end, mDepth);
+#if defined(USE_PIX)
+			PIXEndEvent();
+#endif
+		}
+	}
+	CpuProfileScope(const CpuProfileScope& rhs) = delete;
+	CpuProfileScope& operator=(const CpuProfileScope& rhs) = delete;
+private:
+	Profiler& mProfiler;
+	const char* mName;
+	uint64_t mBegin = 0;
+	uint32_t mDepth = 0;
+	bool mActive;
+
+	static thread_local uint32_t sDepth;
+};
+
+// Backend of GpuProfiler. Timestamps are grouped in frame slots, one per frame in flight,
+// and a slot is only read back after the GPU finished the frame that last used it.
+class GpuTimestampQueries
+{
+public:
+	virtual ~GpuTimestampQueries() = default;
+
+	virtual uint32_t GetTimestampCapacity() = 0; // per slot
+	virtual uint64_t GetTimestampFrequency() = 0; // ticks per second
+
+	virtual void WriteTimestamp(uint32_t slot, uint32_t index) = 0;
+	virtual void Resolve(uint32_t slot, uint32_t count) = 0;
+	virtual void ReadTimestamps(uint32_t slot, uint32_t count, uint64_t* timestamps) = 0;
+
+	virtual void BeginEvent(const char* name) { }
+	virtual void EndEvent() { }
+};
+
+// GPU scopes are placed on the CPU timeline relative to the CPU begin of the frame that recorded them,
+// and reach Profiler once their slot is reused (frame latency later).
+class GpuProfiler
+{
+public:
+	GpuProfiler(GpuTimestampQueries& queries, uint32_t frameLatency);
+
+	void BeginFrame(uint32_t frameSlot); // the previous frame recorded in frameSlot must be finished
+	void EndFrame();
+
+	void BeginScope(const char* name);
+	void EndScope();
+
+	const std::vector<ProfileEvent>& GetLastResolvedEvents();
+private:
+	void ReadSlot(uint32_t frameSlot);
+private:
+	struct FrameSlot
+	{
+		std::vector<const char*> names;
+		std::vector<uint32_t> depths;
+		uint32_t timestampCount = 0;
+		uint64_t cpuBegin = 0;
+		bool pending = false;
+	};
+
+	GpuTimestampQueries& mQueries;
+
+	std::vector<FrameSlot> mFrameSlots;
+	uint32_t mCurrentSlot = 0;
+	std::vector<int> mScopeStack; // scope index, -1 if the scope didn't fit in the slot
+
+	std::vector<uint64_t> mTimestamps;
+	std::vector<ProfileEvent> mLastResolvedEvents;
+};
+
+class GpuProfileScope
+{
+public:
+	GpuProfileScope(GpuProfiler& profiler, const char* name)
+		: mProfiler(profiler)
+	{
+		mProfiler.BeginScope(name);
+	}
+	~GpuProfileScope()
+	{
+		mProfiler.EndScope();
+	}
+	GpuProfileScope(const GpuProfileScope& rhs) = delete;
+	GpuProfileScope& operator=(const GpuProfileScope& rhs) = delete;
+private:
+	GpuProfiler& mProfiler;
+};
\ No newline at end of file
@@ -0,0 +1,174 @@
+#pragma once
+#include "CoreTypes.h"
+
+// Resource states a pass can ask for, the backend translates them. Read states can be combined.
+enum class RenderGraphState : uint32_t
+{
+	Common = 0, // also the present state
+	RenderTarget = 1 << 0,
+	DepthWrite = 1 << 1,
+	DepthRead = 1 << 2,
+	ShaderResource = 1 << 3, // pixel and non-pixel shaders
+	UnorderedAccess = 1 << 4,
+	CopySource = 1 << 5,
+	CopyDest = 1 << 6
+};
+
+inline RenderGraphState operator|(RenderGraphState a, RenderGraphState b)
+{
+	return static_cast<RenderGraphState>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b));
+}
+
+enum class RenderGraphBarrierType : int
+{
+	Transition = 0,
+	Aliasing, // resource takes over memory another transient used before, after is its first state
+	UnorderedAccess // between two passes using the same resource as a UAV, at least one of them writing
+};
+
+struct RenderGraphBarrier
+{
+	RenderGraphBarrierType type;
+	uint32_t resource;
+	RenderGraphState before;
+	RenderGraphState after;
+};
+
+// Records the barriers of a compiled graph, the passes record their own work.
+class RenderGraphBackend
+{
+public:
+	virtual ~RenderGraphBackend() = default;
+
+	// All barriers due before one pass, to be submitted together.
+	virtual void RecordBarriers(const RenderGraphBarrier* barriers, uint32_t count) = 0;
+};
+
+struct RenderGraphStatistics
+{
+	uint32_t passCount = 0;
+	uint32_t culledPassCount = 0;
+	uint32_t barrierCount = 0;
+	uint32_t barrierBatchCount = 0; // RecordBarriers calls per Execute
+
+	uint32_t transientCount = 0;
+	uint64_t transientBytes = 0; // if every transient had its own memory
+	uint64_t heapBytes = 0; // with aliasing
+	uint64_t savedBytes = 0;
+};
+
+// Frame graph: passes declare which resources they read and write in which state, Compile works out
+// the rest. Passes that contribute nothing to an imported resource or a pass with side effects are
+// culled. Consecutive reads of a resource share one transition into the combined read state, and the
+// barriers due before a pass go to the backend in one batch. Transient resources get placed in shared
+// heaps where resources whose lifetimes don't overlap alias the same memory. Passes run in the order
+// they were added. Names are stored by pointer, so they have to outlive the graph (string literals).
+class RenderGraph
+{
+public:
+	static const uint32_t invalidIndex = 0xffffffff;
+
+	void Reset(); // removes every pass and resource
+
+	// Lives outside the graph, in initialState at the start of Execute and returned to finalState at its end.
+	uint32_t ImportResource(const char* name, RenderGraphState initialState, RenderGraphState finalState);
+	// Memory owned by the graph. Only transients of the same heap group alias, backends use the groups for
+	// resources that can't share a heap.
+	uint32_t CreateTransient(const char* name, uint64_t byteSize, uint64_t alignment, uint32_t heapGroup = 0);
+
+	uint32_t AddPass(const char* name, std::function<void()> execute);
+	void Read(uint32_t pass, uint32_t resource, RenderGraphState state);
+	void Write(uint32_t pass, uint32_t resource, RenderGraphState state);
+	void SetSideEffects(uint32_t pass); // the pass is never culled
+
+	// Throws when a transient is read before any pass wrote it.
+	void Compile();
+	void Execute(RenderGraphBackend& backend);
+
+	uint32_t GetPassCount();
+	const char* GetPassName(uint32_t pass);
+	bool IsPassCulled(uint32_t pass);
+	// The barriers recorded before the pass, and the ones returning the imported resources at the end.
+	const RenderGraphBarrier* GetPassBarriers(uint32_t pass, uint32_t& count);
+	const RenderGraphBarrier* GetFinalBarriers(uint32_t& count);
+
+	uint32_t GetResourceCount();
+	const char* GetResourceName(uint32_t resource);
+	bool IsTransient(uint32_t resource);
+	bool IsResourceUsed(uint32_t resource); // by a pass that wasn't culled
+	// Where a transient lives. A transient starts every frame in the state its last pass left it in, which
+	// is the state to create it in.
+	uint32_t GetHeapGroup(uint32_t resource);
+	uint64_t GetHeapOffset(uint32_t resource);
+	uint64_t GetByteSize(uint32_t resource);
+	RenderGraphState GetInitialState(uint32_t resource);
+
+	uint32_t GetHeapGroupCount();
+	uint64_t GetHeapSize(uint32_t heapGroup);
+	uint64_t GetHeapAlignment(uint32_t heapGroup);
+
+	RenderGraphStatistics GetStatistics(); // of the last Compile
+private:
+	struct Access
+	{
+		uint32_t resource;
+		RenderGraphState state;
+		bool isRead;
+		bool isWrite;
+	};
+
+	struct Pass
+	{
+		const char* name;
+		std::function<void()> execute;
+		std::vector<Access> accesses;
+		bool hasSideEffects = false;
+		bool isCulled = false;
+
+		uint32_t firstBarrier = 0;
+		uint32_t barrierCount = 0;
+	};
+
+	struct Resource
+	{
+		const char* name;
+		bool isTransient;
+		RenderGraphState initialState;
+		RenderGraphState finalState;
+
+		uint64_t byteSize = 0;
+		uint64_t alignment = 0;
+		uint32_t heapGroup = 0;
+		uint64_t heapOffset = 0;
+		bool isAliased = false; // shares memory with another transient
+
+		uint32_t firstPass = invalidIndex; // lifetime in pass indices, over the passes that weren't culled
+		uint32_t lastPass = invalidIndex;
+	};
+
+	// A run of accesses to one resource that needs a single state: one write, or consecutive reads.
+	struct Use
+	{
+		uint32_t pass; // first pass of the run
+		RenderGraphState state;
+		bool isWrite;
+	};
+
+	void AddAccess(uint32_t pass, uint32_t resource, RenderGraphState state, bool isRead, bool isWrite);
+	void CullPasses();
+	void BuildUses(std::vector<std::vector<Use>>& uses);
+	void PlaceTransients();
+	void BuildBarriers(const std::vector<std::vector<Use>>& uses);
+private:
+	std::vector<Pass> mPasses;
+	std::vector<Resource> mResources;
+
+	std::vector<RenderGraphBarrier> mBarriers; // the passes' barriers one after the other, then the final ones
+	uint32_t mFirstFinalBarrier = 0;
+
+	std::vector<uint64_t> mHeapSizes; // by heap group
+	std::vector<uint64_t> mHeapAlignments;
+
+	bool mIsCompiled = false;
+	RenderGraphStatistics mStatistics;
+};
\ No newline at end of file
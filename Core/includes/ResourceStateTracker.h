@@ -0,0 +1,126 @@
+#pragma once
+#include "CoreTypes.h"
+
+// States are the backend's bit flags (D3D12_RESOURCE_STATES), resources are the backend's objects.
+enum class ResourceBarrierType : int
+{
+	Transition = 0,
+	UnorderedAccess
+};
+
+struct ResourceBarrierDesc
+{
+	ResourceBarrierType type;
+	void* resource;
+	uint32_t before;
+	uint32_t after;
+};
+
+// Receives the barriers of a flush in one call, a command list in the backend.
+class ResourceBarrierSink
+{
+public:
+	virtual ~ResourceBarrierSink() = default;
+
+	virtual void RecordBarriers(const ResourceBarrierDesc* barriers, uint32_t count) = 0;
+};
+
+// What the backend allows without a barrier. A resource in commonState is promoted to the state of its
+// first use in a command list when it is a buffer, or a texture going to one of texturePromotionStates.
+// Buffers, and textures promoted to read states and left there, decay to commonState when the command
+// list finishes. Read states can be combined, a resource in a combination of them needs no barrier
+// for one of them.
+struct ResourceStateRules
+{
+	uint32_t commonState = 0;
+	uint32_t readStates = 0;
+	uint32_t texturePromotionStates = 0;
+};
+
+// The state of every registered resource between command lists, in submission order. Shared by the
+// trackers of all command lists, thread safe.
+class GlobalResourceStates
+{
+public:
+	static GlobalResourceStates& GetDefault();
+
+	// Registering a resource again replaces its state, resources are registered when they are created.
+	void Register(void* resource, uint32_t state, bool isBuffer);
+	void Unregister(void* resource);
+	bool GetState(void* resource, uint32_t& state); // false if the resource isn't registered
+private:
+	friend class ResourceStateTracker;
+
+	struct Entry
+	{
+		uint32_t state;
+		bool isBuffer;
+	};
+
+	std::mutex mMutex;
+	std::unordered_map<void*, Entry> mEntries;
+};
+
+struct ResourceStateTrackerStatistics
+{
+	uint32_t transitionCount = 0; // TransitionResource calls
+	uint32_t redundantCount = 0; // already in the state
+	uint32_t mergedCount = 0; // folded into a barrier that wasn't flushed yet
+	uint32_t barrierCount = 0; // given to the sink
+	uint32_t flushCount = 0; // RecordBarriers calls
+
+	uint32_t firstUseCount = 0;
+	uint32_t resolvedBarrierCount = 0; // first uses that needed a barrier at submission
+	uint32_t promotedCount = 0; // first uses the backend promotes implicitly
+};
+
+// Resource states of one command list. The caller states the state it needs a resource in before using
+// it, the tracker skips the transitions to the state the resource is in and keeps the others pending
+// until FlushResourceBarriers hands them to the sink together. Pending transitions of a resource fold
+// into one, so flush right before the commands that need the states, even after a first use. The
+// state a resource is in when the command list starts isn't known while recording, other command lists
+// may run first. The first use of every resource is kept instead and Resolve compares it with the
+// global state when the list is submitted, returning the barriers that have to run before the list.
+class ResourceStateTracker
+{
+public:
+	explicit ResourceStateTracker(const ResourceStateRules& rules);
+
+	void Reset(); // for a new command list
+
+	void TransitionResource(void* resource, uint32_t state);
+	void UAVBarrier(void* resource); // between two commands writing the resource as UAV
+	void FlushResourceBarriers(ResourceBarrierSink& sink);
+
+	// At submission, in submission order. Every barrier has to be flushed. Appends the barriers the first
+	// uses need and stores the final states of the list as the global states. Resources that aren't
+	// registered are left to the caller.
+	void Resolve(GlobalResourceStates& globalStates, std::vector<ResourceBarrierDesc>& barriers);
+
+	// The state the resource is in at this point of the command list, false before its first use.
+	bool GetState(void* resource, uint32_t& state);
+
+	ResourceStateTrackerStatistics GetStatistics(); // since the last Reset
+private:
+	struct LocalState
+	{
+		uint32_t firstState; // the state the list expects the resource in when it starts
+		uint32_t state;
+		int pendingBarrier = -1; // index of the unflushed transition of the resource
+		bool isFirstUsePending = true; // nothing was flushed since the first use, it can still change
+		bool hasChanged = false; // a barrier after the first use was flushed
+	};
+
+	bool IsInState(uint32_t currentState, uint32_t state);
+private:
+	ResourceStateRules mRules;
+
+	std::unordered_map<void*, LocalState> mStates;
+	std::vector<void*> mFirstUses; // in order of first use
+	std::vector<void*> mUnflushed; // resources with a pending barrier or first use
+
+	std::vector<ResourceBarrierDesc> mPendingBarriers;
+	std::vector<ResourceBarrierDesc> mFlushedBarriers;
+
+	ResourceStateTrackerStatistics mStatistics;
+};
\ No newline at end of file
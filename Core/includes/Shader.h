@@ -1,5 +1,6 @@
 #pragma once
 #include "Stdafx.h"
+#include "ShaderCache.h"
 #include "Utility.h"
 
 class Shader
@@ -11,7 +12,14 @@ public:
 		const std::wstring& filename,
 		const D3D_SHADER_MACRO* defines,
 		const std::string& entrypoint,
-		const std::string& target);
+		const std::string& target,
+		ShaderCache* shaderCache = nullptr); // nullptr always compiles
+	void CompileShader(
+		const std::wstring& filename,
+		const std::vector<ShaderDefine>& defines,
+		const std::string& entrypoint,
+		const std::string& target,
+		ShaderCache* shaderCache = nullptr);
 
 	ID3DBlob* GetShader();
 private:
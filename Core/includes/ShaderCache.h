@@ -0,0 +1,84 @@
+#pragma once
+#include "CoreTypes.h"
+
+struct ShaderDefine
+{
+	std::string name;
+	std::string definition;
+};
+
+// Everything that changes the compiled bytecode.
+struct ShaderCompileDesc
+{
+	std::string filename;
+	std::vector<ShaderDefine> defines;
+	std::string entrypoint;
+	std::string target;
+	uint32_t flags = 0;
+	uint32_t compilerVersion = 0;
+};
+
+struct ShaderCacheStatistics
+{
+	uint32_t hitCount = 0;
+	uint32_t missCount = 0;
+	uint32_t storeCount = 0;
+	uint32_t corruptCount = 0; // blobs whose size or checksum didn't match the index
+};
+
+// Bytecode cache on disk, keyed by the content of the shader and every file it includes
+// (transitively) plus the compile parameters, so editing common.hlsl invalidates every shader using it.
+// Blobs are stored as <key>.bin next to an append only index.txt. Safe to use from several threads.
+class ShaderCache
+{
+public:
+	explicit ShaderCache(const std::string& directory);
+	ShaderCache(const ShaderCache& rhs) = delete;
+	ShaderCache& operator=(const ShaderCache& rhs) = delete;
+
+	// False if the shader file can't be read, the compiler reports that error.
+	bool ComputeKey(const ShaderCompileDesc& desc, uint64_t& key);
+
+	bool Load(uint64_t key, std::vector<uint8_t>& bytecode);
+	void Store(uint64_t key, const void* bytecode, size_t byteSize, const std::string& source);
+
+	// The shader followed by its includes in discovery order. Quoted includes are resolved
+	// relative to the including file like D3D_COMPILE_STANDARD_FILE_INCLUDE, missing ones are skipped.
+	std::vector<std::string> GetIncludeGraph(const std::string& filename);
+
+	// File contents are hashed once per cache lifetime, call this after the sources changed.
+	void InvalidateFiles();
+
+	ShaderCacheStatistics GetStatistics();
+
+	static uint64_t Hash(const void* data, size_t byteSize, uint64_t hash = fnvOffsetBasis); // FNV-1a
+	static std::string NormalizePath(const std::string& path);
+
+	static const uint64_t fnvOffsetBasis = 14695981039346656037ull;
+	static const uint32_t cacheVersion = 1;
+private:
+	struct Entry
+	{
+		uint64_t byteSize;
+		uint64_t checksum;
+	};
+
+	struct FileInfo
+	{
+		bool exists;
+		uint64_t contentHash;
+		std::vector<std::string> includes; // resolved and normalized
+	};
+
+	const FileInfo& GetFileInfo(const std::string& filename); // mMutex must be held
+	void LoadIndex();
+	std::string GetBlobPath(uint64_t key);
+private:
+	std::string mDirectory;
+
+	std::mutex mMutex;
+	std::unordered_map<uint64_t, Entry> mEntries;
+	std::unordered_map<std::string, FileInfo> mFiles;
+
+	ShaderCacheStatistics mStatistics;
+};
\ No newline at end of file
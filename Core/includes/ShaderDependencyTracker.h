@@ -0,0 +1,23 @@
+#pragma once
+#include "CoreTypes.h"
+#include "ShaderCache.h"
+
+// Maps every shader source and include to the groups (e.g. the shaders of one PSO) built from it,
+// so a change to LightingUtility.hlsl only rebuilds the groups that actually include it.
+class ShaderDependencyTracker
+{
+public:
+	explicit ShaderDependencyTracker(ShaderCache& shaderCache);
+
+	// Rediscovers the include graph of the sources, call again after they changed
+	// (and after ShaderCache::InvalidateFiles) to pick up added or removed includes.
+	void SetSources(uint32_t group, const std::vector<std::string>& sources);
+
+	std::vector<uint32_t> GetAffectedGroups(const std::vector<std::string>& changedFiles); // sorted
+	std::vector<std::string> GetFiles(); // every source and include, normalized
+private:
+	ShaderCache& mShaderCache;
+
+	std::unordered_map<uint32_t, std::vector<std::string>> mGroupFiles;
+	std::unordered_map<std::string, std::vector<uint32_t>> mDependentGroups;
+};
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+#include "Stdafx.h"
+#include "FileWatcher.h"
+#include "Shader.h"
+#include "ShaderCache.h"
+#include "ShaderDependencyTracker.h"
+
+struct HotReloadShaderDesc
+{
+	std::wstring filename;
+	std::vector<ShaderDefine> defines;
+	std::string entrypoint;
+	std::string target;
+};
+
+// Watches the sources of registered shader groups and recompiles the affected groups on a background
+// thread. The new shaders are handed to the group's callback from ApplyPendingReloads, which the
+// renderer calls at a frame boundary to rebuild its PSOs. A group that fails to compile keeps its
+// previous shaders, the errors go to the debug output.
+class ShaderHotReloader
+{
+public:
+	using ApplyCallback = std::function<void(std::vector<Shader>& shaders)>;
+
+	ShaderHotReloader(ShaderCache& shaderCache,
+		std::unique_ptr<FileWatcher> fileWatcher = FileWatcher::CreateDefault());
+	~ShaderHotReloader();
+	ShaderHotReloader(const ShaderHotReloader& rhs) = delete;
+	ShaderHotReloader& operator=(const ShaderHotReloader& rhs) = delete;
+
+	// Before Start. The shaders are passed to apply in the order of the descs.
+	void AddGroup(const std::string& name, const std::vector<HotReloadShaderDesc>& shaders, ApplyCallback apply);
+
+	void Start(std::chrono::milliseconds pollInterval = std::chrono::milliseconds(250));
+	void Stop();
+
+	// Main thread, when the GPU no longer uses the PSOs being replaced. Returns the number of groups applied.
+	uint32_t ApplyPendingReloads();
+private:
+	struct Group
+	{
+		std::string name;
+		std::vector<HotReloadShaderDesc> shaders;
+		ApplyCallback apply;
+	};
+
+	struct PendingReload
+	{
+		uint32_t group;
+		std::vector<Shader> shaders;
+	};
+
+	void WatchLoop();
+	void ReloadChangedGroups(const std::vector<std::string>& changedFiles);
+	std::vector<std::string> GetSources(const Group& group);
+	void WatchFiles();
+private:
+	ShaderCache& mShaderCache;
+	std::unique_ptr<FileWatcher> mFileWatcher;
+	ShaderDependencyTracker mDependencyTracker;
+	std::vector<std::string> mWatchedFiles;
+
+	std::vector<Group> mGroups;
+
+	std::thread mThread;
+	std::mutex mMutex;
+	std::condition_variable mStopRequested;
+	bool mStop = false;
+	std::chrono::milliseconds mPollInterval{ 250 };
+
+	std::vector<PendingReload> mPendingReloads; // guarded by mMutex
+};
\ No newline at end of file
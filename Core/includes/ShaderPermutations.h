@@ -0,0 +1,52 @@
+#pragma once
+#include "Stdafx.h"
+#include "Shader.h"
+#include "ShaderCache.h"
+
+// Every combination of the feature defines of one shader file. Bit i of a feature mask turns
+// featureDefines[i] on, each define is passed as 1 or 0. Permutations are compiled on first use
+// and looked up by indexing with the mask, so there is no string building or hashing per lookup.
+class ShaderPermutations
+{
+public:
+	ShaderPermutations(const std::wstring& filename, const std::vector<std::string>& featureDefines,
+		ShaderCache* shaderCache = nullptr);
+	ShaderPermutations(const ShaderPermutations& rhs) = delete;
+	ShaderPermutations& operator=(const ShaderPermutations& rhs) = delete;
+
+	// Add every stage before the permutations are used from several threads.
+	uint32_t AddStage(const std::string& entrypoint, const std::string& target);
+
+	// Thread safe. Throws like Shader::CompileShader if the permutation doesn't compile,
+	// the next call tries again.
+	Shader& GetShader(uint32_t stage, uint32_t featureMask);
+	void Precompile(uint32_t featureMask); // every stage, e.g. from the startup task graph
+
+	uint32_t GetFeatureBit(const std::string& featureDefine); // 0 if the shader doesn't have the feature
+	std::vector<ShaderDefine> GetDefines(uint32_t featureMask);
+	uint32_t GetCompiledCount();
+
+	static const uint32_t maxFeatureCount = 8;
+private:
+	struct Permutation
+	{
+		std::once_flag compiled;
+		Shader shader;
+	};
+
+	struct Stage
+	{
+		std::string entrypoint;
+		std::string target;
+		std::vector<std::unique_ptr<Permutation>> permutations; // indexed by feature mask
+	};
+
+	void Compile(const Stage& stage, uint32_t featureMask, Shader& shader);
+private:
+	std::wstring mFilename;
+	std::vector<std::string> mFeatureDefines;
+	ShaderCache* mShaderCache;
+
+	std::vector<Stage> mStages;
+	std::atomic<uint32_t> mCompiledCount{ 0 };
+};
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+#include "Stdafx.h"
+#include "Descriptor.h"
+#include "Utility.h"
+
+// Depth texture array with a slice per shadow cascade. Every slice is rendered through its own DSV and the
+// whole array is sampled through one Texture2DArray SRV with the comparison sampler (s6 of
+// Texture::GetStaticSamplers). Between frames the array stays in the pixel shader resource state, so slices
+// that aren't rendered again keep their contents.
+class ShadowMap
+{
+public:
+	ShadowMap(ID3D12Device* device, UINT resolution, UINT sliceCount);
+
+	void BuildDescriptors(
+		ID3D12Device* device,
+		CbvSrvUavDescriptor& descriptorBuilder,
+		UINT cbvSrvUavDescriptorSize,
+		UINT dsvDescriptorSize);
+
+	// Transitions the array to depth write and back.
+	void BeginRender(ID3D12GraphicsCommandList* commandList);
+	void EndRender(ID3D12GraphicsCommandList* commandList);
+	// Clears one slice and makes it the only render target, between BeginRender and EndRender.
+	void SetRenderTarget(ID3D12GraphicsCommandList* commandList, UINT slice);
+
+	ID3D12Resource* GetShadowMap();
+	int GetShadowMapSrvDescriptorIndex();
+	CD3DX12_CPU_DESCRIPTOR_HANDLE GetDsv(UINT slice);
+
+	UINT GetResolution();
+	UINT GetSliceCount();
+
+	static const DXGI_FORMAT depthFormat;
+private:
+	void BuildResource(ID3D12Device* device);
+private:
+	Microsoft::WRL::ComPtr<ID3D12Resource> mShadowMap = nullptr;
+	DsvDescriptor mDsvDescriptor;
+
+	UINT mResolution = 0;
+	UINT mSliceCount = 0;
+	UINT mDsvDescriptorSize = 0;
+
+	D3D12_VIEWPORT mViewport;
+	D3D12_RECT mScissorRect;
+
+	int mShadowMapSrvDescriptorIndex = -1;
+};
\ No newline at end of file
@@ -0,0 +1,147 @@
+#pragma once
+#include "CoreTypes.h"
+#include "Camera.h"
+#include "ImageFilter.h"
+#include "JobSystem.h"
+
+enum class RasterCullMode : int
+{
+	None = 0,
+	Front,
+	Back
+};
+
+// Same meaning as NUM_DIR_LIGHTS/NUM_POINT_LIGHTS/NUM_SPOT_LIGHTS in common.hlsl.
+struct RasterLightCount
+{
+	int directionalLightCount = 1;
+	int pointLightCount = 0;
+	int spotLightCount = 0;
+};
+
+struct SoftwareRasterizerStatistics
+{
+	uint32_t drawCount = 0;
+	uint32_t vertexCount = 0;
+	uint32_t triangleCount = 0;
+	uint32_t culledTriangleCount = 0; // outside the frustum, back facing or degenerate
+	uint32_t clippedTriangleCount = 0;
+	uint32_t rasterizedTriangleCount = 0; // after clipping
+	uint32_t binnedTriangleCount = 0; // sum of every tile's bin size
+	uint64_t shadedPixelCount = 0;
+	uint64_t depthRejectedPixelCount = 0;
+
+	double drawMilliseconds = 0.0; // vertex processing, triangle setup and binning
+	double rasterMilliseconds = 0.0;
+};
+
+// CPU backend that consumes the same draw data as the D3D12 renderers and shades it
+// like opaque.hlsl/instancing.hlsl. Tiles are rasterized in parallel but every tile
+// processes its triangles in submission order, so the result doesn't depend on the thread count.
+// Matrices are expected transposed, exactly as they are uploaded to the constant buffers.
+class SoftwareRasterizer
+{
+public:
+	SoftwareRasterizer(uint32_t width, uint32_t height, JobSystem& jobSystem = JobSystem::GetDefault());
+
+	void Resize(uint32_t width, uint32_t height);
+
+	void SetCullMode(RasterCullMode cullMode);
+	// Camera::GetDepthMode of the camera the scene constant comes from, BeginFrame clears the depth buffer to
+	// its far value and the depth test keeps the nearer fragment.
+	void SetDepthMode(DepthMode depthMode);
+	void SetLightCount(const RasterLightCount& lightCount);
+
+	void BeginFrame(const SceneConstant& sceneConstant, const DirectX::XMFLOAT4& clearColor);
+
+	// Triangle lists only. The texture is sampled with a bilinear wrap filter, nullptr means white.
+	void Draw(const MeshData& meshData, const ObjectConstant& objectConstant, const MaterialData& materialData,
+		const Image* diffuseTexture = nullptr);
+	void Draw(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+		const ObjectConstant& objectConstant, const MaterialData& materialData,
+		const Image* diffuseTexture = nullptr);
+
+	void EndFrame();
+
+	const Image& GetColorBuffer();
+	const std::vector<float>& GetDepthBuffer();
+
+	bool SaveColorBuffer(const std::string& filename); // binary PPM
+	uint64_t GetColorBufferHash(); // FNV-1a of the 8-bit color buffer, for golden image tests
+
+	SoftwareRasterizerStatistics GetStatistics();
+
+	static const uint32_t tileSize = 64;
+	static const int subpixelBits = 8;
+private:
+	struct RasterVertex
+	{
+		DirectX::XMFLOAT4 positionH;
+		DirectX::XMFLOAT3 positionW;
+		DirectX::XMFLOAT3 normalW;
+		DirectX::XMFLOAT2 texCoord;
+	};
+
+	struct RasterTriangle
+	{
+		int32_t x[3];
+		int32_t y[3];
+		int32_t minX, minY, maxX, maxY; // pixels, inclusive
+		int64_t area;
+
+		float depth[3];
+		float invW[3];
+		float attributes[3][8]; // positionW, normalW, texCoord, each divided by w
+
+		uint32_t drawIndex;
+	};
+
+	struct DrawData
+	{
+		MaterialData materialData;
+		const Image* diffuseTexture;
+	};
+
+	// Output of one triangle setup job, merged in job order after all jobs finished.
+	struct SetupBatch
+	{
+		std::vector<RasterTriangle> triangles;
+		std::vector<std::vector<uint32_t>> bins;
+
+		uint32_t culledTriangleCount = 0;
+		uint32_t clippedTriangleCount = 0;
+	};
+
+	void SetupTriangle(const RasterVertex* vertices, uint32_t drawIndex, SetupBatch& batch);
+	void EmitTriangle(const RasterVertex& v0, const RasterVertex& v1, const RasterVertex& v2,
+		uint32_t drawIndex, SetupBatch& batch);
+
+	void RasterizeTile(uint32_t tileX, uint32_t tileY,
+		uint64_t& shadedPixelCount, uint64_t& depthRejectedPixelCount);
+	DirectX::XMVECTOR ShadePixel(const DrawData& drawData,
+		DirectX::FXMVECTOR positionW, DirectX::FXMVECTOR normalW, DirectX::FXMVECTOR texCoord);
+private:
+	JobSystem& mJobSystem;
+
+	uint32_t mWidth = 0;
+	uint32_t mHeight = 0;
+	uint32_t mTileCountX = 0;
+	uint32_t mTileCountY = 0;
+
+	RasterCullMode mCullMode = RasterCullMode::Back;
+	DepthMode mDepthMode = DepthMode::Standard;
+	RasterLightCount mLightCount;
+
+	SceneConstant mSceneConstant{};
+	DirectX::XMFLOAT4X4 mViewProj;
+
+	Image mColorBuffer;
+	std::vector<float> mDepthBuffer;
+
+	std::vector<RasterTriangle> mTriangles;
+	std::vector<std::vector<uint32_t>> mBins; // triangle indices per tile, in submission order
+	std::vector<DrawData> mDraws;
+	std::vector<RasterVertex> mVertexCache;
+
+	SoftwareRasterizerStatistics mStatistics;
+};
\ No newline at end of file
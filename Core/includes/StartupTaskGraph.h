@@ -0,0 +1,69 @@
+#pragma once
+#include "CoreTypes.h"
+#include "JobSystem.h"
+
+struct StartupTaskTiming
+{
+	std::string name;
+	double beginMilliseconds = 0.0; // relative to the start of Run
+	double endMilliseconds = 0.0;
+	bool failed = false;
+};
+
+// Dependency graph for the one-off work before the first frame (shader compiles, PSO creation).
+// A task is handed to the job system as soon as the last of its dependencies finished.
+class StartupTaskGraph
+{
+public:
+	using TaskHandle = uint32_t;
+
+	explicit StartupTaskGraph(JobSystem& jobSystem = JobSystem::GetDefault());
+	StartupTaskGraph(const StartupTaskGraph& rhs) = delete;
+	StartupTaskGraph& operator=(const StartupTaskGraph& rhs) = delete;
+
+	// Dependencies must already be in the graph, so it can't contain cycles.
+	TaskHandle AddTask(const std::string& name, std::function<void()> task,
+		const std::vector<TaskHandle>& dependencies = {});
+
+	// Blocks until every task ran, the calling thread helps. If a task throws, the tasks not yet
+	// started are skipped and the first exception is rethrown here.
+	void Run();
+
+	const std::vector<StartupTaskTiming>& GetTimings(); // indexed by TaskHandle
+
+	// The chain of tasks that gated the last one to finish, each step going to the dependency
+	// that finished last. Its length is the startup time no thread count can go below.
+	std::vector<TaskHandle> GetCriticalPath();
+	double GetCriticalPathMilliseconds(); // sum of the task durations on the critical path
+
+	double GetWallMilliseconds();
+	double GetTotalTaskMilliseconds(); // sum of every task duration, the serial cost
+
+	std::string GetTimelineReport();
+private:
+	struct Task
+	{
+		std::string name;
+		std::function<void()> function;
+		std::vector<TaskHandle> dependencies;
+		std::vector<TaskHandle> dependents;
+		std::atomic<uint32_t> remainingDependencyCount{ 0 };
+	};
+
+	void Schedule(TaskHandle handle);
+	void RunTask(TaskHandle handle);
+private:
+	using Clock = std::chrono::steady_clock;
+
+	JobSystem& mJobSystem;
+
+	std::vector<std::unique_ptr<Task>> mTasks;
+	std::vector<StartupTaskTiming> mTimings;
+
+	Clock::time_point mStartTime;
+	double mWallMilliseconds = 0.0;
+
+	std::atomic<bool> mFailed{ false };
+	std::mutex mExceptionMutex;
+	std::exception_ptr mException;
+};
\ No newline at end of file
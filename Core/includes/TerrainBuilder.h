@@ -0,0 +1,89 @@
+#pragma once
+#include "CoreTypes.h"
+#include "JobSystem.h"
+
+// Headerless 16 bit little endian heightmap (.raw/.r16) of known size. Only the rows a region needs are
+// read, so maps that don't fit in memory can be turned into meshes tile by tile.
+class HeightmapFile
+{
+public:
+	HeightmapFile() = default;
+	HeightmapFile(const std::string& filename, uint32_t width, uint32_t height);
+
+	void Open(const std::string& filename, uint32_t width, uint32_t height);
+	bool IsOpen();
+
+	uint32_t GetWidth();
+	uint32_t GetHeight();
+
+	// width * height samples starting at (x, y) normalized to [0, 1]. Samples outside of the map repeat its edge.
+	void ReadRegion(int x, int y, uint32_t width, uint32_t height, float* heights);
+private:
+	std::ifstream mFile;
+	uint32_t mWidth = 0;
+	uint32_t mHeight = 0;
+
+	std::vector<uint16_t> mRowBuffer;
+};
+
+struct TerrainBuilderStatistics
+{
+	uint32_t vertexCount = 0;
+	uint32_t triangleCount = 0;
+
+	double readMilliseconds = 0.0; // of the samples from a HeightmapFile
+	double buildMilliseconds = 0.0;
+};
+
+// Turns a heightmap into a triangle list with one vertex per sample. Rows are built in parallel into
+// preallocated vertices and indices, normals come from central differences four vertices at a time.
+// Sample (x, y) is at world x = (x - (width - 1) / 2) * sampleSpacing and z = (y - (height - 1) / 2) *
+// sampleSpacing with texture coordinate (x, y) / (width - 1, height - 1), the same layout as the terrain
+// patches, and the tiles of BuildTile line up with the mesh of the whole map.
+class TerrainBuilder
+{
+public:
+	explicit TerrainBuilder(JobSystem& jobSystem = JobSystem::GetDefault());
+
+	void SetSampleSpacing(float sampleSpacing); // 1 by default
+	// height = normalized sample * heightScale + heightOffset, 64 and -16 by default like terrain.hlsl.
+	void SetHeightScale(float heightScale, float heightOffset);
+
+	// width * height samples normalized to [0, 1].
+	MeshData Build(const float* heights, uint32_t width, uint32_t height);
+	// 8 bit heightmap as stbi_load returns it, the first channel is the height.
+	MeshData Build(const unsigned char* heightValues, int width, int height, int nChannels);
+	// The (tileSize + 1)^2 vertices of tile (tileX, tileY), neighbouring tiles share their edge vertices.
+	// Reads (tileSize + 3)^2 samples, the extra ones are for the normals on the edges.
+	MeshData BuildTile(HeightmapFile& heightmap, uint32_t tileX, uint32_t tileY, uint32_t tileSize);
+
+	TerrainBuilderStatistics GetStatistics(); // of the last Build or BuildTile
+
+	static const uint32_t rowsPerJob = 16;
+private:
+	struct GridDesc
+	{
+		const float* samples; // the vertices' samples are a rectangle inside of this array
+		uint32_t sampleCountX;
+		uint32_t sampleCountY;
+		uint32_t firstSampleX; // of the first vertex
+		uint32_t firstSampleY;
+		uint32_t vertexCountX;
+		uint32_t vertexCountY;
+		uint32_t mapX; // of the first vertex in the whole map
+		uint32_t mapY;
+		uint32_t mapWidth;
+		uint32_t mapHeight;
+	};
+
+	MeshData BuildGrid(const GridDesc& grid);
+	void BuildRows(const GridDesc& grid, MeshData& mesh, uint32_t begin, uint32_t end);
+private:
+	JobSystem& mJobSystem;
+
+	float mSampleSpacing = 1.0f;
+	float mHeightScale = 64.0f;
+	float mHeightOffset = -16.0f;
+
+	TerrainBuilderStatistics mStatistics;
+};
\ No newline at end of file
@@ -0,0 +1,146 @@
+#pragma once
+#include "Camera.h"
+#include "CoreTypes.h"
+#include "JobSystem.h"
+
+// One selected chunk, mirrors TerrainChunk in terrainCdlod.hlsl. The chunk is drawn with a grid of
+// cellCount * cellCount cells, either the full chunk grid or the half grid for a quarter of a node.
+struct TerrainChunkData
+{
+	DirectX::XMFLOAT2 origin; // world x and z of the chunk's min corner
+	float size; // world length of the chunk's edges
+	float cellCount;
+	float morphStart; // camera distance where the vertices start to morph to the next coarser level
+	float morphEnd; // and where they reach it, the end of the chunk's LOD range
+	uint32_t lodLevel; // 0 is the finest
+	float pad0;
+};
+
+// Mirrors cbTerrain in terrainCdlod.hlsl.
+struct TerrainConstant
+{
+	DirectX::XMFLOAT2 origin; // world x and z of the heightmap's min corner
+	DirectX::XMFLOAT2 size; // world size of the heightmap
+	float heightScale; // height = texel * heightScale + heightOffset
+	float heightOffset;
+	float sampleSpacing; // world size of a texel
+	float pad0;
+};
+
+struct TerrainQuadtreeStatistics
+{
+	uint32_t nodeCount = 0;
+	uint32_t visitedNodeCount = 0;
+	uint32_t culledNodeCount = 0; // outside the frustum
+	uint32_t selectedChunkCount = 0;
+	uint32_t halfGridChunkCount = 0;
+	uint32_t triangleCount = 0; // of the selected chunks
+
+	double buildMilliseconds = 0.0;
+	double selectMilliseconds = 0.0;
+};
+
+// Continuous distance-dependent level of detail (CDLOD) over a heightmap. The map is split into a quadtree:
+// a leaf covers chunkSize * chunkSize texels, every level up doubles the size of a node but keeps chunkSize
+// grid cells, and every node stores the min/max height below it for tight bounds. Select walks the tree
+// once per frame, drops the nodes outside the frustum and subdivides a node while it is within the LOD
+// range of the finer level, so the chunk count depends on the view rather than the size of the map.
+// Towards the end of its range a chunk morphs its odd vertices onto the next coarser grid, neighbouring
+// chunks then meet without cracks or popping.
+class TerrainQuadtree
+{
+public:
+	static const uint32_t maxLodCount = 16;
+
+	explicit TerrainQuadtree(JobSystem& jobSystem = JobSystem::GetDefault());
+
+	// width * height heights in rows. Texel (x, y) covers [x, x + 1] * sampleSpacing in x and [y, y + 1]
+	// * sampleSpacing in z of a map centered on the origin, like CreateTerrainPatches. chunkSize is a power of two.
+	void Build(const float* heights, uint32_t width, uint32_t height,
+		float sampleSpacing = 1.0f, uint32_t chunkSize = 32);
+	// 8 bit heightmap as stbi_load returns it, the height is the first channel / 255 * heightScale + heightOffset.
+	void Build(const unsigned char* heightValues, int width, int height, int nChannels,
+		float heightScale = 64.0f, float heightOffset = -16.0f, float sampleSpacing = 1.0f, uint32_t chunkSize = 32);
+
+	// Level 0 is used up to this distance from the camera and every coarser level doubles it. The distance
+	// is raised to the smallest one that keeps neighbouring chunks within one level of each other.
+	void SetLodDistance(float distance);
+	void SetMorphStartRatio(float ratio); // part of a level's range before its vertices start to morph, 0.7 by default
+
+	void Select(Camera& camera);
+	// Planes as Camera::GetFrustumPlanes returns them.
+	void Select(const DirectX::XMFLOAT3& cameraPosition, const std::array<DirectX::XMFLOAT4, 6>& frustumPlanes);
+
+	// Chunks drawn with the full grid come first, GetFullGridChunkCount of them, then the half grid chunks.
+	const std::vector<TerrainChunkData>& GetSelection();
+	uint32_t GetFullGridChunkCount();
+
+	uint32_t GetLodCount();
+	uint32_t GetChunkSize();
+	uint32_t GetNodeCount();
+	float GetLodRange(uint32_t lodLevel);
+	uint32_t GetNodeCountX(uint32_t lodLevel);
+	uint32_t GetNodeCountY(uint32_t lodLevel);
+	DirectX::BoundingBox GetNodeBounds(uint32_t lodLevel, uint32_t x, uint32_t y);
+	TerrainConstant GetTerrainConstant();
+
+	TerrainQuadtreeStatistics GetStatistics(); // of the last Build and Select
+
+	// CPU reference of the vertex morph in terrainCdlod.hlsl. gridX and gridY count cells of the chunk's
+	// level from the map origin, the odd ones move towards the even ones below by morphFactor cells.
+	static float ComputeMorphFactor(float distance, float morphStart, float morphEnd);
+	static void MorphGridPosition(float& gridX, float& gridY, float morphFactor);
+
+	static const uint32_t rowsPerJob = 4;
+private:
+	struct Level
+	{
+		uint32_t nodeCountX = 0;
+		uint32_t nodeCountY = 0;
+		std::vector<DirectX::XMFLOAT2> heightRanges; // min and max height per node
+	};
+
+	enum class FrustumTest : int
+	{
+		Outside = 0,
+		Intersects,
+		Inside
+	};
+
+	void BuildLeafRows(const float* heights, uint32_t begin, uint32_t end);
+	void BuildLevel(uint32_t lodLevel);
+	void UpdateLodRanges();
+
+	void GetNodeBox(uint32_t lodLevel, uint32_t x, uint32_t y, DirectX::XMFLOAT3& boxMin, DirectX::XMFLOAT3& boxMax);
+	bool IsInRange(const DirectX::XMFLOAT3& boxMin, const DirectX::XMFLOAT3& boxMax, float range);
+	FrustumTest TestFrustum(const DirectX::XMFLOAT3& boxMin, const DirectX::XMFLOAT3& boxMax);
+	bool SelectNode(uint32_t lodLevel, uint32_t x, uint32_t y, bool insideFrustum);
+	// The area of node (x, y) of areaLevel drawn with the grid of lodLevel.
+	void AddChunk(uint32_t areaLevel, uint32_t x, uint32_t y, uint32_t lodLevel);
+private:
+	JobSystem& mJobSystem;
+
+	uint32_t mWidth = 0;
+	uint32_t mHeight = 0;
+	float mSampleSpacing = 1.0f;
+	uint32_t mChunkSize = 32;
+	float mHeightScale = 1.0f;
+	float mHeightOffset = 0.0f;
+	DirectX::XMFLOAT2 mOrigin = DirectX::XMFLOAT2(0.0f, 0.0f);
+
+	std::vector<Level> mLevels;
+	uint32_t mNodeCount = 0;
+
+	float mLodDistance = 0.0f;
+	float mMorphStartRatio = 0.7f;
+	std::array<float, maxLodCount> mLodRanges = {};
+
+	DirectX::XMFLOAT3 mCameraPosition = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+	std::array<DirectX::XMFLOAT4, 6> mFrustumPlanes;
+
+	std::vector<TerrainChunkData> mSelection;
+	std::vector<TerrainChunkData> mHalfGridSelection; // scratch, appended to mSelection
+	uint32_t mFullGridChunkCount = 0;
+
+	TerrainQuadtreeStatistics mStatistics;
+};
\ No newline at end of file
@@ -0,0 +1,102 @@
+#pragma once
+#include "Camera.h"
+#include "CoreTypes.h"
+#include "JobSystem.h"
+
+// Precomputed data of one terrain patch, mirrors TerrainPatch in terrain.hlsl. Edges are in the order of
+// SV_TessFactor for the quad domain: u = 0 (min x), v = 0 (min z), u = 1 (max x), v = 1 (max z).
+struct TerrainPatchData
+{
+	DirectX::XMFLOAT4 rect; // min x, min z, max x, max z in world space
+	DirectX::XMFLOAT4 edgeErrors; // height error of the untessellated patches on both sides of the edge
+	DirectX::XMFLOAT4 edgeHeights; // height in the middle of the edge
+	float minHeight;
+	float maxHeight;
+	float pad0;
+	float pad1;
+};
+
+// Mirrors cbTessellation in terrain.hlsl.
+struct TessellationConstant
+{
+	DirectX::XMFLOAT4 frustumPlanes[6]; // as Camera::GetFrustumPlanes returns them
+	float projScale; // pixels per world unit at distance 1
+	float pixelError;
+	float minTrianglePixels;
+	float maxTessFactor;
+};
+
+// SV_TessFactor and SV_InsideTessFactor of a quad patch.
+struct PatchTessFactors
+{
+	float edges[4];
+	float inside[2];
+};
+
+struct TerrainTessellationStatistics
+{
+	uint32_t patchCount = 0;
+	uint32_t culledPatchCount = 0;
+	uint32_t triangleCount = 0; // estimate for the factors of the last Update
+
+	double buildMilliseconds = 0.0;
+	double updateMilliseconds = 0.0;
+};
+
+// Screen space error driven tessellation factors for the patches of CreateTerrainPatches. Build measures
+// how far the heightmap strays from every flat, untessellated patch. An edge's factor makes that error
+// about pixelError pixels on screen, with smooth terrain the error shrinks with the square of the factor,
+// and keeps triangles at least minTrianglePixels wide. The factor only depends on data both patches of the
+// edge share, so they agree on it and there are no cracks. Patches outside the frustum get 0 and are culled.
+// The hull shader does the work, Update computes the same factors on the CPU for the statistics and tests.
+class TerrainTessellation
+{
+public:
+	explicit TerrainTessellation(JobSystem& jobSystem = JobSystem::GetDefault());
+
+	// Same heightmap and patch grid as CreateTerrainPatches(width, height, countOfPatches), the height is the
+	// first channel / 255 * heightScale + heightOffset like the domain shader.
+	void Build(const unsigned char* heightValues, int width, int height, int nChannels, uint32_t countOfPatches,
+		float heightScale = 64.0f, float heightOffset = -16.0f);
+
+	void SetPixelError(float pixelError); // 1 by default
+	void SetMinTrianglePixels(float minTrianglePixels); // 4 by default
+	void SetMaxTessFactor(float maxTessFactor); // up to 64, the default
+
+	void Update(Camera& camera, float viewportHeight);
+
+	// Indexed by SV_PrimitiveID, patch i * countOfPatches + j is the one at x index i and z index j.
+	const std::vector<TerrainPatchData>& GetPatchDatas();
+	TessellationConstant GetTessellationConstant();
+	const PatchTessFactors& GetPatchFactors(uint32_t patch); // of the last Update
+
+	TerrainTessellationStatistics GetStatistics();
+
+	// CPU reference of ConstantHSMain in terrain.hlsl.
+	static void ComputePatchFactors(const TerrainPatchData& patch, const TessellationConstant& tessellationConstant,
+		const DirectX::XMFLOAT3& cameraPosition, PatchTessFactors& factors);
+	static float ComputeEdgeFactor(float edgeLength, float edgeError, float distance,
+		const TessellationConstant& tessellationConstant);
+	// Triangles the fractional_odd partitioning produces, approximately.
+	static uint32_t CountTriangles(const PatchTessFactors& factors);
+
+	static const uint32_t patchRowsPerJob = 1;
+private:
+	void BuildPatchRows(const float* heights, uint32_t begin, uint32_t end);
+	void UpdatePatches(uint32_t begin, uint32_t end);
+private:
+	JobSystem& mJobSystem;
+
+	uint32_t mWidth = 0;
+	uint32_t mHeight = 0;
+	uint32_t mCountOfPatches = 0;
+
+	TessellationConstant mTessellationConstant;
+	DirectX::XMFLOAT3 mCameraPosition = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+
+	std::vector<TerrainPatchData> mPatchDatas;
+	std::vector<float> mPatchErrors; // of the patch itself, before the edges take the max with the neighbours
+	std::vector<PatchTessFactors> mPatchFactors;
+
+	TerrainTessellationStatistics mStatistics;
+};
\ No newline at end of file
@@ -3,27 +3,37 @@
 #include "Stdafx.h"
 #include "Utility.h"
 
+class D3D12ResourceStateTracker;
+
 class Texture
 {
 public:
 	Texture() = default;
+	Texture(const Texture& other) = default;
+	Texture(Texture&& other) = default;
+	Texture& operator=(Texture other); // the old resource goes through the destructor of other
+	~Texture();
 
 	void SetTextureFilename(const std::string& path);
 	void SetTextureFilename(const std::wstring& path);
 	std::wstring GetTextureFilename();
 
 	// basic mesh
+	// With a state tracker the texture is registered and its transition to PIXEL_SHADER_RESOURCE is left
+	// pending, so the barriers of several textures go out in one flush of the caller.
 	void CreateTexture(
 		ID3D12Device* device, 
 		ID3D12GraphicsCommandList* commandList,
 		const char* textureName, 
-		const wchar_t* textureFilename);
+		const wchar_t* textureFilename,
+		D3D12ResourceStateTracker* stateTracker = nullptr);
 
 	// load model
 	void CreateTexture(
 		ID3D12Device* device,
 		ID3D12GraphicsCommandList* commandList,
-		const char* textureName);
+		const char* textureName,
+		D3D12ResourceStateTracker* stateTracker = nullptr);
 
 	void CreateDefaultTexture(
 		ID3D12Device* device,
@@ -33,10 +43,14 @@ public:
 	ID3D12Resource* GetTextureResource();
 
 	static std::array<const CD3DX12_STATIC_SAMPLER_DESC, 7> GetStaticSamplers();
+private:
+	// Copies share the resource, the last one to release it unregisters it from the state tracker.
+	void ReleaseTexture();
 private:
 	std::string mTextureName = "";
 	std::wstring mTextureFilename = L"";
 
 	Microsoft::WRL::ComPtr<ID3D12Resource> mTexture = nullptr;
 	Microsoft::WRL::ComPtr<ID3D12Resource> mTextureUpload = nullptr;
+	bool mIsStateTracked = false; // registered in GlobalResourceStates by CreateTexture
 };
\ No newline at end of file
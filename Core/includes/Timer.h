@@ -1,5 +1,5 @@
 #pragma once
-#include "Stdafx.h"
+#include "CoreTypes.h"
 
 class Timer
 {
@@ -14,14 +14,15 @@ public:
 	void Stop(); // Call when paused
 	void Tick(); // Call every frame
 private:
-	double mSecondsPerCount;
+	using Clock = std::chrono::steady_clock;
+
 	double mDeltaTime;
 
-	__int64 mBaseTime;
-	__int64 mPausedTime;
-	__int64 mStopTime;
-	__int64 mPrevTime;
-	__int64 mCurrTime;
+	Clock::time_point mBaseTime;
+	Clock::duration mPausedTime;
+	Clock::time_point mStopTime;
+	Clock::time_point mPrevTime;
+	Clock::time_point mCurrTime;
 
 	bool mStopped;
 };
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+#include "CoreTypes.h"
+
+// Where Defragment moved an allocation.
+struct TlsfMove
+{
+	uint32_t oldOffset;
+	uint32_t newOffset;
+	uint32_t size;
+};
+
+struct TlsfAllocatorStatistics
+{
+	uint32_t capacity = 0;
+	uint32_t usedSize = 0;
+	uint32_t allocationCount = 0;
+	uint32_t freeBlockCount = 0;
+	uint32_t largestFreeBlock = 0;
+	float fragmentation = 0.0f; // 1 - largest free block / free size, 0 when the free space is one block
+};
+
+// Two-level segregated fit allocator over the range [0, capacity) of some outside memory, in any unit
+// (bytes, vertices, indices). Free blocks sit in lists by size class, a power of two split into
+// secondLevelCount steps, and two levels of bitmaps find a big enough list in constant time. Freed
+// blocks merge with free neighbours right away. Allocate and Free are O(1), the allocator never touches
+// the memory it manages.
+class TlsfAllocator
+{
+public:
+	static const uint32_t invalidOffset = 0xffffffff;
+	static const uint32_t secondLevelBits = 4;
+	static const uint32_t secondLevelCount = 1 << secondLevelBits;
+	static const uint32_t firstLevelCount = 32 - secondLevelBits + 1;
+
+	explicit TlsfAllocator(uint32_t capacity = 0);
+
+	void Reset(uint32_t capacity); // frees everything
+	void Grow(uint32_t capacity); // adds free space at the end
+
+	uint32_t Allocate(uint32_t size); // offset or invalidOffset when no free block is big enough
+	void Free(uint32_t offset);
+	uint32_t GetAllocationSize(uint32_t offset);
+
+	// Packs the allocations to the start in offset order, the free space is one block at the end afterwards.
+	// moves gets the allocations that moved, in increasing offsets.
+	void Defragment(std::vector<TlsfMove>& moves);
+
+	uint32_t GetCapacity();
+	TlsfAllocatorStatistics GetStatistics();
+private:
+	static const uint32_t noBlock = 0xffffffff;
+
+	struct Block
+	{
+		uint32_t offset = 0;
+		uint32_t size = 0;
+		uint32_t previousPhysical = noBlock; // neighbours in memory
+		uint32_t nextPhysical = noBlock;
+		uint32_t previousFree = noBlock; // neighbours in the free list
+		uint32_t nextFree = noBlock;
+		bool isFree = false;
+	};
+
+	static void GetListIndex(uint32_t size, uint32_t& firstLevel, uint32_t& secondLevel);
+
+	uint32_t CreateBlock(uint32_t offset, uint32_t size);
+	void DestroyBlock(uint32_t block);
+	void InsertFreeBlock(uint32_t block);
+	void RemoveFreeBlock(uint32_t block);
+	uint32_t FindFreeBlock(uint32_t size);
+private:
+	uint32_t mCapacity = 0;
+	uint32_t mUsedSize = 0;
+
+	std::vector<Block> mBlocks;
+	std::vector<uint32_t> mUnusedBlocks; // entries of mBlocks to reuse
+	uint32_t mFirstBlock = noBlock;
+	uint32_t mLastBlock = noBlock;
+
+	uint32_t mFirstLevelBitmap = 0; // bit per first level with a free block
+	std::array<uint32_t, firstLevelCount> mSecondLevelBitmaps;
+	std::array<uint32_t, firstLevelCount * secondLevelCount> mFreeLists; // first block of every size class
+
+	std::unordered_map<uint32_t, uint32_t> mAllocations; // offset to block
+};
\ No newline at end of file
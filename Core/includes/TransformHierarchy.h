@@ -0,0 +1,52 @@
+#pragma once
+#include "CoreTypes.h"
+#include "JobSystem.h"
+
+// Flat, parent-indexed node transforms. Nodes are stored in the order they were added and a parent
+// has to be added before its children, so one linear pass computes every world matrix.
+// SetLocal marks a node dirty, the update only recomputes dirty nodes and their descendants.
+class TransformHierarchy
+{
+public:
+	static const uint32_t invalidNode = 0xffffffff;
+
+	TransformHierarchy() = default;
+
+	void Reserve(uint32_t nodeCount);
+	void Clear();
+
+	uint32_t AddNode(uint32_t parent, const DirectX::XMFLOAT4X4& local); // invalidNode for a root
+
+	void SetLocal(uint32_t node, const DirectX::XMFLOAT4X4& local);
+	void SetLocal(uint32_t node, DirectX::FXMMATRIX local);
+	DirectX::XMFLOAT4X4 GetLocal(uint32_t node);
+
+	// Valid after UpdateWorldMatrices.
+	DirectX::XMFLOAT4X4 GetWorld(uint32_t node);
+	DirectX::XMMATRIX GetWorldMatrix(uint32_t node);
+	bool IsWorldChanged(uint32_t node); // by the last update, e.g. to refit bounding volumes
+
+	uint32_t GetParent(uint32_t node);
+	uint32_t GetDepth(uint32_t node);
+	uint32_t GetNodeCount();
+
+	// Returns the number of world matrices recomputed.
+	uint32_t UpdateWorldMatrices();
+	// Same result, every depth level is split across the job system.
+	uint32_t UpdateWorldMatrices(JobSystem& jobSystem);
+private:
+	bool UpdateNode(uint32_t node);
+	void BuildLevels();
+private:
+	std::vector<DirectX::XMFLOAT4X4A> mLocalMatrices;
+	std::vector<DirectX::XMFLOAT4X4A> mWorldMatrices;
+	std::vector<uint32_t> mParents;
+	std::vector<uint32_t> mDepths;
+	std::vector<uint8_t> mDirty; // local changed since the last update
+	std::vector<uint8_t> mWorldChanged;
+
+	// Node indices sorted by depth and where each depth starts, rebuilt after nodes were added.
+	std::vector<uint32_t> mLevelNodes;
+	std::vector<uint32_t> mLevelOffsets;
+	bool mLevelsDirty = true;
+};
\ No newline at end of file
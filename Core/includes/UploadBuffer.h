@@ -1,5 +1,6 @@
 #pragma once
 #include "Stdafx.h"
+#include "D3D12MemoryAllocator.h"
 #include "Utility.h"
 
 template<typename T>
@@ -14,13 +15,8 @@ public:
 		if (mIsConstantBuffer)
 			mElementByteSize = D3D12Utility::CalculateConstantBufferSize(sizeof(T));
 
-		ThrowIfFailed(device->CreateCommittedResource(
-			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-			D3D12_HEAP_FLAG_NONE,
-			&CD3DX12_RESOURCE_DESC::Buffer(static_cast<UINT64>(mElementByteSize * instanceCount)),
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(mUploadBuffer.GetAddressOf())));
+		mUploadBuffer = D3D12MemoryAllocator::GetDefault(device).CreateBuffer(D3D12_HEAP_TYPE_UPLOAD,
+			static_cast<UINT64>(mElementByteSize * instanceCount), D3D12_RESOURCE_STATE_GENERIC_READ);
 
 		ThrowIfFailed(mUploadBuffer->Map(0, nullptr, reinterpret_cast<void**>(&mMappedData)));
 	}
@@ -45,6 +41,12 @@ public:
 	{
 		memcpy(&mMappedData[elementIndex * mElementByteSize], &data, mElementByteSize);
 	}
+	// Consecutive elements in one copy, not for constant buffers since their elements are padded.
+	void CopyData(int firstElementIndex, const T* data, UINT count)
+	{
+		assert(!mIsConstantBuffer);
+		memcpy(&mMappedData[firstElementIndex * mElementByteSize], data, count * mElementByteSize);
+	}
 private:
 	Microsoft::WRL::ComPtr<ID3D12Resource> mUploadBuffer = nullptr;
 
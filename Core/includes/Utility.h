@@ -59,22 +59,6 @@ public:
 #define ReleaseCom(x) { if(x){ x->Release(); x = 0; } }
 #endif
 
-struct Vertex
-{
-	Vertex() = default;
-	Vertex(float px, float py, float pz, 
-		float nx, float ny, float nz, 
-		float u, float v)
-		: position(DirectX::XMFLOAT3(px, py, pz)),
-		normal(DirectX::XMFLOAT3(nx, ny, nz)),
-		texCoord(DirectX::XMFLOAT2(u, v))
-	{ }
-
-	DirectX::XMFLOAT3 position;
-	DirectX::XMFLOAT3 normal;
-	DirectX::XMFLOAT2 texCoord;
-};
-
 class D3D12Utility
 {
 public:
@@ -84,6 +68,8 @@ public:
 		const void* initData,
 		UINT byteSize,
 		Microsoft::WRL::ComPtr<ID3D12Resource>& uploadBuffer);
+	// Empty, in the common state that buffers promote from, for data copied in by a GeometryUploader.
+	static Microsoft::WRL::ComPtr<ID3D12Resource> CreateDefaultBuffer(ID3D12Device* device, UINT64 byteSize);
 
 	static UINT CalculateConstantBufferSize(UINT size);
 
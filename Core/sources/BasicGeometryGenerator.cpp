@@ -1,9 +1,9 @@
 #include "../includes/BasicGeometryGenerator.h"
-#include "../includes/Mesh.h"
+#include "../includes/TerrainBuilder.h"
 
 using namespace DirectX;
 
-Mesh BasicGeometryGenerator::CreateBox(float width, float height, float depth)
+MeshData BasicGeometryGenerator::CreateBox(float width, float height, float depth)
 {
 	//
 	// Create the vertices.
@@ -85,10 +85,10 @@ Mesh BasicGeometryGenerator::CreateBox(float width, float height, float depth)
 
 	mIndices.assign(&i[0], &i[36]);
 
-	return Mesh(mVertices, mIndices);
+	return { mVertices, mIndices };
 }
 
-Mesh BasicGeometryGenerator::CreateGrid(float width, float depth, uint32_t m, uint32_t n)
+MeshData BasicGeometryGenerator::CreateGrid(float width, float depth, uint32_t m, uint32_t n)
 {
 	uint32_t vertexCount = m * n;
 	uint32_t faceCount = (m - 1) * (n - 1) * 2;
@@ -148,10 +148,10 @@ Mesh BasicGeometryGenerator::CreateGrid(float width, float depth, uint32_t m, ui
 		}
 	}
 
-	return Mesh(mVertices, mIndices);
+	return { mVertices, mIndices };
 }
 
-Mesh BasicGeometryGenerator::CreateSphere(float radius, uint32_t sliceCount, uint32_t stackCount)
+MeshData BasicGeometryGenerator::CreateSphere(float radius, uint32_t sliceCount, uint32_t stackCount)
 {
 	//
 	// Compute the vertices stating at the top pole and moving down the stacks.
@@ -257,55 +257,18 @@ Mesh BasicGeometryGenerator::CreateSphere(float radius, uint32_t sliceCount, uin
 		mIndices.push_back(baseIndex + i + 1);
 	}
 
-	return Mesh(mVertices, mIndices);
+	return { mVertices, mIndices };
 }
 
-Mesh BasicGeometryGenerator::CreateTerrain(const unsigned char* heightValues, 
+MeshData BasicGeometryGenerator::CreateTerrain(const unsigned char* heightValues, 
 	int width, int height, int nChannels)
 {
-	std::vector<Vertex> vertices;
-	std::vector<uint32_t> indices;
-
-	// vertex generation
-	float yScale = 64.0f / 256.0f, yShift = 16.0f; // apply a scale + shift to the height data
-	for (int i = 0; i < height; i++)
-	{
-		for (int j = 0; j < width; j++)
-		{
-			// retrieve texel for (i, j) tex coord
-			const unsigned char* texel = heightValues + (j + width * i) * nChannels;
-			unsigned char y = texel[0];
-
-			// vertex
-			Vertex vertex;
-
-			vertex.position.x = (-height / 2.0f + i);
-			vertex.position.y = static_cast<float>(y) * yScale - yShift;
-			vertex.position.z = (-width / 2.0f + j);
-
-			vertex.normal = XMFLOAT3(0.0f, 1.0f, 0.0f);
-			vertex.texCoord = XMFLOAT2(0.0f, 0.0f);
-
-			vertices.push_back(vertex);
-		}
-	}
-
-	// index generation
-	for (int i = 0; i < height - 1; i++) // for each row a.k.a. each strip
-	{
-		for (int j = 0; j < width; j++) // for each column
-		{
-			for (int k = 0; k < 2; k++) // for each side of the strip
-			{
-				indices.push_back(static_cast<UINT>(j + width * (i + k)));
-			}
-		}
-	}
-
-	return Mesh(vertices, indices);
+	// One vertex per texel with normals and texture coordinates, built in parallel.
+	TerrainBuilder terrainBuilder;
+	return terrainBuilder.Build(heightValues, width, height, nChannels);
 }
 
-Mesh BasicGeometryGenerator::CreateTerrainPatches(int width, int height, UINT countOfPatches)
+MeshData BasicGeometryGenerator::CreateTerrainPatches(int width, int height, uint32_t countOfPatches)
 {
 	std::vector<Vertex> vertices;
 	std::vector<uint32_t> indices;
@@ -314,9 +277,9 @@ Mesh BasicGeometryGenerator::CreateTerrainPatches(int width, int height, UINT co
 	indices.reserve(countOfPatches * countOfPatches);
 
 	// vertex generation
-	for (UINT i = 0; i <= countOfPatches; i++)
+	for (uint32_t i = 0; i <= countOfPatches; i++)
 	{
-		for (UINT j = 0; j <= countOfPatches; j++)
+		for (uint32_t j = 0; j <= countOfPatches; j++)
 		{
 			// vertex
 			Vertex vertex;
@@ -339,17 +302,17 @@ Mesh BasicGeometryGenerator::CreateTerrainPatches(int width, int height, UINT co
 	{
 		for (int j = 0; j <= countOfPatches - 1; j++) // for each column
 		{
-			indices.push_back(static_cast<UINT>(j + i * (countOfPatches + 1)));
-			indices.push_back(static_cast<UINT>(j + (i + 1) * (countOfPatches + 1)));
-			indices.push_back(static_cast<UINT>(j + 1 + i * (countOfPatches + 1)));
-			indices.push_back(static_cast<UINT>(j + 1 + (i + 1) * (countOfPatches + 1)));
+			indices.push_back(static_cast<uint32_t>(j + i * (countOfPatches + 1)));
+			indices.push_back(static_cast<uint32_t>(j + (i + 1) * (countOfPatches + 1)));
+			indices.push_back(static_cast<uint32_t>(j + 1 + i * (countOfPatches + 1)));
+			indices.push_back(static_cast<uint32_t>(j + 1 + (i + 1) * (countOfPatches + 1)));
 		}
 	}
 
-	return Mesh(vertices, indices, D3D_PRIMITIVE_TOPOLOGY_4_CONTROL_POINT_PATCHLIST);
+	return { vertices, indices, PrimitiveTopology::PatchList4 };
 }
 
-Mesh BasicGeometryGenerator::CreateQuad(float x, float y, float w, float h, float depth)
+MeshData BasicGeometryGenerator::CreateQuad(float x, float y, float w, float h, float depth)
 {
 	std::vector<Vertex> vertices;
 	std::vector<uint32_t> indices;
@@ -390,5 +353,5 @@ Mesh BasicGeometryGenerator::CreateQuad(float x, float y, float w, float h, floa
 	indices[4] = 2;
 	indices[5] = 3;
 
-	return Mesh(vertices, indices);
+	return { vertices, indices };
 }
\ No newline at end of file
@@ -0,0 +1,596 @@
+#include "../includes/BoundingVolumeHierarchy.h"
+using namespace DirectX;
+
+namespace
+{
+	float HalfArea(FXMVECTOR boundsMin, FXMVECTOR boundsMax)
+	{
+		XMVECTOR size = XMVectorSubtract(boundsMax, boundsMin);
+		XMVECTOR yzx = XMVectorSwizzle<1, 2, 0, 3>(size);
+		return XMVectorGetX(XMVector3Dot(size, yzx));
+	}
+
+	// 0 outside, 1 intersecting, 2 inside. The planes are in structure of arrays form, four per group.
+	int ClassifyBox(FXMVECTOR boundsMin, FXMVECTOR boundsMax,
+		const XMVECTOR* planeX, const XMVECTOR* planeY, const XMVECTOR* planeZ, const XMVECTOR* planeW,
+		const XMVECTOR* absPlaneX, const XMVECTOR* absPlaneY, const XMVECTOR* absPlaneZ)
+	{
+		XMVECTOR half = XMVectorReplicate(0.5f);
+		XMVECTOR center = XMVectorMultiply(XMVectorAdd(boundsMin, boundsMax), half);
+		XMVECTOR extents = XMVectorMultiply(XMVectorSubtract(boundsMax, boundsMin), half);
+
+		XMVECTOR centerX = XMVectorSplatX(center);
+		XMVECTOR centerY = XMVectorSplatY(center);
+		XMVECTOR centerZ = XMVectorSplatZ(center);
+		XMVECTOR extentsX = XMVectorSplatX(extents);
+		XMVECTOR extentsY = XMVectorSplatY(extents);
+		XMVECTOR extentsZ = XMVectorSplatZ(extents);
+
+		XMVECTOR outside = XMVectorFalseInt();
+		XMVECTOR crossing = XMVectorFalseInt();
+		for (int group = 0; group < 2; group++)
+		{
+			// Planes face outwards, the box is outside a plane if its nearest corner is in front of it.
+			XMVECTOR distance = XMVectorMultiplyAdd(centerX, planeX[group],
+				XMVectorMultiplyAdd(centerY, planeY[group], XMVectorMultiplyAdd(centerZ, planeZ[group], planeW[group])));
+			XMVECTOR radius = XMVectorMultiplyAdd(extentsX, absPlaneX[group],
+				XMVectorMultiply(extentsY, absPlaneY[group]));
+			radius = XMVectorMultiplyAdd(extentsZ, absPlaneZ[group], radius);
+
+			outside = XMVectorOrInt(outside, XMVectorGreater(distance, radius));
+			crossing = XMVectorOrInt(crossing, XMVectorGreater(distance, XMVectorNegate(radius)));
+		}
+
+		if (!XMVector4EqualInt(outside, XMVectorFalseInt()))
+			return 0;
+		return XMVector4EqualInt(crossing, XMVectorFalseInt()) ? 2 : 1;
+	}
+
+	// Entry distance of the ray into the box clamped to [0, maxDistance], negative for a miss.
+	float IntersectBox(FXMVECTOR boundsMin, FXMVECTOR boundsMax, FXMVECTOR origin, GXMVECTOR inverseDirection,
+		float maxDistance)
+	{
+		XMVECTOR t0 = XMVectorMultiply(XMVectorSubtract(boundsMin, origin), inverseDirection);
+		XMVECTOR t1 = XMVectorMultiply(XMVectorSubtract(boundsMax, origin), inverseDirection);
+		XMVECTOR tNear = XMVectorMin(t0, t1);
+		XMVECTOR tFar = XMVectorMax(t0, t1);
+
+		float entry = std::max(std::max(XMVectorGetX(tNear), XMVectorGetY(tNear)), std::max(XMVectorGetZ(tNear), 0.0f));
+		float exit = std::min(std::min(XMVectorGetX(tFar), XMVectorGetY(tFar)), std::min(XMVectorGetZ(tFar), maxDistance));
+
+		return entry <= exit ? entry : -1.0f;
+	}
+}
+
+uint32_t BoundingVolumeHierarchy::Insert(const BoundingBox& bounds, uint32_t userData)
+{
+	uint32_t leaf = AllocateNode();
+
+	XMVECTOR center = XMLoadFloat3(&bounds.Center);
+	XMVECTOR extents = XMLoadFloat3(&bounds.Extents);
+	XMStoreFloat4(&mNodes[leaf].boundsMin, XMVectorSubtract(center, extents));
+	XMStoreFloat4(&mNodes[leaf].boundsMax, XMVectorAdd(center, extents));
+	mNodes[leaf].userData = userData;
+	mNodes[leaf].height = 0;
+
+	InsertLeaf(leaf);
+	mProxyCount++;
+
+	return leaf;
+}
+void BoundingVolumeHierarchy::Remove(uint32_t proxy)
+{
+	assert(proxy < mNodes.size() && IsLeaf(proxy));
+
+	RemoveLeaf(proxy);
+	FreeNode(proxy);
+	mProxyCount--;
+}
+void BoundingVolumeHierarchy::Update(uint32_t proxy, const BoundingBox& bounds)
+{
+	assert(proxy < mNodes.size() && IsLeaf(proxy));
+
+	XMVECTOR center = XMLoadFloat3(&bounds.Center);
+	XMVECTOR extents = XMLoadFloat3(&bounds.Extents);
+	XMStoreFloat4(&mNodes[proxy].boundsMin, XMVectorSubtract(center, extents));
+	XMStoreFloat4(&mNodes[proxy].boundsMax, XMVectorAdd(center, extents));
+
+	RefitAncestors(mNodes[proxy].parent);
+}
+void BoundingVolumeHierarchy::Rebuild()
+{
+	std::vector<uint32_t> leaves;
+	leaves.reserve(mProxyCount);
+
+	// Keep the leaves, so proxies stay valid, and return every inner node to the free list.
+	for (uint32_t node = 0; node < static_cast<uint32_t>(mNodes.size()); node++)
+	{
+		if (mNodes[node].height == 0)
+			leaves.push_back(node);
+		else if (mNodes[node].height > 0)
+			FreeNode(node);
+	}
+
+	mRoot = leaves.empty() ? invalidNode : BuildRange(leaves.data(), static_cast<uint32_t>(leaves.size()), invalidNode);
+}
+void BoundingVolumeHierarchy::Clear()
+{
+	mNodes.clear();
+	mRoot = invalidNode;
+	mFreeList = invalidNode;
+	mProxyCount = 0;
+}
+
+BoundingBox BoundingVolumeHierarchy::GetBounds(uint32_t proxy)
+{
+	XMVECTOR boundsMin = XMLoadFloat4(&mNodes[proxy].boundsMin);
+	XMVECTOR boundsMax = XMLoadFloat4(&mNodes[proxy].boundsMax);
+
+	BoundingBox bounds;
+	XMStoreFloat3(&bounds.Center, XMVectorScale(XMVectorAdd(boundsMin, boundsMax), 0.5f));
+	XMStoreFloat3(&bounds.Extents, XMVectorScale(XMVectorSubtract(boundsMax, boundsMin), 0.5f));
+	return bounds;
+}
+uint32_t BoundingVolumeHierarchy::GetUserData(uint32_t proxy)
+{
+	return mNodes[proxy].userData;
+}
+uint32_t BoundingVolumeHierarchy::GetProxyCount()
+{
+	return mProxyCount;
+}
+uint32_t BoundingVolumeHierarchy::GetHeight()
+{
+	return mRoot == invalidNode ? 0 : static_cast<uint32_t>(mNodes[mRoot].height);
+}
+float BoundingVolumeHierarchy::GetSurfaceAreaCost()
+{
+	if (mRoot == invalidNode)
+		return 0.0f;
+
+	float innerArea = 0.0f;
+	for (const auto& node : mNodes)
+	{
+		if (node.height > 0)
+			innerArea += HalfArea(XMLoadFloat4(&node.boundsMin), XMLoadFloat4(&node.boundsMax));
+	}
+
+	float rootArea = HalfArea(XMLoadFloat4(&mNodes[mRoot].boundsMin), XMLoadFloat4(&mNodes[mRoot].boundsMax));
+	return rootArea > 0.0f ? innerArea / rootArea : 0.0f;
+}
+
+void BoundingVolumeHierarchy::QueryFrustum(const BoundingFrustum& frustum, std::vector<uint32_t>& results)
+{
+	if (mRoot == invalidNode)
+		return;
+
+	XMVECTOR planes[8];
+	frustum.GetPlanes(&planes[0], &planes[1], &planes[2], &planes[3], &planes[4], &planes[5]);
+	planes[6] = planes[0];
+	planes[7] = planes[1];
+
+	XMVECTOR planeX[2], planeY[2], planeZ[2], planeW[2];
+	XMVECTOR absPlaneX[2], absPlaneY[2], absPlaneZ[2];
+	for (int group = 0; group < 2; group++)
+	{
+		const XMVECTOR* p = &planes[group * 4];
+		planeX[group] = XMVectorSet(XMVectorGetX(p[0]), XMVectorGetX(p[1]), XMVectorGetX(p[2]), XMVectorGetX(p[3]));
+		planeY[group] = XMVectorSet(XMVectorGetY(p[0]), XMVectorGetY(p[1]), XMVectorGetY(p[2]), XMVectorGetY(p[3]));
+		planeZ[group] = XMVectorSet(XMVectorGetZ(p[0]), XMVectorGetZ(p[1]), XMVectorGetZ(p[2]), XMVectorGetZ(p[3]));
+		planeW[group] = XMVectorSet(XMVectorGetW(p[0]), XMVectorGetW(p[1]), XMVectorGetW(p[2]), XMVectorGetW(p[3]));
+
+		absPlaneX[group] = XMVectorAbs(planeX[group]);
+		absPlaneY[group] = XMVectorAbs(planeY[group]);
+		absPlaneZ[group] = XMVectorAbs(planeZ[group]);
+	}
+
+	std::vector<uint32_t> stack;
+	stack.reserve(64);
+	stack.push_back(mRoot);
+
+	while (!stack.empty())
+	{
+		uint32_t node = stack.back();
+		stack.pop_back();
+
+		int classification = ClassifyBox(XMLoadFloat4(&mNodes[node].boundsMin), XMLoadFloat4(&mNodes[node].boundsMax),
+			planeX, planeY, planeZ, planeW, absPlaneX, absPlaneY, absPlaneZ);
+		if (classification == 0)
+			continue;
+
+		if (classification == 2 || IsLeaf(node))
+		{
+			CollectLeaves(node, results);
+		}
+		else
+		{
+			stack.push_back(mNodes[node].child1);
+			stack.push_back(mNodes[node].child0);
+		}
+	}
+}
+void BoundingVolumeHierarchy::QuerySphere(const BoundingSphere& sphere, std::vector<uint32_t>& results)
+{
+	if (mRoot == invalidNode)
+		return;
+
+	XMVECTOR center = XMLoadFloat3(&sphere.Center);
+	float radiusSquared = sphere.Radius * sphere.Radius;
+
+	std::vector<uint32_t> stack;
+	stack.reserve(64);
+	stack.push_back(mRoot);
+
+	while (!stack.empty())
+	{
+		uint32_t node = stack.back();
+		stack.pop_back();
+
+		XMVECTOR closest = XMVectorClamp(center, XMLoadFloat4(&mNodes[node].boundsMin), XMLoadFloat4(&mNodes[node].boundsMax));
+		if (XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(closest, center))) > radiusSquared)
+			continue;
+
+		if (IsLeaf(node))
+		{
+			results.push_back(mNodes[node].userData);
+		}
+		else
+		{
+			stack.push_back(mNodes[node].child1);
+			stack.push_back(mNodes[node].child0);
+		}
+	}
+}
+
+bool BoundingVolumeHierarchy::RayCast(FXMVECTOR origin, FXMVECTOR direction, float maxDistance, BvhRayHit& hit,
+	const std::function<bool(uint32_t, float&)>& intersect)
+{
+	if (mRoot == invalidNode)
+		return false;
+
+	XMVECTOR inverseDirection = XMVectorReciprocal(direction);
+	float closestDistance = maxDistance;
+	bool found = false;
+
+	float rootDistance = IntersectBox(XMLoadFloat4(&mNodes[mRoot].boundsMin), XMLoadFloat4(&mNodes[mRoot].boundsMax),
+		origin, inverseDirection, closestDistance);
+	if (rootDistance < 0.0f)
+		return false;
+
+	// Entry distances are kept with the nodes so that nodes behind a closer hit are skipped.
+	std::vector<std::pair<uint32_t, float>> stack;
+	stack.reserve(64);
+	stack.push_back({ mRoot, rootDistance });
+
+	while (!stack.empty())
+	{
+		uint32_t node = stack.back().first;
+		float entryDistance = stack.back().second;
+		stack.pop_back();
+
+		if (entryDistance > closestDistance)
+			continue;
+
+		if (IsLeaf(node))
+		{
+			float distance = entryDistance;
+			if (intersect && !intersect(mNodes[node].userData, distance))
+				continue;
+
+			if (distance <= closestDistance)
+			{
+				closestDistance = distance;
+				hit.proxy = node;
+				hit.userData = mNodes[node].userData;
+				hit.distance = distance;
+				found = true;
+			}
+			continue;
+		}
+
+		uint32_t child0 = mNodes[node].child0;
+		uint32_t child1 = mNodes[node].child1;
+		float distance0 = IntersectBox(XMLoadFloat4(&mNodes[child0].boundsMin), XMLoadFloat4(&mNodes[child0].boundsMax),
+			origin, inverseDirection, closestDistance);
+		float distance1 = IntersectBox(XMLoadFloat4(&mNodes[child1].boundsMin), XMLoadFloat4(&mNodes[child1].boundsMax),
+			origin, inverseDirection, closestDistance);
+
+		// Push the farther child first so the nearer one is visited first.
+		if (distance0 >= 0.0f && distance1 >= 0.0f && distance1 < distance0)
+		{
+			std::swap(child0, child1);
+			std::swap(distance0, distance1);
+		}
+		if (distance1 >= 0.0f)
+			stack.push_back({ child1, distance1 });
+		if (distance0 >= 0.0f)
+			stack.push_back({ child0, distance0 });
+	}
+
+	return found;
+}
+
+uint32_t BoundingVolumeHierarchy::AllocateNode()
+{
+	if (mFreeList == invalidNode)
+	{
+		mNodes.emplace_back();
+		return static_cast<uint32_t>(mNodes.size() - 1);
+	}
+
+	uint32_t node = mFreeList;
+	mFreeList = mNodes[node].child1;
+	mNodes[node] = Node();
+	return node;
+}
+void BoundingVolumeHierarchy::FreeNode(uint32_t node)
+{
+	mNodes[node].parent = invalidNode;
+	mNodes[node].child0 = invalidNode;
+	mNodes[node].child1 = mFreeList;
+	mNodes[node].height = -1;
+	mFreeList = node;
+}
+bool BoundingVolumeHierarchy::IsLeaf(uint32_t node)
+{
+	return mNodes[node].height == 0;
+}
+
+void BoundingVolumeHierarchy::InsertLeaf(uint32_t leaf)
+{
+	if (mRoot == invalidNode)
+	{
+		mRoot = leaf;
+		mNodes[leaf].parent = invalidNode;
+		return;
+	}
+
+	uint32_t sibling = FindBestSibling(leaf);
+	uint32_t oldParent = mNodes[sibling].parent;
+	uint32_t newParent = AllocateNode();
+
+	mNodes[newParent].parent = oldParent;
+	mNodes[newParent].child0 = sibling;
+	mNodes[newParent].child1 = leaf;
+	mNodes[sibling].parent = newParent;
+	mNodes[leaf].parent = newParent;
+
+	if (oldParent == invalidNode)
+		mRoot = newParent;
+	else if (mNodes[oldParent].child0 == sibling)
+		mNodes[oldParent].child0 = newParent;
+	else
+		mNodes[oldParent].child1 = newParent;
+
+	RefitAncestors(newParent);
+}
+void BoundingVolumeHierarchy::RemoveLeaf(uint32_t leaf)
+{
+	if (leaf == mRoot)
+	{
+		mRoot = invalidNode;
+		return;
+	}
+
+	uint32_t parent = mNodes[leaf].parent;
+	uint32_t grandParent = mNodes[parent].parent;
+	uint32_t sibling = mNodes[parent].child0 == leaf ? mNodes[parent].child1 : mNodes[parent].child0;
+
+	// The sibling takes the place of the parent.
+	mNodes[sibling].parent = grandParent;
+	if (grandParent == invalidNode)
+	{
+		mRoot = sibling;
+	}
+	else
+	{
+		if (mNodes[grandParent].child0 == parent)
+			mNodes[grandParent].child0 = sibling;
+		else
+			mNodes[grandParent].child1 = sibling;
+	}
+
+	FreeNode(parent);
+	mNodes[leaf].parent = invalidNode;
+
+	RefitAncestors(grandParent);
+}
+uint32_t BoundingVolumeHierarchy::FindBestSibling(uint32_t leaf)
+{
+	XMVECTOR leafMin = XMLoadFloat4(&mNodes[leaf].boundsMin);
+	XMVECTOR leafMax = XMLoadFloat4(&mNodes[leaf].boundsMax);
+	float leafArea = HalfArea(leafMin, leafMax);
+
+	uint32_t bestSibling = mRoot;
+	float bestCost = HalfArea(XMVectorMin(leafMin, XMLoadFloat4(&mNodes[mRoot].boundsMin)),
+		XMVectorMax(leafMax, XMLoadFloat4(&mNodes[mRoot].boundsMax)));
+
+	// Branch and bound over the cost of placing the leaf next to a node: the area of the new parent
+	// plus the growth of every ancestor. Candidates are visited cheapest inherited cost first.
+	typedef std::pair<float, uint32_t> Candidate;
+	auto& heap = mSiblingCandidates;
+	heap.clear();
+	heap.push_back({ 0.0f, mRoot });
+
+	while (!heap.empty())
+	{
+		std::pop_heap(heap.begin(), heap.end(), std::greater<Candidate>());
+		float inheritedCost = heap.back().first;
+		uint32_t node = heap.back().second;
+		heap.pop_back();
+
+		XMVECTOR nodeMin = XMLoadFloat4(&mNodes[node].boundsMin);
+		XMVECTOR nodeMax = XMLoadFloat4(&mNodes[node].boundsMax);
+		float unionArea = HalfArea(XMVectorMin(leafMin, nodeMin), XMVectorMax(leafMax, nodeMax));
+
+		float cost = unionArea + inheritedCost;
+		if (cost < bestCost)
+		{
+			bestCost = cost;
+			bestSibling = node;
+		}
+
+		if (IsLeaf(node))
+			continue;
+
+		float childInheritedCost = inheritedCost + unionArea - HalfArea(nodeMin, nodeMax);
+		if (leafArea + childInheritedCost < bestCost)
+		{
+			heap.push_back({ childInheritedCost, mNodes[node].child0 });
+			std::push_heap(heap.begin(), heap.end(), std::greater<Candidate>());
+			heap.push_back({ childInheritedCost, mNodes[node].child1 });
+			std::push_heap(heap.begin(), heap.end(), std::greater<Candidate>());
+		}
+	}
+
+	return bestSibling;
+}
+void BoundingVolumeHierarchy::RefitAncestors(uint32_t node)
+{
+	while (node != invalidNode)
+	{
+		Node& current = mNodes[node];
+		const Node& child0 = mNodes[current.child0];
+		const Node& child1 = mNodes[current.child1];
+
+		XMVECTOR boundsMin = XMVectorMin(XMLoadFloat4(&child0.boundsMin), XMLoadFloat4(&child1.boundsMin));
+		XMVECTOR boundsMax = XMVectorMax(XMLoadFloat4(&child0.boundsMax), XMLoadFloat4(&child1.boundsMax));
+		int height = 1 + std::max(child0.height, child1.height);
+
+		// Nothing above changes once a node keeps its bounds.
+		if (height == current.height &&
+			XMVector3Equal(boundsMin, XMLoadFloat4(&current.boundsMin)) &&
+			XMVector3Equal(boundsMax, XMLoadFloat4(&current.boundsMax)))
+			break;
+
+		XMStoreFloat4(&current.boundsMin, boundsMin);
+		XMStoreFloat4(&current.boundsMax, boundsMax);
+		current.height = height;
+
+		node = current.parent;
+	}
+}
+
+uint32_t BoundingVolumeHierarchy::BuildRange(uint32_t* leaves, uint32_t count, uint32_t parent)
+{
+	if (count == 1)
+	{
+		mNodes[leaves[0]].parent = parent;
+		return leaves[0];
+	}
+
+	XMVECTOR centroidMin = XMVectorSplatInfinity();
+	XMVECTOR centroidMax = XMVectorNegate(centroidMin);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		XMVECTOR centroid = XMVectorAdd(XMLoadFloat4(&mNodes[leaves[i]].boundsMin), XMLoadFloat4(&mNodes[leaves[i]].boundsMax));
+		centroidMin = XMVectorMin(centroidMin, centroid);
+		centroidMax = XMVectorMax(centroidMax, centroid);
+	}
+
+	XMFLOAT3 centroidOrigin;
+	XMFLOAT3 centroidExtent;
+	XMStoreFloat3(&centroidOrigin, centroidMin);
+	XMStoreFloat3(&centroidExtent, XMVectorSubtract(centroidMax, centroidMin));
+	int axis = 0;
+	if (centroidExtent.y > centroidExtent.x)
+		axis = 1;
+	if (centroidExtent.z > (axis == 0 ? centroidExtent.x : centroidExtent.y))
+		axis = 2;
+
+	float axisMin = (&centroidOrigin.x)[axis];
+	float axisExtent = (&centroidExtent.x)[axis];
+
+	uint32_t middle = count / 2;
+	if (axisExtent > 0.0f)
+	{
+		struct Bin
+		{
+			XMVECTOR boundsMin = XMVectorSplatInfinity();
+			XMVECTOR boundsMax = XMVectorNegate(XMVectorSplatInfinity());
+			uint32_t count = 0;
+		};
+		Bin bins[sahBinCount];
+
+		float binScale = sahBinCount * 0.9999f / axisExtent;
+		auto binIndex = [&](uint32_t leaf)
+		{
+			float centroid = (&mNodes[leaf].boundsMin.x)[axis] + (&mNodes[leaf].boundsMax.x)[axis];
+			return std::min(static_cast<uint32_t>((centroid - axisMin) * binScale), sahBinCount - 1);
+		};
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			Bin& bin = bins[binIndex(leaves[i])];
+			bin.boundsMin = XMVectorMin(bin.boundsMin, XMLoadFloat4(&mNodes[leaves[i]].boundsMin));
+			bin.boundsMax = XMVectorMax(bin.boundsMax, XMLoadFloat4(&mNodes[leaves[i]].boundsMax));
+			bin.count++;
+		}
+
+		// Sweep from the right to get the area of every right side, then from the left to find the cheapest split.
+		float rightCosts[sahBinCount];
+		XMVECTOR rightMin = XMVectorSplatInfinity();
+		XMVECTOR rightMax = XMVectorNegate(rightMin);
+		uint32_t rightCount = 0;
+		for (uint32_t i = sahBinCount - 1; i > 0; i--)
+		{
+			rightMin = XMVectorMin(rightMin, bins[i].boundsMin);
+			rightMax = XMVectorMax(rightMax, bins[i].boundsMax);
+			rightCount += bins[i].count;
+			rightCosts[i] = rightCount > 0 ? rightCount * HalfArea(rightMin, rightMax) : 0.0f;
+		}
+
+		uint32_t bestSplit = 0;
+		float bestCost = INFINITY;
+		XMVECTOR leftMin = XMVectorSplatInfinity();
+		XMVECTOR leftMax = XMVectorNegate(leftMin);
+		uint32_t leftCount = 0;
+		for (uint32_t split = 1; split < sahBinCount; split++)
+		{
+			leftMin = XMVectorMin(leftMin, bins[split - 1].boundsMin);
+			leftMax = XMVectorMax(leftMax, bins[split - 1].boundsMax);
+			leftCount += bins[split - 1].count;
+			if (leftCount == 0 || leftCount == count)
+				continue;
+
+			float cost = leftCount * HalfArea(leftMin, leftMax) + rightCosts[split];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestSplit = split;
+			}
+		}
+
+		if (bestSplit > 0)
+		{
+			uint32_t* partition = std::partition(leaves, leaves + count,
+				[&](uint32_t leaf) { return binIndex(leaf) < bestSplit; });
+			middle = static_cast<uint32_t>(partition - leaves);
+		}
+	}
+
+	uint32_t node = AllocateNode();
+	mNodes[node].parent = parent;
+
+	uint32_t child0 = BuildRange(leaves, middle, node);
+	uint32_t child1 = BuildRange(leaves + middle, count - middle, node);
+
+	mNodes[node].child0 = child0;
+	mNodes[node].child1 = child1;
+	XMStoreFloat4(&mNodes[node].boundsMin, XMVectorMin(XMLoadFloat4(&mNodes[child0].boundsMin), XMLoadFloat4(&mNodes[child1].boundsMin)));
+	XMStoreFloat4(&mNodes[node].boundsMax, XMVectorMax(XMLoadFloat4(&mNodes[child0].boundsMax), XMLoadFloat4(&mNodes[child1].boundsMax)));
+	mNodes[node].height = 1 + std::max(mNodes[child0].height, mNodes[child1].height);
+
+	return node;
+}
+void BoundingVolumeHierarchy::CollectLeaves(uint32_t node, std::vector<uint32_t>& results)
+{
+	if (IsLeaf(node))
+	{
+		results.push_back(mNodes[node].userData);
+		return;
+	}
+
+	CollectLeaves(mNodes[node].child0, results);
+	CollectLeaves(mNodes[node].child1, results);
+}
\ No newline at end of file
@@ -1,6 +1,15 @@
 #include "../includes/Camera.h"
 using namespace DirectX;
 
+float GetClearDepth(DepthMode depthMode)
+{
+	return depthMode == DepthMode::Standard ? 1.0f : 0.0f;
+}
+DepthComparison GetDepthComparison(DepthMode depthMode)
+{
+	return depthMode == DepthMode::Standard ? DepthComparison::Less : DepthComparison::Greater;
+}
+
 Camera::Camera()
 	: mPosition(XMFLOAT3(0.0f, 0.0f, 0.0f)),
 	mRight(XMFLOAT3(1.0f, 0.0f, 0.0f)), mUp(XMFLOAT3(0.0f, 1.0f, 0.0f)), mLook(XMFLOAT3(0.0f, 0.0f, 1.0f))
@@ -17,33 +26,71 @@ XMFLOAT3 Camera::GetPosition()
 void Camera::SetPosition(const XMFLOAT3& position)
 {
 	mPosition = position;
+	mViewDirty = true;
 }
 void Camera::SetPosition(float x, float y, float z)
 {
 	mPosition = XMFLOAT3(x, y, z);
+	mViewDirty = true;
 }
 
 XMFLOAT3 Camera::GetRight()
 {
+	UpdateMatrices();
 	return mRight;
 }
 XMFLOAT3 Camera::GetUp()
 {
+	UpdateMatrices();
 	return mUp;
 }
 XMFLOAT3 Camera::GetLook()
 {
+	UpdateMatrices();
 	return mLook;
 }
 
-XMFLOAT4X4 Camera::GetView()
+const XMFLOAT4X4& Camera::GetView()
 {
+	UpdateMatrices();
 	return mView;
 }
-XMFLOAT4X4 Camera::GetProj()
+const XMFLOAT4X4& Camera::GetProj()
 {
+	UpdateMatrices();
 	return mProj;
 }
+const XMFLOAT4X4& Camera::GetViewProj()
+{
+	UpdateMatrices();
+	return mViewProj;
+}
+const XMFLOAT4X4& Camera::GetInverseView()
+{
+	UpdateMatrices();
+	return mInverseView;
+}
+const XMFLOAT4X4& Camera::GetInverseProj()
+{
+	UpdateMatrices();
+	return mInverseProj;
+}
+const XMFLOAT4X4& Camera::GetInverseViewProj()
+{
+	UpdateMatrices();
+	return mInverseViewProj;
+}
+
+const BoundingFrustum& Camera::GetFrustum()
+{
+	UpdateMatrices();
+	return mFrustum;
+}
+const std::array<XMFLOAT4, 6>& Camera::GetFrustumPlanes()
+{
+	UpdateMatrices();
+	return mFrustumPlanes;
+}
 
 void Camera::LookAt(
 	const XMFLOAT3& position, 
@@ -63,7 +110,7 @@ void Camera::LookAt(
 	XMStoreFloat3(&mUp, up);
 	XMStoreFloat3(&mLook, look);
 
-	UpdateViewMatrix();
+	mViewDirty = true;
 }
 void Camera::LookAt(
 	float posX, float posY, float posZ, 
@@ -83,8 +130,30 @@ void Camera::SetLens(float fovAngleY, float aspectRatio, float zn, float zf)
 	mNearZ = zn;
 	mFarZ = zf;
 
-	XMMATRIX proj = XMMatrixPerspectiveFovLH(fovAngleY, aspectRatio, zn, zf);
-	XMStoreFloat4x4(&mProj, proj);
+	mProjDirty = true;
+}
+
+void Camera::SetDepthMode(DepthMode depthMode)
+{
+	mDepthMode = depthMode;
+	mProjDirty = true;
+}
+DepthMode Camera::GetDepthMode()
+{
+	return mDepthMode;
+}
+bool Camera::IsReversedZ()
+{
+	return mDepthMode != DepthMode::Standard;
+}
+
+float Camera::GetNearZ()
+{
+	return mNearZ;
+}
+float Camera::GetFarZ()
+{
+	return mFarZ;
 }
 
 void Camera::Strafe(float distance)
@@ -95,7 +164,7 @@ void Camera::Strafe(float distance)
 	pos = XMVectorMultiplyAdd(XMVectorReplicate(distance), right, pos);
 	XMStoreFloat3(&mPosition, pos);
 
-	UpdateViewMatrix();
+	mViewDirty = true;
 }
 void Camera::Walk(float distance)
 {
@@ -105,7 +174,7 @@ void Camera::Walk(float distance)
 	pos = XMVectorMultiplyAdd(XMVectorReplicate(distance), look, pos);
 	XMStoreFloat3(&mPosition, pos);
 
-	UpdateViewMatrix();
+	mViewDirty = true;
 }
 
 void Camera::Pitch(float angle)
@@ -115,7 +184,7 @@ void Camera::Pitch(float angle)
 	XMStoreFloat3(&mUp, XMVector3TransformNormal(XMLoadFloat3(&mUp), rotationMatrix));
 	XMStoreFloat3(&mLook, XMVector3TransformNormal(XMLoadFloat3(&mLook), rotationMatrix));
 
-	UpdateViewMatrix();
+	mViewDirty = true;
 }
 void Camera::RotateY(float angle)
 {
@@ -125,7 +194,27 @@ void Camera::RotateY(float angle)
 	XMStoreFloat3(&mUp, XMVector3TransformNormal(XMLoadFloat3(&mUp), rotationMatrix));
 	XMStoreFloat3(&mLook, XMVector3TransformNormal(XMLoadFloat3(&mLook), rotationMatrix));
 
-	UpdateViewMatrix();
+	mViewDirty = true;
+}
+
+void Camera::GetPickingRay(float screenX, float screenY, float viewportWidth, float viewportHeight,
+	XMFLOAT3& origin, XMFLOAT3& direction)
+{
+	UpdateMatrices();
+
+	// Pixel to view space on the z = 1 plane.
+	float viewX = (2.0f * screenX / viewportWidth - 1.0f) / mProj(0, 0);
+	float viewY = (-2.0f * screenY / viewportHeight + 1.0f) / mProj(1, 1);
+
+	XMVECTOR right = XMLoadFloat3(&mRight);
+	XMVECTOR up = XMLoadFloat3(&mUp);
+	XMVECTOR look = XMLoadFloat3(&mLook);
+
+	XMVECTOR rayDirection = XMVectorMultiplyAdd(XMVectorReplicate(viewX), right,
+		XMVectorMultiplyAdd(XMVectorReplicate(viewY), up, look));
+
+	origin = mPosition;
+	XMStoreFloat3(&direction, XMVector3Normalize(rayDirection));
 }
 
 void Camera::UpdateViewMatrix()
@@ -166,4 +255,90 @@ void Camera::UpdateViewMatrix()
 	mView(3, 1) = y;
 	mView(3, 2) = z;
 	mView(3, 3) = 1;
+
+	// The view is a rigid transform, its inverse is the camera basis and position.
+	mInverseView(0, 0) = mRight.x;
+	mInverseView(0, 1) = mRight.y;
+	mInverseView(0, 2) = mRight.z;
+	mInverseView(0, 3) = 0;
+
+	mInverseView(1, 0) = mUp.x;
+	mInverseView(1, 1) = mUp.y;
+	mInverseView(1, 2) = mUp.z;
+	mInverseView(1, 3) = 0;
+
+	mInverseView(2, 0) = mLook.x;
+	mInverseView(2, 1) = mLook.y;
+	mInverseView(2, 2) = mLook.z;
+	mInverseView(2, 3) = 0;
+
+	mInverseView(3, 0) = mPosition.x;
+	mInverseView(3, 1) = mPosition.y;
+	mInverseView(3, 2) = mPosition.z;
+	mInverseView(3, 3) = 1;
+}
+void Camera::UpdateProjMatrix()
+{
+	XMMATRIX proj;
+	switch (mDepthMode)
+	{
+	case DepthMode::Reversed:
+		proj = XMMatrixPerspectiveFovLH(mFovAngleY, mAspectRatio, mFarZ, mNearZ);
+		break;
+	case DepthMode::ReversedInfinite:
+	{
+		// z / w = zn / z, 1 on the near plane and 0 at infinity.
+		float yScale = 1.0f / std::tan(0.5f * mFovAngleY);
+		float xScale = yScale / mAspectRatio;
+		proj = XMMatrixSet(
+			xScale, 0.0f, 0.0f, 0.0f,
+			0.0f, yScale, 0.0f, 0.0f,
+			0.0f, 0.0f, 0.0f, 1.0f,
+			0.0f, 0.0f, mNearZ, 0.0f);
+		break;
+	}
+	default:
+		proj = XMMatrixPerspectiveFovLH(mFovAngleY, mAspectRatio, mNearZ, mFarZ);
+		break;
+	}
+	XMStoreFloat4x4(&mProj, proj);
+	XMStoreFloat4x4(&mInverseProj, XMMatrixInverse(nullptr, proj));
+
+	// CreateFromMatrix expects near at depth 0 and a finite far plane, the frustum is built from the lens instead.
+	mViewSpaceFrustum = BoundingFrustum();
+	mViewSpaceFrustum.RightSlope = 1.0f / mProj(0, 0);
+	mViewSpaceFrustum.LeftSlope = -mViewSpaceFrustum.RightSlope;
+	mViewSpaceFrustum.TopSlope = 1.0f / mProj(1, 1);
+	mViewSpaceFrustum.BottomSlope = -mViewSpaceFrustum.TopSlope;
+	mViewSpaceFrustum.Near = mNearZ;
+	mViewSpaceFrustum.Far = mFarZ;
+}
+void Camera::UpdateMatrices()
+{
+	if (!mViewDirty && !mProjDirty)
+		return;
+
+	if (mViewDirty)
+		UpdateViewMatrix();
+
+	if (mProjDirty)
+		UpdateProjMatrix();
+
+	mViewDirty = false;
+	mProjDirty = false;
+
+	XMMATRIX view = XMLoadFloat4x4(&mView);
+	XMMATRIX inverseView = XMLoadFloat4x4(&mInverseView);
+	XMMATRIX viewProj = XMMatrixMultiply(view, XMLoadFloat4x4(&mProj));
+
+	XMStoreFloat4x4(&mViewProj, viewProj);
+	XMStoreFloat4x4(&mInverseViewProj, XMMatrixMultiply(XMLoadFloat4x4(&mInverseProj), inverseView));
+
+	mViewSpaceFrustum.Transform(mFrustum, inverseView);
+
+	// BoundingFrustum planes face outwards and come in near, far, right, left, top, bottom order.
+	XMVECTOR planes[6];
+	mFrustum.GetPlanes(&planes[0], &planes[1], &planes[3], &planes[2], &planes[4], &planes[5]);
+	for (int i = 0; i < 6; i++)
+		XMStoreFloat4(&mFrustumPlanes[i], XMVectorNegate(planes[i]));
 }
\ No newline at end of file
@@ -0,0 +1,408 @@
+#include "../includes/CascadedShadows.h"
+using namespace DirectX;
+
+namespace
+{
+	double ElapsedMilliseconds(std::chrono::steady_clock::time_point start)
+	{
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	}
+
+	// The cascade bounds are rounded to a grid fixed in light space, so they only change
+	// after the camera moved by a whole step.
+	float FloorTo(float value, float step)
+	{
+		return std::floor(value / step) * step;
+	}
+	float CeilTo(float value, float step)
+	{
+		return std::ceil(value / step) * step;
+	}
+
+	bool operator==(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return a.x == b.x && a.y == b.y && a.z == b.z;
+	}
+}
+
+CascadedShadows::CascadedShadows(uint32_t cascadeCount, uint32_t resolution, JobSystem& jobSystem)
+	: mJobSystem(jobSystem), mCascadeCount(cascadeCount), mResolution(resolution)
+{
+	assert(cascadeCount > 0 && cascadeCount <= ShadowConstant::maxCascadeCount);
+	assert(resolution > 2 * mSnapTexels);
+
+	XMStoreFloat4x4(&mLightView, XMMatrixIdentity());
+
+	for (auto& cascade : mCascades)
+	{
+		XMStoreFloat4x4(&cascade.viewProj, XMMatrixIdentity());
+		XMStoreFloat4x4(&cascade.shadowTransform, XMMatrixIdentity());
+		cascade.lightSpaceMin = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		cascade.lightSpaceMax = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	}
+	for (auto& key : mCascadeKeys)
+		key = CascadeKey{ 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+}
+
+void CascadedShadows::SetCascadeCount(uint32_t cascadeCount)
+{
+	assert(cascadeCount > 0 && cascadeCount <= ShadowConstant::maxCascadeCount);
+
+	mCascadeCount = cascadeCount;
+	mInvalidated = true;
+}
+uint32_t CascadedShadows::GetCascadeCount()
+{
+	return mCascadeCount;
+}
+uint32_t CascadedShadows::GetResolution()
+{
+	return mResolution;
+}
+
+void CascadedShadows::SetSplitLambda(float lambda)
+{
+	mSplitLambda = std::min(std::max(lambda, 0.0f), 1.0f);
+}
+void CascadedShadows::SetSnapTexels(uint32_t snapTexels)
+{
+	assert(snapTexels > 0 && snapTexels < mResolution / 2);
+	mSnapTexels = snapTexels;
+}
+void CascadedShadows::SetShadowDistance(float distance)
+{
+	assert(distance > 0.0f);
+	mShadowDistance = distance;
+}
+void CascadedShadows::SetSceneBounds(const BoundingBox& worldBounds)
+{
+	mSceneBounds = worldBounds;
+	mHasSceneBounds = true;
+}
+
+uint32_t CascadedShadows::AddCaster(const BoundingBox& worldBounds, bool isStatic)
+{
+	mCasters.push_back(Caster{ worldBounds, isStatic, true });
+	mCasterMasks.push_back(0);
+	mPreviousCasterMasks.push_back(0);
+
+	GrowSceneBounds(worldBounds);
+
+	return static_cast<uint32_t>(mCasters.size() - 1);
+}
+void CascadedShadows::SetCasterBounds(uint32_t caster, const BoundingBox& worldBounds)
+{
+	assert(caster < mCasters.size());
+
+	mCasters[caster].worldBounds = worldBounds;
+	mCasters[caster].moved = true;
+
+	GrowSceneBounds(worldBounds);
+}
+void CascadedShadows::ClearCasters()
+{
+	mCasters.clear();
+	mCasterMasks.clear();
+	mPreviousCasterMasks.clear();
+
+	for (auto& casters : mCascadeCasters)
+		casters.clear();
+
+	mInvalidated = true;
+}
+void CascadedShadows::Invalidate()
+{
+	mInvalidated = true;
+}
+
+void CascadedShadows::Update(Camera& camera, const XMFLOAT3& lightDirection)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	UpdateLightView(lightDirection);
+
+	// Depth range of the scene along the light, casters can't be closer to it than the near side.
+	BoundingBox lightSpaceScene;
+	mSceneBounds.Transform(lightSpaceScene, XMLoadFloat4x4(&mLightView));
+
+	XMFLOAT3 sceneMin;
+	XMFLOAT3 sceneMax;
+	XMStoreFloat3(&sceneMin, XMVectorSubtract(XMLoadFloat3(&lightSpaceScene.Center), XMLoadFloat3(&lightSpaceScene.Extents)));
+	XMStoreFloat3(&sceneMax, XMVectorAdd(XMLoadFloat3(&lightSpaceScene.Center), XMLoadFloat3(&lightSpaceScene.Extents)));
+
+	const XMFLOAT4X4& proj = camera.GetProj();
+	float slopeX = 1.0f / proj(0, 0);
+	float slopeY = 1.0f / proj(1, 1);
+
+	float nearZ = camera.GetNearZ();
+	float farZ = std::min(camera.GetFarZ(), mShadowDistance);
+
+	float splits[ShadowConstant::maxCascadeCount];
+	ComputeSplitDistances(nearZ, farZ, mCascadeCount, mSplitLambda, splits);
+
+	uint32_t allCascades = (1u << mCascadeCount) - 1;
+
+	mRenderMask = 0;
+	for (uint32_t i = 0; i < mCascadeCount; i++)
+		FitCascade(i, camera, slopeX, slopeY, i == 0 ? nearZ : splits[i - 1], splits[i], sceneMin, sceneMax);
+
+	if (mInvalidated)
+	{
+		mRenderMask = allCascades;
+		mInvalidated = false;
+	}
+
+	uint32_t casterCount = static_cast<uint32_t>(mCasters.size());
+	mJobSystem.ParallelFor(casterCount, castersPerJob, [this](uint32_t begin, uint32_t end)
+		{
+			CullCasters(begin, end);
+		});
+
+	// Serial, the lists stay sorted and a moved caster invalidates both its old and new cascades.
+	for (auto& casters : mCascadeCasters)
+		casters.clear();
+
+	mStatistics = CascadedShadowsStatistics();
+	mStatistics.casterCount = casterCount;
+
+	for (uint32_t i = 0; i < casterCount; i++)
+	{
+		Caster& caster = mCasters[i];
+		uint32_t mask = mCasterMasks[i];
+
+		if (!caster.isStatic)
+			mRenderMask |= mask;
+		else if (caster.moved)
+			mRenderMask |= mask | mPreviousCasterMasks[i];
+
+		caster.moved = false;
+		mPreviousCasterMasks[i] = static_cast<uint8_t>(mask);
+
+		if (mask == 0)
+		{
+			mStatistics.culledCasterCount++;
+			continue;
+		}
+
+		for (uint32_t j = 0; j < mCascadeCount; j++)
+		{
+			if (mask & (1u << j))
+				mCascadeCasters[j].push_back(i);
+		}
+	}
+	mRenderMask &= allCascades;
+
+	for (uint32_t i = 0; i < mCascadeCount; i++)
+	{
+		mStatistics.cascadeCasterCounts[i] = static_cast<uint32_t>(mCascadeCasters[i].size());
+		if (mRenderMask & (1u << i))
+			mStatistics.renderedCascadeCount++;
+	}
+	mStatistics.updateMilliseconds = ElapsedMilliseconds(start);
+}
+
+const ShadowCascade& CascadedShadows::GetCascade(uint32_t cascade)
+{
+	assert(cascade < mCascadeCount);
+	return mCascades[cascade];
+}
+bool CascadedShadows::NeedsRender(uint32_t cascade)
+{
+	assert(cascade < mCascadeCount);
+	return (mRenderMask & (1u << cascade)) != 0;
+}
+const std::vector<uint32_t>& CascadedShadows::GetCasters(uint32_t cascade)
+{
+	assert(cascade < mCascadeCount);
+	return mCascadeCasters[cascade];
+}
+ShadowConstant CascadedShadows::GetShadowConstant()
+{
+	ShadowConstant shadowConstant;
+	shadowConstant.cascadeSplits = XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
+	shadowConstant.cascadeTexelSizes = XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
+
+	for (uint32_t i = 0; i < ShadowConstant::maxCascadeCount; i++)
+	{
+		XMStoreFloat4x4(&shadowConstant.shadowTransforms[i],
+			XMMatrixTranspose(XMLoadFloat4x4(&mCascades[i].shadowTransform)));
+
+		if (i < mCascadeCount)
+		{
+			(&shadowConstant.cascadeSplits.x)[i] = mCascades[i].splitFar;
+			(&shadowConstant.cascadeTexelSizes.x)[i] = mCascades[i].worldTexelSize;
+		}
+	}
+
+	shadowConstant.cascadeCount = mCascadeCount;
+	shadowConstant.shadowMapTexelSize = 1.0f / static_cast<float>(mResolution);
+	shadowConstant.pad0 = 0.0f;
+	shadowConstant.pad1 = 0.0f;
+
+	return shadowConstant;
+}
+
+CascadedShadowsStatistics CascadedShadows::GetStatistics()
+{
+	return mStatistics;
+}
+
+void CascadedShadows::ComputeSplitDistances(float nearZ, float farZ, uint32_t count, float lambda, float* splits)
+{
+	assert(nearZ > 0.0f && farZ > nearZ && count > 0);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		float fraction = static_cast<float>(i + 1) / static_cast<float>(count);
+		float logSplit = nearZ * std::pow(farZ / nearZ, fraction);
+		float uniformSplit = nearZ + (farZ - nearZ) * fraction;
+
+		splits[i] = lambda * logSplit + (1.0f - lambda) * uniformSplit;
+	}
+	splits[count - 1] = farZ;
+}
+void CascadedShadows::ComputeSliceSphere(float slopeX, float slopeY, float sliceNear, float sliceFar,
+	float& centerZ, float& radius)
+{
+	assert(sliceFar > sliceNear);
+
+	// Equidistant from the near and far corners, k2 is the squared slope of the corner rays.
+	// Wide slices put the center past the far plane, the far corners alone bound them then.
+	float k2 = slopeX * slopeX + slopeY * slopeY;
+
+	centerZ = 0.5f * (sliceNear + sliceFar) * (1.0f + k2);
+	if (centerZ >= sliceFar)
+	{
+		centerZ = sliceFar;
+		radius = sliceFar * std::sqrt(k2);
+		return;
+	}
+
+	float farDistance = sliceFar - centerZ;
+	radius = std::sqrt(farDistance * farDistance + sliceFar * sliceFar * k2);
+}
+
+void CascadedShadows::GrowSceneBounds(const BoundingBox& worldBounds)
+{
+	if (mHasSceneBounds)
+		BoundingBox::CreateMerged(mSceneBounds, mSceneBounds, worldBounds);
+	else
+		mSceneBounds = worldBounds;
+
+	mHasSceneBounds = true;
+}
+void CascadedShadows::UpdateLightView(const XMFLOAT3& lightDirection)
+{
+	if (lightDirection == mLightDirection)
+		return;
+
+	mLightDirection = lightDirection;
+	mInvalidated = true;
+
+	// No translation, the texel grid of the cascades is fixed in the world. The up vector only
+	// has to be stable, the rotation around the light direction doesn't matter.
+	XMVECTOR direction = XMVector3Normalize(XMLoadFloat3(&lightDirection));
+	XMVECTOR up = std::fabs(XMVectorGetY(direction)) > 0.99f ?
+		XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f) : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+
+	XMStoreFloat4x4(&mLightView, XMMatrixLookToLH(XMVectorZero(), direction, up));
+}
+void CascadedShadows::FitCascade(uint32_t cascade, Camera& camera, float slopeX, float slopeY,
+	float sliceNear, float sliceFar, const XMFLOAT3& sceneMin, const XMFLOAT3& sceneMax)
+{
+	float centerZ;
+	float radius;
+	ComputeSliceSphere(slopeX, slopeY, sliceNear, sliceFar, centerZ, radius);
+
+	XMMATRIX lightView = XMLoadFloat4x4(&mLightView);
+
+	XMVECTOR centerW = XMVector3TransformCoord(XMVectorSet(0.0f, 0.0f, centerZ, 1.0f),
+		XMLoadFloat4x4(&camera.GetInverseView()));
+	XMFLOAT3 center;
+	XMStoreFloat3(&center, XMVector3TransformCoord(centerW, lightView));
+
+	// The sphere doesn't depend on the camera orientation, so the size of the cascade is constant and
+	// snapping its corner to whole texels keeps every texel on the same spot of the world. The corner
+	// moves in steps of mSnapTexels, the cascade is widened by one step so the sphere always fits.
+	float resolution = static_cast<float>(mResolution);
+	float width = 2.0f * radius * resolution / (resolution - static_cast<float>(mSnapTexels));
+	float texelSize = width / resolution;
+	float snapStep = texelSize * static_cast<float>(mSnapTexels);
+	float depthStep = 0.25f * radius;
+
+	CascadeKey key;
+	key.left = FloorTo(center.x - radius, snapStep);
+	key.bottom = FloorTo(center.y - radius, snapStep);
+	key.nearZ = FloorTo(std::min(sceneMin.z, center.z - radius), depthStep);
+	key.farZ = CeilTo(std::min(sceneMax.z, center.z + radius), depthStep);
+	key.farZ = std::max(key.farZ, key.nearZ + depthStep);
+	key.radius = radius;
+
+	const CascadeKey& previousKey = mCascadeKeys[cascade];
+	if (key.left != previousKey.left || key.bottom != previousKey.bottom || key.nearZ != previousKey.nearZ ||
+		key.farZ != previousKey.farZ || key.radius != previousKey.radius)
+	{
+		mRenderMask |= 1u << cascade;
+	}
+	mCascadeKeys[cascade] = key;
+
+	XMMATRIX proj = XMMatrixOrthographicOffCenterLH(key.left, key.left + width,
+		key.bottom, key.bottom + width, key.nearZ, key.farZ);
+	XMMATRIX viewProj = XMMatrixMultiply(lightView, proj);
+
+	// NDC to texture space, [-1, 1] to [0, 1] with v pointing down.
+	XMMATRIX toTexture = XMMatrixSet(
+		0.5f, 0.0f, 0.0f, 0.0f,
+		0.0f, -0.5f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f,
+		0.5f, 0.5f, 0.0f, 1.0f);
+
+	ShadowCascade& shadowCascade = mCascades[cascade];
+	XMStoreFloat4x4(&shadowCascade.viewProj, viewProj);
+	XMStoreFloat4x4(&shadowCascade.shadowTransform, XMMatrixMultiply(viewProj, toTexture));
+	shadowCascade.splitNear = sliceNear;
+	shadowCascade.splitFar = sliceFar;
+	shadowCascade.worldTexelSize = texelSize;
+	shadowCascade.lightSpaceMin = XMFLOAT3(key.left, key.bottom, key.nearZ);
+	shadowCascade.lightSpaceMax = XMFLOAT3(key.left + width, key.bottom + width, key.farZ);
+}
+void CascadedShadows::CullCasters(uint32_t begin, uint32_t end)
+{
+	XMMATRIX lightView = XMLoadFloat4x4(&mLightView);
+
+	XMVECTOR absRow0 = XMVectorAbs(lightView.r[0]);
+	XMVECTOR absRow1 = XMVectorAbs(lightView.r[1]);
+	XMVECTOR absRow2 = XMVectorAbs(lightView.r[2]);
+
+	XMVECTOR cascadeMins[ShadowConstant::maxCascadeCount];
+	XMVECTOR cascadeMaxs[ShadowConstant::maxCascadeCount];
+	for (uint32_t i = 0; i < mCascadeCount; i++)
+	{
+		cascadeMins[i] = XMLoadFloat3(&mCascades[i].lightSpaceMin);
+		cascadeMaxs[i] = XMLoadFloat3(&mCascades[i].lightSpaceMax);
+	}
+
+	for (uint32_t i = begin; i < end; i++)
+	{
+		const BoundingBox& worldBounds = mCasters[i].worldBounds;
+
+		// Light space box around the rotated world box, its extents are |R| * extents.
+		XMVECTOR center = XMVector3TransformCoord(XMLoadFloat3(&worldBounds.Center), lightView);
+		XMVECTOR extents = XMLoadFloat3(&worldBounds.Extents);
+		XMVECTOR lightExtents = XMVectorMultiply(XMVectorSplatX(extents), absRow0);
+		lightExtents = XMVectorMultiplyAdd(XMVectorSplatY(extents), absRow1, lightExtents);
+		lightExtents = XMVectorMultiplyAdd(XMVectorSplatZ(extents), absRow2, lightExtents);
+
+		XMVECTOR casterMin = XMVectorSubtract(center, lightExtents);
+		XMVECTOR casterMax = XMVectorAdd(center, lightExtents);
+
+		uint8_t mask = 0;
+		for (uint32_t j = 0; j < mCascadeCount; j++)
+		{
+			if (XMVector3LessOrEqual(casterMin, cascadeMaxs[j]) && XMVector3LessOrEqual(cascadeMins[j], casterMax))
+				mask |= static_cast<uint8_t>(1u << j);
+		}
+		mCasterMasks[i] = mask;
+	}
+}
\ No newline at end of file
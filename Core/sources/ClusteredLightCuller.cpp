@@ -0,0 +1,430 @@
+#include "../includes/ClusteredLightCuller.h"
+using namespace DirectX;
+
+namespace
+{
+	const float spotCutoff = 1.0f / 256.0f;
+
+	double ElapsedMilliseconds(std::chrono::steady_clock::time_point start)
+	{
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	}
+
+	// Clamped in float first, far away lights give coordinates that don't fit in an integer.
+	uint32_t ClampToCluster(float coordinate, uint32_t count)
+	{
+		coordinate = std::floor(coordinate);
+		if (!(coordinate > 0.0f))
+			return 0;
+		if (coordinate >= static_cast<float>(count))
+			return count - 1;
+		return static_cast<uint32_t>(coordinate);
+	}
+
+	void SetLane(XMFLOAT4& vector, uint32_t lane, float value)
+	{
+		(&vector.x)[lane] = value;
+	}
+}
+
+ClusteredLightCuller::ClusteredLightCuller(uint32_t clusterCountX, uint32_t clusterCountY, uint32_t clusterCountZ,
+	JobSystem& jobSystem)
+	: mJobSystem(jobSystem),
+	mClusterCountX(clusterCountX), mClusterCountY(clusterCountY), mClusterCountZ(clusterCountZ),
+	mGroupsPerRow((clusterCountX + 3) / 4)
+{
+	assert(clusterCountX > 0 && clusterCountY > 0 && clusterCountZ > 0);
+
+	mGroups.resize(mGroupsPerRow * mClusterCountY * mClusterCountZ);
+	mSliceHits.resize(mClusterCountZ);
+	mSliceIndices.resize(mClusterCountZ);
+	mClusters.resize(GetClusterCount(), LightCluster{ 0, 0 });
+}
+
+void ClusteredLightCuller::SetViewport(uint32_t width, uint32_t height)
+{
+	assert(width > 0 && height > 0);
+
+	mViewportWidth = width;
+	mViewportHeight = height;
+}
+
+void ClusteredLightCuller::AssignLights(Camera& camera, const Light* lights, uint32_t lightCount)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	BuildClusters(camera);
+
+	const XMFLOAT4X4& view = camera.GetView();
+
+	mViewLights.clear();
+	for (uint32_t i = 0; i < lightCount; i++)
+	{
+		ViewLight viewLight;
+		if (SetupLight(lights[i], view, viewLight))
+		{
+			viewLight.index = i;
+			mViewLights.push_back(viewLight);
+		}
+	}
+
+	mJobSystem.ParallelFor(mClusterCountZ, 1, [this](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t slice = begin; slice < end; slice++)
+				AssignSlice(slice);
+		});
+
+	// Every slice sorted its own clusters, concatenating the slices in order gives the final list.
+	uint32_t indexCount = 0;
+	for (const auto& sliceIndices : mSliceIndices)
+		indexCount += static_cast<uint32_t>(sliceIndices.size());
+	mLightIndices.resize(indexCount);
+
+	mStatistics = ClusteredLightCullerStatistics();
+	mStatistics.lightCount = lightCount;
+	mStatistics.visibleLightCount = static_cast<uint32_t>(mViewLights.size());
+	mStatistics.lightIndexCount = indexCount;
+
+	uint32_t clustersPerSlice = mClusterCountX * mClusterCountY;
+	uint32_t sliceOffset = 0;
+	for (uint32_t slice = 0; slice < mClusterCountZ; slice++)
+	{
+		const auto& sliceIndices = mSliceIndices[slice];
+		std::copy(sliceIndices.begin(), sliceIndices.end(), mLightIndices.begin() + sliceOffset);
+
+		LightCluster* clusters = &mClusters[slice * clustersPerSlice];
+		for (uint32_t i = 0; i < clustersPerSlice; i++)
+		{
+			clusters[i].offset += sliceOffset;
+
+			mStatistics.maxLightsPerCluster = std::max(mStatistics.maxLightsPerCluster, clusters[i].count);
+			if (clusters[i].count > 0)
+				mStatistics.nonEmptyClusterCount++;
+		}
+		sliceOffset += static_cast<uint32_t>(sliceIndices.size());
+	}
+
+	mStatistics.assignMilliseconds = ElapsedMilliseconds(start);
+}
+void ClusteredLightCuller::AssignLights(Camera& camera, const std::vector<Light>& lights)
+{
+	AssignLights(camera, lights.data(), static_cast<uint32_t>(lights.size()));
+}
+
+const std::vector<LightCluster>& ClusteredLightCuller::GetClusters()
+{
+	return mClusters;
+}
+const std::vector<uint32_t>& ClusteredLightCuller::GetLightIndices()
+{
+	return mLightIndices;
+}
+ClusterConstant ClusteredLightCuller::GetClusterConstant()
+{
+	ClusterConstant clusterConstant;
+	clusterConstant.clusterCountX = mClusterCountX;
+	clusterConstant.clusterCountY = mClusterCountY;
+	clusterConstant.clusterCountZ = mClusterCountZ;
+	clusterConstant.depthScale = mDepthScale;
+	clusterConstant.tileScaleX = static_cast<float>(mClusterCountX) / mViewportWidth;
+	clusterConstant.tileScaleY = static_cast<float>(mClusterCountY) / mViewportHeight;
+	clusterConstant.depthBias = mDepthBias;
+	clusterConstant.pad0 = 0.0f;
+	return clusterConstant;
+}
+
+uint32_t ClusteredLightCuller::GetClusterIndex(uint32_t x, uint32_t y, uint32_t z)
+{
+	return (z * mClusterCountY + y) * mClusterCountX + x;
+}
+uint32_t ClusteredLightCuller::GetClusterCount()
+{
+	return mClusterCountX * mClusterCountY * mClusterCountZ;
+}
+BoundingBox ClusteredLightCuller::GetClusterBounds(uint32_t cluster)
+{
+	uint32_t x = cluster % mClusterCountX;
+	uint32_t row = cluster / mClusterCountX; // z * mClusterCountY + y
+	const ClusterGroup& group = mGroups[row * mGroupsPerRow + x / 4];
+	uint32_t lane = x % 4;
+
+	XMFLOAT3 minimum((&group.minX.x)[lane], (&group.minY.x)[lane], (&group.minZ.x)[lane]);
+	XMFLOAT3 maximum((&group.maxX.x)[lane], (&group.maxY.x)[lane], (&group.maxZ.x)[lane]);
+
+	BoundingBox bounds;
+	BoundingBox::CreateFromPoints(bounds, XMLoadFloat3(&minimum), XMLoadFloat3(&maximum));
+	return bounds;
+}
+
+ClusteredLightCullerStatistics ClusteredLightCuller::GetStatistics()
+{
+	return mStatistics;
+}
+
+float ClusteredLightCuller::GetSpotCosAngle(float spotPower)
+{
+	// pow(cos, spotPower) = spotCutoff
+	return std::pow(spotCutoff, 1.0f / spotPower);
+}
+
+void ClusteredLightCuller::BuildClusters(Camera& camera)
+{
+	const XMFLOAT4X4& proj = camera.GetProj();
+	float projScaleX = proj(0, 0);
+	float projScaleY = proj(1, 1);
+	float nearZ = camera.GetNearZ();
+	float farZ = camera.GetFarZ();
+
+	if (projScaleX == mProjScaleX && projScaleY == mProjScaleY && nearZ == mNearZ && farZ == mFarZ)
+		return;
+
+	assert(nearZ > 0.0f && farZ > nearZ);
+
+	mProjScaleX = projScaleX;
+	mProjScaleY = projScaleY;
+	mNearZ = nearZ;
+	mFarZ = farZ;
+
+	// slice = log(viewZ) * depthScale + depthBias, slice 0 starts at the near plane.
+	mDepthScale = mClusterCountZ / std::log(farZ / nearZ);
+	mDepthBias = -std::log(nearZ) * mDepthScale;
+
+	for (uint32_t z = 0; z < mClusterCountZ; z++)
+	{
+		float sliceNear = std::exp((z - mDepthBias) / mDepthScale);
+		float sliceFar = std::exp((z + 1 - mDepthBias) / mDepthScale);
+		if (z == 0)
+			sliceNear = nearZ;
+		if (z == mClusterCountZ - 1)
+			sliceFar = farZ;
+
+		for (uint32_t y = 0; y < mClusterCountY; y++)
+		{
+			float top = 1.0f - 2.0f * y / mClusterCountY;
+			float bottom = 1.0f - 2.0f * (y + 1) / mClusterCountY;
+
+			for (uint32_t x = 0; x < mGroupsPerRow * 4; x++)
+			{
+				// Lanes past the last column repeat it, AssignSlice never reports them.
+				uint32_t column = std::min(x, mClusterCountX - 1);
+				float left = -1.0f + 2.0f * column / mClusterCountX;
+				float right = -1.0f + 2.0f * (column + 1) / mClusterCountX;
+
+				// View space x = ndc * viewZ / projScale, the extremes are at the slice planes.
+				XMFLOAT3 minimum(
+					std::min(left * sliceNear, left * sliceFar) / projScaleX,
+					std::min(bottom * sliceNear, bottom * sliceFar) / projScaleY,
+					sliceNear);
+				XMFLOAT3 maximum(
+					std::max(right * sliceNear, right * sliceFar) / projScaleX,
+					std::max(top * sliceNear, top * sliceFar) / projScaleY,
+					sliceFar);
+
+				ClusterGroup& group = mGroups[(z * mClusterCountY + y) * mGroupsPerRow + x / 4];
+				uint32_t lane = x % 4;
+
+				SetLane(group.minX, lane, minimum.x);
+				SetLane(group.minY, lane, minimum.y);
+				SetLane(group.minZ, lane, minimum.z);
+				SetLane(group.maxX, lane, maximum.x);
+				SetLane(group.maxY, lane, maximum.y);
+				SetLane(group.maxZ, lane, maximum.z);
+
+				float extentX = 0.5f * (maximum.x - minimum.x);
+				float extentY = 0.5f * (maximum.y - minimum.y);
+				float extentZ = 0.5f * (maximum.z - minimum.z);
+				SetLane(group.centerX, lane, minimum.x + extentX);
+				SetLane(group.centerY, lane, minimum.y + extentY);
+				SetLane(group.centerZ, lane, minimum.z + extentZ);
+				SetLane(group.radius, lane, std::sqrt(extentX * extentX + extentY * extentY + extentZ * extentZ));
+			}
+		}
+	}
+}
+
+bool ClusteredLightCuller::SetupLight(const Light& light, const XMFLOAT4X4& view, ViewLight& viewLight)
+{
+	XMMATRIX viewMatrix = XMLoadFloat4x4(&view);
+
+	XMVECTOR position = XMVector3TransformCoord(XMLoadFloat3(&light.position), viewMatrix);
+	XMStoreFloat3(&viewLight.position, position);
+	viewLight.range = light.falloffEnd;
+	viewLight.spot = light.spotPower > 0.0f;
+	viewLight.cosAngle = 0.0f;
+	viewLight.sinAngle = 1.0f;
+
+	// Bounding sphere of the light volume, for the cluster range.
+	XMFLOAT3 center = viewLight.position;
+	float radius = viewLight.range;
+
+	if (viewLight.spot)
+	{
+		XMVECTOR direction = XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&light.direction), viewMatrix));
+		XMStoreFloat3(&viewLight.direction, direction);
+		viewLight.cosAngle = GetSpotCosAngle(light.spotPower);
+		viewLight.sinAngle = std::sqrt(std::max(1.0f - viewLight.cosAngle * viewLight.cosAngle, 0.0f));
+
+		// Smallest sphere around the cone, through the apex and the rim up to a 45 degree half angle.
+		float centerDistance;
+		if (viewLight.cosAngle > XMScalarCos(XM_PIDIV4))
+		{
+			centerDistance = 0.5f * viewLight.range / viewLight.cosAngle;
+			radius = centerDistance;
+		}
+		else
+		{
+			centerDistance = viewLight.range * viewLight.cosAngle;
+			radius = viewLight.range * viewLight.sinAngle;
+		}
+		XMStoreFloat3(&center, XMVectorMultiplyAdd(XMVectorReplicate(centerDistance), direction, position));
+	}
+	else
+	{
+		viewLight.direction = XMFLOAT3(0.0f, 0.0f, 1.0f);
+	}
+
+	float minZ = center.z - radius;
+	float maxZ = center.z + radius;
+	if (maxZ < mNearZ || minZ > mFarZ || !(radius > 0.0f))
+		return false;
+
+	minZ = std::max(minZ, mNearZ);
+	maxZ = std::min(maxZ, mFarZ);
+
+	// x / viewZ over the box around the sphere, the extremes are at its nearest and farthest depth.
+	float left = std::min((center.x - radius) / minZ, (center.x - radius) / maxZ) * mProjScaleX;
+	float right = std::max((center.x + radius) / minZ, (center.x + radius) / maxZ) * mProjScaleX;
+	float bottom = std::min((center.y - radius) / minZ, (center.y - radius) / maxZ) * mProjScaleY;
+	float top = std::max((center.y + radius) / minZ, (center.y + radius) / maxZ) * mProjScaleY;
+	if (right < -1.0f || left > 1.0f || top < -1.0f || bottom > 1.0f)
+		return false;
+
+	viewLight.minX = ClampToCluster((left + 1.0f) * 0.5f * mClusterCountX, mClusterCountX);
+	viewLight.maxX = ClampToCluster((right + 1.0f) * 0.5f * mClusterCountX, mClusterCountX);
+	viewLight.minY = ClampToCluster((1.0f - top) * 0.5f * mClusterCountY, mClusterCountY);
+	viewLight.maxY = ClampToCluster((1.0f - bottom) * 0.5f * mClusterCountY, mClusterCountY);
+	viewLight.minZ = GetSlice(minZ);
+	viewLight.maxZ = GetSlice(maxZ);
+
+	return true;
+}
+
+uint32_t ClusteredLightCuller::GetSlice(float viewZ)
+{
+	return ClampToCluster(std::log(viewZ) * mDepthScale + mDepthBias, mClusterCountZ);
+}
+
+void ClusteredLightCuller::AssignSlice(uint32_t slice)
+{
+	auto& hits = mSliceHits[slice];
+	hits.clear();
+
+	for (const auto& light : mViewLights)
+	{
+		if (slice < light.minZ || slice > light.maxZ)
+			continue;
+
+		XMVECTOR positionX = XMVectorReplicate(light.position.x);
+		XMVECTOR positionY = XMVectorReplicate(light.position.y);
+		XMVECTOR positionZ = XMVectorReplicate(light.position.z);
+		XMVECTOR range = XMVectorReplicate(light.range);
+		XMVECTOR rangeSquared = XMVectorMultiply(range, range);
+
+		XMVECTOR directionX = XMVectorReplicate(light.direction.x);
+		XMVECTOR directionY = XMVectorReplicate(light.direction.y);
+		XMVECTOR directionZ = XMVectorReplicate(light.direction.z);
+		XMVECTOR cosAngle = XMVectorReplicate(light.cosAngle);
+		XMVECTOR sinAngle = XMVectorReplicate(light.sinAngle);
+
+		for (uint32_t y = light.minY; y <= light.maxY; y++)
+		{
+			const ClusterGroup* row = &mGroups[(slice * mClusterCountY + y) * mGroupsPerRow];
+
+			for (uint32_t groupIndex = light.minX / 4; groupIndex <= light.maxX / 4; groupIndex++)
+			{
+				const ClusterGroup& group = row[groupIndex];
+
+				// Sphere against box, squared distance from the light to the box.
+				XMVECTOR distanceX = XMVectorMax(XMVectorSubtract(XMLoadFloat4(&group.minX), positionX),
+					XMVectorSubtract(positionX, XMLoadFloat4(&group.maxX)));
+				XMVECTOR distanceY = XMVectorMax(XMVectorSubtract(XMLoadFloat4(&group.minY), positionY),
+					XMVectorSubtract(positionY, XMLoadFloat4(&group.maxY)));
+				XMVECTOR distanceZ = XMVectorMax(XMVectorSubtract(XMLoadFloat4(&group.minZ), positionZ),
+					XMVectorSubtract(positionZ, XMLoadFloat4(&group.maxZ)));
+				distanceX = XMVectorMax(distanceX, XMVectorZero());
+				distanceY = XMVectorMax(distanceY, XMVectorZero());
+				distanceZ = XMVectorMax(distanceZ, XMVectorZero());
+
+				XMVECTOR distanceSquared = XMVectorMultiply(distanceX, distanceX);
+				distanceSquared = XMVectorMultiplyAdd(distanceY, distanceY, distanceSquared);
+				distanceSquared = XMVectorMultiplyAdd(distanceZ, distanceZ, distanceSquared);
+				XMVECTOR inside = XMVectorLessOrEqual(distanceSquared, rangeSquared);
+
+				if (light.spot)
+				{
+					// Cone against the cluster bounding sphere: closest distance from the sphere center
+					// to the cone surface, and the caps in front of and behind the apex.
+					XMVECTOR radius = XMLoadFloat4(&group.radius);
+					XMVECTOR toCenterX = XMVectorSubtract(XMLoadFloat4(&group.centerX), positionX);
+					XMVECTOR toCenterY = XMVectorSubtract(XMLoadFloat4(&group.centerY), positionY);
+					XMVECTOR toCenterZ = XMVectorSubtract(XMLoadFloat4(&group.centerZ), positionZ);
+
+					XMVECTOR lengthSquared = XMVectorMultiply(toCenterX, toCenterX);
+					lengthSquared = XMVectorMultiplyAdd(toCenterY, toCenterY, lengthSquared);
+					lengthSquared = XMVectorMultiplyAdd(toCenterZ, toCenterZ, lengthSquared);
+
+					XMVECTOR alongAxis = XMVectorMultiply(toCenterX, directionX);
+					alongAxis = XMVectorMultiplyAdd(toCenterY, directionY, alongAxis);
+					alongAxis = XMVectorMultiplyAdd(toCenterZ, directionZ, alongAxis);
+
+					XMVECTOR fromAxis = XMVectorSqrt(XMVectorMax(
+						XMVectorSubtract(lengthSquared, XMVectorMultiply(alongAxis, alongAxis)), XMVectorZero()));
+					XMVECTOR coneDistance = XMVectorSubtract(XMVectorMultiply(cosAngle, fromAxis),
+						XMVectorMultiply(alongAxis, sinAngle));
+
+					XMVECTOR outside = XMVectorGreater(coneDistance, radius);
+					outside = XMVectorOrInt(outside, XMVectorGreater(alongAxis, XMVectorAdd(range, radius)));
+					outside = XMVectorOrInt(outside, XMVectorLess(alongAxis, XMVectorNegate(radius)));
+					inside = XMVectorAndCInt(inside, outside);
+				}
+
+				uint32_t mask[4];
+				XMStoreInt4(mask, inside);
+
+				uint32_t firstColumn = std::max(groupIndex * 4, light.minX);
+				uint32_t lastColumn = std::min(groupIndex * 4 + 3, light.maxX);
+				for (uint32_t column = firstColumn; column <= lastColumn; column++)
+				{
+					if (mask[column % 4] != 0)
+						hits.push_back({ y * mClusterCountX + column, light.index });
+				}
+			}
+		}
+	}
+
+	// Counting sort by cluster, lights stay in ascending order within a cluster.
+	LightCluster* clusters = &mClusters[slice * mClusterCountX * mClusterCountY];
+	uint32_t clustersPerSlice = mClusterCountX * mClusterCountY;
+	for (uint32_t i = 0; i < clustersPerSlice; i++)
+		clusters[i] = LightCluster{ 0, 0 };
+	for (const auto& hit : hits)
+		clusters[hit.cluster].count++;
+
+	uint32_t offset = 0;
+	for (uint32_t i = 0; i < clustersPerSlice; i++)
+	{
+		clusters[i].offset = offset;
+		offset += clusters[i].count;
+		clusters[i].count = 0;
+	}
+
+	auto& sliceIndices = mSliceIndices[slice];
+	sliceIndices.resize(hits.size());
+	for (const auto& hit : hits)
+	{
+		LightCluster& cluster = clusters[hit.cluster];
+		sliceIndices[cluster.offset + cluster.count] = hit.light;
+		cluster.count++;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "../includes/D3D12GeometryCopyQueue.h"
+#include "../includes/D3D12MemoryAllocator.h"
+
+D3D12GeometryCopyQueue::D3D12GeometryCopyQueue(ID3D12Device* device, ID3D12CommandQueue* commandQueue, UINT64 stagingSize)
+	: mDevice(device), mCommandQueue(commandQueue), mStagingSize(stagingSize)
+{
+	mCommandListType = commandQueue->GetDesc().Type;
+
+	mStagingBuffer = D3D12MemoryAllocator::GetDefault(device).CreateBuffer(D3D12_HEAP_TYPE_UPLOAD,
+		stagingSize, D3D12_RESOURCE_STATE_GENERIC_READ);
+
+	ThrowIfFailed(mStagingBuffer->Map(0, nullptr, reinterpret_cast<void**>(&mStagingData)));
+
+	ThrowIfFailed(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&mFence)));
+}
+D3D12GeometryCopyQueue::~D3D12GeometryCopyQueue()
+{
+	if (mRecordingAllocator != nullptr)
+		Submit();
+	WaitForFenceValue(mFenceValue);
+
+	if (mStagingData != nullptr)
+		mStagingBuffer->Unmap(0, nullptr);
+	mStagingData = nullptr;
+}
+
+uint64_t D3D12GeometryCopyQueue::GetStagingSize()
+{
+	return mStagingSize;
+}
+uint8_t* D3D12GeometryCopyQueue::GetStagingData()
+{
+	return mStagingData;
+}
+
+void D3D12GeometryCopyQueue::RecordCopies(const GeometryCopy* copies, uint32_t count)
+{
+	if (mRecordingAllocator == nullptr)
+	{
+		if (!mSubmittedAllocators.empty() && mSubmittedAllocators.front().fenceValue <= mFence->GetCompletedValue())
+		{
+			mRecordingAllocator = mSubmittedAllocators.front().allocator;
+			mSubmittedAllocators.pop_front();
+			ThrowIfFailed(mRecordingAllocator->Reset());
+		}
+		else
+		{
+			ThrowIfFailed(mDevice->CreateCommandAllocator(mCommandListType, IID_PPV_ARGS(&mRecordingAllocator)));
+		}
+
+		if (mCommandList == nullptr)
+			ThrowIfFailed(mDevice->CreateCommandList(0, mCommandListType, mRecordingAllocator.Get(), nullptr,
+				IID_PPV_ARGS(&mCommandList)));
+		else
+			ThrowIfFailed(mCommandList->Reset(mRecordingAllocator.Get(), nullptr));
+	}
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		mCommandList->CopyBufferRegion(static_cast<ID3D12Resource*>(copies[i].destination), copies[i].destinationOffset,
+			mStagingBuffer.Get(), copies[i].stagingOffset, copies[i].byteSize);
+	}
+}
+uint64_t D3D12GeometryCopyQueue::Submit()
+{
+	if (mRecordingAllocator == nullptr)
+		return mFenceValue;
+
+	ThrowIfFailed(mCommandList->Close());
+	ID3D12CommandList* commandLists[] = { mCommandList.Get() };
+	mCommandQueue->ExecuteCommandLists(_countof(commandLists), commandLists);
+
+	mFenceValue++;
+	ThrowIfFailed(mCommandQueue->Signal(mFence.Get(), mFenceValue));
+
+	mSubmittedAllocators.push_back({ mRecordingAllocator, mFenceValue });
+	mRecordingAllocator = nullptr;
+
+	return mFenceValue;
+}
+uint64_t D3D12GeometryCopyQueue::GetCompletedFenceValue()
+{
+	return mFence->GetCompletedValue();
+}
+void D3D12GeometryCopyQueue::WaitForFenceValue(uint64_t fenceValue)
+{
+	if (mFence->GetCompletedValue() < fenceValue)
+	{
+		HANDLE eventHandle = CreateEventEx(nullptr, false, false, EVENT_ALL_ACCESS);
+		ThrowIfFailed(mFence->SetEventOnCompletion(fenceValue, eventHandle));
+		WaitForSingleObject(eventHandle, INFINITE);
+		CloseHandle(eventHandle);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include "../includes/D3D12MemoryAllocator.h"
+
+namespace
+{
+	// Private data of a placed resource, frees its allocation when the resource releases it.
+	const GUID allocationGuid = { 0x5c1e0b7a, 0x3d2f, 0x4b8e, { 0x9a, 0x61, 0x2e, 0x7f, 0x40, 0xd3, 0x8c, 0x15 } };
+
+	template <typename State>
+	class AllocationOwner : public IUnknown
+	{
+	public:
+		AllocationOwner(const std::shared_ptr<State>& state, const GpuAllocation& allocation)
+			: mState(state), mAllocation(allocation)
+		{ }
+
+		HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object) override
+		{
+			if (riid == __uuidof(IUnknown))
+			{
+				*object = static_cast<IUnknown*>(this);
+				AddRef();
+				return S_OK;
+			}
+
+			*object = nullptr;
+			return E_NOINTERFACE;
+		}
+		ULONG STDMETHODCALLTYPE AddRef() override
+		{
+			return ++mRefCount;
+		}
+		ULONG STDMETHODCALLTYPE Release() override
+		{
+			ULONG refCount = --mRefCount;
+			if (refCount == 0)
+			{
+				mState->allocator.Free(mAllocation);
+				delete this;
+			}
+			return refCount;
+		}
+	private:
+		std::atomic<ULONG> mRefCount{ 1 };
+		std::shared_ptr<State> mState;
+		GpuAllocation mAllocation;
+	};
+}
+
+D3D12HeapFactory::D3D12HeapFactory(ID3D12Device* device)
+	: mDevice(device)
+{
+
+}
+
+void* D3D12HeapFactory::CreateHeap(GpuHeapType heapType, GpuResourceClass resourceClass, uint64_t byteSize, uint64_t alignment)
+{
+	const D3D12_HEAP_TYPE heapTypes[] = { D3D12_HEAP_TYPE_DEFAULT, D3D12_HEAP_TYPE_UPLOAD, D3D12_HEAP_TYPE_READBACK };
+	const D3D12_HEAP_FLAGS heapFlags[] =
+	{
+		D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS,
+		D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES,
+		D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES
+	};
+
+	D3D12_HEAP_DESC heapDesc;
+	heapDesc.SizeInBytes = byteSize;
+	heapDesc.Properties = CD3DX12_HEAP_PROPERTIES(heapTypes[static_cast<int>(heapType)]);
+	// 4 KB placement only needs the heap's 64 KB default alignment.
+	heapDesc.Alignment = alignment == GpuMemoryAllocator::msaaAlignment ?
+		D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	heapDesc.Flags = heapFlags[static_cast<int>(resourceClass)];
+
+	ID3D12Heap* heap = nullptr;
+	ThrowIfFailed(mDevice->CreateHeap(&heapDesc, IID_PPV_ARGS(&heap)));
+	return heap;
+}
+void D3D12HeapFactory::DestroyHeap(void* heap)
+{
+	static_cast<ID3D12Heap*>(heap)->Release();
+}
+
+D3D12MemoryAllocator::D3D12MemoryAllocator(ID3D12Device* device)
+	: mDevice(device), mState(std::make_shared<State>(device))
+{
+
+}
+
+D3D12MemoryAllocator& D3D12MemoryAllocator::GetDefault(ID3D12Device* device)
+{
+	static D3D12MemoryAllocator allocator(device);
+	assert(allocator.mDevice == device);
+	return allocator;
+}
+
+Microsoft::WRL::ComPtr<ID3D12Resource> D3D12MemoryAllocator::CreateResource(
+	D3D12_HEAP_TYPE heapType,
+	const D3D12_RESOURCE_DESC& resourceDesc,
+	D3D12_RESOURCE_STATES initialState,
+	const D3D12_CLEAR_VALUE* optimizedClearValue)
+{
+	D3D12_RESOURCE_DESC desc = resourceDesc;
+
+	GpuResourceClass resourceClass = GpuResourceClass::Buffer;
+	if (desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER)
+	{
+		bool isRenderTarget = (desc.Flags &
+			(D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) != 0;
+		resourceClass = isRenderTarget ? GpuResourceClass::RenderTargetTexture : GpuResourceClass::Texture;
+	}
+
+	// Small textures may be placed at 4 KB, the device says whether this one is small enough.
+	D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = {};
+	bool isSmall = false;
+	if (resourceClass == GpuResourceClass::Texture && desc.SampleDesc.Count == 1)
+	{
+		desc.Alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+		allocationInfo = mDevice->GetResourceAllocationInfo(0, 1, &desc);
+		isSmall = allocationInfo.Alignment == D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+	}
+	if (!isSmall)
+	{
+		desc.Alignment = 0;
+		allocationInfo = mDevice->GetResourceAllocationInfo(0, 1, &desc);
+	}
+
+	GpuAllocation allocation = mState->allocator.Allocate(ToGpuHeapType(heapType), resourceClass,
+		allocationInfo.SizeInBytes, allocationInfo.Alignment);
+	if (!allocation.IsValid())
+		throw std::runtime_error("GPU memory budget exceeded by a resource of " +
+			std::to_string(allocationInfo.SizeInBytes) + " bytes.");
+
+	Microsoft::WRL::ComPtr<ID3D12Resource> resource = nullptr;
+	HRESULT hr = mDevice->CreatePlacedResource(static_cast<ID3D12Heap*>(allocation.heap), allocation.offset,
+		&desc, initialState, optimizedClearValue, IID_PPV_ARGS(&resource));
+	if (FAILED(hr))
+		mState->allocator.Free(allocation);
+	ThrowIfFailed(hr);
+
+	auto owner = new AllocationOwner<State>(mState, allocation);
+	hr = resource->SetPrivateDataInterface(allocationGuid, owner);
+	owner->Release(); // the resource holds the only reference now, or none when hr failed
+	ThrowIfFailed(hr);
+
+	return resource;
+}
+Microsoft::WRL::ComPtr<ID3D12Resource> D3D12MemoryAllocator::CreateBuffer(
+	D3D12_HEAP_TYPE heapType,
+	UINT64 byteSize,
+	D3D12_RESOURCE_STATES initialState,
+	D3D12_RESOURCE_FLAGS flags)
+{
+	return CreateResource(heapType, CD3DX12_RESOURCE_DESC::Buffer(byteSize, flags), initialState);
+}
+
+void D3D12MemoryAllocator::SetBudgetsFromAdapter()
+{
+	Microsoft::WRL::ComPtr<IDXGIFactory4> factory = nullptr;
+	ThrowIfFailed(CreateDXGIFactory1(IID_PPV_ARGS(&factory)));
+
+	Microsoft::WRL::ComPtr<IDXGIAdapter3> adapter = nullptr;
+	ThrowIfFailed(factory->EnumAdapterByLuid(mDevice->GetAdapterLuid(), IID_PPV_ARGS(&adapter)));
+
+	DXGI_QUERY_VIDEO_MEMORY_INFO localInfo;
+	DXGI_QUERY_VIDEO_MEMORY_INFO nonLocalInfo;
+	ThrowIfFailed(adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &localInfo));
+	ThrowIfFailed(adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL, &nonLocalInfo));
+
+	D3D12_FEATURE_DATA_ARCHITECTURE architecture = {};
+	ThrowIfFailed(mDevice->CheckFeatureSupport(D3D12_FEATURE_ARCHITECTURE, &architecture, sizeof(architecture)));
+	UINT64 systemMemoryBudget = architecture.UMA ? localInfo.Budget : nonLocalInfo.Budget;
+
+	mState->allocator.SetBudget(GpuHeapType::Default, localInfo.Budget);
+	mState->allocator.SetBudget(GpuHeapType::Upload, systemMemoryBudget);
+	mState->allocator.SetBudget(GpuHeapType::Readback, systemMemoryBudget);
+}
+void D3D12MemoryAllocator::SetBudget(D3D12_HEAP_TYPE heapType, UINT64 budgetBytes)
+{
+	mState->allocator.SetBudget(ToGpuHeapType(heapType), budgetBytes);
+}
+void D3D12MemoryAllocator::SetHeapSize(D3D12_HEAP_TYPE heapType, UINT64 heapSize)
+{
+	mState->allocator.SetHeapSize(ToGpuHeapType(heapType), heapSize);
+}
+GpuMemoryStatistics D3D12MemoryAllocator::GetStatistics()
+{
+	return mState->allocator.GetStatistics();
+}
+
+GpuHeapType D3D12MemoryAllocator::ToGpuHeapType(D3D12_HEAP_TYPE heapType)
+{
+	switch (heapType)
+	{
+	case D3D12_HEAP_TYPE_DEFAULT:
+		return GpuHeapType::Default;
+	case D3D12_HEAP_TYPE_UPLOAD:
+		return GpuHeapType::Upload;
+	case D3D12_HEAP_TYPE_READBACK:
+		return GpuHeapType::Readback;
+	default:
+		throw std::runtime_error("Custom heaps aren't supported by D3D12MemoryAllocator.");
+	}
+}
\ No newline at end of file
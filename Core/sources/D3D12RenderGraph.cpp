@@ -0,0 +1,190 @@
+#include "../includes/D3D12RenderGraph.h"
+
+namespace
+{
+	GpuResourceClass GetResourceClass(const D3D12_RESOURCE_DESC& resourceDesc)
+	{
+		if (resourceDesc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+			return GpuResourceClass::Buffer;
+
+		bool isRenderTarget = (resourceDesc.Flags &
+			(D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) != 0;
+		return isRenderTarget ? GpuResourceClass::RenderTargetTexture : GpuResourceClass::Texture;
+	}
+
+	// Placed resources come with undefined contents, the states a pass can start writing them in
+	// get discarded first.
+	bool IsDiscardableState(RenderGraphState state)
+	{
+		return state == RenderGraphState::RenderTarget || state == RenderGraphState::DepthWrite ||
+			state == RenderGraphState::UnorderedAccess;
+	}
+}
+
+D3D12RenderGraphBackend::D3D12RenderGraphBackend(ID3D12Device* device)
+	: mDevice(device), mHeapFactory(device)
+{
+
+}
+D3D12RenderGraphBackend::~D3D12RenderGraphBackend()
+{
+	ReleaseTransientResources();
+}
+
+uint32_t D3D12RenderGraphBackend::CreateTexture(RenderGraph& renderGraph, const char* name,
+	const D3D12_RESOURCE_DESC& resourceDesc)
+{
+	D3D12_RESOURCE_DESC desc = resourceDesc;
+	desc.Alignment = 0;
+	D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = mDevice->GetResourceAllocationInfo(0, 1, &desc);
+
+	uint32_t resource = renderGraph.CreateTransient(name, allocationInfo.SizeInBytes, allocationInfo.Alignment,
+		static_cast<uint32_t>(GetResourceClass(desc)));
+
+	if (mResourceDescs.size() <= resource)
+		ResizeResourceArrays(resource + 1);
+	mResourceDescs[resource] = desc;
+
+	return resource;
+}
+void D3D12RenderGraphBackend::CreateTransientResources(RenderGraph& renderGraph)
+{
+	ReleaseTransientResources();
+
+	uint32_t resourceCount = renderGraph.GetResourceCount();
+	ResizeResourceArrays(resourceCount);
+
+	mHeaps.assign(renderGraph.GetHeapGroupCount(), nullptr);
+	for (uint32_t i = 0; i < mHeaps.size(); i++)
+	{
+		uint64_t heapSize = renderGraph.GetHeapSize(i);
+		if (heapSize == 0)
+			continue;
+
+		uint64_t alignment = renderGraph.GetHeapAlignment(i);
+		uint64_t heapAlignment = alignment > D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT ?
+			GpuMemoryAllocator::msaaAlignment : GpuMemoryAllocator::defaultAlignment;
+		heapSize = (heapSize + D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1) /
+			D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT * D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+
+		mHeaps[i] = mHeapFactory.CreateHeap(GpuHeapType::Default, static_cast<GpuResourceClass>(i),
+			heapSize, heapAlignment);
+	}
+
+	for (uint32_t i = 0; i < resourceCount; i++)
+	{
+		if (!renderGraph.IsTransient(i) || !renderGraph.IsResourceUsed(i))
+			continue;
+
+		auto heap = static_cast<ID3D12Heap*>(mHeaps[renderGraph.GetHeapGroup(i)]);
+		ThrowIfFailed(mDevice->CreatePlacedResource(heap, renderGraph.GetHeapOffset(i), &mResourceDescs[i],
+			ToResourceStates(renderGraph.GetInitialState(i)), nullptr, IID_PPV_ARGS(&mTransients[i])));
+		mResources[i] = mTransients[i].Get();
+		mNeedsDiscard[i] = true;
+	}
+}
+
+void D3D12RenderGraphBackend::SetImportedResource(uint32_t resource, ID3D12Resource* d3dResource)
+{
+	if (mResources.size() <= resource)
+		ResizeResourceArrays(resource + 1);
+	mResources[resource] = d3dResource;
+}
+ID3D12Resource* D3D12RenderGraphBackend::GetResource(uint32_t resource)
+{
+	return mResources[resource];
+}
+
+void D3D12RenderGraphBackend::SetCommandList(ID3D12GraphicsCommandList* commandList)
+{
+	mCommandList = commandList;
+}
+ID3D12GraphicsCommandList* D3D12RenderGraphBackend::GetCommandList()
+{
+	return mCommandList;
+}
+
+void D3D12RenderGraphBackend::RecordBarriers(const RenderGraphBarrier* barriers, uint32_t count)
+{
+	mBarriers.clear();
+	mDiscards.clear();
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const RenderGraphBarrier& barrier = barriers[i];
+		ID3D12Resource* resource = mResources[barrier.resource];
+
+		switch (barrier.type)
+		{
+		case RenderGraphBarrierType::Transition:
+			mBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource,
+				ToResourceStates(barrier.before), ToResourceStates(barrier.after)));
+			break;
+		case RenderGraphBarrierType::Aliasing:
+			mBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Aliasing(nullptr, resource));
+			mNeedsDiscard[barrier.resource] = true;
+			break;
+		case RenderGraphBarrierType::UnorderedAccess:
+			mBarriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(resource));
+			break;
+		}
+
+		if (mNeedsDiscard[barrier.resource] && barrier.type != RenderGraphBarrierType::Aliasing)
+		{
+			if (IsDiscardableState(barrier.after))
+				mDiscards.push_back(resource);
+			mNeedsDiscard[barrier.resource] = false;
+		}
+	}
+
+	mCommandList->ResourceBarrier(static_cast<UINT>(mBarriers.size()), mBarriers.data());
+	for (ID3D12Resource* resource : mDiscards)
+		mCommandList->DiscardResource(resource, nullptr);
+}
+
+D3D12_RESOURCE_STATES D3D12RenderGraphBackend::ToResourceStates(RenderGraphState state)
+{
+	uint32_t bits = static_cast<uint32_t>(state);
+
+	D3D12_RESOURCE_STATES states = D3D12_RESOURCE_STATE_COMMON;
+	if (bits & static_cast<uint32_t>(RenderGraphState::RenderTarget))
+		states |= D3D12_RESOURCE_STATE_RENDER_TARGET;
+	if (bits & static_cast<uint32_t>(RenderGraphState::DepthWrite))
+		states |= D3D12_RESOURCE_STATE_DEPTH_WRITE;
+	if (bits & static_cast<uint32_t>(RenderGraphState::DepthRead))
+		states |= D3D12_RESOURCE_STATE_DEPTH_READ;
+	if (bits & static_cast<uint32_t>(RenderGraphState::ShaderResource))
+		states |= D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+	if (bits & static_cast<uint32_t>(RenderGraphState::UnorderedAccess))
+		states |= D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+	if (bits & static_cast<uint32_t>(RenderGraphState::CopySource))
+		states |= D3D12_RESOURCE_STATE_COPY_SOURCE;
+	if (bits & static_cast<uint32_t>(RenderGraphState::CopyDest))
+		states |= D3D12_RESOURCE_STATE_COPY_DEST;
+	return states;
+}
+
+void D3D12RenderGraphBackend::ResizeResourceArrays(uint32_t resourceCount)
+{
+	mResourceDescs.resize(resourceCount);
+	mTransients.resize(resourceCount);
+	mResources.resize(resourceCount, nullptr);
+	mNeedsDiscard.resize(resourceCount, false);
+}
+void D3D12RenderGraphBackend::ReleaseTransientResources()
+{
+	for (size_t i = 0; i < mTransients.size(); i++)
+	{
+		if (mTransients[i] != nullptr)
+			mResources[i] = nullptr;
+		mTransients[i] = nullptr;
+	}
+	std::fill(mNeedsDiscard.begin(), mNeedsDiscard.end(), false);
+
+	for (void* heap : mHeaps)
+	{
+		if (heap != nullptr)
+			mHeapFactory.DestroyHeap(heap);
+	}
+	mHeaps.clear();
+}
\ No newline at end of file
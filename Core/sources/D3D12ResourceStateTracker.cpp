@@ -0,0 +1,147 @@
+#include "../includes/D3D12ResourceStateTracker.h"
+
+D3D12ResourceStateTracker::D3D12ResourceStateTracker()
+	: mTracker(GetStateRules())
+{
+
+}
+
+void D3D12ResourceStateTracker::RegisterResource(ID3D12Resource* resource, D3D12_RESOURCE_STATES state)
+{
+	// Simultaneous access textures promote and decay like buffers.
+	D3D12_RESOURCE_DESC desc = resource->GetDesc();
+	bool isBuffer = desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER ||
+		(desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_SIMULTANEOUS_ACCESS) != 0;
+
+	GlobalResourceStates::GetDefault().Register(resource, static_cast<uint32_t>(state), isBuffer);
+}
+void D3D12ResourceStateTracker::UnregisterResource(ID3D12Resource* resource)
+{
+	GlobalResourceStates::GetDefault().Unregister(resource);
+}
+ResourceStateRules D3D12ResourceStateTracker::GetStateRules()
+{
+	ResourceStateRules rules;
+	rules.commonState = D3D12_RESOURCE_STATE_COMMON;
+	rules.readStates = D3D12_RESOURCE_STATE_GENERIC_READ | D3D12_RESOURCE_STATE_DEPTH_READ |
+		D3D12_RESOURCE_STATE_RESOLVE_SOURCE;
+	rules.texturePromotionStates = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE |
+		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_COPY_DEST | D3D12_RESOURCE_STATE_COPY_SOURCE;
+	return rules;
+}
+
+void D3D12ResourceStateTracker::SetCommandList(ID3D12GraphicsCommandList* commandList)
+{
+	mCommandList = commandList;
+	mTracker.Reset();
+}
+ID3D12GraphicsCommandList* D3D12ResourceStateTracker::GetCommandList()
+{
+	return mCommandList;
+}
+
+void D3D12ResourceStateTracker::TransitionResource(ID3D12Resource* resource, D3D12_RESOURCE_STATES state)
+{
+	mTracker.TransitionResource(resource, static_cast<uint32_t>(state));
+}
+void D3D12ResourceStateTracker::UAVBarrier(ID3D12Resource* resource)
+{
+	mTracker.UAVBarrier(resource);
+}
+void D3D12ResourceStateTracker::FlushResourceBarriers()
+{
+	mTracker.FlushResourceBarriers(*this);
+}
+
+ResourceStateTracker& D3D12ResourceStateTracker::GetTracker()
+{
+	return mTracker;
+}
+
+void D3D12ResourceStateTracker::RecordBarriers(const ResourceBarrierDesc* barriers, uint32_t count)
+{
+	mBarriers.clear();
+	for (uint32_t i = 0; i < count; i++)
+	{
+		auto resource = static_cast<ID3D12Resource*>(barriers[i].resource);
+		if (barriers[i].type == ResourceBarrierType::UnorderedAccess)
+			mBarriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(resource));
+		else
+			mBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource,
+				static_cast<D3D12_RESOURCE_STATES>(barriers[i].before), static_cast<D3D12_RESOURCE_STATES>(barriers[i].after)));
+	}
+
+	mCommandList->ResourceBarrier(count, mBarriers.data());
+}
+
+D3D12ResourceStateSubmitter::D3D12ResourceStateSubmitter(ID3D12Device* device, ID3D12CommandQueue* commandQueue)
+	: mDevice(device), mCommandQueue(commandQueue)
+{
+	mCommandListType = commandQueue->GetDesc().Type;
+
+	ThrowIfFailed(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&mFence)));
+}
+D3D12ResourceStateSubmitter::~D3D12ResourceStateSubmitter()
+{
+	if (mFence->GetCompletedValue() < mFenceValue)
+	{
+		HANDLE eventHandle = CreateEventEx(nullptr, false, false, EVENT_ALL_ACCESS);
+		ThrowIfFailed(mFence->SetEventOnCompletion(mFenceValue, eventHandle));
+		WaitForSingleObject(eventHandle, INFINITE);
+		CloseHandle(eventHandle);
+	}
+}
+
+void D3D12ResourceStateSubmitter::ExecuteCommandList(D3D12ResourceStateTracker& stateTracker)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	auto commandList = stateTracker.GetCommandList();
+	ThrowIfFailed(commandList->Close());
+
+	mResolvedBarriers.clear();
+	stateTracker.GetTracker().Resolve(GlobalResourceStates::GetDefault(), mResolvedBarriers);
+
+	if (mResolvedBarriers.empty())
+	{
+		ID3D12CommandList* commandLists[] = { commandList };
+		mCommandQueue->ExecuteCommandLists(_countof(commandLists), commandLists);
+		return;
+	}
+
+	CommandAllocator allocator = nullptr;
+	if (!mSubmittedAllocators.empty() && mSubmittedAllocators.front().fenceValue <= mFence->GetCompletedValue())
+	{
+		allocator = mSubmittedAllocators.front().allocator;
+		mSubmittedAllocators.pop_front();
+		ThrowIfFailed(allocator->Reset());
+	}
+	else
+	{
+		ThrowIfFailed(mDevice->CreateCommandAllocator(mCommandListType, IID_PPV_ARGS(&allocator)));
+	}
+
+	if (mBarrierCommandList == nullptr)
+		ThrowIfFailed(mDevice->CreateCommandList(0, mCommandListType, allocator.Get(), nullptr,
+			IID_PPV_ARGS(&mBarrierCommandList)));
+	else
+		ThrowIfFailed(mBarrierCommandList->Reset(allocator.Get(), nullptr));
+
+	mBarrierList.SetCommandList(mBarrierCommandList.Get());
+	mBarrierList.RecordBarriers(mResolvedBarriers.data(), static_cast<uint32_t>(mResolvedBarriers.size()));
+	ThrowIfFailed(mBarrierCommandList->Close());
+
+	ID3D12CommandList* commandLists[] = { mBarrierCommandList.Get(), commandList };
+	mCommandQueue->ExecuteCommandLists(_countof(commandLists), commandLists);
+
+	mFenceValue++;
+	ThrowIfFailed(mCommandQueue->Signal(mFence.Get(), mFenceValue));
+
+	mSubmittedAllocators.push_back({ allocator, mFenceValue });
+	mBarrierListCount++;
+}
+
+uint32_t D3D12ResourceStateSubmitter::GetBarrierListCount()
+{
+	return mBarrierListCount;
+}
\ No newline at end of file
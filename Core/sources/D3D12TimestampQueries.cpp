@@ -0,0 +1,70 @@
+#include "../includes/D3D12TimestampQueries.h"
+#include "../includes/D3D12MemoryAllocator.h"
+
+D3D12TimestampQueries::D3D12TimestampQueries(ID3D12Device* device, ID3D12CommandQueue* commandQueue,
+	UINT frameSlotCount, UINT timestampCapacity)
+	: mFrameSlotCount(frameSlotCount), mTimestampCapacity(timestampCapacity)
+{
+	D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+	queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+	queryHeapDesc.Count = frameSlotCount * timestampCapacity;
+	queryHeapDesc.NodeMask = 0;
+	ThrowIfFailed(device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&mQueryHeap)));
+
+	mReadbackBuffer = D3D12MemoryAllocator::GetDefault(device).CreateBuffer(D3D12_HEAP_TYPE_READBACK,
+		sizeof(UINT64) * frameSlotCount * timestampCapacity, D3D12_RESOURCE_STATE_COPY_DEST);
+
+	ThrowIfFailed(commandQueue->GetTimestampFrequency(&mTimestampFrequency));
+}
+
+void D3D12TimestampQueries::SetCommandList(ID3D12GraphicsCommandList* commandList)
+{
+	mCommandList = commandList;
+}
+
+uint32_t D3D12TimestampQueries::GetTimestampCapacity()
+{
+	return mTimestampCapacity;
+}
+uint64_t D3D12TimestampQueries::GetTimestampFrequency()
+{
+	return mTimestampFrequency;
+}
+
+void D3D12TimestampQueries::WriteTimestamp(uint32_t slot, uint32_t index)
+{
+	assert(mCommandList != nullptr && slot < mFrameSlotCount && index < mTimestampCapacity);
+	mCommandList->EndQuery(mQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, slot * mTimestampCapacity + index);
+}
+void D3D12TimestampQueries::Resolve(uint32_t slot, uint32_t count)
+{
+	assert(mCommandList != nullptr && slot < mFrameSlotCount && count <= mTimestampCapacity);
+	mCommandList->ResolveQueryData(mQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP,
+		slot * mTimestampCapacity, count, mReadbackBuffer.Get(), sizeof(UINT64) * slot * mTimestampCapacity);
+}
+void D3D12TimestampQueries::ReadTimestamps(uint32_t slot, uint32_t count, uint64_t* timestamps)
+{
+	D3D12_RANGE readRange;
+	readRange.Begin = sizeof(UINT64) * slot * mTimestampCapacity;
+	readRange.End = readRange.Begin + sizeof(UINT64) * count;
+
+	void* mappedData = nullptr;
+	ThrowIfFailed(mReadbackBuffer->Map(0, &readRange, &mappedData));
+	memcpy(timestamps, static_cast<BYTE*>(mappedData) + readRange.Begin, sizeof(UINT64) * count);
+
+	D3D12_RANGE writtenRange = { 0, 0 };
+	mReadbackBuffer->Unmap(0, &writtenRange);
+}
+
+void D3D12TimestampQueries::BeginEvent(const char* name)
+{
+#if defined(USE_PIX)
+	PIXBeginEvent(mCommandList, PIX_COLOR_DEFAULT, name);
+#endif
+}
+void D3D12TimestampQueries::EndEvent()
+{
+#if defined(USE_PIX)
+	PIXEndEvent(mCommandList);
+#endif
+}
\ No newline at end of file
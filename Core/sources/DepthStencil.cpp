@@ -1,4 +1,5 @@
 #include "../includes/DepthStencil.h"
+#include "../includes/D3D12MemoryAllocator.h"
 
 void DepthStencil::CreateDepthStencilBuffer(ID3D12Device* device,
 	UINT width, UINT height,
@@ -19,16 +20,12 @@ void DepthStencil::CreateDepthStencilBuffer(ID3D12Device* device,
 
 	D3D12_CLEAR_VALUE optClear;
 	optClear.Format = mDepthStencilBufferFormat;
-	optClear.DepthStencil.Depth = 1.0f;
+	optClear.DepthStencil.Depth = GetClearDepth();
 	optClear.DepthStencil.Stencil = 0;
 
-	ThrowIfFailed(device->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-		D3D12_HEAP_FLAG_NONE,
-		&depthStencilBufferDesc,
-		D3D12_RESOURCE_STATE_DEPTH_WRITE,
-		&optClear,
-		IID_PPV_ARGS(&mDepthStencilBuffer)));
+	// Placed, the renderers clear it before the first draw, which initializes its memory.
+	mDepthStencilBuffer = D3D12MemoryAllocator::GetDefault(device).CreateResource(D3D12_HEAP_TYPE_DEFAULT,
+		depthStencilBufferDesc, D3D12_RESOURCE_STATE_DEPTH_WRITE, &optClear);
 }
 
 void DepthStencil::ResetDepthStencilBuffer()
@@ -36,6 +33,37 @@ void DepthStencil::ResetDepthStencilBuffer()
 	mDepthStencilBuffer.Reset();
 }
 
+void DepthStencil::SetReversedZ(bool reversedZ)
+{
+	mReversedZ = reversedZ;
+	mDepthStencilBufferFormat = reversedZ ? DXGI_FORMAT_D32_FLOAT_S8X24_UINT : DXGI_FORMAT_D24_UNORM_S8_UINT;
+}
+bool DepthStencil::IsReversedZ()
+{
+	return mReversedZ;
+}
+
+DepthMode DepthStencil::GetDepthMode()
+{
+	return mReversedZ ? DepthMode::Reversed : DepthMode::Standard;
+}
+float DepthStencil::GetClearDepth()
+{
+	return ::GetClearDepth(GetDepthMode());
+}
+D3D12_COMPARISON_FUNC DepthStencil::GetDepthFunc(bool orEqual)
+{
+	if (GetDepthComparison(GetDepthMode()) == DepthComparison::Greater)
+		return orEqual ? D3D12_COMPARISON_FUNC_GREATER_EQUAL : D3D12_COMPARISON_FUNC_GREATER;
+	return orEqual ? D3D12_COMPARISON_FUNC_LESS_EQUAL : D3D12_COMPARISON_FUNC_LESS;
+}
+D3D12_DEPTH_STENCIL_DESC DepthStencil::GetDepthStencilDesc(bool orEqual)
+{
+	D3D12_DEPTH_STENCIL_DESC depthStencilDesc = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
+	depthStencilDesc.DepthFunc = GetDepthFunc(orEqual);
+	return depthStencilDesc;
+}
+
 ID3D12Resource* DepthStencil::GetDepthStencilBuffer()
 {
 	return mDepthStencilBuffer.Get();
@@ -73,7 +73,7 @@ void DsvDescriptor::CreateDescriptorHeap(ID3D12Device* device, UINT descriptorCo
 }
 
 void DsvDescriptor::CreateDepthStencilView(ID3D12Device* device, UINT descriptorSize, DXGI_FORMAT viewFormat, 
-	D3D12_DSV_DIMENSION viewDimension, ID3D12Resource* resource)
+	D3D12_DSV_DIMENSION viewDimension, ID3D12Resource* resource, UINT arraySlice)
 {
 	D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc;
 	dsvDesc.Format = viewFormat;
@@ -85,6 +85,11 @@ void DsvDescriptor::CreateDepthStencilView(ID3D12Device* device, UINT descriptor
 	case D3D12_DSV_DIMENSION_TEXTURE2D:
 		dsvDesc.Texture2D.MipSlice = 0;
 		break;
+	case D3D12_DSV_DIMENSION_TEXTURE2DARRAY:
+		dsvDesc.Texture2DArray.MipSlice = 0;
+		dsvDesc.Texture2DArray.FirstArraySlice = arraySlice;
+		dsvDesc.Texture2DArray.ArraySize = 1;
+		break;
 	default:
 		throw std::runtime_error("Invalid resource dimension");
 		break;
@@ -147,6 +152,14 @@ void CbvSrvUavDescriptor::CreateShaderResourceView(ID3D12Device* device, UINT de
 		srvDesc.Texture2D.PlaneSlice = 0;
 		srvDesc.Texture2D.ResourceMinLODClamp = 0.0f;
 		break;
+	case D3D12_SRV_DIMENSION_TEXTURE2DARRAY:
+		srvDesc.Texture2DArray.MipLevels = resource->GetDesc().MipLevels;
+		srvDesc.Texture2DArray.MostDetailedMip = 0;
+		srvDesc.Texture2DArray.FirstArraySlice = 0;
+		srvDesc.Texture2DArray.ArraySize = resource->GetDesc().DepthOrArraySize;
+		srvDesc.Texture2DArray.PlaneSlice = 0;
+		srvDesc.Texture2DArray.ResourceMinLODClamp = 0.0f;
+		break;
 	case D3D12_SRV_DIMENSION_TEXTURECUBE:
 		if (resource)
 			srvDesc.TextureCube.MipLevels = resource->GetDesc().MipLevels;
@@ -0,0 +1,170 @@
+#include "../includes/FileWatcher.h"
+#include <sys/stat.h>
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#endif
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+std::unique_ptr<FileWatcher> FileWatcher::CreateDefault()
+{
+#if defined(__linux__)
+	return std::make_unique<InotifyFileWatcher>();
+#else
+	return std::make_unique<PollingFileWatcher>();
+#endif
+}
+
+void PollingFileWatcher::Watch(const std::string& filename)
+{
+	if (mFiles.find(filename) == mFiles.end())
+		mFiles.insert({ filename, GetFileState(filename) });
+}
+void PollingFileWatcher::Unwatch(const std::string& filename)
+{
+	mFiles.erase(filename);
+}
+
+void PollingFileWatcher::Poll(std::vector<std::string>& changedFiles)
+{
+	for (auto& file : mFiles)
+	{
+		FileState state = GetFileState(file.first);
+		if (state != file.second)
+		{
+			file.second = state;
+			changedFiles.push_back(file.first);
+		}
+	}
+}
+
+PollingFileWatcher::FileState PollingFileWatcher::GetFileState(const std::string& filename)
+{
+	// Whole seconds would miss two saves of the same size within a second.
+#if defined(_WIN32)
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesExA(filename.c_str(), GetFileExInfoStandard, &attributes))
+		return { false, 0, 0 };
+
+	int64_t writeTime = (static_cast<int64_t>(attributes.ftLastWriteTime.dwHighDateTime) << 32) |
+		attributes.ftLastWriteTime.dwLowDateTime; // 100 ns units
+	int64_t size = (static_cast<int64_t>(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+	return { true, writeTime * 100, size };
+#else
+	struct stat status;
+	if (stat(filename.c_str(), &status) != 0)
+		return { false, 0, 0 };
+
+#if defined(__APPLE__)
+	const timespec& writeTime = status.st_mtimespec;
+#else
+	const timespec& writeTime = status.st_mtim;
+#endif
+	return { true, static_cast<int64_t>(writeTime.tv_sec) * 1000000000 + writeTime.tv_nsec,
+		static_cast<int64_t>(status.st_size) };
+#endif
+}
+
+#if defined(__linux__)
+InotifyFileWatcher::InotifyFileWatcher()
+{
+	mFileDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (mFileDescriptor < 0)
+		throw std::runtime_error("inotify_init1 failed.");
+}
+InotifyFileWatcher::~InotifyFileWatcher()
+{
+	close(mFileDescriptor);
+}
+
+void InotifyFileWatcher::Watch(const std::string& filename)
+{
+	std::string directory;
+	std::string name;
+	SplitPath(filename, directory, name);
+
+	auto it = mDirectories.find(directory);
+	if (it == mDirectories.end())
+	{
+		int watchDescriptor = inotify_add_watch(mFileDescriptor, directory.c_str(),
+			IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE);
+		if (watchDescriptor < 0)
+			return;
+
+		it = mDirectories.insert({ directory, WatchedDirectory{ watchDescriptor, {} } }).first;
+		mWatchDescriptors[watchDescriptor] = directory;
+	}
+
+	it->second.files[name] = filename;
+}
+void InotifyFileWatcher::Unwatch(const std::string& filename)
+{
+	std::string directory;
+	std::string name;
+	SplitPath(filename, directory, name);
+
+	auto it = mDirectories.find(directory);
+	if (it == mDirectories.end())
+		return;
+
+	it->second.files.erase(name);
+	if (it->second.files.empty())
+	{
+		inotify_rm_watch(mFileDescriptor, it->second.watchDescriptor);
+		mWatchDescriptors.erase(it->second.watchDescriptor);
+		mDirectories.erase(it);
+	}
+}
+
+void InotifyFileWatcher::Poll(std::vector<std::string>& changedFiles)
+{
+	size_t firstChange = changedFiles.size();
+
+	alignas(inotify_event) char buffer[4096];
+	while (true)
+	{
+		ssize_t byteCount = read(mFileDescriptor, buffer, sizeof(buffer));
+		if (byteCount <= 0)
+			break; // EAGAIN, nothing left
+
+		for (ssize_t offset = 0; offset < byteCount; )
+		{
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+			offset += sizeof(inotify_event) + event->len;
+
+			auto directory = mWatchDescriptors.find(event->wd);
+			if (event->len == 0 || directory == mWatchDescriptors.end())
+				continue;
+
+			const auto& files = mDirectories[directory->second].files;
+			auto file = files.find(event->name);
+			if (file == files.end())
+				continue;
+
+			// A save usually produces several events.
+			if (std::find(changedFiles.begin() + firstChange, changedFiles.end(), file->second) == changedFiles.end())
+				changedFiles.push_back(file->second);
+		}
+	}
+}
+
+void InotifyFileWatcher::SplitPath(const std::string& filename, std::string& directory, std::string& name)
+{
+	size_t slash = filename.find_last_of("/\\");
+	if (slash == std::string::npos)
+	{
+		directory = ".";
+		name = filename;
+	}
+	else
+	{
+		directory = slash == 0 ? "/" : filename.substr(0, slash);
+		name = filename.substr(slash + 1);
+	}
+}
+#endif
\ No newline at end of file
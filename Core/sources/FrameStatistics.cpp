@@ -0,0 +1,157 @@
+#include "../includes/FrameStatistics.h"
+
+FrameStatistics::FrameStatistics()
+{
+	Reset();
+}
+
+void FrameStatistics::AddFrame(float deltaTime)
+{
+	// A NaN or infinite delta, e.g. from a timer that wasn't reset, would poison the window sum for good.
+	if (!std::isfinite(deltaTime))
+		return;
+
+	float milliseconds = std::max(deltaTime, 0.0f) * 1000.0f;
+
+	// Compare against the history before this frame is part of it.
+	mLastFrameHitch = mFrameCount > 0 &&
+		milliseconds > mHitchFactor * mSmoothedFrameTime && milliseconds > mBudgetMilliseconds;
+	if (mLastFrameHitch)
+	{
+		mHitchCount++;
+		mLastHitchFrame = mFrameCount;
+	}
+
+	if (milliseconds > mBudgetMilliseconds)
+		mOverBudgetFrameCount++;
+
+	if (mSampleCount == windowSize)
+	{
+		float evicted = mFrameTimes[mNextFrame];
+		mHistogram[GetBucket(evicted)]--;
+		mWindowSum -= evicted;
+	}
+	else
+	{
+		mSampleCount++;
+	}
+
+	mFrameTimes[mNextFrame] = milliseconds;
+	mHistogram[GetBucket(milliseconds)]++;
+	mWindowSum += milliseconds;
+	mNextFrame = (mNextFrame + 1) % windowSize;
+
+	mSmoothedFrameTime = mFrameCount == 0 ? milliseconds :
+		mSmoothedFrameTime + mSmoothingFactor * (milliseconds - mSmoothedFrameTime);
+
+	mFrameCount++;
+}
+void FrameStatistics::Reset()
+{
+	mFrameTimes.fill(0.0f);
+	mHistogram.fill(0);
+
+	mNextFrame = 0;
+	mSampleCount = 0;
+	mWindowSum = 0.0;
+	mSmoothedFrameTime = 0.0f;
+
+	mFrameCount = 0;
+	mOverBudgetFrameCount = 0;
+	mHitchCount = 0;
+	mLastHitchFrame = 0;
+	mLastFrameHitch = false;
+}
+
+float FrameStatistics::GetPercentile(float percentile)
+{
+	if (mSampleCount == 0)
+		return 0.0f;
+
+	std::copy(mFrameTimes.begin(), mFrameTimes.begin() + mSampleCount, mSortScratch.begin());
+
+	// Nearest rank.
+	float rank = std::min(std::max(percentile, 0.0f), 100.0f) / 100.0f * mSampleCount;
+	uint32_t index = std::min(static_cast<uint32_t>(std::ceil(rank)), mSampleCount);
+	index = index > 0 ? index - 1 : 0;
+
+	std::nth_element(mSortScratch.begin(), mSortScratch.begin() + index, mSortScratch.begin() + mSampleCount);
+	return mSortScratch[index];
+}
+FrameTimeSummary FrameStatistics::GetSummary()
+{
+	FrameTimeSummary summary;
+	if (mSampleCount == 0)
+		return summary;
+
+	// One sort instead of three selections.
+	std::copy(mFrameTimes.begin(), mFrameTimes.begin() + mSampleCount, mSortScratch.begin());
+	std::sort(mSortScratch.begin(), mSortScratch.begin() + mSampleCount);
+
+	auto nearestRank = [this](float percentile)
+	{
+		uint32_t index = static_cast<uint32_t>(std::ceil(percentile / 100.0f * mSampleCount));
+		return mSortScratch[std::max(std::min(index, mSampleCount), 1u) - 1];
+	};
+
+	summary.averageMilliseconds = static_cast<float>(mWindowSum / mSampleCount);
+	summary.minMilliseconds = mSortScratch[0];
+	summary.maxMilliseconds = mSortScratch[mSampleCount - 1];
+	summary.p50Milliseconds = nearestRank(50.0f);
+	summary.p95Milliseconds = nearestRank(95.0f);
+	summary.p99Milliseconds = nearestRank(99.0f);
+	summary.sampleCount = mSampleCount;
+
+	return summary;
+}
+
+float FrameStatistics::GetSmoothedFps()
+{
+	return mSmoothedFrameTime > 0.0f ? 1000.0f / mSmoothedFrameTime : 0.0f;
+}
+float FrameStatistics::GetSmoothedFrameTime()
+{
+	return mSmoothedFrameTime;
+}
+
+void FrameStatistics::SetHitchThreshold(float hitchFactor, float budgetMilliseconds)
+{
+	mHitchFactor = hitchFactor;
+	mBudgetMilliseconds = budgetMilliseconds;
+}
+uint64_t FrameStatistics::GetHitchCount()
+{
+	return mHitchCount;
+}
+uint64_t FrameStatistics::GetLastHitchFrame()
+{
+	return mLastHitchFrame;
+}
+bool FrameStatistics::IsLastFrameHitch()
+{
+	return mLastFrameHitch;
+}
+
+uint64_t FrameStatistics::GetFrameCount()
+{
+	return mFrameCount;
+}
+uint64_t FrameStatistics::GetOverBudgetFrameCount()
+{
+	return mOverBudgetFrameCount;
+}
+
+const std::array<uint32_t, FrameStatistics::histogramBucketCount>& FrameStatistics::GetHistogram()
+{
+	return mHistogram;
+}
+
+uint32_t FrameStatistics::GetBucket(float milliseconds)
+{
+	// The cast is only defined inside uint32_t's range, NaN and negative times go to the first bucket.
+	if (!(milliseconds > 0.0f))
+		return 0;
+	if (milliseconds >= static_cast<float>(histogramBucketCount - 1))
+		return histogramBucketCount - 1;
+	return static_cast<uint32_t>(milliseconds);
+}
\ No newline at end of file
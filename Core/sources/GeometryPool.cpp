@@ -0,0 +1,193 @@
+#include "../includes/GeometryPool.h"
+
+GeometryPool::GeometryPool(ID3D12Device* device, UINT vertexCapacity, UINT indexCapacity)
+	: mDevice(device), mVertexAllocator(vertexCapacity), mIndexAllocator(indexCapacity)
+{
+	CreateBuffers();
+}
+
+uint32_t GeometryPool::Add(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, GeometryUploader& uploader)
+{
+	assert(!vertices.empty() && !indices.empty());
+
+	UINT vertexCount = static_cast<UINT>(vertices.size());
+	UINT indexCount = static_cast<UINT>(indices.size());
+
+	UINT baseVertex = mVertexAllocator.Allocate(vertexCount);
+	if (baseVertex == TlsfAllocator::invalidOffset)
+		throw std::runtime_error("Geometry pool has no room for " + std::to_string(vertexCount) + " vertices.");
+
+	UINT startIndex = mIndexAllocator.Allocate(indexCount);
+	if (startIndex == TlsfAllocator::invalidOffset)
+	{
+		mVertexAllocator.Free(baseVertex);
+		throw std::runtime_error("Geometry pool has no room for " + std::to_string(indexCount) + " indices.");
+	}
+
+	uploader.Upload(mVertexBuffer.Get(), static_cast<uint64_t>(baseVertex) * sizeof(Vertex),
+		vertices.data(), static_cast<uint64_t>(vertexCount) * sizeof(Vertex));
+	uploader.Upload(mIndexBuffer.Get(), static_cast<uint64_t>(startIndex) * sizeof(uint32_t),
+		indices.data(), static_cast<uint64_t>(indexCount) * sizeof(uint32_t));
+
+	uint32_t handle;
+	if (!mFreeHandles.empty())
+	{
+		handle = mFreeHandles.back();
+		mFreeHandles.pop_back();
+	}
+	else
+	{
+		handle = static_cast<uint32_t>(mEntries.size());
+		mEntries.emplace_back();
+	}
+
+	mEntries[handle].range = { baseVertex, vertexCount, startIndex, indexCount };
+	mEntries[handle].isLive = true;
+	return handle;
+}
+void GeometryPool::Remove(uint32_t handle)
+{
+	assert(handle < mEntries.size() && mEntries[handle].isLive);
+
+	mVertexAllocator.Free(mEntries[handle].range.baseVertex);
+	mIndexAllocator.Free(mEntries[handle].range.startIndex);
+
+	mEntries[handle].isLive = false;
+	mFreeHandles.push_back(handle);
+}
+const GeometryRange& GeometryPool::GetRange(uint32_t handle)
+{
+	assert(handle < mEntries.size() && mEntries[handle].isLive);
+	return mEntries[handle].range;
+}
+
+ID3D12Resource* GeometryPool::GetVertexBuffer()
+{
+	return mVertexBuffer.Get();
+}
+D3D12_VERTEX_BUFFER_VIEW GeometryPool::GetVertexBufferView()
+{
+	D3D12_VERTEX_BUFFER_VIEW vertexBufferView;
+	vertexBufferView.BufferLocation = mVertexBuffer->GetGPUVirtualAddress();
+	vertexBufferView.SizeInBytes = mVertexAllocator.GetCapacity() * sizeof(Vertex);
+	vertexBufferView.StrideInBytes = sizeof(Vertex);
+	return vertexBufferView;
+}
+ID3D12Resource* GeometryPool::GetIndexBuffer()
+{
+	return mIndexBuffer.Get();
+}
+D3D12_INDEX_BUFFER_VIEW GeometryPool::GetIndexBufferView()
+{
+	D3D12_INDEX_BUFFER_VIEW indexBufferView;
+	indexBufferView.BufferLocation = mIndexBuffer->GetGPUVirtualAddress();
+	indexBufferView.SizeInBytes = mIndexAllocator.GetCapacity() * sizeof(uint32_t);
+	indexBufferView.Format = DXGI_FORMAT_R32_UINT;
+	return indexBufferView;
+}
+
+bool GeometryPool::Defragment(ID3D12GraphicsCommandList* commandList)
+{
+	UINT usedVertices = mVertexAllocator.GetStatistics().usedSize;
+	UINT usedIndices = mIndexAllocator.GetStatistics().usedSize;
+
+	std::vector<TlsfMove> vertexMoves;
+	std::vector<TlsfMove> indexMoves;
+	mVertexAllocator.Defragment(vertexMoves);
+	mIndexAllocator.Defragment(indexMoves);
+	if (vertexMoves.empty() && indexMoves.empty())
+		return false;
+
+	// Overlapping copies inside one buffer aren't allowed, the meshes go to new buffers instead.
+	mRetiredBuffers.push_back(mVertexBuffer);
+	mRetiredBuffers.push_back(mIndexBuffer);
+	CreateBuffers();
+
+	RecordCopies(commandList, mVertexBuffer.Get(), mRetiredBuffers[mRetiredBuffers.size() - 2].Get(),
+		vertexMoves, usedVertices, sizeof(Vertex));
+	RecordCopies(commandList, mIndexBuffer.Get(), mRetiredBuffers.back().Get(),
+		indexMoves, usedIndices, sizeof(uint32_t));
+
+	// The copies promoted the new buffers to the copy destination state.
+	D3D12_RESOURCE_BARRIER barriers[] =
+	{
+		CD3DX12_RESOURCE_BARRIER::Transition(mVertexBuffer.Get(),
+			D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER),
+		CD3DX12_RESOURCE_BARRIER::Transition(mIndexBuffer.Get(),
+			D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_INDEX_BUFFER)
+	};
+	commandList->ResourceBarrier(_countof(barriers), barriers);
+
+	std::unordered_map<uint32_t, uint32_t> newBaseVertices;
+	std::unordered_map<uint32_t, uint32_t> newStartIndices;
+	for (const auto& move : vertexMoves)
+		newBaseVertices[move.oldOffset] = move.newOffset;
+	for (const auto& move : indexMoves)
+		newStartIndices[move.oldOffset] = move.newOffset;
+
+	for (auto& entry : mEntries)
+	{
+		if (!entry.isLive)
+			continue;
+
+		auto baseVertex = newBaseVertices.find(entry.range.baseVertex);
+		if (baseVertex != newBaseVertices.end())
+			entry.range.baseVertex = baseVertex->second;
+		auto startIndex = newStartIndices.find(entry.range.startIndex);
+		if (startIndex != newStartIndices.end())
+			entry.range.startIndex = startIndex->second;
+	}
+
+	mDefragmentCount++;
+	return true;
+}
+void GeometryPool::ReleaseRetiredBuffers()
+{
+	mRetiredBuffers.clear();
+}
+
+GeometryPoolStatistics GeometryPool::GetStatistics()
+{
+	TlsfAllocatorStatistics vertexStatistics = mVertexAllocator.GetStatistics();
+	TlsfAllocatorStatistics indexStatistics = mIndexAllocator.GetStatistics();
+
+	GeometryPoolStatistics statistics;
+	statistics.meshCount = vertexStatistics.allocationCount;
+	statistics.vertexCount = vertexStatistics.usedSize;
+	statistics.vertexCapacity = vertexStatistics.capacity;
+	statistics.indexCount = indexStatistics.usedSize;
+	statistics.indexCapacity = indexStatistics.capacity;
+	statistics.vertexFragmentation = vertexStatistics.fragmentation;
+	statistics.indexFragmentation = indexStatistics.fragmentation;
+	statistics.defragmentCount = mDefragmentCount;
+	return statistics;
+}
+
+void GeometryPool::CreateBuffers()
+{
+	mVertexBuffer = D3D12Utility::CreateDefaultBuffer(mDevice,
+		static_cast<UINT64>(mVertexAllocator.GetCapacity()) * sizeof(Vertex));
+	mIndexBuffer = D3D12Utility::CreateDefaultBuffer(mDevice,
+		static_cast<UINT64>(mIndexAllocator.GetCapacity()) * sizeof(uint32_t));
+}
+void GeometryPool::RecordCopies(ID3D12GraphicsCommandList* commandList, ID3D12Resource* destination, ID3D12Resource* source,
+	const std::vector<TlsfMove>& moves, UINT usedSize, UINT stride)
+{
+	// The ranges before the first move kept their places.
+	UINT unmovedSize = moves.empty() ? usedSize : moves.front().newOffset;
+	if (unmovedSize > 0)
+		commandList->CopyBufferRegion(destination, 0, source, 0, static_cast<UINT64>(unmovedSize) * stride);
+
+	size_t i = 0;
+	while (i < moves.size())
+	{
+		UINT oldOffset = moves[i].oldOffset;
+		UINT newOffset = moves[i].newOffset;
+		UINT size = moves[i].size;
+		for (i++; i < moves.size() && moves[i].oldOffset == oldOffset + size; i++)
+			size += moves[i].size;
+
+		commandList->CopyBufferRegion(destination, static_cast<UINT64>(newOffset) * stride,
+			source, static_cast<UINT64>(oldOffset) * stride, static_cast<UINT64>(size) * stride);
+	}
+}
\ No newline at end of file
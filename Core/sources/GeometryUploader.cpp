@@ -0,0 +1,160 @@
+#include "../includes/GeometryUploader.h"
+
+namespace
+{
+	uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+GeometryUploader::GeometryUploader(GeometryCopyQueue& copyQueue)
+	: mCopyQueue(copyQueue)
+{
+	mStagingSize = copyQueue.GetStagingSize();
+	mStagingData = copyQueue.GetStagingData();
+	assert(mStagingSize >= 4 * stagingAlignment && mStagingSize % stagingAlignment == 0);
+}
+
+void GeometryUploader::Upload(void* destination, uint64_t destinationOffset, const void* data, uint64_t byteSize)
+{
+	assert(destination != nullptr && (data != nullptr || byteSize == 0));
+
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	uint64_t maxChunkSize = mStagingSize / 4 / stagingAlignment * stagingAlignment;
+
+	while (byteSize > 0)
+	{
+		uint64_t chunkSize = std::min(byteSize, maxChunkSize);
+		uint64_t stagingOffset = Allocate(chunkSize);
+		memcpy(mStagingData + stagingOffset, bytes, static_cast<size_t>(chunkSize));
+
+		// Consecutive parts of a buffer that are also consecutive in the ring become one copy.
+		GeometryCopy* previous = mPendingCopies.empty() ? nullptr : &mPendingCopies.back();
+		if (previous != nullptr && previous->destination == destination &&
+			previous->destinationOffset + previous->byteSize == destinationOffset &&
+			previous->stagingOffset + previous->byteSize == stagingOffset)
+		{
+			previous->byteSize += chunkSize;
+		}
+		else
+		{
+			mPendingCopies.push_back({ destination, destinationOffset, stagingOffset, chunkSize });
+		}
+
+		mStatistics.uploadedBytes += chunkSize;
+		bytes += chunkSize;
+		destinationOffset += chunkSize;
+		byteSize -= chunkSize;
+	}
+}
+
+uint64_t GeometryUploader::Flush()
+{
+	if (mPendingCopies.empty())
+		return mLastFenceValue;
+
+	mCopyQueue.RecordCopies(mPendingCopies.data(), static_cast<uint32_t>(mPendingCopies.size()));
+	mLastFenceValue = mCopyQueue.Submit();
+
+	mBatches.push_back({ mLastFenceValue, mHead, mPendingBytes });
+
+	mStatistics.copyCount += static_cast<uint32_t>(mPendingCopies.size());
+	mStatistics.batchCount++;
+
+	mPendingCopies.clear();
+	mPendingBytes = 0;
+
+	return mLastFenceValue;
+}
+void GeometryUploader::Retire()
+{
+	if (mBatches.empty())
+		return;
+
+	uint64_t completedFenceValue = mCopyQueue.GetCompletedFenceValue();
+	while (!mBatches.empty() && mBatches.front().fenceValue <= completedFenceValue)
+	{
+		mTail = mBatches.front().end;
+		mUsedBytes -= mBatches.front().byteCount;
+		mBatches.pop_front();
+	}
+
+	// Start over at the beginning once everything is free, nothing is skipped at the end then.
+	if (mUsedBytes == 0)
+	{
+		mHead = 0;
+		mTail = 0;
+	}
+}
+void GeometryUploader::WaitIdle()
+{
+	Flush();
+	if (!mBatches.empty())
+		mCopyQueue.WaitForFenceValue(mBatches.back().fenceValue);
+	Retire();
+}
+
+GeometryUploaderStatistics GeometryUploader::GetStatistics()
+{
+	GeometryUploaderStatistics statistics = mStatistics;
+	statistics.stagingBytesInUse = mUsedBytes;
+	return statistics;
+}
+
+uint64_t GeometryUploader::Allocate(uint64_t byteSize)
+{
+	uint64_t alignedSize = AlignUp(byteSize, stagingAlignment);
+	assert(alignedSize <= mStagingSize);
+
+	uint64_t offset = 0;
+	Retire();
+	while (!TryAllocate(alignedSize, offset))
+	{
+		// The pending copies may hold the space, submit them before waiting for the oldest batch.
+		Flush();
+		assert(!mBatches.empty());
+
+		mCopyQueue.WaitForFenceValue(mBatches.front().fenceValue);
+		mStatistics.stallCount++;
+		Retire();
+	}
+
+	mStatistics.peakStagingBytes = std::max(mStatistics.peakStagingBytes, mUsedBytes);
+	return offset;
+}
+bool GeometryUploader::TryAllocate(uint64_t byteSize, uint64_t& offset)
+{
+	if (mUsedBytes == mStagingSize)
+		return false;
+
+	uint64_t skippedBytes = 0;
+	if (mHead >= mTail)
+	{
+		// Free are [head, size) and [0, tail), the end is skipped when the data doesn't fit there.
+		if (mHead + byteSize <= mStagingSize)
+		{
+			offset = mHead;
+		}
+		else if (byteSize <= mTail)
+		{
+			skippedBytes = mStagingSize - mHead;
+			offset = 0;
+		}
+		else
+		{
+			return false;
+		}
+	}
+	else
+	{
+		if (mHead + byteSize > mTail)
+			return false;
+		offset = mHead;
+	}
+
+	mHead = offset + byteSize;
+	mUsedBytes += skippedBytes + byteSize;
+	mPendingBytes += skippedBytes + byteSize;
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,234 @@
+#include "../includes/GpuMemoryAllocator.h"
+
+namespace
+{
+	uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+GpuMemoryAllocator::GpuMemoryAllocator(GpuHeapFactory& heapFactory)
+	: mHeapFactory(heapFactory)
+{
+	mHeapSizes[static_cast<size_t>(GpuHeapType::Default)] = 64 * 1024 * 1024;
+	mHeapSizes[static_cast<size_t>(GpuHeapType::Upload)] = 8 * 1024 * 1024;
+	mHeapSizes[static_cast<size_t>(GpuHeapType::Readback)] = 1024 * 1024;
+
+	const uint64_t alignments[alignmentClassCount] = { smallAlignment, defaultAlignment, msaaAlignment };
+
+	for (int heapType = 0; heapType < static_cast<int>(GpuHeapType::Count); heapType++)
+	{
+		for (int resourceClass = 0; resourceClass < static_cast<int>(GpuResourceClass::Count); resourceClass++)
+		{
+			for (uint32_t alignmentClass = 0; alignmentClass < alignmentClassCount; alignmentClass++)
+			{
+				Pool pool;
+				pool.heapType = static_cast<GpuHeapType>(heapType);
+				pool.resourceClass = static_cast<GpuResourceClass>(resourceClass);
+				pool.alignment = alignments[alignmentClass];
+				mPools.push_back(std::move(pool));
+			}
+		}
+
+		mStatistics.heapTypes[heapType].budgetBytes = UINT64_MAX;
+	}
+}
+GpuMemoryAllocator::~GpuMemoryAllocator()
+{
+	for (auto& pool : mPools)
+	{
+		for (auto& heap : pool.heaps)
+		{
+			if (heap.heap == nullptr)
+				continue;
+
+			assert(heap.allocator.GetStatistics().allocationCount == 0);
+			mHeapFactory.DestroyHeap(heap.heap);
+		}
+	}
+}
+
+GpuAllocation GpuMemoryAllocator::Allocate(GpuHeapType heapType, GpuResourceClass resourceClass, uint64_t byteSize, uint64_t alignment)
+{
+	assert(byteSize > 0);
+
+	uint32_t alignmentClass = GetAlignmentClass(alignment);
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	GpuHeapTypeStatistics& statistics = GetHeapTypeStatistics(heapType);
+
+	GpuAllocation allocation;
+	allocation.byteSize = AlignUp(byteSize, alignment);
+	allocation.requestedByteSize = byteSize;
+	allocation.heapType = heapType;
+
+	// The bytes of a new heap count against the budget only once the factory created it, a factory that
+	// throws leaves the statistics as they were.
+	uint64_t heapSize = AlignUp(mHeapSizes[static_cast<size_t>(heapType)], alignment);
+	if (allocation.byteSize > heapSize / 2)
+	{
+		if (!FitsBudget(heapType, allocation.byteSize))
+			return GpuAllocation();
+
+		allocation.heap = mHeapFactory.CreateHeap(heapType, resourceClass, allocation.byteSize, alignment);
+		AddHeapBytes(heapType, allocation.byteSize);
+		allocation.isDedicated = true;
+		statistics.dedicatedHeapCount++;
+	}
+	else
+	{
+		allocation.pool = (static_cast<uint32_t>(heapType) * static_cast<uint32_t>(GpuResourceClass::Count) +
+			static_cast<uint32_t>(resourceClass)) * alignmentClassCount + alignmentClass;
+		Pool& pool = mPools[allocation.pool];
+		uint32_t unitCount = static_cast<uint32_t>(allocation.byteSize / alignment);
+
+		uint32_t emptySlot = TlsfAllocator::invalidOffset;
+		for (uint32_t i = 0; i < pool.heaps.size() && !allocation.IsValid(); i++)
+		{
+			if (pool.heaps[i].heap == nullptr)
+			{
+				emptySlot = i;
+				continue;
+			}
+
+			uint32_t unit = pool.heaps[i].allocator.Allocate(unitCount);
+			if (unit != TlsfAllocator::invalidOffset)
+			{
+				allocation.heap = pool.heaps[i].heap;
+				allocation.offset = static_cast<uint64_t>(unit) * alignment;
+				allocation.heapIndex = i;
+			}
+		}
+
+		if (!allocation.IsValid())
+		{
+			if (!FitsBudget(heapType, heapSize))
+				return GpuAllocation();
+
+			void* newHeap = mHeapFactory.CreateHeap(heapType, resourceClass, heapSize, alignment);
+			AddHeapBytes(heapType, heapSize);
+
+			if (emptySlot == TlsfAllocator::invalidOffset)
+			{
+				emptySlot = static_cast<uint32_t>(pool.heaps.size());
+				pool.heaps.emplace_back();
+			}
+
+			Heap& heap = pool.heaps[emptySlot];
+			heap.heap = newHeap;
+			heap.byteSize = heapSize;
+			heap.allocator.Reset(static_cast<uint32_t>(heapSize / alignment));
+			pool.liveHeapCount++;
+
+			allocation.heap = heap.heap;
+			allocation.offset = static_cast<uint64_t>(heap.allocator.Allocate(unitCount)) * alignment;
+			allocation.heapIndex = emptySlot;
+		}
+	}
+
+	statistics.allocationCount++;
+	statistics.allocatedBytes += allocation.byteSize;
+	statistics.requestedBytes += allocation.requestedByteSize;
+	return allocation;
+}
+void GpuMemoryAllocator::Free(const GpuAllocation& allocation)
+{
+	assert(allocation.IsValid());
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	GpuHeapTypeStatistics& statistics = GetHeapTypeStatistics(allocation.heapType);
+
+	statistics.allocationCount--;
+	statistics.allocatedBytes -= allocation.byteSize;
+	statistics.requestedBytes -= allocation.requestedByteSize;
+
+	if (allocation.isDedicated)
+	{
+		mHeapFactory.DestroyHeap(allocation.heap);
+		ReleaseHeapBytes(allocation.heapType, allocation.byteSize);
+		statistics.dedicatedHeapCount--;
+		return;
+	}
+
+	Pool& pool = mPools[allocation.pool];
+	Heap& heap = pool.heaps[allocation.heapIndex];
+	assert(heap.heap == allocation.heap);
+	heap.allocator.Free(static_cast<uint32_t>(allocation.offset / pool.alignment));
+
+	// Keep the pool's last heap, so freeing and allocating one resource doesn't create a heap every time.
+	if (heap.allocator.GetStatistics().allocationCount == 0 && pool.liveHeapCount > 1)
+	{
+		mHeapFactory.DestroyHeap(heap.heap);
+		heap.heap = nullptr;
+		heap.allocator.Reset(0);
+		pool.liveHeapCount--;
+		ReleaseHeapBytes(allocation.heapType, heap.byteSize);
+	}
+}
+
+void GpuMemoryAllocator::SetBudget(GpuHeapType heapType, uint64_t budgetBytes)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	GetHeapTypeStatistics(heapType).budgetBytes = budgetBytes;
+}
+void GpuMemoryAllocator::SetHeapSize(GpuHeapType heapType, uint64_t heapSize)
+{
+	assert(heapSize > 0);
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mHeapSizes[static_cast<size_t>(heapType)] = heapSize;
+}
+uint64_t GpuMemoryAllocator::GetHeapSize(GpuHeapType heapType)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mHeapSizes[static_cast<size_t>(heapType)];
+}
+
+GpuMemoryStatistics GpuMemoryAllocator::GetStatistics()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mStatistics;
+}
+
+uint32_t GpuMemoryAllocator::GetAlignmentClass(uint64_t alignment)
+{
+	switch (alignment)
+	{
+	case smallAlignment:
+		return 0;
+	case defaultAlignment:
+		return 1;
+	case msaaAlignment:
+		return 2;
+	default:
+		throw std::runtime_error("Unsupported placement alignment " + std::to_string(alignment) + ".");
+	}
+}
+bool GpuMemoryAllocator::FitsBudget(GpuHeapType heapType, uint64_t byteSize)
+{
+	GpuHeapTypeStatistics& statistics = GetHeapTypeStatistics(heapType);
+	if (statistics.heapBytes + byteSize > statistics.budgetBytes)
+	{
+		statistics.budgetFailureCount++;
+		return false;
+	}
+	return true;
+}
+void GpuMemoryAllocator::AddHeapBytes(GpuHeapType heapType, uint64_t byteSize)
+{
+	GpuHeapTypeStatistics& statistics = GetHeapTypeStatistics(heapType);
+	statistics.heapCount++;
+	statistics.heapBytes += byteSize;
+	statistics.peakHeapBytes = std::max(statistics.peakHeapBytes, statistics.heapBytes);
+}
+void GpuMemoryAllocator::ReleaseHeapBytes(GpuHeapType heapType, uint64_t byteSize)
+{
+	GpuHeapTypeStatistics& statistics = GetHeapTypeStatistics(heapType);
+	statistics.heapCount--;
+	statistics.heapBytes -= byteSize;
+}
+GpuHeapTypeStatistics& GpuMemoryAllocator::GetHeapTypeStatistics(GpuHeapType heapType)
+{
+	return mStatistics.heapTypes[static_cast<size_t>(heapType)];
+}
\ No newline at end of file
@@ -0,0 +1,666 @@
+#include "../includes/Heightfield.h"
+using namespace DirectX;
+
+namespace
+{
+	double ElapsedMilliseconds(std::chrono::steady_clock::time_point start)
+	{
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	}
+
+	uint32_t DivideRoundUp(uint32_t value, uint32_t divisor)
+	{
+		return (value + divisor - 1) / divisor;
+	}
+
+	// The bits of a coordinate inside of a tile spread to every other bit, x in the even ones and y in the odd ones.
+	static_assert(Heightfield::tileSize == 8, "The Morton table covers 8 samples");
+	const uint32_t mortonBits[Heightfield::tileSize] = { 0, 1, 4, 5, 16, 17, 20, 21 };
+
+	// Clips [enter, exit] to the part of the ray inside of the box. The box is open at the bottom, everything
+	// below the surface is terrain.
+	bool ClipRayToBox(const XMFLOAT3& origin, const XMFLOAT3& direction,
+		const XMFLOAT3& boxMin, const XMFLOAT3& boxMax, float& enter, float& exit)
+	{
+		const float origins[3] = { origin.x, origin.y, origin.z };
+		const float directions[3] = { direction.x, direction.y, direction.z };
+		const float mins[3] = { boxMin.x, boxMin.y, boxMin.z };
+		const float maxs[3] = { boxMax.x, boxMax.y, boxMax.z };
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			bool isOpen = axis == 1;
+
+			if (directions[axis] == 0.0f)
+			{
+				if ((!isOpen && origins[axis] < mins[axis]) || origins[axis] > maxs[axis])
+					return false;
+				continue;
+			}
+
+			float invDirection = 1.0f / directions[axis];
+			float t0 = (mins[axis] - origins[axis]) * invDirection;
+			float t1 = (maxs[axis] - origins[axis]) * invDirection;
+			if (t0 > t1)
+				std::swap(t0, t1);
+
+			// The open axis only clips at the top, the ray leaves there going up and enters there going down.
+			if (!isOpen || directions[axis] > 0.0f)
+				exit = std::min(exit, t1);
+			if (!isOpen || directions[axis] < 0.0f)
+				enter = std::max(enter, t0);
+			if (enter > exit)
+				return false;
+		}
+
+		return true;
+	}
+}
+
+Heightfield::Heightfield(JobSystem& jobSystem)
+	: mJobSystem(jobSystem)
+{
+}
+
+void Heightfield::Build(const float* heights, uint32_t width, uint32_t height, float sampleSpacing)
+{
+	assert(heights != nullptr && width > 1 && height > 1);
+	assert(sampleSpacing > 0.0f);
+
+	auto start = std::chrono::steady_clock::now();
+
+	mWidth = width;
+	mHeight = height;
+	mSampleSpacing = sampleSpacing;
+
+	auto range = std::minmax_element(heights, heights + static_cast<size_t>(width) * height);
+	mMinHeight = *range.first;
+	mMaxHeight = *range.second;
+	mQuantizationStep = (mMaxHeight - mMinHeight) / 65535.0f;
+
+	mTileCountX = DivideRoundUp(width, tileSize);
+	uint32_t tileCountY = DivideRoundUp(height, tileSize);
+	mSamples.assign(static_cast<size_t>(mTileCountX) * tileCountY * tileSize * tileSize, 0);
+
+	mJobSystem.ParallelFor(tileCountY, 1,
+		[this, heights](uint32_t begin, uint32_t end)
+		{
+			BuildTileRows(heights, begin, end);
+		});
+
+	BuildLevels();
+
+	mStatistics = HeightfieldStatistics();
+	mStatistics.tileCount = mTileCountX * tileCountY;
+	mStatistics.levelCount = static_cast<uint32_t>(mLevels.size());
+	mStatistics.memoryBytes = mSamples.size() * sizeof(uint16_t);
+	for (const auto& level : mLevels)
+		mStatistics.memoryBytes += level.heightRanges.size() * sizeof(XMFLOAT2);
+	mStatistics.buildMilliseconds = ElapsedMilliseconds(start);
+}
+void Heightfield::Build(const unsigned char* heightValues, int width, int height, int nChannels,
+	float heightScale, float heightOffset, float sampleSpacing)
+{
+	assert(heightValues != nullptr && nChannels > 0);
+
+	std::vector<float> heights(static_cast<size_t>(width) * height);
+	mJobSystem.ParallelFor(static_cast<uint32_t>(height), rowsPerJob,
+		[&heights, heightValues, width, nChannels, heightScale, heightOffset](uint32_t begin, uint32_t end)
+		{
+			for (size_t i = begin * static_cast<size_t>(width); i < end * static_cast<size_t>(width); i++)
+				heights[i] = heightValues[i * nChannels] / 255.0f * heightScale + heightOffset;
+		});
+
+	Build(heights.data(), static_cast<uint32_t>(width), static_cast<uint32_t>(height), sampleSpacing);
+}
+
+bool Heightfield::IsEmpty()
+{
+	return mSamples.empty();
+}
+uint32_t Heightfield::GetWidth()
+{
+	return mWidth;
+}
+uint32_t Heightfield::GetHeight()
+{
+	return mHeight;
+}
+float Heightfield::GetSampleSpacing()
+{
+	return mSampleSpacing;
+}
+BoundingBox Heightfield::GetBounds()
+{
+	return BoundingBox(XMFLOAT3(0.0f, 0.5f * (mMinHeight + mMaxHeight), 0.0f),
+		XMFLOAT3(0.5f * (mWidth - 1) * mSampleSpacing, 0.5f * (mMaxHeight - mMinHeight), 0.5f * (mHeight - 1) * mSampleSpacing));
+}
+
+float Heightfield::GetSample(uint32_t x, uint32_t y)
+{
+	assert(x < mWidth && y < mHeight);
+	return mMinHeight + mSamples[GetSampleIndex(x, y)] * mQuantizationStep;
+}
+
+float Heightfield::GetHeight(float x, float z)
+{
+	CellSample cell;
+	GetCellSample(x, z, cell);
+
+	float top = cell.q00 + (cell.q10 - cell.q00) * cell.u;
+	float bottom = cell.q01 + (cell.q11 - cell.q01) * cell.u;
+	return mMinHeight + (top + (bottom - top) * cell.v) * mQuantizationStep;
+}
+XMFLOAT3 Heightfield::GetNormal(float x, float z)
+{
+	XMFLOAT3 normal;
+	GetHeightAndNormal(x, z, normal);
+	return normal;
+}
+float Heightfield::GetHeightAndNormal(float x, float z, XMFLOAT3& normal)
+{
+	CellSample cell;
+	GetCellSample(x, z, cell);
+
+	// Gradient of the bilinear surface, per sample.
+	float slopeU = ((cell.q10 - cell.q00) * (1.0f - cell.v) + (cell.q11 - cell.q01) * cell.v) * mQuantizationStep;
+	float slopeV = ((cell.q01 - cell.q00) * (1.0f - cell.u) + (cell.q11 - cell.q10) * cell.u) * mQuantizationStep;
+	XMStoreFloat3(&normal, XMVector3Normalize(XMVectorSet(-slopeU, mSampleSpacing, -slopeV, 0.0f)));
+
+	float top = cell.q00 + (cell.q10 - cell.q00) * cell.u;
+	float bottom = cell.q01 + (cell.q11 - cell.q01) * cell.u;
+	return mMinHeight + (top + (bottom - top) * cell.v) * mQuantizationStep;
+}
+
+void Heightfield::GetHeights(const XMFLOAT2* points, uint32_t count, float* heights)
+{
+	assert(!IsEmpty());
+
+	XMVECTOR invSpacing = XMVectorReplicate(1.0f / mSampleSpacing);
+	XMVECTOR halfSizeX = XMVectorReplicate(0.5f * (mWidth - 1));
+	XMVECTOR halfSizeZ = XMVectorReplicate(0.5f * (mHeight - 1));
+	XMVECTOR maxX = XMVectorReplicate(static_cast<float>(mWidth - 1));
+	XMVECTOR maxZ = XMVectorReplicate(static_cast<float>(mHeight - 1));
+	XMVECTOR maxCellX = XMVectorReplicate(static_cast<float>(mWidth - 2));
+	XMVECTOR maxCellZ = XMVectorReplicate(static_cast<float>(mHeight - 2));
+	XMVECTOR minHeight = XMVectorReplicate(mMinHeight);
+	XMVECTOR step = XMVectorReplicate(mQuantizationStep);
+
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const XMFLOAT2* p = points + i;
+		XMVECTOR x = XMVectorClamp(XMVectorMultiplyAdd(XMVectorSet(p[0].x, p[1].x, p[2].x, p[3].x), invSpacing, halfSizeX),
+			XMVectorZero(), maxX);
+		XMVECTOR z = XMVectorClamp(XMVectorMultiplyAdd(XMVectorSet(p[0].y, p[1].y, p[2].y, p[3].y), invSpacing, halfSizeZ),
+			XMVectorZero(), maxZ);
+		XMVECTOR cellX = XMVectorMin(XMVectorFloor(x), maxCellX);
+		XMVECTOR cellZ = XMVectorMin(XMVectorFloor(z), maxCellZ);
+		XMVECTOR u = XMVectorSubtract(x, cellX);
+		XMVECTOR v = XMVectorSubtract(z, cellZ);
+
+		XMFLOAT4 cellXs, cellZs;
+		XMStoreFloat4(&cellXs, cellX);
+		XMStoreFloat4(&cellZs, cellZ);
+		const float* cellXArray = &cellXs.x;
+		const float* cellZArray = &cellZs.x;
+
+		// There is no gather, the corners are fetched one lane at a time.
+		XMFLOAT4 corners[4];
+		float* cornerArrays[4] = { &corners[0].x, &corners[1].x, &corners[2].x, &corners[3].x };
+		for (uint32_t lane = 0; lane < 4; lane++)
+		{
+			uint32_t sampleX = static_cast<uint32_t>(cellXArray[lane]);
+			uint32_t sampleZ = static_cast<uint32_t>(cellZArray[lane]);
+			cornerArrays[0][lane] = mSamples[GetSampleIndex(sampleX, sampleZ)];
+			cornerArrays[1][lane] = mSamples[GetSampleIndex(sampleX + 1, sampleZ)];
+			cornerArrays[2][lane] = mSamples[GetSampleIndex(sampleX, sampleZ + 1)];
+			cornerArrays[3][lane] = mSamples[GetSampleIndex(sampleX + 1, sampleZ + 1)];
+		}
+
+		XMVECTOR top = XMVectorLerpV(XMLoadFloat4(&corners[0]), XMLoadFloat4(&corners[1]), u);
+		XMVECTOR bottom = XMVectorLerpV(XMLoadFloat4(&corners[2]), XMLoadFloat4(&corners[3]), u);
+		XMVECTOR quantized = XMVectorLerpV(top, bottom, v);
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(heights + i), XMVectorMultiplyAdd(quantized, step, minHeight));
+	}
+
+	for (; i < count; i++)
+		heights[i] = GetHeight(points[i].x, points[i].y);
+}
+void Heightfield::GetNormals(const XMFLOAT2* points, uint32_t count, XMFLOAT3* normals)
+{
+	assert(!IsEmpty());
+
+	XMVECTOR invSpacing = XMVectorReplicate(1.0f / mSampleSpacing);
+	XMVECTOR halfSizeX = XMVectorReplicate(0.5f * (mWidth - 1));
+	XMVECTOR halfSizeZ = XMVectorReplicate(0.5f * (mHeight - 1));
+	XMVECTOR maxX = XMVectorReplicate(static_cast<float>(mWidth - 1));
+	XMVECTOR maxZ = XMVectorReplicate(static_cast<float>(mHeight - 1));
+	XMVECTOR maxCellX = XMVectorReplicate(static_cast<float>(mWidth - 2));
+	XMVECTOR maxCellZ = XMVectorReplicate(static_cast<float>(mHeight - 2));
+	XMVECTOR step = XMVectorReplicate(mQuantizationStep);
+	XMVECTOR spacing = XMVectorReplicate(mSampleSpacing);
+	XMVECTOR one = XMVectorReplicate(1.0f);
+
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const XMFLOAT2* p = points + i;
+		XMVECTOR x = XMVectorClamp(XMVectorMultiplyAdd(XMVectorSet(p[0].x, p[1].x, p[2].x, p[3].x), invSpacing, halfSizeX),
+			XMVectorZero(), maxX);
+		XMVECTOR z = XMVectorClamp(XMVectorMultiplyAdd(XMVectorSet(p[0].y, p[1].y, p[2].y, p[3].y), invSpacing, halfSizeZ),
+			XMVectorZero(), maxZ);
+		XMVECTOR cellX = XMVectorMin(XMVectorFloor(x), maxCellX);
+		XMVECTOR cellZ = XMVectorMin(XMVectorFloor(z), maxCellZ);
+		XMVECTOR u = XMVectorSubtract(x, cellX);
+		XMVECTOR v = XMVectorSubtract(z, cellZ);
+
+		XMFLOAT4 cellXs, cellZs;
+		XMStoreFloat4(&cellXs, cellX);
+		XMStoreFloat4(&cellZs, cellZ);
+		const float* cellXArray = &cellXs.x;
+		const float* cellZArray = &cellZs.x;
+
+		XMFLOAT4 corners[4];
+		float* cornerArrays[4] = { &corners[0].x, &corners[1].x, &corners[2].x, &corners[3].x };
+		for (uint32_t lane = 0; lane < 4; lane++)
+		{
+			uint32_t sampleX = static_cast<uint32_t>(cellXArray[lane]);
+			uint32_t sampleZ = static_cast<uint32_t>(cellZArray[lane]);
+			cornerArrays[0][lane] = mSamples[GetSampleIndex(sampleX, sampleZ)];
+			cornerArrays[1][lane] = mSamples[GetSampleIndex(sampleX + 1, sampleZ)];
+			cornerArrays[2][lane] = mSamples[GetSampleIndex(sampleX, sampleZ + 1)];
+			cornerArrays[3][lane] = mSamples[GetSampleIndex(sampleX + 1, sampleZ + 1)];
+		}
+
+		XMVECTOR h00 = XMLoadFloat4(&corners[0]);
+		XMVECTOR h10 = XMLoadFloat4(&corners[1]);
+		XMVECTOR h01 = XMLoadFloat4(&corners[2]);
+		XMVECTOR h11 = XMLoadFloat4(&corners[3]);
+
+		// The same gradient as GetHeightAndNormal, the corners are still quantized.
+		XMVECTOR slopeU = XMVectorMultiply(XMVectorLerpV(XMVectorSubtract(h10, h00), XMVectorSubtract(h11, h01), v), step);
+		XMVECTOR slopeV = XMVectorMultiply(XMVectorLerpV(XMVectorSubtract(h01, h00), XMVectorSubtract(h11, h10), u), step);
+		XMVECTOR lengthSquared = XMVectorMultiplyAdd(slopeU, slopeU, XMVectorMultiplyAdd(slopeV, slopeV, XMVectorMultiply(spacing, spacing)));
+		XMVECTOR invLength = XMVectorDivide(one, XMVectorSqrt(lengthSquared));
+
+		XMFLOAT4 normalsX, normalsY, normalsZ;
+		XMStoreFloat4(&normalsX, XMVectorNegate(XMVectorMultiply(slopeU, invLength)));
+		XMStoreFloat4(&normalsY, XMVectorMultiply(spacing, invLength));
+		XMStoreFloat4(&normalsZ, XMVectorNegate(XMVectorMultiply(slopeV, invLength)));
+
+		normals[i] = XMFLOAT3(normalsX.x, normalsY.x, normalsZ.x);
+		normals[i + 1] = XMFLOAT3(normalsX.y, normalsY.y, normalsZ.y);
+		normals[i + 2] = XMFLOAT3(normalsX.z, normalsY.z, normalsZ.z);
+		normals[i + 3] = XMFLOAT3(normalsX.w, normalsY.w, normalsZ.w);
+	}
+
+	for (; i < count; i++)
+		normals[i] = GetNormal(points[i].x, points[i].y);
+}
+
+bool Heightfield::Intersects(const XMFLOAT3& origin, const XMFLOAT3& direction, float maxDistance, float& distance)
+{
+	if (IsEmpty())
+		return false;
+
+	// In sample units the cells are unit squares, the ray's distances don't change.
+	XMFLOAT3 sampleOrigin(origin.x / mSampleSpacing + 0.5f * (mWidth - 1), origin.y,
+		origin.z / mSampleSpacing + 0.5f * (mHeight - 1));
+	XMFLOAT3 sampleDirection(direction.x / mSampleSpacing, direction.y, direction.z / mSampleSpacing);
+
+	struct Node
+	{
+		uint32_t level, x, y;
+		float enter, exit;
+	};
+	// A node pushes at most 4 children, so the stack holds at most 3 waiting siblings per level.
+	std::array<Node, 3 * maxLevelCount + 1> stack;
+
+	bool hit = false;
+	float nearest = maxDistance;
+
+	uint32_t rootLevel = static_cast<uint32_t>(mLevels.size()) - 1;
+	for (uint32_t rootY = 0; rootY < mLevels[rootLevel].tileCountY; rootY++)
+	{
+		for (uint32_t rootX = 0; rootX < mLevels[rootLevel].tileCountX; rootX++)
+		{
+			XMFLOAT3 boxMin, boxMax;
+			GetTileBox(rootLevel, rootX, rootY, boxMin, boxMax);
+
+			Node root = { rootLevel, rootX, rootY, 0.0f, nearest };
+			if (!ClipRayToBox(sampleOrigin, sampleDirection, boxMin, boxMax, root.enter, root.exit))
+				continue;
+
+			uint32_t stackSize = 0;
+			stack[stackSize++] = root;
+			while (stackSize > 0)
+			{
+				Node node = stack[--stackSize];
+				if (node.enter > nearest)
+					continue;
+
+				// Below the lowest sample of the node the ray is in the terrain already.
+				const XMFLOAT2& heightRange = mLevels[node.level].heightRanges[node.y * mLevels[node.level].tileCountX + node.x];
+				if (sampleOrigin.y + sampleDirection.y * node.enter <= heightRange.x)
+				{
+					hit = true;
+					nearest = node.enter;
+					continue;
+				}
+
+				if (node.level == 0)
+				{
+					float tileDistance;
+					if (IntersectTile(node.x, node.y, sampleOrigin, sampleDirection,
+						node.enter, std::min(node.exit, nearest), tileDistance))
+					{
+						hit = true;
+						nearest = tileDistance;
+					}
+					continue;
+				}
+
+				// The children the ray passes through, pushed far to near so the nearest is walked first.
+				const Level& children = mLevels[node.level - 1];
+				std::array<Node, 4> hits;
+				uint32_t hitCount = 0;
+				for (uint32_t childY = 2 * node.y; childY < std::min(2 * node.y + 2, children.tileCountY); childY++)
+				{
+					for (uint32_t childX = 2 * node.x; childX < std::min(2 * node.x + 2, children.tileCountX); childX++)
+					{
+						GetTileBox(node.level - 1, childX, childY, boxMin, boxMax);
+
+						Node child = { node.level - 1, childX, childY, node.enter, std::min(node.exit, nearest) };
+						if (!ClipRayToBox(sampleOrigin, sampleDirection, boxMin, boxMax, child.enter, child.exit))
+							continue;
+
+						uint32_t slot = hitCount++;
+						for (; slot > 0 && hits[slot - 1].enter < child.enter; slot--)
+							hits[slot] = hits[slot - 1];
+						hits[slot] = child;
+					}
+				}
+
+				for (uint32_t i = 0; i < hitCount; i++)
+				{
+					assert(stackSize < stack.size());
+					stack[stackSize++] = hits[i];
+				}
+			}
+		}
+	}
+
+	if (hit)
+		distance = nearest;
+	return hit;
+}
+
+HeightfieldStatistics Heightfield::GetStatistics()
+{
+	return mStatistics;
+}
+
+uint32_t Heightfield::GetSampleIndex(uint32_t x, uint32_t y)
+{
+	uint32_t tile = (y / tileSize) * mTileCountX + x / tileSize;
+	return tile * tileSize * tileSize + (mortonBits[x % tileSize] | (mortonBits[y % tileSize] << 1));
+}
+void Heightfield::GetCellSample(float x, float z, CellSample& cell)
+{
+	assert(!IsEmpty());
+
+	float sampleX = std::min(std::max(x / mSampleSpacing + 0.5f * (mWidth - 1), 0.0f), static_cast<float>(mWidth - 1));
+	float sampleZ = std::min(std::max(z / mSampleSpacing + 0.5f * (mHeight - 1), 0.0f), static_cast<float>(mHeight - 1));
+	uint32_t cellX = std::min(static_cast<uint32_t>(sampleX), mWidth - 2);
+	uint32_t cellZ = std::min(static_cast<uint32_t>(sampleZ), mHeight - 2);
+
+	uint32_t tileX = cellX % tileSize;
+	uint32_t tileZ = cellZ % tileSize;
+	if (tileX + 1 < tileSize && tileZ + 1 < tileSize)
+	{
+		// All four corners in one tile, 49 of 64 cells.
+		const uint16_t* tile = mSamples.data() + GetSampleIndex(cellX - tileX, cellZ - tileZ);
+		uint32_t x0 = mortonBits[tileX], x1 = mortonBits[tileX + 1];
+		uint32_t z0 = mortonBits[tileZ] << 1, z1 = mortonBits[tileZ + 1] << 1;
+		cell.q00 = tile[x0 | z0];
+		cell.q10 = tile[x1 | z0];
+		cell.q01 = tile[x0 | z1];
+		cell.q11 = tile[x1 | z1];
+	}
+	else
+	{
+		cell.q00 = mSamples[GetSampleIndex(cellX, cellZ)];
+		cell.q10 = mSamples[GetSampleIndex(cellX + 1, cellZ)];
+		cell.q01 = mSamples[GetSampleIndex(cellX, cellZ + 1)];
+		cell.q11 = mSamples[GetSampleIndex(cellX + 1, cellZ + 1)];
+	}
+	cell.u = sampleX - cellX;
+	cell.v = sampleZ - cellZ;
+}
+void Heightfield::BuildTileRows(const float* heights, uint32_t begin, uint32_t end)
+{
+	float invStep = mQuantizationStep > 0.0f ? 1.0f / mQuantizationStep : 0.0f;
+
+	for (uint32_t tileY = begin; tileY < end; tileY++)
+	{
+		for (uint32_t tileX = 0; tileX < mTileCountX; tileX++)
+		{
+			// Tiles over the map's far edges repeat the edge samples.
+			for (uint32_t y = tileY * tileSize; y < (tileY + 1) * tileSize; y++)
+			{
+				const float* row = heights + static_cast<size_t>(std::min(y, mHeight - 1)) * mWidth;
+				for (uint32_t x = tileX * tileSize; x < (tileX + 1) * tileSize; x++)
+				{
+					float quantized = (row[std::min(x, mWidth - 1)] - mMinHeight) * invStep + 0.5f;
+					mSamples[GetSampleIndex(x, y)] = static_cast<uint16_t>(std::min(quantized, 65535.0f));
+				}
+			}
+		}
+	}
+}
+void Heightfield::BuildLevels()
+{
+	// Level 0 has a tile per tileSize * tileSize cells, the samples on its far edges are shared with the next tiles.
+	mLevels.clear();
+	uint32_t tileCountX = DivideRoundUp(mWidth - 1, tileSize);
+	uint32_t tileCountY = DivideRoundUp(mHeight - 1, tileSize);
+	while (true)
+	{
+		Level level;
+		level.tileCountX = tileCountX;
+		level.tileCountY = tileCountY;
+		level.heightRanges.resize(tileCountX * tileCountY);
+		mLevels.push_back(std::move(level));
+
+		if ((tileCountX == 1 && tileCountY == 1) || mLevels.size() == maxLevelCount)
+			break;
+
+		tileCountX = DivideRoundUp(tileCountX, 2);
+		tileCountY = DivideRoundUp(tileCountY, 2);
+	}
+
+	// The ranges are of the quantized heights, the surface the rays hit.
+	Level& tiles = mLevels[0];
+	mJobSystem.ParallelFor(tiles.tileCountY, 1,
+		[this, &tiles](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t tileY = begin; tileY < end; tileY++)
+			{
+				for (uint32_t tileX = 0; tileX < tiles.tileCountX; tileX++)
+				{
+					uint32_t lastX = std::min((tileX + 1) * tileSize, mWidth - 1);
+					uint32_t lastY = std::min((tileY + 1) * tileSize, mHeight - 1);
+
+					float minHeight = GetSample(tileX * tileSize, tileY * tileSize);
+					float maxHeight = minHeight;
+					for (uint32_t y = tileY * tileSize; y <= lastY; y++)
+					{
+						for (uint32_t x = tileX * tileSize; x <= lastX; x++)
+						{
+							float sample = GetSample(x, y);
+							minHeight = std::min(minHeight, sample);
+							maxHeight = std::max(maxHeight, sample);
+						}
+					}
+
+					tiles.heightRanges[tileY * tiles.tileCountX + tileX] = XMFLOAT2(minHeight, maxHeight);
+				}
+			}
+		});
+
+	for (uint32_t i = 1; i < (uint32_t)mLevels.size(); i++)
+	{
+		Level& level = mLevels[i];
+		const Level& children = mLevels[i - 1];
+
+		for (uint32_t y = 0; y < level.tileCountY; y++)
+		{
+			for (uint32_t x = 0; x < level.tileCountX; x++)
+			{
+				XMFLOAT2 heightRange = children.heightRanges[2 * y * children.tileCountX + 2 * x];
+				for (uint32_t childY = 2 * y; childY < std::min(2 * y + 2, children.tileCountY); childY++)
+				{
+					for (uint32_t childX = 2 * x; childX < std::min(2 * x + 2, children.tileCountX); childX++)
+					{
+						const XMFLOAT2& childRange = children.heightRanges[childY * children.tileCountX + childX];
+						heightRange.x = std::min(heightRange.x, childRange.x);
+						heightRange.y = std::max(heightRange.y, childRange.y);
+					}
+				}
+
+				level.heightRanges[y * level.tileCountX + x] = heightRange;
+			}
+		}
+	}
+}
+
+void Heightfield::GetTileBox(uint32_t level, uint32_t x, uint32_t y, XMFLOAT3& boxMin, XMFLOAT3& boxMax)
+{
+	// In sample units, like the rays in Intersects.
+	uint32_t cellCount = tileSize << level;
+	const XMFLOAT2& heightRange = mLevels[level].heightRanges[y * mLevels[level].tileCountX + x];
+
+	boxMin = XMFLOAT3(static_cast<float>(x * cellCount), heightRange.x, static_cast<float>(y * cellCount));
+	boxMax = XMFLOAT3(static_cast<float>(std::min((x + 1) * cellCount, mWidth - 1)), heightRange.y,
+		static_cast<float>(std::min((y + 1) * cellCount, mHeight - 1)));
+}
+bool Heightfield::IntersectTile(uint32_t x, uint32_t y, const XMFLOAT3& origin, const XMFLOAT3& direction,
+	float enter, float exit, float& distance)
+{
+	uint32_t firstCellX = x * tileSize;
+	uint32_t firstCellY = y * tileSize;
+	uint32_t endCellX = std::min(firstCellX + tileSize, mWidth - 1);
+	uint32_t endCellY = std::min(firstCellY + tileSize, mHeight - 1);
+
+	// 2D DDA over the cells from where the ray enters the tile.
+	float enterX = origin.x + direction.x * enter;
+	float enterZ = origin.z + direction.z * enter;
+	int cellX = std::min(std::max(static_cast<int>(std::floor(enterX)), static_cast<int>(firstCellX)), static_cast<int>(endCellX) - 1);
+	int cellY = std::min(std::max(static_cast<int>(std::floor(enterZ)), static_cast<int>(firstCellY)), static_cast<int>(endCellY) - 1);
+
+	int stepX = direction.x > 0.0f ? 1 : -1;
+	int stepY = direction.z > 0.0f ? 1 : -1;
+	float nextX = exit, nextY = exit; // distance to the next cell border
+	float deltaX = 0.0f, deltaY = 0.0f;
+	if (direction.x != 0.0f)
+	{
+		nextX = ((direction.x > 0.0f ? cellX + 1 : cellX) - origin.x) / direction.x;
+		deltaX = std::fabs(1.0f / direction.x);
+	}
+	if (direction.z != 0.0f)
+	{
+		nextY = ((direction.z > 0.0f ? cellY + 1 : cellY) - origin.z) / direction.z;
+		deltaY = std::fabs(1.0f / direction.z);
+	}
+
+	float cellEnter = enter;
+	while (true)
+	{
+		bool stepsX = direction.x != 0.0f && (direction.z == 0.0f || nextX < nextY);
+		float cellExit = std::min(stepsX ? nextX : (direction.z != 0.0f ? nextY : exit), exit);
+
+		if (IntersectCell(cellX, cellY, origin, direction, cellEnter, cellExit, distance))
+			return true;
+		if (cellExit >= exit)
+			return false;
+
+		cellEnter = cellExit;
+		if (stepsX)
+		{
+			cellX += stepX;
+			nextX += deltaX;
+		}
+		else
+		{
+			cellY += stepY;
+			nextY += deltaY;
+		}
+
+		if (cellX < static_cast<int>(firstCellX) || cellX >= static_cast<int>(endCellX) ||
+			cellY < static_cast<int>(firstCellY) || cellY >= static_cast<int>(endCellY))
+			return false;
+	}
+}
+bool Heightfield::IntersectCell(uint32_t x, uint32_t y, const XMFLOAT3& origin, const XMFLOAT3& direction,
+	float enter, float exit, float& distance)
+{
+	float h00 = GetSample(x, y);
+	float h10 = GetSample(x + 1, y);
+	float h01 = GetSample(x, y + 1);
+	float h11 = GetSample(x + 1, y + 1);
+
+	// Height above the bilinear surface along the ray, a quadratic in s = t - enter.
+	float u = origin.x + direction.x * enter - x;
+	float v = origin.z + direction.z * enter - y;
+	float a = h10 - h00;
+	float b = h01 - h00;
+	float c = h00 - h10 - h01 + h11;
+
+	float c0 = origin.y + direction.y * enter - (h00 + a * u + b * v + c * u * v);
+	float c1 = direction.y - (a * direction.x + b * direction.z + c * (u * direction.z + v * direction.x));
+	float c2 = -c * direction.x * direction.z;
+	float length = exit - enter;
+
+	if (c0 <= 0.0f)
+	{
+		distance = enter;
+		return true;
+	}
+
+	// The first root in [0, length], with the form of the quadratic formula that is stable for small c2.
+	float root = -1.0f;
+	if (c2 == 0.0f)
+	{
+		if (c1 < 0.0f)
+			root = -c0 / c1;
+	}
+	else
+	{
+		float discriminant = c1 * c1 - 4.0f * c2 * c0;
+		if (discriminant >= 0.0f)
+		{
+			float q = -0.5f * (c1 + std::copysign(std::sqrt(discriminant), c1));
+			float root0 = q / c2;
+			float root1 = q != 0.0f ? c0 / q : -1.0f;
+			if (root0 > root1)
+				std::swap(root0, root1);
+			root = root0 >= 0.0f ? root0 : root1;
+		}
+	}
+
+	if (root >= 0.0f && root <= length)
+	{
+		distance = enter + root;
+		return true;
+	}
+
+	// Rounding can lose a root right at the exit.
+	if (c0 + (c1 + c2 * length) * length <= 0.0f)
+	{
+		distance = exit;
+		return true;
+	}
+	return false;
+}
\ No newline at end of file
@@ -0,0 +1,357 @@
+#include "../includes/ImageFilter.h"
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace
+{
+	const uint32_t rowsPerJob = 8;
+
+	double ElapsedMilliseconds(std::chrono::steady_clock::time_point start)
+	{
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	}
+
+	FilterStatistics MakeStatistics(double milliseconds, uint32_t width, uint32_t height)
+	{
+		FilterStatistics statistics;
+		statistics.milliseconds = milliseconds;
+		statistics.megapixelsPerSecond = milliseconds > 0.0 ?
+			(static_cast<double>(width) * height / 1.0e6) / (milliseconds / 1000.0) : 0.0;
+		return statistics;
+	}
+}
+
+Image::Image(uint32_t width, uint32_t height)
+{
+	Resize(width, height);
+}
+
+void Image::Resize(uint32_t width, uint32_t height)
+{
+	mWidth = width;
+	mHeight = height;
+	mPixels.resize(static_cast<size_t>(width) * height);
+}
+
+void Image::LoadRGBA8(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t rowPitch)
+{
+	Resize(width, height);
+
+	for (uint32_t y = 0; y < mHeight; y++)
+	{
+		auto source = reinterpret_cast<const XMUBYTEN4*>(pixels + static_cast<size_t>(y) * rowPitch);
+		auto destination = GetRow(y);
+
+		for (uint32_t x = 0; x < mWidth; x++)
+			XMStoreFloat4A(&destination[x], XMLoadUByteN4(&source[x]));
+	}
+}
+void Image::StoreRGBA8(uint8_t* pixels, uint32_t rowPitch) const
+{
+	for (uint32_t y = 0; y < mHeight; y++)
+	{
+		auto source = GetRow(y);
+		auto destination = reinterpret_cast<XMUBYTEN4*>(pixels + static_cast<size_t>(y) * rowPitch);
+
+		for (uint32_t x = 0; x < mWidth; x++)
+			XMStoreUByteN4(&destination[x], XMLoadFloat4A(&source[x]));
+	}
+}
+
+uint32_t Image::GetWidth() const
+{
+	return mWidth;
+}
+uint32_t Image::GetHeight() const
+{
+	return mHeight;
+}
+
+XMFLOAT4A* Image::GetRow(uint32_t y)
+{
+	return mPixels.data() + static_cast<size_t>(y) * mWidth;
+}
+const XMFLOAT4A* Image::GetRow(uint32_t y) const
+{
+	return mPixels.data() + static_cast<size_t>(y) * mWidth;
+}
+
+const std::vector<float>& GaussWeightCache::GetWeights(float sigma)
+{
+	static std::mutex cacheMutex;
+	static std::unordered_map<uint32_t, std::vector<float>> cache;
+
+	uint32_t key;
+	memcpy(&key, &sigma, sizeof(key));
+
+	std::lock_guard<std::mutex> lock(cacheMutex);
+
+	auto it = cache.find(key);
+	if (it == cache.end())
+		it = cache.insert({ key, CalculateWeights(sigma) }).first;
+
+	// References to unordered_map elements stay valid across rehashing.
+	return it->second;
+}
+
+std::vector<float> GaussWeightCache::CalculateWeights(float sigma)
+{
+	float twoSigma2 = 2.0f * sigma * sigma;
+
+	// Estimate the blur radius based on sigma since sigma controls the "width" of the bell curve.
+	int blurRadius = static_cast<int>(ceil(2.0f * sigma));
+
+	std::vector<float> weights;
+	weights.resize(2 * blurRadius + 1);
+
+	float weightSum = 0.0f;
+
+	for (int i = -blurRadius; i <= blurRadius; i++)
+	{
+		float x = static_cast<float>(i);
+
+		weights[i + blurRadius] = expf(-x * x / twoSigma2);
+
+		weightSum += weights[i + blurRadius];
+	}
+
+	// Divide by the sum so all the weights add up to 1.0.
+	for (auto& weight : weights)
+		weight /= weightSum;
+
+	return weights;
+}
+
+CpuBlurFilter::CpuBlurFilter(JobSystem& jobSystem)
+	: mJobSystem(jobSystem)
+{ }
+
+void CpuBlurFilter::Execute(const Image& input, Image& output, float sigma, int blurCount)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	const auto& weights = GaussWeightCache::GetWeights(sigma);
+
+	output = input;
+	mIntermediate.Resize(input.GetWidth(), input.GetHeight());
+
+	for (int i = 0; i < blurCount; i++)
+	{
+		HorizontalPass(output, mIntermediate, weights);
+		VerticalPass(mIntermediate, output, weights);
+	}
+
+	mStatistics = MakeStatistics(ElapsedMilliseconds(start), input.GetWidth(), input.GetHeight());
+}
+
+FilterStatistics CpuBlurFilter::GetStatistics()
+{
+	return mStatistics;
+}
+
+void CpuBlurFilter::HorizontalPass(const Image& source, Image& destination, const std::vector<float>& weights)
+{
+	int width = static_cast<int>(source.GetWidth());
+	int blurRadius = static_cast<int>(weights.size()) / 2;
+
+	std::vector<XMVECTOR> weightVectors(weights.size());
+	for (size_t i = 0; i < weights.size(); i++)
+		weightVectors[i] = XMVectorReplicate(weights[i]);
+
+	mJobSystem.ParallelFor(source.GetHeight(), rowsPerJob, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t y = begin; y < end; y++)
+		{
+			auto sourceRow = source.GetRow(y);
+			auto destinationRow = destination.GetRow(y);
+
+			for (int x = 0; x < width; x++)
+			{
+				XMVECTOR sum = XMVectorZero();
+
+				if (x >= blurRadius && x + blurRadius < width)
+				{
+					auto taps = sourceRow + (x - blurRadius);
+					for (int i = 0; i <= 2 * blurRadius; i++)
+						sum = XMVectorMultiplyAdd(weightVectors[i], XMLoadFloat4A(&taps[i]), sum);
+				}
+				else
+				{
+					// Clamp out-of-bound samples to the image borders like the compute shader.
+					for (int i = -blurRadius; i <= blurRadius; i++)
+					{
+						int sampleX = std::min(std::max(x + i, 0), width - 1);
+						sum = XMVectorMultiplyAdd(weightVectors[i + blurRadius],
+							XMLoadFloat4A(&sourceRow[sampleX]), sum);
+					}
+				}
+
+				XMStoreFloat4A(&destinationRow[x], sum);
+			}
+		}
+	});
+}
+void CpuBlurFilter::VerticalPass(const Image& source, Image& destination, const std::vector<float>& weights)
+{
+	uint32_t width = source.GetWidth();
+	int height = static_cast<int>(source.GetHeight());
+	int blurRadius = static_cast<int>(weights.size()) / 2;
+
+	std::vector<XMVECTOR> weightVectors(weights.size());
+	for (size_t i = 0; i < weights.size(); i++)
+		weightVectors[i] = XMVectorReplicate(weights[i]);
+
+	mJobSystem.ParallelFor(source.GetHeight(), rowsPerJob, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t y = begin; y < end; y++)
+		{
+			auto destinationRow = destination.GetRow(y);
+
+			// Accumulate whole rows so every tap is a sequential read.
+			for (int i = -blurRadius; i <= blurRadius; i++)
+			{
+				int sampleY = std::min(std::max(static_cast<int>(y) + i, 0), height - 1);
+				auto sourceRow = source.GetRow(static_cast<uint32_t>(sampleY));
+				XMVECTOR weight = weightVectors[i + blurRadius];
+
+				if (i == -blurRadius)
+				{
+					for (uint32_t x = 0; x < width; x++)
+						XMStoreFloat4A(&destinationRow[x], XMVectorMultiply(weight, XMLoadFloat4A(&sourceRow[x])));
+				}
+				else
+				{
+					for (uint32_t x = 0; x < width; x++)
+						XMStoreFloat4A(&destinationRow[x], XMVectorMultiplyAdd(weight,
+							XMLoadFloat4A(&sourceRow[x]), XMLoadFloat4A(&destinationRow[x])));
+				}
+			}
+		}
+	});
+}
+
+CpuSobelFilter::CpuSobelFilter(JobSystem& jobSystem)
+	: mJobSystem(jobSystem)
+{ }
+
+void CpuSobelFilter::Execute(const Image& input, Image& output)
+{
+	assert(&input != &output && "Sobel filter can't run in place.");
+
+	auto start = std::chrono::steady_clock::now();
+
+	int width = static_cast<int>(input.GetWidth());
+	int height = static_cast<int>(input.GetHeight());
+
+	output.Resize(input.GetWidth(), input.GetHeight());
+
+	const XMVECTOR luminanceWeights = XMVectorSet(0.299f, 0.587f, 0.114f, 0.0f);
+	const XMVECTOR two = XMVectorReplicate(2.0f);
+
+	mJobSystem.ParallelFor(input.GetHeight(), rowsPerJob, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t y = begin; y < end; y++)
+		{
+			const XMFLOAT4A* rows[3];
+			for (int i = 0; i < 3; i++)
+			{
+				int sampleY = static_cast<int>(y) - 1 + i;
+				rows[i] = (sampleY >= 0 && sampleY < height) ? input.GetRow(static_cast<uint32_t>(sampleY)) : nullptr;
+			}
+
+			auto destinationRow = output.GetRow(y);
+
+			for (int x = 0; x < width; x++)
+			{
+				// c[i][j]: row i, column j of the 3x3 neighborhood. Out-of-bounds loads return zero.
+				XMVECTOR c[3][3];
+				for (int i = 0; i < 3; i++)
+				{
+					for (int j = 0; j < 3; j++)
+					{
+						int sampleX = x - 1 + j;
+						c[i][j] = (rows[i] != nullptr && sampleX >= 0 && sampleX < width) ?
+							XMLoadFloat4A(&rows[i][sampleX]) : XMVectorZero();
+					}
+				}
+
+				XMVECTOR gx = (c[0][2] + c[2][2] - c[0][0] - c[2][0]) + two * (c[1][2] - c[1][0]);
+				XMVECTOR gy = (c[0][0] + c[0][2] - c[2][0] - c[2][2]) + two * (c[0][1] - c[2][1]);
+
+				XMVECTOR magnitude = XMVectorSqrt(gx * gx + gy * gy);
+				XMVECTOR luminance = XMVector3Dot(magnitude, luminanceWeights);
+
+				XMStoreFloat4A(&destinationRow[x], XMVectorSplatOne() - XMVectorSaturate(luminance));
+			}
+		}
+	});
+
+	mStatistics = MakeStatistics(ElapsedMilliseconds(start), input.GetWidth(), input.GetHeight());
+}
+
+FilterStatistics CpuSobelFilter::GetStatistics()
+{
+	return mStatistics;
+}
+
+std::vector<FilterBenchmarkResult> FilterBenchmark::Run(
+	const std::vector<std::pair<uint32_t, uint32_t>>& resolutions,
+	const std::vector<float>& sigmas,
+	int iterations)
+{
+	std::vector<FilterBenchmarkResult> results;
+
+	CpuBlurFilter blurFilter;
+	CpuSobelFilter sobelFilter;
+
+	for (const auto& resolution : resolutions)
+	{
+		Image input(resolution.first, resolution.second);
+		Image blurred;
+		Image edges;
+
+		// Deterministic noise so every run filters the same data.
+		uint32_t seed = 0x9E3779B9u;
+		for (uint32_t y = 0; y < input.GetHeight(); y++)
+		{
+			auto row = input.GetRow(y);
+			for (uint32_t x = 0; x < input.GetWidth(); x++)
+			{
+				seed = seed * 1664525u + 1013904223u;
+				float value = static_cast<float>(seed >> 8) / static_cast<float>(1u << 24);
+				row[x] = XMFLOAT4A(value, 1.0f - value, 0.5f * value, 1.0f);
+			}
+		}
+
+		for (float sigma : sigmas)
+		{
+			FilterBenchmarkResult result;
+			result.width = resolution.first;
+			result.height = resolution.second;
+			result.sigma = sigma;
+			result.blurRadius = static_cast<int>(GaussWeightCache::GetWeights(sigma).size()) / 2;
+
+			double blurMilliseconds = 0.0;
+			double sobelMilliseconds = 0.0;
+
+			for (int i = 0; i < iterations; i++)
+			{
+				blurFilter.Execute(input, blurred, sigma, 1);
+				blurMilliseconds += blurFilter.GetStatistics().milliseconds;
+
+				sobelFilter.Execute(blurred, edges);
+				sobelMilliseconds += sobelFilter.GetStatistics().milliseconds;
+			}
+
+			result.blurMegapixelsPerSecond = MakeStatistics(blurMilliseconds / iterations,
+				result.width, result.height).megapixelsPerSecond;
+			result.sobelMegapixelsPerSecond = MakeStatistics(sobelMilliseconds / iterations,
+				result.width, result.height).megapixelsPerSecond;
+
+			results.push_back(result);
+		}
+	}
+
+	return results;
+}
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include "../includes/JobSystem.h"
+
+JobSystem::JobSystem(uint32_t workerCount)
+{
+	if (workerCount == 0)
+	{
+		uint32_t hardwareThreadCount = std::thread::hardware_concurrency();
+		workerCount = hardwareThreadCount > 1 ? hardwareThreadCount - 1 : 1;
+	}
+
+	mWorkers.reserve(workerCount);
+	for (uint32_t i = 0; i < workerCount; i++)
+		mWorkers.emplace_back(&JobSystem::WorkerLoop, this);
+}
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(mJobMutex);
+		mShutdown = true;
+	}
+	mJobAvailable.notify_all();
+
+	for (auto& worker : mWorkers)
+		worker.join();
+}
+
+void JobSystem::Execute(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mJobMutex);
+		mJobs.push_back(std::move(job));
+		mPendingJobCount++;
+	}
+	mJobAvailable.notify_one();
+}
+void JobSystem::Wait()
+{
+	// Help with the queue instead of sleeping while there is work left.
+	while (RunPendingJob())
+	{ }
+
+	std::unique_lock<std::mutex> lock(mJobMutex);
+	mJobsFinished.wait(lock, [this]() { return mPendingJobCount == 0; });
+}
+
+void JobSystem::ParallelFor(uint32_t count, uint32_t grainSize,
+	const std::function<void(uint32_t, uint32_t)>& job)
+{
+	if (count == 0)
+		return;
+
+	grainSize = std::max(grainSize, 1u);
+	uint32_t chunkCount = (count + grainSize - 1) / grainSize;
+
+	if (chunkCount == 1)
+	{
+		job(0, count);
+		return;
+	}
+
+	// Shared so that helpers picked up after this call returned only touch valid memory.
+	struct ParallelForState
+	{
+		std::function<void(uint32_t, uint32_t)> job;
+		std::atomic<uint32_t> nextChunk{ 0 };
+		std::atomic<uint32_t> finishedChunks{ 0 };
+		std::mutex mutex;
+		std::condition_variable finished;
+	};
+
+	auto state = std::make_shared<ParallelForState>();
+	state->job = job;
+
+	auto runChunks = [state, count, grainSize, chunkCount]()
+	{
+		uint32_t chunk;
+		while ((chunk = state->nextChunk.fetch_add(1)) < chunkCount)
+		{
+			uint32_t begin = chunk * grainSize;
+			uint32_t end = std::min(begin + grainSize, count);
+			state->job(begin, end);
+
+			if (state->finishedChunks.fetch_add(1) + 1 == chunkCount)
+			{
+				std::lock_guard<std::mutex> lock(state->mutex);
+				state->finished.notify_all();
+			}
+		}
+	};
+
+	uint32_t helperCount = std::min(static_cast<uint32_t>(mWorkers.size()), chunkCount - 1);
+	for (uint32_t i = 0; i < helperCount; i++)
+		Execute(runChunks);
+
+	runChunks();
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->finished.wait(lock, [&state, chunkCount]() { return state->finishedChunks.load() == chunkCount; });
+}
+
+uint32_t JobSystem::GetWorkerCount()
+{
+	return static_cast<uint32_t>(mWorkers.size());
+}
+uint32_t JobSystem::GetThreadCount()
+{
+	return static_cast<uint32_t>(mWorkers.size()) + 1;
+}
+
+JobSystem& JobSystem::GetDefault()
+{
+	static JobSystem jobSystem;
+	return jobSystem;
+}
+
+void JobSystem::WorkerLoop()
+{
+	while (true)
+	{
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(mJobMutex);
+			mJobAvailable.wait(lock, [this]() { return mShutdown || !mJobs.empty(); });
+
+			if (mShutdown && mJobs.empty())
+				return;
+
+			job = std::move(mJobs.front());
+			mJobs.pop_front();
+		}
+
+		job();
+
+		std::lock_guard<std::mutex> lock(mJobMutex);
+		if (--mPendingJobCount == 0)
+			mJobsFinished.notify_all();
+	}
+}
+bool JobSystem::RunPendingJob()
+{
+	std::function<void()> job;
+	{
+		std::lock_guard<std::mutex> lock(mJobMutex);
+		if (mJobs.empty())
+			return false;
+
+		job = std::move(mJobs.front());
+		mJobs.pop_front();
+	}
+
+	job();
+
+	std::lock_guard<std::mutex> lock(mJobMutex);
+	if (--mPendingJobCount == 0)
+		mJobsFinished.notify_all();
+
+	return true;
+}
\ No newline at end of file
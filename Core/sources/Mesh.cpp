@@ -7,37 +7,101 @@ Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& ind
 {
 	vertexByteSize = (UINT)mVertices.size() * sizeof(Vertex);
 	indexByteSize = (UINT)mIndices.size() * sizeof(uint32_t);
+	mIndexCount = (UINT)mIndices.size();
+}
+Mesh::Mesh(const MeshData& meshData)
+	: Mesh(meshData.vertices, meshData.indices,
+		meshData.topology == PrimitiveTopology::PatchList4 ?
+		D3D_PRIMITIVE_TOPOLOGY_4_CONTROL_POINT_PATCHLIST : D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST)
+{
+
 }
 
 void Mesh::ConfigureMesh(ID3D12Device* device, ID3D12GraphicsCommandList* commandList)
 {
 	CreateVertexBuffer(device, commandList);
 	CreateIndexBuffer(device, commandList);
+	CreateBufferViews();
+
+	CreateBoundingBox();
+	CreateBoundingSphere();
+}
+void Mesh::ConfigureMesh(ID3D12Device* device, GeometryUploader& uploader)
+{
+	mVertexBuffer = D3D12Utility::CreateDefaultBuffer(device, vertexByteSize);
+	uploader.Upload(mVertexBuffer.Get(), 0, mVertices.data(), vertexByteSize);
+
+	mIndexBuffer = D3D12Utility::CreateDefaultBuffer(device, indexByteSize);
+	uploader.Upload(mIndexBuffer.Get(), 0, mIndices.data(), indexByteSize);
+
+	CreateBufferViews();
 
 	CreateBoundingBox();
 	CreateBoundingSphere();
 }
+void Mesh::ConfigureMesh(GeometryPool& pool, GeometryUploader& uploader)
+{
+	mGeometryPool = &pool;
+	mGeometryHandle = pool.Add(mVertices, mIndices, uploader);
+
+	CreateBoundingBox();
+	CreateBoundingSphere();
+}
+void Mesh::ReleaseCpuData()
+{
+	std::vector<Vertex>().swap(mVertices);
+	std::vector<uint32_t>().swap(mIndices);
+}
 
 ID3D12Resource* Mesh::GetVertexBuffer()
 {
+	if (mGeometryPool != nullptr)
+		return mGeometryPool->GetVertexBuffer();
 	return mVertexBuffer.Get();
 }
 D3D12_VERTEX_BUFFER_VIEW Mesh::GetVertexBufferView()
 {
+	if (mGeometryPool != nullptr)
+		return mGeometryPool->GetVertexBufferView();
 	return mVertexBufferView;
 }
 
 ID3D12Resource* Mesh::GetIndexBuffer()
 {
+	if (mGeometryPool != nullptr)
+		return mGeometryPool->GetIndexBuffer();
 	return mIndexBuffer.Get();
 }
 D3D12_INDEX_BUFFER_VIEW Mesh::GetIndexBufferView()
 {
+	if (mGeometryPool != nullptr)
+		return mGeometryPool->GetIndexBufferView();
 	return mIndexBufferView;
 }
 UINT Mesh::GetIndexCount()
 {
-	return static_cast<UINT>(mIndices.size());
+	return mIndexCount;
+}
+UINT Mesh::GetStartIndexLocation()
+{
+	if (mGeometryPool != nullptr)
+		return mGeometryPool->GetRange(mGeometryHandle).startIndex;
+	return 0;
+}
+INT Mesh::GetBaseVertexLocation()
+{
+	if (mGeometryPool != nullptr)
+		return static_cast<INT>(mGeometryPool->GetRange(mGeometryHandle).baseVertex);
+	return 0;
+}
+
+const std::vector<Vertex>& Mesh::GetVertices()
+{
+	return mVertices;
+}
+const std::vector<uint32_t>& Mesh::GetIndices()
+{
+	return mIndices;
 }
 
 D3D_PRIMITIVE_TOPOLOGY Mesh::GetPrimitiveType()
@@ -58,15 +122,17 @@ void Mesh::CreateVertexBuffer(ID3D12Device* device, ID3D12GraphicsCommandList* c
 {
 	mVertexBuffer = D3D12Utility::CreateDefaultBuffer(device, commandList,
 		mVertices.data(), vertexByteSize, mVertexBufferUpload);
-
-	mVertexBufferView.BufferLocation = mVertexBuffer->GetGPUVirtualAddress();
-	mVertexBufferView.SizeInBytes = vertexByteSize;
-	mVertexBufferView.StrideInBytes = sizeof(Vertex);
 }
 void Mesh::CreateIndexBuffer(ID3D12Device* device, ID3D12GraphicsCommandList* commandList)
 {
 	mIndexBuffer = D3D12Utility::CreateDefaultBuffer(device, commandList,
 		mIndices.data(), indexByteSize, mIndexBufferUpload);
+}
+void Mesh::CreateBufferViews()
+{
+	mVertexBufferView.BufferLocation = mVertexBuffer->GetGPUVirtualAddress();
+	mVertexBufferView.SizeInBytes = vertexByteSize;
+	mVertexBufferView.StrideInBytes = sizeof(Vertex);
 
 	mIndexBufferView.BufferLocation = mIndexBuffer->GetGPUVirtualAddress();
 	mIndexBufferView.Format = indexFormat;
@@ -14,7 +14,8 @@ void Model::LoadModel(const std::string& path)
 	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
 		throw std::runtime_error("Cannot read the model!");
 
-	ProcessNode(scene->mRootNode, scene);
+	ProcessNode(scene->mRootNode, scene, TransformHierarchy::invalidNode);
+	mHierarchy.UpdateWorldMatrices();
 }
 
 std::vector<Mesh> Model::GetMeshes()
@@ -26,16 +27,39 @@ std::vector<Texture> Model::GetRawTextures()
 	return mRawTextures;
 }
 
-void Model::ProcessNode(aiNode* node, const aiScene* scene)
+TransformHierarchy& Model::GetHierarchy()
 {
+	return mHierarchy;
+}
+uint32_t Model::GetMeshNode(uint32_t meshIndex)
+{
+	return mMeshNodes[meshIndex];
+}
+DirectX::XMFLOAT4X4 Model::GetMeshWorld(uint32_t meshIndex)
+{
+	return mHierarchy.GetWorld(mMeshNodes[meshIndex]);
+}
+
+void Model::ProcessNode(aiNode* node, const aiScene* scene, uint32_t parentNode)
+{
+	// Assimp matrices are column vector, transpose to the row vector convention of DirectXMath.
+	const aiMatrix4x4& m = node->mTransformation;
+	DirectX::XMFLOAT4X4 local(
+		m.a1, m.b1, m.c1, m.d1,
+		m.a2, m.b2, m.c2, m.d2,
+		m.a3, m.b3, m.c3, m.d3,
+		m.a4, m.b4, m.c4, m.d4);
+	uint32_t nodeIndex = mHierarchy.AddNode(parentNode, local);
+
 	for (UINT i = 0; i < node->mNumMeshes; i++)
 	{
 		auto meshIndex = node->mMeshes[i];
 		mMeshes.push_back(ProcessMesh(scene->mMeshes[meshIndex], scene));
+		mMeshNodes.push_back(nodeIndex);
 	}
 
 	for (UINT i = 0; i < node->mNumChildren; i++)
-		ProcessNode(node->mChildren[i], scene);
+		ProcessNode(node->mChildren[i], scene, nodeIndex);
 }
 Mesh Model::ProcessMesh(aiMesh* mesh, const aiScene* scene)
 {
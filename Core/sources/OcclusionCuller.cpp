@@ -0,0 +1,413 @@
+#include "../includes/OcclusionCuller.h"
+using namespace DirectX;
+
+namespace
+{
+	const uint32_t verticesPerJob = 1024;
+	const uint32_t maxTestLevelTexels = 4; // per axis, the level is chosen so the box covers at most 4x4 texels
+
+	double ElapsedMilliseconds(std::chrono::steady_clock::time_point start)
+	{
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	}
+}
+
+OcclusionCuller::OcclusionCuller(uint32_t width, uint32_t height, JobSystem& jobSystem)
+	: mJobSystem(jobSystem)
+{
+	XMStoreFloat4x4(&mViewProj, XMMatrixIdentity());
+	Resize(width, height);
+}
+
+void OcclusionCuller::Resize(uint32_t width, uint32_t height)
+{
+	assert(width > 0 && height > 0);
+
+	mWidth = (width + 3) & ~3u;
+	mHeight = height;
+
+	mLevels.clear();
+	mLevelWidths.clear();
+	mLevelHeights.clear();
+
+	uint32_t levelWidth = mWidth;
+	uint32_t levelHeight = mHeight;
+	while (true)
+	{
+		mLevels.emplace_back(levelWidth * levelHeight, 1.0f);
+		mLevelWidths.push_back(levelWidth);
+		mLevelHeights.push_back(levelHeight);
+
+		if (levelWidth == 1 && levelHeight == 1)
+			break;
+
+		levelWidth = std::max((levelWidth + 1) / 2, 1u);
+		levelHeight = std::max((levelHeight + 1) / 2, 1u);
+	}
+}
+
+uint32_t OcclusionCuller::AddOccluder(const MeshData& meshData, const XMFLOAT4X4& world)
+{
+	assert(meshData.topology == PrimitiveTopology::TriangleList && meshData.indices.size() % 3 == 0);
+
+	Occluder occluder;
+	occluder.positions.reserve(meshData.vertices.size());
+	for (const auto& vertex : meshData.vertices)
+		occluder.positions.push_back(vertex.position);
+	occluder.indices = meshData.indices;
+	occluder.world = world;
+
+	mOccluders.push_back(std::move(occluder));
+	return static_cast<uint32_t>(mOccluders.size() - 1);
+}
+void OcclusionCuller::SetOccluderWorld(uint32_t occluder, const XMFLOAT4X4& world)
+{
+	mOccluders[occluder].world = world;
+}
+void OcclusionCuller::ClearOccluders()
+{
+	mOccluders.clear();
+}
+
+void OcclusionCuller::RenderOccluders(const XMFLOAT4X4& viewProj)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	mViewProj = viewProj;
+	mStatistics = OcclusionCullerStatistics();
+	mStatistics.occluderCount = static_cast<uint32_t>(mOccluders.size());
+
+	std::fill(mLevels[0].begin(), mLevels[0].end(), 1.0f);
+	mTriangles.clear();
+
+	XMMATRIX viewProjMatrix = XMLoadFloat4x4(&viewProj);
+	for (const auto& occluder : mOccluders)
+	{
+		XMMATRIX worldViewProj = XMMatrixMultiply(XMLoadFloat4x4(&occluder.world), viewProjMatrix);
+
+		mClipVertices.resize(occluder.positions.size());
+		mJobSystem.ParallelFor(static_cast<uint32_t>(occluder.positions.size()), verticesPerJob,
+			[&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; i++)
+					XMStoreFloat4(&mClipVertices[i], XMVector3Transform(XMLoadFloat3(&occluder.positions[i]), worldViewProj));
+			});
+
+		for (size_t i = 0; i < occluder.indices.size(); i += 3)
+		{
+			XMFLOAT4 triangle[3] =
+			{
+				mClipVertices[occluder.indices[i + 0]],
+				mClipVertices[occluder.indices[i + 1]],
+				mClipVertices[occluder.indices[i + 2]]
+			};
+			SetupTriangle(triangle);
+		}
+
+		mStatistics.occluderTriangleCount += static_cast<uint32_t>(occluder.indices.size() / 3);
+	}
+	mStatistics.rasterizedTriangleCount = static_cast<uint32_t>(mTriangles.size());
+
+	// Bands own disjoint rows, so they write the depth buffer without synchronization.
+	uint32_t bandCount = (mHeight + bandHeight - 1) / bandHeight;
+	mJobSystem.ParallelFor(bandCount, 1,
+		[this](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t band = begin; band < end; band++)
+				RasterizeBand(band);
+		});
+
+	BuildLevels();
+
+	mStatistics.rasterMilliseconds = ElapsedMilliseconds(start);
+}
+
+bool OcclusionCuller::IsVisible(const BoundingBox& worldBounds)
+{
+	XMMATRIX viewProj = XMLoadFloat4x4(&mViewProj);
+	XMVECTOR center = XMLoadFloat3(&worldBounds.Center);
+	XMVECTOR extents = XMLoadFloat3(&worldBounds.Extents);
+
+	XMVECTOR screenMin = XMVectorSplatInfinity();
+	XMVECTOR screenMax = XMVectorNegate(screenMin);
+	const XMVECTOR screenScale = XMVectorSet(0.5f * mWidth, -0.5f * mHeight, 1.0f, 0.0f);
+	const XMVECTOR screenOffset = XMVectorSet(0.5f * mWidth, 0.5f * mHeight, 0.0f, 0.0f);
+
+	for (uint32_t corner = 0; corner < 8; corner++)
+	{
+		XMVECTOR sign = XMVectorSet((corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f, (corner & 4) ? 1.0f : -1.0f, 0.0f);
+		XMVECTOR clip = XMVector3Transform(XMVectorMultiplyAdd(sign, extents, center), viewProj);
+
+		// In front of the near plane, the projection isn't bounded anymore.
+		if (XMVectorGetZ(clip) < 0.0f)
+			return true;
+
+		XMVECTOR screen = XMVectorMultiplyAdd(XMVectorDivide(clip, XMVectorSplatW(clip)), screenScale, screenOffset);
+		screenMin = XMVectorMin(screenMin, screen);
+		screenMax = XMVectorMax(screenMax, screen);
+	}
+
+	XMFLOAT3 boundsMin;
+	XMFLOAT3 boundsMax;
+	XMStoreFloat3(&boundsMin, screenMin);
+	XMStoreFloat3(&boundsMax, screenMax);
+
+	if (boundsMax.x < 0.0f || boundsMax.y < 0.0f || boundsMin.x >= mWidth || boundsMin.y >= mHeight)
+		return false;
+
+	// Every pixel the box touches, the nearest depth of the box against the farthest occluder depth.
+	// A pixel is covered when its center is, so the box can still show through the part of a covered pixel
+	// next to the occluder's edge. The neighbouring pixel across that edge is uncovered, test one more pixel on each side.
+	uint32_t minX = static_cast<uint32_t>(std::max(boundsMin.x - 1.0f, 0.0f));
+	uint32_t minY = static_cast<uint32_t>(std::max(boundsMin.y - 1.0f, 0.0f));
+	uint32_t maxX = static_cast<uint32_t>(std::min(boundsMax.x + 1.0f, static_cast<float>(mWidth - 1)));
+	uint32_t maxY = static_cast<uint32_t>(std::min(boundsMax.y + 1.0f, static_cast<float>(mHeight - 1)));
+	float nearestDepth = boundsMin.z;
+
+	uint32_t level = 0;
+	while (level + 1 < GetLevelCount() &&
+		((maxX >> level) - (minX >> level) >= maxTestLevelTexels || (maxY >> level) - (minY >> level) >= maxTestLevelTexels))
+		level++;
+
+	const auto& depths = mLevels[level];
+	uint32_t levelWidth = mLevelWidths[level];
+	for (uint32_t y = minY >> level; y <= maxY >> level; y++)
+	{
+		for (uint32_t x = minX >> level; x <= maxX >> level; x++)
+		{
+			if (nearestDepth <= depths[y * levelWidth + x])
+				return true;
+		}
+	}
+
+	return false;
+}
+uint32_t OcclusionCuller::TestVisibility(const BoundingBox* worldBounds, uint32_t count, uint8_t* visible)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	mJobSystem.ParallelFor(count, testsPerJob,
+		[&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; i++)
+				visible[i] = IsVisible(worldBounds[i]) ? 1 : 0;
+		});
+
+	uint32_t visibleCount = 0;
+	for (uint32_t i = 0; i < count; i++)
+		visibleCount += visible[i];
+
+	mStatistics.testedCount += count;
+	mStatistics.culledCount += count - visibleCount;
+	mStatistics.culledPercentage = mStatistics.testedCount > 0 ?
+		100.0f * mStatistics.culledCount / mStatistics.testedCount : 0.0f;
+	mStatistics.testMilliseconds += ElapsedMilliseconds(start);
+
+	return visibleCount;
+}
+
+uint32_t OcclusionCuller::GetWidth()
+{
+	return mWidth;
+}
+uint32_t OcclusionCuller::GetHeight()
+{
+	return mHeight;
+}
+uint32_t OcclusionCuller::GetLevelCount()
+{
+	return static_cast<uint32_t>(mLevels.size());
+}
+const std::vector<float>& OcclusionCuller::GetDepthLevel(uint32_t level)
+{
+	return mLevels[level];
+}
+
+OcclusionCullerStatistics OcclusionCuller::GetStatistics()
+{
+	return mStatistics;
+}
+
+void OcclusionCuller::SetupTriangle(const XMFLOAT4* clipVertices)
+{
+	XMVECTOR vertices[3] =
+	{
+		XMLoadFloat4(&clipVertices[0]),
+		XMLoadFloat4(&clipVertices[1]),
+		XMLoadFloat4(&clipVertices[2])
+	};
+
+	int insideCount = 0;
+	for (int i = 0; i < 3; i++)
+		insideCount += XMVectorGetZ(vertices[i]) >= 0.0f ? 1 : 0;
+
+	if (insideCount == 0)
+		return;
+	if (insideCount == 3)
+	{
+		EmitTriangle(vertices[0], vertices[1], vertices[2]);
+		return;
+	}
+
+	// Clip against the near plane (z >= 0), the result is a triangle or a quad.
+	XMVECTOR clipped[4];
+	int clippedCount = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		XMVECTOR current = vertices[i];
+		XMVECTOR next = vertices[(i + 1) % 3];
+		float currentZ = XMVectorGetZ(current);
+		float nextZ = XMVectorGetZ(next);
+
+		if (currentZ >= 0.0f)
+			clipped[clippedCount++] = current;
+		if ((currentZ >= 0.0f) != (nextZ >= 0.0f))
+			clipped[clippedCount++] = XMVectorLerp(current, next, currentZ / (currentZ - nextZ));
+	}
+
+	for (int i = 1; i + 1 < clippedCount; i++)
+		EmitTriangle(clipped[0], clipped[i], clipped[i + 1]);
+}
+void OcclusionCuller::EmitTriangle(FXMVECTOR v0, FXMVECTOR v1, FXMVECTOR v2)
+{
+	const XMVECTOR screenScale = XMVectorSet(0.5f * mWidth, -0.5f * mHeight, 1.0f, 0.0f);
+	const XMVECTOR screenOffset = XMVectorSet(0.5f * mWidth, 0.5f * mHeight, 0.0f, 0.0f);
+
+	XMFLOAT3 screen[3];
+	XMStoreFloat3(&screen[0], XMVectorMultiplyAdd(XMVectorDivide(v0, XMVectorSplatW(v0)), screenScale, screenOffset));
+	XMStoreFloat3(&screen[1], XMVectorMultiplyAdd(XMVectorDivide(v1, XMVectorSplatW(v1)), screenScale, screenOffset));
+	XMStoreFloat3(&screen[2], XMVectorMultiplyAdd(XMVectorDivide(v2, XMVectorSplatW(v2)), screenScale, screenOffset));
+
+	float area = (screen[1].x - screen[0].x) * (screen[2].y - screen[0].y) -
+		(screen[2].x - screen[0].x) * (screen[1].y - screen[0].y);
+	if (std::fabs(area) < 1.0e-6f)
+		return;
+
+	// Both faces occlude, make the winding consistent so the edge functions are positive inside.
+	if (area < 0.0f)
+	{
+		std::swap(screen[1], screen[2]);
+		area = -area;
+	}
+
+	float minX = std::min(std::min(screen[0].x, screen[1].x), screen[2].x);
+	float maxX = std::max(std::max(screen[0].x, screen[1].x), screen[2].x);
+	float minY = std::min(std::min(screen[0].y, screen[1].y), screen[2].y);
+	float maxY = std::max(std::max(screen[0].y, screen[1].y), screen[2].y);
+	if (maxX < 0.0f || maxY < 0.0f || minX >= mWidth || minY >= mHeight)
+		return;
+
+	// Rows whose pixel centers can be covered.
+	float firstRow = std::max(std::ceil(minY - 0.5f), 0.0f);
+	float lastRow = std::min(std::floor(maxY - 0.5f), static_cast<float>(mHeight - 1));
+	if (firstRow > lastRow)
+		return;
+
+	ScreenTriangle triangle;
+	for (int i = 0; i < 3; i++)
+	{
+		triangle.x[i] = screen[i].x;
+		triangle.y[i] = screen[i].y;
+	}
+
+	float dz1 = screen[1].z - screen[0].z;
+	float dz2 = screen[2].z - screen[0].z;
+	triangle.depthX = (dz1 * (screen[2].y - screen[0].y) - dz2 * (screen[1].y - screen[0].y)) / area;
+	triangle.depthY = (dz2 * (screen[1].x - screen[0].x) - dz1 * (screen[2].x - screen[0].x)) / area;
+	triangle.depthOffset = screen[0].z - triangle.depthX * screen[0].x - triangle.depthY * screen[0].y;
+	// The farthest depth of the plane over the pixel rather than the depth at its center.
+	triangle.depthOffset += 0.5f * (std::fabs(triangle.depthX) + std::fabs(triangle.depthY));
+
+	triangle.minY = static_cast<uint32_t>(firstRow);
+	triangle.maxY = static_cast<uint32_t>(lastRow);
+
+	mTriangles.push_back(triangle);
+}
+void OcclusionCuller::RasterizeBand(uint32_t band)
+{
+	uint32_t bandMinY = band * bandHeight;
+	uint32_t bandMaxY = std::min(bandMinY + bandHeight, mHeight) - 1;
+	float* depths = mLevels[0].data();
+
+	const XMVECTOR pixelOffsets = XMVectorSet(0.5f, 1.5f, 2.5f, 3.5f);
+	const XMVECTOR zero = XMVectorZero();
+
+	for (const auto& triangle : mTriangles)
+	{
+		if (triangle.maxY < bandMinY || triangle.minY > bandMaxY)
+			continue;
+
+		// Edge i goes from vertex i to vertex i + 1, edge(x, y) = a * x + b * y + c is >= 0 inside.
+		XMVECTOR edgeA[3];
+		float edgeB[3];
+		float edgeC[3];
+		for (int i = 0; i < 3; i++)
+		{
+			int j = (i + 1) % 3;
+			edgeA[i] = XMVectorReplicate(triangle.y[i] - triangle.y[j]);
+			edgeB[i] = triangle.x[j] - triangle.x[i];
+			edgeC[i] = triangle.x[i] * triangle.y[j] - triangle.x[j] * triangle.y[i];
+		}
+
+		float minX = std::min(std::min(triangle.x[0], triangle.x[1]), triangle.x[2]);
+		float maxX = std::max(std::max(triangle.x[0], triangle.x[1]), triangle.x[2]);
+		uint32_t firstX = static_cast<uint32_t>(std::max(minX, 0.0f)) & ~3u;
+		uint32_t lastX = static_cast<uint32_t>(std::min(maxX, static_cast<float>(mWidth - 1)));
+
+		XMVECTOR depthX = XMVectorReplicate(triangle.depthX);
+
+		uint32_t firstY = std::max(triangle.minY, bandMinY);
+		uint32_t lastY = std::min(triangle.maxY, bandMaxY);
+		for (uint32_t y = firstY; y <= lastY; y++)
+		{
+			float pixelY = y + 0.5f;
+			XMVECTOR rowEdge0 = XMVectorReplicate(edgeB[0] * pixelY + edgeC[0]);
+			XMVECTOR rowEdge1 = XMVectorReplicate(edgeB[1] * pixelY + edgeC[1]);
+			XMVECTOR rowEdge2 = XMVectorReplicate(edgeB[2] * pixelY + edgeC[2]);
+			XMVECTOR rowDepth = XMVectorReplicate(triangle.depthY * pixelY + triangle.depthOffset);
+
+			float* row = depths + y * mWidth;
+			for (uint32_t x = firstX; x <= lastX; x += 4)
+			{
+				XMVECTOR pixelX = XMVectorAdd(XMVectorReplicate(static_cast<float>(x)), pixelOffsets);
+
+				XMVECTOR inside = XMVectorGreaterOrEqual(XMVectorMultiplyAdd(edgeA[0], pixelX, rowEdge0), zero);
+				inside = XMVectorAndInt(inside, XMVectorGreaterOrEqual(XMVectorMultiplyAdd(edgeA[1], pixelX, rowEdge1), zero));
+				inside = XMVectorAndInt(inside, XMVectorGreaterOrEqual(XMVectorMultiplyAdd(edgeA[2], pixelX, rowEdge2), zero));
+
+				XMVECTOR depth = XMVectorMultiplyAdd(depthX, pixelX, rowDepth);
+				XMVECTOR current = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(row + x));
+				XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(row + x), XMVectorSelect(current, XMVectorMin(current, depth), inside));
+			}
+		}
+	}
+}
+void OcclusionCuller::BuildLevels()
+{
+	for (size_t level = 1; level < mLevels.size(); level++)
+	{
+		const auto& source = mLevels[level - 1];
+		uint32_t sourceWidth = mLevelWidths[level - 1];
+		uint32_t sourceHeight = mLevelHeights[level - 1];
+
+		auto& destination = mLevels[level];
+		uint32_t width = mLevelWidths[level];
+		uint32_t height = mLevelHeights[level];
+
+		for (uint32_t y = 0; y < height; y++)
+		{
+			uint32_t y0 = 2 * y;
+			uint32_t y1 = std::min(2 * y + 1, sourceHeight - 1);
+			for (uint32_t x = 0; x < width; x++)
+			{
+				uint32_t x0 = 2 * x;
+				uint32_t x1 = std::min(2 * x + 1, sourceWidth - 1);
+
+				destination[y * width + x] = std::max(
+					std::max(source[y0 * sourceWidth + x0], source[y0 * sourceWidth + x1]),
+					std::max(source[y1 * sourceWidth + x0], source[y1 * sourceWidth + x1]));
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,371 @@
+#include "../includes/Profiler.h"
+
+thread_local uint32_t CpuProfileScope::sDepth = 0;
+thread_local Profiler::ThreadBuffer* Profiler::sThreadBuffer = nullptr;
+
+namespace
+{
+	// Scopes are merged by call path. Names are compared by pointer, which is enough for string literals.
+	struct NodeKey
+	{
+		int parent;
+		uint32_t threadIndex;
+		const char* name;
+
+		bool operator==(const NodeKey& rhs) const
+		{
+			return parent == rhs.parent && threadIndex == rhs.threadIndex && name == rhs.name;
+		}
+	};
+
+	struct NodeKeyHash
+	{
+		std::size_t operator()(const NodeKey& key) const
+		{
+			return std::hash<const char*>()(key.name) ^
+				(std::hash<int>()(key.parent) * 31) ^ (std::hash<uint32_t>()(key.threadIndex) * 131);
+		}
+	};
+
+	std::string EscapeJson(const char* text)
+	{
+		std::string result;
+		for (const char* c = text; *c != '\0'; c++)
+		{
+			if (*c == '"' || *c == '\\')
+				result += '\\';
+			result += *c;
+		}
+		return result;
+	}
+}
+
+Profiler::Profiler()
+{
+	Calibrate();
+	mCurrentFrame.begin = mStartTicks;
+}
+
+double Profiler::GetTicksPerSecond()
+{
+	return mTicksPerSecond;
+}
+double Profiler::TicksToMilliseconds(uint64_t ticks)
+{
+	return static_cast<double>(ticks) * 1000.0 / mTicksPerSecond;
+}
+double Profiler::TicksToMicroseconds(uint64_t ticks)
+{
+	return static_cast<double>(ticks) * 1000000.0 / mTicksPerSecond;
+}
+
+void Profiler::SetEnabled(bool enabled)
+{
+	mEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Profiler::SetThreadName(const std::string& name)
+{
+	auto buffer = GetThreadBuffer();
+
+	std::lock_guard<std::mutex> lock(mThreadMutex);
+	buffer->name = name;
+}
+
+void Profiler::BeginFrame()
+{
+	mCurrentFrame.frameNumber = mFrameNumber;
+	mCurrentFrame.begin = Now();
+}
+void Profiler::EndFrame()
+{
+	mCurrentFrame.end = Now();
+
+	{
+		std::lock_guard<std::mutex> lock(mThreadMutex);
+
+		for (auto& buffer : mThreadBuffers)
+		{
+			uint32_t tail = buffer->tail.load(std::memory_order_relaxed);
+			uint32_t head = buffer->head.load(std::memory_order_acquire);
+
+			for (; tail != head; tail++)
+				mCurrentFrame.cpuEvents.push_back(buffer->events[tail & (ringCapacity - 1)]);
+
+			buffer->tail.store(tail, std::memory_order_release);
+			mCurrentFrame.droppedEventCount += buffer->droppedEventCount.exchange(0, std::memory_order_relaxed);
+		}
+	}
+
+	// Refine the tick rate, the calibration at startup only covers a short interval.
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - mStartTime;
+	if (elapsed.count() > 0.1)
+		mTicksPerSecond = static_cast<double>(Now() - mStartTicks) / elapsed.count();
+
+	BuildNodes(mCurrentFrame);
+
+	mCapturedFrames.push_back(std::move(mCurrentFrame));
+	if (mCapturedFrames.size() > maxCapturedFrameCount)
+		mCapturedFrames.pop_front();
+
+	mCurrentFrame = ProfileFrame();
+	mFrameNumber++;
+}
+
+const ProfileFrame& Profiler::GetLastFrame()
+{
+	return mCapturedFrames.empty() ? mEmptyFrame : mCapturedFrames.back();
+}
+uint64_t Profiler::GetFrameNumber()
+{
+	return mFrameNumber;
+}
+
+void Profiler::AddGpuEvents(const std::vector<ProfileEvent>& events)
+{
+	mCurrentFrame.gpuEvents.insert(mCurrentFrame.gpuEvents.end(), events.begin(), events.end());
+}
+
+bool Profiler::ExportChromeTrace(const std::string& filename)
+{
+	std::ofstream file(filename);
+	if (!file)
+		return false;
+
+	file << "{\"traceEvents\":[\n";
+	bool first = true;
+
+	auto writeEvent = [&](const ProfileEvent& event, int processId, uint32_t threadId)
+	{
+		if (!first)
+			file << ",\n";
+		first = false;
+
+		uint64_t begin = event.begin > mStartTicks ? event.begin - mStartTicks : 0;
+		uint64_t duration = event.end > event.begin ? event.end - event.begin : 0;
+
+		file << "{\"name\":\"" << EscapeJson(event.name) << "\",\"ph\":\"X\",\"pid\":" << processId
+			<< ",\"tid\":" << threadId << ",\"ts\":" << TicksToMicroseconds(begin)
+			<< ",\"dur\":" << TicksToMicroseconds(duration) << "}";
+	};
+
+	{
+		std::lock_guard<std::mutex> lock(mThreadMutex);
+
+		for (auto& buffer : mThreadBuffers)
+		{
+			std::string name = buffer->name.empty() ?
+				"Thread " + std::to_string(buffer->threadIndex) : buffer->name;
+
+			if (!first)
+				file << ",\n";
+			first = false;
+
+			file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->threadIndex
+				<< ",\"args\":{\"name\":\"" << EscapeJson(name.c_str()) << "\"}}";
+		}
+	}
+
+	file << (first ? "" : ",\n") << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+		<< "\"args\":{\"name\":\"GPU\"}}";
+	first = false;
+
+	for (const auto& frame : mCapturedFrames)
+	{
+		for (const auto& event : frame.cpuEvents)
+			writeEvent(event, 0, event.threadIndex);
+		for (const auto& event : frame.gpuEvents)
+			writeEvent(event, 1, 0);
+	}
+
+	file << "\n]}\n";
+	return static_cast<bool>(file);
+}
+
+Profiler::ThreadBuffer* Profiler::GetThreadBuffer()
+{
+	if (sThreadBuffer == nullptr)
+	{
+		std::lock_guard<std::mutex> lock(mThreadMutex);
+
+		// Buffers are never freed, a thread that exits just stops producing.
+		mThreadBuffers.push_back(std::unique_ptr<ThreadBuffer>(new ThreadBuffer()));
+		mThreadBuffers.back()->threadIndex = static_cast<uint32_t>(mThreadBuffers.size() - 1);
+		sThreadBuffer = mThreadBuffers.back().get();
+	}
+
+	return sThreadBuffer;
+}
+
+void Profiler::Calibrate()
+{
+	mStartTime = std::chrono::steady_clock::now();
+	mStartTicks = Now();
+
+	// Spin for a millisecond to get a first estimate, EndFrame refines it.
+	std::chrono::steady_clock::time_point now;
+	do
+	{
+		now = std::chrono::steady_clock::now();
+	} while (now - mStartTime < std::chrono::milliseconds(1));
+
+	std::chrono::duration<double> elapsed = now - mStartTime;
+	mTicksPerSecond = static_cast<double>(Now() - mStartTicks) / elapsed.count();
+}
+
+void Profiler::BuildNodes(ProfileFrame& frame)
+{
+	// Scopes are recorded when they end, so sort them back into call order per thread.
+	std::vector<ProfileEvent> events = frame.cpuEvents;
+	std::sort(events.begin(), events.end(),
+		[](const ProfileEvent& a, const ProfileEvent& b)
+		{
+			if (a.threadIndex != b.threadIndex)
+				return a.threadIndex < b.threadIndex;
+			if (a.begin != b.begin)
+				return a.begin < b.begin;
+			return a.depth < b.depth;
+		});
+
+	frame.nodes.clear();
+
+	std::unordered_map<NodeKey, int, NodeKeyHash> nodeIndices;
+	std::vector<int> stack; // node index per depth of the current thread
+	uint32_t currentThread = 0xffffffff;
+
+	for (const auto& event : events)
+	{
+		if (event.threadIndex != currentThread)
+		{
+			currentThread = event.threadIndex;
+			stack.clear();
+		}
+
+		// Scopes that started before profiling was enabled can leave gaps in the depth.
+		uint32_t depth = std::min(event.depth, static_cast<uint32_t>(stack.size()));
+		stack.resize(depth);
+		int parent = depth > 0 ? stack[depth - 1] : -1;
+
+		NodeKey key{ parent, event.threadIndex, event.name };
+		auto it = nodeIndices.find(key);
+		int nodeIndex = it != nodeIndices.end() ? it->second : -1;
+
+		double milliseconds = TicksToMilliseconds(event.end - event.begin);
+
+		if (nodeIndex < 0)
+		{
+			nodeIndex = static_cast<int>(frame.nodes.size());
+			frame.nodes.push_back({ event.name, parent, depth, event.threadIndex, 0, 0.0, 0.0 });
+			nodeIndices.insert({ key, nodeIndex });
+		}
+
+		frame.nodes[nodeIndex].callCount++;
+		frame.nodes[nodeIndex].totalMilliseconds += milliseconds;
+		frame.nodes[nodeIndex].selfMilliseconds += milliseconds;
+		if (parent >= 0)
+			frame.nodes[parent].selfMilliseconds -= milliseconds;
+
+		stack.push_back(nodeIndex);
+	}
+}
+
+GpuProfiler::GpuProfiler(GpuTimestampQueries& queries, uint32_t frameLatency)
+	: mQueries(queries), mFrameSlots(frameLatency)
+{
+	mTimestamps.resize(queries.GetTimestampCapacity());
+}
+
+void GpuProfiler::BeginFrame(uint32_t frameSlot)
+{
+	assert(frameSlot < mFrameSlots.size());
+	assert(mScopeStack.empty());
+
+	mCurrentSlot = frameSlot;
+	if (mFrameSlots[frameSlot].pending)
+		ReadSlot(frameSlot);
+
+	auto& slot = mFrameSlots[frameSlot];
+	slot.names.clear();
+	slot.depths.clear();
+	slot.timestampCount = 0;
+	slot.cpuBegin = Profiler::Now();
+	slot.pending = false;
+}
+void GpuProfiler::EndFrame()
+{
+	assert(mScopeStack.empty());
+
+	auto& slot = mFrameSlots[mCurrentSlot];
+	if (slot.timestampCount > 0)
+	{
+		mQueries.Resolve(mCurrentSlot, slot.timestampCount);
+		slot.pending = true;
+	}
+}
+
+void GpuProfiler::BeginScope(const char* name)
+{
+	mQueries.BeginEvent(name);
+
+	auto& slot = mFrameSlots[mCurrentSlot];
+	uint32_t scopeIndex = static_cast<uint32_t>(slot.names.size());
+
+	if (2 * scopeIndex + 2 > mQueries.GetTimestampCapacity())
+	{
+		mScopeStack.push_back(-1);
+		return;
+	}
+
+	slot.names.push_back(name);
+	slot.depths.push_back(static_cast<uint32_t>(mScopeStack.size()));
+	slot.timestampCount = 2 * scopeIndex + 2;
+
+	mQueries.WriteTimestamp(mCurrentSlot, 2 * scopeIndex);
+	mScopeStack.push_back(static_cast<int>(scopeIndex));
+}
+void GpuProfiler::EndScope()
+{
+	assert(!mScopeStack.empty());
+
+	int scopeIndex = mScopeStack.back();
+	mScopeStack.pop_back();
+
+	if (scopeIndex >= 0)
+		mQueries.WriteTimestamp(mCurrentSlot, 2 * scopeIndex + 1);
+
+	mQueries.EndEvent();
+}
+
+const std::vector<ProfileEvent>& GpuProfiler::GetLastResolvedEvents()
+{
+	return mLastResolvedEvents;
+}
+
+void GpuProfiler::ReadSlot(uint32_t frameSlot)
+{
+	auto& slot = mFrameSlots[frameSlot];
+	mQueries.ReadTimestamps(frameSlot, slot.timestampCount, mTimestamps.data());
+
+	auto& profiler = Profiler::Get();
+	double cpuTicksPerGpuTick = profiler.GetTicksPerSecond() /
+		static_cast<double>(mQueries.GetTimestampFrequency());
+
+	uint64_t gpuBegin = mTimestamps[0];
+
+	mLastResolvedEvents.clear();
+	for (size_t i = 0; i < slot.names.size(); i++)
+	{
+		uint64_t begin = mTimestamps[2 * i] - gpuBegin;
+		uint64_t end = std::max(mTimestamps[2 * i + 1], mTimestamps[2 * i]) - gpuBegin;
+
+		ProfileEvent event;
+		event.name = slot.names[i];
+		event.begin = slot.cpuBegin + static_cast<uint64_t>(begin * cpuTicksPerGpuTick);
+		event.end = slot.cpuBegin + static_cast<uint64_t>(end * cpuTicksPerGpuTick);
+		event.depth = slot.depths[i];
+		event.threadIndex = Profiler::gpuThreadIndex;
+		mLastResolvedEvents.push_back(event);
+	}
+
+	profiler.AddGpuEvents(mLastResolvedEvents);
+}
\ No newline at end of file
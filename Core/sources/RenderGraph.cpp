@@ -0,0 +1,440 @@
+#include "../includes/RenderGraph.h"
+
+namespace
+{
+	uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	// Barriers of one pass go out as aliasing, transition and UAV barriers in that order.
+	int GetBarrierOrder(RenderGraphBarrierType type)
+	{
+		switch (type)
+		{
+		case RenderGraphBarrierType::Aliasing:
+			return 0;
+		case RenderGraphBarrierType::Transition:
+			return 1;
+		default:
+			return 2;
+		}
+	}
+}
+
+void RenderGraph::Reset()
+{
+	mPasses.clear();
+	mResources.clear();
+	mBarriers.clear();
+	mFirstFinalBarrier = 0;
+	mHeapSizes.clear();
+	mHeapAlignments.clear();
+
+	mIsCompiled = false;
+	mStatistics = RenderGraphStatistics();
+}
+
+uint32_t RenderGraph::ImportResource(const char* name, RenderGraphState initialState, RenderGraphState finalState)
+{
+	Resource resource;
+	resource.name = name;
+	resource.isTransient = false;
+	resource.initialState = initialState;
+	resource.finalState = finalState;
+
+	mResources.push_back(resource);
+	mIsCompiled = false;
+	return static_cast<uint32_t>(mResources.size() - 1);
+}
+uint32_t RenderGraph::CreateTransient(const char* name, uint64_t byteSize, uint64_t alignment, uint32_t heapGroup)
+{
+	assert(byteSize > 0 && alignment > 0);
+
+	Resource resource;
+	resource.name = name;
+	resource.isTransient = true;
+	resource.initialState = RenderGraphState::Common;
+	resource.finalState = RenderGraphState::Common;
+	resource.byteSize = byteSize;
+	resource.alignment = alignment;
+	resource.heapGroup = heapGroup;
+
+	mResources.push_back(resource);
+	mIsCompiled = false;
+	return static_cast<uint32_t>(mResources.size() - 1);
+}
+
+uint32_t RenderGraph::AddPass(const char* name, std::function<void()> execute)
+{
+	Pass pass;
+	pass.name = name;
+	pass.execute = std::move(execute);
+
+	mPasses.push_back(std::move(pass));
+	mIsCompiled = false;
+	return static_cast<uint32_t>(mPasses.size() - 1);
+}
+void RenderGraph::Read(uint32_t pass, uint32_t resource, RenderGraphState state)
+{
+	AddAccess(pass, resource, state, true, false);
+}
+void RenderGraph::Write(uint32_t pass, uint32_t resource, RenderGraphState state)
+{
+	AddAccess(pass, resource, state, false, true);
+}
+void RenderGraph::SetSideEffects(uint32_t pass)
+{
+	mPasses[pass].hasSideEffects = true;
+	mIsCompiled = false;
+}
+
+void RenderGraph::Compile()
+{
+	mStatistics = RenderGraphStatistics();
+
+	CullPasses();
+
+	std::vector<std::vector<Use>> uses;
+	BuildUses(uses);
+
+	PlaceTransients();
+	BuildBarriers(uses);
+
+	mStatistics.passCount = static_cast<uint32_t>(mPasses.size());
+	for (const auto& pass : mPasses)
+	{
+		if (pass.isCulled)
+			mStatistics.culledPassCount++;
+		else if (pass.barrierCount > 0)
+			mStatistics.barrierBatchCount++;
+	}
+	if (mFirstFinalBarrier < mBarriers.size())
+		mStatistics.barrierBatchCount++;
+	mStatistics.barrierCount = static_cast<uint32_t>(mBarriers.size());
+
+	for (const auto& resource : mResources)
+	{
+		if (resource.isTransient && resource.firstPass != invalidIndex)
+		{
+			mStatistics.transientCount++;
+			mStatistics.transientBytes += resource.byteSize;
+		}
+	}
+	for (uint64_t heapSize : mHeapSizes)
+		mStatistics.heapBytes += heapSize;
+	mStatistics.savedBytes = mStatistics.transientBytes - mStatistics.heapBytes;
+
+	mIsCompiled = true;
+}
+void RenderGraph::Execute(RenderGraphBackend& backend)
+{
+	assert(mIsCompiled);
+
+	for (auto& pass : mPasses)
+	{
+		if (pass.isCulled)
+			continue;
+
+		if (pass.barrierCount > 0)
+			backend.RecordBarriers(&mBarriers[pass.firstBarrier], pass.barrierCount);
+		pass.execute();
+	}
+
+	if (mFirstFinalBarrier < mBarriers.size())
+		backend.RecordBarriers(&mBarriers[mFirstFinalBarrier], static_cast<uint32_t>(mBarriers.size()) - mFirstFinalBarrier);
+}
+
+uint32_t RenderGraph::GetPassCount()
+{
+	return static_cast<uint32_t>(mPasses.size());
+}
+const char* RenderGraph::GetPassName(uint32_t pass)
+{
+	return mPasses[pass].name;
+}
+bool RenderGraph::IsPassCulled(uint32_t pass)
+{
+	return mPasses[pass].isCulled;
+}
+const RenderGraphBarrier* RenderGraph::GetPassBarriers(uint32_t pass, uint32_t& count)
+{
+	count = mPasses[pass].barrierCount;
+	return count > 0 ? &mBarriers[mPasses[pass].firstBarrier] : nullptr;
+}
+const RenderGraphBarrier* RenderGraph::GetFinalBarriers(uint32_t& count)
+{
+	count = static_cast<uint32_t>(mBarriers.size()) - mFirstFinalBarrier;
+	return count > 0 ? &mBarriers[mFirstFinalBarrier] : nullptr;
+}
+
+uint32_t RenderGraph::GetResourceCount()
+{
+	return static_cast<uint32_t>(mResources.size());
+}
+const char* RenderGraph::GetResourceName(uint32_t resource)
+{
+	return mResources[resource].name;
+}
+bool RenderGraph::IsTransient(uint32_t resource)
+{
+	return mResources[resource].isTransient;
+}
+bool RenderGraph::IsResourceUsed(uint32_t resource)
+{
+	return mResources[resource].firstPass != invalidIndex;
+}
+uint32_t RenderGraph::GetHeapGroup(uint32_t resource)
+{
+	return mResources[resource].heapGroup;
+}
+uint64_t RenderGraph::GetHeapOffset(uint32_t resource)
+{
+	return mResources[resource].heapOffset;
+}
+uint64_t RenderGraph::GetByteSize(uint32_t resource)
+{
+	return mResources[resource].byteSize;
+}
+RenderGraphState RenderGraph::GetInitialState(uint32_t resource)
+{
+	return mResources[resource].initialState;
+}
+
+uint32_t RenderGraph::GetHeapGroupCount()
+{
+	return static_cast<uint32_t>(mHeapSizes.size());
+}
+uint64_t RenderGraph::GetHeapSize(uint32_t heapGroup)
+{
+	return mHeapSizes[heapGroup];
+}
+uint64_t RenderGraph::GetHeapAlignment(uint32_t heapGroup)
+{
+	return mHeapAlignments[heapGroup];
+}
+
+RenderGraphStatistics RenderGraph::GetStatistics()
+{
+	return mStatistics;
+}
+
+void RenderGraph::AddAccess(uint32_t pass, uint32_t resource, RenderGraphState state, bool isRead, bool isWrite)
+{
+	assert(pass < mPasses.size() && resource < mResources.size());
+
+	for (auto& access : mPasses[pass].accesses)
+	{
+		if (access.resource != resource)
+			continue;
+
+		// A pass reading and writing a resource uses one state for both, read states combine.
+		if (access.isWrite || isWrite)
+			assert(access.state == state);
+		access.state = access.state | state;
+		access.isRead = access.isRead || isRead;
+		access.isWrite = access.isWrite || isWrite;
+		return;
+	}
+
+	mPasses[pass].accesses.push_back({ resource, state, isRead, isWrite });
+	mIsCompiled = false;
+}
+void RenderGraph::CullPasses()
+{
+	// Backwards from the outputs, a pass is needed when it writes what a later needed pass reads.
+	std::vector<bool> isNeeded(mResources.size(), false);
+
+	for (size_t i = mPasses.size(); i-- > 0;)
+	{
+		Pass& pass = mPasses[i];
+
+		bool isLive = pass.hasSideEffects;
+		for (const auto& access : pass.accesses)
+		{
+			if (access.isWrite && (!mResources[access.resource].isTransient || isNeeded[access.resource]))
+				isLive = true;
+		}
+
+		pass.isCulled = !isLive;
+		if (!isLive)
+			continue;
+
+		for (const auto& access : pass.accesses)
+		{
+			if (access.isWrite && !access.isRead)
+				isNeeded[access.resource] = false;
+		}
+		for (const auto& access : pass.accesses)
+		{
+			if (access.isRead)
+				isNeeded[access.resource] = true;
+		}
+	}
+}
+void RenderGraph::BuildUses(std::vector<std::vector<Use>>& uses)
+{
+	uses.assign(mResources.size(), std::vector<Use>());
+	for (auto& resource : mResources)
+	{
+		resource.firstPass = invalidIndex;
+		resource.lastPass = invalidIndex;
+		resource.isAliased = false;
+		resource.heapOffset = 0;
+	}
+
+	for (uint32_t i = 0; i < mPasses.size(); i++)
+	{
+		if (mPasses[i].isCulled)
+			continue;
+
+		for (const auto& access : mPasses[i].accesses)
+		{
+			Resource& resource = mResources[access.resource];
+			if (resource.firstPass == invalidIndex)
+				resource.firstPass = i;
+			resource.lastPass = i;
+
+			auto& resourceUses = uses[access.resource];
+			if (!access.isWrite && !resourceUses.empty() && !resourceUses.back().isWrite)
+				resourceUses.back().state = resourceUses.back().state | access.state;
+			else
+				resourceUses.push_back({ i, access.state, access.isWrite });
+		}
+	}
+
+	for (uint32_t i = 0; i < mResources.size(); i++)
+	{
+		if (!mResources[i].isTransient || uses[i].empty())
+			continue;
+
+		if (!uses[i].front().isWrite)
+			throw std::runtime_error(std::string("Render graph transient ") + mResources[i].name +
+				" is read before a pass writes it.");
+
+		// The state the last pass leaves it in, which the first pass of the next frame finds it in.
+		mResources[i].initialState = uses[i].back().state;
+	}
+}
+void RenderGraph::PlaceTransients()
+{
+	mHeapSizes.clear();
+	mHeapAlignments.clear();
+
+	std::vector<uint32_t> transients;
+	for (uint32_t i = 0; i < mResources.size(); i++)
+	{
+		if (mResources[i].isTransient && mResources[i].firstPass != invalidIndex)
+			transients.push_back(i);
+	}
+
+	// Biggest first, each at the lowest offset not taken by a transient living at the same time.
+	std::stable_sort(transients.begin(), transients.end(), [this](uint32_t a, uint32_t b)
+		{
+			return mResources[a].byteSize > mResources[b].byteSize;
+		});
+
+	std::vector<uint32_t> placed;
+	std::vector<std::pair<uint64_t, uint64_t>> takenRanges;
+	for (uint32_t index : transients)
+	{
+		Resource& resource = mResources[index];
+		if (resource.heapGroup >= mHeapSizes.size())
+		{
+			mHeapSizes.resize(resource.heapGroup + 1, 0);
+			mHeapAlignments.resize(resource.heapGroup + 1, 1);
+		}
+
+		takenRanges.clear();
+		for (uint32_t other : placed)
+		{
+			const Resource& otherResource = mResources[other];
+			bool livesAtSameTime = otherResource.firstPass <= resource.lastPass && resource.firstPass <= otherResource.lastPass;
+			if (otherResource.heapGroup == resource.heapGroup && livesAtSameTime)
+				takenRanges.push_back({ otherResource.heapOffset, otherResource.heapOffset + otherResource.byteSize });
+		}
+		std::sort(takenRanges.begin(), takenRanges.end());
+
+		uint64_t offset = 0;
+		for (const auto& range : takenRanges)
+		{
+			if (offset + resource.byteSize <= range.first)
+				break;
+			offset = std::max(offset, AlignUp(range.second, resource.alignment));
+		}
+
+		resource.heapOffset = offset;
+		mHeapSizes[resource.heapGroup] = std::max(mHeapSizes[resource.heapGroup], offset + resource.byteSize);
+		mHeapAlignments[resource.heapGroup] = std::max(mHeapAlignments[resource.heapGroup], resource.alignment);
+		placed.push_back(index);
+	}
+
+	for (size_t i = 0; i < placed.size(); i++)
+	{
+		for (size_t j = i + 1; j < placed.size(); j++)
+		{
+			Resource& a = mResources[placed[i]];
+			Resource& b = mResources[placed[j]];
+			if (a.heapGroup == b.heapGroup &&
+				a.heapOffset < b.heapOffset + b.byteSize && b.heapOffset < a.heapOffset + a.byteSize)
+			{
+				a.isAliased = true;
+				b.isAliased = true;
+			}
+		}
+	}
+}
+void RenderGraph::BuildBarriers(const std::vector<std::vector<Use>>& uses)
+{
+	std::vector<std::vector<RenderGraphBarrier>> passBarriers(mPasses.size());
+	std::vector<RenderGraphBarrier> finalBarriers;
+
+	for (uint32_t i = 0; i < mResources.size(); i++)
+	{
+		const Resource& resource = mResources[i];
+		const auto& resourceUses = uses[i];
+
+		if (resource.isTransient && resource.isAliased)
+		{
+			passBarriers[resourceUses.front().pass].push_back({ RenderGraphBarrierType::Aliasing, i,
+				RenderGraphState::Common, resourceUses.front().state });
+		}
+
+		RenderGraphState state = resource.initialState;
+		for (size_t j = 0; j < resourceUses.size(); j++)
+		{
+			const Use& use = resourceUses[j];
+			if (use.state != state)
+			{
+				passBarriers[use.pass].push_back({ RenderGraphBarrierType::Transition, i, state, use.state });
+			}
+			else if (j > 0 && use.state == RenderGraphState::UnorderedAccess && (use.isWrite || resourceUses[j - 1].isWrite))
+			{
+				// Both sides stay in UnorderedAccess, a write on either side still has to finish first.
+				passBarriers[use.pass].push_back({ RenderGraphBarrierType::UnorderedAccess, i,
+					use.state, use.state });
+			}
+			state = use.state;
+		}
+
+		if (!resource.isTransient && state != resource.finalState)
+			finalBarriers.push_back({ RenderGraphBarrierType::Transition, i, state, resource.finalState });
+	}
+
+	mBarriers.clear();
+	for (size_t i = 0; i < mPasses.size(); i++)
+	{
+		auto& barriers = passBarriers[i];
+		std::stable_sort(barriers.begin(), barriers.end(), [](const RenderGraphBarrier& a, const RenderGraphBarrier& b)
+			{
+				return GetBarrierOrder(a.type) < GetBarrierOrder(b.type);
+			});
+
+		mPasses[i].firstBarrier = static_cast<uint32_t>(mBarriers.size());
+		mPasses[i].barrierCount = static_cast<uint32_t>(barriers.size());
+		mBarriers.insert(mBarriers.end(), barriers.begin(), barriers.end());
+	}
+
+	mFirstFinalBarrier = static_cast<uint32_t>(mBarriers.size());
+	mBarriers.insert(mBarriers.end(), finalBarriers.begin(), finalBarriers.end());
+}
\ No newline at end of file
@@ -0,0 +1,216 @@
+#include "../includes/ResourceStateTracker.h"
+
+GlobalResourceStates& GlobalResourceStates::GetDefault()
+{
+	static GlobalResourceStates globalStates;
+	return globalStates;
+}
+
+void GlobalResourceStates::Register(void* resource, uint32_t state, bool isBuffer)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mEntries[resource] = { state, isBuffer };
+}
+void GlobalResourceStates::Unregister(void* resource)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mEntries.erase(resource);
+}
+bool GlobalResourceStates::GetState(void* resource, uint32_t& state)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	auto entry = mEntries.find(resource);
+	if (entry == mEntries.end())
+		return false;
+
+	state = entry->second.state;
+	return true;
+}
+
+ResourceStateTracker::ResourceStateTracker(const ResourceStateRules& rules)
+	: mRules(rules)
+{
+
+}
+
+void ResourceStateTracker::Reset()
+{
+	mStates.clear();
+	mFirstUses.clear();
+	mUnflushed.clear();
+	mPendingBarriers.clear();
+
+	mStatistics = ResourceStateTrackerStatistics();
+}
+
+void ResourceStateTracker::TransitionResource(void* resource, uint32_t state)
+{
+	mStatistics.transitionCount++;
+
+	auto found = mStates.find(resource);
+	if (found == mStates.end())
+	{
+		LocalState localState;
+		localState.firstState = state;
+		localState.state = state;
+		mStates.insert({ resource, localState });
+
+		mFirstUses.push_back(resource);
+		mUnflushed.push_back(resource);
+		mStatistics.firstUseCount++;
+		return;
+	}
+
+	LocalState& localState = found->second;
+	if (localState.isFirstUsePending)
+	{
+		// No command used the first state yet, the list can as well start in this one. Even a read state
+		// the first one includes replaces it, the backend promotes to exactly the state of the first use.
+		if (localState.state == state)
+			mStatistics.redundantCount++;
+		else
+			mStatistics.mergedCount++;
+
+		localState.firstState = state;
+		localState.state = state;
+		return;
+	}
+
+	if (IsInState(localState.state, state))
+	{
+		mStatistics.redundantCount++;
+		return;
+	}
+
+	if (localState.pendingBarrier >= 0)
+	{
+		// A -> B followed by B -> C before any command used B, a cancelled A -> A is skipped by the flush.
+		mPendingBarriers[localState.pendingBarrier].after = state;
+		mStatistics.mergedCount++;
+	}
+	else
+	{
+		localState.pendingBarrier = static_cast<int>(mPendingBarriers.size());
+		mPendingBarriers.push_back({ ResourceBarrierType::Transition, resource, localState.state, state });
+		mUnflushed.push_back(resource);
+	}
+
+	localState.state = state;
+}
+void ResourceStateTracker::UAVBarrier(void* resource)
+{
+	for (const auto& barrier : mPendingBarriers)
+	{
+		if (barrier.type == ResourceBarrierType::UnorderedAccess && barrier.resource == resource)
+			return;
+	}
+
+	mPendingBarriers.push_back({ ResourceBarrierType::UnorderedAccess, resource, 0, 0 });
+}
+void ResourceStateTracker::FlushResourceBarriers(ResourceBarrierSink& sink)
+{
+	mFlushedBarriers.clear();
+	for (const auto& barrier : mPendingBarriers)
+	{
+		if (barrier.type == ResourceBarrierType::Transition)
+		{
+			if (barrier.before == barrier.after)
+				continue;
+			mStates[barrier.resource].hasChanged = true;
+		}
+		mFlushedBarriers.push_back(barrier);
+	}
+	mPendingBarriers.clear();
+
+	for (void* resource : mUnflushed)
+	{
+		LocalState& localState = mStates[resource];
+		localState.pendingBarrier = -1;
+		localState.isFirstUsePending = false;
+	}
+	mUnflushed.clear();
+
+	if (mFlushedBarriers.empty())
+		return;
+
+	sink.RecordBarriers(mFlushedBarriers.data(), static_cast<uint32_t>(mFlushedBarriers.size()));
+	mStatistics.barrierCount += static_cast<uint32_t>(mFlushedBarriers.size());
+	mStatistics.flushCount++;
+}
+
+void ResourceStateTracker::Resolve(GlobalResourceStates& globalStates, std::vector<ResourceBarrierDesc>& barriers)
+{
+	assert(mPendingBarriers.empty());
+
+	std::lock_guard<std::mutex> lock(globalStates.mMutex);
+
+	for (void* resource : mFirstUses)
+	{
+		auto entry = globalStates.mEntries.find(resource);
+		if (entry == globalStates.mEntries.end())
+			continue;
+
+		const LocalState& localState = mStates[resource];
+		GlobalResourceStates::Entry& globalState = entry->second;
+
+		// A list that only read the resource leaves a combined read state as it is, the barriers of one that
+		// changes it start from the first state.
+		if (globalState.state != localState.firstState && IsInState(globalState.state, localState.firstState))
+		{
+			if (!localState.hasChanged)
+				continue;
+
+			barriers.push_back({ ResourceBarrierType::Transition, resource, globalState.state, localState.firstState });
+			mStatistics.resolvedBarrierCount++;
+			globalState.state = globalState.isBuffer ? mRules.commonState : localState.state;
+			continue;
+		}
+
+		bool isPromoted = false;
+		if (globalState.state != localState.firstState)
+		{
+			bool isPromotable = globalState.isBuffer ||
+				(localState.firstState & ~mRules.texturePromotionStates) == 0;
+			if (globalState.state == mRules.commonState && isPromotable)
+			{
+				isPromoted = true;
+				mStatistics.promotedCount++;
+			}
+			else
+			{
+				barriers.push_back({ ResourceBarrierType::Transition, resource, globalState.state, localState.firstState });
+				mStatistics.resolvedBarrierCount++;
+			}
+		}
+
+		bool isReadState = (localState.state & ~mRules.readStates) == 0;
+		bool decays = globalState.isBuffer || (isPromoted && !localState.hasChanged && isReadState);
+		globalState.state = decays ? mRules.commonState : localState.state;
+	}
+}
+
+bool ResourceStateTracker::GetState(void* resource, uint32_t& state)
+{
+	auto found = mStates.find(resource);
+	if (found == mStates.end())
+		return false;
+
+	state = found->second.state;
+	return true;
+}
+
+ResourceStateTrackerStatistics ResourceStateTracker::GetStatistics()
+{
+	return mStatistics;
+}
+
+bool ResourceStateTracker::IsInState(uint32_t currentState, uint32_t state)
+{
+	if (currentState == state)
+		return true;
+
+	// A combination of read states serves every read state in it.
+	bool isRead = (currentState & ~mRules.readStates) == 0 && (state & ~mRules.readStates) == 0;
+	return isRead && state != mRules.commonState && (currentState & state) == state;
+}
\ No newline at end of file
@@ -5,13 +5,39 @@ void Shader::CompileShader(
 	const std::wstring& filename, 
 	const D3D_SHADER_MACRO* defines, 
 	const std::string& entrypoint, 
-	const std::string& target)
+	const std::string& target,
+	ShaderCache* shaderCache)
 {
 	UINT compileFlags = 0;
 #if defined(DEBUG) || defined(_DEBUG)
 	compileFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
 #endif
 
+	ShaderCompileDesc compileDesc;
+	uint64_t key = 0;
+	if (shaderCache != nullptr)
+	{
+		std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>, wchar_t> converter;
+		compileDesc.filename = converter.to_bytes(filename);
+		compileDesc.entrypoint = entrypoint;
+		compileDesc.target = target;
+		compileDesc.flags = compileFlags;
+		compileDesc.compilerVersion = D3D_COMPILER_VERSION;
+		for (auto define = defines; define != nullptr && define->Name != nullptr; define++)
+			compileDesc.defines.push_back({ define->Name, define->Definition != nullptr ? define->Definition : "" });
+
+		if (!shaderCache->ComputeKey(compileDesc, key))
+			shaderCache = nullptr;
+	}
+
+	std::vector<uint8_t> bytecode;
+	if (shaderCache != nullptr && shaderCache->Load(key, bytecode))
+	{
+		ThrowIfFailed(D3DCreateBlob(bytecode.size(), mShader.ReleaseAndGetAddressOf()));
+		std::memcpy(mShader->GetBufferPointer(), bytecode.data(), bytecode.size());
+		return;
+	}
+
 	HRESULT hr = S_OK;
 	ComPtr<ID3DBlob> errors;
 
@@ -25,6 +51,27 @@ void Shader::CompileShader(
 	}
 
 	ThrowIfFailed(hr);
+
+	if (shaderCache != nullptr)
+	{
+		shaderCache->Store(key, mShader->GetBufferPointer(), mShader->GetBufferSize(),
+			compileDesc.filename + " " + entrypoint + " " + target);
+	}
+}
+void Shader::CompileShader(
+	const std::wstring& filename,
+	const std::vector<ShaderDefine>& defines,
+	const std::string& entrypoint,
+	const std::string& target,
+	ShaderCache* shaderCache)
+{
+	std::vector<D3D_SHADER_MACRO> macros;
+	macros.reserve(defines.size() + 1);
+	for (const auto& define : defines)
+		macros.push_back({ define.name.c_str(), define.definition.c_str() });
+	macros.push_back({ nullptr, nullptr });
+
+	CompileShader(filename, macros.data(), entrypoint, target, shaderCache);
 }
 
 ID3DBlob* Shader::GetShader()
@@ -0,0 +1,336 @@
+#include "../includes/ShaderCache.h"
+#include <sys/stat.h>
+#if defined(_WIN32)
+#include <direct.h>
+#endif
+
+namespace
+{
+	void MakeDirectory(const std::string& directory)
+	{
+#if defined(_WIN32)
+		_mkdir(directory.c_str());
+#else
+		mkdir(directory.c_str(), 0755);
+#endif
+	}
+
+	bool ReadFileContents(const std::string& filename, std::string& contents)
+	{
+		std::ifstream file(filename, std::ios::binary);
+		if (!file)
+			return false;
+
+		std::ostringstream stream;
+		stream << file.rdbuf();
+		contents = stream.str();
+		return true;
+	}
+
+	std::string GetDirectory(const std::string& path)
+	{
+		size_t slash = path.find_last_of('/');
+		return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+	}
+
+	// The quoted or angled names of every #include line. Includes inside inactive #if blocks
+	// are kept as well, they can only cause a spurious miss.
+	std::vector<std::string> ParseIncludes(const std::string& source)
+	{
+		std::vector<std::string> includes;
+
+		std::istringstream stream(source);
+		std::string line;
+		while (std::getline(stream, line))
+		{
+			size_t i = line.find_first_not_of(" \t");
+			if (i == std::string::npos || line[i] != '#')
+				continue;
+
+			i = line.find_first_not_of(" \t", i + 1);
+			if (i == std::string::npos || line.compare(i, 7, "include") != 0)
+				continue;
+
+			i = line.find_first_of("\"<", i + 7);
+			if (i == std::string::npos)
+				continue;
+
+			char close = line[i] == '"' ? '"' : '>';
+			size_t end = line.find(close, i + 1);
+			if (end != std::string::npos)
+				includes.push_back(line.substr(i + 1, end - i - 1));
+		}
+
+		return includes;
+	}
+
+	template <typename T>
+	uint64_t HashValue(const T& value, uint64_t hash)
+	{
+		return ShaderCache::Hash(&value, sizeof(T), hash);
+	}
+
+	uint64_t HashString(const std::string& value, uint64_t hash)
+	{
+		// The length keeps ("ab", "c") and ("a", "bc") apart.
+		hash = HashValue(static_cast<uint64_t>(value.size()), hash);
+		return ShaderCache::Hash(value.data(), value.size(), hash);
+	}
+}
+
+ShaderCache::ShaderCache(const std::string& directory)
+	: mDirectory(NormalizePath(directory))
+{
+	if (!mDirectory.empty() && mDirectory.back() != '/')
+		mDirectory += '/';
+
+	MakeDirectory(mDirectory);
+	LoadIndex();
+}
+
+bool ShaderCache::ComputeKey(const ShaderCompileDesc& desc, uint64_t& key)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	std::string filename = NormalizePath(desc.filename);
+	if (!GetFileInfo(filename).exists)
+		return false;
+
+	uint32_t version = cacheVersion;
+	uint64_t hash = HashValue(version, fnvOffsetBasis);
+	hash = HashString(desc.entrypoint, hash);
+	hash = HashString(desc.target, hash);
+	hash = HashValue(desc.flags, hash);
+	hash = HashValue(desc.compilerVersion, hash);
+
+	hash = HashValue(static_cast<uint64_t>(desc.defines.size()), hash);
+	for (const auto& define : desc.defines)
+	{
+		hash = HashString(define.name, hash);
+		hash = HashString(define.definition, hash);
+	}
+
+	// Walk the include graph, every file contributes its path and content once.
+	std::vector<std::string> pending{ filename };
+	std::unordered_map<std::string, bool> visited{ { filename, true } };
+	while (!pending.empty())
+	{
+		std::string current = pending.back();
+		pending.pop_back();
+
+		const FileInfo& fileInfo = GetFileInfo(current);
+		hash = HashString(current, hash);
+		hash = HashValue(fileInfo.exists, hash);
+		hash = HashValue(fileInfo.contentHash, hash);
+
+		// Reverse so the files are visited in include order.
+		for (auto it = fileInfo.includes.rbegin(); it != fileInfo.includes.rend(); ++it)
+		{
+			if (visited.insert({ *it, true }).second)
+				pending.push_back(*it);
+		}
+	}
+
+	key = hash;
+	return true;
+}
+
+bool ShaderCache::Load(uint64_t key, std::vector<uint8_t>& bytecode)
+{
+	Entry entry;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		auto it = mEntries.find(key);
+		if (it == mEntries.end())
+		{
+			mStatistics.missCount++;
+			return false;
+		}
+		entry = it->second;
+	}
+
+	std::string contents;
+	bool valid = ReadFileContents(GetBlobPath(key), contents) && contents.size() == entry.byteSize &&
+		Hash(contents.data(), contents.size()) == entry.checksum;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (!valid)
+	{
+		// Drop it, the following Store rewrites the blob and appends a new index line.
+		mEntries.erase(key);
+		mStatistics.corruptCount++;
+		mStatistics.missCount++;
+		return false;
+	}
+
+	bytecode.assign(contents.begin(), contents.end());
+	mStatistics.hitCount++;
+	return true;
+}
+
+void ShaderCache::Store(uint64_t key, const void* bytecode, size_t byteSize, const std::string& source)
+{
+	Entry entry{ byteSize, Hash(bytecode, byteSize) };
+
+	// Write to a temporary file first so a crash never leaves a truncated blob under the final name.
+	std::string blobPath = GetBlobPath(key);
+	std::string temporaryPath = blobPath + ".tmp" +
+		std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!file)
+			return;
+		file.write(static_cast<const char*>(bytecode), byteSize);
+		if (!file)
+			return;
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	std::remove(blobPath.c_str());
+	if (std::rename(temporaryPath.c_str(), blobPath.c_str()) != 0)
+	{
+		std::remove(temporaryPath.c_str());
+		return;
+	}
+
+	std::ofstream index(mDirectory + "index.txt", std::ios::app);
+	char line[64];
+	std::snprintf(line, sizeof(line), "%016llx %llu %016llx ",
+		static_cast<unsigned long long>(key), static_cast<unsigned long long>(entry.byteSize),
+		static_cast<unsigned long long>(entry.checksum));
+	index << line << source << '\n';
+
+	mEntries[key] = entry;
+	mStatistics.storeCount++;
+}
+
+std::vector<std::string> ShaderCache::GetIncludeGraph(const std::string& filename)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	std::string root = NormalizePath(filename);
+	std::vector<std::string> graph;
+	std::vector<std::string> pending{ root };
+	std::unordered_map<std::string, bool> visited{ { root, true } };
+	while (!pending.empty())
+	{
+		std::string current = pending.back();
+		pending.pop_back();
+
+		const FileInfo& fileInfo = GetFileInfo(current);
+		if (!fileInfo.exists)
+			continue;
+		graph.push_back(current);
+
+		for (auto it = fileInfo.includes.rbegin(); it != fileInfo.includes.rend(); ++it)
+		{
+			if (visited.insert({ *it, true }).second)
+				pending.push_back(*it);
+		}
+	}
+
+	return graph;
+}
+
+void ShaderCache::InvalidateFiles()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mFiles.clear();
+}
+
+ShaderCacheStatistics ShaderCache::GetStatistics()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mStatistics;
+}
+
+uint64_t ShaderCache::Hash(const void* data, size_t byteSize, uint64_t hash)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < byteSize; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+std::string ShaderCache::NormalizePath(const std::string& path)
+{
+	std::string slashed = path;
+	std::replace(slashed.begin(), slashed.end(), '\\', '/');
+
+	bool absolute = !slashed.empty() && slashed[0] == '/';
+
+	// Collapse "." and "name/.." so one file always gets the same key in the include graph.
+	std::vector<std::string> parts;
+	std::istringstream stream(slashed);
+	std::string part;
+	while (std::getline(stream, part, '/'))
+	{
+		if (part.empty() || part == ".")
+			continue;
+
+		if (part == ".." && !parts.empty() && parts.back() != "..")
+			parts.pop_back();
+		else
+			parts.push_back(part);
+	}
+
+	std::string normalized = absolute ? "/" : "";
+	for (size_t i = 0; i < parts.size(); i++)
+	{
+		if (i > 0)
+			normalized += '/';
+		normalized += parts[i];
+	}
+
+	return normalized;
+}
+
+const ShaderCache::FileInfo& ShaderCache::GetFileInfo(const std::string& filename)
+{
+	auto it = mFiles.find(filename);
+	if (it != mFiles.end())
+		return it->second;
+
+	FileInfo fileInfo{ false, 0, {} };
+
+	std::string source;
+	if (ReadFileContents(filename, source))
+	{
+		fileInfo.exists = true;
+		fileInfo.contentHash = Hash(source.data(), source.size());
+
+		std::string directory = GetDirectory(filename);
+		for (const auto& include : ParseIncludes(source))
+			fileInfo.includes.push_back(NormalizePath(directory + include));
+	}
+
+	return mFiles.insert({ filename, std::move(fileInfo) }).first->second;
+}
+
+void ShaderCache::LoadIndex()
+{
+	std::ifstream index(mDirectory + "index.txt");
+
+	std::string line;
+	while (std::getline(index, line))
+	{
+		unsigned long long key = 0;
+		unsigned long long byteSize = 0;
+		unsigned long long checksum = 0;
+		if (std::sscanf(line.c_str(), "%llx %llu %llx", &key, &byteSize, &checksum) == 3)
+			mEntries[key] = { byteSize, checksum }; // later lines win
+	}
+}
+
+std::string ShaderCache::GetBlobPath(uint64_t key)
+{
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+	return mDirectory + name;
+}
\ No newline at end of file
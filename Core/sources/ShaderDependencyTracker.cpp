@@ -0,0 +1,65 @@
+#include "../includes/ShaderDependencyTracker.h"
+
+ShaderDependencyTracker::ShaderDependencyTracker(ShaderCache& shaderCache)
+	: mShaderCache(shaderCache)
+{
+
+}
+
+void ShaderDependencyTracker::SetSources(uint32_t group, const std::vector<std::string>& sources)
+{
+	// Forget the previous graph of the group.
+	for (const auto& file : mGroupFiles[group])
+	{
+		auto& groups = mDependentGroups[file];
+		groups.erase(std::remove(groups.begin(), groups.end(), group), groups.end());
+		if (groups.empty())
+			mDependentGroups.erase(file);
+	}
+
+	std::vector<std::string> files;
+	for (const auto& source : sources)
+	{
+		// A missing source still gets an entry, creating it later is a change as well.
+		std::vector<std::string> graph = mShaderCache.GetIncludeGraph(source);
+		if (graph.empty())
+			graph.push_back(ShaderCache::NormalizePath(source));
+
+		for (auto& file : graph)
+		{
+			if (std::find(files.begin(), files.end(), file) == files.end())
+				files.push_back(std::move(file));
+		}
+	}
+
+	for (const auto& file : files)
+		mDependentGroups[file].push_back(group);
+
+	mGroupFiles[group] = std::move(files);
+}
+
+std::vector<uint32_t> ShaderDependencyTracker::GetAffectedGroups(const std::vector<std::string>& changedFiles)
+{
+	std::vector<uint32_t> affectedGroups;
+	for (const auto& changedFile : changedFiles)
+	{
+		auto it = mDependentGroups.find(ShaderCache::NormalizePath(changedFile));
+		if (it != mDependentGroups.end())
+			affectedGroups.insert(affectedGroups.end(), it->second.begin(), it->second.end());
+	}
+
+	std::sort(affectedGroups.begin(), affectedGroups.end());
+	affectedGroups.erase(std::unique(affectedGroups.begin(), affectedGroups.end()), affectedGroups.end());
+
+	return affectedGroups;
+}
+std::vector<std::string> ShaderDependencyTracker::GetFiles()
+{
+	std::vector<std::string> files;
+	files.reserve(mDependentGroups.size());
+	for (const auto& file : mDependentGroups)
+		files.push_back(file.first);
+
+	std::sort(files.begin(), files.end());
+	return files;
+}
\ No newline at end of file
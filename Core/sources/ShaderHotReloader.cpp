@@ -0,0 +1,153 @@
+#include "../includes/ShaderHotReloader.h"
+
+ShaderHotReloader::ShaderHotReloader(ShaderCache& shaderCache, std::unique_ptr<FileWatcher> fileWatcher)
+	: mShaderCache(shaderCache), mFileWatcher(std::move(fileWatcher)), mDependencyTracker(shaderCache)
+{
+
+}
+ShaderHotReloader::~ShaderHotReloader()
+{
+	Stop();
+}
+
+void ShaderHotReloader::AddGroup(const std::string& name, const std::vector<HotReloadShaderDesc>& shaders,
+	ApplyCallback apply)
+{
+	assert(!mThread.joinable());
+
+	uint32_t group = static_cast<uint32_t>(mGroups.size());
+	mGroups.push_back({ name, shaders, std::move(apply) });
+
+	mDependencyTracker.SetSources(group, GetSources(mGroups.back()));
+	WatchFiles();
+}
+
+void ShaderHotReloader::Start(std::chrono::milliseconds pollInterval)
+{
+	assert(!mThread.joinable());
+
+	mPollInterval = pollInterval;
+	mStop = false;
+	mThread = std::thread(&ShaderHotReloader::WatchLoop, this);
+}
+void ShaderHotReloader::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStop = true;
+	}
+	mStopRequested.notify_all();
+
+	if (mThread.joinable())
+		mThread.join();
+}
+
+uint32_t ShaderHotReloader::ApplyPendingReloads()
+{
+	std::vector<PendingReload> pendingReloads;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (mPendingReloads.empty())
+			return 0;
+		pendingReloads.swap(mPendingReloads);
+	}
+
+	for (auto& pendingReload : pendingReloads)
+	{
+		const Group& group = mGroups[pendingReload.group];
+		group.apply(pendingReload.shaders);
+
+		std::string message = "Shader hot reload: applied " + group.name + "\n";
+		::OutputDebugStringA(message.c_str());
+	}
+
+	return static_cast<uint32_t>(pendingReloads.size());
+}
+
+void ShaderHotReloader::WatchLoop()
+{
+	std::vector<std::string> changedFiles;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			if (mStopRequested.wait_for(lock, mPollInterval, [this]() { return mStop; }))
+				break;
+		}
+
+		changedFiles.clear();
+		mFileWatcher->Poll(changedFiles);
+		if (!changedFiles.empty())
+			ReloadChangedGroups(changedFiles);
+	}
+}
+void ShaderHotReloader::ReloadChangedGroups(const std::vector<std::string>& changedFiles)
+{
+	// The memoized hashes and include lists are stale now.
+	mShaderCache.InvalidateFiles();
+
+	for (auto groupIndex : mDependencyTracker.GetAffectedGroups(changedFiles))
+	{
+		const Group& group = mGroups[groupIndex];
+
+		// Includes may have been added or removed.
+		mDependencyTracker.SetSources(groupIndex, GetSources(group));
+
+		PendingReload pendingReload{ groupIndex, std::vector<Shader>(group.shaders.size()) };
+		try
+		{
+			for (size_t i = 0; i < group.shaders.size(); i++)
+			{
+				const auto& desc = group.shaders[i];
+				pendingReload.shaders[i].CompileShader(desc.filename, desc.defines,
+					desc.entrypoint, desc.target, &mShaderCache);
+			}
+		}
+		catch (DxException& e)
+		{
+			std::wstring message = L"Shader hot reload: " + AnsiToWString(group.name) +
+				L" failed, keeping the previous shaders. " + e.ToString() + L"\n";
+			::OutputDebugStringW(message.c_str());
+			continue;
+		}
+
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		// Only the newest shaders of a group matter if the main thread didn't pick up the last ones.
+		mPendingReloads.erase(std::remove_if(mPendingReloads.begin(), mPendingReloads.end(),
+			[groupIndex](const PendingReload& pending) { return pending.group == groupIndex; }),
+			mPendingReloads.end());
+		mPendingReloads.push_back(std::move(pendingReload));
+	}
+
+	WatchFiles();
+}
+
+std::vector<std::string> ShaderHotReloader::GetSources(const Group& group)
+{
+	std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>, wchar_t> converter;
+
+	std::vector<std::string> sources;
+	for (const auto& shader : group.shaders)
+		sources.push_back(converter.to_bytes(shader.filename));
+
+	return sources;
+}
+void ShaderHotReloader::WatchFiles()
+{
+	// Watch new includes, stop watching the ones nothing includes anymore.
+	std::vector<std::string> files = mDependencyTracker.GetFiles();
+
+	for (const auto& file : mWatchedFiles)
+	{
+		if (!std::binary_search(files.begin(), files.end(), file))
+			mFileWatcher->Unwatch(file);
+	}
+	for (const auto& file : files)
+	{
+		if (!std::binary_search(mWatchedFiles.begin(), mWatchedFiles.end(), file))
+			mFileWatcher->Watch(file);
+	}
+
+	mWatchedFiles = std::move(files);
+}
\ No newline at end of file
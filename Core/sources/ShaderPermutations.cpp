@@ -0,0 +1,73 @@
+#include "../includes/ShaderPermutations.h"
+
+ShaderPermutations::ShaderPermutations(const std::wstring& filename,
+	const std::vector<std::string>& featureDefines, ShaderCache* shaderCache)
+	: mFilename(filename), mFeatureDefines(featureDefines), mShaderCache(shaderCache)
+{
+	if (mFeatureDefines.size() > maxFeatureCount)
+		throw std::runtime_error("Too many shader features, the permutation table would be too large.");
+}
+
+uint32_t ShaderPermutations::AddStage(const std::string& entrypoint, const std::string& target)
+{
+	Stage stage;
+	stage.entrypoint = entrypoint;
+	stage.target = target;
+
+	stage.permutations.resize(size_t(1) << mFeatureDefines.size());
+	for (auto& permutation : stage.permutations)
+		permutation = std::make_unique<Permutation>();
+
+	mStages.push_back(std::move(stage));
+	return static_cast<uint32_t>(mStages.size() - 1);
+}
+
+Shader& ShaderPermutations::GetShader(uint32_t stage, uint32_t featureMask)
+{
+	assert(stage < mStages.size());
+	assert(featureMask < mStages[stage].permutations.size());
+
+	Permutation& permutation = *mStages[stage].permutations[featureMask];
+	std::call_once(permutation.compiled, [this, stage, featureMask, &permutation]()
+		{
+			Compile(mStages[stage], featureMask, permutation.shader);
+		});
+
+	return permutation.shader;
+}
+void ShaderPermutations::Precompile(uint32_t featureMask)
+{
+	for (uint32_t stage = 0; stage < mStages.size(); stage++)
+		GetShader(stage, featureMask);
+}
+
+uint32_t ShaderPermutations::GetFeatureBit(const std::string& featureDefine)
+{
+	for (size_t i = 0; i < mFeatureDefines.size(); i++)
+	{
+		if (mFeatureDefines[i] == featureDefine)
+			return 1u << i;
+	}
+
+	return 0;
+}
+std::vector<ShaderDefine> ShaderPermutations::GetDefines(uint32_t featureMask)
+{
+	std::vector<ShaderDefine> defines;
+	defines.reserve(mFeatureDefines.size());
+
+	for (size_t i = 0; i < mFeatureDefines.size(); i++)
+		defines.push_back({ mFeatureDefines[i], (featureMask & (1u << i)) != 0 ? "1" : "0" });
+
+	return defines;
+}
+uint32_t ShaderPermutations::GetCompiledCount()
+{
+	return mCompiledCount.load();
+}
+
+void ShaderPermutations::Compile(const Stage& stage, uint32_t featureMask, Shader& shader)
+{
+	shader.CompileShader(mFilename, GetDefines(featureMask), stage.entrypoint, stage.target, mShaderCache);
+	mCompiledCount++;
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include "../includes/ShadowMap.h"
+#include "../includes/D3D12MemoryAllocator.h"
+
+const DXGI_FORMAT ShadowMap::depthFormat = DXGI_FORMAT_D32_FLOAT;
+
+ShadowMap::ShadowMap(ID3D12Device* device, UINT resolution, UINT sliceCount)
+	: mResolution(resolution), mSliceCount(sliceCount)
+{
+	mViewport = { 0.0f, 0.0f, static_cast<float>(resolution), static_cast<float>(resolution), 0.0f, 1.0f };
+	mScissorRect = { 0, 0, static_cast<LONG>(resolution), static_cast<LONG>(resolution) };
+
+	BuildResource(device);
+}
+
+void ShadowMap::BuildResource(ID3D12Device* device)
+{
+	// Typeless, the DSVs read it as D32_FLOAT and the SRV as R32_FLOAT.
+	D3D12_RESOURCE_DESC textureDesc;
+	textureDesc.Alignment = 0;
+	textureDesc.DepthOrArraySize = static_cast<UINT16>(mSliceCount);
+	textureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	textureDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+	textureDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+	textureDesc.Height = mResolution;
+	textureDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+	textureDesc.MipLevels = 1;
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.SampleDesc.Quality = 0;
+	textureDesc.Width = mResolution;
+
+	D3D12_CLEAR_VALUE optClear;
+	optClear.Format = depthFormat;
+	optClear.DepthStencil.Depth = 1.0f;
+	optClear.DepthStencil.Stencil = 0;
+
+	mShadowMap = D3D12MemoryAllocator::GetDefault(device).CreateResource(D3D12_HEAP_TYPE_DEFAULT,
+		textureDesc, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, &optClear);
+}
+
+void ShadowMap::BuildDescriptors(
+	ID3D12Device* device,
+	CbvSrvUavDescriptor& descriptorBuilder,
+	UINT cbvSrvUavDescriptorSize,
+	UINT dsvDescriptorSize)
+{
+	int currentDescriptorIndex = descriptorBuilder.GetCurrentDescriptorIndex();
+
+	descriptorBuilder.CreateShaderResourceView(device, cbvSrvUavDescriptorSize,
+		DXGI_FORMAT_R32_FLOAT, D3D12_SRV_DIMENSION_TEXTURE2DARRAY, mShadowMap.Get());
+
+	mShadowMapSrvDescriptorIndex = currentDescriptorIndex + 1;
+
+	mDsvDescriptorSize = dsvDescriptorSize;
+	mDsvDescriptor.CreateDescriptorHeap(device, mSliceCount);
+	for (UINT i = 0; i < mSliceCount; i++)
+	{
+		mDsvDescriptor.CreateDepthStencilView(device, dsvDescriptorSize, depthFormat,
+			D3D12_DSV_DIMENSION_TEXTURE2DARRAY, mShadowMap.Get(), i);
+	}
+}
+
+void ShadowMap::BeginRender(ID3D12GraphicsCommandList* commandList)
+{
+	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mShadowMap.Get(),
+		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_DEPTH_WRITE));
+
+	commandList->RSSetViewports(1, &mViewport);
+	commandList->RSSetScissorRects(1, &mScissorRect);
+}
+void ShadowMap::EndRender(ID3D12GraphicsCommandList* commandList)
+{
+	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mShadowMap.Get(),
+		D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+}
+void ShadowMap::SetRenderTarget(ID3D12GraphicsCommandList* commandList, UINT slice)
+{
+	auto dsv = GetDsv(slice);
+
+	commandList->ClearDepthStencilView(dsv, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+	commandList->OMSetRenderTargets(0, nullptr, false, &dsv);
+}
+
+ID3D12Resource* ShadowMap::GetShadowMap()
+{
+	return mShadowMap.Get();
+}
+int ShadowMap::GetShadowMapSrvDescriptorIndex()
+{
+	return mShadowMapSrvDescriptorIndex;
+}
+CD3DX12_CPU_DESCRIPTOR_HANDLE ShadowMap::GetDsv(UINT slice)
+{
+	assert(slice < mSliceCount);
+
+	CD3DX12_CPU_DESCRIPTOR_HANDLE dsv(mDsvDescriptor.GetStartCPUDescriptorHandle());
+	dsv.Offset(slice, mDsvDescriptorSize);
+	return dsv;
+}
+
+UINT ShadowMap::GetResolution()
+{
+	return mResolution;
+}
+UINT ShadowMap::GetSliceCount()
+{
+	return mSliceCount;
+}
\ No newline at end of file
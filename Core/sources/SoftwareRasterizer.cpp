@@ -0,0 +1,687 @@
+#include "../includes/SoftwareRasterizer.h"
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace
+{
+	const uint32_t verticesPerJob = 1024;
+	const uint32_t trianglesPerJob = 512;
+
+	// Clip space guard band, keeps the fixed point coordinates of clipped triangles inside int32.
+	const float guardBand = 16.0f;
+	const int clipPlaneCount = 6;
+	const int maxClippedVertexCount = 3 + clipPlaneCount;
+
+	double ElapsedMilliseconds(std::chrono::steady_clock::time_point start)
+	{
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	}
+
+	XMVECTOR GetClipPlane(int index)
+	{
+		switch (index)
+		{
+		case 0: return XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f); // z >= 0
+		case 1: return XMVectorSet(0.0f, 0.0f, -1.0f, 1.0f); // z <= w
+		case 2: return XMVectorSet(1.0f, 0.0f, 0.0f, guardBand);
+		case 3: return XMVectorSet(-1.0f, 0.0f, 0.0f, guardBand);
+		case 4: return XMVectorSet(0.0f, 1.0f, 0.0f, guardBand);
+		default: return XMVectorSet(0.0f, -1.0f, 0.0f, guardBand);
+		}
+	}
+
+	int64_t FloorDivide(int64_t numerator, int64_t denominator)
+	{
+		int64_t quotient = numerator / denominator;
+		if ((numerator % denominator != 0) && ((numerator < 0) != (denominator < 0)))
+			quotient--;
+		return quotient;
+	}
+
+	bool IsTopLeftEdge(int32_t ax, int32_t ay, int32_t bx, int32_t by)
+	{
+		// Clockwise triangles with y pointing down.
+		return (ay == by && bx > ax) || by < ay;
+	}
+
+	XMVECTOR SampleBilinearWrap(const Image& texture, FXMVECTOR texCoord)
+	{
+		float u = XMVectorGetX(texCoord) * texture.GetWidth() - 0.5f;
+		float v = XMVectorGetY(texCoord) * texture.GetHeight() - 0.5f;
+
+		float x0 = floorf(u);
+		float y0 = floorf(v);
+		float fx = u - x0;
+		float fy = v - y0;
+
+		auto wrap = [](float coordinate, uint32_t size)
+		{
+			int64_t value = static_cast<int64_t>(coordinate) % static_cast<int64_t>(size);
+			return static_cast<uint32_t>(value < 0 ? value + size : value);
+		};
+
+		uint32_t left = wrap(x0, texture.GetWidth());
+		uint32_t right = wrap(x0 + 1.0f, texture.GetWidth());
+		uint32_t top = wrap(y0, texture.GetHeight());
+		uint32_t bottom = wrap(y0 + 1.0f, texture.GetHeight());
+
+		XMVECTOR topRow = XMVectorLerp(
+			XMLoadFloat4A(&texture.GetRow(top)[left]), XMLoadFloat4A(&texture.GetRow(top)[right]), fx);
+		XMVECTOR bottomRow = XMVectorLerp(
+			XMLoadFloat4A(&texture.GetRow(bottom)[left]), XMLoadFloat4A(&texture.GetRow(bottom)[right]), fx);
+
+		return XMVectorLerp(topRow, bottomRow, fy);
+	}
+
+	// The functions below follow LightingUtility.hlsl line by line so the CPU images
+	// match what the GPU renders.
+	struct RasterMaterial
+	{
+		XMVECTOR diffuseAlbedo;
+		XMVECTOR fresnelR0;
+		float shininess;
+	};
+
+	float CalcAttenuation(float d, float falloffEnd, float falloffStart)
+	{
+		return std::min(std::max((falloffEnd - d) / (falloffEnd - falloffStart), 0.0f), 1.0f);
+	}
+
+	XMVECTOR SchlickFresnel(FXMVECTOR R0, FXMVECTOR normal, FXMVECTOR lightVec)
+	{
+		float cosIncidentAngle = std::max(XMVectorGetX(XMVector3Dot(normal, lightVec)), 0.0f);
+
+		float f0 = 1.0f - cosIncidentAngle;
+		return XMVectorMultiplyAdd(XMVectorSplatOne() - R0,
+			XMVectorReplicate(f0 * f0 * f0 * f0 * f0), R0);
+	}
+
+	XMVECTOR BlinnPhong(FXMVECTOR lightStrength, FXMVECTOR lightVec, FXMVECTOR normal,
+		GXMVECTOR toEye, const RasterMaterial& mat)
+	{
+		const float m = mat.shininess * 256.0f;
+		XMVECTOR halfVec = XMVector3Normalize(lightVec + toEye);
+
+		float roughnessFactor =
+			(m + 8.0f) * powf(std::max(XMVectorGetX(XMVector3Dot(halfVec, normal)), 0.0f), m) / 8.0f;
+		XMVECTOR fresnelFactor = SchlickFresnel(mat.fresnelR0, normal, lightVec);
+
+		XMVECTOR specAlbedo = fresnelFactor * roughnessFactor;
+		specAlbedo = specAlbedo / (specAlbedo + XMVectorSplatOne());
+
+		return (mat.diffuseAlbedo + specAlbedo) * lightStrength;
+	}
+
+	XMVECTOR ComputeDirectionalLight(const Light& light, const RasterMaterial& mat,
+		FXMVECTOR normal, FXMVECTOR toEye)
+	{
+		XMVECTOR lightVec = XMVector3Normalize(-XMLoadFloat3(&light.direction));
+
+		float ndotl = std::max(XMVectorGetX(XMVector3Dot(lightVec, normal)), 0.0f);
+		XMVECTOR lightStrength = XMLoadFloat3(&light.strength) * ndotl;
+
+		return BlinnPhong(lightStrength, lightVec, normal, toEye, mat);
+	}
+
+	XMVECTOR ComputePointLight(const Light& light, const RasterMaterial& mat, FXMVECTOR pos,
+		FXMVECTOR normal, FXMVECTOR toEye)
+	{
+		XMVECTOR lightVec = XMLoadFloat3(&light.position) - pos;
+
+		float d = XMVectorGetX(XMVector3Length(lightVec));
+		if (d > light.falloffEnd)
+			return XMVectorZero();
+
+		lightVec = lightVec / d;
+
+		float ndotl = std::max(XMVectorGetX(XMVector3Dot(lightVec, normal)), 0.0f);
+		XMVECTOR lightStrength = XMLoadFloat3(&light.strength) * ndotl;
+
+		float att = CalcAttenuation(d, light.falloffEnd, light.falloffStart);
+		lightStrength = lightStrength * att;
+
+		return BlinnPhong(lightStrength, lightVec, normal, toEye, mat);
+	}
+
+	XMVECTOR ComputeSpotLight(const Light& light, const RasterMaterial& mat, FXMVECTOR pos,
+		FXMVECTOR normal, FXMVECTOR toEye)
+	{
+		XMVECTOR lightVec = XMLoadFloat3(&light.position) - pos;
+
+		float d = XMVectorGetX(XMVector3Length(lightVec));
+		if (d > light.falloffEnd)
+			return XMVectorZero();
+
+		lightVec = lightVec / d;
+
+		float ndotl = std::max(XMVectorGetX(XMVector3Dot(lightVec, normal)), 0.0f);
+		XMVECTOR lightStrength = XMLoadFloat3(&light.strength) * ndotl;
+
+		float att = CalcAttenuation(d, light.falloffEnd, light.falloffStart);
+		lightStrength = lightStrength * att;
+
+		float spotFactor = powf(std::max(
+			XMVectorGetX(XMVector3Dot(-lightVec, XMLoadFloat3(&light.direction))), 0.0f), light.spotPower);
+		lightStrength = lightStrength * spotFactor;
+
+		return BlinnPhong(lightStrength, lightVec, normal, toEye, mat);
+	}
+}
+
+SoftwareRasterizer::SoftwareRasterizer(uint32_t width, uint32_t height, JobSystem& jobSystem)
+	: mJobSystem(jobSystem)
+{
+	XMStoreFloat4x4(&mViewProj, XMMatrixIdentity());
+	Resize(width, height);
+}
+
+void SoftwareRasterizer::Resize(uint32_t width, uint32_t height)
+{
+	assert(width > 0 && height > 0);
+
+	mWidth = width;
+	mHeight = height;
+	mTileCountX = (width + tileSize - 1) / tileSize;
+	mTileCountY = (height + tileSize - 1) / tileSize;
+
+	mColorBuffer.Resize(width, height);
+	mDepthBuffer.resize(static_cast<size_t>(width) * height);
+	mBins.resize(static_cast<size_t>(mTileCountX) * mTileCountY);
+}
+
+void SoftwareRasterizer::SetCullMode(RasterCullMode cullMode)
+{
+	mCullMode = cullMode;
+}
+void SoftwareRasterizer::SetDepthMode(DepthMode depthMode)
+{
+	mDepthMode = depthMode;
+}
+void SoftwareRasterizer::SetLightCount(const RasterLightCount& lightCount)
+{
+	assert(lightCount.directionalLightCount + lightCount.pointLightCount +
+		lightCount.spotLightCount <= Light::maxNumLights);
+	mLightCount = lightCount;
+}
+
+void SoftwareRasterizer::BeginFrame(const SceneConstant& sceneConstant, const XMFLOAT4& clearColor)
+{
+	mSceneConstant = sceneConstant;
+
+	XMStoreFloat4x4(&mViewProj, XMMatrixTranspose(XMLoadFloat4x4(&sceneConstant.viewProj)));
+
+	XMVECTOR clear = XMLoadFloat4(&clearColor);
+	for (uint32_t y = 0; y < mHeight; y++)
+	{
+		auto row = mColorBuffer.GetRow(y);
+		for (uint32_t x = 0; x < mWidth; x++)
+			XMStoreFloat4A(&row[x], clear);
+	}
+	std::fill(mDepthBuffer.begin(), mDepthBuffer.end(), GetClearDepth(mDepthMode));
+
+	mTriangles.clear();
+	for (auto& bin : mBins)
+		bin.clear();
+	mDraws.clear();
+
+	mStatistics = SoftwareRasterizerStatistics();
+}
+
+void SoftwareRasterizer::Draw(const MeshData& meshData, const ObjectConstant& objectConstant,
+	const MaterialData& materialData, const Image* diffuseTexture)
+{
+	assert(meshData.topology == PrimitiveTopology::TriangleList);
+	Draw(meshData.vertices, meshData.indices, objectConstant, materialData, diffuseTexture);
+}
+void SoftwareRasterizer::Draw(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+	const ObjectConstant& objectConstant, const MaterialData& materialData, const Image* diffuseTexture)
+{
+	assert(indices.size() % 3 == 0);
+
+	auto start = std::chrono::steady_clock::now();
+
+	uint32_t drawIndex = static_cast<uint32_t>(mDraws.size());
+	mDraws.push_back({ materialData, diffuseTexture });
+
+	// Vertex stage, same math as VSMain.
+	XMMATRIX world = XMMatrixTranspose(XMLoadFloat4x4(&objectConstant.world));
+	XMMATRIX viewProj = XMLoadFloat4x4(&mViewProj);
+
+	mVertexCache.resize(vertices.size());
+	mJobSystem.ParallelFor(static_cast<uint32_t>(vertices.size()), verticesPerJob,
+		[&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; i++)
+			{
+				XMVECTOR positionW = XMVectorSetW(XMVector3Transform(XMLoadFloat3(&vertices[i].position), world), 1.0f);
+				XMVECTOR normalW = XMVector3TransformNormal(XMLoadFloat3(&vertices[i].normal), world);
+
+				auto& output = mVertexCache[i];
+				XMStoreFloat4(&output.positionH, XMVector4Transform(positionW, viewProj));
+				XMStoreFloat3(&output.positionW, positionW);
+				XMStoreFloat3(&output.normalW, normalW);
+				output.texCoord = vertices[i].texCoord;
+			}
+		});
+
+	// Triangle setup and binning, one batch per job so the merge below keeps submission order.
+	uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+	uint32_t batchCount = (triangleCount + trianglesPerJob - 1) / trianglesPerJob;
+
+	std::vector<SetupBatch> batches(batchCount);
+	mJobSystem.ParallelFor(triangleCount, trianglesPerJob,
+		[&](uint32_t begin, uint32_t end)
+		{
+			auto& batch = batches[begin / trianglesPerJob];
+			batch.bins.resize(mBins.size());
+
+			for (uint32_t i = begin; i < end; i++)
+			{
+				RasterVertex triangle[3] =
+				{
+					mVertexCache[indices[3 * i + 0]],
+					mVertexCache[indices[3 * i + 1]],
+					mVertexCache[indices[3 * i + 2]]
+				};
+				SetupTriangle(triangle, drawIndex, batch);
+			}
+		});
+
+	for (auto& batch : batches)
+	{
+		uint32_t baseIndex = static_cast<uint32_t>(mTriangles.size());
+		mTriangles.insert(mTriangles.end(), batch.triangles.begin(), batch.triangles.end());
+
+		for (size_t tile = 0; tile < mBins.size(); tile++)
+		{
+			for (auto triangleIndex : batch.bins[tile])
+				mBins[tile].push_back(baseIndex + triangleIndex);
+			mStatistics.binnedTriangleCount += static_cast<uint32_t>(batch.bins[tile].size());
+		}
+
+		mStatistics.culledTriangleCount += batch.culledTriangleCount;
+		mStatistics.clippedTriangleCount += batch.clippedTriangleCount;
+		mStatistics.rasterizedTriangleCount += static_cast<uint32_t>(batch.triangles.size());
+	}
+
+	mStatistics.drawCount++;
+	mStatistics.vertexCount += static_cast<uint32_t>(vertices.size());
+	mStatistics.triangleCount += triangleCount;
+	mStatistics.drawMilliseconds += ElapsedMilliseconds(start);
+}
+
+void SoftwareRasterizer::EndFrame()
+{
+	auto start = std::chrono::steady_clock::now();
+
+	uint32_t tileCount = mTileCountX * mTileCountY;
+	std::vector<uint64_t> shadedPixelCounts(tileCount, 0);
+	std::vector<uint64_t> depthRejectedPixelCounts(tileCount, 0);
+
+	mJobSystem.ParallelFor(tileCount, 1,
+		[&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t tile = begin; tile < end; tile++)
+				RasterizeTile(tile % mTileCountX, tile / mTileCountX,
+					shadedPixelCounts[tile], depthRejectedPixelCounts[tile]);
+		});
+
+	for (uint32_t tile = 0; tile < tileCount; tile++)
+	{
+		mStatistics.shadedPixelCount += shadedPixelCounts[tile];
+		mStatistics.depthRejectedPixelCount += depthRejectedPixelCounts[tile];
+	}
+
+	mStatistics.rasterMilliseconds = ElapsedMilliseconds(start);
+}
+
+const Image& SoftwareRasterizer::GetColorBuffer()
+{
+	return mColorBuffer;
+}
+const std::vector<float>& SoftwareRasterizer::GetDepthBuffer()
+{
+	return mDepthBuffer;
+}
+
+bool SoftwareRasterizer::SaveColorBuffer(const std::string& filename)
+{
+	std::ofstream file(filename, std::ios::binary);
+	if (!file)
+		return false;
+
+	std::vector<uint8_t> rgba(static_cast<size_t>(mWidth) * mHeight * 4);
+	mColorBuffer.StoreRGBA8(rgba.data(), mWidth * 4);
+
+	std::vector<uint8_t> rgb(static_cast<size_t>(mWidth) * mHeight * 3);
+	for (size_t i = 0; i < static_cast<size_t>(mWidth) * mHeight; i++)
+	{
+		rgb[3 * i + 0] = rgba[4 * i + 0];
+		rgb[3 * i + 1] = rgba[4 * i + 1];
+		rgb[3 * i + 2] = rgba[4 * i + 2];
+	}
+
+	file << "P6\n" << mWidth << " " << mHeight << "\n255\n";
+	file.write(reinterpret_cast<const char*>(rgb.data()), rgb.size());
+
+	return static_cast<bool>(file);
+}
+uint64_t SoftwareRasterizer::GetColorBufferHash()
+{
+	std::vector<uint8_t> rgba(static_cast<size_t>(mWidth) * mHeight * 4);
+	mColorBuffer.StoreRGBA8(rgba.data(), mWidth * 4);
+
+	uint64_t hash = 14695981039346656037ull;
+	for (auto value : rgba)
+	{
+		hash ^= value;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+SoftwareRasterizerStatistics SoftwareRasterizer::GetStatistics()
+{
+	return mStatistics;
+}
+
+void SoftwareRasterizer::SetupTriangle(const RasterVertex* vertices, uint32_t drawIndex, SetupBatch& batch)
+{
+	// Outcodes against the clip planes: reject if all vertices are outside one plane,
+	// clip only if some vertex is outside any plane.
+	uint32_t outsideMask[3] = { 0, 0, 0 };
+	for (int i = 0; i < 3; i++)
+	{
+		XMVECTOR positionH = XMLoadFloat4(&vertices[i].positionH);
+		for (int plane = 0; plane < clipPlaneCount; plane++)
+		{
+			if (XMVectorGetX(XMVector4Dot(GetClipPlane(plane), positionH)) < 0.0f)
+				outsideMask[i] |= 1u << plane;
+		}
+	}
+
+	if (outsideMask[0] & outsideMask[1] & outsideMask[2])
+	{
+		batch.culledTriangleCount++;
+		return;
+	}
+
+	if ((outsideMask[0] | outsideMask[1] | outsideMask[2]) == 0)
+	{
+		EmitTriangle(vertices[0], vertices[1], vertices[2], drawIndex, batch);
+		return;
+	}
+
+	// Sutherland-Hodgman in homogeneous clip space, attributes are interpolated linearly.
+	batch.clippedTriangleCount++;
+
+	RasterVertex polygon[2][maxClippedVertexCount];
+	int vertexCount = 3;
+	int current = 0;
+	std::copy(vertices, vertices + 3, polygon[current]);
+
+	auto lerp = [](const RasterVertex& a, const RasterVertex& b, float t)
+	{
+		RasterVertex result;
+		XMStoreFloat4(&result.positionH, XMVectorLerp(XMLoadFloat4(&a.positionH), XMLoadFloat4(&b.positionH), t));
+		XMStoreFloat3(&result.positionW, XMVectorLerp(XMLoadFloat3(&a.positionW), XMLoadFloat3(&b.positionW), t));
+		XMStoreFloat3(&result.normalW, XMVectorLerp(XMLoadFloat3(&a.normalW), XMLoadFloat3(&b.normalW), t));
+		XMStoreFloat2(&result.texCoord, XMVectorLerp(XMLoadFloat2(&a.texCoord), XMLoadFloat2(&b.texCoord), t));
+		return result;
+	};
+
+	for (int plane = 0; plane < clipPlaneCount && vertexCount >= 3; plane++)
+	{
+		if (((outsideMask[0] | outsideMask[1] | outsideMask[2]) & (1u << plane)) == 0)
+			continue;
+
+		XMVECTOR clipPlane = GetClipPlane(plane);
+		const RasterVertex* input = polygon[current];
+		RasterVertex* output = polygon[1 - current];
+		int outputCount = 0;
+
+		for (int i = 0; i < vertexCount; i++)
+		{
+			const RasterVertex& a = input[i];
+			const RasterVertex& b = input[(i + 1) % vertexCount];
+
+			float distanceA = XMVectorGetX(XMVector4Dot(clipPlane, XMLoadFloat4(&a.positionH)));
+			float distanceB = XMVectorGetX(XMVector4Dot(clipPlane, XMLoadFloat4(&b.positionH)));
+
+			if (distanceA >= 0.0f)
+				output[outputCount++] = a;
+			if ((distanceA >= 0.0f) != (distanceB >= 0.0f))
+				output[outputCount++] = lerp(a, b, distanceA / (distanceA - distanceB));
+		}
+
+		vertexCount = outputCount;
+		current = 1 - current;
+	}
+
+	for (int i = 1; i + 1 < vertexCount; i++)
+		EmitTriangle(polygon[current][0], polygon[current][i], polygon[current][i + 1], drawIndex, batch);
+}
+void SoftwareRasterizer::EmitTriangle(const RasterVertex& v0, const RasterVertex& v1, const RasterVertex& v2,
+	uint32_t drawIndex, SetupBatch& batch)
+{
+	const RasterVertex* vertices[3] = { &v0, &v1, &v2 };
+
+	RasterTriangle triangle;
+	triangle.drawIndex = drawIndex;
+
+	const float subpixelScale = static_cast<float>(1 << subpixelBits);
+	XMVECTOR viewportScale = XMVectorSet(0.5f * mWidth * subpixelScale, -0.5f * mHeight * subpixelScale, 1.0f, 1.0f);
+	XMVECTOR viewportBias = XMVectorSet(0.5f * mWidth * subpixelScale, 0.5f * mHeight * subpixelScale, 0.0f, 0.0f);
+
+	for (int i = 0; i < 3; i++)
+	{
+		XMVECTOR positionH = XMLoadFloat4(&vertices[i]->positionH);
+		float invW = 1.0f / XMVectorGetW(positionH);
+
+		XMVECTOR screen = XMVectorMultiplyAdd(positionH * invW, viewportScale, viewportBias);
+		screen = XMVectorRound(screen);
+
+		triangle.x[i] = static_cast<int32_t>(XMVectorGetX(screen));
+		triangle.y[i] = static_cast<int32_t>(XMVectorGetY(screen));
+		triangle.depth[i] = XMVectorGetZ(positionH) * invW;
+		triangle.invW[i] = invW;
+
+		float* attributes = triangle.attributes[i];
+		XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(attributes + 0), XMLoadFloat3(&vertices[i]->positionW) * invW);
+		XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(attributes + 3), XMLoadFloat3(&vertices[i]->normalW) * invW);
+		XMStoreFloat2(reinterpret_cast<XMFLOAT2*>(attributes + 6), XMLoadFloat2(&vertices[i]->texCoord) * invW);
+	}
+
+	int64_t area =
+		static_cast<int64_t>(triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0]) -
+		static_cast<int64_t>(triangle.y[1] - triangle.y[0]) * (triangle.x[2] - triangle.x[0]);
+
+	// Positive area means clockwise on screen, the front face of the D3D12 default rasterizer state.
+	if (area == 0 ||
+		(mCullMode == RasterCullMode::Back && area < 0) ||
+		(mCullMode == RasterCullMode::Front && area > 0))
+	{
+		batch.culledTriangleCount++;
+		return;
+	}
+
+	if (area < 0)
+	{
+		std::swap(triangle.x[1], triangle.x[2]);
+		std::swap(triangle.y[1], triangle.y[2]);
+		std::swap(triangle.depth[1], triangle.depth[2]);
+		std::swap(triangle.invW[1], triangle.invW[2]);
+		std::swap(triangle.attributes[1], triangle.attributes[2]);
+		area = -area;
+	}
+	triangle.area = area;
+
+	// Pixel centers covered by the bounding box.
+	const int64_t half = 1 << (subpixelBits - 1);
+	int64_t minX = std::min({ triangle.x[0], triangle.x[1], triangle.x[2] });
+	int64_t minY = std::min({ triangle.y[0], triangle.y[1], triangle.y[2] });
+	int64_t maxX = std::max({ triangle.x[0], triangle.x[1], triangle.x[2] });
+	int64_t maxY = std::max({ triangle.y[0], triangle.y[1], triangle.y[2] });
+
+	minX = std::max<int64_t>(-FloorDivide(-(minX - half), 1 << subpixelBits), 0);
+	minY = std::max<int64_t>(-FloorDivide(-(minY - half), 1 << subpixelBits), 0);
+	maxX = std::min<int64_t>(FloorDivide(maxX - half, 1 << subpixelBits), mWidth - 1);
+	maxY = std::min<int64_t>(FloorDivide(maxY - half, 1 << subpixelBits), mHeight - 1);
+
+	if (minX > maxX || minY > maxY)
+	{
+		batch.culledTriangleCount++;
+		return;
+	}
+
+	triangle.minX = static_cast<int32_t>(minX);
+	triangle.minY = static_cast<int32_t>(minY);
+	triangle.maxX = static_cast<int32_t>(maxX);
+	triangle.maxY = static_cast<int32_t>(maxY);
+
+	uint32_t triangleIndex = static_cast<uint32_t>(batch.triangles.size());
+	batch.triangles.push_back(triangle);
+
+	for (uint32_t tileY = triangle.minY / tileSize; tileY <= triangle.maxY / tileSize; tileY++)
+	{
+		for (uint32_t tileX = triangle.minX / tileSize; tileX <= triangle.maxX / tileSize; tileX++)
+			batch.bins[tileY * mTileCountX + tileX].push_back(triangleIndex);
+	}
+}
+
+void SoftwareRasterizer::RasterizeTile(uint32_t tileX, uint32_t tileY,
+	uint64_t& shadedPixelCount, uint64_t& depthRejectedPixelCount)
+{
+	const int32_t tileMinX = static_cast<int32_t>(tileX * tileSize);
+	const int32_t tileMinY = static_cast<int32_t>(tileY * tileSize);
+	const int32_t tileMaxX = std::min(tileMinX + static_cast<int32_t>(tileSize), static_cast<int32_t>(mWidth)) - 1;
+	const int32_t tileMaxY = std::min(tileMinY + static_cast<int32_t>(tileSize), static_cast<int32_t>(mHeight)) - 1;
+
+	const int64_t pixelSize = 1 << subpixelBits;
+	const int64_t half = pixelSize / 2;
+
+	const bool isGreaterDepthNearer = GetDepthComparison(mDepthMode) == DepthComparison::Greater;
+
+	for (auto triangleIndex : mBins[tileY * mTileCountX + tileX])
+	{
+		const RasterTriangle& triangle = mTriangles[triangleIndex];
+		const DrawData& drawData = mDraws[triangle.drawIndex];
+
+		int32_t minX = std::max(triangle.minX, tileMinX);
+		int32_t minY = std::max(triangle.minY, tileMinY);
+		int32_t maxX = std::min(triangle.maxX, tileMaxX);
+		int32_t maxY = std::min(triangle.maxY, tileMaxY);
+		if (minX > maxX || minY > maxY)
+			continue;
+
+		// Edge i is opposite to vertex i, so its value is the (unnormalized) barycentric of vertex i.
+		int64_t rowEdge[3];
+		int64_t stepX[3];
+		int64_t stepY[3];
+		int64_t bias[3];
+
+		int64_t sampleX = minX * pixelSize + half;
+		int64_t sampleY = minY * pixelSize + half;
+
+		for (int i = 0; i < 3; i++)
+		{
+			int a = (i + 1) % 3;
+			int b = (i + 2) % 3;
+
+			int64_t ax = triangle.x[a], ay = triangle.y[a];
+			int64_t bx = triangle.x[b], by = triangle.y[b];
+
+			rowEdge[i] = (bx - ax) * (sampleY - ay) - (by - ay) * (sampleX - ax);
+			stepX[i] = -(by - ay) * pixelSize;
+			stepY[i] = (bx - ax) * pixelSize;
+			bias[i] = IsTopLeftEdge(triangle.x[a], triangle.y[a], triangle.x[b], triangle.y[b]) ? 0 : -1;
+		}
+
+		const float invArea = 1.0f / static_cast<float>(triangle.area);
+
+		for (int32_t y = minY; y <= maxY; y++)
+		{
+			int64_t edge[3] = { rowEdge[0], rowEdge[1], rowEdge[2] };
+
+			auto colorRow = mColorBuffer.GetRow(y);
+			float* depthRow = mDepthBuffer.data() + static_cast<size_t>(y) * mWidth;
+
+			for (int32_t x = minX; x <= maxX; x++)
+			{
+				if (((edge[0] + bias[0]) | (edge[1] + bias[1]) | (edge[2] + bias[2])) >= 0)
+				{
+					float b0 = static_cast<float>(edge[0]) * invArea;
+					float b1 = static_cast<float>(edge[1]) * invArea;
+					float b2 = static_cast<float>(edge[2]) * invArea;
+
+					float depth = b0 * triangle.depth[0] + b1 * triangle.depth[1] + b2 * triangle.depth[2];
+
+					if (isGreaterDepthNearer ? depth > depthRow[x] : depth < depthRow[x])
+					{
+						depthRow[x] = depth;
+
+						float w = 1.0f / (b0 * triangle.invW[0] + b1 * triangle.invW[1] + b2 * triangle.invW[2]);
+						float attributes[8];
+						for (int k = 0; k < 8; k++)
+						{
+							attributes[k] = (b0 * triangle.attributes[0][k] +
+								b1 * triangle.attributes[1][k] + b2 * triangle.attributes[2][k]) * w;
+						}
+
+						XMVECTOR color = ShadePixel(drawData,
+							XMVectorSet(attributes[0], attributes[1], attributes[2], 1.0f),
+							XMVectorSet(attributes[3], attributes[4], attributes[5], 0.0f),
+							XMVectorSet(attributes[6], attributes[7], 0.0f, 0.0f));
+						XMStoreFloat4A(&colorRow[x], color);
+
+						shadedPixelCount++;
+					}
+					else
+					{
+						depthRejectedPixelCount++;
+					}
+				}
+
+				edge[0] += stepX[0];
+				edge[1] += stepX[1];
+				edge[2] += stepX[2];
+			}
+
+			rowEdge[0] += stepY[0];
+			rowEdge[1] += stepY[1];
+			rowEdge[2] += stepY[2];
+		}
+	}
+}
+
+XMVECTOR SoftwareRasterizer::ShadePixel(const DrawData& drawData,
+	FXMVECTOR positionW, FXMVECTOR normalW, FXMVECTOR texCoord)
+{
+	XMVECTOR normal = XMVector3Normalize(normalW);
+	XMVECTOR toEye = XMVector3Normalize(XMLoadFloat3(&mSceneConstant.cameraPosition) - positionW);
+
+	XMVECTOR diffuseAlbedo = XMLoadFloat4(&drawData.materialData.diffuseAlbedo);
+	if (drawData.diffuseTexture != nullptr)
+		diffuseAlbedo = diffuseAlbedo * SampleBilinearWrap(*drawData.diffuseTexture, texCoord);
+
+	XMVECTOR ambient = XMLoadFloat4(&mSceneConstant.ambientLight) * diffuseAlbedo;
+
+	RasterMaterial mat;
+	mat.diffuseAlbedo = diffuseAlbedo;
+	mat.fresnelR0 = XMLoadFloat3(&drawData.materialData.fresnelR0);
+	mat.shininess = 1.0f - drawData.materialData.roughness;
+
+	XMVECTOR directLight = XMVectorZero();
+	int lightIndex = 0;
+
+	for (int i = 0; i < mLightCount.directionalLightCount; i++, lightIndex++)
+		directLight += ComputeDirectionalLight(mSceneConstant.lights[lightIndex], mat, normal, toEye);
+	for (int i = 0; i < mLightCount.pointLightCount; i++, lightIndex++)
+		directLight += ComputePointLight(mSceneConstant.lights[lightIndex], mat, positionW, normal, toEye);
+	for (int i = 0; i < mLightCount.spotLightCount; i++, lightIndex++)
+		directLight += ComputeSpotLight(mSceneConstant.lights[lightIndex], mat, positionW, normal, toEye);
+
+	XMVECTOR litColor = ambient + XMVectorSetW(directLight, 0.0f);
+	return XMVectorSetW(litColor, XMVectorGetW(diffuseAlbedo));
+}
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include "../includes/StartupTaskGraph.h"
+
+StartupTaskGraph::StartupTaskGraph(JobSystem& jobSystem)
+	: mJobSystem(jobSystem)
+{
+
+}
+
+StartupTaskGraph::TaskHandle StartupTaskGraph::AddTask(const std::string& name, std::function<void()> task,
+	const std::vector<TaskHandle>& dependencies)
+{
+	TaskHandle handle = static_cast<TaskHandle>(mTasks.size());
+
+	auto newTask = std::make_unique<Task>();
+	newTask->name = name;
+	newTask->function = std::move(task);
+	newTask->dependencies = dependencies;
+
+	for (auto dependency : dependencies)
+	{
+		assert(dependency < handle);
+		mTasks[dependency]->dependents.push_back(handle);
+	}
+
+	mTasks.push_back(std::move(newTask));
+	return handle;
+}
+
+void StartupTaskGraph::Run()
+{
+	mTimings.assign(mTasks.size(), StartupTaskTiming());
+	for (size_t i = 0; i < mTasks.size(); i++)
+	{
+		mTimings[i].name = mTasks[i]->name;
+		mTasks[i]->remainingDependencyCount = static_cast<uint32_t>(mTasks[i]->dependencies.size());
+	}
+
+	mFailed = false;
+	mException = nullptr;
+	mStartTime = Clock::now();
+
+	for (TaskHandle handle = 0; handle < mTasks.size(); handle++)
+	{
+		if (mTasks[handle]->dependencies.empty())
+			Schedule(handle);
+	}
+
+	// Also waits for jobs other systems put in flight, there shouldn't be any during startup.
+	mJobSystem.Wait();
+
+	mWallMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - mStartTime).count();
+
+	if (mException)
+		std::rethrow_exception(mException);
+}
+
+const std::vector<StartupTaskTiming>& StartupTaskGraph::GetTimings()
+{
+	return mTimings;
+}
+
+std::vector<StartupTaskGraph::TaskHandle> StartupTaskGraph::GetCriticalPath()
+{
+	std::vector<TaskHandle> path;
+	if (mTimings.empty())
+		return path;
+
+	auto finishedLater = [this](TaskHandle a, TaskHandle b)
+	{
+		return mTimings[a].endMilliseconds < mTimings[b].endMilliseconds;
+	};
+
+	std::vector<TaskHandle> handles(mTasks.size());
+	for (TaskHandle handle = 0; handle < handles.size(); handle++)
+		handles[handle] = handle;
+
+	TaskHandle current = *std::max_element(handles.begin(), handles.end(), finishedLater);
+	path.push_back(current);
+
+	while (!mTasks[current]->dependencies.empty())
+	{
+		const auto& dependencies = mTasks[current]->dependencies;
+		current = *std::max_element(dependencies.begin(), dependencies.end(), finishedLater);
+		path.push_back(current);
+	}
+
+	std::reverse(path.begin(), path.end());
+	return path;
+}
+double StartupTaskGraph::GetCriticalPathMilliseconds()
+{
+	double milliseconds = 0.0;
+	for (auto handle : GetCriticalPath())
+		milliseconds += mTimings[handle].endMilliseconds - mTimings[handle].beginMilliseconds;
+
+	return milliseconds;
+}
+
+double StartupTaskGraph::GetWallMilliseconds()
+{
+	return mWallMilliseconds;
+}
+double StartupTaskGraph::GetTotalTaskMilliseconds()
+{
+	double milliseconds = 0.0;
+	for (const auto& timing : mTimings)
+		milliseconds += timing.endMilliseconds - timing.beginMilliseconds;
+
+	return milliseconds;
+}
+
+std::string StartupTaskGraph::GetTimelineReport()
+{
+	std::vector<bool> critical(mTasks.size(), false);
+	for (auto handle : GetCriticalPath())
+		critical[handle] = true;
+
+	// In start order, critical path tasks are marked with '*'.
+	std::vector<TaskHandle> order(mTasks.size());
+	for (TaskHandle handle = 0; handle < order.size(); handle++)
+		order[handle] = handle;
+	std::sort(order.begin(), order.end(), [this](TaskHandle a, TaskHandle b)
+		{
+			return mTimings[a].beginMilliseconds < mTimings[b].beginMilliseconds;
+		});
+
+	std::ostringstream report;
+	char line[256];
+	for (auto handle : order)
+	{
+		const auto& timing = mTimings[handle];
+		std::snprintf(line, sizeof(line), "%c %-24s %9.2f ms - %9.2f ms (%8.2f ms)%s\n",
+			critical[handle] ? '*' : ' ', timing.name.c_str(),
+			timing.beginMilliseconds, timing.endMilliseconds,
+			timing.endMilliseconds - timing.beginMilliseconds, timing.failed ? " failed" : "");
+		report << line;
+	}
+
+	double wallMilliseconds = GetWallMilliseconds();
+	double totalMilliseconds = GetTotalTaskMilliseconds();
+	std::snprintf(line, sizeof(line),
+		"startup: %zu tasks, wall %.2f ms, serial %.2f ms, critical path %.2f ms, speedup %.2fx\n",
+		mTasks.size(), wallMilliseconds, totalMilliseconds, GetCriticalPathMilliseconds(),
+		wallMilliseconds > 0.0 ? totalMilliseconds / wallMilliseconds : 0.0);
+	report << line;
+
+	return report.str();
+}
+
+void StartupTaskGraph::Schedule(TaskHandle handle)
+{
+	mJobSystem.Execute([this, handle]() { RunTask(handle); });
+}
+void StartupTaskGraph::RunTask(TaskHandle handle)
+{
+	Task& task = *mTasks[handle];
+	StartupTaskTiming& timing = mTimings[handle];
+
+	auto begin = Clock::now();
+	if (!mFailed.load())
+	{
+		try
+		{
+			task.function();
+		}
+		catch (...)
+		{
+			timing.failed = true;
+			mFailed = true;
+
+			std::lock_guard<std::mutex> lock(mExceptionMutex);
+			if (!mException)
+				mException = std::current_exception();
+		}
+	}
+	auto end = Clock::now();
+
+	timing.beginMilliseconds = std::chrono::duration<double, std::milli>(begin - mStartTime).count();
+	timing.endMilliseconds = std::chrono::duration<double, std::milli>(end - mStartTime).count();
+
+	// Dependents are skipped after a failure but still walked, so Run doesn't wait forever.
+	for (auto dependent : task.dependents)
+	{
+		if (mTasks[dependent]->remainingDependencyCount.fetch_sub(1) == 1)
+			Schedule(dependent);
+	}
+}
\ No newline at end of file
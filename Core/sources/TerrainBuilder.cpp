@@ -0,0 +1,273 @@
+#include "../includes/TerrainBuilder.h"
+using namespace DirectX;
+
+namespace
+{
+	double ElapsedMilliseconds(std::chrono::steady_clock::time_point start)
+	{
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	}
+
+	XMVECTOR LoadSamples(const float* samples)
+	{
+		return XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(samples));
+	}
+}
+
+HeightmapFile::HeightmapFile(const std::string& filename, uint32_t width, uint32_t height)
+{
+	Open(filename, width, height);
+}
+
+void HeightmapFile::Open(const std::string& filename, uint32_t width, uint32_t height)
+{
+	assert(width > 0 && height > 0);
+
+	mFile.close();
+	mFile.clear();
+	mFile.open(filename, std::ios::binary);
+	if (!mFile)
+		throw std::runtime_error("Failed to open heightmap " + filename);
+
+	mFile.seekg(0, std::ios::end);
+	std::streamoff expectedSize = static_cast<std::streamoff>(width) * height * sizeof(uint16_t);
+	if (static_cast<std::streamoff>(mFile.tellg()) != expectedSize)
+		throw std::runtime_error("Heightmap " + filename + " is not " +
+			std::to_string(width) + "x" + std::to_string(height) + " 16 bit samples");
+
+	mWidth = width;
+	mHeight = height;
+	mRowBuffer.resize(width);
+}
+bool HeightmapFile::IsOpen()
+{
+	return mFile.is_open();
+}
+
+uint32_t HeightmapFile::GetWidth()
+{
+	return mWidth;
+}
+uint32_t HeightmapFile::GetHeight()
+{
+	return mHeight;
+}
+
+void HeightmapFile::ReadRegion(int x, int y, uint32_t width, uint32_t height, float* heights)
+{
+	assert(IsOpen());
+
+	// The part of the region's columns inside of the map is read, the rest repeats the edge.
+	int firstColumn = std::min(std::max(x, 0), static_cast<int>(mWidth) - 1);
+	int lastColumn = std::min(std::max(x + static_cast<int>(width) - 1, 0), static_cast<int>(mWidth) - 1);
+	uint32_t columnCount = static_cast<uint32_t>(lastColumn - firstColumn + 1);
+
+	for (uint32_t row = 0; row < height; row++)
+	{
+		int fileRow = std::min(std::max(y + static_cast<int>(row), 0), static_cast<int>(mHeight) - 1);
+
+		mFile.seekg(static_cast<std::streamoff>(fileRow) * mWidth * sizeof(uint16_t) + firstColumn * sizeof(uint16_t));
+		mFile.read(reinterpret_cast<char*>(mRowBuffer.data()), columnCount * sizeof(uint16_t));
+		if (!mFile)
+			throw std::runtime_error("Failed to read heightmap row " + std::to_string(fileRow));
+
+		float* output = heights + static_cast<size_t>(row) * width;
+		for (uint32_t column = 0; column < width; column++)
+		{
+			int fileColumn = std::min(std::max(x + static_cast<int>(column), firstColumn), lastColumn);
+			output[column] = mRowBuffer[fileColumn - firstColumn] / 65535.0f;
+		}
+	}
+}
+
+TerrainBuilder::TerrainBuilder(JobSystem& jobSystem)
+	: mJobSystem(jobSystem)
+{
+}
+
+void TerrainBuilder::SetSampleSpacing(float sampleSpacing)
+{
+	assert(sampleSpacing > 0.0f);
+	mSampleSpacing = sampleSpacing;
+}
+void TerrainBuilder::SetHeightScale(float heightScale, float heightOffset)
+{
+	mHeightScale = heightScale;
+	mHeightOffset = heightOffset;
+}
+
+MeshData TerrainBuilder::Build(const float* heights, uint32_t width, uint32_t height)
+{
+	assert(heights != nullptr && width > 1 && height > 1);
+
+	mStatistics = TerrainBuilderStatistics();
+
+	GridDesc grid = { heights, width, height, 0, 0, width, height, 0, 0, width, height };
+	return BuildGrid(grid);
+}
+MeshData TerrainBuilder::Build(const unsigned char* heightValues, int width, int height, int nChannels)
+{
+	assert(heightValues != nullptr && nChannels > 0);
+
+	std::vector<float> heights(static_cast<size_t>(width) * height);
+	mJobSystem.ParallelFor(static_cast<uint32_t>(height), rowsPerJob,
+		[&heights, heightValues, width, nChannels](uint32_t begin, uint32_t end)
+		{
+			for (size_t i = begin * static_cast<size_t>(width); i < end * static_cast<size_t>(width); i++)
+				heights[i] = heightValues[i * nChannels] / 255.0f;
+		});
+
+	return Build(heights.data(), static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+}
+MeshData TerrainBuilder::BuildTile(HeightmapFile& heightmap, uint32_t tileX, uint32_t tileY, uint32_t tileSize)
+{
+	assert(tileSize > 0);
+
+	mStatistics = TerrainBuilderStatistics();
+
+	uint32_t mapWidth = heightmap.GetWidth();
+	uint32_t mapHeight = heightmap.GetHeight();
+
+	uint32_t mapX = tileX * tileSize;
+	uint32_t mapY = tileY * tileSize;
+	assert(mapX < mapWidth - 1 && mapY < mapHeight - 1);
+
+	// Tiles on the far edges of the map are smaller.
+	uint32_t vertexCountX = std::min(tileSize + 1, mapWidth - mapX);
+	uint32_t vertexCountY = std::min(tileSize + 1, mapHeight - mapY);
+
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<float> samples((vertexCountX + 2) * (vertexCountY + 2));
+	heightmap.ReadRegion(static_cast<int>(mapX) - 1, static_cast<int>(mapY) - 1,
+		vertexCountX + 2, vertexCountY + 2, samples.data());
+
+	mStatistics.readMilliseconds = ElapsedMilliseconds(start);
+
+	GridDesc grid = { samples.data(), vertexCountX + 2, vertexCountY + 2, 1, 1,
+		vertexCountX, vertexCountY, mapX, mapY, mapWidth, mapHeight };
+	return BuildGrid(grid);
+}
+
+TerrainBuilderStatistics TerrainBuilder::GetStatistics()
+{
+	return mStatistics;
+}
+
+MeshData TerrainBuilder::BuildGrid(const GridDesc& grid)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	MeshData mesh;
+	mesh.vertices.resize(static_cast<size_t>(grid.vertexCountX) * grid.vertexCountY);
+	mesh.indices.resize(static_cast<size_t>(grid.vertexCountX - 1) * (grid.vertexCountY - 1) * 6);
+
+	mJobSystem.ParallelFor(grid.vertexCountY, rowsPerJob,
+		[this, &grid, &mesh](uint32_t begin, uint32_t end)
+		{
+			BuildRows(grid, mesh, begin, end);
+		});
+
+	mStatistics.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+	mStatistics.triangleCount = static_cast<uint32_t>(mesh.indices.size() / 3);
+	mStatistics.buildMilliseconds = ElapsedMilliseconds(start);
+
+	return mesh;
+}
+void TerrainBuilder::BuildRows(const GridDesc& grid, MeshData& mesh, uint32_t begin, uint32_t end)
+{
+	float originX = -0.5f * (grid.mapWidth - 1) * mSampleSpacing;
+	float originZ = -0.5f * (grid.mapHeight - 1) * mSampleSpacing;
+	float uScale = 1.0f / (grid.mapWidth - 1);
+	float vScale = 1.0f / (grid.mapHeight - 1);
+
+	XMVECTOR heightScale = XMVectorReplicate(mHeightScale);
+	XMVECTOR normalY = XMVectorReplicate(2.0f * mSampleSpacing);
+	XMVECTOR normalYSquared = XMVectorMultiply(normalY, normalY);
+
+	// Four vertices at a time where all of their neighbours are in the sample array.
+	uint32_t simdBegin = grid.firstSampleX > 0 ? 0 : 1;
+	uint32_t simdEnd = std::min(grid.vertexCountX, grid.sampleCountX - 1 - grid.firstSampleX);
+
+	for (uint32_t y = begin; y < end; y++)
+	{
+		uint32_t sampleY = grid.firstSampleY + y;
+		const float* row = grid.samples + static_cast<size_t>(sampleY) * grid.sampleCountX + grid.firstSampleX;
+		const float* rowDown = grid.samples + static_cast<size_t>(sampleY > 0 ? sampleY - 1 : 0) * grid.sampleCountX + grid.firstSampleX;
+		const float* rowUp = grid.samples + static_cast<size_t>(std::min(sampleY + 1, grid.sampleCountY - 1)) * grid.sampleCountX + grid.firstSampleX;
+
+		Vertex* vertices = mesh.vertices.data() + static_cast<size_t>(y) * grid.vertexCountX;
+		float z = originZ + (grid.mapY + y) * mSampleSpacing;
+		float v = (grid.mapY + y) * vScale;
+
+		auto writeVertex = [&](uint32_t x, float sample, float nx, float ny, float nz)
+		{
+			Vertex& vertex = vertices[x];
+			vertex.position = XMFLOAT3(originX + (grid.mapX + x) * mSampleSpacing, sample * mHeightScale + mHeightOffset, z);
+			vertex.normal = XMFLOAT3(nx, ny, nz);
+			vertex.texCoord = XMFLOAT2((grid.mapX + x) * uScale, v);
+		};
+		auto writeScalarVertex = [&](uint32_t x)
+		{
+			// Neighbours outside of the sample array repeat the edge.
+			int sampleX = static_cast<int>(grid.firstSampleX + x);
+			float left = grid.samples[static_cast<size_t>(sampleY) * grid.sampleCountX + std::max(sampleX - 1, 0)];
+			float right = grid.samples[static_cast<size_t>(sampleY) * grid.sampleCountX +
+				std::min(sampleX + 1, static_cast<int>(grid.sampleCountX) - 1)];
+
+			float nx = (left - right) * mHeightScale;
+			float ny = 2.0f * mSampleSpacing;
+			float nz = (rowDown[x] - rowUp[x]) * mHeightScale;
+			float invLength = 1.0f / std::sqrt(nx * nx + ny * ny + nz * nz);
+
+			writeVertex(x, row[x], nx * invLength, ny * invLength, nz * invLength);
+		};
+
+		uint32_t x = 0;
+		for (; x < simdBegin && x < grid.vertexCountX; x++)
+			writeScalarVertex(x);
+
+		for (; x + 4 <= simdEnd; x += 4)
+		{
+			XMVECTOR nx = XMVectorMultiply(XMVectorSubtract(LoadSamples(row + x - 1), LoadSamples(row + x + 1)), heightScale);
+			XMVECTOR nz = XMVectorMultiply(XMVectorSubtract(LoadSamples(rowDown + x), LoadSamples(rowUp + x)), heightScale);
+			XMVECTOR lengthSquared = XMVectorMultiplyAdd(nx, nx, XMVectorMultiplyAdd(nz, nz, normalYSquared));
+			XMVECTOR invLength = XMVectorReciprocalSqrt(lengthSquared);
+
+			XMFLOAT4 normalsX, normalsY, normalsZ;
+			XMStoreFloat4(&normalsX, XMVectorMultiply(nx, invLength));
+			XMStoreFloat4(&normalsY, XMVectorMultiply(normalY, invLength));
+			XMStoreFloat4(&normalsZ, XMVectorMultiply(nz, invLength));
+
+			writeVertex(x, row[x], normalsX.x, normalsY.x, normalsZ.x);
+			writeVertex(x + 1, row[x + 1], normalsX.y, normalsY.y, normalsZ.y);
+			writeVertex(x + 2, row[x + 2], normalsX.z, normalsY.z, normalsZ.z);
+			writeVertex(x + 3, row[x + 3], normalsX.w, normalsY.w, normalsZ.w);
+		}
+
+		for (; x < grid.vertexCountX; x++)
+			writeScalarVertex(x);
+
+		// Two clockwise triangles per cell seen from above, the row's indices start at y * (countX - 1) * 6.
+		if (y + 1 < grid.vertexCountY)
+		{
+			uint32_t* indices = mesh.indices.data() + static_cast<size_t>(y) * (grid.vertexCountX - 1) * 6;
+			uint32_t rowStart = y * grid.vertexCountX;
+
+			for (uint32_t cell = 0; cell + 1 < grid.vertexCountX; cell++)
+			{
+				uint32_t i0 = rowStart + cell;
+				uint32_t i1 = i0 + grid.vertexCountX;
+
+				indices[0] = i0;
+				indices[1] = i1;
+				indices[2] = i0 + 1;
+				indices[3] = i0 + 1;
+				indices[4] = i1;
+				indices[5] = i1 + 1;
+				indices += 6;
+			}
+		}
+	}
+}
\ No newline at end of file
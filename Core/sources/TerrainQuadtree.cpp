@@ -0,0 +1,414 @@
+#include "../includes/TerrainQuadtree.h"
+using namespace DirectX;
+
+namespace
+{
+	double ElapsedMilliseconds(std::chrono::steady_clock::time_point start)
+	{
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	}
+
+	uint32_t DivideRoundUp(uint32_t value, uint32_t divisor)
+	{
+		return (value + divisor - 1) / divisor;
+	}
+}
+
+TerrainQuadtree::TerrainQuadtree(JobSystem& jobSystem)
+	: mJobSystem(jobSystem)
+{
+	for (auto& plane : mFrustumPlanes)
+		plane = XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+void TerrainQuadtree::Build(const float* heights, uint32_t width, uint32_t height,
+	float sampleSpacing, uint32_t chunkSize)
+{
+	assert(heights != nullptr && width > 0 && height > 0);
+	assert(chunkSize >= 4 && (chunkSize & (chunkSize - 1)) == 0);
+	assert(sampleSpacing > 0.0f);
+
+	auto start = std::chrono::steady_clock::now();
+
+	mWidth = width;
+	mHeight = height;
+	mSampleSpacing = sampleSpacing;
+	mChunkSize = chunkSize;
+	mOrigin = XMFLOAT2(-0.5f * width * sampleSpacing, -0.5f * height * sampleSpacing);
+
+	// Add levels until a single node covers the map.
+	mLevels.clear();
+	uint32_t nodeCountX = DivideRoundUp(width, chunkSize);
+	uint32_t nodeCountY = DivideRoundUp(height, chunkSize);
+	while (true)
+	{
+		Level level;
+		level.nodeCountX = nodeCountX;
+		level.nodeCountY = nodeCountY;
+		level.heightRanges.resize(nodeCountX * nodeCountY);
+		mLevels.push_back(std::move(level));
+
+		if ((nodeCountX == 1 && nodeCountY == 1) || mLevels.size() == maxLodCount)
+			break;
+
+		nodeCountX = DivideRoundUp(nodeCountX, 2);
+		nodeCountY = DivideRoundUp(nodeCountY, 2);
+	}
+
+	mJobSystem.ParallelFor(mLevels[0].nodeCountY, rowsPerJob,
+		[this, heights](uint32_t begin, uint32_t end)
+		{
+			BuildLeafRows(heights, begin, end);
+		});
+
+	mNodeCount = static_cast<uint32_t>(mLevels[0].heightRanges.size());
+	for (uint32_t i = 1; i < (uint32_t)mLevels.size(); i++)
+	{
+		BuildLevel(i);
+		mNodeCount += static_cast<uint32_t>(mLevels[i].heightRanges.size());
+	}
+
+	UpdateLodRanges();
+
+	mSelection.clear();
+	mFullGridChunkCount = 0;
+
+	mStatistics = TerrainQuadtreeStatistics();
+	mStatistics.nodeCount = mNodeCount;
+	mStatistics.buildMilliseconds = ElapsedMilliseconds(start);
+}
+void TerrainQuadtree::Build(const unsigned char* heightValues, int width, int height, int nChannels,
+	float heightScale, float heightOffset, float sampleSpacing, uint32_t chunkSize)
+{
+	assert(heightValues != nullptr && nChannels > 0);
+
+	std::vector<float> heights(static_cast<size_t>(width) * height);
+	for (size_t i = 0; i < heights.size(); i++)
+		heights[i] = heightValues[i * nChannels] / 255.0f * heightScale + heightOffset;
+
+	Build(heights.data(), static_cast<uint32_t>(width), static_cast<uint32_t>(height), sampleSpacing, chunkSize);
+
+	mHeightScale = heightScale;
+	mHeightOffset = heightOffset;
+}
+
+void TerrainQuadtree::SetLodDistance(float distance)
+{
+	assert(distance >= 0.0f);
+
+	mLodDistance = distance;
+	UpdateLodRanges();
+}
+void TerrainQuadtree::SetMorphStartRatio(float ratio)
+{
+	assert(ratio > 0.0f && ratio < 1.0f);
+
+	mMorphStartRatio = ratio;
+	UpdateLodRanges();
+}
+
+void TerrainQuadtree::Select(Camera& camera)
+{
+	Select(camera.GetPosition(), camera.GetFrustumPlanes());
+}
+void TerrainQuadtree::Select(const XMFLOAT3& cameraPosition, const std::array<XMFLOAT4, 6>& frustumPlanes)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	mCameraPosition = cameraPosition;
+	mFrustumPlanes = frustumPlanes;
+
+	mSelection.clear();
+	mHalfGridSelection.clear();
+
+	mStatistics.visitedNodeCount = 0;
+	mStatistics.culledNodeCount = 0;
+	mStatistics.triangleCount = 0;
+
+	if (!mLevels.empty())
+	{
+		// Roots beyond the range of the coarsest level are still drawn with it.
+		uint32_t rootLevel = static_cast<uint32_t>(mLevels.size()) - 1;
+		for (uint32_t y = 0; y < mLevels[rootLevel].nodeCountY; y++)
+		{
+			for (uint32_t x = 0; x < mLevels[rootLevel].nodeCountX; x++)
+			{
+				if (!SelectNode(rootLevel, x, y, false))
+					AddChunk(rootLevel, x, y, rootLevel);
+			}
+		}
+	}
+
+	mFullGridChunkCount = static_cast<uint32_t>(mSelection.size());
+	mSelection.insert(mSelection.end(), mHalfGridSelection.begin(), mHalfGridSelection.end());
+
+	mStatistics.selectedChunkCount = static_cast<uint32_t>(mSelection.size());
+	mStatistics.halfGridChunkCount = static_cast<uint32_t>(mHalfGridSelection.size());
+	mStatistics.selectMilliseconds = ElapsedMilliseconds(start);
+}
+
+const std::vector<TerrainChunkData>& TerrainQuadtree::GetSelection()
+{
+	return mSelection;
+}
+uint32_t TerrainQuadtree::GetFullGridChunkCount()
+{
+	return mFullGridChunkCount;
+}
+
+uint32_t TerrainQuadtree::GetLodCount()
+{
+	return static_cast<uint32_t>(mLevels.size());
+}
+uint32_t TerrainQuadtree::GetChunkSize()
+{
+	return mChunkSize;
+}
+uint32_t TerrainQuadtree::GetNodeCount()
+{
+	return mNodeCount;
+}
+float TerrainQuadtree::GetLodRange(uint32_t lodLevel)
+{
+	assert(lodLevel < mLevels.size());
+	return mLodRanges[lodLevel];
+}
+uint32_t TerrainQuadtree::GetNodeCountX(uint32_t lodLevel)
+{
+	assert(lodLevel < mLevels.size());
+	return mLevels[lodLevel].nodeCountX;
+}
+uint32_t TerrainQuadtree::GetNodeCountY(uint32_t lodLevel)
+{
+	assert(lodLevel < mLevels.size());
+	return mLevels[lodLevel].nodeCountY;
+}
+BoundingBox TerrainQuadtree::GetNodeBounds(uint32_t lodLevel, uint32_t x, uint32_t y)
+{
+	XMFLOAT3 boxMin, boxMax;
+	GetNodeBox(lodLevel, x, y, boxMin, boxMax);
+
+	BoundingBox bounds;
+	BoundingBox::CreateFromPoints(bounds, XMLoadFloat3(&boxMin), XMLoadFloat3(&boxMax));
+	return bounds;
+}
+TerrainConstant TerrainQuadtree::GetTerrainConstant()
+{
+	TerrainConstant terrainConstant;
+	terrainConstant.origin = mOrigin;
+	terrainConstant.size = XMFLOAT2(mWidth * mSampleSpacing, mHeight * mSampleSpacing);
+	terrainConstant.heightScale = mHeightScale;
+	terrainConstant.heightOffset = mHeightOffset;
+	terrainConstant.sampleSpacing = mSampleSpacing;
+	terrainConstant.pad0 = 0.0f;
+
+	return terrainConstant;
+}
+
+TerrainQuadtreeStatistics TerrainQuadtree::GetStatistics()
+{
+	return mStatistics;
+}
+
+float TerrainQuadtree::ComputeMorphFactor(float distance, float morphStart, float morphEnd)
+{
+	float factor = (distance - morphStart) / (morphEnd - morphStart);
+	return std::min(std::max(factor, 0.0f), 1.0f);
+}
+void TerrainQuadtree::MorphGridPosition(float& gridX, float& gridY, float morphFactor)
+{
+	// frac(grid * 0.5) * 2 is 1 for the odd vertices and 0 for the even ones.
+	gridX -= (gridX * 0.5f - std::floor(gridX * 0.5f)) * 2.0f * morphFactor;
+	gridY -= (gridY * 0.5f - std::floor(gridY * 0.5f)) * 2.0f * morphFactor;
+}
+
+void TerrainQuadtree::BuildLeafRows(const float* heights, uint32_t begin, uint32_t end)
+{
+	Level& leaves = mLevels[0];
+
+	for (uint32_t y = begin; y < end; y++)
+	{
+		// Bilinear filtering at the chunk's edges reads one texel outside of it.
+		uint32_t texelY0 = y * mChunkSize > 0 ? y * mChunkSize - 1 : 0;
+		uint32_t texelY1 = std::min((y + 1) * mChunkSize, mHeight - 1);
+
+		for (uint32_t x = 0; x < leaves.nodeCountX; x++)
+		{
+			uint32_t texelX0 = x * mChunkSize > 0 ? x * mChunkSize - 1 : 0;
+			uint32_t texelX1 = std::min((x + 1) * mChunkSize, mWidth - 1);
+
+			float minHeight = heights[texelY0 * mWidth + texelX0];
+			float maxHeight = minHeight;
+			for (uint32_t texelY = texelY0; texelY <= texelY1; texelY++)
+			{
+				const float* row = heights + static_cast<size_t>(texelY) * mWidth;
+				for (uint32_t texelX = texelX0; texelX <= texelX1; texelX++)
+				{
+					minHeight = std::min(minHeight, row[texelX]);
+					maxHeight = std::max(maxHeight, row[texelX]);
+				}
+			}
+
+			leaves.heightRanges[y * leaves.nodeCountX + x] = XMFLOAT2(minHeight, maxHeight);
+		}
+	}
+}
+void TerrainQuadtree::BuildLevel(uint32_t lodLevel)
+{
+	Level& level = mLevels[lodLevel];
+	const Level& children = mLevels[lodLevel - 1];
+
+	for (uint32_t y = 0; y < level.nodeCountY; y++)
+	{
+		for (uint32_t x = 0; x < level.nodeCountX; x++)
+		{
+			XMFLOAT2 heightRange = children.heightRanges[2 * y * children.nodeCountX + 2 * x];
+			for (uint32_t childY = 2 * y; childY < std::min(2 * y + 2, children.nodeCountY); childY++)
+			{
+				for (uint32_t childX = 2 * x; childX < std::min(2 * x + 2, children.nodeCountX); childX++)
+				{
+					const XMFLOAT2& childRange = children.heightRanges[childY * children.nodeCountX + childX];
+					heightRange.x = std::min(heightRange.x, childRange.x);
+					heightRange.y = std::max(heightRange.y, childRange.y);
+				}
+			}
+
+			level.heightRanges[y * level.nodeCountX + x] = heightRange;
+		}
+	}
+}
+void TerrainQuadtree::UpdateLodRanges()
+{
+	if (mLevels.empty())
+		return;
+
+	// A chunk of level l lies in a node of level l + 1 that reached into range l. Its border with a
+	// coarser chunk must be fully morphed (beyond range l) and the coarser chunk must not have started
+	// to morph there (before the morph start of level l + 1), which holds while the diagonal of a node
+	// of level l + 1 fits into morphStartRatio * range l. Level 0 is the tightest case.
+	XMFLOAT2 mapRange = mLevels.back().heightRanges[0];
+	for (const auto& range : mLevels.back().heightRanges)
+	{
+		mapRange.x = std::min(mapRange.x, range.x);
+		mapRange.y = std::max(mapRange.y, range.y);
+	}
+	float heightRange = mapRange.y - mapRange.x;
+
+	float parentSize = 2.0f * mChunkSize * mSampleSpacing;
+	float diagonal = std::sqrt(2.0f * parentSize * parentSize + heightRange * heightRange);
+
+	mLodRanges[0] = std::max(mLodDistance, diagonal / mMorphStartRatio);
+	for (uint32_t i = 1; i < (uint32_t)mLevels.size(); i++)
+		mLodRanges[i] = 2.0f * mLodRanges[i - 1];
+}
+
+void TerrainQuadtree::GetNodeBox(uint32_t lodLevel, uint32_t x, uint32_t y, XMFLOAT3& boxMin, XMFLOAT3& boxMax)
+{
+	const Level& level = mLevels[lodLevel];
+	const XMFLOAT2& heightRange = level.heightRanges[y * level.nodeCountX + x];
+
+	// Nodes on the far edges of the map are clipped to it.
+	float size = static_cast<float>(mChunkSize << lodLevel) * mSampleSpacing;
+	boxMin = XMFLOAT3(mOrigin.x + x * size, heightRange.x, mOrigin.y + y * size);
+	boxMax = XMFLOAT3(
+		std::min(boxMin.x + size, mOrigin.x + mWidth * mSampleSpacing),
+		heightRange.y,
+		std::min(boxMin.z + size, mOrigin.y + mHeight * mSampleSpacing));
+}
+bool TerrainQuadtree::IsInRange(const XMFLOAT3& boxMin, const XMFLOAT3& boxMax, float range)
+{
+	float dx = std::max(std::max(boxMin.x - mCameraPosition.x, mCameraPosition.x - boxMax.x), 0.0f);
+	float dy = std::max(std::max(boxMin.y - mCameraPosition.y, mCameraPosition.y - boxMax.y), 0.0f);
+	float dz = std::max(std::max(boxMin.z - mCameraPosition.z, mCameraPosition.z - boxMax.z), 0.0f);
+
+	return dx * dx + dy * dy + dz * dz < range * range;
+}
+TerrainQuadtree::FrustumTest TerrainQuadtree::TestFrustum(const XMFLOAT3& boxMin, const XMFLOAT3& boxMax)
+{
+	FrustumTest result = FrustumTest::Inside;
+
+	for (const auto& plane : mFrustumPlanes)
+	{
+		// The corner furthest along the plane normal, and the one furthest against it.
+		float outer = plane.w
+			+ plane.x * (plane.x >= 0.0f ? boxMax.x : boxMin.x)
+			+ plane.y * (plane.y >= 0.0f ? boxMax.y : boxMin.y)
+			+ plane.z * (plane.z >= 0.0f ? boxMax.z : boxMin.z);
+		if (outer < 0.0f)
+			return FrustumTest::Outside;
+
+		float inner = plane.w
+			+ plane.x * (plane.x >= 0.0f ? boxMin.x : boxMax.x)
+			+ plane.y * (plane.y >= 0.0f ? boxMin.y : boxMax.y)
+			+ plane.z * (plane.z >= 0.0f ? boxMin.z : boxMax.z);
+		if (inner < 0.0f)
+			result = FrustumTest::Intersects;
+	}
+
+	return result;
+}
+bool TerrainQuadtree::SelectNode(uint32_t lodLevel, uint32_t x, uint32_t y, bool insideFrustum)
+{
+	mStatistics.visitedNodeCount++;
+
+	XMFLOAT3 boxMin, boxMax;
+	GetNodeBox(lodLevel, x, y, boxMin, boxMax);
+
+	// Culled nodes count as handled, so the parent doesn't draw their area either.
+	if (!insideFrustum)
+	{
+		FrustumTest frustumTest = TestFrustum(boxMin, boxMax);
+		if (frustumTest == FrustumTest::Outside)
+		{
+			mStatistics.culledNodeCount++;
+			return true;
+		}
+		insideFrustum = frustumTest == FrustumTest::Inside;
+	}
+
+	if (!IsInRange(boxMin, boxMax, mLodRanges[lodLevel]))
+		return false;
+
+	if (lodLevel == 0 || !IsInRange(boxMin, boxMax, mLodRanges[lodLevel - 1]))
+	{
+		AddChunk(lodLevel, x, y, lodLevel);
+		return true;
+	}
+
+	// Children out of their range are drawn with this node's grid, on a quarter of it.
+	const Level& children = mLevels[lodLevel - 1];
+	for (uint32_t childY = 2 * y; childY < std::min(2 * y + 2, children.nodeCountY); childY++)
+	{
+		for (uint32_t childX = 2 * x; childX < std::min(2 * x + 2, children.nodeCountX); childX++)
+		{
+			if (!SelectNode(lodLevel - 1, childX, childY, insideFrustum))
+				AddChunk(lodLevel - 1, childX, childY, lodLevel);
+		}
+	}
+
+	return true;
+}
+void TerrainQuadtree::AddChunk(uint32_t areaLevel, uint32_t x, uint32_t y, uint32_t lodLevel)
+{
+	float size = static_cast<float>(mChunkSize << areaLevel) * mSampleSpacing;
+	uint32_t cellCount = mChunkSize >> (lodLevel - areaLevel);
+
+	float previousRange = lodLevel > 0 ? mLodRanges[lodLevel - 1] : 0.0f;
+
+	TerrainChunkData chunk;
+	chunk.origin = XMFLOAT2(mOrigin.x + x * size, mOrigin.y + y * size);
+	chunk.size = size;
+	chunk.cellCount = static_cast<float>(cellCount);
+	chunk.morphEnd = mLodRanges[lodLevel];
+	chunk.morphStart = previousRange + (chunk.morphEnd - previousRange) * mMorphStartRatio;
+	chunk.lodLevel = lodLevel;
+	chunk.pad0 = 0.0f;
+
+	if (areaLevel == lodLevel)
+		mSelection.push_back(chunk);
+	else
+		mHalfGridSelection.push_back(chunk);
+
+	mStatistics.triangleCount += 2 * cellCount * cellCount;
+}
\ No newline at end of file
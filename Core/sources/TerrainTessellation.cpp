@@ -0,0 +1,298 @@
+#include "../includes/TerrainTessellation.h"
+using namespace DirectX;
+
+namespace
+{
+	double ElapsedMilliseconds(std::chrono::steady_clock::time_point start)
+	{
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	}
+
+	// Bilinear height at (x, y) in texels from the map's min corner, with clamp addressing like the sampler.
+	float SampleHeight(const float* heights, uint32_t width, uint32_t height, float x, float y)
+	{
+		x -= 0.5f;
+		y -= 0.5f;
+		float x0 = std::floor(x);
+		float y0 = std::floor(y);
+		float fx = x - x0;
+		float fy = y - y0;
+
+		auto texel = [heights, width, height](float tx, float ty)
+		{
+			uint32_t clampedX = static_cast<uint32_t>(std::min(std::max(tx, 0.0f), width - 1.0f));
+			uint32_t clampedY = static_cast<uint32_t>(std::min(std::max(ty, 0.0f), height - 1.0f));
+			return heights[static_cast<size_t>(clampedY) * width + clampedX];
+		};
+
+		float top = texel(x0, y0) + (texel(x0 + 1.0f, y0) - texel(x0, y0)) * fx;
+		float bottom = texel(x0, y0 + 1.0f) + (texel(x0 + 1.0f, y0 + 1.0f) - texel(x0, y0 + 1.0f)) * fx;
+		return top + (bottom - top) * fy;
+	}
+
+	// Segments the fractional_odd partitioning rounds a factor up to.
+	uint32_t OddSegments(float factor)
+	{
+		return 2 * static_cast<uint32_t>(std::ceil((std::max(factor, 1.0f) - 1.0f) * 0.5f)) + 1;
+	}
+}
+
+TerrainTessellation::TerrainTessellation(JobSystem& jobSystem)
+	: mJobSystem(jobSystem)
+{
+	for (auto& plane : mTessellationConstant.frustumPlanes)
+		plane = XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
+	mTessellationConstant.projScale = 1.0f;
+	mTessellationConstant.pixelError = 1.0f;
+	mTessellationConstant.minTrianglePixels = 4.0f;
+	mTessellationConstant.maxTessFactor = 64.0f;
+}
+
+void TerrainTessellation::Build(const unsigned char* heightValues, int width, int height, int nChannels,
+	uint32_t countOfPatches, float heightScale, float heightOffset)
+{
+	assert(heightValues != nullptr && width > 0 && height > 0 && nChannels > 0);
+	assert(countOfPatches > 0);
+
+	auto start = std::chrono::steady_clock::now();
+
+	mWidth = static_cast<uint32_t>(width);
+	mHeight = static_cast<uint32_t>(height);
+	mCountOfPatches = countOfPatches;
+
+	std::vector<float> heights(static_cast<size_t>(width) * height);
+	for (size_t i = 0; i < heights.size(); i++)
+		heights[i] = heightValues[i * nChannels] / 255.0f * heightScale + heightOffset;
+
+	mPatchDatas.resize(countOfPatches * countOfPatches);
+	mPatchErrors.resize(countOfPatches * countOfPatches);
+	mPatchFactors.assign(countOfPatches * countOfPatches, PatchTessFactors());
+
+	mJobSystem.ParallelFor(countOfPatches, patchRowsPerJob,
+		[this, &heights](uint32_t begin, uint32_t end)
+		{
+			BuildPatchRows(heights.data(), begin, end);
+		});
+
+	// An edge takes the larger error of its two patches, so both compute the same factor for it.
+	for (uint32_t i = 0; i < countOfPatches; i++)
+	{
+		for (uint32_t j = 0; j < countOfPatches; j++)
+		{
+			uint32_t patch = i * countOfPatches + j;
+			float error = mPatchErrors[patch];
+
+			XMFLOAT4& edgeErrors = mPatchDatas[patch].edgeErrors;
+			edgeErrors.x = i > 0 ? std::max(error, mPatchErrors[patch - countOfPatches]) : error;
+			edgeErrors.y = j > 0 ? std::max(error, mPatchErrors[patch - 1]) : error;
+			edgeErrors.z = i + 1 < countOfPatches ? std::max(error, mPatchErrors[patch + countOfPatches]) : error;
+			edgeErrors.w = j + 1 < countOfPatches ? std::max(error, mPatchErrors[patch + 1]) : error;
+		}
+	}
+
+	mStatistics = TerrainTessellationStatistics();
+	mStatistics.patchCount = countOfPatches * countOfPatches;
+	mStatistics.buildMilliseconds = ElapsedMilliseconds(start);
+}
+
+void TerrainTessellation::SetPixelError(float pixelError)
+{
+	assert(pixelError > 0.0f);
+	mTessellationConstant.pixelError = pixelError;
+}
+void TerrainTessellation::SetMinTrianglePixels(float minTrianglePixels)
+{
+	assert(minTrianglePixels > 0.0f);
+	mTessellationConstant.minTrianglePixels = minTrianglePixels;
+}
+void TerrainTessellation::SetMaxTessFactor(float maxTessFactor)
+{
+	assert(maxTessFactor >= 1.0f && maxTessFactor <= 64.0f);
+	mTessellationConstant.maxTessFactor = maxTessFactor;
+}
+
+void TerrainTessellation::Update(Camera& camera, float viewportHeight)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	const auto& frustumPlanes = camera.GetFrustumPlanes();
+	for (uint32_t i = 0; i < 6; i++)
+		mTessellationConstant.frustumPlanes[i] = frustumPlanes[i];
+
+	// proj._22 is 1 / tan(fovY / 2), half the viewport covers that many world units at distance 1.
+	mTessellationConstant.projScale = 0.5f * viewportHeight * camera.GetProj()._22;
+	mCameraPosition = camera.GetPosition();
+
+	mJobSystem.ParallelFor(static_cast<uint32_t>(mPatchDatas.size()), 64,
+		[this](uint32_t begin, uint32_t end)
+		{
+			UpdatePatches(begin, end);
+		});
+
+	mStatistics.culledPatchCount = 0;
+	mStatistics.triangleCount = 0;
+	for (const auto& factors : mPatchFactors)
+	{
+		if (factors.edges[0] == 0.0f)
+			mStatistics.culledPatchCount++;
+		mStatistics.triangleCount += CountTriangles(factors);
+	}
+
+	mStatistics.updateMilliseconds = ElapsedMilliseconds(start);
+}
+
+const std::vector<TerrainPatchData>& TerrainTessellation::GetPatchDatas()
+{
+	return mPatchDatas;
+}
+TessellationConstant TerrainTessellation::GetTessellationConstant()
+{
+	return mTessellationConstant;
+}
+const PatchTessFactors& TerrainTessellation::GetPatchFactors(uint32_t patch)
+{
+	assert(patch < mPatchFactors.size());
+	return mPatchFactors[patch];
+}
+
+TerrainTessellationStatistics TerrainTessellation::GetStatistics()
+{
+	return mStatistics;
+}
+
+void TerrainTessellation::ComputePatchFactors(const TerrainPatchData& patch,
+	const TessellationConstant& tessellationConstant, const XMFLOAT3& cameraPosition, PatchTessFactors& factors)
+{
+	const XMFLOAT4& rect = patch.rect;
+
+	// Cull against the bounds of the displaced patch, the corner furthest along each plane normal.
+	for (const auto& plane : tessellationConstant.frustumPlanes)
+	{
+		float outer = plane.w
+			+ plane.x * (plane.x >= 0.0f ? rect.z : rect.x)
+			+ plane.y * (plane.y >= 0.0f ? patch.maxHeight : patch.minHeight)
+			+ plane.z * (plane.z >= 0.0f ? rect.w : rect.y);
+		if (outer < 0.0f)
+		{
+			factors = PatchTessFactors{ { 0.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f } };
+			return;
+		}
+	}
+
+	float centerX = 0.5f * (rect.x + rect.z);
+	float centerZ = 0.5f * (rect.y + rect.w);
+	float edgeMidX[4] = { rect.x, centerX, rect.z, centerX };
+	float edgeMidZ[4] = { centerZ, rect.y, centerZ, rect.w };
+	float edgeLengths[4] = { rect.w - rect.y, rect.z - rect.x, rect.w - rect.y, rect.z - rect.x };
+	float edgeErrors[4] = { patch.edgeErrors.x, patch.edgeErrors.y, patch.edgeErrors.z, patch.edgeErrors.w };
+	float edgeHeights[4] = { patch.edgeHeights.x, patch.edgeHeights.y, patch.edgeHeights.z, patch.edgeHeights.w };
+
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		float dx = edgeMidX[i] - cameraPosition.x;
+		float dy = edgeHeights[i] - cameraPosition.y;
+		float dz = edgeMidZ[i] - cameraPosition.z;
+		float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+
+		factors.edges[i] = ComputeEdgeFactor(edgeLengths[i], edgeErrors[i], distance, tessellationConstant);
+	}
+
+	// inside[0] splits along u, like the v = 0 and v = 1 edges.
+	factors.inside[0] = std::max(factors.edges[1], factors.edges[3]);
+	factors.inside[1] = std::max(factors.edges[0], factors.edges[2]);
+}
+float TerrainTessellation::ComputeEdgeFactor(float edgeLength, float edgeError, float distance,
+	const TessellationConstant& tessellationConstant)
+{
+	float pixelsPerUnit = tessellationConstant.projScale / std::max(distance, 0.001f);
+
+	float errorFactor = std::sqrt(edgeError * pixelsPerUnit / tessellationConstant.pixelError);
+	float lengthFactor = edgeLength * pixelsPerUnit / tessellationConstant.minTrianglePixels;
+
+	return std::min(std::max(std::min(errorFactor, lengthFactor), 1.0f), tessellationConstant.maxTessFactor);
+}
+uint32_t TerrainTessellation::CountTriangles(const PatchTessFactors& factors)
+{
+	if (factors.edges[0] == 0.0f)
+		return 0;
+
+	return 2 * OddSegments(factors.inside[0]) * OddSegments(factors.inside[1]);
+}
+
+void TerrainTessellation::BuildPatchRows(const float* heights, uint32_t begin, uint32_t end)
+{
+	float width = static_cast<float>(mWidth);
+	float height = static_cast<float>(mHeight);
+
+	for (uint32_t i = begin; i < end; i++)
+	{
+		for (uint32_t j = 0; j < mCountOfPatches; j++)
+		{
+			// The same corners as CreateTerrainPatches.
+			XMFLOAT4 rect(
+				-width / 2.0f + width * i / static_cast<float>(mCountOfPatches),
+				-height / 2.0f + height * j / static_cast<float>(mCountOfPatches),
+				-width / 2.0f + width * (i + 1) / static_cast<float>(mCountOfPatches),
+				-height / 2.0f + height * (j + 1) / static_cast<float>(mCountOfPatches));
+
+			// Texels from the map's min corner.
+			float x0 = rect.x + width / 2.0f;
+			float y0 = rect.y + height / 2.0f;
+			float x1 = rect.z + width / 2.0f;
+			float y1 = rect.w + height / 2.0f;
+
+			float corner00 = SampleHeight(heights, mWidth, mHeight, x0, y0);
+			float corner10 = SampleHeight(heights, mWidth, mHeight, x1, y0);
+			float corner01 = SampleHeight(heights, mWidth, mHeight, x0, y1);
+			float corner11 = SampleHeight(heights, mWidth, mHeight, x1, y1);
+
+			// Largest distance of a texel from the flat patch through the corners, and the height range
+			// including the texels that bilinear filtering at the edges reads.
+			float error = 0.0f;
+			float minHeight = corner00;
+			float maxHeight = corner00;
+
+			uint32_t texelX0 = static_cast<uint32_t>(std::max(std::floor(x0) - 1.0f, 0.0f));
+			uint32_t texelY0 = static_cast<uint32_t>(std::max(std::floor(y0) - 1.0f, 0.0f));
+			uint32_t texelX1 = std::min(static_cast<uint32_t>(std::ceil(x1)), mWidth - 1);
+			uint32_t texelY1 = std::min(static_cast<uint32_t>(std::ceil(y1)), mHeight - 1);
+
+			for (uint32_t texelY = texelY0; texelY <= texelY1; texelY++)
+			{
+				const float* row = heights + static_cast<size_t>(texelY) * mWidth;
+				float t = std::min(std::max((texelY + 0.5f - y0) / (y1 - y0), 0.0f), 1.0f);
+
+				for (uint32_t texelX = texelX0; texelX <= texelX1; texelX++)
+				{
+					minHeight = std::min(minHeight, row[texelX]);
+					maxHeight = std::max(maxHeight, row[texelX]);
+
+					float s = std::min(std::max((texelX + 0.5f - x0) / (x1 - x0), 0.0f), 1.0f);
+					float flat = (corner00 + (corner10 - corner00) * s) * (1.0f - t)
+						+ (corner01 + (corner11 - corner01) * s) * t;
+					error = std::max(error, std::fabs(row[texelX] - flat));
+				}
+			}
+
+			TerrainPatchData& patch = mPatchDatas[i * mCountOfPatches + j];
+			patch.rect = rect;
+			patch.edgeHeights = XMFLOAT4(
+				SampleHeight(heights, mWidth, mHeight, x0, 0.5f * (y0 + y1)),
+				SampleHeight(heights, mWidth, mHeight, 0.5f * (x0 + x1), y0),
+				SampleHeight(heights, mWidth, mHeight, x1, 0.5f * (y0 + y1)),
+				SampleHeight(heights, mWidth, mHeight, 0.5f * (x0 + x1), y1));
+			patch.minHeight = minHeight;
+			patch.maxHeight = maxHeight;
+			patch.pad0 = 0.0f;
+			patch.pad1 = 0.0f;
+
+			mPatchErrors[i * mCountOfPatches + j] = error;
+		}
+	}
+}
+void TerrainTessellation::UpdatePatches(uint32_t begin, uint32_t end)
+{
+	for (uint32_t i = begin; i < end; i++)
+		ComputePatchFactors(mPatchDatas[i], mTessellationConstant, mCameraPosition, mPatchFactors[i]);
+}
\ No newline at end of file
@@ -1,6 +1,22 @@
 #include "../includes/Texture.h"
+#include "../includes/D3D12MemoryAllocator.h"
+#include "../includes/D3D12ResourceStateTracker.h"
 using namespace DirectX;
 
+Texture& Texture::operator=(Texture other)
+{
+	std::swap(mTextureName, other.mTextureName);
+	std::swap(mTextureFilename, other.mTextureFilename);
+	std::swap(mTexture, other.mTexture);
+	std::swap(mTextureUpload, other.mTextureUpload);
+	std::swap(mIsStateTracked, other.mIsStateTracked);
+	return *this;
+}
+Texture::~Texture()
+{
+	ReleaseTexture();
+}
+
 void Texture::SetTextureFilename(const std::string& path)
 {
     mTextureFilename.assign(path.cbegin(), path.cend());
@@ -18,11 +34,14 @@ void Texture::CreateTexture(
 	ID3D12Device* device, 
 	ID3D12GraphicsCommandList* commandList,
 	const char* textureName, 
-	const wchar_t* textureFilename)
+	const wchar_t* textureFilename,
+	D3D12ResourceStateTracker* stateTracker)
 {
 	mTextureName = std::string(textureName);
 	mTextureFilename = std::wstring(textureFilename);
 
+	ReleaseTexture();
+
 	std::unique_ptr<uint8_t[]> ddsData;
 	std::vector<D3D12_SUBRESOURCE_DATA> subresources;
 	ThrowIfFailed(LoadDDSTextureFromFile(device, textureFilename, mTexture.ReleaseAndGetAddressOf(),
@@ -31,30 +50,42 @@ void Texture::CreateTexture(
 	const UINT64 uploadBufferSize = GetRequiredIntermediateSize(mTexture.Get(), 0,
 		static_cast<UINT>(subresources.size()));
 
-	// Create the GPU upload buffer.
-	ThrowIfFailed(device->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-		D3D12_HEAP_FLAG_NONE,
-		&CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize),
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(mTextureUpload.GetAddressOf())));
+	// Create the GPU upload buffer. The texture itself is committed, the DDS loader creates it.
+	mTextureUpload = D3D12MemoryAllocator::GetDefault(device).CreateBuffer(D3D12_HEAP_TYPE_UPLOAD,
+		uploadBufferSize, D3D12_RESOURCE_STATE_GENERIC_READ);
+
+	if (stateTracker == nullptr)
+	{
+		UpdateSubresources(commandList, mTexture.Get(), mTextureUpload.Get(),
+			0, 0, static_cast<UINT>(subresources.size()), subresources.data());
+		commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mTexture.Get(),
+			D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+		return;
+	}
+
+	// The loader creates the texture in COPY_DEST, the flush fixes the state of the copy before the
+	// transition is requested.
+	D3D12ResourceStateTracker::RegisterResource(mTexture.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
+	mIsStateTracked = true;
+	stateTracker->TransitionResource(mTexture.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
+	stateTracker->FlushResourceBarriers();
 
 	UpdateSubresources(commandList, mTexture.Get(), mTextureUpload.Get(),
 		0, 0, static_cast<UINT>(subresources.size()), subresources.data());
-	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mTexture.Get(),
-		D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+	stateTracker->TransitionResource(mTexture.Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 void Texture::CreateTexture(
     ID3D12Device* device, 
     ID3D12GraphicsCommandList* commandList, 
-    const char* textureName)
+    const char* textureName,
+    D3D12ResourceStateTracker* stateTracker)
 {
     Texture::CreateTexture(
         device,
         commandList,
         textureName,
-        mTextureFilename.c_str());
+        mTextureFilename.c_str(),
+        stateTracker);
 }
 
 void Texture::CreateDefaultTexture(
@@ -75,13 +106,9 @@ void Texture::CreateDefaultTexture(
     texDesc.SampleDesc.Quality = 0;
     texDesc.Width = width;
 
-    ThrowIfFailed(device->CreateCommittedResource(
-        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-        D3D12_HEAP_FLAG_NONE,
-        &texDesc,
-        D3D12_RESOURCE_STATE_COMMON,
-        nullptr,
-        IID_PPV_ARGS(&mTexture)));
+    ReleaseTexture();
+    mTexture = D3D12MemoryAllocator::GetDefault(device).CreateResource(D3D12_HEAP_TYPE_DEFAULT,
+        texDesc, D3D12_RESOURCE_STATE_COMMON);
 }
 
 ID3D12Resource* Texture::GetTextureResource()
@@ -89,6 +116,16 @@ ID3D12Resource* Texture::GetTextureResource()
 	return mTexture.Get();
 }
 
+void Texture::ReleaseTexture()
+{
+	// GlobalResourceStates is keyed by address, a later resource at the same address must not find this
+	// one's state.
+	ID3D12Resource* texture = mTexture.Get();
+	if (mTexture.Reset() == 0 && texture != nullptr && mIsStateTracked)
+		D3D12ResourceStateTracker::UnregisterResource(texture);
+	mIsStateTracked = false;
+}
+
 std::array<const CD3DX12_STATIC_SAMPLER_DESC, 7> Texture::GetStaticSamplers()
 {
     // Applications usually only need a handful of samplers.  So just define them all up front
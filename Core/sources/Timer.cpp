@@ -1,25 +1,26 @@
 #include "../includes/Timer.h"
 
 Timer::Timer()
-	: mSecondsPerCount(0.0), mDeltaTime(-1.0),
-	mBaseTime(0), mPausedTime(0), mStopTime(0),
-	mPrevTime(0), mCurrTime(0), mStopped(false)
+	: mDeltaTime(-1.0),
+	mBaseTime(Clock::now()), mPausedTime(Clock::duration::zero()), mStopTime(),
+	mPrevTime(mBaseTime), mCurrTime(mBaseTime), mStopped(false)
 {
-	__int64 countsPerSec;
-	QueryPerformanceFrequency(reinterpret_cast<LARGE_INTEGER*>(&countsPerSec));
-	mSecondsPerCount = 1.0 / static_cast<double>(countsPerSec);
 }
 
 float Timer::TotalTime() const
 {
+	std::chrono::duration<double> totalTime;
+
 	if (mStopped)
 	{
-		return static_cast<float>(((mStopTime - mPausedTime) - mBaseTime) * mSecondsPerCount);
+		totalTime = (mStopTime - mPausedTime) - mBaseTime;
 	}
 	else
 	{
-		return static_cast<float>(((mCurrTime - mPausedTime) - mBaseTime) * mSecondsPerCount);
+		totalTime = (mCurrTime - mPausedTime) - mBaseTime;
 	}
+
+	return static_cast<float>(totalTime.count());
 }
 float Timer::DeltaTime() const
 {
@@ -28,26 +29,26 @@ float Timer::DeltaTime() const
 
 void Timer::Reset()
 {
-	__int64 currTime;
-	QueryPerformanceCounter(reinterpret_cast<LARGE_INTEGER*>(&currTime));
+	Clock::time_point currTime = Clock::now();
 
 	mBaseTime = currTime;
 	mPrevTime = currTime;
-	mStopTime = 0;
+	mCurrTime = currTime;
+	mPausedTime = Clock::duration::zero();
+	mStopTime = Clock::time_point();
 	mStopped = false;
 }
 
 void Timer::Start()
 {
-	__int64 startTime;
-	QueryPerformanceCounter(reinterpret_cast<LARGE_INTEGER*>(&startTime));
+	Clock::time_point startTime = Clock::now();
 
 	if (mStopped)
 	{
 		mPausedTime += (startTime - mStopTime);
 
 		mPrevTime = startTime;
-		mStopTime = 0;
+		mStopTime = Clock::time_point();
 		mStopped = false;
 	}
 }
@@ -56,10 +57,7 @@ void Timer::Stop()
 {
 	if (!mStopped)
 	{
-		__int64 currTime;
-		QueryPerformanceCounter(reinterpret_cast<LARGE_INTEGER*>(&currTime));
-
-		mStopTime = currTime;
+		mStopTime = Clock::now();
 		mStopped = true;
 	}
 }
@@ -72,14 +70,13 @@ void Timer::Tick()
 		return;
 	}
 
-	__int64 currTime;
-	QueryPerformanceCounter(reinterpret_cast<LARGE_INTEGER*>(&currTime));
-	mCurrTime = currTime;
+	mCurrTime = Clock::now();
 
-	mDeltaTime = (mCurrTime - mPrevTime) * mSecondsPerCount;
+	mDeltaTime = std::chrono::duration<double>(mCurrTime - mPrevTime).count();
 	
-	mPrevTime = currTime;
+	mPrevTime = mCurrTime;
 
+	// steady_clock never goes backwards, but keep the guard of the QPC version.
 	if (mDeltaTime < 0.0)
 	{
 		mDeltaTime = 0.0;
@@ -0,0 +1,337 @@
+#include "../includes/TlsfAllocator.h"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+	// Index of the lowest and the highest set bit, value isn't 0.
+	uint32_t LowestBit(uint32_t value)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, value);
+		return index;
+#else
+		return static_cast<uint32_t>(__builtin_ctz(value));
+#endif
+	}
+	uint32_t HighestBit(uint32_t value)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanReverse(&index, value);
+		return index;
+#else
+		return 31 - static_cast<uint32_t>(__builtin_clz(value));
+#endif
+	}
+}
+
+TlsfAllocator::TlsfAllocator(uint32_t capacity)
+{
+	Reset(capacity);
+}
+
+void TlsfAllocator::Reset(uint32_t capacity)
+{
+	mCapacity = 0;
+	mUsedSize = 0;
+
+	mBlocks.clear();
+	mUnusedBlocks.clear();
+	mFirstBlock = noBlock;
+	mLastBlock = noBlock;
+
+	mFirstLevelBitmap = 0;
+	mSecondLevelBitmaps.fill(0);
+	std::fill(mFreeLists.begin(), mFreeLists.end(), static_cast<uint32_t>(noBlock));
+
+	mAllocations.clear();
+
+	Grow(capacity);
+}
+void TlsfAllocator::Grow(uint32_t capacity)
+{
+	assert(capacity >= mCapacity);
+	if (capacity == mCapacity)
+		return;
+
+	uint32_t addedSize = capacity - mCapacity;
+	if (mLastBlock != noBlock && mBlocks[mLastBlock].isFree)
+	{
+		// The new space extends the free block at the end.
+		RemoveFreeBlock(mLastBlock);
+		mBlocks[mLastBlock].size += addedSize;
+		InsertFreeBlock(mLastBlock);
+	}
+	else
+	{
+		uint32_t block = CreateBlock(mCapacity, addedSize);
+		mBlocks[block].previousPhysical = mLastBlock;
+		if (mLastBlock != noBlock)
+			mBlocks[mLastBlock].nextPhysical = block;
+		else
+			mFirstBlock = block;
+		mLastBlock = block;
+
+		InsertFreeBlock(block);
+	}
+
+	mCapacity = capacity;
+}
+
+uint32_t TlsfAllocator::Allocate(uint32_t size)
+{
+	assert(size > 0);
+
+	uint32_t block = FindFreeBlock(size);
+	if (block == noBlock)
+		return invalidOffset;
+
+	RemoveFreeBlock(block);
+
+	// The rest of the block stays free.
+	if (mBlocks[block].size > size)
+	{
+		uint32_t rest = CreateBlock(mBlocks[block].offset + size, mBlocks[block].size - size);
+		mBlocks[block].size = size;
+
+		mBlocks[rest].previousPhysical = block;
+		mBlocks[rest].nextPhysical = mBlocks[block].nextPhysical;
+		if (mBlocks[rest].nextPhysical != noBlock)
+			mBlocks[mBlocks[rest].nextPhysical].previousPhysical = rest;
+		else
+			mLastBlock = rest;
+		mBlocks[block].nextPhysical = rest;
+
+		InsertFreeBlock(rest);
+	}
+
+	mUsedSize += size;
+	mAllocations[mBlocks[block].offset] = block;
+	return mBlocks[block].offset;
+}
+void TlsfAllocator::Free(uint32_t offset)
+{
+	auto allocation = mAllocations.find(offset);
+	assert(allocation != mAllocations.end());
+
+	uint32_t block = allocation->second;
+	mAllocations.erase(allocation);
+	mUsedSize -= mBlocks[block].size;
+
+	// Merge with the free neighbours, the block keeps the lower offset.
+	uint32_t previous = mBlocks[block].previousPhysical;
+	if (previous != noBlock && mBlocks[previous].isFree)
+	{
+		RemoveFreeBlock(previous);
+		mBlocks[previous].size += mBlocks[block].size;
+		mBlocks[previous].nextPhysical = mBlocks[block].nextPhysical;
+		if (mBlocks[previous].nextPhysical != noBlock)
+			mBlocks[mBlocks[previous].nextPhysical].previousPhysical = previous;
+		else
+			mLastBlock = previous;
+
+		DestroyBlock(block);
+		block = previous;
+	}
+
+	uint32_t next = mBlocks[block].nextPhysical;
+	if (next != noBlock && mBlocks[next].isFree)
+	{
+		RemoveFreeBlock(next);
+		mBlocks[block].size += mBlocks[next].size;
+		mBlocks[block].nextPhysical = mBlocks[next].nextPhysical;
+		if (mBlocks[block].nextPhysical != noBlock)
+			mBlocks[mBlocks[block].nextPhysical].previousPhysical = block;
+		else
+			mLastBlock = block;
+
+		DestroyBlock(next);
+	}
+
+	InsertFreeBlock(block);
+}
+uint32_t TlsfAllocator::GetAllocationSize(uint32_t offset)
+{
+	auto allocation = mAllocations.find(offset);
+	assert(allocation != mAllocations.end());
+	return mBlocks[allocation->second].size;
+}
+
+void TlsfAllocator::Defragment(std::vector<TlsfMove>& moves)
+{
+	moves.clear();
+
+	std::vector<std::pair<uint32_t, uint32_t>> allocations; // new offset and size
+	allocations.reserve(mAllocations.size());
+
+	uint32_t offset = 0;
+	for (uint32_t block = mFirstBlock; block != noBlock; block = mBlocks[block].nextPhysical)
+	{
+		if (mBlocks[block].isFree)
+			continue;
+
+		if (mBlocks[block].offset != offset)
+			moves.push_back({ mBlocks[block].offset, offset, mBlocks[block].size });
+		allocations.push_back({ offset, mBlocks[block].size });
+		offset += mBlocks[block].size;
+	}
+
+	// Rebuild the blocks in their new places, the free space is appended by Grow.
+	uint32_t capacity = mCapacity;
+	Reset(0);
+	for (const auto& allocation : allocations)
+	{
+		uint32_t block = CreateBlock(allocation.first, allocation.second);
+		mBlocks[block].previousPhysical = mLastBlock;
+		if (mLastBlock != noBlock)
+			mBlocks[mLastBlock].nextPhysical = block;
+		else
+			mFirstBlock = block;
+		mLastBlock = block;
+
+		mAllocations[allocation.first] = block;
+		mUsedSize += allocation.second;
+	}
+	mCapacity = offset;
+	Grow(capacity);
+}
+
+uint32_t TlsfAllocator::GetCapacity()
+{
+	return mCapacity;
+}
+TlsfAllocatorStatistics TlsfAllocator::GetStatistics()
+{
+	TlsfAllocatorStatistics statistics;
+	statistics.capacity = mCapacity;
+	statistics.usedSize = mUsedSize;
+	statistics.allocationCount = static_cast<uint32_t>(mAllocations.size());
+
+	for (uint32_t block = mFirstBlock; block != noBlock; block = mBlocks[block].nextPhysical)
+	{
+		if (mBlocks[block].isFree)
+		{
+			statistics.freeBlockCount++;
+			statistics.largestFreeBlock = std::max(statistics.largestFreeBlock, mBlocks[block].size);
+		}
+	}
+
+	uint32_t freeSize = mCapacity - mUsedSize;
+	if (freeSize > 0)
+		statistics.fragmentation = 1.0f - static_cast<float>(statistics.largestFreeBlock) / freeSize;
+
+	return statistics;
+}
+
+void TlsfAllocator::GetListIndex(uint32_t size, uint32_t& firstLevel, uint32_t& secondLevel)
+{
+	// Sizes below secondLevelCount have a list each in the first level, above that every power of two
+	// is split into secondLevelCount lists.
+	if (size < secondLevelCount)
+	{
+		firstLevel = 0;
+		secondLevel = size;
+	}
+	else
+	{
+		uint32_t highestBit = HighestBit(size);
+		firstLevel = highestBit - secondLevelBits + 1;
+		secondLevel = (size >> (highestBit - secondLevelBits)) ^ secondLevelCount;
+	}
+}
+
+uint32_t TlsfAllocator::CreateBlock(uint32_t offset, uint32_t size)
+{
+	uint32_t block;
+	if (!mUnusedBlocks.empty())
+	{
+		block = mUnusedBlocks.back();
+		mUnusedBlocks.pop_back();
+		mBlocks[block] = Block();
+	}
+	else
+	{
+		block = static_cast<uint32_t>(mBlocks.size());
+		mBlocks.emplace_back();
+	}
+
+	mBlocks[block].offset = offset;
+	mBlocks[block].size = size;
+	return block;
+}
+void TlsfAllocator::DestroyBlock(uint32_t block)
+{
+	mUnusedBlocks.push_back(block);
+}
+void TlsfAllocator::InsertFreeBlock(uint32_t block)
+{
+	uint32_t firstLevel, secondLevel;
+	GetListIndex(mBlocks[block].size, firstLevel, secondLevel);
+	uint32_t& head = mFreeLists[firstLevel * secondLevelCount + secondLevel];
+
+	mBlocks[block].isFree = true;
+	mBlocks[block].previousFree = noBlock;
+	mBlocks[block].nextFree = head;
+	if (head != noBlock)
+		mBlocks[head].previousFree = block;
+	head = block;
+
+	mFirstLevelBitmap |= 1u << firstLevel;
+	mSecondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+}
+void TlsfAllocator::RemoveFreeBlock(uint32_t block)
+{
+	uint32_t firstLevel, secondLevel;
+	GetListIndex(mBlocks[block].size, firstLevel, secondLevel);
+	uint32_t& head = mFreeLists[firstLevel * secondLevelCount + secondLevel];
+
+	if (mBlocks[block].previousFree != noBlock)
+		mBlocks[mBlocks[block].previousFree].nextFree = mBlocks[block].nextFree;
+	else
+		head = mBlocks[block].nextFree;
+	if (mBlocks[block].nextFree != noBlock)
+		mBlocks[mBlocks[block].nextFree].previousFree = mBlocks[block].previousFree;
+
+	mBlocks[block].isFree = false;
+	mBlocks[block].previousFree = noBlock;
+	mBlocks[block].nextFree = noBlock;
+
+	if (head == noBlock)
+	{
+		mSecondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+		if (mSecondLevelBitmaps[firstLevel] == 0)
+			mFirstLevelBitmap &= ~(1u << firstLevel);
+	}
+}
+uint32_t TlsfAllocator::FindFreeBlock(uint32_t size)
+{
+	// Round the size up to the next list boundary, every block in that list and above is big enough.
+	uint32_t searchSize = size;
+	if (size >= secondLevelCount)
+	{
+		uint32_t roundUp = (1u << (HighestBit(size) - secondLevelBits)) - 1;
+		if (size > 0xffffffff - roundUp)
+			return noBlock;
+		searchSize += roundUp;
+	}
+
+	uint32_t firstLevel, secondLevel;
+	GetListIndex(searchSize, firstLevel, secondLevel);
+
+	uint32_t secondLevelMap = mSecondLevelBitmaps[firstLevel] & (0xffffffffu << secondLevel);
+	if (secondLevelMap == 0)
+	{
+		uint32_t firstLevelMap = firstLevel + 1 < 32 ? mFirstLevelBitmap & (0xffffffffu << (firstLevel + 1)) : 0;
+		if (firstLevelMap == 0)
+			return noBlock;
+
+		firstLevel = LowestBit(firstLevelMap);
+		secondLevelMap = mSecondLevelBitmaps[firstLevel];
+	}
+	secondLevel = LowestBit(secondLevelMap);
+
+	return mFreeLists[firstLevel * secondLevelCount + secondLevel];
+}
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "../includes/TransformHierarchy.h"
+using namespace DirectX;
+
+void TransformHierarchy::Reserve(uint32_t nodeCount)
+{
+	mLocalMatrices.reserve(nodeCount);
+	mWorldMatrices.reserve(nodeCount);
+	mParents.reserve(nodeCount);
+	mDepths.reserve(nodeCount);
+	mDirty.reserve(nodeCount);
+	mWorldChanged.reserve(nodeCount);
+}
+void TransformHierarchy::Clear()
+{
+	mLocalMatrices.clear();
+	mWorldMatrices.clear();
+	mParents.clear();
+	mDepths.clear();
+	mDirty.clear();
+	mWorldChanged.clear();
+
+	mLevelsDirty = true;
+}
+
+uint32_t TransformHierarchy::AddNode(uint32_t parent, const XMFLOAT4X4& local)
+{
+	uint32_t node = static_cast<uint32_t>(mParents.size());
+	assert(parent == invalidNode || parent < node);
+
+	XMFLOAT4X4A localMatrix;
+	XMStoreFloat4x4A(&localMatrix, XMLoadFloat4x4(&local));
+
+	mLocalMatrices.push_back(localMatrix);
+	mWorldMatrices.push_back(localMatrix);
+	mParents.push_back(parent);
+	mDepths.push_back(parent == invalidNode ? 0 : mDepths[parent] + 1);
+	mDirty.push_back(1);
+	mWorldChanged.push_back(0);
+
+	mLevelsDirty = true;
+	return node;
+}
+
+void TransformHierarchy::SetLocal(uint32_t node, const XMFLOAT4X4& local)
+{
+	SetLocal(node, XMLoadFloat4x4(&local));
+}
+void TransformHierarchy::SetLocal(uint32_t node, FXMMATRIX local)
+{
+	XMStoreFloat4x4A(&mLocalMatrices[node], local);
+	mDirty[node] = 1;
+}
+XMFLOAT4X4 TransformHierarchy::GetLocal(uint32_t node)
+{
+	XMFLOAT4X4 local;
+	XMStoreFloat4x4(&local, XMLoadFloat4x4A(&mLocalMatrices[node]));
+	return local;
+}
+
+XMFLOAT4X4 TransformHierarchy::GetWorld(uint32_t node)
+{
+	XMFLOAT4X4 world;
+	XMStoreFloat4x4(&world, XMLoadFloat4x4A(&mWorldMatrices[node]));
+	return world;
+}
+XMMATRIX TransformHierarchy::GetWorldMatrix(uint32_t node)
+{
+	return XMLoadFloat4x4A(&mWorldMatrices[node]);
+}
+bool TransformHierarchy::IsWorldChanged(uint32_t node)
+{
+	return mWorldChanged[node] != 0;
+}
+
+uint32_t TransformHierarchy::GetParent(uint32_t node)
+{
+	return mParents[node];
+}
+uint32_t TransformHierarchy::GetDepth(uint32_t node)
+{
+	return mDepths[node];
+}
+uint32_t TransformHierarchy::GetNodeCount()
+{
+	return static_cast<uint32_t>(mParents.size());
+}
+
+uint32_t TransformHierarchy::UpdateWorldMatrices()
+{
+	uint32_t updatedCount = 0;
+
+	uint32_t nodeCount = GetNodeCount();
+	for (uint32_t node = 0; node < nodeCount; node++)
+	{
+		if (UpdateNode(node))
+			updatedCount++;
+	}
+
+	return updatedCount;
+}
+uint32_t TransformHierarchy::UpdateWorldMatrices(JobSystem& jobSystem)
+{
+	if (mLevelsDirty)
+		BuildLevels();
+
+	std::atomic<uint32_t> updatedCount{ 0 };
+
+	// A level only reads the world matrices of the level above, which is complete.
+	for (size_t level = 0; level + 1 < mLevelOffsets.size(); level++)
+	{
+		uint32_t levelBegin = mLevelOffsets[level];
+		uint32_t levelSize = mLevelOffsets[level + 1] - levelBegin;
+
+		jobSystem.ParallelFor(levelSize, 2048, [this, levelBegin, &updatedCount](uint32_t begin, uint32_t end)
+			{
+				uint32_t chunkUpdatedCount = 0;
+				for (uint32_t i = begin; i < end; i++)
+				{
+					if (UpdateNode(mLevelNodes[levelBegin + i]))
+						chunkUpdatedCount++;
+				}
+				updatedCount += chunkUpdatedCount;
+			});
+	}
+
+	return updatedCount.load();
+}
+
+bool TransformHierarchy::UpdateNode(uint32_t node)
+{
+	uint32_t parent = mParents[node];
+	bool parentChanged = parent != invalidNode && mWorldChanged[parent] != 0;
+
+	bool changed = mDirty[node] != 0 || parentChanged;
+	mWorldChanged[node] = changed ? 1 : 0;
+	mDirty[node] = 0;
+
+	if (!changed)
+		return false;
+
+	XMMATRIX local = XMLoadFloat4x4A(&mLocalMatrices[node]);
+	if (parent == invalidNode)
+	{
+		XMStoreFloat4x4A(&mWorldMatrices[node], local);
+	}
+	else
+	{
+		XMMATRIX parentWorld = XMLoadFloat4x4A(&mWorldMatrices[parent]);
+		XMStoreFloat4x4A(&mWorldMatrices[node], XMMatrixMultiply(local, parentWorld));
+	}
+
+	return true;
+}
+void TransformHierarchy::BuildLevels()
+{
+	uint32_t nodeCount = GetNodeCount();
+	uint32_t levelCount = nodeCount == 0 ? 0 : *std::max_element(mDepths.begin(), mDepths.end()) + 1;
+
+	// Counting sort by depth, stable so each level keeps the storage order.
+	mLevelOffsets.assign(levelCount + 1, 0);
+	for (uint32_t node = 0; node < nodeCount; node++)
+		mLevelOffsets[mDepths[node] + 1]++;
+	for (uint32_t level = 0; level < levelCount; level++)
+		mLevelOffsets[level + 1] += mLevelOffsets[level];
+
+	std::vector<uint32_t> next(mLevelOffsets.begin(), mLevelOffsets.end() - (levelCount > 0 ? 1 : 0));
+	mLevelNodes.resize(nodeCount);
+	for (uint32_t node = 0; node < nodeCount; node++)
+		mLevelNodes[next[mDepths[node]]++] = node;
+
+	mLevelsDirty = false;
+}
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "../includes/Utility.h"
+#include "../includes/D3D12MemoryAllocator.h"
 
 const float MathUtility::PI = 3.14159265359f;
 
@@ -27,23 +28,11 @@ Microsoft::WRL::ComPtr<ID3D12Resource> D3D12Utility::CreateDefaultBuffer(
 	UINT byteSize,
 	Microsoft::WRL::ComPtr<ID3D12Resource>& uploadBuffer)
 {
-	Microsoft::WRL::ComPtr<ID3D12Resource> defaultBuffer = nullptr;
+	D3D12MemoryAllocator& allocator = D3D12MemoryAllocator::GetDefault(device);
 
-	ThrowIfFailed(device->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-		D3D12_HEAP_FLAG_NONE,
-		&CD3DX12_RESOURCE_DESC::Buffer(byteSize),
-		D3D12_RESOURCE_STATE_COMMON,
-		nullptr,
-		IID_PPV_ARGS(&defaultBuffer)));
-
-	ThrowIfFailed(device->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-		D3D12_HEAP_FLAG_NONE,
-		&CD3DX12_RESOURCE_DESC::Buffer(byteSize),
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(&uploadBuffer)));
+	Microsoft::WRL::ComPtr<ID3D12Resource> defaultBuffer =
+		allocator.CreateBuffer(D3D12_HEAP_TYPE_DEFAULT, byteSize, D3D12_RESOURCE_STATE_COMMON);
+	uploadBuffer = allocator.CreateBuffer(D3D12_HEAP_TYPE_UPLOAD, byteSize, D3D12_RESOURCE_STATE_GENERIC_READ);
 
 	D3D12_SUBRESOURCE_DATA subResource;
 	subResource.pData = initData;
@@ -58,6 +47,11 @@ Microsoft::WRL::ComPtr<ID3D12Resource> D3D12Utility::CreateDefaultBuffer(
 
 	return defaultBuffer;
 }
+Microsoft::WRL::ComPtr<ID3D12Resource> D3D12Utility::CreateDefaultBuffer(ID3D12Device* device, UINT64 byteSize)
+{
+	return D3D12MemoryAllocator::GetDefault(device).CreateBuffer(D3D12_HEAP_TYPE_DEFAULT, byteSize,
+		D3D12_RESOURCE_STATE_COMMON);
+}
 
 UINT D3D12Utility::CalculateConstantBufferSize(UINT size)
 {
@@ -0,0 +1,142 @@
+#include "../includes/BoundingVolumeHierarchy.h"
+#include "../includes/Camera.h"
+#include "TestUtility.h"
+using namespace DirectX;
+
+// Every query against brute force over the same boxes, after inserts, moves, removes and a rebuild.
+int main(int argc, char** argv)
+{
+	uint32_t objectCount = IsBenchmarkRun(argc, argv) ? 1000000 : 20000;
+
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> position(-1000.0f, 1000.0f);
+	std::uniform_real_distribution<float> extent(0.2f, 3.0f);
+
+	std::vector<BoundingBox> boxes(objectCount);
+	for (auto& box : boxes)
+	{
+		box = BoundingBox(XMFLOAT3(position(random), position(random) * 0.1f, position(random)),
+			XMFLOAT3(extent(random), extent(random), extent(random)));
+	}
+
+	BoundingVolumeHierarchy bvh;
+	std::vector<uint32_t> proxies(objectCount);
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < objectCount; i++)
+		proxies[i] = bvh.Insert(boxes[i], i);
+	double insertMilliseconds = MillisecondsSince(start);
+	float insertedCost = bvh.GetSurfaceAreaCost();
+
+	start = std::chrono::steady_clock::now();
+	bvh.Rebuild();
+	double rebuildMilliseconds = MillisecondsSince(start);
+	float rebuiltCost = bvh.GetSurfaceAreaCost();
+	std::printf("%u objects: insert %.1f ms (cost %.1f), rebuild %.1f ms (cost %.1f, height %u)\n",
+		objectCount, insertMilliseconds, insertedCost, rebuildMilliseconds, rebuiltCost, bvh.GetHeight());
+	CHECK(bvh.GetProxyCount() == objectCount);
+
+	// Proxies stay valid across Rebuild.
+	for (uint32_t i = 0; i < objectCount; i += 101)
+		CHECK(bvh.GetUserData(proxies[i]) == i);
+
+	for (uint32_t i = 0; i < objectCount; i += 10)
+	{
+		boxes[i].Center.x += 5.0f;
+		bvh.Update(proxies[i], boxes[i]);
+	}
+	for (uint32_t i = 1; i < objectCount; i += 97)
+	{
+		bvh.Remove(proxies[i]);
+		proxies[i] = bvh.Insert(boxes[i], i);
+	}
+	CHECK(bvh.GetProxyCount() == objectCount);
+
+	Camera camera;
+	camera.SetLens(0.25f * XM_PI, 16.0f / 9.0f, 1.0f, 400.0f);
+	camera.LookAt(XMFLOAT3(0.0f, 20.0f, -300.0f), XMFLOAT3(50.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f));
+	XMFLOAT4X4 view = camera.GetView();
+	XMFLOAT4X4 proj = camera.GetProj();
+	BoundingFrustum frustum;
+	BoundingFrustum::CreateFromMatrix(frustum, XMLoadFloat4x4(&proj));
+	frustum.Transform(frustum, XMMatrixInverse(nullptr, XMLoadFloat4x4(&view)));
+
+	std::vector<uint32_t> results;
+	start = std::chrono::steady_clock::now();
+	bvh.QueryFrustum(frustum, results);
+	double queryMilliseconds = MillisecondsSince(start);
+
+	std::vector<uint32_t> expected;
+	start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < objectCount; i++)
+	{
+		if (frustum.Contains(boxes[i]) != DISJOINT)
+			expected.push_back(i);
+	}
+	double bruteForceMilliseconds = MillisecondsSince(start);
+	std::sort(results.begin(), results.end());
+	std::printf("frustum: bvh %.3f ms, brute force %.3f ms, %zu visible\n",
+		queryMilliseconds, bruteForceMilliseconds, expected.size());
+	CHECK(!expected.empty());
+	CHECK(results == expected);
+
+	BoundingSphere sphere(XMFLOAT3(100.0f, 0.0f, 100.0f), 60.0f);
+	results.clear();
+	expected.clear();
+	bvh.QuerySphere(sphere, results);
+	for (uint32_t i = 0; i < objectCount; i++)
+	{
+		if (boxes[i].Intersects(sphere))
+			expected.push_back(i);
+	}
+	std::sort(results.begin(), results.end());
+	CHECK(results == expected);
+
+	// Picking rays through random pixels, the closest hit has to match.
+	std::uniform_real_distribution<float> pixelX(0.0f, 1280.0f);
+	std::uniform_real_distribution<float> pixelY(0.0f, 720.0f);
+	double rayMilliseconds = 0.0;
+	uint32_t hitCount = 0;
+	for (int ray = 0; ray < 200; ray++)
+	{
+		XMFLOAT3 origin;
+		XMFLOAT3 direction;
+		camera.GetPickingRay(pixelX(random), pixelY(random), 1280.0f, 720.0f, origin, direction);
+		XMVECTOR rayOrigin = XMLoadFloat3(&origin);
+		XMVECTOR rayDirection = XMLoadFloat3(&direction);
+
+		BvhRayHit hit;
+		start = std::chrono::steady_clock::now();
+		bool isHit = bvh.RayCast(rayOrigin, rayDirection, 2000.0f, hit);
+		rayMilliseconds += MillisecondsSince(start);
+
+		float closestDistance = 2000.0f;
+		bool isExpectedHit = false;
+		for (uint32_t i = 0; i < objectCount; i++)
+		{
+			float distance;
+			if (boxes[i].Intersects(rayOrigin, rayDirection, distance) && distance < closestDistance)
+			{
+				closestDistance = distance;
+				isExpectedHit = true;
+			}
+		}
+		CHECK(isHit == isExpectedHit);
+		CHECK(!isHit || std::fabs(hit.distance - closestDistance) < 1.0e-3f);
+		hitCount += isHit ? 1 : 0;
+	}
+	std::printf("ray: bvh %.4f ms per ray, %u of 200 hit\n", rayMilliseconds / 200.0, hitCount);
+
+	// The center pixel looks along the camera.
+	XMFLOAT3 origin;
+	XMFLOAT3 direction;
+	camera.GetPickingRay(640.0f, 360.0f, 1280.0f, 720.0f, origin, direction);
+	XMFLOAT3 look = camera.GetLook();
+	CHECK(direction.x * look.x + direction.y * look.y + direction.z * look.z > 0.9999f);
+
+	for (uint32_t i = 0; i < objectCount; i++)
+		bvh.Remove(proxies[i]);
+	CHECK(bvh.GetProxyCount() == 0);
+
+	std::printf("OK\n");
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,316 @@
+#include "../includes/Camera.h"
+#include "TestUtility.h"
+using namespace DirectX;
+
+namespace
+{
+	bool IsNear(const XMFLOAT4X4& a, FXMMATRIX b, float tolerance)
+	{
+		XMFLOAT4X4 expected;
+		XMStoreFloat4x4(&expected, b);
+		for (int row = 0; row < 4; row++)
+		{
+			for (int column = 0; column < 4; column++)
+			{
+				float scale = std::max(1.0f, std::fabs(expected(row, column)));
+				if (std::fabs(a(row, column) - expected(row, column)) > tolerance * scale)
+					return false;
+			}
+		}
+		return true;
+	}
+
+	// Every cached matrix against the one built from the camera's basis and lens right now.
+	bool MatchesRecomputed(Camera& camera)
+	{
+		XMFLOAT3 position = camera.GetPosition();
+		XMFLOAT3 look = camera.GetLook();
+		XMFLOAT3 up = camera.GetUp();
+		XMMATRIX view = XMMatrixLookToLH(XMLoadFloat3(&position), XMLoadFloat3(&look), XMLoadFloat3(&up));
+		XMMATRIX proj = XMLoadFloat4x4(&camera.GetProj());
+		XMMATRIX viewProj = XMMatrixMultiply(view, proj);
+
+		return IsNear(camera.GetView(), view, 1.0e-5f) &&
+			IsNear(camera.GetInverseView(), XMMatrixInverse(nullptr, view), 1.0e-5f) &&
+			IsNear(camera.GetViewProj(), viewProj, 1.0e-5f) &&
+			IsNear(camera.GetInverseProj(), XMMatrixInverse(nullptr, proj), 1.0e-5f) &&
+			IsNear(camera.GetInverseViewProj(), XMMatrixInverse(nullptr, viewProj), 1.0e-4f);
+	}
+
+	const DepthMode depthModes[] = { DepthMode::Standard, DepthMode::Reversed, DepthMode::ReversedInfinite };
+	const char* depthModeNames[] = { "standard", "reversed", "reversed infinite" };
+
+	// Depth of a view space distance the way the rasterizer gets it, z / w in float. Every mode keeps w = z,
+	// so the depth is _33 + _43 / z.
+	float GetDepth(const XMFLOAT4X4& proj, float z)
+	{
+		return (z * proj(2, 2) + proj(3, 2)) / (z * proj(2, 3));
+	}
+
+	// The smallest distance two surfaces at z can be apart and still get different depths: one float ulp of the
+	// depth over the slope of the depth at z.
+	double GetDepthStep(const XMFLOAT4X4& proj, float z)
+	{
+		float depth = GetDepth(proj, z);
+		double ulp = std::nextafter(depth, 2.0f) - depth;
+		double slope = std::fabs(proj(3, 2)) / (static_cast<double>(z) * z);
+		return ulp / slope;
+	}
+
+	bool IsNearer(DepthMode depthMode, float depth, float storedDepth)
+	{
+		return GetDepthComparison(depthMode) == DepthComparison::Less ? depth < storedDepth : depth > storedDepth;
+	}
+
+	// The depth of every distance inside the lens passes the test against the clear value, nearer passes against
+	// farther, and near and far land where the mode puts them.
+	void CheckDepthMapping(DepthMode depthMode, float nearZ, float farZ)
+	{
+		Camera camera;
+		camera.SetLens(0.25f * XM_PI, 16.0f / 9.0f, nearZ, farZ);
+		camera.SetDepthMode(depthMode);
+		const XMFLOAT4X4& proj = camera.GetProj();
+
+		float nearDepth = depthMode == DepthMode::Standard ? 0.0f : 1.0f;
+		float farDepth = depthMode == DepthMode::Standard ? 1.0f : depthMode == DepthMode::Reversed ? 0.0f : nearZ / farZ;
+		CHECK(std::fabs(GetDepth(proj, nearZ) - nearDepth) < 1.0e-6f);
+		CHECK(std::fabs(GetDepth(proj, farZ) - farDepth) < 1.0e-6f);
+
+		float clearDepth = GetClearDepth(depthMode);
+		for (float z = nearZ; z < 0.5f * farZ; z *= 1.7f)
+		{
+			CHECK(IsNearer(depthMode, GetDepth(proj, z), clearDepth));
+			CHECK(IsNearer(depthMode, GetDepth(proj, z), GetDepth(proj, 2.0f * z)));
+			CHECK(!IsNearer(depthMode, GetDepth(proj, 2.0f * z), GetDepth(proj, z)));
+		}
+	}
+
+	void CheckDepthSteps(float nearZ, float farZ)
+	{
+		const float distances[] = { 1.0f, 100.0f, 1000.0f, 10000.0f };
+		double steps[3][4];
+		for (int mode = 0; mode < 3; mode++)
+		{
+			Camera camera;
+			camera.SetLens(0.25f * XM_PI, 16.0f / 9.0f, nearZ, farZ);
+			camera.SetDepthMode(depthModes[mode]);
+			std::printf("%-17s depth step", depthModeNames[mode]);
+			for (int i = 0; i < 4; i++)
+			{
+				steps[mode][i] = GetDepthStep(camera.GetProj(), distances[i]);
+				std::printf("  %g at %g", steps[mode][i], distances[i]);
+			}
+			std::printf("\n");
+		}
+
+		// Standard loses all precision far away, the reversed modes stay within a millionth of the distance.
+		for (int i = 0; i < 4; i++)
+		{
+			CHECK(steps[0][i] > steps[1][i] && steps[0][i] > steps[2][i]);
+			CHECK(steps[1][i] < 1.0e-6 * distances[i] && steps[2][i] < 1.0e-6 * distances[i]);
+			if (distances[i] >= 100.0f)
+				CHECK(steps[0][i] > 100.0 * steps[1][i] && steps[0][i] > 100.0 * steps[2][i]);
+		}
+		CHECK(steps[0][3] > 1.0);
+	}
+
+	// Random points around the frustum classified by the planes against the clip space test of the projection,
+	// in double so only the points close to a plane are ambiguous, those are skipped.
+	void CheckFrustumPlanes(DepthMode depthMode)
+	{
+		Camera camera;
+		camera.SetLens(0.3f * XM_PI, 16.0f / 9.0f, 0.5f, 800.0f);
+		camera.SetDepthMode(depthMode);
+		camera.LookAt(XMFLOAT3(10.0f, 25.0f, -30.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f));
+
+		const auto& planes = camera.GetFrustumPlanes();
+		const XMFLOAT4X4& viewProj = camera.GetViewProj();
+		XMFLOAT3 position = camera.GetPosition();
+		XMFLOAT3 right = camera.GetRight();
+		XMFLOAT3 up = camera.GetUp();
+		XMFLOAT3 look = camera.GetLook();
+		float slopeX = 1.0f / camera.GetProj()(0, 0);
+		float slopeY = 1.0f / camera.GetProj()(1, 1);
+
+		std::mt19937 random(29);
+		std::uniform_real_distribution<float> depth(-20.0f, 1.2f * camera.GetFarZ());
+		std::uniform_real_distribution<float> spread(-1.4f, 1.4f);
+		int insideCount = 0;
+		int outsideCount = 0;
+		for (int i = 0; i < 20000; i++)
+		{
+			float viewZ = depth(random);
+			float viewX = spread(random) * (slopeX * std::fabs(viewZ) + 1.0f);
+			float viewY = spread(random) * (slopeY * std::fabs(viewZ) + 1.0f);
+			XMFLOAT3 point(
+				position.x + viewX * right.x + viewY * up.x + viewZ * look.x,
+				position.y + viewX * right.y + viewY * up.y + viewZ * look.y,
+				position.z + viewX * right.z + viewY * up.z + viewZ * look.z);
+
+			bool isInside = true;
+			bool isAmbiguous = false;
+			float margin = 1.0e-3f * std::max(1.0f, std::fabs(viewZ));
+			for (const XMFLOAT4& plane : planes)
+			{
+				float distance = plane.x * point.x + plane.y * point.y + plane.z * point.z + plane.w;
+				isInside = isInside && distance >= 0.0f;
+				isAmbiguous = isAmbiguous || std::fabs(distance) < margin;
+			}
+			if (isAmbiguous)
+				continue;
+
+			double clip[4];
+			for (int column = 0; column < 4; column++)
+			{
+				clip[column] = static_cast<double>(point.x) * viewProj(0, column) +
+					static_cast<double>(point.y) * viewProj(1, column) +
+					static_cast<double>(point.z) * viewProj(2, column) + viewProj(3, column);
+			}
+			bool isClipInside = std::fabs(clip[0]) <= clip[3] && std::fabs(clip[1]) <= clip[3] &&
+				clip[2] >= 0.0 && clip[2] <= clip[3];
+			// The infinite projection has no far plane, the lens' far distance is only the culling distance.
+			if (depthMode == DepthMode::ReversedInfinite)
+				isClipInside = isClipInside && viewZ <= camera.GetFarZ();
+
+			CHECK(isInside == isClipInside);
+			if (isInside)
+				insideCount++;
+			else
+				outsideCount++;
+		}
+		CHECK(insideCount > 1000 && outsideCount > 1000);
+	}
+
+	void RunBenchmark(Camera& camera)
+	{
+		const int iterationCount = 1000000;
+		float sum = 0.0f;
+
+		// What a frame did before the cache: the view from the basis, its inverse, the frustum from the
+		// projection and the view projection.
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < iterationCount; i++)
+		{
+			XMFLOAT3 position = camera.GetPosition();
+			position.x += i * 1.0e-6f;
+			XMFLOAT3 look = camera.GetLook();
+			XMFLOAT3 up = camera.GetUp();
+			XMMATRIX view = XMMatrixLookToLH(XMLoadFloat3(&position), XMLoadFloat3(&look), XMLoadFloat3(&up));
+			XMMATRIX proj = XMLoadFloat4x4(&camera.GetProj());
+			XMMATRIX inverseView = XMMatrixInverse(nullptr, view);
+
+			BoundingFrustum frustum;
+			BoundingFrustum::CreateFromMatrix(frustum, proj);
+			frustum.Transform(frustum, inverseView);
+
+			XMFLOAT4X4 viewProj;
+			XMStoreFloat4x4(&viewProj, XMMatrixMultiply(view, proj));
+			sum += viewProj(3, 2) + frustum.Origin.x;
+		}
+		double recomputeNanoseconds = MillisecondsSince(start) * 1.0e6 / iterationCount;
+
+		start = std::chrono::steady_clock::now();
+		for (int i = 0; i < iterationCount; i++)
+			sum += camera.GetViewProj()(3, 2) + camera.GetInverseView()(3, 0) + camera.GetFrustum().Origin.x;
+		double cachedNanoseconds = MillisecondsSince(start) * 1.0e6 / iterationCount;
+
+		start = std::chrono::steady_clock::now();
+		for (int i = 0; i < iterationCount; i++)
+		{
+			camera.Strafe(1.0e-6f);
+			sum += camera.GetViewProj()(3, 2) + camera.GetInverseView()(3, 0) + camera.GetFrustum().Origin.x;
+		}
+		double movedNanoseconds = MillisecondsSince(start) * 1.0e6 / iterationCount;
+
+		std::printf("per frame recompute %.1f ns, cached %.1f ns, cached after a Strafe %.1f ns (%d)\n",
+			recomputeNanoseconds, cachedNanoseconds, movedNanoseconds, static_cast<int>(sum) & 1);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Camera camera;
+	camera.SetLens(0.25f * XM_PI, 16.0f / 9.0f, 0.1f, 1000.0f);
+	CHECK(IsNear(camera.GetProj(), XMMatrixPerspectiveFovLH(0.25f * XM_PI, 16.0f / 9.0f, 0.1f, 1000.0f), 1.0e-6f));
+	CHECK(MatchesRecomputed(camera));
+
+	// Every setter marks the cache dirty, the next query sees the change.
+	camera.SetPosition(3.0f, 4.0f, -5.0f);
+	CHECK(MatchesRecomputed(camera));
+	camera.SetPosition(XMFLOAT3(-20.0f, 7.5f, 40.0f));
+	CHECK(MatchesRecomputed(camera));
+	camera.LookAt(XMFLOAT3(10.0f, 25.0f, -30.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f));
+	CHECK(MatchesRecomputed(camera));
+	camera.LookAt(-5.0f, 2.0f, 8.0f, 40.0f, -3.0f, 100.0f, 0.0f, 1.0f, 0.0f);
+	CHECK(MatchesRecomputed(camera));
+	camera.Strafe(12.5f);
+	CHECK(MatchesRecomputed(camera));
+	camera.Walk(-7.0f);
+	CHECK(MatchesRecomputed(camera));
+	camera.Pitch(0.3f);
+	CHECK(MatchesRecomputed(camera));
+	camera.RotateY(-1.1f);
+	CHECK(MatchesRecomputed(camera));
+	camera.SetLens(0.4f * XM_PI, 4.0f / 3.0f, 0.5f, 300.0f);
+	CHECK(MatchesRecomputed(camera));
+	CHECK(IsNear(camera.GetProj(), XMMatrixPerspectiveFovLH(0.4f * XM_PI, 4.0f / 3.0f, 0.5f, 300.0f), 1.0e-6f));
+
+	// A random walk with queries in between, and several changes before one query.
+	std::mt19937 random(17);
+	std::uniform_real_distribution<float> distance(-5.0f, 5.0f);
+	std::uniform_real_distribution<float> angle(-0.2f, 0.2f);
+	for (int i = 0; i < 2000; i++)
+	{
+		switch (random() % 4)
+		{
+		case 0: camera.Strafe(distance(random)); break;
+		case 1: camera.Walk(distance(random)); break;
+		case 2: camera.Pitch(angle(random)); break;
+		default: camera.RotateY(angle(random)); break;
+		}
+		if (random() % 3 == 0)
+			CHECK(MatchesRecomputed(camera));
+	}
+	CHECK(MatchesRecomputed(camera));
+
+	// The frustum and its planes follow the camera: a point ahead is inside, the camera's own position and a
+	// point behind it aren't.
+	XMFLOAT3 position = camera.GetPosition();
+	XMFLOAT3 look = camera.GetLook();
+	XMVECTOR ahead = XMVectorMultiplyAdd(XMVectorReplicate(50.0f), XMLoadFloat3(&look), XMLoadFloat3(&position));
+	XMVECTOR behind = XMVectorMultiplyAdd(XMVectorReplicate(-50.0f), XMLoadFloat3(&look), XMLoadFloat3(&position));
+	XMFLOAT3 aheadPoint, behindPoint;
+	XMStoreFloat3(&aheadPoint, ahead);
+	XMStoreFloat3(&behindPoint, behind);
+	CHECK(camera.GetFrustum().Contains(BoundingSphere(aheadPoint, 0.01f)) == CONTAINS);
+	CHECK(camera.GetFrustum().Contains(BoundingSphere(behindPoint, 0.01f)) == DISJOINT);
+	const auto& planes = camera.GetFrustumPlanes();
+	bool isAheadInside = true;
+	for (const XMFLOAT4& plane : planes)
+	{
+		CHECK(std::fabs(XMVectorGetX(XMVector3Length(XMLoadFloat4(&plane))) - 1.0f) < 1.0e-5f);
+		isAheadInside = isAheadInside && XMVectorGetX(XMPlaneDotCoord(XMLoadFloat4(&plane), ahead)) >= 0.0f;
+	}
+	CHECK(isAheadInside);
+	CHECK(XMVectorGetX(XMPlaneDotCoord(XMLoadFloat4(&planes[0]), XMLoadFloat3(&position))) < 0.0f);
+
+	// The clear value and the test flip together, the reversed modes share a depth buffer.
+	CHECK(GetClearDepth(DepthMode::Standard) == 1.0f && GetDepthComparison(DepthMode::Standard) == DepthComparison::Less);
+	CHECK(GetClearDepth(DepthMode::Reversed) == 0.0f && GetDepthComparison(DepthMode::Reversed) == DepthComparison::Greater);
+	CHECK(GetClearDepth(DepthMode::ReversedInfinite) == 0.0f &&
+		GetDepthComparison(DepthMode::ReversedInfinite) == DepthComparison::Greater);
+
+	for (DepthMode depthMode : depthModes)
+	{
+		CheckDepthMapping(depthMode, 0.1f, 10000.0f);
+		CheckDepthMapping(depthMode, 1.0f, 500.0f);
+		CheckFrustumPlanes(depthMode);
+	}
+	CheckDepthSteps(0.1f, 100000.0f);
+
+	if (IsBenchmarkRun(argc, argv))
+		RunBenchmark(camera);
+
+	std::printf("OK\n");
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,206 @@
+#include "../includes/CascadedShadows.h"
+#include "TestUtility.h"
+using namespace DirectX;
+
+namespace
+{
+	const uint32_t resolution = 2048;
+
+	// Fractional texel position of a world point in a cascade, it stays put while the cascade only snaps.
+	XMFLOAT2 GetTexelFraction(CascadedShadows& shadows, uint32_t cascade, const XMFLOAT3& positionW)
+	{
+		XMFLOAT3 uv;
+		XMStoreFloat3(&uv, XMVector3TransformCoord(XMLoadFloat3(&positionW), XMLoadFloat4x4(&shadows.GetCascade(cascade).shadowTransform)));
+		float x = uv.x * resolution;
+		float y = uv.y * resolution;
+		return XMFLOAT2(x - std::floor(x), y - std::floor(y));
+	}
+
+	float GetWrappedDistance(float a, float b)
+	{
+		float distance = std::fabs(a - b);
+		return std::min(distance, 1.0f - distance);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t casterCount = IsBenchmarkRun(argc, argv) ? 200000 : 20000;
+
+	// Splits: uniform, logarithmic and the blend in between.
+	float splits[4];
+	CascadedShadows::ComputeSplitDistances(1.0f, 100.0f, 4, 0.0f, splits);
+	CHECK(std::fabs(splits[0] - 25.75f) < 1.0e-3f && splits[3] == 100.0f);
+	CascadedShadows::ComputeSplitDistances(1.0f, 100.0f, 4, 1.0f, splits);
+	CHECK(std::fabs(splits[1] - 10.0f) < 1.0e-3f);
+	CascadedShadows::ComputeSplitDistances(1.0f, 100.0f, 4, 0.75f, splits);
+	for (int i = 1; i < 4; i++)
+		CHECK(splits[i] > splits[i - 1]);
+
+	// The slice sphere holds every corner of the slice and is no bigger than the best center found by search.
+	const float sliceNears[] = { 1.0f, 5.0f, 30.0f };
+	const float sliceFars[] = { 2.0f, 10.0f, 80.0f };
+	const float slopeX = 0.7f;
+	const float slopeY = 0.41f;
+	for (float sliceNear : sliceNears)
+	{
+		for (float sliceFar : sliceFars)
+		{
+			if (sliceFar <= sliceNear)
+				continue;
+
+			float centerZ;
+			float radius;
+			CascadedShadows::ComputeSliceSphere(slopeX, slopeY, sliceNear, sliceFar, centerZ, radius);
+
+			float bestRadius = std::numeric_limits<float>::max();
+			for (int step = 0; step <= 20000; step++)
+			{
+				float center = sliceNear + (sliceFar - sliceNear) * step / 20000.0f;
+				float farthest = 0.0f;
+				for (float z : { sliceNear, sliceFar })
+				{
+					float cornerDistance = std::sqrt((slopeX * slopeX + slopeY * slopeY) * z * z + (z - centerZ) * (z - centerZ));
+					CHECK(cornerDistance <= radius * 1.0001f);
+					farthest = std::max(farthest, std::sqrt((slopeX * slopeX + slopeY * slopeY) * z * z + (z - center) * (z - center)));
+				}
+				bestRadius = std::min(bestRadius, farthest);
+			}
+			CHECK(radius <= bestRadius * 1.001f);
+		}
+	}
+
+	JobSystem jobSystem(3);
+	Camera camera;
+	camera.SetLens(0.25f * XM_PI, 16.0f / 9.0f, 1.0f, 1000.0f);
+	camera.LookAt(XMFLOAT3(0.0f, 5.0f, -30.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f));
+
+	CascadedShadows shadows(4, resolution, jobSystem);
+	shadows.SetShadowDistance(80.0f);
+
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> position(-60.0f, 60.0f);
+	std::uniform_real_distribution<float> extent(0.2f, 3.0f);
+	std::vector<BoundingBox> casters;
+	for (uint32_t i = 0; i < casterCount; i++)
+	{
+		casters.emplace_back(XMFLOAT3(position(random), position(random) * 0.2f, position(random)), XMFLOAT3(extent(random), extent(random), extent(random)));
+		shadows.AddCaster(casters.back(), true);
+	}
+
+	const XMFLOAT3 lightDirection(0.3f, -1.0f, -0.8f);
+	shadows.Update(camera, lightDirection);
+	CHECK(shadows.GetStatistics().renderedCascadeCount == 4);
+
+	for (uint32_t cascade = 0; cascade < 4; cascade++)
+	{
+		// Every caster whose box reaches the cascade's clip volume is drawn into it, with very few extra ones.
+		const ShadowCascade& shadowCascade = shadows.GetCascade(cascade);
+		XMMATRIX viewProj = XMLoadFloat4x4(&shadowCascade.viewProj);
+		const auto& culledCasters = shadows.GetCasters(cascade);
+		uint32_t expectedCount = 0;
+		uint32_t missingCount = 0;
+		for (uint32_t i = 0; i < casterCount; i++)
+		{
+			XMFLOAT3 corners[8];
+			casters[i].GetCorners(corners);
+			XMVECTOR clipMin = XMVectorReplicate(std::numeric_limits<float>::max());
+			XMVECTOR clipMax = XMVectorNegate(clipMin);
+			for (const auto& corner : corners)
+			{
+				XMVECTOR clip = XMVector3TransformCoord(XMLoadFloat3(&corner), viewProj);
+				clipMin = XMVectorMin(clipMin, clip);
+				clipMax = XMVectorMax(clipMax, clip);
+			}
+
+			if (XMVectorGetX(clipMax) < -1.0f || XMVectorGetX(clipMin) > 1.0f || XMVectorGetY(clipMax) < -1.0f ||
+				XMVectorGetY(clipMin) > 1.0f || XMVectorGetZ(clipMax) < 0.0f || XMVectorGetZ(clipMin) > 1.0f)
+				continue;
+
+			expectedCount++;
+			missingCount += std::binary_search(culledCasters.begin(), culledCasters.end(), i) ? 0 : 1;
+		}
+		std::printf("cascade %u: %.2f to %.2f, texel %.4f, %zu casters, %u expected, %u missing\n", cascade,
+			shadowCascade.splitNear, shadowCascade.splitFar, shadowCascade.worldTexelSize, culledCasters.size(), expectedCount, missingCount);
+		CHECK(missingCount == 0 && culledCasters.size() <= expectedCount + expectedCount / 1000 + 2);
+
+		// The camera's slice of the cascade is inside the shadow map.
+		const XMFLOAT4X4& proj = camera.GetProj();
+		XMMATRIX inverseView = XMLoadFloat4x4(&camera.GetInverseView());
+		XMMATRIX shadowTransform = XMLoadFloat4x4(&shadowCascade.shadowTransform);
+		for (float z : { shadowCascade.splitNear, shadowCascade.splitFar })
+		{
+			for (uint32_t corner = 0; corner < 4; corner++)
+			{
+				XMVECTOR positionV = XMVectorSet((corner & 1 ? z : -z) / proj.m[0][0], (corner & 2 ? z : -z) / proj.m[1][1], z, 1.0f);
+				XMFLOAT3 uv;
+				XMStoreFloat3(&uv, XMVector3TransformCoord(XMVector3TransformCoord(positionV, inverseView), shadowTransform));
+				CHECK(uv.x >= 0.0f && uv.x <= 1.0f && uv.y >= 0.0f && uv.y <= 1.0f);
+			}
+		}
+	}
+
+	// Small camera moves only snap the cascades by whole texels, and the far cascades are redrawn less often.
+	const XMFLOAT3 probe(3.3f, 0.7f, 4.1f);
+	XMFLOAT2 nearFraction = GetTexelFraction(shadows, 0, probe);
+	XMFLOAT2 farFraction = GetTexelFraction(shadows, 3, probe);
+	uint32_t renderCounts[4] = {};
+	float maxDrift = 0.0f;
+	for (int frame = 0; frame < 100; frame++)
+	{
+		camera.Strafe(0.013f);
+		camera.RotateY(0.002f);
+		shadows.Update(camera, lightDirection);
+		for (uint32_t cascade = 0; cascade < 4; cascade++)
+			renderCounts[cascade] += shadows.NeedsRender(cascade) ? 1 : 0;
+
+		maxDrift = std::max(maxDrift, GetWrappedDistance(GetTexelFraction(shadows, 0, probe).x, nearFraction.x));
+		maxDrift = std::max(maxDrift, GetWrappedDistance(GetTexelFraction(shadows, 3, probe).x, farFraction.x));
+	}
+	std::printf("redrawn over 100 frames: %u %u %u %u, texel drift %g\n", renderCounts[0], renderCounts[1], renderCounts[2], renderCounts[3], maxDrift);
+	CHECK(maxDrift < 2.0e-2f);
+	CHECK(renderCounts[3] < renderCounts[0] || renderCounts[0] < 100);
+
+	// Nothing changed, nothing to draw.
+	shadows.Update(camera, lightDirection);
+	CHECK(shadows.GetStatistics().renderedCascadeCount == 0);
+
+	// Moving a static caster that is only in the last cascade redraws that cascade alone.
+	uint32_t farCaster = UINT32_MAX;
+	for (uint32_t caster : shadows.GetCasters(3))
+	{
+		bool inNearCascade = false;
+		for (uint32_t cascade = 0; cascade < 3; cascade++)
+			inNearCascade |= std::binary_search(shadows.GetCasters(cascade).begin(), shadows.GetCasters(cascade).end(), caster);
+		if (!inNearCascade)
+		{
+			farCaster = caster;
+			break;
+		}
+	}
+	CHECK(farCaster != UINT32_MAX);
+	BoundingBox movedBounds = casters[farCaster];
+	movedBounds.Center.y += 0.5f;
+	shadows.SetCasterBounds(farCaster, movedBounds);
+	shadows.Update(camera, lightDirection);
+	CHECK(shadows.NeedsRender(3) && !shadows.NeedsRender(0));
+
+	// A dynamic caster redraws its cascades every frame, a new light direction redraws all of them.
+	shadows.AddCaster(BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)), false);
+	shadows.Update(camera, lightDirection);
+	shadows.Update(camera, lightDirection);
+	CHECK(shadows.GetStatistics().renderedCascadeCount > 0);
+	shadows.Update(camera, XMFLOAT3(0.0f, -1.0f, 0.0f));
+	CHECK(shadows.GetStatistics().renderedCascadeCount == 4);
+
+	auto start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < 100; frame++)
+	{
+		camera.Strafe(0.05f);
+		shadows.Update(camera, XMFLOAT3(0.0f, -1.0f, 0.0f));
+	}
+	std::printf("update with %u casters: %.3f ms\n", casterCount + 1, MillisecondsSince(start) / 100.0);
+
+	std::printf("OK\n");
+	return 0;
+}
\ No newline at end of file
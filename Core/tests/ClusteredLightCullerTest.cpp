@@ -0,0 +1,234 @@
+#include "../includes/ClusteredLightCuller.h"
+#include "../includes/BasicGeometryGenerator.h"
+#include "../includes/SoftwareRasterizer.h"
+#include "TestUtility.h"
+using namespace DirectX;
+
+namespace
+{
+	const uint32_t clusterCountX = 16;
+	const uint32_t clusterCountY = 9;
+	const uint32_t clusterCountZ = 24;
+
+	// Brute force, one cluster and one light at a time: the sphere against the cluster box, the screen and
+	// depth range of the light's bounds against the cluster's tile, and for spot lights the cone against
+	// the cluster's bounding sphere.
+	bool TouchesCluster(Camera& camera, ClusteredLightCuller& culler, uint32_t cluster, const Light& light)
+	{
+		XMMATRIX view = XMLoadFloat4x4(&camera.GetView());
+		const XMFLOAT4X4& proj = camera.GetProj();
+		BoundingBox bounds = culler.GetClusterBounds(cluster);
+		XMFLOAT3 boundsMin(bounds.Center.x - bounds.Extents.x, bounds.Center.y - bounds.Extents.y, bounds.Center.z - bounds.Extents.z);
+		XMFLOAT3 boundsMax(bounds.Center.x + bounds.Extents.x, bounds.Center.y + bounds.Extents.y, bounds.Center.z + bounds.Extents.z);
+
+		XMFLOAT3 position;
+		XMStoreFloat3(&position, XMVector3TransformCoord(XMLoadFloat3(&light.position), view));
+		float dx = std::max(0.0f, std::max(boundsMin.x - position.x, position.x - boundsMax.x));
+		float dy = std::max(0.0f, std::max(boundsMin.y - position.y, position.y - boundsMax.y));
+		float dz = std::max(0.0f, std::max(boundsMin.z - position.z, position.z - boundsMax.z));
+		if (dx * dx + dy * dy + dz * dz > light.falloffEnd * light.falloffEnd)
+			return false;
+
+		XMFLOAT3 direction;
+		XMStoreFloat3(&direction, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&light.direction), view)));
+		float cosAngle = ClusteredLightCuller::GetSpotCosAngle(light.spotPower);
+		float sinAngle = std::sqrt(std::max(1.0f - cosAngle * cosAngle, 0.0f));
+
+		// Bounding sphere of the light, for a wide cone the one of its cap and apex.
+		XMFLOAT3 center = position;
+		float radius = light.falloffEnd;
+		if (light.spotPower > 0.0f)
+		{
+			float centerDistance = cosAngle > std::cos(XM_PIDIV4) ? 0.5f * radius / cosAngle : radius * cosAngle;
+			radius = cosAngle > std::cos(XM_PIDIV4) ? centerDistance : radius * sinAngle;
+			center = XMFLOAT3(position.x + direction.x * centerDistance, position.y + direction.y * centerDistance,
+				position.z + direction.z * centerDistance);
+		}
+
+		float nearZ = std::max(center.z - radius, camera.GetNearZ());
+		float farZ = std::min(center.z + radius, camera.GetFarZ());
+		if (farZ < nearZ || boundsMax.z < nearZ || boundsMin.z > farZ)
+			return false;
+
+		float left = std::min((center.x - radius) / nearZ, (center.x - radius) / farZ) * proj.m[0][0];
+		float right = std::max((center.x + radius) / nearZ, (center.x + radius) / farZ) * proj.m[0][0];
+		float bottom = std::min((center.y - radius) / nearZ, (center.y - radius) / farZ) * proj.m[1][1];
+		float top = std::max((center.y + radius) / nearZ, (center.y + radius) / farZ) * proj.m[1][1];
+		uint32_t tileX = cluster % clusterCountX;
+		uint32_t tileY = (cluster / clusterCountX) % clusterCountY;
+		if (right < -1.0f + 2.0f * tileX / clusterCountX || left > -1.0f + 2.0f * (tileX + 1) / clusterCountX ||
+			top < 1.0f - 2.0f * (tileY + 1) / clusterCountY || bottom > 1.0f - 2.0f * tileY / clusterCountY)
+			return false;
+
+		if (light.spotPower > 0.0f)
+		{
+			XMFLOAT3 toCluster(bounds.Center.x - position.x, bounds.Center.y - position.y, bounds.Center.z - position.z);
+			float clusterRadius = std::sqrt(bounds.Extents.x * bounds.Extents.x + bounds.Extents.y * bounds.Extents.y + bounds.Extents.z * bounds.Extents.z);
+			float lengthSquared = toCluster.x * toCluster.x + toCluster.y * toCluster.y + toCluster.z * toCluster.z;
+			float alongAxis = toCluster.x * direction.x + toCluster.y * direction.y + toCluster.z * direction.z;
+			float coneDistance = cosAngle * std::sqrt(std::max(lengthSquared - alongAxis * alongAxis, 0.0f)) - alongAxis * sinAngle;
+			if (coneDistance > clusterRadius || alongAxis > light.falloffEnd + clusterRadius || alongAxis < -clusterRadius)
+				return false;
+		}
+		return true;
+	}
+
+	float GetPixel(const Image& image, FXMMATRIX viewProj, FXMVECTOR positionW)
+	{
+		XMFLOAT3 ndc;
+		XMStoreFloat3(&ndc, XMVector3TransformCoord(positionW, viewProj));
+		uint32_t x = static_cast<uint32_t>((ndc.x + 1.0f) * 0.5f * image.GetWidth());
+		uint32_t y = static_cast<uint32_t>((1.0f - ndc.y) * 0.5f * image.GetHeight());
+		return image.GetRow(y)[x].x;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t lightCount = IsBenchmarkRun(argc, argv) ? 4096 : 1024;
+
+	JobSystem jobSystem(3);
+	Camera camera;
+	camera.SetLens(0.25f * XM_PI, 16.0f / 9.0f, 0.5f, 300.0f);
+	camera.LookAt(XMFLOAT3(0.0f, 20.0f, -60.0f), XMFLOAT3(0.0f, 0.0f, 40.0f), XMFLOAT3(0.0f, 1.0f, 0.0f));
+
+	std::mt19937 random(lightCount);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::vector<Light> lights(lightCount);
+	for (auto& light : lights)
+	{
+		light.position = XMFLOAT3(unit(random) * 300.0f - 150.0f, unit(random) * 30.0f, unit(random) * 300.0f - 100.0f);
+		light.falloffStart = 1.0f;
+		light.falloffEnd = 3.0f + unit(random) * 12.0f;
+		light.strength = XMFLOAT3(1.0f, 1.0f, 1.0f);
+		if (unit(random) < 0.4f)
+		{
+			XMStoreFloat3(&light.direction, XMVector3Normalize(XMVectorSet(unit(random) - 0.5f, -unit(random), unit(random) - 0.5f, 0.0f)));
+			light.spotPower = 2.0f + unit(random) * 60.0f;
+		}
+		else
+		{
+			light.direction = XMFLOAT3(0.0f, -1.0f, 0.0f);
+			light.spotPower = 0.0f;
+		}
+	}
+
+	ClusteredLightCuller culler(clusterCountX, clusterCountY, clusterCountZ, jobSystem);
+	culler.SetViewport(1600, 900);
+
+	const DepthMode depthModes[] = { DepthMode::Standard, DepthMode::ReversedInfinite };
+	for (DepthMode depthMode : depthModes)
+	{
+		camera.SetDepthMode(depthMode);
+		culler.AssignLights(camera, lights);
+
+		auto start = std::chrono::steady_clock::now();
+		culler.AssignLights(camera, lights);
+		double assignMilliseconds = MillisecondsSince(start);
+
+		// The same sorted list as the brute force in every cluster.
+		const auto& clusters = culler.GetClusters();
+		const auto& indices = culler.GetLightIndices();
+		uint32_t mismatchCount = 0;
+		for (uint32_t cluster = 0; cluster < culler.GetClusterCount(); cluster++)
+		{
+			std::vector<uint32_t> expected;
+			for (uint32_t light = 0; light < lightCount; light++)
+			{
+				if (TouchesCluster(camera, culler, cluster, lights[light]))
+					expected.push_back(light);
+			}
+			std::vector<uint32_t> assigned(indices.begin() + clusters[cluster].offset,
+				indices.begin() + clusters[cluster].offset + clusters[cluster].count);
+			mismatchCount += assigned != expected ? 1 : 0;
+		}
+
+		// A light that reaches a point on screen is in the list of the cluster the pixel shader picks.
+		ClusterConstant clusterConstant = culler.GetClusterConstant();
+		const XMFLOAT4X4& proj = camera.GetProj();
+		XMMATRIX inverseView = XMLoadFloat4x4(&camera.GetInverseView());
+		uint32_t shadingMissCount = 0;
+		uint32_t shadingTestCount = 0;
+		for (int i = 0; i < 20000; i++)
+		{
+			float pixelX = unit(random) * 1600.0f;
+			float pixelY = unit(random) * 900.0f;
+			float viewZ = 0.5f * std::pow(600.0f, unit(random));
+			XMVECTOR positionV = XMVectorSet((pixelX / 1600.0f * 2.0f - 1.0f) * viewZ / proj.m[0][0],
+				(1.0f - pixelY / 900.0f * 2.0f) * viewZ / proj.m[1][1], viewZ, 1.0f);
+			XMVECTOR positionW = XMVector3TransformCoord(positionV, inverseView);
+
+			uint32_t clusterX = std::min(static_cast<uint32_t>(pixelX * clusterConstant.tileScaleX), clusterCountX - 1);
+			uint32_t clusterY = std::min(static_cast<uint32_t>(pixelY * clusterConstant.tileScaleY), clusterCountY - 1);
+			float slice = std::log(viewZ) * clusterConstant.depthScale + clusterConstant.depthBias;
+			uint32_t clusterZ = static_cast<uint32_t>(std::min(std::max(slice, 0.0f), static_cast<float>(clusterCountZ - 1)));
+			const LightCluster& cluster = clusters[culler.GetClusterIndex(clusterX, clusterY, clusterZ)];
+
+			for (uint32_t light = 0; light < lightCount; light++)
+			{
+				XMVECTOR toLight = XMLoadFloat3(&lights[light].position) - positionW;
+				float distance = XMVectorGetX(XMVector3Length(toLight));
+				if (distance > lights[light].falloffEnd)
+					continue;
+				if (lights[light].spotPower > 0.0f &&
+					std::pow(std::max(XMVectorGetX(XMVector3Dot(-toLight / distance, XMLoadFloat3(&lights[light].direction))), 0.0f),
+						lights[light].spotPower) < 1.0f / 256.0f)
+					continue;
+
+				shadingTestCount++;
+				auto begin = indices.begin() + cluster.offset;
+				if (std::find(begin, begin + cluster.count, light) == begin + cluster.count)
+					shadingMissCount++;
+			}
+		}
+
+		ClusteredLightCullerStatistics statistics = culler.GetStatistics();
+		std::printf("%s, %u lights: assign %.3f ms, %u visible, %u indices, at most %u per cluster, %u mismatching clusters, %u of %u lit points missed\n",
+			depthMode == DepthMode::Standard ? "standard" : "reversed infinite", lightCount, assignMilliseconds,
+			statistics.visibleLightCount, statistics.lightIndexCount, statistics.maxLightsPerCluster, mismatchCount, shadingMissCount, shadingTestCount);
+		CHECK(mismatchCount == 0);
+		CHECK(shadingMissCount == 0 && shadingTestCount > 0);
+	}
+
+	// The CPU shading of point lights follows LightingUtility.hlsl: a floor under a light is lit at full
+	// strength inside falloffStart, fades out towards falloffEnd and is black past it.
+	SoftwareRasterizer rasterizer(64, 64, jobSystem);
+	rasterizer.SetCullMode(RasterCullMode::None);
+	RasterLightCount rasterLightCount;
+	rasterLightCount.directionalLightCount = 0;
+	rasterLightCount.pointLightCount = 1;
+	rasterizer.SetLightCount(rasterLightCount);
+
+	XMVECTOR eye = XMVectorSet(0.0f, 8.0f, 0.0f, 1.0f);
+	XMMATRIX viewProj = XMMatrixMultiply(XMMatrixLookAtLH(eye, XMVectorZero(), XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f)),
+		XMMatrixPerspectiveFovLH(0.5f * XM_PI, 1.0f, 1.0f, 100.0f));
+	SceneConstant sceneConstant{};
+	XMStoreFloat4x4(&sceneConstant.viewProj, XMMatrixTranspose(viewProj));
+	XMStoreFloat3(&sceneConstant.cameraPosition, eye);
+	sceneConstant.lights[0].strength = XMFLOAT3(1.0f, 1.0f, 1.0f);
+	sceneConstant.lights[0].position = XMFLOAT3(0.0f, 1.0f, 0.0f);
+	sceneConstant.lights[0].falloffStart = 2.0f;
+	sceneConstant.lights[0].falloffEnd = 4.0f;
+
+	ObjectConstant objectConstant{};
+	XMStoreFloat4x4(&objectConstant.world, XMMatrixIdentity());
+	MaterialData materialData = { XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), 1.0f };
+
+	BasicGeometryGenerator geometryGenerator;
+	rasterizer.BeginFrame(sceneConstant, XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f));
+	rasterizer.Draw(geometryGenerator.CreateGrid(16.0f, 16.0f, 2, 2), objectConstant, materialData);
+	rasterizer.EndFrame();
+
+	const Image& color = rasterizer.GetColorBuffer();
+	float underLight = GetPixel(color, viewProj, XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f));
+	float insideStart = GetPixel(color, viewProj, XMVectorSet(1.0f, 0.0f, 0.0f, 1.0f));
+	float fading = GetPixel(color, viewProj, XMVectorSet(2.5f, 0.0f, 0.0f, 1.0f));
+	float almostOut = GetPixel(color, viewProj, XMVectorSet(3.5f, 0.0f, 0.0f, 1.0f));
+	float outside = GetPixel(color, viewProj, XMVectorSet(5.0f, 0.0f, 0.0f, 1.0f));
+	std::printf("point light: %.3f %.3f %.3f %.3f %.3f\n", underLight, insideStart, fading, almostOut, outside);
+	CHECK(underLight > insideStart && insideStart > fading && fading > almostOut && almostOut > 0.0f);
+	CHECK(outside == 0.0f);
+
+	std::printf("OK\n");
+	return 0;
+}
\ No newline at end of file
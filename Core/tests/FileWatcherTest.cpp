@@ -0,0 +1,97 @@
+#include "../includes/FileWatcher.h"
+#include "../includes/ShaderDependencyTracker.h"
+#include "TestUtility.h"
+
+namespace
+{
+	void WriteFile(const std::string& filename, const std::string& text)
+	{
+		std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+		file << text;
+		CHECK(static_cast<bool>(file));
+	}
+
+	bool Contains(const std::vector<std::string>& files, const std::string& filename)
+	{
+		return std::find(files.begin(), files.end(), filename) != files.end();
+	}
+
+	void TestWatcher(FileWatcher& watcher)
+	{
+		WriteFile("FileWatcherTestA.hlsl", "aaaa");
+		WriteFile("FileWatcherTestB.hlsl", "bbbb");
+		WriteFile("FileWatcherTestC.hlsl", "cccc");
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+		watcher.Watch("FileWatcherTestA.hlsl");
+		watcher.Watch("FileWatcherTestB.hlsl");
+		watcher.Watch("FileWatcherTestC.hlsl");
+
+		std::vector<std::string> changedFiles;
+		watcher.Poll(changedFiles);
+		CHECK(changedFiles.empty());
+
+		// Two saves of the same size well within a second, the second one has to be seen as well.
+		WriteFile("FileWatcherTestA.hlsl", "AAAA");
+		watcher.Poll(changedFiles);
+		CHECK(changedFiles.size() == 1 && changedFiles[0] == "FileWatcherTestA.hlsl");
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		changedFiles.clear();
+		WriteFile("FileWatcherTestA.hlsl", "aaaa");
+		watcher.Poll(changedFiles);
+		CHECK(changedFiles.size() == 1 && changedFiles[0] == "FileWatcherTestA.hlsl");
+
+		// Saved by renaming a new file over the old one, and a file that isn't watched.
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		changedFiles.clear();
+		WriteFile("FileWatcherTestB.tmp", "bbbbbb");
+		CHECK(std::rename("FileWatcherTestB.tmp", "FileWatcherTestB.hlsl") == 0);
+		WriteFile("FileWatcherTestOther.txt", "other");
+		watcher.Poll(changedFiles);
+		CHECK(changedFiles.size() == 1 && changedFiles[0] == "FileWatcherTestB.hlsl");
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		changedFiles.clear();
+		watcher.Unwatch("FileWatcherTestC.hlsl");
+		WriteFile("FileWatcherTestC.hlsl", "cccccc");
+		watcher.Poll(changedFiles);
+		CHECK(changedFiles.empty());
+	}
+}
+
+int main()
+{
+	WriteFile("FileWatcherTestDefault.hlsl", "#include \"FileWatcherTestCommon.hlsl\"\n");
+	WriteFile("FileWatcherTestSky.hlsl", "#include \"FileWatcherTestCommon.hlsl\"\n");
+	WriteFile("FileWatcherTestCommon.hlsl", "#include \"FileWatcherTestLighting.hlsl\"\n");
+	WriteFile("FileWatcherTestLighting.hlsl", "\n");
+
+	ShaderCache cache("FileWatcherTestCache");
+	ShaderDependencyTracker tracker(cache);
+	tracker.SetSources(0, { "FileWatcherTestDefault.hlsl" });
+	tracker.SetSources(1, { "FileWatcherTestSky.hlsl" });
+	tracker.SetSources(2, { "FileWatcherTestMissing.hlsl" });
+
+	std::vector<std::string> files = tracker.GetFiles();
+	CHECK(Contains(files, "FileWatcherTestLighting.hlsl") && Contains(files, "FileWatcherTestMissing.hlsl"));
+	CHECK(tracker.GetAffectedGroups({ "FileWatcherTestLighting.hlsl" }) == std::vector<uint32_t>({ 0, 1 }));
+	CHECK(tracker.GetAffectedGroups({ "./FileWatcherTestSky.hlsl" }) == std::vector<uint32_t>({ 1 }));
+	CHECK(tracker.GetAffectedGroups({ "FileWatcherTestMissing.hlsl" }) == std::vector<uint32_t>({ 2 }));
+	CHECK(tracker.GetAffectedGroups({ "FileWatcherTestUnrelated.hlsl" }).empty());
+
+	// Removing an include drops the dependency once the sources are set again.
+	WriteFile("FileWatcherTestSky.hlsl", "\n");
+	cache.InvalidateFiles();
+	tracker.SetSources(1, { "FileWatcherTestSky.hlsl" });
+	CHECK(tracker.GetAffectedGroups({ "FileWatcherTestCommon.hlsl" }) == std::vector<uint32_t>({ 0 }));
+
+	PollingFileWatcher pollingWatcher;
+	TestWatcher(pollingWatcher);
+#if defined(__linux__)
+	InotifyFileWatcher inotifyWatcher;
+	TestWatcher(inotifyWatcher);
+#endif
+
+	std::printf("OK\n");
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include "../includes/FrameStatistics.h"
+#include "../includes/Timer.h"
+#include "TestUtility.h"
+#include <limits>
+#include <new>
+
+namespace
+{
+	size_t allocationCount = 0;
+}
+
+// Counts allocations, AddFrame and the queries must not make any.
+void* operator new(size_t size)
+{
+	allocationCount++;
+	if (void* memory = std::malloc(size))
+		return memory;
+	throw std::bad_alloc();
+}
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+void operator delete(void* memory, size_t size) noexcept
+{
+	std::free(memory);
+}
+
+int main()
+{
+	FrameStatistics statistics;
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> frameTime(15.0f, 17.0f);
+
+	size_t allocationsBefore = allocationCount;
+	for (int i = 0; i < 10000; i++)
+	{
+		float milliseconds = i % 1000 == 500 ? 80.0f : frameTime(random);
+		statistics.AddFrame(milliseconds / 1000.0f);
+	}
+	FrameTimeSummary summary = statistics.GetSummary();
+	float p99 = statistics.GetPercentile(99.0f);
+	CHECK(allocationCount == allocationsBefore);
+
+	CHECK(summary.sampleCount == FrameStatistics::windowSize);
+	CHECK(summary.minMilliseconds >= 15.0f && summary.p50Milliseconds < 17.0f);
+	CHECK(summary.maxMilliseconds == 80.0f);
+	CHECK(p99 == summary.p99Milliseconds);
+	CHECK(statistics.GetHitchCount() == 10);
+	CHECK(statistics.GetLastHitchFrame() == 9500);
+	CHECK(std::abs(statistics.GetSmoothedFps() - 62.5f) < 3.0f);
+
+	uint32_t histogramTotal = 0;
+	for (uint32_t count : statistics.GetHistogram())
+		histogramTotal += count;
+	CHECK(histogramTotal == FrameStatistics::windowSize);
+	CHECK(statistics.GetHistogram()[80] == 1);
+
+	// Nearest rank over 1 to 100 ms.
+	FrameStatistics ranks;
+	for (int i = 1; i <= 100; i++)
+		ranks.AddFrame(i / 1000.0f);
+	CHECK(std::abs(ranks.GetPercentile(50.0f) - 50.0f) < 1.0e-3f);
+	CHECK(std::abs(ranks.GetPercentile(95.0f) - 95.0f) < 1.0e-3f);
+	CHECK(std::abs(ranks.GetPercentile(0.0f) - 1.0f) < 1.0e-3f);
+	CHECK(std::abs(ranks.GetPercentile(100.0f) - 100.0f) < 1.0e-3f);
+
+	// Times outside of the histogram's range are clamped into its first and last bucket, non-finite times are
+	// dropped.
+	FrameStatistics outliers;
+	outliers.AddFrame(std::numeric_limits<float>::quiet_NaN());
+	outliers.AddFrame(-1.0f);
+	outliers.AddFrame(1.0e30f);
+	outliers.AddFrame(std::numeric_limits<float>::infinity());
+	outliers.AddFrame(-std::numeric_limits<float>::infinity());
+	CHECK(outliers.GetHistogram()[0] == 1);
+	CHECK(outliers.GetHistogram()[FrameStatistics::histogramBucketCount - 1] == 1);
+	CHECK(outliers.GetSummary().sampleCount == 2);
+
+	FrameStatistics nonFinite;
+	for (int i = 0; i < 10; i++)
+		nonFinite.AddFrame(0.016f);
+	nonFinite.AddFrame(std::numeric_limits<float>::quiet_NaN());
+	nonFinite.AddFrame(std::numeric_limits<float>::infinity());
+	FrameTimeSummary nonFiniteSummary = nonFinite.GetSummary();
+	CHECK(nonFiniteSummary.sampleCount == 10);
+	CHECK(std::abs(nonFiniteSummary.maxMilliseconds - 16.0f) < 1.0e-3f);
+	CHECK(std::abs(nonFinite.GetSmoothedFps() - 62.5f) < 0.1f);
+	CHECK(nonFinite.GetHitchCount() == 0 && !nonFinite.IsLastFrameHitch());
+	nonFinite.AddFrame(0.016f);
+	CHECK(nonFinite.GetSummary().sampleCount == 11 && std::isfinite(nonFinite.GetSmoothedFps()));
+
+	auto timerStart = std::chrono::steady_clock::now();
+	Timer timer;
+	timer.Reset();
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	timer.Tick();
+	CHECK(timer.DeltaTime() >= 0.019f && timer.TotalTime() >= 0.019f);
+
+	// The paused time doesn't count, the total stays below the wall time minus the pause however long the
+	// sleeps really took.
+	timer.Stop();
+	auto pauseStart = std::chrono::steady_clock::now();
+	std::this_thread::sleep_for(std::chrono::milliseconds(30));
+	double pauseMilliseconds = MillisecondsSince(pauseStart);
+	timer.Start();
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	timer.Tick();
+	double wallMilliseconds = MillisecondsSince(timerStart);
+	CHECK(timer.TotalTime() >= 0.029f);
+	CHECK(timer.TotalTime() * 1000.0 < wallMilliseconds - 0.5 * pauseMilliseconds);
+
+	std::printf("OK\n");
+	return 0;
+}
\ No newline at end of file
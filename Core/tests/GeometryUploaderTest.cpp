@@ -0,0 +1,160 @@
+#include "../includes/GeometryUploader.h"
+#include "TestUtility.h"
+
+namespace
+{
+	// Destinations are byte vectors. The "GPU" copies a batch only once the fence reaches it and makes random
+	// progress in between, so staging memory that is reused too early shows up as wrong data.
+	class FakeCopyQueue : public GeometryCopyQueue
+	{
+	public:
+		FakeCopyQueue(uint64_t stagingSize, std::mt19937& random)
+			: mStaging(stagingSize), mRandom(random)
+		{
+		}
+
+		uint64_t GetStagingSize() override
+		{
+			return mStaging.size();
+		}
+		uint8_t* GetStagingData() override
+		{
+			return mStaging.data();
+		}
+
+		void RecordCopies(const GeometryCopy* copies, uint32_t count) override
+		{
+			mRecording.insert(mRecording.end(), copies, copies + count);
+		}
+		uint64_t Submit() override
+		{
+			mSubmitted.emplace_back(++mFenceValue, std::move(mRecording));
+			mRecording.clear();
+			return mFenceValue;
+		}
+		uint64_t GetCompletedFenceValue() override
+		{
+			if (!mSubmitted.empty() && mRandom() % 3 == 0)
+				Execute(mSubmitted.front().first);
+			return mCompletedFenceValue;
+		}
+		void WaitForFenceValue(uint64_t fenceValue) override
+		{
+			CHECK(fenceValue <= mFenceValue);
+			Execute(fenceValue);
+		}
+
+		bool IsIdle()
+		{
+			return mSubmitted.empty();
+		}
+	private:
+		void Execute(uint64_t fenceValue)
+		{
+			while (!mSubmitted.empty() && mSubmitted.front().first <= fenceValue)
+			{
+				for (const GeometryCopy& copy : mSubmitted.front().second)
+				{
+					auto destination = static_cast<std::vector<uint8_t>*>(copy.destination);
+					CHECK(copy.destinationOffset + copy.byteSize <= destination->size());
+					CHECK(copy.stagingOffset + copy.byteSize <= mStaging.size());
+					std::memcpy(destination->data() + copy.destinationOffset, mStaging.data() + copy.stagingOffset, copy.byteSize);
+				}
+				mCompletedFenceValue = mSubmitted.front().first;
+				mSubmitted.pop_front();
+			}
+		}
+	private:
+		std::vector<uint8_t> mStaging;
+		std::mt19937& mRandom;
+
+		std::vector<GeometryCopy> mRecording;
+		std::deque<std::pair<uint64_t, std::vector<GeometryCopy>>> mSubmitted;
+		uint64_t mFenceValue = 0;
+		uint64_t mCompletedFenceValue = 0;
+	};
+}
+
+int main()
+{
+	std::mt19937 random(7);
+
+	// Uploads smaller and bigger than the staging ring, split in two like vertices and indices of one mesh,
+	// with flushes and retires in between.
+	const uint64_t stagingSizes[] = { 256, 4096, 1 << 20 };
+	for (uint64_t stagingSize : stagingSizes)
+	{
+		// Fewer rounds for the big ring, its big uploads are megabytes each.
+		int roundCount = stagingSize < (1 << 20) ? 20 : 2;
+		for (int round = 0; round < roundCount; round++)
+		{
+			FakeCopyQueue copyQueue(stagingSize, random);
+			GeometryUploader uploader(copyQueue);
+
+			std::vector<std::vector<uint8_t>> sources(200);
+			std::vector<std::vector<uint8_t>> destinations(200);
+			for (size_t i = 0; i < sources.size(); i++)
+			{
+				size_t byteSize = random() % 8 == 0 ? random() % (stagingSize * 3) + 1 : random() % 300 + 1;
+				sources[i].resize(byteSize);
+				for (auto& byte : sources[i])
+					byte = static_cast<uint8_t>(random());
+				destinations[i].assign(byteSize, 0);
+			}
+
+			for (size_t i = 0; i < sources.size(); i++)
+			{
+				size_t half = sources[i].size() / 2;
+				if (random() % 2)
+				{
+					uploader.Upload(&destinations[i], 0, sources[i].data(), half);
+					uploader.Upload(&destinations[i], half, sources[i].data() + half, sources[i].size() - half);
+				}
+				else
+				{
+					uploader.Upload(&destinations[i], 0, sources[i].data(), sources[i].size());
+				}
+
+				if (random() % 10 == 0)
+					uploader.Flush();
+				if (random() % 7 == 0)
+					uploader.Retire();
+				CHECK(uploader.GetStatistics().stagingBytesInUse <= stagingSize);
+			}
+			uploader.WaitIdle();
+
+			for (size_t i = 0; i < sources.size(); i++)
+				CHECK(sources[i] == destinations[i]);
+			GeometryUploaderStatistics statistics = uploader.GetStatistics();
+			CHECK(statistics.stagingBytesInUse == 0 && copyQueue.IsIdle());
+			if (round == 0)
+			{
+				std::printf("staging %llu bytes: %llu bytes uploaded, %u copies, %u batches, %u stalls, peak %llu bytes\n",
+					static_cast<unsigned long long>(stagingSize), static_cast<unsigned long long>(statistics.uploadedBytes),
+					statistics.copyCount, statistics.batchCount, statistics.stallCount, static_cast<unsigned long long>(statistics.peakStagingBytes));
+			}
+		}
+	}
+
+	// Many small meshes fit in one batch, and the two halves of a mesh merge into one copy.
+	{
+		FakeCopyQueue copyQueue(1 << 20, random);
+		GeometryUploader uploader(copyQueue);
+		std::vector<std::vector<uint8_t>> destinations(100, std::vector<uint8_t>(1000));
+		std::vector<uint8_t> source(1000, 3);
+		for (auto& destination : destinations)
+		{
+			uploader.Upload(&destination, 0, source.data(), 512);
+			uploader.Upload(&destination, 512, source.data() + 512, 488);
+		}
+		uploader.WaitIdle();
+
+		GeometryUploaderStatistics statistics = uploader.GetStatistics();
+		CHECK(statistics.batchCount == 1 && statistics.copyCount == 100 && statistics.stallCount == 0);
+		for (const auto& destination : destinations)
+			CHECK(destination == source);
+	}
+
+	std::printf("OK\n");
+	return 0;
+}
\ No newline at end of file
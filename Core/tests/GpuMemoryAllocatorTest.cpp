@@ -0,0 +1,195 @@
+#include "../includes/GpuMemoryAllocator.h"
+#include "TestUtility.h"
+#include <algorithm>
+#include <map>
+
+namespace
+{
+	// Hands out dummy heaps and remembers their size and alignment. Throws on CreateHeap once failNextHeap is set,
+	// like D3D12HeapFactory when the device is out of memory.
+	class FakeHeapFactory : public GpuHeapFactory
+	{
+	public:
+		void* CreateHeap(GpuHeapType heapType, GpuResourceClass resourceClass, uint64_t byteSize, uint64_t alignment) override
+		{
+			if (failNextHeap)
+			{
+				failNextHeap = false;
+				throw std::runtime_error("Out of memory.");
+			}
+
+			void* heap = new char[1];
+			heaps[heap] = { heapType, byteSize, alignment };
+			return heap;
+		}
+		void DestroyHeap(void* heap) override
+		{
+			CHECK(heaps.erase(heap) == 1);
+			delete[] static_cast<char*>(heap);
+		}
+
+		struct FakeHeap
+		{
+			GpuHeapType heapType;
+			uint64_t byteSize;
+			uint64_t alignment;
+		};
+
+		std::map<void*, FakeHeap> heaps;
+		bool failNextHeap = false;
+	};
+
+	const uint64_t megabyte = 1024 * 1024;
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t operationCount = IsBenchmarkRun(argc, argv) ? 200000 : 30000;
+	std::mt19937 random(5);
+
+	FakeHeapFactory heapFactory;
+	{
+		GpuMemoryAllocator allocator(heapFactory);
+		CHECK(allocator.GetHeapSize(GpuHeapType::Default) == 64 * megabyte);
+		CHECK(allocator.GetHeapSize(GpuHeapType::Upload) < allocator.GetHeapSize(GpuHeapType::Default));
+		CHECK(allocator.GetHeapSize(GpuHeapType::Readback) < allocator.GetHeapSize(GpuHeapType::Upload));
+
+		// Random allocations across every pool, some of them big enough for a dedicated heap. Every allocation
+		// is aligned, inside its heap and in a heap of its own heap type and alignment.
+		const uint64_t alignments[] = { GpuMemoryAllocator::smallAlignment, GpuMemoryAllocator::defaultAlignment,
+			GpuMemoryAllocator::msaaAlignment };
+		std::vector<GpuAllocation> live;
+		for (uint32_t operation = 0; operation < operationCount; operation++)
+		{
+			if (live.empty() || random() % 100 < 52)
+			{
+				uint64_t alignment = alignments[random() % 3 == 0 ? 0 : (random() % 10 == 0 ? 2 : 1)];
+				uint64_t byteSize = random() % 50 == 0 ? 1 + random() % (80 * megabyte) : 1 + random() % megabyte;
+				GpuHeapType heapType = static_cast<GpuHeapType>(random() % 3);
+				GpuResourceClass resourceClass = static_cast<GpuResourceClass>(random() % 3);
+
+				GpuAllocation allocation = allocator.Allocate(heapType, resourceClass, byteSize, alignment);
+				CHECK(allocation.IsValid());
+				const FakeHeapFactory::FakeHeap& heap = heapFactory.heaps.at(allocation.heap);
+				CHECK(allocation.offset % alignment == 0 && allocation.byteSize >= byteSize);
+				CHECK(allocation.offset + allocation.byteSize <= heap.byteSize);
+				CHECK(heap.heapType == heapType && heap.alignment == alignment);
+				CHECK(allocation.isDedicated || heap.byteSize == std::max(allocator.GetHeapSize(heapType), alignment));
+				live.push_back(allocation);
+			}
+			else
+			{
+				size_t i = random() % live.size();
+				allocator.Free(live[i]);
+				live[i] = live.back();
+				live.pop_back();
+			}
+		}
+
+		std::map<void*, std::vector<std::pair<uint64_t, uint64_t>>> ranges;
+		for (const GpuAllocation& allocation : live)
+			ranges[allocation.heap].push_back({ allocation.offset, allocation.offset + allocation.byteSize });
+		for (auto& heapRanges : ranges)
+		{
+			std::sort(heapRanges.second.begin(), heapRanges.second.end());
+			for (size_t i = 1; i < heapRanges.second.size(); i++)
+				CHECK(heapRanges.second[i].first >= heapRanges.second[i - 1].second);
+		}
+
+		GpuMemoryStatistics statistics = allocator.GetStatistics();
+		for (int heapType = 0; heapType < static_cast<int>(GpuHeapType::Count); heapType++)
+		{
+			uint64_t heapBytes = 0;
+			uint32_t heapCount = 0;
+			for (const auto& heap : heapFactory.heaps)
+			{
+				if (heap.second.heapType == static_cast<GpuHeapType>(heapType))
+				{
+					heapBytes += heap.second.byteSize;
+					heapCount++;
+				}
+			}
+
+			const GpuHeapTypeStatistics& heapTypeStatistics = statistics.heapTypes[heapType];
+			CHECK(heapTypeStatistics.heapBytes == heapBytes && heapTypeStatistics.heapCount == heapCount);
+			std::printf("heap type %d: %u heaps, %u dedicated, %u allocations, %.1f MB heaps, %.1f MB allocated, "
+				"%.1f MB requested\n", heapType, heapTypeStatistics.heapCount, heapTypeStatistics.dedicatedHeapCount,
+				heapTypeStatistics.allocationCount, heapTypeStatistics.heapBytes / double(megabyte),
+				heapTypeStatistics.allocatedBytes / double(megabyte), heapTypeStatistics.requestedBytes / double(megabyte));
+		}
+
+		for (const GpuAllocation& allocation : live)
+			allocator.Free(allocation);
+		statistics = allocator.GetStatistics();
+		for (const GpuHeapTypeStatistics& heapTypeStatistics : statistics.heapTypes)
+		{
+			CHECK(heapTypeStatistics.allocationCount == 0 && heapTypeStatistics.allocatedBytes == 0);
+			CHECK(heapTypeStatistics.dedicatedHeapCount == 0);
+		}
+
+		// A budget of one more upload heap refuses exactly the allocation that needs a second one. The pool
+		// kept its last heap, so the allocations fill that one first.
+		const uint64_t uploadHeapSize = allocator.GetHeapSize(GpuHeapType::Upload);
+		const uint64_t uploadBudget = statistics.heapTypes[1].heapBytes + uploadHeapSize;
+		allocator.SetBudget(GpuHeapType::Upload, uploadBudget);
+		std::vector<GpuAllocation> budgetAllocations;
+		for (uint64_t i = 0; i <= 2 * uploadHeapSize / megabyte; i++)
+		{
+			GpuAllocation allocation = allocator.Allocate(GpuHeapType::Upload, GpuResourceClass::Buffer, megabyte,
+				GpuMemoryAllocator::defaultAlignment);
+			if (!allocation.IsValid())
+				break;
+			budgetAllocations.push_back(allocation);
+		}
+		statistics = allocator.GetStatistics();
+		CHECK(budgetAllocations.size() >= uploadHeapSize / megabyte);
+		CHECK(statistics.heapTypes[1].budgetFailureCount == 1 && statistics.heapTypes[1].heapBytes == uploadBudget);
+		for (const GpuAllocation& allocation : budgetAllocations)
+			allocator.Free(allocation);
+
+		// A heap the factory fails to create doesn't count, the next allocation gets a heap of the new size.
+		allocator.SetHeapSize(GpuHeapType::Readback, 2 * megabyte);
+		GpuHeapTypeStatistics readbackStatistics = allocator.GetStatistics().heapTypes[2];
+		heapFactory.failNextHeap = true;
+		bool threw = false;
+		try
+		{
+			allocator.Allocate(GpuHeapType::Readback, GpuResourceClass::Buffer, 64 * megabyte,
+				GpuMemoryAllocator::defaultAlignment);
+		}
+		catch (std::runtime_error&)
+		{
+			threw = true;
+		}
+		CHECK(threw);
+		GpuHeapTypeStatistics failedStatistics = allocator.GetStatistics().heapTypes[2];
+		CHECK(failedStatistics.heapBytes == readbackStatistics.heapBytes);
+		CHECK(failedStatistics.heapCount == readbackStatistics.heapCount);
+		CHECK(failedStatistics.dedicatedHeapCount == 0 && failedStatistics.allocationCount == 0);
+
+		std::vector<GpuAllocation> readbackAllocations;
+		for (int i = 0; i < 3; i++)
+		{
+			readbackAllocations.push_back(allocator.Allocate(GpuHeapType::Readback, GpuResourceClass::Buffer,
+				megabyte, GpuMemoryAllocator::defaultAlignment));
+		}
+		CHECK(heapFactory.heaps.at(readbackAllocations[2].heap).byteSize == 2 * megabyte);
+		for (const GpuAllocation& allocation : readbackAllocations)
+			allocator.Free(allocation);
+
+		threw = false;
+		try
+		{
+			allocator.Allocate(GpuHeapType::Default, GpuResourceClass::Buffer, 10, 512);
+		}
+		catch (std::runtime_error&)
+		{
+			threw = true;
+		}
+		CHECK(threw);
+	}
+	CHECK(heapFactory.heaps.empty());
+
+	std::printf("OK\n");
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,198 @@
+#include "../includes/Heightfield.h"
+#include "TestUtility.h"
+using namespace DirectX;
+
+namespace
+{
+	const float heightScale = 64.0f;
+	const float heightOffset = -16.0f;
+
+	struct Reference
+	{
+		int width;
+		int height;
+		std::vector<float> heights;
+
+		// Bilinear over a plain row-major float array, the map is centered on the origin.
+		float GetHeight(float x, float z) const
+		{
+			float fx = std::min(std::max(x + 0.5f * (width - 1), 0.0f), width - 1.0f);
+			float fz = std::min(std::max(z + 0.5f * (height - 1), 0.0f), height - 1.0f);
+			int cellX = std::min(static_cast<int>(fx), width - 2);
+			int cellZ = std::min(static_cast<int>(fz), height - 2);
+			float u = fx - cellX;
+			float v = fz - cellZ;
+
+			const float* row = &heights[cellZ * width + cellX];
+			float top = row[0] + (row[1] - row[0]) * u;
+			float bottom = row[width] + (row[width + 1] - row[width]) * u;
+			return top + (bottom - top) * v;
+		}
+	};
+}
+
+int main(int argc, char** argv)
+{
+	bool isBenchmarkRun = IsBenchmarkRun(argc, argv);
+	Reference reference;
+	reference.width = isBenchmarkRun ? 2624 : 1000;
+	reference.height = isBenchmarkRun ? 1756 : 700;
+	int width = reference.width;
+	int height = reference.height;
+
+	std::mt19937 random(1);
+	std::uniform_int_distribution<int> noise(-3, 3);
+	std::vector<unsigned char> heightValues(width * height);
+	reference.heights.resize(width * height);
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			float value = 128.0f + 90.0f * std::sin(x * 0.012f) * std::cos(y * 0.009f) + 25.0f * std::sin(x * 0.08f - y * 0.05f);
+			unsigned char heightValue = static_cast<unsigned char>(std::min(std::max(static_cast<int>(value) + noise(random), 0), 255));
+			heightValues[y * width + x] = heightValue;
+			reference.heights[y * width + x] = heightValue / 255.0f * heightScale + heightOffset;
+		}
+	}
+
+	JobSystem jobSystem(3);
+	Heightfield heightfield(jobSystem);
+	heightfield.Build(heightValues.data(), width, height, 1, heightScale, heightOffset);
+	HeightfieldStatistics statistics = heightfield.GetStatistics();
+	std::printf("build %.1f ms, %u tiles, %u levels, %.2f MB against %.2f MB as floats\n", statistics.buildMilliseconds,
+		statistics.tileCount, statistics.levelCount, statistics.memoryBytes / 1.0e6, width * height * 4 / 1.0e6);
+
+	// Samples and bilinear heights within half a 16 bit quantization step of the float map, also outside of it.
+	const float tolerance = heightScale / 65535.0f * 0.51f + 1.0e-4f;
+	std::uniform_real_distribution<float> pointX(-0.5f * width - 20.0f, 0.5f * width + 20.0f);
+	std::uniform_real_distribution<float> pointZ(-0.5f * height - 20.0f, 0.5f * height + 20.0f);
+	for (int i = 0; i < 100000; i++)
+	{
+		float x = pointX(random);
+		float z = pointZ(random);
+		CHECK(std::fabs(heightfield.GetHeight(x, z) - reference.GetHeight(x, z)) <= tolerance);
+	}
+	for (int y = 0; y < height; y += 7)
+	{
+		for (int x = 0; x < width; x += 5)
+			CHECK(std::fabs(heightfield.GetSample(x, y) - reference.heights[y * width + x]) <= tolerance);
+	}
+
+	// The SIMD batches match the single queries, the count isn't a multiple of 4.
+	std::vector<XMFLOAT2> points(10003);
+	for (auto& point : points)
+		point = XMFLOAT2(pointX(random), pointZ(random));
+	std::vector<float> heights(points.size());
+	std::vector<XMFLOAT3> normals(points.size());
+	heightfield.GetHeights(points.data(), static_cast<uint32_t>(points.size()), heights.data());
+	heightfield.GetNormals(points.data(), static_cast<uint32_t>(points.size()), normals.data());
+	for (size_t i = 0; i < points.size(); i++)
+	{
+		CHECK(std::fabs(heights[i] - heightfield.GetHeight(points[i].x, points[i].y)) < 1.0e-3f);
+		XMFLOAT3 normal = heightfield.GetNormal(points[i].x, points[i].y);
+		CHECK(std::fabs(normal.x - normals[i].x) + std::fabs(normal.y - normals[i].y) + std::fabs(normal.z - normals[i].z) < 1.0e-4f);
+	}
+
+	// Normals against central differences of the heights, at sample positions inside the map.
+	for (int i = 0; i < 10000; i++)
+	{
+		float x = std::trunc(pointX(random) * 0.9f);
+		float z = std::trunc(pointZ(random) * 0.9f);
+		const float delta = 1.0e-2f;
+		float slopeX = (heightfield.GetHeight(x + delta, z) - heightfield.GetHeight(x - delta, z)) / (2.0f * delta);
+		float slopeZ = (heightfield.GetHeight(x, z + delta) - heightfield.GetHeight(x, z - delta)) / (2.0f * delta);
+		XMFLOAT3 expected;
+		XMStoreFloat3(&expected, XMVector3Normalize(XMVectorSet(-slopeX, 1.0f, -slopeZ, 0.0f)));
+		XMFLOAT3 normal = heightfield.GetNormal(x, z);
+		CHECK(std::fabs(expected.x - normal.x) < 2.0e-3f && std::fabs(expected.y - normal.y) < 2.0e-3f && std::fabs(expected.z - normal.z) < 2.0e-3f);
+	}
+
+	// Rays against marching in small steps. A hit the march stepped over has to graze the surface.
+	const float maxDistance = 300.0f;
+	const float marchStep = 0.01f;
+	std::uniform_real_distribution<float> azimuth(0.0f, XM_2PI);
+	std::uniform_real_distribution<float> elevation(-1.2f, 0.3f);
+	std::uniform_real_distribution<float> originHeight(-10.0f, 80.0f);
+	uint32_t hitCount = 0;
+	uint32_t grazingCount = 0;
+	for (int i = 0; i < 300; i++)
+	{
+		XMFLOAT3 origin(pointX(random) * 0.9f, originHeight(random), pointZ(random) * 0.9f);
+		float a = azimuth(random);
+		float e = elevation(random);
+		XMFLOAT3 direction = i % 50 == 0 ? XMFLOAT3(0.0f, -1.0f, 0.0f) : XMFLOAT3(std::cos(a) * std::cos(e), std::sin(e), std::sin(a) * std::cos(e));
+
+		float distance;
+		bool isHit = heightfield.Intersects(origin, direction, maxDistance, distance);
+
+		float marchedDistance = -1.0f;
+		bool wasInside = false;
+		for (float s = 0.0f; s <= maxDistance; s += marchStep)
+		{
+			float x = origin.x + direction.x * s;
+			float z = origin.z + direction.z * s;
+			if (std::fabs(x) > 0.5f * (width - 1) || std::fabs(z) > 0.5f * (height - 1))
+			{
+				if (wasInside)
+					break;
+				continue;
+			}
+			wasInside = true;
+			if (origin.y + direction.y * s <= heightfield.GetHeight(x, z))
+			{
+				marchedDistance = s;
+				break;
+			}
+		}
+
+		if (marchedDistance >= 0.0f)
+		{
+			CHECK(isHit && std::fabs(distance - marchedDistance) <= marchStep * 1.1f);
+			hitCount++;
+		}
+		else if (isHit)
+		{
+			float y = origin.y + direction.y * distance;
+			CHECK(std::fabs(y - heightfield.GetHeight(origin.x + direction.x * distance, origin.z + direction.z * distance)) < 1.0e-2f);
+			grazingCount++;
+		}
+	}
+	std::printf("300 rays: %u hits match the march, %u grazing hits\n", hitCount, grazingCount);
+	CHECK(hitCount > 0);
+
+	// Throughput against the float array.
+	const uint32_t queryCount = isBenchmarkRun ? 4000000 : 100000;
+	std::vector<XMFLOAT2> queries(queryCount);
+	std::uniform_real_distribution<float> insideX(-0.5f * width, 0.5f * width);
+	std::uniform_real_distribution<float> insideZ(-0.5f * height, 0.5f * height);
+	for (auto& query : queries)
+		query = XMFLOAT2(insideX(random), insideZ(random));
+	heights.resize(queryCount);
+
+	volatile float sink = 0.0f;
+	auto benchmark = [&](const char* name, const std::function<void()>& function)
+	{
+		auto start = std::chrono::steady_clock::now();
+		function();
+		std::printf("%s: %.1f M queries/s\n", name, queryCount / MillisecondsSince(start) / 1.0e3);
+	};
+	benchmark("GetHeight", [&]()
+		{
+			float sum = 0.0f;
+			for (const auto& query : queries)
+				sum += heightfield.GetHeight(query.x, query.y);
+			sink = sum;
+		});
+	benchmark("float array", [&]()
+		{
+			float sum = 0.0f;
+			for (const auto& query : queries)
+				sum += reference.GetHeight(query.x, query.y);
+			sink = sum;
+		});
+	benchmark("GetHeights", [&]() { heightfield.GetHeights(queries.data(), queryCount, heights.data()); });
+	(void)sink;
+
+	std::printf("OK\n");
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,237 @@
+#include "../includes/ImageFilter.h"
+#include "TestUtility.h"
+using namespace DirectX;
+
+namespace
+{
+	// Row-major RGBA floats, one plain array per image, filtered one channel at a time.
+	struct Reference
+	{
+		int width;
+		int height;
+		std::vector<float> pixels;
+
+		float& At(int x, int y, int channel) { return pixels[(static_cast<size_t>(y) * width + x) * 4 + channel]; }
+		float AtClamped(int x, int y, int channel)
+		{
+			return At(std::min(std::max(x, 0), width - 1), std::min(std::max(y, 0), height - 1), channel);
+		}
+		float AtOrZero(int x, int y, int channel)
+		{
+			return (x >= 0 && x < width && y >= 0 && y < height) ? At(x, y, channel) : 0.0f;
+		}
+	};
+
+	Reference MakeReference(const Image& image)
+	{
+		Reference reference = { static_cast<int>(image.GetWidth()), static_cast<int>(image.GetHeight()), {} };
+		for (uint32_t y = 0; y < image.GetHeight(); y++)
+		{
+			for (uint32_t x = 0; x < image.GetWidth(); x++)
+			{
+				const XMFLOAT4A& pixel = image.GetRow(y)[x];
+				reference.pixels.insert(reference.pixels.end(), { pixel.x, pixel.y, pixel.z, pixel.w });
+			}
+		}
+		return reference;
+	}
+
+	void FillNoise(Image& image, uint32_t seed)
+	{
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<float> value(0.0f, 1.0f);
+		for (uint32_t y = 0; y < image.GetHeight(); y++)
+		{
+			for (uint32_t x = 0; x < image.GetWidth(); x++)
+				image.GetRow(y)[x] = XMFLOAT4A(value(random), value(random), value(random), value(random));
+		}
+	}
+
+	// The full 2D sum of every tap, clamped to the border, instead of the filter's two 1D passes.
+	Reference ReferenceBlur(Reference source, float sigma, int blurCount)
+	{
+		std::vector<float> weights = GaussWeightCache::CalculateWeights(sigma);
+		int blurRadius = static_cast<int>(weights.size()) / 2;
+
+		for (int pass = 0; pass < blurCount; pass++)
+		{
+			Reference destination = source;
+			for (int y = 0; y < source.height; y++)
+			{
+				for (int x = 0; x < source.width; x++)
+				{
+					for (int channel = 0; channel < 4; channel++)
+					{
+						double sum = 0.0;
+						for (int i = -blurRadius; i <= blurRadius; i++)
+						{
+							for (int j = -blurRadius; j <= blurRadius; j++)
+							{
+								sum += static_cast<double>(weights[i + blurRadius]) * weights[j + blurRadius] *
+									source.AtClamped(x + j, y + i, channel);
+							}
+						}
+						destination.At(x, y, channel) = static_cast<float>(sum);
+					}
+				}
+			}
+			source = destination;
+		}
+		return source;
+	}
+
+	Reference ReferenceSobel(Reference source)
+	{
+		Reference destination = source;
+		for (int y = 0; y < source.height; y++)
+		{
+			for (int x = 0; x < source.width; x++)
+			{
+				double luminance = 0.0;
+				const double luminanceWeights[] = { 0.299, 0.587, 0.114 };
+				for (int channel = 0; channel < 3; channel++)
+				{
+					double gx = source.AtOrZero(x + 1, y - 1, channel) + 2.0 * source.AtOrZero(x + 1, y, channel) +
+						source.AtOrZero(x + 1, y + 1, channel) - source.AtOrZero(x - 1, y - 1, channel) -
+						2.0 * source.AtOrZero(x - 1, y, channel) - source.AtOrZero(x - 1, y + 1, channel);
+					double gy = source.AtOrZero(x - 1, y - 1, channel) + 2.0 * source.AtOrZero(x, y - 1, channel) +
+						source.AtOrZero(x + 1, y - 1, channel) - source.AtOrZero(x - 1, y + 1, channel) -
+						2.0 * source.AtOrZero(x, y + 1, channel) - source.AtOrZero(x + 1, y + 1, channel);
+					luminance += luminanceWeights[channel] * std::sqrt(gx * gx + gy * gy);
+				}
+				float edge = 1.0f - static_cast<float>(std::min(std::max(luminance, 0.0), 1.0));
+				for (int channel = 0; channel < 4; channel++)
+					destination.At(x, y, channel) = edge;
+			}
+		}
+		return destination;
+	}
+
+	float MaxDifference(const Image& image, Reference& reference)
+	{
+		CHECK(static_cast<int>(image.GetWidth()) == reference.width);
+		CHECK(static_cast<int>(image.GetHeight()) == reference.height);
+
+		float maxDifference = 0.0f;
+		for (int y = 0; y < reference.height; y++)
+		{
+			for (int x = 0; x < reference.width; x++)
+			{
+				const XMFLOAT4A& pixel = image.GetRow(y)[x];
+				const float channels[] = { pixel.x, pixel.y, pixel.z, pixel.w };
+				for (int channel = 0; channel < 4; channel++)
+					maxDifference = std::max(maxDifference, std::fabs(channels[channel] - reference.At(x, y, channel)));
+			}
+		}
+		return maxDifference;
+	}
+
+	void RunBenchmark()
+	{
+		// The naive 2D reference at one size for scale, then the filters at the sizes of the log.
+		Image input(1280, 720);
+		FillNoise(input, 5);
+		Reference reference = MakeReference(input);
+		auto start = std::chrono::steady_clock::now();
+		ReferenceBlur(reference, 2.5f, 1);
+		double referenceMilliseconds = MillisecondsSince(start);
+		std::printf("reference blur 1280x720 sigma 2.5: %.1f MP/s\n",
+			1280.0 * 720.0 / 1.0e6 / (referenceMilliseconds / 1000.0));
+
+		auto results = FilterBenchmark::Run({ { 1280, 720 }, { 1920, 1080 }, { 3840, 2160 } }, { 1.0f, 2.5f, 5.0f }, 5);
+		for (const auto& result : results)
+		{
+			std::printf("%ux%u sigma %.1f (radius %d): blur %.1f MP/s, sobel %.1f MP/s\n",
+				result.width, result.height, result.sigma, result.blurRadius,
+				result.blurMegapixelsPerSecond, result.sobelMegapixelsPerSecond);
+			CHECK(result.blurMegapixelsPerSecond > 0.0 && result.sobelMegapixelsPerSecond > 0.0);
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	// The weights are normalized and symmetric, and cached per sigma.
+	for (float sigma : { 0.5f, 1.5f, 4.0f })
+	{
+		const std::vector<float>& weights = GaussWeightCache::GetWeights(sigma);
+		CHECK(weights.size() == 2 * static_cast<size_t>(std::ceil(2.0f * sigma)) + 1);
+		CHECK(&weights == &GaussWeightCache::GetWeights(sigma));
+		float sum = 0.0f;
+		for (size_t i = 0; i < weights.size(); i++)
+		{
+			sum += weights[i];
+			CHECK(weights[i] == weights[weights.size() - 1 - i]);
+		}
+		CHECK(std::fabs(sum - 1.0f) < 1.0e-6f);
+	}
+
+	// Odd sizes, images narrower than the blur radius so both borders clamp, one and several worker threads.
+	const std::pair<uint32_t, uint32_t> sizes[] = { { 1, 1 }, { 7, 3 }, { 3, 17 }, { 37, 29 }, { 130, 9 } };
+	for (uint32_t workerCount : { 1u, 3u })
+	{
+		JobSystem jobSystem(workerCount);
+		CpuBlurFilter blurFilter(jobSystem);
+		CpuSobelFilter sobelFilter(jobSystem);
+
+		for (const auto& size : sizes)
+		{
+			Image input(size.first, size.second);
+			FillNoise(input, size.first * 131 + size.second);
+			Reference reference = MakeReference(input);
+
+			for (float sigma : { 0.5f, 1.5f, 4.0f })
+			{
+				for (int blurCount : { 1, 2 })
+				{
+					Image blurred;
+					blurFilter.Execute(input, blurred, sigma, blurCount);
+					Reference expected = ReferenceBlur(reference, sigma, blurCount);
+					CHECK(MaxDifference(blurred, expected) < 1.0e-5f);
+				}
+			}
+
+			Image edges;
+			sobelFilter.Execute(input, edges);
+			Reference expected = ReferenceSobel(reference);
+			CHECK(MaxDifference(edges, expected) < 1.0e-5f);
+			CHECK(sobelFilter.GetStatistics().milliseconds >= 0.0);
+		}
+	}
+
+	// A constant image blurs to itself, the clamped border adds nothing new.
+	Image constant(23, 11);
+	for (uint32_t y = 0; y < constant.GetHeight(); y++)
+	{
+		for (uint32_t x = 0; x < constant.GetWidth(); x++)
+			constant.GetRow(y)[x] = XMFLOAT4A(0.25f, 0.5f, 0.75f, 1.0f);
+	}
+	CpuBlurFilter blurFilter;
+	Image blurred;
+	blurFilter.Execute(constant, blurred, 3.0f, 3);
+	Reference constantReference = MakeReference(constant);
+	CHECK(MaxDifference(blurred, constantReference) < 1.0e-5f);
+
+	// 8-bit data through a padded row pitch comes back unchanged.
+	const uint32_t width = 5;
+	const uint32_t height = 3;
+	const uint32_t rowPitch = 32;
+	std::vector<uint8_t> pixels(rowPitch * height, 0xCD);
+	for (uint32_t y = 0; y < height; y++)
+	{
+		for (uint32_t i = 0; i < width * 4; i++)
+			pixels[y * rowPitch + i] = static_cast<uint8_t>(y * 53 + i * 11);
+	}
+	Image loaded;
+	loaded.LoadRGBA8(pixels.data(), width, height, rowPitch);
+	CHECK(loaded.GetWidth() == width && loaded.GetHeight() == height);
+	std::vector<uint8_t> stored(rowPitch * height, 0xCD);
+	loaded.StoreRGBA8(stored.data(), rowPitch);
+	CHECK(stored == pixels);
+
+	if (IsBenchmarkRun(argc, argv))
+		RunBenchmark();
+
+	std::printf("OK\n");
+	return 0;
+}
\ No newline at end of file
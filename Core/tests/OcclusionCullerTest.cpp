@@ -0,0 +1,105 @@
+#include "../includes/OcclusionCuller.h"
+#include "../includes/BasicGeometryGenerator.h"
+#include "TestUtility.h"
+using namespace DirectX;
+
+namespace
+{
+	const float quadSize = 20.0f;
+
+	// Exact answer for a single quad occluder: the box is entirely behind the quad's plane
+	// and every ray from the eye to a corner goes through the quad.
+	bool IsBehindQuad(const BoundingBox& box, FXMMATRIX inverseWorld, FXMVECTOR eye)
+	{
+		XMVECTOR localEye = XMVector3TransformCoord(eye, inverseWorld);
+		float eyeY = XMVectorGetY(localEye);
+		for (uint32_t corner = 0; corner < 8; corner++)
+		{
+			XMVECTOR sign = XMVectorSet((corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f, (corner & 4) ? 1.0f : -1.0f, 0.0f);
+			XMVECTOR point = XMVector3TransformCoord(
+				XMVectorMultiplyAdd(sign, XMLoadFloat3(&box.Extents), XMLoadFloat3(&box.Center)), inverseWorld);
+			float pointY = XMVectorGetY(point);
+			if (pointY * eyeY >= 0.0f)
+				return false;
+
+			XMVECTOR hit = XMVectorLerp(localEye, point, eyeY / (eyeY - pointY));
+			if (std::fabs(XMVectorGetX(hit)) > 0.5f * quadSize || std::fabs(XMVectorGetZ(hit)) > 0.5f * quadSize)
+				return false;
+		}
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t boxCount = IsBenchmarkRun(argc, argv) ? 1000000 : 20000;
+
+	JobSystem jobSystem(3);
+	OcclusionCuller culler(256, 128, jobSystem);
+	BasicGeometryGenerator geometryGenerator;
+	MeshData quad = geometryGenerator.CreateGrid(quadSize, quadSize, 2, 2);
+
+	XMVECTOR eye = XMVectorSet(0.0f, 0.0f, -30.0f, 1.0f);
+	XMMATRIX view = XMMatrixLookAtLH(eye, XMVectorZero(), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	XMMATRIX proj = XMMatrixPerspectiveFovLH(0.25f * XM_PI, 2.0f, 1.0f, 1000.0f);
+	XMFLOAT4X4 viewProj;
+	XMStoreFloat4x4(&viewProj, XMMatrixMultiply(view, proj));
+	BoundingFrustum frustum;
+	BoundingFrustum::CreateFromMatrix(frustum, proj);
+	frustum.Transform(frustum, XMMatrixInverse(nullptr, view));
+
+	// Small boxes around the quad's silhouette, where a texel is only partially covered.
+	std::mt19937 random(5);
+	std::uniform_real_distribution<float> positionX(-20.0f, 20.0f);
+	std::uniform_real_distribution<float> positionY(-12.0f, 12.0f);
+	std::uniform_real_distribution<float> positionZ(-5.0f, 40.0f);
+	std::uniform_real_distribution<float> extent(0.02f, 1.5f);
+	std::vector<BoundingBox> boxes;
+	std::vector<uint8_t> visible(boxCount);
+
+	// The quad facing the camera, then tilted so its edges and depth are slanted.
+	const float angles[][2] = { { 0.0f, 0.0f }, { 0.3f, 0.0f }, { 0.0f, 0.7f }, { 0.5f, -0.4f }, { -1.0f, 0.9f }, { 1.2f, 0.2f } };
+	for (const auto& angle : angles)
+	{
+		XMMATRIX world = XMMatrixRotationX(-0.5f * XM_PI + angle[0]) * XMMatrixRotationY(angle[1]);
+		XMMATRIX inverseWorld = XMMatrixInverse(nullptr, world);
+		XMFLOAT4X4 quadWorld;
+		XMStoreFloat4x4(&quadWorld, world);
+
+		culler.ClearOccluders();
+		culler.AddOccluder(quad, quadWorld);
+		culler.RenderOccluders(viewProj);
+
+		// Boxes outside the screen are culled too, only the ones in view count.
+		boxes.clear();
+		while (boxes.size() < boxCount)
+		{
+			BoundingBox box(XMFLOAT3(positionX(random), positionY(random), positionZ(random)), XMFLOAT3(extent(random), extent(random), extent(random)));
+			if (frustum.Contains(box) != DISJOINT)
+				boxes.push_back(box);
+		}
+		uint32_t visibleCount = culler.TestVisibility(boxes.data(), boxCount, visible.data());
+
+		uint32_t occludedCount = 0;
+		uint32_t falseCullCount = 0;
+		for (uint32_t i = 0; i < boxCount; i++)
+		{
+			bool occluded = IsBehindQuad(boxes[i], inverseWorld, eye);
+			occludedCount += occluded ? 1 : 0;
+			falseCullCount += !occluded && !visible[i] ? 1 : 0;
+		}
+
+		OcclusionCullerStatistics statistics = culler.GetStatistics();
+		std::printf("angles %.1f %.1f: %u of %u occluded boxes culled, %u false culls, raster %.3f ms, test %.3f ms\n",
+			angle[0], angle[1], boxCount - visibleCount, occludedCount, falseCullCount, statistics.rasterMilliseconds, statistics.testMilliseconds);
+		CHECK(falseCullCount == 0);
+		CHECK(boxCount - visibleCount >= occludedCount / 2);
+	}
+
+	// Crossing the near plane is always visible, outside the screen never is.
+	CHECK(culler.IsVisible(BoundingBox(XMFLOAT3(0.0f, 0.0f, -30.0f), XMFLOAT3(1.0f, 1.0f, 1.0f))));
+	CHECK(!culler.IsVisible(BoundingBox(XMFLOAT3(500.0f, 0.0f, 10.0f), XMFLOAT3(1.0f, 1.0f, 1.0f))));
+
+	std::printf("OK\n");
+	return 0;
+}
\ No newline at end of file
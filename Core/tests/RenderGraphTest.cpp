@@ -0,0 +1,200 @@
+#include "../includes/RenderGraph.h"
+#include "TestUtility.h"
+
+namespace
+{
+	typedef RenderGraphState State;
+
+	// Keeps every batch the graph submits.
+	class RecordingBackend : public RenderGraphBackend
+	{
+	public:
+		void RecordBarriers(const RenderGraphBarrier* barriers, uint32_t count) override
+		{
+			batches.emplace_back(barriers, barriers + count);
+		}
+
+		std::vector<std::vector<RenderGraphBarrier>> batches;
+	};
+
+	// "T name before->after" for transitions, "A" for aliasing and "U" for UAV barriers, separated by spaces.
+	std::string DescribeBarriers(RenderGraph& graph, const RenderGraphBarrier* barriers, uint32_t count)
+	{
+		const char types[] = { 'T', 'A', 'U' };
+
+		std::string description;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (i > 0)
+				description += " ";
+			description += types[static_cast<int>(barriers[i].type)];
+			description += std::string(" ") + graph.GetResourceName(barriers[i].resource) + " " +
+				std::to_string(static_cast<uint32_t>(barriers[i].before)) + "->" +
+				std::to_string(static_cast<uint32_t>(barriers[i].after));
+		}
+		return description;
+	}
+	std::string DescribePassBarriers(RenderGraph& graph, uint32_t pass)
+	{
+		uint32_t count = 0;
+		const RenderGraphBarrier* barriers = graph.GetPassBarriers(pass, count);
+		return DescribeBarriers(graph, barriers, count);
+	}
+}
+
+int main()
+{
+	// The compute sample's frame: scene, a copy into blur map 0, four blur pairs ping-ponging between the
+	// blur maps, sobel into its own map, a copy of the back buffer and the composite. One extra pass writes
+	// a transient nothing reads and has to be culled.
+	RenderGraph graph;
+	std::vector<std::string> executed;
+	auto addPass = [&graph, &executed](const char* name)
+	{
+		return graph.AddPass(name, [&executed, name]() { executed.push_back(name); });
+	};
+
+	const uint64_t mapSize = 1024 * 1024;
+	uint32_t backBuffer = graph.ImportResource("backBuffer", State::Common, State::Common);
+	uint32_t renderTexture = graph.ImportResource("renderTexture", State::Common, State::Common);
+	uint32_t blurMap0 = graph.CreateTransient("blurMap0", mapSize, 65536);
+	uint32_t blurMap1 = graph.CreateTransient("blurMap1", mapSize, 65536);
+	uint32_t sobelMap = graph.CreateTransient("sobelMap", mapSize, 65536);
+	uint32_t unusedMap = graph.CreateTransient("unusedMap", mapSize, 65536);
+
+	uint32_t scenePass = addPass("scene");
+	graph.Write(scenePass, backBuffer, State::RenderTarget);
+	uint32_t copyPass = addPass("copy");
+	graph.Read(copyPass, backBuffer, State::CopySource);
+	graph.Write(copyPass, blurMap0, State::CopyDest);
+	std::vector<uint32_t> blurPasses;
+	for (int i = 0; i < 4; i++)
+	{
+		uint32_t horizontalPass = addPass("horizontalBlur");
+		graph.Read(horizontalPass, blurMap0, State::ShaderResource);
+		graph.Write(horizontalPass, blurMap1, State::UnorderedAccess);
+		uint32_t verticalPass = addPass("verticalBlur");
+		graph.Read(verticalPass, blurMap1, State::ShaderResource);
+		graph.Write(verticalPass, blurMap0, State::UnorderedAccess);
+		blurPasses.push_back(horizontalPass);
+		blurPasses.push_back(verticalPass);
+	}
+	uint32_t unusedPass = addPass("unused");
+	graph.Read(unusedPass, blurMap0, State::ShaderResource);
+	graph.Write(unusedPass, unusedMap, State::UnorderedAccess);
+	uint32_t sobelPass = addPass("sobel");
+	graph.Read(sobelPass, blurMap0, State::ShaderResource);
+	graph.Write(sobelPass, sobelMap, State::UnorderedAccess);
+	uint32_t copyBackPass = addPass("copyBack");
+	graph.Read(copyBackPass, backBuffer, State::CopySource);
+	graph.Write(copyBackPass, renderTexture, State::CopyDest);
+	uint32_t compositePass = addPass("composite");
+	graph.Read(compositePass, renderTexture, State::ShaderResource);
+	graph.Read(compositePass, sobelMap, State::ShaderResource);
+	graph.Write(compositePass, backBuffer, State::RenderTarget);
+
+	graph.Compile();
+	RenderGraphStatistics statistics = graph.GetStatistics();
+	std::printf("%u passes, %u culled, %u barriers in %u batches, %u transients, %llu bytes aliased into %llu\n",
+		statistics.passCount, statistics.culledPassCount, statistics.barrierCount, statistics.barrierBatchCount,
+		statistics.transientCount, static_cast<unsigned long long>(statistics.transientBytes),
+		static_cast<unsigned long long>(statistics.heapBytes));
+
+	CHECK(graph.IsPassCulled(unusedPass) && !graph.IsResourceUsed(unusedMap));
+	CHECK(statistics.culledPassCount == 1 && statistics.transientCount == 3);
+	// The sobel map starts after the last blur pass read blur map 1, so it takes over blur map 1's memory.
+	CHECK(graph.GetHeapOffset(sobelMap) == graph.GetHeapOffset(blurMap1));
+	CHECK(graph.GetHeapOffset(blurMap0) != graph.GetHeapOffset(blurMap1));
+	CHECK(statistics.heapBytes == 2 * mapSize && statistics.savedBytes == mapSize);
+	CHECK(graph.GetInitialState(blurMap0) == State::ShaderResource);
+
+	// Render target 1, copy source 32, copy dest 64, shader resource 8, unordered access 16.
+	CHECK(DescribePassBarriers(graph, scenePass) == "T backBuffer 0->1");
+	CHECK(DescribePassBarriers(graph, copyPass) == "T backBuffer 1->32 T blurMap0 8->64");
+	CHECK(DescribePassBarriers(graph, blurPasses[0]) == "A blurMap1 0->16 T blurMap0 64->8 T blurMap1 8->16");
+	CHECK(DescribePassBarriers(graph, blurPasses[1]) == "T blurMap0 8->16 T blurMap1 16->8");
+	for (size_t i = 2; i < blurPasses.size(); i += 2)
+	{
+		CHECK(DescribePassBarriers(graph, blurPasses[i]) == "T blurMap0 16->8 T blurMap1 8->16");
+		CHECK(DescribePassBarriers(graph, blurPasses[i + 1]) == "T blurMap0 8->16 T blurMap1 16->8");
+	}
+	CHECK(DescribePassBarriers(graph, unusedPass).empty());
+	CHECK(DescribePassBarriers(graph, sobelPass) == "A sobelMap 0->16 T blurMap0 16->8 T sobelMap 8->16");
+	CHECK(DescribePassBarriers(graph, copyBackPass) == "T renderTexture 0->64");
+	CHECK(DescribePassBarriers(graph, compositePass) ==
+		"T backBuffer 32->1 T renderTexture 64->8 T sobelMap 16->8");
+	uint32_t finalCount = 0;
+	const RenderGraphBarrier* finalBarriers = graph.GetFinalBarriers(finalCount);
+	CHECK(DescribeBarriers(graph, finalBarriers, finalCount) == "T backBuffer 1->0 T renderTexture 8->0");
+
+	RecordingBackend backend;
+	graph.Execute(backend);
+	CHECK(executed.size() == 13 && executed.front() == "scene" && executed.back() == "composite");
+	CHECK(backend.batches.size() == statistics.barrierBatchCount);
+	uint32_t recordedCount = 0;
+	for (const auto& batch : backend.batches)
+	{
+		CHECK(!batch.empty());
+		recordedCount += static_cast<uint32_t>(batch.size());
+	}
+	CHECK(recordedCount == statistics.barrierCount);
+
+	// Consecutive reads in different states share one transition into the combined state.
+	RenderGraph readGraph;
+	uint32_t output = readGraph.ImportResource("output", State::Common, State::Common);
+	uint32_t texture = readGraph.CreateTransient("texture", 256, 256);
+	uint32_t writePass = readGraph.AddPass("write", []() {});
+	readGraph.Write(writePass, texture, State::RenderTarget);
+	uint32_t samplePass = readGraph.AddPass("sample", []() {});
+	readGraph.Read(samplePass, texture, State::ShaderResource);
+	readGraph.Write(samplePass, output, State::CopyDest);
+	uint32_t copySourcePass = readGraph.AddPass("copySource", []() {});
+	readGraph.Read(copySourcePass, texture, State::CopySource);
+	readGraph.Write(copySourcePass, output, State::CopyDest);
+	readGraph.Compile();
+	CHECK(DescribePassBarriers(readGraph, samplePass) == "T output 0->64 T texture 1->40");
+	CHECK(DescribePassBarriers(readGraph, copySourcePass).empty());
+
+	// Passes using the same UAV get a UAV barrier and no transition when one of the two writes it, reads after
+	// reads don't wait for each other.
+	RenderGraph uavGraph;
+	uint32_t buffer = uavGraph.ImportResource("buffer", State::UnorderedAccess, State::UnorderedAccess);
+	uint32_t firstPass = uavGraph.AddPass("first", []() {});
+	uavGraph.Write(firstPass, buffer, State::UnorderedAccess);
+	uint32_t secondPass = uavGraph.AddPass("second", []() {});
+	uavGraph.Write(secondPass, buffer, State::UnorderedAccess);
+	uint32_t firstReadPass = uavGraph.AddPass("firstRead", []() {});
+	uavGraph.Read(firstReadPass, buffer, State::UnorderedAccess);
+	uavGraph.SetSideEffects(firstReadPass);
+	uint32_t secondReadPass = uavGraph.AddPass("secondRead", []() {});
+	uavGraph.Read(secondReadPass, buffer, State::UnorderedAccess);
+	uavGraph.SetSideEffects(secondReadPass);
+	uint32_t lastPass = uavGraph.AddPass("last", []() {});
+	uavGraph.Write(lastPass, buffer, State::UnorderedAccess);
+	uavGraph.Compile();
+	CHECK(DescribePassBarriers(uavGraph, firstPass).empty());
+	CHECK(DescribePassBarriers(uavGraph, secondPass) == "U buffer 16->16");
+	CHECK(DescribePassBarriers(uavGraph, firstReadPass) == "U buffer 16->16");
+	CHECK(DescribePassBarriers(uavGraph, secondReadPass).empty());
+	CHECK(DescribePassBarriers(uavGraph, lastPass) == "U buffer 16->16");
+
+	RenderGraph invalidGraph;
+	uint32_t unwritten = invalidGraph.CreateTransient("unwritten", 16, 16);
+	uint32_t target = invalidGraph.ImportResource("target", State::Common, State::Common);
+	uint32_t readPass = invalidGraph.AddPass("read", []() {});
+	invalidGraph.Read(readPass, unwritten, State::ShaderResource);
+	invalidGraph.Write(readPass, target, State::RenderTarget);
+	bool threw = false;
+	try
+	{
+		invalidGraph.Compile();
+	}
+	catch (std::runtime_error&)
+	{
+		threw = true;
+	}
+	CHECK(threw);
+
+	std::printf("OK\n");
+	return 0;
+}
\ No newline at end of file
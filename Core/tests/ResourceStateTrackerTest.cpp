@@ -0,0 +1,279 @@
+#include "../includes/ResourceStateTracker.h"
+#include "TestUtility.h"
+#include <algorithm>
+
+namespace
+{
+	// The D3D12_RESOURCE_STATES values and the rules D3D12ResourceStateTracker uses.
+	enum : uint32_t
+	{
+		Common = 0,
+		VertexAndConstantBuffer = 0x1,
+		IndexBuffer = 0x2,
+		RenderTarget = 0x4,
+		UnorderedAccess = 0x8,
+		DepthWrite = 0x10,
+		DepthRead = 0x20,
+		NonPixelShaderResource = 0x40,
+		PixelShaderResource = 0x80,
+		CopyDest = 0x400,
+		CopySource = 0x800
+	};
+	const uint32_t readStates = VertexAndConstantBuffer | IndexBuffer | DepthRead | NonPixelShaderResource |
+		PixelShaderResource | CopySource;
+	const uint32_t texturePromotionStates = NonPixelShaderResource | PixelShaderResource | CopySource | CopyDest;
+
+	// A command list: the flushed barriers and the commands using the resources, in recording order.
+	class RecordingList : public ResourceBarrierSink
+	{
+	public:
+		void RecordBarriers(const ResourceBarrierDesc* barriers, uint32_t count) override
+		{
+			flushes.emplace_back(barriers, barriers + count);
+			for (uint32_t i = 0; i < count; i++)
+				commands.push_back({ false, barriers[i], nullptr, 0 });
+		}
+		void Use(void* resource, uint32_t state)
+		{
+			commands.push_back({ true, {}, resource, state });
+		}
+
+		struct Command
+		{
+			bool isUse;
+			ResourceBarrierDesc barrier;
+			void* resource;
+			uint32_t state;
+		};
+
+		std::vector<std::vector<ResourceBarrierDesc>> flushes;
+		std::vector<Command> commands;
+	};
+
+	bool IsInState(uint32_t currentState, uint32_t state)
+	{
+		return currentState == state ||
+			((currentState & ~readStates) == 0 && (state & ~readStates) == 0 && state != 0 && (currentState & state) == state);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	ResourceStateRules rules;
+	rules.commonState = Common;
+	rules.readStates = readStates;
+	rules.texturePromotionStates = texturePromotionStates;
+
+	// A frame of a sample: the back buffer goes to render target and back to present, a texture is uploaded
+	// and read, a buffer is read and written.
+	{
+		GlobalResourceStates globalStates;
+		int backBuffer = 0, texture = 0, buffer = 0, promotedTexture = 0;
+		globalStates.Register(&backBuffer, Common, false);
+		globalStates.Register(&texture, CopyDest, false);
+		globalStates.Register(&buffer, Common, true);
+		globalStates.Register(&promotedTexture, Common, false);
+
+		ResourceStateTracker tracker(rules);
+		RecordingList list;
+		std::vector<ResourceBarrierDesc> resolved;
+
+		// First uses produce no barrier in the list, Resolve decides at submission.
+		tracker.TransitionResource(&backBuffer, RenderTarget);
+		tracker.FlushResourceBarriers(list);
+		CHECK(list.flushes.empty());
+		tracker.TransitionResource(&backBuffer, RenderTarget);
+		CHECK(tracker.GetStatistics().redundantCount == 1);
+
+		// Two read transitions before the flush fold into one barrier to the combined read state.
+		tracker.TransitionResource(&texture, CopyDest);
+		tracker.FlushResourceBarriers(list);
+		tracker.TransitionResource(&texture, PixelShaderResource);
+		tracker.TransitionResource(&texture, PixelShaderResource | NonPixelShaderResource);
+		tracker.TransitionResource(&buffer, VertexAndConstantBuffer);
+		tracker.FlushResourceBarriers(list);
+		CHECK(list.flushes.size() == 1 && list.flushes[0].size() == 1);
+		CHECK(list.flushes[0][0].after == (PixelShaderResource | NonPixelShaderResource));
+		tracker.TransitionResource(&texture, PixelShaderResource);
+		CHECK(tracker.GetStatistics().redundantCount == 2);
+
+		// A transition undone before the flush cancels, two UAV barriers before the flush become one.
+		tracker.TransitionResource(&promotedTexture, PixelShaderResource);
+		tracker.FlushResourceBarriers(list);
+		tracker.TransitionResource(&backBuffer, Common);
+		tracker.TransitionResource(&buffer, CopyDest);
+		tracker.TransitionResource(&buffer, VertexAndConstantBuffer);
+		tracker.UAVBarrier(&buffer);
+		tracker.UAVBarrier(&buffer);
+		tracker.FlushResourceBarriers(list);
+		CHECK(list.flushes.size() == 2 && list.flushes[1].size() == 2);
+
+		// Only the back buffer needs a barrier before the list, the buffer and the promoted texture decay.
+		tracker.Resolve(globalStates, resolved);
+		CHECK(resolved.size() == 1 && resolved[0].resource == &backBuffer);
+		CHECK(resolved[0].before == Common && resolved[0].after == RenderTarget);
+		uint32_t state = 0;
+		CHECK(globalStates.GetState(&backBuffer, state) && state == Common);
+		CHECK(globalStates.GetState(&texture, state) && state == (PixelShaderResource | NonPixelShaderResource));
+		CHECK(globalStates.GetState(&buffer, state) && state == Common);
+		CHECK(globalStates.GetState(&promotedTexture, state) && state == Common);
+		ResourceStateTrackerStatistics statistics = tracker.GetStatistics();
+		CHECK(statistics.promotedCount == 2 && statistics.resolvedBarrierCount == 1);
+
+		// A first use that changes before anything was flushed is replaced by the later state.
+		tracker.Reset();
+		list = RecordingList();
+		resolved.clear();
+		tracker.TransitionResource(&texture, CopyDest);
+		tracker.TransitionResource(&texture, RenderTarget);
+		tracker.FlushResourceBarriers(list);
+		CHECK(list.flushes.empty());
+		tracker.Resolve(globalStates, resolved);
+		CHECK(resolved.size() == 1 && resolved[0].before == (PixelShaderResource | NonPixelShaderResource) &&
+			resolved[0].after == RenderTarget);
+
+		// A released resource is left to the caller, like one that was never registered.
+		globalStates.Unregister(&texture);
+		CHECK(!globalStates.GetState(&texture, state));
+		tracker.Reset();
+		resolved.clear();
+		tracker.TransitionResource(&texture, PixelShaderResource);
+		tracker.FlushResourceBarriers(list);
+		tracker.Resolve(globalStates, resolved);
+		CHECK(resolved.empty() && !globalStates.GetState(&texture, state));
+	}
+
+	// Three command lists record random transitions and are submitted in a random order. A simulation of
+	// the D3D12 rules runs the resolved barriers and the lists: every barrier's before state and every use
+	// has to match the simulated state, promotions have to be legal, and the global states have to match
+	// the simulated ones after decay.
+	const uint32_t iterationCount = IsBenchmarkRun(argc, argv) ? 50000 : 5000;
+	const int resourceCount = 12;
+	int resources[resourceCount];
+	bool isBuffer[resourceCount];
+	GlobalResourceStates globalStates;
+	std::unordered_map<void*, uint32_t> gpuStates;
+	for (int i = 0; i < resourceCount; i++)
+	{
+		isBuffer[i] = i % 3 == 0;
+		globalStates.Register(&resources[i], Common, isBuffer[i]);
+		gpuStates[&resources[i]] = Common;
+	}
+
+	const uint32_t states[] = { Common, VertexAndConstantBuffer, RenderTarget, UnorderedAccess, PixelShaderResource,
+		NonPixelShaderResource, PixelShaderResource | NonPixelShaderResource, CopyDest, CopySource, DepthWrite,
+		DepthRead, CopySource | PixelShaderResource };
+	const uint32_t stateCount = sizeof(states) / sizeof(states[0]);
+	const uint32_t bufferStateMask = ~(RenderTarget | DepthWrite | DepthRead);
+	auto randomState = [&](std::mt19937& random, int resource)
+	{
+		return states[random() % stateCount] & (isBuffer[resource] ? bufferStateMask : ~0u);
+	};
+
+	std::mt19937 random(11);
+	std::vector<ResourceStateTracker> trackers(3, ResourceStateTracker(rules));
+	uint64_t requestedCount = 0, barrierCount = 0, flushCount = 0, resolvedCount = 0;
+	for (uint32_t iteration = 0; iteration < iterationCount; iteration++)
+	{
+		std::vector<RecordingList> lists(3);
+		for (auto& tracker : trackers)
+			tracker.Reset();
+
+		for (int operation = 0; operation < 30; operation++)
+		{
+			int list = random() % 3;
+			int resource = random() % resourceCount;
+			uint32_t state = randomState(random, resource);
+			if (random() % 4 == 0)
+			{
+				trackers[list].TransitionResource(&resources[resource], randomState(random, resource));
+				requestedCount++;
+			}
+			trackers[list].TransitionResource(&resources[resource], state);
+			requestedCount++;
+
+			// Sometimes another resource's transition goes out in the same flush.
+			if (random() % 5 == 0)
+			{
+				int otherResource = (resource + 1 + random() % (resourceCount - 1)) % resourceCount;
+				uint32_t otherState = randomState(random, otherResource);
+				trackers[list].TransitionResource(&resources[otherResource], otherState);
+				requestedCount++;
+				trackers[list].FlushResourceBarriers(lists[list]);
+				lists[list].Use(&resources[otherResource], otherState);
+			}
+
+			trackers[list].FlushResourceBarriers(lists[list]);
+			lists[list].Use(&resources[resource], state);
+			if (state == UnorderedAccess && random() % 2)
+			{
+				trackers[list].UAVBarrier(&resources[resource]);
+				trackers[list].FlushResourceBarriers(lists[list]);
+			}
+		}
+
+		int order[3] = { 0, 1, 2 };
+		std::shuffle(order, order + 3, random);
+		for (int list : order)
+		{
+			std::vector<ResourceBarrierDesc> resolved;
+			trackers[list].Resolve(globalStates, resolved);
+			resolvedCount += resolved.size();
+			for (const ResourceBarrierDesc& barrier : resolved)
+			{
+				CHECK(gpuStates[barrier.resource] == barrier.before);
+				gpuStates[barrier.resource] = barrier.after;
+			}
+
+			std::unordered_map<void*, bool> isAccessed, isPromotedToRead, hasBarrier;
+			auto promote = [&](void* resource, uint32_t state)
+			{
+				int i = static_cast<int>(static_cast<int*>(resource) - resources);
+				if (isAccessed[resource] || gpuStates[resource] != Common || state == Common)
+					return false;
+				if (!isBuffer[i] && (state & ~texturePromotionStates) != 0)
+					return false;
+				gpuStates[resource] = state;
+				isPromotedToRead[resource] = (state & ~readStates) == 0;
+				return true;
+			};
+
+			for (const RecordingList::Command& command : lists[list].commands)
+			{
+				if (command.isUse)
+				{
+					CHECK(IsInState(gpuStates[command.resource], command.state) || promote(command.resource, command.state));
+					isAccessed[command.resource] = true;
+				}
+				else if (command.barrier.type == ResourceBarrierType::Transition)
+				{
+					void* resource = command.barrier.resource;
+					CHECK(gpuStates[resource] == command.barrier.before || promote(resource, command.barrier.before));
+					isAccessed[resource] = true;
+					hasBarrier[resource] = true;
+					gpuStates[resource] = command.barrier.after;
+					barrierCount++;
+				}
+			}
+			flushCount += lists[list].flushes.size();
+
+			for (int i = 0; i < resourceCount; i++)
+			{
+				void* resource = &resources[i];
+				if (!isAccessed[resource])
+					continue;
+				if (isBuffer[i] || (isPromotedToRead[resource] && !hasBarrier[resource]))
+					gpuStates[resource] = Common;
+
+				uint32_t globalState = 0;
+				CHECK(globalStates.GetState(resource, globalState) && globalState == gpuStates[resource]);
+			}
+		}
+	}
+	std::printf("%llu transitions requested, %llu barriers in %llu flushes, %llu resolved at submission\n",
+		static_cast<unsigned long long>(requestedCount), static_cast<unsigned long long>(barrierCount),
+		static_cast<unsigned long long>(flushCount), static_cast<unsigned long long>(resolvedCount));
+
+	std::printf("OK\n");
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include "../includes/ShaderCache.h"
+#include "TestUtility.h"
+
+namespace
+{
+	void WriteFile(const std::string& filename, const std::string& text)
+	{
+		std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+		file << text;
+		CHECK(static_cast<bool>(file));
+	}
+	void AppendFile(const std::string& filename, const std::string& text)
+	{
+		std::ofstream file(filename, std::ios::binary | std::ios::app);
+		file << text;
+	}
+}
+
+int main()
+{
+	CHECK(ShaderCache::NormalizePath("..\\..\\Shaders/./a/../common.hlsl") == "../../Shaders/common.hlsl");
+
+	// A token of this run in the shader, so blobs of earlier runs don't hit.
+	std::string token = std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+	WriteFile("ShaderCacheTestMain.hlsl", "// " + token + "\n#include \"ShaderCacheTestCommon.hlsl\"\nfloat4 VSMain() : SV_POSITION { return 0; }\n");
+	WriteFile("ShaderCacheTestCommon.hlsl", "#include \"ShaderCacheTestLighting.hlsl\"\n#include \"ShaderCacheTestMissing.hlsl\"\n");
+	WriteFile("ShaderCacheTestLighting.hlsl", "float3 Lighting() { return 1; }\n");
+
+	ShaderCache cache("ShaderCacheTestCache");
+	std::vector<std::string> includes = cache.GetIncludeGraph("ShaderCacheTestMain.hlsl");
+	CHECK(includes.size() == 3);
+	CHECK(includes[1].find("ShaderCacheTestCommon.hlsl") != std::string::npos);
+	CHECK(includes[2].find("ShaderCacheTestLighting.hlsl") != std::string::npos);
+
+	ShaderCompileDesc desc;
+	desc.filename = "ShaderCacheTestMain.hlsl";
+	desc.entrypoint = "VSMain";
+	desc.target = "vs_5_1";
+
+	uint64_t key = 0;
+	uint64_t definedKey = 0;
+	CHECK(cache.ComputeKey(desc, key));
+	desc.defines.push_back({ "NUM_DIR_LIGHTS", "3" });
+	CHECK(cache.ComputeKey(desc, definedKey));
+	CHECK(key != definedKey);
+	desc.defines.clear();
+
+	uint64_t targetKey = 0;
+	desc.target = "vs_5_0";
+	CHECK(cache.ComputeKey(desc, targetKey));
+	CHECK(targetKey != key);
+	desc.target = "vs_5_1";
+
+	std::vector<uint8_t> bytecode;
+	CHECK(!cache.Load(key, bytecode));
+	const char blob[] = "bytecodebytecode";
+	cache.Store(key, blob, sizeof(blob), "ShaderCacheTestMain.hlsl VSMain");
+
+	// A new cache reads the index of the previous one.
+	{
+		ShaderCache warmCache("ShaderCacheTestCache");
+		CHECK(warmCache.Load(key, bytecode));
+		CHECK(bytecode.size() == sizeof(blob) && std::memcmp(bytecode.data(), blob, sizeof(blob)) == 0);
+		CHECK(warmCache.GetStatistics().hitCount == 1);
+	}
+
+	// Editing a file two includes down changes the key.
+	AppendFile("ShaderCacheTestLighting.hlsl", "// edit\n");
+	uint64_t editedKey = 0;
+	cache.InvalidateFiles();
+	CHECK(cache.ComputeKey(desc, editedKey));
+	CHECK(editedKey != key);
+
+	// A blob that doesn't match the index is a miss.
+	char blobName[32];
+	std::snprintf(blobName, sizeof(blobName), "%016llx.bin", static_cast<unsigned long long>(key));
+	AppendFile(std::string("ShaderCacheTestCache/") + blobName, "x");
+	{
+		ShaderCache corruptCache("ShaderCacheTestCache");
+		CHECK(!corruptCache.Load(key, bytecode));
+		CHECK(corruptCache.GetStatistics().corruptCount == 1);
+	}
+
+	desc.filename = "ShaderCacheTestNotThere.hlsl";
+	CHECK(!cache.ComputeKey(desc, key));
+
+	std::printf("OK\n");
+	return 0;
+}
\ No newline at end of file
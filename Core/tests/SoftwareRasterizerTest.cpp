@@ -0,0 +1,112 @@
+#include "../includes/SoftwareRasterizer.h"
+#include "../includes/BasicGeometryGenerator.h"
+#include "TestUtility.h"
+using namespace DirectX;
+
+namespace
+{
+	const uint32_t width = 173;
+	const uint32_t height = 97;
+
+	// FNV-1a of the color buffer of the scene below. The objects float above the floor and don't touch, so no two
+	// surfaces are close enough in depth for the depth modes or the thread count to pick a different winner.
+	const uint64_t goldenHash = 0xf1a03a36fdbe3692ull;
+
+	struct Frame
+	{
+		uint64_t hash;
+		uint64_t shadedPixelCount;
+		uint64_t depthRejectedPixelCount;
+		uint32_t coveredPixelCount;
+	};
+
+	// The sphere in front is drawn first and the floor last, so most of what's behind it is rejected by the
+	// depth test instead of overwritten.
+	Frame RenderScene(JobSystem& jobSystem, DepthMode depthMode)
+	{
+		Camera camera;
+		camera.SetLens(0.3f * XM_PI, static_cast<float>(width) / height, 0.5f, 100.0f);
+		camera.SetDepthMode(depthMode);
+		camera.LookAt(XMFLOAT3(2.0f, 6.0f, -12.0f), XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f));
+
+		SceneConstant sceneConstant{};
+		XMStoreFloat4x4(&sceneConstant.viewProj, XMMatrixTranspose(XMLoadFloat4x4(&camera.GetViewProj())));
+		sceneConstant.cameraPosition = camera.GetPosition();
+		sceneConstant.farDepth = GetClearDepth(depthMode);
+		sceneConstant.ambientLight = XMFLOAT4(0.2f, 0.2f, 0.25f, 1.0f);
+		sceneConstant.lights[0].strength = XMFLOAT3(0.8f, 0.8f, 0.7f);
+		sceneConstant.lights[0].direction = XMFLOAT3(0.57735f, -0.57735f, 0.57735f);
+
+		SoftwareRasterizer rasterizer(width, height, jobSystem);
+		rasterizer.SetDepthMode(depthMode);
+		rasterizer.BeginFrame(sceneConstant, XMFLOAT4(0.1f, 0.2f, 0.4f, 1.0f));
+
+		BasicGeometryGenerator geometryGenerator;
+		auto draw = [&](const MeshData& meshData, FXMMATRIX world, const XMFLOAT4& diffuseAlbedo)
+		{
+			ObjectConstant objectConstant{};
+			XMStoreFloat4x4(&objectConstant.world, XMMatrixTranspose(world));
+			MaterialData materialData = { diffuseAlbedo, XMFLOAT3(0.05f, 0.05f, 0.05f), 0.3f };
+			rasterizer.Draw(meshData, objectConstant, materialData);
+		};
+		draw(geometryGenerator.CreateSphere(1.0f, 24, 16), XMMatrixTranslation(1.0f, 1.2f, -3.0f),
+			XMFLOAT4(0.9f, 0.2f, 0.2f, 1.0f));
+		draw(geometryGenerator.CreateBox(2.0f, 2.0f, 2.0f), XMMatrixRotationY(0.4f) * XMMatrixTranslation(0.0f, 1.2f, 0.5f),
+			XMFLOAT4(0.2f, 0.8f, 0.3f, 1.0f));
+		draw(geometryGenerator.CreateSphere(1.5f, 24, 16), XMMatrixTranslation(-1.0f, 1.7f, 4.0f),
+			XMFLOAT4(0.3f, 0.4f, 0.9f, 1.0f));
+		draw(geometryGenerator.CreateGrid(30.0f, 30.0f, 8, 8), XMMatrixIdentity(), XMFLOAT4(0.7f, 0.7f, 0.7f, 1.0f));
+		rasterizer.EndFrame();
+
+		// Every covered pixel is nearer than the clear value, the rest still holds it.
+		const std::vector<float>& depthBuffer = rasterizer.GetDepthBuffer();
+		float clearDepth = GetClearDepth(depthMode);
+		bool isGreaterNearer = GetDepthComparison(depthMode) == DepthComparison::Greater;
+		uint32_t coveredPixelCount = 0;
+		for (float depth : depthBuffer)
+		{
+			if (depth != clearDepth)
+			{
+				CHECK(isGreaterNearer ? depth > clearDepth : depth < clearDepth);
+				coveredPixelCount++;
+			}
+		}
+
+		SoftwareRasterizerStatistics statistics = rasterizer.GetStatistics();
+		return { rasterizer.GetColorBufferHash(), statistics.shadedPixelCount, statistics.depthRejectedPixelCount,
+			coveredPixelCount };
+	}
+}
+
+int main()
+{
+	const DepthMode depthModes[] = { DepthMode::Standard, DepthMode::Reversed, DepthMode::ReversedInfinite };
+	const char* depthModeNames[] = { "standard", "reversed", "reversed infinite" };
+	uint32_t threadCount = std::max(4u, std::thread::hardware_concurrency());
+	const uint32_t workerCounts[] = { 1, 2, threadCount };
+
+	Frame first = {};
+	for (uint32_t workerCount : workerCounts)
+	{
+		JobSystem jobSystem(workerCount);
+		for (int mode = 0; mode < 3; mode++)
+		{
+			Frame frame = RenderScene(jobSystem, depthModes[mode]);
+			std::printf("%-17s %2u workers: hash %016llx, %llu shaded, %llu depth rejected, %u covered\n",
+				depthModeNames[mode], workerCount, static_cast<unsigned long long>(frame.hash),
+				static_cast<unsigned long long>(frame.shadedPixelCount),
+				static_cast<unsigned long long>(frame.depthRejectedPixelCount), frame.coveredPixelCount);
+
+			if (workerCount == workerCounts[0] && mode == 0)
+				first = frame;
+			CHECK(frame.hash == goldenHash);
+			CHECK(frame.shadedPixelCount == first.shadedPixelCount);
+			CHECK(frame.depthRejectedPixelCount == first.depthRejectedPixelCount);
+			CHECK(frame.coveredPixelCount == first.coveredPixelCount);
+		}
+	}
+	CHECK(first.depthRejectedPixelCount > 0 && first.coveredPixelCount < width * height);
+
+	std::printf("OK\n");
+	return 0;
+}
\ No newline at end of file
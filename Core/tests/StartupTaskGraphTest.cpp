@@ -0,0 +1,93 @@
+#include "../includes/StartupTaskGraph.h"
+#include "TestUtility.h"
+
+namespace
+{
+	// A fake startup: shaderCount compiles and a PSO per two shaders, sleeping instead of compiling.
+	double RunFakeStartup(uint32_t workerCount, uint32_t shaderCount, int shaderMilliseconds, int psoMilliseconds,
+		bool checkOrder)
+	{
+		JobSystem jobSystem(workerCount);
+		StartupTaskGraph graph(jobSystem);
+
+		std::vector<StartupTaskGraph::TaskHandle> shaders;
+		for (uint32_t i = 0; i < shaderCount; i++)
+		{
+			shaders.push_back(graph.AddTask("shader" + std::to_string(i), [shaderMilliseconds]()
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(shaderMilliseconds));
+			}));
+		}
+		std::vector<StartupTaskGraph::TaskHandle> psos;
+		for (uint32_t i = 0; i < shaderCount / 2; i++)
+		{
+			psos.push_back(graph.AddTask("pso" + std::to_string(i), [psoMilliseconds]()
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(psoMilliseconds));
+			}, { shaders[2 * i], shaders[2 * i + 1] }));
+		}
+		graph.Run();
+
+		if (checkOrder)
+		{
+			auto& timings = graph.GetTimings();
+			for (uint32_t i = 0; i < psos.size(); i++)
+			{
+				CHECK(timings[psos[i]].beginMilliseconds >= timings[shaders[2 * i]].endMilliseconds);
+				CHECK(timings[psos[i]].beginMilliseconds >= timings[shaders[2 * i + 1]].endMilliseconds);
+			}
+
+			// A shader followed by its PSO.
+			std::vector<StartupTaskGraph::TaskHandle> criticalPath = graph.GetCriticalPath();
+			CHECK(criticalPath.size() == 2);
+			CHECK(graph.GetCriticalPathMilliseconds() >= shaderMilliseconds + psoMilliseconds);
+			CHECK(graph.GetTotalTaskMilliseconds() >= shaderCount * shaderMilliseconds);
+			CHECK(!graph.GetTimelineReport().empty());
+		}
+
+		return graph.GetWallMilliseconds();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	bool benchmark = IsBenchmarkRun(argc, argv);
+	uint32_t shaderCount = 12;
+	int shaderMilliseconds = benchmark ? 40 : 10;
+	int psoMilliseconds = benchmark ? 20 : 5;
+
+	// The calling thread helps, so the graph runs on workerCount + 1 threads. Sleeping tasks don't need
+	// the cores, the wall time follows the thread count like compiles on as many cores would.
+	double twoThreadMilliseconds = RunFakeStartup(1, shaderCount, shaderMilliseconds, psoMilliseconds, true);
+	double fourThreadMilliseconds = RunFakeStartup(3, shaderCount, shaderMilliseconds, psoMilliseconds, true);
+	double eightThreadMilliseconds = RunFakeStartup(7, shaderCount, shaderMilliseconds, psoMilliseconds, true);
+	double serialMilliseconds = shaderCount * shaderMilliseconds + shaderCount / 2 * psoMilliseconds;
+	std::printf("serial %.1f ms, wall 2 threads %.1f ms, 4 threads %.1f ms, 8 threads %.1f ms\n",
+		serialMilliseconds, twoThreadMilliseconds, fourThreadMilliseconds, eightThreadMilliseconds);
+	CHECK(twoThreadMilliseconds < serialMilliseconds * 0.65);
+	CHECK(fourThreadMilliseconds < twoThreadMilliseconds * 0.65);
+	CHECK(eightThreadMilliseconds < fourThreadMilliseconds * 0.8);
+
+	// A failing compile skips its dependents and is rethrown by Run.
+	JobSystem jobSystem(3);
+	StartupTaskGraph graph(jobSystem);
+	auto failing = graph.AddTask("failing", []() { throw std::runtime_error("compile failed"); });
+	int dependentRunCount = 0;
+	graph.AddTask("dependent", [&dependentRunCount]() { dependentRunCount++; }, { failing });
+
+	bool caught = false;
+	try
+	{
+		graph.Run();
+	}
+	catch (const std::runtime_error& e)
+	{
+		caught = std::strcmp(e.what(), "compile failed") == 0;
+	}
+	CHECK(caught);
+	CHECK(dependentRunCount == 0);
+	CHECK(graph.GetTimings()[failing].failed);
+
+	std::printf("OK\n");
+	return 0;
+}
\ No newline at end of file
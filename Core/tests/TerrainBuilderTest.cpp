@@ -0,0 +1,209 @@
+#include "../includes/TerrainBuilder.h"
+#include "TestUtility.h"
+#include <fstream>
+using namespace DirectX;
+
+namespace
+{
+	const float sampleSpacing = 2.0f;
+	const float heightScale = 100.0f;
+	const float heightOffset = -30.0f;
+
+	std::vector<uint16_t> CreateHeightmap(uint32_t width, uint32_t height)
+	{
+		std::mt19937 random(3);
+		std::uniform_int_distribution<int> noise(-400, 400);
+		std::vector<uint16_t> samples(static_cast<size_t>(width) * height);
+		for (uint32_t y = 0; y < height; y++)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				float value = 32768.0f + 20000.0f * std::sin(x * 0.021f) * std::cos(y * 0.017f) + 6000.0f * std::sin(x * 0.11f - y * 0.07f);
+				samples[static_cast<size_t>(y) * width + x] =
+					static_cast<uint16_t>(std::min(std::max(static_cast<int>(value) + noise(random), 0), 65535));
+			}
+		}
+		return samples;
+	}
+
+	void WriteHeightmap(const std::string& filename, const std::vector<uint16_t>& samples)
+	{
+		// Little endian like the files HeightmapFile reads, as long as the test runs on a little endian machine.
+		std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(samples.data()), samples.size() * sizeof(uint16_t));
+	}
+
+	// One vertex the slow way, neighbours outside of the map repeat its edge.
+	Vertex ReferenceVertex(const std::vector<float>& heights, int width, int height, int x, int y)
+	{
+		auto sample = [&](int sampleX, int sampleY)
+		{
+			sampleX = std::min(std::max(sampleX, 0), width - 1);
+			sampleY = std::min(std::max(sampleY, 0), height - 1);
+			return heights[static_cast<size_t>(sampleY) * width + sampleX];
+		};
+
+		float nx = (sample(x - 1, y) - sample(x + 1, y)) * heightScale;
+		float ny = 2.0f * sampleSpacing;
+		float nz = (sample(x, y - 1) - sample(x, y + 1)) * heightScale;
+		float length = std::sqrt(nx * nx + ny * ny + nz * nz);
+
+		return Vertex((x - 0.5f * (width - 1)) * sampleSpacing, sample(x, y) * heightScale + heightOffset,
+			(y - 0.5f * (height - 1)) * sampleSpacing, nx / length, ny / length, nz / length,
+			x / (width - 1.0f), y / (height - 1.0f));
+	}
+
+	bool IsNear(const XMFLOAT3& a, const XMFLOAT3& b, float tolerance)
+	{
+		return std::fabs(a.x - b.x) <= tolerance && std::fabs(a.y - b.y) <= tolerance && std::fabs(a.z - b.z) <= tolerance;
+	}
+	bool IsNear(const XMFLOAT2& a, const XMFLOAT2& b, float tolerance)
+	{
+		return std::fabs(a.x - b.x) <= tolerance && std::fabs(a.y - b.y) <= tolerance;
+	}
+
+	void RunBenchmark(TerrainBuilder& builder)
+	{
+		// 1k and 4k from 8 bit maps in memory, like CreateTerrain gets them from stbi_load.
+		const uint32_t sizes[] = { 1024, 4096 };
+		for (uint32_t size : sizes)
+		{
+			std::vector<uint16_t> samples = CreateHeightmap(size, size);
+			std::vector<unsigned char> heightValues(samples.size());
+			for (size_t i = 0; i < samples.size(); i++)
+				heightValues[i] = static_cast<unsigned char>(samples[i] >> 8);
+
+			auto start = std::chrono::steady_clock::now();
+			MeshData mesh = builder.Build(heightValues.data(), size, size, 1);
+			std::printf("%u x %u: %.1f ms, %u vertices\n", size, size, MillisecondsSince(start),
+				builder.GetStatistics().vertexCount);
+		}
+
+		// 16k doesn't fit as one mesh, it is streamed from a 16 bit file as 256 tiles of 1024.
+		const uint32_t size = 16384;
+		const uint32_t tileSize = 1024;
+		const std::string filename = "TerrainBuilderTestBenchmark.r16";
+		{
+			std::vector<uint16_t> row(size);
+			std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+			for (uint32_t y = 0; y < size; y++)
+			{
+				for (uint32_t x = 0; x < size; x++)
+					row[x] = static_cast<uint16_t>(32768.0f + 20000.0f * std::sin(x * 0.0021f) * std::cos(y * 0.0017f));
+				file.write(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(uint16_t));
+			}
+		}
+
+		HeightmapFile heightmap(filename, size, size);
+		double readMilliseconds = 0.0;
+		uint64_t vertexCount = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (uint32_t tileY = 0; tileY * tileSize < size - 1; tileY++)
+		{
+			for (uint32_t tileX = 0; tileX * tileSize < size - 1; tileX++)
+			{
+				MeshData tile = builder.BuildTile(heightmap, tileX, tileY, tileSize);
+				readMilliseconds += builder.GetStatistics().readMilliseconds;
+				vertexCount += tile.vertices.size();
+			}
+		}
+		std::printf("%u x %u in tiles of %u: %.1f ms, %.1f ms of it reading, %llu vertices\n", size, size, tileSize,
+			MillisecondsSince(start), readMilliseconds, static_cast<unsigned long long>(vertexCount));
+		std::remove(filename.c_str());
+	}
+}
+
+int main(int argc, char** argv)
+{
+	// Odd sizes, the tiles on the far edges are partial.
+	const uint32_t width = 301;
+	const uint32_t height = 203;
+	std::vector<uint16_t> samples = CreateHeightmap(width, height);
+	std::vector<float> heights(samples.size());
+	for (size_t i = 0; i < samples.size(); i++)
+		heights[i] = samples[i] / 65535.0f;
+
+	JobSystem jobSystem(3);
+	TerrainBuilder builder(jobSystem);
+	builder.SetSampleSpacing(sampleSpacing);
+	builder.SetHeightScale(heightScale, heightOffset);
+
+	// The whole map against the scalar reference, including the height range.
+	MeshData mesh = builder.Build(heights.data(), width, height);
+	CHECK(mesh.vertices.size() == static_cast<size_t>(width) * height);
+	CHECK(mesh.indices.size() == static_cast<size_t>(width - 1) * (height - 1) * 6);
+
+	float minHeight = std::numeric_limits<float>::max();
+	float maxHeight = -std::numeric_limits<float>::max();
+	float referenceMinHeight = std::numeric_limits<float>::max();
+	float referenceMaxHeight = -std::numeric_limits<float>::max();
+	for (uint32_t y = 0; y < height; y++)
+	{
+		for (uint32_t x = 0; x < width; x++)
+		{
+			const Vertex& vertex = mesh.vertices[static_cast<size_t>(y) * width + x];
+			Vertex reference = ReferenceVertex(heights, width, height, x, y);
+			CHECK(IsNear(vertex.position, reference.position, 1.0e-3f));
+			CHECK(IsNear(vertex.normal, reference.normal, 1.0e-5f));
+			CHECK(IsNear(vertex.texCoord, reference.texCoord, 1.0e-6f));
+
+			minHeight = std::min(minHeight, vertex.position.y);
+			maxHeight = std::max(maxHeight, vertex.position.y);
+			referenceMinHeight = std::min(referenceMinHeight, reference.position.y);
+			referenceMaxHeight = std::max(referenceMaxHeight, reference.position.y);
+		}
+	}
+	CHECK(std::fabs(minHeight - referenceMinHeight) < 1.0e-3f && std::fabs(maxHeight - referenceMaxHeight) < 1.0e-3f);
+	CHECK(builder.GetStatistics().triangleCount == mesh.indices.size() / 3);
+
+	// Every triangle faces up.
+	for (size_t i = 0; i < mesh.indices.size(); i += 3)
+	{
+		XMVECTOR p0 = XMLoadFloat3(&mesh.vertices[mesh.indices[i]].position);
+		XMVECTOR p1 = XMLoadFloat3(&mesh.vertices[mesh.indices[i + 1]].position);
+		XMVECTOR p2 = XMLoadFloat3(&mesh.vertices[mesh.indices[i + 2]].position);
+		CHECK(XMVectorGetY(XMVector3Cross(p1 - p0, p2 - p0)) > 0.0f);
+	}
+
+	// The tiles streamed from a 16 bit file are the whole-map mesh cut into pieces.
+	const std::string filename = "TerrainBuilderTest.r16";
+	WriteHeightmap(filename, samples);
+	{
+		HeightmapFile heightmap(filename, width, height);
+		const uint32_t tileSize = 64;
+		size_t tileVertexCount = 0;
+		for (uint32_t tileY = 0; tileY * tileSize < height - 1; tileY++)
+		{
+			for (uint32_t tileX = 0; tileX * tileSize < width - 1; tileX++)
+			{
+				MeshData tile = builder.BuildTile(heightmap, tileX, tileY, tileSize);
+				uint32_t countX = std::min(tileSize + 1, width - tileX * tileSize);
+				uint32_t countY = std::min(tileSize + 1, height - tileY * tileSize);
+				CHECK(tile.vertices.size() == static_cast<size_t>(countX) * countY);
+				CHECK(tile.indices.size() == static_cast<size_t>(countX - 1) * (countY - 1) * 6);
+				tileVertexCount += tile.vertices.size();
+
+				for (uint32_t y = 0; y < countY; y++)
+				{
+					for (uint32_t x = 0; x < countX; x++)
+					{
+						const Vertex& vertex = tile.vertices[static_cast<size_t>(y) * countX + x];
+						const Vertex& wholeVertex = mesh.vertices[static_cast<size_t>(tileY * tileSize + y) * width +
+							tileX * tileSize + x];
+						CHECK(IsNear(vertex.position, wholeVertex.position, 0.0f));
+						CHECK(IsNear(vertex.normal, wholeVertex.normal, 1.0e-6f));
+						CHECK(IsNear(vertex.texCoord, wholeVertex.texCoord, 0.0f));
+					}
+				}
+			}
+		}
+		std::printf("%zu vertices in tiles of %u, %zu in the whole map\n", tileVertexCount, tileSize, mesh.vertices.size());
+	}
+	std::remove(filename.c_str());
+
+	if (IsBenchmarkRun(argc, argv))
+		RunBenchmark(builder);
+
+	std::printf("OK\n");
+	return 0;
+}
\ No newline at end of file
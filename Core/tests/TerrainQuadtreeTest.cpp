@@ -0,0 +1,231 @@
+#include "../includes/TerrainQuadtree.h"
+#include "TestUtility.h"
+using namespace DirectX;
+
+namespace
+{
+	struct Heightmap
+	{
+		uint32_t width;
+		uint32_t height;
+		std::vector<float> heights;
+
+		// Bilinear with clamp addressing like the heightmap sampler, x and y in texels from the map's corner.
+		float Sample(float x, float y) const
+		{
+			x -= 0.5f;
+			y -= 0.5f;
+			int x0 = static_cast<int>(std::floor(x));
+			int y0 = static_cast<int>(std::floor(y));
+			float fx = x - x0;
+			float fy = y - y0;
+			auto at = [this](int x, int y)
+			{
+				x = std::min(std::max(x, 0), static_cast<int>(width) - 1);
+				y = std::min(std::max(y, 0), static_cast<int>(height) - 1);
+				return heights[y * width + x];
+			};
+			return (at(x0, y0) * (1.0f - fx) + at(x0 + 1, y0) * fx) * (1.0f - fy) +
+				(at(x0, y0 + 1) * (1.0f - fx) + at(x0 + 1, y0 + 1) * fx) * fy;
+		}
+	};
+
+	// Every texel is drawn by at most one selected chunk (exactly one when nothing is culled), neighbouring
+	// chunks are at most one level apart, and where a chunk meets a coarser one its edge is fully morphed
+	// while the coarser one isn't morphed at all, so the shared edge has no cracks. Returns the number
+	// of edge vertices between two levels.
+	uint32_t CheckSelection(TerrainQuadtree& terrain, const Heightmap& map, const XMFLOAT3& cameraPosition,
+		bool isCullingDisabled, std::vector<int>& owners)
+	{
+		const auto& selection = terrain.GetSelection();
+		float halfWidth = 0.5f * map.width;
+		float halfHeight = 0.5f * map.height;
+
+		std::fill(owners.begin(), owners.end(), -1);
+		for (size_t i = 0; i < selection.size(); i++)
+		{
+			const TerrainChunkData& chunk = selection[i];
+			CHECK((i < terrain.GetFullGridChunkCount()) == (chunk.cellCount == terrain.GetChunkSize()));
+
+			int x0 = static_cast<int>(std::lround(chunk.origin.x + halfWidth));
+			int y0 = static_cast<int>(std::lround(chunk.origin.y + halfHeight));
+			int size = static_cast<int>(chunk.size);
+			for (int y = y0; y < std::min(y0 + size, static_cast<int>(map.height)); y++)
+			{
+				for (int x = x0; x < std::min(x0 + size, static_cast<int>(map.width)); x++)
+				{
+					CHECK(owners[y * map.width + x] == -1);
+					owners[y * map.width + x] = static_cast<int>(i);
+				}
+			}
+		}
+		if (isCullingDisabled)
+		{
+			for (int owner : owners)
+				CHECK(owner >= 0);
+		}
+
+		uint32_t transitionCount = 0;
+		for (size_t i = 0; i < selection.size(); i++)
+		{
+			const TerrainChunkData& chunk = selection[i];
+			float cellSize = chunk.size / chunk.cellCount;
+			int cellCount = static_cast<int>(chunk.cellCount);
+			float x0 = std::round(chunk.origin.x + halfWidth);
+			float y0 = std::round(chunk.origin.y + halfHeight);
+
+			// Left, right, top and bottom edge, the texel across the edge tells the neighbouring chunk.
+			for (int edge = 0; edge < 4; edge++)
+			{
+				for (int k = 0; k < cellCount; k++)
+				{
+					float x = x0 + (edge == 0 ? 0 : edge == 1 ? cellCount : k) * cellSize;
+					float y = y0 + (edge == 2 ? 0 : edge == 3 ? cellCount : k) * cellSize;
+					if (x >= map.width || y >= map.height)
+						continue;
+
+					int neighbourX = static_cast<int>(x) - (edge == 0 ? 1 : 0);
+					int neighbourY = static_cast<int>(y) - (edge == 2 ? 1 : 0);
+					if (neighbourX < 0 || neighbourY < 0)
+						continue;
+					int neighbour = owners[neighbourY * map.width + neighbourX];
+					if (neighbour < 0 || neighbour == static_cast<int>(i))
+						continue;
+
+					const TerrainChunkData& other = selection[neighbour];
+					int levelDifference = static_cast<int>(other.lodLevel) - static_cast<int>(chunk.lodLevel);
+					CHECK(std::abs(levelDifference) <= 1);
+					if (levelDifference != 1)
+						continue;
+
+					float dx = x - halfWidth - cameraPosition.x;
+					float dy = map.Sample(x, y) - cameraPosition.y;
+					float dz = y - halfHeight - cameraPosition.z;
+					float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+					CHECK(TerrainQuadtree::ComputeMorphFactor(distance, chunk.morphStart, chunk.morphEnd) == 1.0f);
+					CHECK(TerrainQuadtree::ComputeMorphFactor(distance, other.morphStart, other.morphEnd) == 0.0f);
+					transitionCount++;
+				}
+			}
+		}
+		return transitionCount;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	// Not a multiple of the chunk size, so the last row and column of chunks are partial.
+	bool isBenchmarkRun = IsBenchmarkRun(argc, argv);
+	Heightmap map;
+	map.width = isBenchmarkRun ? 2624 : 1000;
+	map.height = isBenchmarkRun ? 1756 : 700;
+	map.heights.resize(map.width * map.height);
+
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+	for (uint32_t y = 0; y < map.height; y++)
+	{
+		for (uint32_t x = 0; x < map.width; x++)
+		{
+			map.heights[y * map.width + x] = 20.0f * std::sin(x * 0.013f) * std::cos(y * 0.017f) +
+				8.0f * std::sin(x * 0.11f + y * 0.07f) + noise(random);
+		}
+	}
+
+	JobSystem jobSystem(3);
+	TerrainQuadtree terrain(jobSystem);
+	terrain.Build(map.heights.data(), map.width, map.height);
+	uint32_t lodCount = terrain.GetLodCount();
+	std::printf("%u levels, %u nodes, build %.2f ms\n", lodCount, terrain.GetNodeCount(), terrain.GetStatistics().buildMilliseconds);
+	CHECK(terrain.GetNodeCountX(lodCount - 1) == 1 && terrain.GetNodeCountY(lodCount - 1) == 1);
+
+	// Node bounds hold every bilinear sample inside the node.
+	for (uint32_t level = 0; level < std::min(lodCount, 2u); level++)
+	{
+		for (uint32_t y = 0; y < terrain.GetNodeCountY(level); y++)
+		{
+			for (uint32_t x = 0; x < terrain.GetNodeCountX(level); x++)
+			{
+				BoundingBox bounds = terrain.GetNodeBounds(level, x, y);
+				std::uniform_real_distribution<float> positionX(bounds.Center.x - bounds.Extents.x, bounds.Center.x + bounds.Extents.x);
+				std::uniform_real_distribution<float> positionZ(bounds.Center.z - bounds.Extents.z, bounds.Center.z + bounds.Extents.z);
+				for (int i = 0; i < 64; i++)
+				{
+					float height = map.Sample(positionX(random) + 0.5f * map.width, positionZ(random) + 0.5f * map.height);
+					CHECK(height >= bounds.Center.y - bounds.Extents.y - 1.0e-4f && height <= bounds.Center.y + bounds.Extents.y + 1.0e-4f);
+				}
+			}
+		}
+	}
+
+	// And are tight: a leaf's height range is the one of its texels and the ring around them.
+	{
+		uint32_t chunkSize = terrain.GetChunkSize();
+		BoundingBox bounds = terrain.GetNodeBounds(0, 10, 10);
+		float minHeight = std::numeric_limits<float>::max();
+		float maxHeight = -minHeight;
+		for (uint32_t y = 10 * chunkSize - 1; y <= 11 * chunkSize; y++)
+		{
+			for (uint32_t x = 10 * chunkSize - 1; x <= 11 * chunkSize; x++)
+			{
+				minHeight = std::min(minHeight, map.heights[y * map.width + x]);
+				maxHeight = std::max(maxHeight, map.heights[y * map.width + x]);
+			}
+		}
+		CHECK(std::fabs(bounds.Center.y - bounds.Extents.y - minHeight) < 1.0e-4f);
+		CHECK(std::fabs(bounds.Center.y + bounds.Extents.y - maxHeight) < 1.0e-4f);
+	}
+
+	// Odd grid positions morph to the even ones below.
+	float gridX = 5.0f;
+	float gridY = 4.0f;
+	TerrainQuadtree::MorphGridPosition(gridX, gridY, 1.0f);
+	CHECK(gridX == 4.0f && gridY == 4.0f);
+	gridX = 7.0f;
+	gridY = 3.0f;
+	TerrainQuadtree::MorphGridPosition(gridX, gridY, 0.5f);
+	CHECK(gridX == 6.5f && gridY == 2.5f);
+
+	// Planes that keep everything, from many camera positions over the whole map.
+	std::array<XMFLOAT4, 6> noPlanes;
+	noPlanes.fill(XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f));
+	std::vector<int> owners(map.width * map.height);
+	std::uniform_real_distribution<float> cameraX(-0.5f * map.width, 0.5f * map.width);
+	std::uniform_real_distribution<float> cameraY(-10.0f, 300.0f);
+	std::uniform_real_distribution<float> cameraZ(-0.5f * map.height, 0.5f * map.height);
+	uint32_t transitionCount = 0;
+	for (int i = 0; i < 20; i++)
+	{
+		XMFLOAT3 cameraPosition(cameraX(random), cameraY(random), cameraZ(random));
+		terrain.Select(cameraPosition, noPlanes);
+		transitionCount += CheckSelection(terrain, map, cameraPosition, true, owners);
+	}
+	CHECK(transitionCount > 0);
+
+	// A flight over the map with a real frustum.
+	Camera camera;
+	camera.SetLens(0.25f * XM_PI, 16.0f / 9.0f, 0.1f, 1000.0f);
+	camera.SetDepthMode(DepthMode::ReversedInfinite);
+	const int frameCount = 100;
+	double selectMilliseconds = 0.0;
+	uint64_t triangleCount = 0;
+	for (int frame = 0; frame < frameCount; frame++)
+	{
+		float angle = frame * 0.06f;
+		XMFLOAT3 position(-0.4f * map.width + frame * 0.008f * map.width, 60.0f, 0.1f * map.height * std::sin(angle));
+		camera.LookAt(position, XMFLOAT3(position.x + 10.0f * std::cos(angle), 40.0f, position.z + 10.0f * std::sin(angle) + 5.0f),
+			XMFLOAT3(0.0f, 1.0f, 0.0f));
+		terrain.Select(camera);
+		CheckSelection(terrain, map, camera.GetPosition(), false, owners);
+
+		TerrainQuadtreeStatistics statistics = terrain.GetStatistics();
+		selectMilliseconds += statistics.selectMilliseconds;
+		triangleCount += statistics.triangleCount;
+	}
+	std::printf("flight: %.0f triangles per frame, %.2f%% of the full map, select %.3f ms, %u edge vertices between levels\n",
+		static_cast<double>(triangleCount) / frameCount, 100.0 * triangleCount / frameCount / (2.0 * (map.width - 1) * (map.height - 1)),
+		selectMilliseconds / frameCount, transitionCount);
+
+	std::printf("OK\n");
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include "../includes/TerrainTessellation.h"
+#include "TestUtility.h"
+using namespace DirectX;
+
+int main(int argc, char** argv)
+{
+	bool isBenchmarkRun = IsBenchmarkRun(argc, argv);
+	int width = isBenchmarkRun ? 2624 : 1024;
+	int height = isBenchmarkRun ? 1756 : 768;
+	const uint32_t countOfPatches = 20;
+
+	// Four channels like stbi_load returns the heightmap, only the first one is the height.
+	std::mt19937 random(5);
+	std::uniform_int_distribution<int> noise(-2, 2);
+	std::vector<unsigned char> heightValues(width * height * 4);
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			float value = 128.0f + 80.0f * std::sin(x * 0.011f) * std::cos(y * 0.015f) + 30.0f * std::sin(x * 0.09f + y * 0.05f);
+			heightValues[(y * width + x) * 4] = static_cast<unsigned char>(std::min(std::max(static_cast<int>(value) + noise(random), 0), 255));
+		}
+	}
+
+	JobSystem jobSystem(3);
+	TerrainTessellation tessellation(jobSystem);
+	tessellation.Build(heightValues.data(), width, height, 4, countOfPatches);
+	std::printf("build %.2f ms\n", tessellation.GetStatistics().buildMilliseconds);
+
+	// Neighbouring patches carry the same data for the edge they share.
+	const auto& patchDatas = tessellation.GetPatchDatas();
+	for (uint32_t i = 0; i < countOfPatches; i++)
+	{
+		for (uint32_t j = 0; j < countOfPatches; j++)
+		{
+			const TerrainPatchData& patch = patchDatas[i * countOfPatches + j];
+			CHECK(patch.minHeight <= patch.maxHeight && patch.edgeErrors.x >= 0.0f);
+			if (i + 1 < countOfPatches)
+			{
+				const TerrainPatchData& next = patchDatas[(i + 1) * countOfPatches + j];
+				CHECK(patch.rect.z == next.rect.x && patch.edgeErrors.z == next.edgeErrors.x && patch.edgeHeights.z == next.edgeHeights.x);
+			}
+			if (j + 1 < countOfPatches)
+			{
+				const TerrainPatchData& next = patchDatas[i * countOfPatches + j + 1];
+				CHECK(patch.rect.w == next.rect.y && patch.edgeErrors.w == next.edgeErrors.y && patch.edgeHeights.w == next.edgeHeights.y);
+			}
+		}
+	}
+
+	// A flight over the terrain: neighbours agree on their shared edge factor, and a culled patch has no
+	// point of its bounds inside the frustum.
+	Camera camera;
+	camera.SetLens(0.25f * XM_PI, 800.0f / 600.0f, 0.1f, 1000.0f);
+	camera.SetDepthMode(DepthMode::ReversedInfinite);
+	const int frameCount = 150;
+	uint64_t triangleCount = 0;
+	uint32_t culledCount = 0;
+	double updateMilliseconds = 0.0;
+	for (int frame = 0; frame < frameCount; frame++)
+	{
+		float angle = frame * 0.04f;
+		XMFLOAT3 position(-0.4f * width + frame * 0.005f * width, 40.0f + 20.0f * std::sin(3.0f * angle), 0.3f * height * std::sin(angle));
+		camera.LookAt(position, XMFLOAT3(position.x + 50.0f * std::cos(angle), position.y - 10.0f, position.z + 50.0f * std::sin(0.7f * angle)),
+			XMFLOAT3(0.0f, 1.0f, 0.0f));
+		tessellation.Update(camera, 600.0f);
+
+		TerrainTessellationStatistics statistics = tessellation.GetStatistics();
+		triangleCount += statistics.triangleCount;
+		culledCount += statistics.culledPatchCount;
+		updateMilliseconds += statistics.updateMilliseconds;
+
+		const auto& planes = camera.GetFrustumPlanes();
+		for (uint32_t i = 0; i < countOfPatches; i++)
+		{
+			for (uint32_t j = 0; j < countOfPatches; j++)
+			{
+				const PatchTessFactors& factors = tessellation.GetPatchFactors(i * countOfPatches + j);
+				if (factors.edges[0] == 0.0f)
+				{
+					const TerrainPatchData& patch = patchDatas[i * countOfPatches + j];
+					std::uniform_real_distribution<float> pointX(patch.rect.x, patch.rect.z);
+					std::uniform_real_distribution<float> pointY(patch.minHeight, patch.maxHeight);
+					std::uniform_real_distribution<float> pointZ(patch.rect.y, patch.rect.w);
+					for (int k = 0; k < 20; k++)
+					{
+						float x = pointX(random);
+						float y = pointY(random);
+						float z = pointZ(random);
+						bool isInside = true;
+						for (const auto& plane : planes)
+							isInside &= plane.x * x + plane.y * y + plane.z * z + plane.w >= 0.0f;
+						CHECK(!isInside);
+					}
+					continue;
+				}
+
+				for (int edge = 0; edge < 4; edge++)
+					CHECK(factors.edges[edge] >= 1.0f && factors.edges[edge] <= 64.0f);
+				if (i + 1 < countOfPatches)
+				{
+					const PatchTessFactors& next = tessellation.GetPatchFactors((i + 1) * countOfPatches + j);
+					CHECK(next.edges[0] == 0.0f || factors.edges[2] == next.edges[0]);
+				}
+				if (j + 1 < countOfPatches)
+				{
+					const PatchTessFactors& next = tessellation.GetPatchFactors(i * countOfPatches + j + 1);
+					CHECK(next.edges[0] == 0.0f || factors.edges[3] == next.edges[1]);
+				}
+			}
+		}
+	}
+	CHECK(culledCount > 0);
+
+	// Closer edges and rougher edges get more tessellation, flat ones none.
+	TessellationConstant tessellationConstant = tessellation.GetTessellationConstant();
+	float nearFactor = TerrainTessellation::ComputeEdgeFactor(131.0f, 3.0f, 50.0f, tessellationConstant);
+	float farFactor = TerrainTessellation::ComputeEdgeFactor(131.0f, 3.0f, 500.0f, tessellationConstant);
+	float smoothFactor = TerrainTessellation::ComputeEdgeFactor(131.0f, 0.5f, 50.0f, tessellationConstant);
+	float flatFactor = TerrainTessellation::ComputeEdgeFactor(131.0f, 0.0f, 50.0f, tessellationConstant);
+	CHECK(nearFactor > farFactor && nearFactor > smoothFactor && flatFactor == 1.0f);
+
+	PatchTessFactors fixedFactors = { { 16.0f, 16.0f, 16.0f, 16.0f }, { 16.0f, 16.0f } };
+	uint32_t fixedTriangleCount = countOfPatches * countOfPatches * TerrainTessellation::CountTriangles(fixedFactors);
+	std::printf("flight: %.0f triangles per frame, %.1f%% of a fixed factor of 16, %.1f of %u patches culled, update %.3f ms\n",
+		static_cast<double>(triangleCount) / frameCount, 100.0 * triangleCount / frameCount / fixedTriangleCount,
+		static_cast<double>(culledCount) / frameCount, countOfPatches * countOfPatches, updateMilliseconds / frameCount);
+
+	std::printf("OK\n");
+	return 0;
+}
\ No newline at end of file
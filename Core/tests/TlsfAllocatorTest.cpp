@@ -0,0 +1,146 @@
+#include "../includes/TlsfAllocator.h"
+#include "TestUtility.h"
+#include <map>
+
+namespace
+{
+	// Allocate rounds the request up to the next second level size class, a free block at least this big
+	// always satisfies it.
+	uint32_t GetGuaranteedFitSize(uint32_t size)
+	{
+		if (size < TlsfAllocator::secondLevelCount)
+			return size;
+		uint32_t highestBit = 31;
+		while ((size >> highestBit) == 0)
+			highestBit--;
+		return size + (1u << (highestBit - TlsfAllocator::secondLevelBits));
+	}
+
+	void Fill(std::vector<uint8_t>& memory, uint32_t offset, uint32_t size)
+	{
+		for (uint32_t i = 0; i < size; i++)
+			memory[offset + i] = static_cast<uint8_t>(offset * 31 + i);
+	}
+	bool IsFilled(const std::vector<uint8_t>& memory, uint32_t offset, uint32_t originalOffset, uint32_t size)
+	{
+		for (uint32_t i = 0; i < size; i++)
+		{
+			if (memory[offset + i] != static_cast<uint8_t>(originalOffset * 31 + i))
+				return false;
+		}
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t operationCount = IsBenchmarkRun(argc, argv) ? 2000000 : 200000;
+	std::mt19937 random(7);
+
+	// Random allocations and frees against a map of the live ranges: no overlaps, nothing outside the
+	// capacity, and a failed allocation means no free block was big enough.
+	const uint32_t capacity = 1 << 20;
+	TlsfAllocator allocator(capacity);
+	std::map<uint32_t, uint32_t> live; // offset, size
+	std::map<uint32_t, uint32_t> originalOffsets; // offset, offset the contents were written at
+	std::vector<uint8_t> memory(capacity);
+	uint32_t failedCount = 0;
+	for (uint32_t operation = 0; operation < operationCount; operation++)
+	{
+		if (live.empty() || random() % 100 < 55)
+		{
+			uint32_t size = random() % 4 == 0 ? 1 + random() % 20000 : 1 + random() % 300;
+			uint32_t offset = allocator.Allocate(size);
+			if (offset == TlsfAllocator::invalidOffset)
+			{
+				CHECK(allocator.GetStatistics().largestFreeBlock < GetGuaranteedFitSize(size));
+				failedCount++;
+				continue;
+			}
+
+			CHECK(offset + size <= capacity);
+			auto next = live.lower_bound(offset);
+			CHECK(next == live.end() || next->first >= offset + size);
+			CHECK(next == live.begin() || std::prev(next)->first + std::prev(next)->second <= offset);
+			live[offset] = size;
+			originalOffsets[offset] = offset;
+			Fill(memory, offset, size);
+		}
+		else
+		{
+			auto allocation = live.begin();
+			std::advance(allocation, random() % live.size());
+			CHECK(allocator.GetAllocationSize(allocation->first) == allocation->second);
+			allocator.Free(allocation->first);
+			originalOffsets.erase(allocation->first);
+			live.erase(allocation);
+		}
+
+		if (operation % 10000 == 0)
+		{
+			uint64_t usedSize = 0;
+			for (const auto& allocation : live)
+				usedSize += allocation.second;
+			CHECK(usedSize == allocator.GetStatistics().usedSize);
+		}
+	}
+
+	// Defragment packs the allocations in offset order. Copying the moves in order keeps every allocation's contents.
+	TlsfAllocatorStatistics statistics = allocator.GetStatistics();
+	std::printf("%u operations, %u failed, %zu live, %u free blocks, fragmentation %.3f\n", operationCount, failedCount,
+		live.size(), statistics.freeBlockCount, statistics.fragmentation);
+	std::vector<TlsfMove> moves;
+	allocator.Defragment(moves);
+	for (const TlsfMove& move : moves)
+	{
+		CHECK(live.count(move.oldOffset) == 1 && live[move.oldOffset] == move.size && move.newOffset < move.oldOffset);
+		std::memmove(memory.data() + move.newOffset, memory.data() + move.oldOffset, move.size);
+	}
+
+	uint32_t packedOffset = 0;
+	for (const auto& allocation : live)
+	{
+		CHECK(allocator.GetAllocationSize(packedOffset) == allocation.second);
+		CHECK(IsFilled(memory, packedOffset, originalOffsets[allocation.first], allocation.second));
+		packedOffset += allocation.second;
+	}
+	statistics = allocator.GetStatistics();
+	CHECK(statistics.freeBlockCount == 1 && statistics.largestFreeBlock == capacity - packedOffset);
+	std::printf("defragment: %zu moves\n", moves.size());
+
+	// Freeing everything merges the free space back into one block, growing appends to it.
+	packedOffset = 0;
+	for (const auto& allocation : live)
+	{
+		allocator.Free(packedOffset);
+		packedOffset += allocation.second;
+	}
+	statistics = allocator.GetStatistics();
+	CHECK(statistics.freeBlockCount == 1 && statistics.largestFreeBlock == capacity && statistics.usedSize == 0);
+	allocator.Grow(2 * capacity);
+	CHECK(allocator.Allocate(2 * capacity) == 0);
+
+	TlsfAllocator big(1u << 26);
+	std::vector<uint32_t> offsets;
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t operation = 0; operation < operationCount; operation++)
+	{
+		if (offsets.size() < 5000 || random() % 2)
+		{
+			uint32_t offset = big.Allocate(1 + random() % 1000);
+			if (offset != TlsfAllocator::invalidOffset)
+				offsets.push_back(offset);
+		}
+		else
+		{
+			size_t i = random() % offsets.size();
+			big.Free(offsets[i]);
+			offsets[i] = offsets.back();
+			offsets.pop_back();
+		}
+	}
+	std::printf("%u mixed operations: %.1f ms\n", operationCount, MillisecondsSince(start));
+
+	std::printf("OK\n");
+	return 0;
+}
\ No newline at end of file
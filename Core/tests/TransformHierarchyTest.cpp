@@ -0,0 +1,97 @@
+#include "../includes/TransformHierarchy.h"
+#include "TestUtility.h"
+using namespace DirectX;
+
+namespace
+{
+	float MaxDifference(const XMFLOAT4X4& a, const XMFLOAT4X4& b)
+	{
+		float difference = 0.0f;
+		for (int row = 0; row < 4; row++)
+		{
+			for (int column = 0; column < 4; column++)
+				difference = std::max(difference, std::fabs(a.m[row][column] - b.m[row][column]));
+		}
+		return difference;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t nodeCount = IsBenchmarkRun(argc, argv) ? 100000 : 20000;
+
+	// Eight roots, every other node hangs off one of the 64 nodes before it.
+	std::mt19937 random(7);
+	TransformHierarchy serial;
+	TransformHierarchy parallel;
+	serial.Reserve(nodeCount);
+	parallel.Reserve(nodeCount);
+	std::vector<uint32_t> parents(nodeCount);
+	for (uint32_t i = 0; i < nodeCount; i++)
+	{
+		uint32_t parent = i < 8 ? TransformHierarchy::invalidNode :
+			std::uniform_int_distribution<uint32_t>(i > 64 ? i - 64 : 0, i - 1)(random);
+		parents[i] = parent;
+
+		XMFLOAT4X4 local;
+		XMStoreFloat4x4(&local, XMMatrixMultiply(XMMatrixRotationY(0.001f * i),
+			XMMatrixTranslation(0.01f, 0.02f * (i % 3), 0.0f)));
+		serial.AddNode(parent, local);
+		parallel.AddNode(parent, local);
+	}
+
+	JobSystem jobSystem(7);
+	CHECK(serial.UpdateWorldMatrices() == nodeCount);
+	CHECK(parallel.UpdateWorldMatrices(jobSystem) == nodeCount);
+	for (uint32_t i = 0; i < nodeCount; i++)
+		CHECK(MaxDifference(serial.GetWorld(i), parallel.GetWorld(i)) < 1.0e-5f);
+
+	// The world matrix of the deepest chain against the product of its locals.
+	XMMATRIX world = XMMatrixIdentity();
+	for (uint32_t node = nodeCount - 1; node != TransformHierarchy::invalidNode; node = parents[node])
+	{
+		XMFLOAT4X4 local = serial.GetLocal(node);
+		world = XMMatrixMultiply(world, XMLoadFloat4x4(&local));
+	}
+	XMFLOAT4X4 expectedWorld;
+	XMStoreFloat4x4(&expectedWorld, world);
+	CHECK(MaxDifference(expectedWorld, serial.GetWorld(nodeCount - 1)) < 1.0e-3f);
+
+	// Only the dirty node and its descendants are recomputed.
+	uint32_t dirtyNode = nodeCount / 2;
+	serial.SetLocal(dirtyNode, XMMatrixIdentity());
+	std::vector<uint8_t> isDescendant(nodeCount, 0);
+	isDescendant[dirtyNode] = 1;
+	uint32_t expectedCount = 1;
+	for (uint32_t i = dirtyNode + 1; i < nodeCount; i++)
+	{
+		if (parents[i] != TransformHierarchy::invalidNode && isDescendant[parents[i]])
+		{
+			isDescendant[i] = 1;
+			expectedCount++;
+		}
+	}
+	CHECK(serial.UpdateWorldMatrices() == expectedCount);
+	CHECK(serial.IsWorldChanged(dirtyNode) && !serial.IsWorldChanged(dirtyNode - 1));
+	CHECK(serial.UpdateWorldMatrices() == 0);
+
+	// Touching the roots updates every node.
+	auto benchmark = [&](const char* name, const std::function<void()>& update)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (int iteration = 0; iteration < 20; iteration++)
+		{
+			for (uint32_t i = 0; i < 8; i++)
+				parallel.SetLocal(i, parallel.GetLocal(i));
+			update();
+		}
+		double milliseconds = MillisecondsSince(start) / 20.0;
+		std::printf("%s: %.2f ms for %u nodes, %.1f M nodes/s\n", name, milliseconds, nodeCount,
+			nodeCount / milliseconds / 1000.0);
+	};
+	benchmark("serial", [&]() { parallel.UpdateWorldMatrices(); });
+	benchmark("parallel", [&]() { parallel.UpdateWorldMatrices(jobSystem); });
+
+	std::printf("OK\n");
+	return 0;
+}
\ No newline at end of file
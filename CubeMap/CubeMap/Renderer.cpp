@@ -165,15 +165,15 @@ void Renderer::Initialize()
 	// Create vertex and pixel shader
 	std::unique_ptr<Shader> vertexShader = std::make_unique<Shader>();
 	std::unique_ptr<Shader> pixelShader = std::make_unique<Shader>();
-	vertexShader->CompileShader(L"../../Shaders/opaque.hlsl", nullptr, "VSMain", "vs_5_1");
-	pixelShader->CompileShader(L"../../Shaders/opaque.hlsl", nullptr, "PSMain", "ps_5_1");
+	vertexShader->CompileShader(L"../../Shaders/opaque.hlsl", nullptr, "VSMain", "vs_5_1", &mShaderCache);
+	pixelShader->CompileShader(L"../../Shaders/opaque.hlsl", nullptr, "PSMain", "ps_5_1", &mShaderCache);
 	mShaders.insert({ "opaqueVS", std::move(vertexShader) });
 	mShaders.insert({ "opaquePS", std::move(pixelShader) });
 
 	auto skyVertexShader = std::make_unique<Shader>();
 	auto skyPixelShader = std::make_unique<Shader>();
-	skyVertexShader->CompileShader(L"../../Shaders/sky.hlsl", nullptr, "VSMain", "vs_5_1");
-	skyPixelShader->CompileShader(L"../../Shaders/sky.hlsl", nullptr, "PSMain", "ps_5_1");
+	skyVertexShader->CompileShader(L"../../Shaders/sky.hlsl", nullptr, "VSMain", "vs_5_1", &mShaderCache);
+	skyPixelShader->CompileShader(L"../../Shaders/sky.hlsl", nullptr, "PSMain", "ps_5_1", &mShaderCache);
 	mShaders.insert({ "skyVS", std::move(skyVertexShader) });
 	mShaders.insert({ "skyPS", std::move(skyPixelShader) });
 
@@ -563,14 +563,10 @@ void Renderer::UpdateSceneConstants()
 {
 	SceneConstant sceneConstant;
 
-	XMFLOAT4X4 view = mCamera->GetView();
-	XMFLOAT4X4 proj = mCamera->GetProj();
-
-	XMMATRIX v = XMLoadFloat4x4(&view);
-	XMMATRIX p = XMLoadFloat4x4(&proj);
-
-	XMStoreFloat4x4(&sceneConstant.view, XMMatrixTranspose(v));
-	XMStoreFloat4x4(&sceneConstant.proj, XMMatrixTranspose(p));
+	XMStoreFloat4x4(&sceneConstant.view, XMMatrixTranspose(XMLoadFloat4x4(&mCamera->GetView())));
+	XMStoreFloat4x4(&sceneConstant.proj, XMMatrixTranspose(XMLoadFloat4x4(&mCamera->GetProj())));
+	XMStoreFloat4x4(&sceneConstant.viewProj, XMMatrixTranspose(XMLoadFloat4x4(&mCamera->GetViewProj())));
+	XMStoreFloat4x4(&sceneConstant.invView, XMMatrixTranspose(XMLoadFloat4x4(&mCamera->GetInverseView())));
 
 	sceneConstant.cameraPosition = mCamera->GetPosition();
 
@@ -874,7 +870,8 @@ void Renderer::BuildRenderItems()
 	{
 		std::string meshName = "MinatoAqua" + std::to_string(i);
 		renderItem.mesh = mMeshes[meshName].get();
-		world = XMMatrixMultiply(scalingMatrix, rotationMatrix);
+		XMFLOAT4X4 meshWorld = mMinatoAqua->GetMeshWorld(i);
+		world = XMMatrixMultiply(XMLoadFloat4x4(&meshWorld), XMMatrixMultiply(scalingMatrix, rotationMatrix));
 		XMStoreFloat4x4(&renderItem.world, world);
 		renderItem.objectCBIndex = i + 3;
 		renderItem.diffuseMapIndex = i + 3;
@@ -8,6 +8,7 @@
 #include "../../Core/Includes/Mesh.h"
 #include "../../Core/Includes/Model.h"
 #include "../../Core/Includes/Shader.h"
+#include "../../Core/Includes/ShaderCache.h"
 #include "../../Core/Includes/Stdafx.h"
 #include "../../Core/Includes/SwapChain.h"
 #include "../../Core/Includes/Texture.h"
@@ -76,9 +77,11 @@ struct SceneConstant
 {
 	DirectX::XMFLOAT4X4 view;
 	DirectX::XMFLOAT4X4 proj;
+	DirectX::XMFLOAT4X4 viewProj;
+	DirectX::XMFLOAT4X4 invView;
 
 	DirectX::XMFLOAT3 cameraPosition;
-	float pad0;
+	float farDepth = 1.0f;
 
 	DirectX::XMFLOAT4 ambientLight;
 	std::array<Light, Light::maxNumLights> lights;
@@ -165,6 +168,7 @@ private:
 	std::unique_ptr<CbvSrvUavDescriptor> mCbvSrvUavDescriptor;
 
 	std::unordered_map<std::string, std::unique_ptr<Shader>> mShaders;
+	ShaderCache mShaderCache{ "ShaderCache" }; // bytecode of previous runs
 
 	std::unordered_map<std::string, RootSignature> mRootSignatures; // default count is 1
 	std::unordered_map<std::string, PipelineStateObject> mPSOs; // default count is 1
@@ -94,15 +94,15 @@ void Renderer::Initialize()
 
 	// Create meshes
 	BasicGeometryGenerator geoGenerator;
-	auto box = geoGenerator.CreateBox(2.0f, 2.0f, 2.0f);
+	Mesh box = geoGenerator.CreateBox(2.0f, 2.0f, 2.0f);
 	box.ConfigureMesh(device, commandList);
 	mMeshes.insert({ "box", std::move(box) });
 
-	auto grid = geoGenerator.CreateGrid(10.0f, 20.0f, 10, 20);
+	Mesh grid = geoGenerator.CreateGrid(10.0f, 20.0f, 10, 20);
 	grid.ConfigureMesh(device, commandList);
 	mMeshes.insert({ "grid", std::move(grid) });
 
-	auto sphere = geoGenerator.CreateSphere(0.5f, 20, 20);
+	Mesh sphere = geoGenerator.CreateSphere(0.5f, 20, 20);
 	sphere.ConfigureMesh(device, commandList);
 	mMeshes.insert({ "sphere", std::move(sphere) });
 
@@ -601,14 +601,10 @@ void Renderer::UpdateSceneConstants()
 
 	SceneConstant sceneConstant;
 
-	XMFLOAT4X4 view = mCamera.GetView();
-	XMFLOAT4X4 proj = mCamera.GetProj();
-
-	XMMATRIX v = XMLoadFloat4x4(&view);
-	XMMATRIX p = XMLoadFloat4x4(&proj);
-
-	XMStoreFloat4x4(&sceneConstant.view, XMMatrixTranspose(v));
-	XMStoreFloat4x4(&sceneConstant.proj, XMMatrixTranspose(p));
+	XMStoreFloat4x4(&sceneConstant.view, XMMatrixTranspose(XMLoadFloat4x4(&mCamera.GetView())));
+	XMStoreFloat4x4(&sceneConstant.proj, XMMatrixTranspose(XMLoadFloat4x4(&mCamera.GetProj())));
+	XMStoreFloat4x4(&sceneConstant.viewProj, XMMatrixTranspose(XMLoadFloat4x4(&mCamera.GetViewProj())));
+	XMStoreFloat4x4(&sceneConstant.invView, XMMatrixTranspose(XMLoadFloat4x4(&mCamera.GetInverseView())));
 
 	sceneConstant.cameraPosition = mCamera.GetPosition();
 
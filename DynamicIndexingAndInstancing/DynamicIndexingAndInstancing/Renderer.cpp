@@ -65,10 +65,14 @@ void Renderer::Initialize()
 	auto commandList = mCommandObject.GetCommandList();
 	auto commandQueue = mCommandObject.GetCommandQueue();
 
+	mStateTracker.SetCommandList(commandList);
+	mStateSubmitter = std::make_unique<D3D12ResourceStateSubmitter>(device, commandQueue);
+
 	// Create swap chain and back buffer
 	mSwapChain.CreateSwapChain(mDirect3D.GetFactory(),
 		commandQueue, mhWnd,
 		mViewportWidth, mViewportHeight);
+	RegisterBackBuffers();
 
 	// Create depth stencil buffer
 	mDepthStencil.CreateDepthStencilBuffer(device,
@@ -89,15 +93,15 @@ void Renderer::Initialize()
 
 	// Create meshes
 	BasicGeometryGenerator geoGenerator;
-	auto box = geoGenerator.CreateBox(2.0f, 2.0f, 2.0f);
+	Mesh box = geoGenerator.CreateBox(2.0f, 2.0f, 2.0f);
 	box.ConfigureMesh(device, commandList);
 	mMeshes.insert({ "box", std::move(box) });
 
-	auto grid = geoGenerator.CreateGrid(10.0f, 20.0f, 10, 20);
+	Mesh grid = geoGenerator.CreateGrid(10.0f, 20.0f, 10, 20);
 	grid.ConfigureMesh(device, commandList);
 	mMeshes.insert({ "grid", std::move(grid) });
 
-	auto sphere = geoGenerator.CreateSphere(0.5f, 20, 20);
+	Mesh sphere = geoGenerator.CreateSphere(0.5f, 20, 20);
 	sphere.ConfigureMesh(device, commandList);
 	mMeshes.insert({ "sphere", std::move(sphere) });
 
@@ -131,25 +135,22 @@ void Renderer::Initialize()
 	mCbvSrvUavDescriptor.CreateShaderResourceView(device, mDirect3D.GetCbvSrvUavDescriptorSize(),
 		skyboxTexture->GetDesc().Format, D3D12_SRV_DIMENSION_TEXTURECUBE, skyboxTexture);
 
-	// Create vertex and pixel shader
-	Shader vertexShader;
-	Shader pixelShader; 
-	vertexShader.CompileShader(L"../../Shaders/dynamicIndexing.hlsl", nullptr, "VSMain", "vs_5_1");
-	pixelShader.CompileShader(L"../../Shaders/dynamicIndexing.hlsl", nullptr, "PSMain", "ps_5_1");
-	mShaders.insert({ "opaqueVS", std::move(vertexShader) });
-	mShaders.insert({ "opaquePS", std::move(pixelShader) });
-
-	Shader instancingVertexShader;
-	Shader instancingPixelShader;
-	instancingVertexShader.CompileShader(L"../../Shaders/instancing.hlsl", nullptr, "VSMain", "vs_5_1");
-	instancingPixelShader.CompileShader(L"../../Shaders/instancing.hlsl", nullptr, "PSMain", "ps_5_1");
-	mShaders.insert({ "instancingVS", std::move(instancingVertexShader) });
-	mShaders.insert({ "instancingPS", std::move(instancingPixelShader) });
+	// Create vertex and pixel shader, the lit ones are permutations of default.hlsl
+	uint32_t defaultVS = mDefaultShaders.AddStage("VSMain", "vs_5_1");
+	uint32_t defaultPS = mDefaultShaders.AddStage("PSMain", "ps_5_1");
+
+	uint32_t dynamicIndexing = mDefaultShaders.GetFeatureBit("DYNAMIC_INDEXING");
+	mShaders.insert({ "opaqueVS", mDefaultShaders.GetShader(defaultVS, dynamicIndexing) });
+	mShaders.insert({ "opaquePS", mDefaultShaders.GetShader(defaultPS, dynamicIndexing) });
+
+	uint32_t instancing = mDefaultShaders.GetFeatureBit("INSTANCING");
+	mShaders.insert({ "instancingVS", mDefaultShaders.GetShader(defaultVS, instancing) });
+	mShaders.insert({ "instancingPS", mDefaultShaders.GetShader(defaultPS, instancing) });
 
 	Shader skyVertexShader;
 	Shader skyPixelShader;
-	skyVertexShader.CompileShader(L"../../Shaders/sky.hlsl", nullptr, "VSMain", "vs_5_1");
-	skyPixelShader.CompileShader(L"../../Shaders/sky.hlsl", nullptr, "PSMain", "ps_5_1");
+	skyVertexShader.CompileShader(L"../../Shaders/sky.hlsl", nullptr, "VSMain", "vs_5_1", &mShaderCache);
+	skyPixelShader.CompileShader(L"../../Shaders/sky.hlsl", nullptr, "PSMain", "ps_5_1", &mShaderCache);
 	mShaders.insert({ "skyVS", std::move(skyVertexShader) });
 	mShaders.insert({ "skyPS", std::move(skyPixelShader) });
 
@@ -161,7 +162,7 @@ void Renderer::Initialize()
 
 	BuildRenderItems();
 
-	ExecuteCommandLists(commandList, commandQueue);
+	ExecuteCommandLists();
 
 	mDirect3D.WaitForPreviousFrame(commandQueue);
 }
@@ -388,7 +389,9 @@ void Renderer::Resize()
 	mDirect3D.WaitForPreviousFrame(commandQueue);
 
 	// Resize back buffer
+	UnregisterBackBuffers();
 	mSwapChain.ResizeBackBuffers(mWindowWidth, mWindowHeight);
+	RegisterBackBuffers();
 	
 	mRtvDescriptor.ResetDescriptorHeap();
 	for (UINT i = 0; i < mSwapChain.GetBackBufferCount(); i++)
@@ -405,12 +408,19 @@ void Renderer::Resize()
 	ConfigureViewportAndScissorRect();
 }
 
-void Renderer::ExecuteCommandLists(ID3D12GraphicsCommandList* commandList, 
-	ID3D12CommandQueue* commandQueue)
+void Renderer::ExecuteCommandLists()
+{
+	mStateSubmitter->ExecuteCommandList(mStateTracker);
+}
+void Renderer::RegisterBackBuffers()
+{
+	for (UINT i = 0; i < mSwapChain.GetBackBufferCount(); i++)
+		D3D12ResourceStateTracker::RegisterResource(mSwapChain.GetBackBuffer(i), D3D12_RESOURCE_STATE_PRESENT);
+}
+void Renderer::UnregisterBackBuffers()
 {
-	ThrowIfFailed(commandList->Close());
-	ID3D12CommandList* commandLists[] = { commandList };
-	commandQueue->ExecuteCommandLists(_countof(commandLists), commandLists);
+	for (UINT i = 0; i < mSwapChain.GetBackBufferCount(); i++)
+		D3D12ResourceStateTracker::UnregisterResource(mSwapChain.GetBackBuffer(i));
 }
 
 void Renderer::MouseDown(WPARAM btnState, int x, int y)
@@ -474,12 +484,14 @@ void Renderer::DrawScene()
 	ThrowIfFailed(commandAllocator->Reset());
 
 	ThrowIfFailed(commandList->Reset(commandAllocator, mPSOs["opaque"].Get()));
+	mStateTracker.SetCommandList(commandList);
 
 	commandList->RSSetScissorRects(1, &mScissorRect);
 	commandList->RSSetViewports(1, &mScreenViewport);
 
-	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(currentBackBuffer,
-		D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET));
+	// The back buffer's first use, its PRESENT -> RENDER_TARGET barrier is added when the list is submitted.
+	mStateTracker.TransitionResource(currentBackBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	mStateTracker.FlushResourceBarriers();
 
 	D3D12_CPU_DESCRIPTOR_HANDLE currentRenderTargetView =
 		CD3DX12_CPU_DESCRIPTOR_HANDLE(mRtvDescriptor.GetStartCPUDescriptorHandle(), 
@@ -514,10 +526,10 @@ void Renderer::DrawScene()
 	commandList->SetPipelineState(mPSOs["instancing"].Get());
 	DrawRenderItems(RenderLayer::Instancing, commandList);
 
-	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(currentBackBuffer,
-		D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
+	mStateTracker.TransitionResource(currentBackBuffer, D3D12_RESOURCE_STATE_PRESENT);
+	mStateTracker.FlushResourceBarriers();
 
-	ExecuteCommandLists(commandList, commandQueue);
+	ExecuteCommandLists();
 
 	ThrowIfFailed(mSwapChain.GetSwapChain()->Present(0, 0));
 	mSwapChain.SwitchBackBuffer();
@@ -551,14 +563,10 @@ void Renderer::UpdateSceneConstants()
 {
 	SceneConstant sceneConstant;
 
-	XMFLOAT4X4 view = mCamera.GetView();
-	XMFLOAT4X4 proj = mCamera.GetProj();
-
-	XMMATRIX v = XMLoadFloat4x4(&view);
-	XMMATRIX p = XMLoadFloat4x4(&proj);
-
-	XMStoreFloat4x4(&sceneConstant.view, XMMatrixTranspose(v));
-	XMStoreFloat4x4(&sceneConstant.proj, XMMatrixTranspose(p));
+	XMStoreFloat4x4(&sceneConstant.view, XMMatrixTranspose(XMLoadFloat4x4(&mCamera.GetView())));
+	XMStoreFloat4x4(&sceneConstant.proj, XMMatrixTranspose(XMLoadFloat4x4(&mCamera.GetProj())));
+	XMStoreFloat4x4(&sceneConstant.viewProj, XMMatrixTranspose(XMLoadFloat4x4(&mCamera.GetViewProj())));
+	XMStoreFloat4x4(&sceneConstant.invView, XMMatrixTranspose(XMLoadFloat4x4(&mCamera.GetInverseView())));
 
 	sceneConstant.cameraPosition = mCamera.GetPosition();
 
@@ -765,23 +773,26 @@ void Renderer::LoadTextures()
 
 	Texture woodTexture;
 	std::string texName = "wood";
-	woodTexture.CreateTexture(device, commandList, texName.c_str(), L"../../Textures/wood.dds");
+	woodTexture.CreateTexture(device, commandList, texName.c_str(), L"../../Textures/wood.dds", &mStateTracker);
 	mTextures.insert({ texName, std::move(woodTexture) });
 
 	Texture trinketTexture;
 	texName = "trinket";
-	trinketTexture.CreateTexture(device, commandList, texName.c_str(), L"../../Textures/trinket.dds");
+	trinketTexture.CreateTexture(device, commandList, texName.c_str(), L"../../Textures/trinket.dds", &mStateTracker);
 	mTextures.insert({ texName, std::move(trinketTexture) });
 
 	Texture aquaTexture;
 	texName = "aqua";
-	aquaTexture.CreateTexture(device, commandList, texName.c_str(), L"../../Textures/aqua.dds");
+	aquaTexture.CreateTexture(device, commandList, texName.c_str(), L"../../Textures/aqua.dds", &mStateTracker);
 	mTextures.insert({ texName, std::move(aquaTexture) });
 
 	Texture skyTexture;
 	texName = "sky";
-	skyTexture.CreateTexture(device, commandList, texName.c_str(), L"../../Textures/yokohama2.dds");
+	skyTexture.CreateTexture(device, commandList, texName.c_str(), L"../../Textures/yokohama2.dds", &mStateTracker);
 	mTextures.insert({ texName, std::move(skyTexture) });
+
+	// The last texture's transition to PIXEL_SHADER_RESOURCE, the others went out with the flush of the next one.
+	mStateTracker.FlushResourceBarriers();
 }
 void Renderer::BuildMaterials()
 {
@@ -2,12 +2,15 @@
 #include "../../Core/includes/BasicGeometryGenerator.h"
 #include "../../Core/includes/Camera.h"
 #include "../../Core/includes/Command.h"
+#include "../../Core/includes/D3D12ResourceStateTracker.h"
 #include "../../Core/includes/DepthStencil.h"
 #include "../../Core/includes/Descriptor.h"
 #include "../../Core/includes/Direct3d.h"
 #include "../../Core/includes/Mesh.h"
 #include "../../Core/includes/Model.h"
 #include "../../Core/includes/Shader.h"
+#include "../../Core/includes/ShaderCache.h"
+#include "../../Core/includes/ShaderPermutations.h"
 #include "../../Core/includes/Stdafx.h"
 #include "../../Core/includes/SwapChain.h"
 #include "../../Core/includes/Texture.h"
@@ -69,9 +72,11 @@ struct SceneConstant
 {
 	DirectX::XMFLOAT4X4 view;
 	DirectX::XMFLOAT4X4 proj;
+	DirectX::XMFLOAT4X4 viewProj;
+	DirectX::XMFLOAT4X4 invView;
 
 	DirectX::XMFLOAT3 cameraPosition;
-	float pad0;
+	float farDepth = 1.0f;
 
 	DirectX::XMFLOAT4 ambientLight;
 	std::array<Light, Light::maxNumLights> lights;
@@ -127,8 +132,9 @@ private:
 
 	void Resize();
 
-	void ExecuteCommandLists(ID3D12GraphicsCommandList* commandList,
-		ID3D12CommandQueue* commandQueue);
+	void ExecuteCommandLists();
+	void RegisterBackBuffers();
+	void UnregisterBackBuffers();
 
 	void MouseDown(WPARAM btnState, int x, int y);
 	void MouseUp(WPARAM btnState, int x, int y);
@@ -172,6 +178,9 @@ private:
 
 	BasicDirect3DComponent mDirect3D;
 	Command mCommandObject;
+	// Barriers of mCommandObject's list, the first uses of every frame are resolved when it is submitted.
+	D3D12ResourceStateTracker mStateTracker;
+	std::unique_ptr<D3D12ResourceStateSubmitter> mStateSubmitter = nullptr;
 	SwapChain mSwapChain;
 	DepthStencil mDepthStencil;
 
@@ -180,6 +189,9 @@ private:
 	CbvSrvUavDescriptor mCbvSrvUavDescriptor;
 
 	std::unordered_map<std::string, Shader> mShaders;
+	ShaderCache mShaderCache{ "ShaderCache" }; // bytecode of previous runs
+	ShaderPermutations mDefaultShaders{ L"../../Shaders/default.hlsl",
+		{ "INSTANCING", "DYNAMIC_INDEXING", "ALPHA_TEST" }, &mShaderCache };
 
 	std::unordered_map<std::string, RootSignature> mRootSignatures; // default count is 1
 	std::unordered_map<std::string, PipelineStateObject> mPSOs; // default count is 1
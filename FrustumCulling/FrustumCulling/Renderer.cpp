@@ -91,15 +91,15 @@ void Renderer::Initialize()
 
 	// Create meshes
 	BasicGeometryGenerator geoGenerator;
-	auto box = geoGenerator.CreateBox(2.0f, 2.0f, 2.0f);
+	Mesh box = geoGenerator.CreateBox(2.0f, 2.0f, 2.0f);
 	box.ConfigureMesh(device, commandList);
 	mMeshes.insert({ "box", std::move(box) });
 
-	auto grid = geoGenerator.CreateGrid(10.0f, 20.0f, 10, 20);
+	Mesh grid = geoGenerator.CreateGrid(10.0f, 20.0f, 10, 20);
 	grid.ConfigureMesh(device, commandList);
 	mMeshes.insert({ "grid", std::move(grid) });
 
-	auto sphere = geoGenerator.CreateSphere(0.5f, 20, 20);
+	Mesh sphere = geoGenerator.CreateSphere(0.5f, 20, 20);
 	sphere.ConfigureMesh(device, commandList);
 	mMeshes.insert({ "sphere", std::move(sphere) });
 
@@ -549,10 +549,7 @@ void Renderer::UpdateObjectConstants()
 	ObjectConstant objectConstant;
 	UINT elementIndex = 0;
 
-	XMMATRIX view = XMLoadFloat4x4(&mCamera.GetView());
-
-	XMVECTOR determinant = XMMatrixDeterminant(view);
-	XMMATRIX inverseView = XMMatrixInverse(&determinant, view);
+	XMMATRIX inverseView = XMLoadFloat4x4(&mCamera.GetInverseView());
 
 	for (const auto& renderItems : mAllRenderItems)
 	{
@@ -560,7 +557,7 @@ void Renderer::UpdateObjectConstants()
 		{
 			XMMATRIX world = XMLoadFloat4x4(&renderItem.world);
 
-			determinant = XMMatrixDeterminant(world);
+			XMVECTOR determinant = XMMatrixDeterminant(world);
 			XMMATRIX inverseWorld = XMMatrixInverse(&determinant, world);
 
 			XMMATRIX viewToLocal = XMMatrixMultiply(inverseWorld, inverseView);
@@ -582,14 +579,10 @@ void Renderer::UpdateSceneConstants()
 {
 	SceneConstant sceneConstant;
 
-	XMFLOAT4X4 view = mCamera.GetView();
-	XMFLOAT4X4 proj = mCamera.GetProj();
-
-	XMMATRIX v = XMLoadFloat4x4(&view);
-	XMMATRIX p = XMLoadFloat4x4(&proj);
-
-	XMStoreFloat4x4(&sceneConstant.view, XMMatrixTranspose(v));
-	XMStoreFloat4x4(&sceneConstant.proj, XMMatrixTranspose(p));
+	XMStoreFloat4x4(&sceneConstant.view, XMMatrixTranspose(XMLoadFloat4x4(&mCamera.GetView())));
+	XMStoreFloat4x4(&sceneConstant.proj, XMMatrixTranspose(XMLoadFloat4x4(&mCamera.GetProj())));
+	XMStoreFloat4x4(&sceneConstant.viewProj, XMMatrixTranspose(XMLoadFloat4x4(&mCamera.GetViewProj())));
+	XMStoreFloat4x4(&sceneConstant.invView, XMMatrixTranspose(XMLoadFloat4x4(&mCamera.GetInverseView())));
 
 	sceneConstant.cameraPosition = mCamera.GetPosition();
 
@@ -621,10 +614,7 @@ void Renderer::UpdateInstanceDatas()
 	InstanceData instanceData;
 	UINT elementIndex = 0;
 
-	XMMATRIX view = XMLoadFloat4x4(&mCamera.GetView());
-
-	XMVECTOR determinant = XMMatrixDeterminant(view);
-	XMMATRIX inverseView = XMMatrixInverse(&determinant, view);
+	XMMATRIX inverseView = XMLoadFloat4x4(&mCamera.GetInverseView());
 
 	for (const auto& renderItems : mAllRenderItems)
 	{
@@ -637,7 +627,7 @@ void Renderer::UpdateInstanceDatas()
 					XMMATRIX world = XMLoadFloat4x4(&renderItem.instanceDatas[i].world);
 					
 
-					determinant = XMMatrixDeterminant(world);
+					XMVECTOR determinant = XMMatrixDeterminant(world);
 					XMMATRIX inverseWorld = XMMatrixInverse(&determinant, world);
 
 					XMMATRIX viewToLocal = XMMatrixMultiply(inverseWorld, inverseView);
@@ -65,7 +65,7 @@ float3 ComputePointLight(Light light, Material mat, float3 pos,
     float3 normal, float3 toEye)
 {
     // The vector from the surface to the light.
-    float3 lightVec = normalize(light.position - pos);
+    float3 lightVec = light.position - pos;
     
     // The distance from surface to light.
     float d = length(lightVec);
@@ -82,7 +82,7 @@ float3 ComputePointLight(Light light, Material mat, float3 pos,
     float3 lightStrength = light.strength * ndotl;
     
     // Attenuate light by distance.
-    float att = CalcAttenuation(d, light.falloffStart, light.falloffEnd);
+    float att = CalcAttenuation(d, light.falloffEnd, light.falloffStart);
     lightStrength *= att;
     
     return BlinnPhong(lightStrength, lightVec, normal, toEye, mat);
@@ -91,7 +91,7 @@ float3 ComputePointLight(Light light, Material mat, float3 pos,
 float3 ComputeSpotLight(Light light, Material mat, float3 pos, float3 normal, float3 toEye)
 {
     // The vector from the surface to the light.
-    float3 lightVec = normalize(light.position - pos);
+    float3 lightVec = light.position - pos;
 
     // The distance from surface to light.
     float d = length(lightVec);
@@ -108,7 +108,7 @@ float3 ComputeSpotLight(Light light, Material mat, float3 pos, float3 normal, fl
     float3 lightStrength = light.strength * ndotl;
 
     // Attenuate light by distance.
-    float att = CalcAttenuation(d, light.falloffStart, light.falloffEnd);
+    float att = CalcAttenuation(d, light.falloffEnd, light.falloffStart);
     lightStrength *= att;
 
     // Scale by spotlight
@@ -22,8 +22,10 @@ cbuffer cbScene : register(b1)
 {
     float4x4 gView;
     float4x4 gProj;
+    float4x4 gViewProj;
+    float4x4 gInvView;
     float3 cameraPosition;
-    float pad0;
+    float gFarDepth;
     float4 gAmbientLight;
     
     Light gLights[MaxLights];
@@ -54,10 +56,111 @@ StructuredBuffer<InstanceData> gInstanceDatas : register(t1, space1);
 Texture2D gDiffuseTexture : register(t0);
 TextureCube gSkyBox : register(t1);
 
+#if CLUSTERED_LIGHTING
+// Point and spot lights assigned to view frustum clusters by ClusteredLightCuller on the CPU.
+struct LightCluster
+{
+    uint offset;
+    uint count;
+};
+
+cbuffer cbClusters : register(b3)
+{
+    uint3 gClusterCount;
+    float gClusterDepthScale;
+    float2 gClusterTileScale;
+    float gClusterDepthBias;
+    float clusterPad0;
+};
+
+StructuredBuffer<Light> gClusterLights : register(t2, space1);
+StructuredBuffer<LightCluster> gLightClusters : register(t3, space1);
+StructuredBuffer<uint> gClusterLightIndices : register(t4, space1);
+#endif
+
+#if SHADOWS
+// Cascaded shadow maps of gLights[0], fitted on the CPU by CascadedShadows.
+#define MaxCascades 4
+
+cbuffer cbShadow : register(b4)
+{
+    float4x4 gShadowTransforms[MaxCascades];
+    float4 gCascadeSplits;
+    float4 gCascadeTexelSizes;
+    uint gCascadeCount;
+    float gShadowMapTexelSize;
+    float2 shadowPad0;
+};
+
+Texture2DArray gShadowMap : register(t3);
+#endif
+
 SamplerState gsamPointWrap : register(s0);
 SamplerState gsamPointClamp : register(s1);
 SamplerState gsamLinearWrap : register(s2);
 SamplerState gsamLinearClamp : register(s3);
 SamplerState gsamAnisotropicWrap : register(s4);
 SamplerState gsamAnisotropicClamp : register(s5);
-SamplerComparisonState gsamShadow : register(s6);
\ No newline at end of file
+SamplerComparisonState gsamShadow : register(s6);
+
+#if CLUSTERED_LIGHTING
+// Lights with spotPower > 0 are spot lights, the others point lights.
+float3 ComputeClusteredLighting(float4 posH, float3 posW, Material mat, float3 normal, float3 toEye)
+{
+    float viewZ = mul(float4(posW, 1.0f), gView).z;
+    
+    uint3 cluster;
+    cluster.xy = min(uint2(posH.xy * gClusterTileScale), gClusterCount.xy - 1);
+    cluster.z = (uint) clamp(log(viewZ) * gClusterDepthScale + gClusterDepthBias, 0.0f, gClusterCount.z - 1);
+    
+    LightCluster lightCluster = gLightClusters[(cluster.z * gClusterCount.y + cluster.y) * gClusterCount.x + cluster.x];
+    
+    float3 result = 0.0f;
+    for (uint i = 0; i < lightCluster.count; ++i)
+    {
+        Light light = gClusterLights[gClusterLightIndices[lightCluster.offset + i]];
+        
+        if (light.spotPower > 0.0f)
+            result += ComputeSpotLight(light, mat, posW, normal, toEye);
+        else
+            result += ComputePointLight(light, mat, posW, normal, toEye);
+    }
+    
+    return result;
+}
+#endif
+
+#if SHADOWS
+// 1 when lit, 0 in shadow. The cascade is picked by view depth, the position is pushed along the normal
+// by a texel of that cascade against acne on slopes, then 3x3 comparison samples are averaged.
+float CalcShadowFactor(float3 posW, float3 normalW)
+{
+    float viewZ = mul(float4(posW, 1.0f), gView).z;
+    if (viewZ > gCascadeSplits[gCascadeCount - 1])
+        return 1.0f;
+    
+    uint cascade = 0;
+    while (cascade < gCascadeCount - 1 && viewZ > gCascadeSplits[cascade])
+        ++cascade;
+    
+    float3 offsetPosW = posW + normalW * (1.5f * gCascadeTexelSizes[cascade]);
+    float4 shadowPosH = mul(float4(offsetPosW, 1.0f), gShadowTransforms[cascade]);
+    
+    // Past the far side of the cascade there are no casters behind the pixel.
+    float depth = saturate(shadowPosH.z);
+    
+    float percentLit = 0.0f;
+    [unroll]
+    for (int y = -1; y <= 1; ++y)
+    {
+        [unroll]
+        for (int x = -1; x <= 1; ++x)
+        {
+            float2 texC = shadowPosH.xy + float2(x, y) * gShadowMapTexelSize;
+            percentLit += gShadowMap.SampleCmpLevelZero(gsamShadow, float3(texC, cascade), depth).r;
+        }
+    }
+    
+    return percentLit / 9.0f;
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,122 @@
+// Lit geometry shader shared by every sample. Variants are selected with the feature defines below
+// (see ShaderPermutations), disabled features are compiled out instead of branched over.
+//   INSTANCING       : world matrix and material index come from gInstanceDatas[SV_InstanceID]
+//   DYNAMIC_INDEXING : material comes from gMaterialDatas[materialIndex] of cbPerObject
+//   ALPHA_TEST       : discards pixels with diffuse alpha below 0.1
+//   CLUSTERED_LIGHTING : adds the point/spot lights of the pixel's cluster (see ClusteredLightCuller)
+//   SHADOWS          : gLights[0] is shadowed by the cascaded shadow maps (see CascadedShadows)
+// Without INSTANCING and DYNAMIC_INDEXING the material comes from cbMaterial.
+#ifndef INSTANCING
+    #define INSTANCING 0
+#endif
+
+#ifndef DYNAMIC_INDEXING
+    #define DYNAMIC_INDEXING 0
+#endif
+
+#ifndef ALPHA_TEST
+    #define ALPHA_TEST 0
+#endif
+
+#ifndef CLUSTERED_LIGHTING
+    #define CLUSTERED_LIGHTING 0
+#endif
+
+#ifndef SHADOWS
+    #define SHADOWS 0
+#endif
+
+#include "common.hlsl"
+
+struct VertexIn
+{
+    float3 PosL : POSITION;
+    float3 NormalL : NORMAL;
+    float2 TexC : TEXCOORD;
+};
+
+struct VertexOut
+{
+    float4 PosH : SV_POSITION;
+    float3 PosW : POSITION;
+    float3 NormalW : NORMAL;
+    float2 TexC : TEXCOORD;
+    
+#if INSTANCING
+    nointerpolation uint materialIndex : MATINDEX;
+#endif
+};
+
+#if INSTANCING
+VertexOut VSMain(VertexIn vin, uint instanceID : SV_InstanceID)
+#else
+VertexOut VSMain(VertexIn vin)
+#endif
+{
+    VertexOut vout = (VertexOut) 0.0f;
+    
+#if INSTANCING
+    InstanceData instanceData = gInstanceDatas[instanceID];
+    float4x4 world = instanceData.world;
+    vout.materialIndex = instanceData.materialIndex;
+#else
+    float4x4 world = gWorld;
+#endif
+    
+    vout.PosW = (float3) (mul(float4(vin.PosL, 1.0f), world));
+    
+    vout.PosH = mul(float4(vout.PosW, 1.0), gViewProj);
+    vout.NormalW = mul(vin.NormalL, (float3x3) world);
+    vout.TexC = vin.TexC;
+    
+    return vout;
+}
+
+float4 PSMain(VertexOut pin) : SV_Target
+{
+    float4 diffuseAlbedo = gDiffuseTexture.Sample(gsamAnisotropicWrap, pin.TexC);
+    
+#if INSTANCING || DYNAMIC_INDEXING
+#if INSTANCING
+    MaterialData matData = gMaterialDatas[pin.materialIndex];
+#else
+    MaterialData matData = gMaterialDatas[materialIndex];
+#endif
+    diffuseAlbedo *= matData.diffuseAlbedo;
+    float3 fresnelR0 = matData.fresnelR0;
+    float roughness = matData.roughness;
+#else
+    float3 fresnelR0 = gFresnelR0;
+    float roughness = gRoughness;
+#endif
+    
+#if ALPHA_TEST
+    // Before any lighting work, so discarded pixels cost only the texture fetch.
+    clip(diffuseAlbedo.a - 0.1f);
+#endif
+    
+    pin.NormalW = normalize(pin.NormalW);
+    
+    float3 toEyeW = normalize(cameraPosition - pin.PosW);
+    
+    float4 ambient = gAmbientLight * diffuseAlbedo;
+    
+    const float shininess = 1.0f - roughness;
+    Material mat = { diffuseAlbedo, fresnelR0, shininess };
+    float3 shadowFactor = 1.0f;
+#if SHADOWS
+    shadowFactor[0] = CalcShadowFactor(pin.PosW, pin.NormalW);
+#endif
+    float4 directLight = ComputeLighting(gLights, mat, pin.PosW,
+        pin.NormalW, toEyeW, shadowFactor);
+    
+#if CLUSTERED_LIGHTING
+    directLight.rgb += ComputeClusteredLighting(pin.PosH, pin.PosW, mat, pin.NormalW, toEyeW);
+#endif
+    
+    float4 litColor = ambient + directLight;
+    
+    litColor.a = diffuseAlbedo.a;
+    
+    return litColor;
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+// Depth only pass of the cascaded shadow maps (see CascadedShadows), cbScene holds the view projection of
+// the cascade being rendered. There is no pixel shader.
+//   INSTANCING : world matrix comes from gInstanceDatas[SV_InstanceID], the casters of the cascade
+#ifndef INSTANCING
+    #define INSTANCING 0
+#endif
+
+#include "common.hlsl"
+
+struct VertexIn
+{
+    float3 PosL : POSITION;
+    float3 NormalL : NORMAL;
+    float2 TexC : TEXCOORD;
+};
+
+#if INSTANCING
+float4 VSMain(VertexIn vin, uint instanceID : SV_InstanceID) : SV_POSITION
+#else
+float4 VSMain(VertexIn vin) : SV_POSITION
+#endif
+{
+#if INSTANCING
+    float4x4 world = gInstanceDatas[instanceID].world;
+#else
+    float4x4 world = gWorld;
+#endif
+    
+    float4 posW = mul(float4(vin.PosL, 1.0f), world);
+    
+    return mul(posW, gViewProj);
+}
\ No newline at end of file
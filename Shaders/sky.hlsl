@@ -17,12 +17,12 @@ VertexOut VSMain(VertexIn vin)
 {
     VertexOut vout;
     
-    float4x4 viewProj = mul(gView, gProj);
-    
     float4 posW = mul(float4(vin.PosL, 1.0), gWorld);
     // posW.xyz += cameraPosition;
     
-    vout.PosH = mul(posW, viewProj).xyww;
+    // keep the sky on the far plane, z = w is depth 1 and z = 0 is reversed-Z's far plane
+    vout.PosH = mul(posW, gViewProj).xyww;
+    vout.PosH.z *= gFarDepth;
     
     vout.PosL = vin.PosL;
     
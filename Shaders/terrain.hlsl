@@ -1,5 +1,28 @@
 #include "common.hlsl"
 
+// Mirrors TerrainPatchData in TerrainTessellation.h, edges in SV_TessFactor order.
+struct TerrainPatch
+{
+    float4 Rect;
+    float4 EdgeErrors;
+    float4 EdgeHeights;
+    float MinHeight;
+    float MaxHeight;
+    float2 Pad;
+};
+
+// Mirrors TessellationConstant in TerrainTessellation.h.
+cbuffer cbTessellation : register(b6)
+{
+    float4 gFrustumPlanes[6];
+    float gProjScale;
+    float gPixelError;
+    float gMinTrianglePixels;
+    float gMaxTessFactor;
+};
+
+StructuredBuffer<TerrainPatch> gTerrainPatches : register(t6, space1);
+
 struct VertexIn
 {
     float3 PosL : POSITION;
@@ -42,18 +65,62 @@ VertexOut VSMain(VertexIn vin)
     return vout;
 }
 
+// Same as TerrainTessellation::ComputeEdgeFactor. The height error of the flat patch should be gPixelError
+// pixels on screen, it shrinks with the square of the factor on smooth terrain.
+float EdgeTessFactor(float edgeLength, float edgeError, float3 edgeCenter)
+{
+    float pixelsPerUnit = gProjScale / max(distance(edgeCenter, cameraPosition), 0.001f);
+    
+    float errorFactor = sqrt(edgeError * pixelsPerUnit / gPixelError);
+    float lengthFactor = edgeLength * pixelsPerUnit / gMinTrianglePixels;
+    
+    return clamp(min(errorFactor, lengthFactor), 1.0f, gMaxTessFactor);
+}
+
+// Patch data is in world space, the terrain is drawn with an identity world matrix.
 PatchTess ConstantHSMain(InputPatch<VertexOut, 4> patch,
                          uint patchID : SV_PrimitiveID)
 {
     PatchTess pt;
     
-    pt.EdgeTess[0] = 16;
-    pt.EdgeTess[1] = 16;
-    pt.EdgeTess[2] = 16;
-    pt.EdgeTess[3] = 16;
+    TerrainPatch terrainPatch = gTerrainPatches[patchID];
+    float4 rect = terrainPatch.Rect;
     
-    pt.InsideTess[0] = 16;
-    pt.InsideTess[1] = 16;
+    // A factor of 0 culls the patch, test the bounds of the displaced patch against the frustum.
+    [unroll]
+    for (int i = 0; i < 6; ++i)
+    {
+        float4 plane = gFrustumPlanes[i];
+        float3 outer = float3(
+            plane.x >= 0.0f ? rect.z : rect.x,
+            plane.y >= 0.0f ? terrainPatch.MaxHeight : terrainPatch.MinHeight,
+            plane.z >= 0.0f ? rect.w : rect.y);
+        
+        if (dot(plane.xyz, outer) + plane.w < 0.0f)
+        {
+            pt.EdgeTess[0] = 0.0f;
+            pt.EdgeTess[1] = 0.0f;
+            pt.EdgeTess[2] = 0.0f;
+            pt.EdgeTess[3] = 0.0f;
+            pt.InsideTess[0] = 0.0f;
+            pt.InsideTess[1] = 0.0f;
+            
+            return pt;
+        }
+    }
+    
+    // Every input of an edge's factor is shared with the patch on its other side, so there are no cracks.
+    float2 center = 0.5f * (rect.xy + rect.zw);
+    float4 edgeErrors = terrainPatch.EdgeErrors;
+    float4 edgeHeights = terrainPatch.EdgeHeights;
+    
+    pt.EdgeTess[0] = EdgeTessFactor(rect.w - rect.y, edgeErrors.x, float3(rect.x, edgeHeights.x, center.y));
+    pt.EdgeTess[1] = EdgeTessFactor(rect.z - rect.x, edgeErrors.y, float3(center.x, edgeHeights.y, rect.y));
+    pt.EdgeTess[2] = EdgeTessFactor(rect.w - rect.y, edgeErrors.z, float3(rect.z, edgeHeights.z, center.y));
+    pt.EdgeTess[3] = EdgeTessFactor(rect.z - rect.x, edgeErrors.w, float3(center.x, edgeHeights.w, rect.w));
+    
+    pt.InsideTess[0] = max(pt.EdgeTess[1], pt.EdgeTess[3]);
+    pt.InsideTess[1] = max(pt.EdgeTess[0], pt.EdgeTess[2]);
     
     return pt;
 }
@@ -104,11 +171,9 @@ DomainOut DSMain(PatchTess patchTess,
     // displace point along normal
     PosL += dout.NormalL * dout.Height;
     
-    float4x4 viewProj = mul(gView, gProj);
-    float4x4 worldViewProj = mul(gWorld, viewProj);
-    
     // output patch point position in clip space
-    dout.PosH = mul(float4(PosL, 1.0), worldViewProj);
+    float4 PosW = mul(float4(PosL, 1.0), gWorld);
+    dout.PosH = mul(PosW, gViewProj);
     
     return dout;
 }
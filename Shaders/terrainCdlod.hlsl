@@ -0,0 +1,91 @@
+// Quadtree terrain chunks selected on the CPU by TerrainQuadtree. Every instance is one chunk drawn with the
+// shared grid mesh, the height comes from the heightmap in gDiffuseTexture. Towards the end of its LOD range
+// a chunk moves its odd vertices onto the grid of the next coarser level, so neighbouring levels meet.
+#include "common.hlsl"
+
+// Mirrors TerrainChunkData in TerrainQuadtree.h.
+struct TerrainChunk
+{
+    float2 Origin;
+    float Size;
+    float CellCount;
+    float MorphStart;
+    float MorphEnd;
+    uint LodLevel;
+    float Pad0;
+};
+
+// Mirrors TerrainConstant in TerrainQuadtree.h.
+cbuffer cbTerrain : register(b5)
+{
+    float2 gTerrainOrigin;
+    float2 gTerrainSize;
+    float gHeightScale;
+    float gHeightOffset;
+    float gSampleSpacing;
+    float terrainPad0;
+};
+
+StructuredBuffer<TerrainChunk> gTerrainChunks : register(t5, space1);
+
+struct VertexIn
+{
+    float3 PosL : POSITION;
+    float3 NormalL : NORMAL;
+    float2 TexC : TEXCOORD;
+};
+
+struct VertexOut
+{
+    float4 PosH : SV_POSITION;
+    float3 NormalW : NORMAL;
+    float Height : HEIGHT;
+};
+
+float SampleHeight(float2 posXZ)
+{
+    float2 texC = (posXZ - gTerrainOrigin) / gTerrainSize;
+    return gDiffuseTexture.SampleLevel(gsamLinearClamp, texC, 0).r * gHeightScale + gHeightOffset;
+}
+
+VertexOut VSMain(VertexIn vin, uint instanceID : SV_InstanceID)
+{
+    VertexOut vout;
+    
+    TerrainChunk chunk = gTerrainChunks[instanceID];
+    
+    // The grid mesh spans [-0.5, 0.5], count its vertices from the chunk's min corner.
+    float2 vertex = round((vin.PosL.xz + 0.5f) * chunk.CellCount);
+    float cellSize = chunk.Size / chunk.CellCount;
+    float2 posXZ = chunk.Origin + vertex * cellSize;
+    
+    // Chunks start on even cells of their level, so the odd vertices of the chunk are the odd ones of the level.
+    float3 posW = float3(posXZ.x, SampleHeight(posXZ), posXZ.y);
+    float morphFactor = saturate((distance(posW, cameraPosition) - chunk.MorphStart) / (chunk.MorphEnd - chunk.MorphStart));
+    posXZ -= frac(vertex * 0.5f) * 2.0f * cellSize * morphFactor;
+    
+    // Chunks on the far edges of the map stick out of it.
+    posXZ = min(posXZ, gTerrainOrigin + gTerrainSize);
+    
+    vout.Height = SampleHeight(posXZ);
+    
+    // Central differences one texel apart.
+    float2 dx = float2(gSampleSpacing, 0.0f);
+    float2 dz = float2(0.0f, gSampleSpacing);
+    vout.NormalW = normalize(float3(
+        SampleHeight(posXZ - dx) - SampleHeight(posXZ + dx),
+        2.0f * gSampleSpacing,
+        SampleHeight(posXZ - dz) - SampleHeight(posXZ + dz)));
+    
+    vout.PosH = mul(float4(posXZ.x, vout.Height, posXZ.y, 1.0f), gViewProj);
+    
+    return vout;
+}
+
+float4 PSMain(VertexOut pin) : SV_Target
+{
+    float h = (pin.Height - gHeightOffset) / gHeightScale;
+    float diffuse = saturate(dot(normalize(pin.NormalW), -normalize(gLights[0].direction)));
+    
+    return float4(h * (gAmbientLight.rgb + diffuse * gLights[0].strength), 1.0f);
+}
\ No newline at end of file
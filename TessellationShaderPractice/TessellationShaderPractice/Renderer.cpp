@@ -24,7 +24,11 @@ Renderer::Renderer(HINSTANCE hInstance)
 		0.0f, 0.0f, 0.0f,
 		0.0f, 1.0f, 0.0f);
 
-	mCamera.SetLens(0.25f * XM_PI, aspectRatio, 1.0f, 1000.0f);
+	// Reversed-Z with an infinite far plane for the large terrain, 1000 is only the culling distance.
+	mCamera.SetDepthMode(DepthMode::ReversedInfinite);
+	mCamera.SetLens(0.25f * XM_PI, aspectRatio, 0.1f, 1000.0f);
+
+	mDepthStencil.SetReversedZ(mCamera.IsReversedZ());
 }
 Renderer::~Renderer()
 {
@@ -88,18 +92,22 @@ void Renderer::Initialize()
 		mDepthStencil.GetDepthStencilBufferFormat(), D3D12_DSV_DIMENSION_TEXTURE2D, 
 		mDepthStencil.GetDepthStencilBuffer());
 
-	// Create meshes
+	// Create meshes in one vertex and index buffer, their data goes through one staging ring
+	mGeometryPool = std::make_unique<GeometryPool>(device, 65536, 262144);
+	D3D12GeometryCopyQueue geometryCopyQueue(device, commandQueue);
+	GeometryUploader geometryUploader(geometryCopyQueue);
+
 	BasicGeometryGenerator geoGenerator;
-	auto box = geoGenerator.CreateBox(2.0f, 2.0f, 2.0f);
-	box.ConfigureMesh(device, commandList);
+	Mesh box = geoGenerator.CreateBox(2.0f, 2.0f, 2.0f);
+	box.ConfigureMesh(*mGeometryPool, geometryUploader);
 	mMeshes.insert({ "box", std::move(box) });
 
-	auto grid = geoGenerator.CreateGrid(10.0f, 20.0f, 10, 20);
-	grid.ConfigureMesh(device, commandList);
+	Mesh grid = geoGenerator.CreateGrid(10.0f, 20.0f, 10, 20);
+	grid.ConfigureMesh(*mGeometryPool, geometryUploader);
 	mMeshes.insert({ "grid", std::move(grid) });
 
-	auto sphere = geoGenerator.CreateSphere(0.5f, 20, 20);
-	sphere.ConfigureMesh(device, commandList);
+	Mesh sphere = geoGenerator.CreateSphere(0.5f, 20, 20);
+	sphere.ConfigureMesh(*mGeometryPool, geometryUploader);
 	mMeshes.insert({ "sphere", std::move(sphere) });
 
 	int width, height, nChannels;
@@ -107,17 +115,49 @@ void Renderer::Initialize()
 		&width, &height, &nChannels,
 		0);
 
-	auto terrain = geoGenerator.CreateTerrainPatches(width, height, 20);
-	terrain.ConfigureMesh(device, commandList);
+	const uint32_t countOfPatches = 20;
+	Mesh terrain = geoGenerator.CreateTerrainPatches(width, height, countOfPatches);
+	terrain.ConfigureMesh(*mGeometryPool, geometryUploader);
 	mMeshes.insert({ "terrain", std::move(terrain) });
 
+	// Height error of every patch for the tessellation factors
+	mTerrainTessellation.Build(data, width, height, nChannels, countOfPatches);
+
+	// The same heightmap as quadtree chunks, drawn with the full grid or the half grid on a quarter of a node
+	mTerrainQuadtree.Build(data, width, height, nChannels);
+
+	mHeightfield.Build(data, width, height, nChannels);
+
+	uint32_t chunkSize = mTerrainQuadtree.GetChunkSize();
+	Mesh terrainChunk = geoGenerator.CreateGrid(1.0f, 1.0f, chunkSize + 1, chunkSize + 1);
+	terrainChunk.ConfigureMesh(*mGeometryPool, geometryUploader);
+	mMeshes.insert({ "terrainChunk", std::move(terrainChunk) });
+
+	Mesh terrainHalfChunk = geoGenerator.CreateGrid(1.0f, 1.0f, chunkSize / 2 + 1, chunkSize / 2 + 1);
+	terrainHalfChunk.ConfigureMesh(*mGeometryPool, geometryUploader);
+	mMeshes.insert({ "terrainHalfChunk", std::move(terrainHalfChunk) });
+
 	stbi_image_free(data);
 
+	// The GPU copies are all that is needed from here on
+	geometryUploader.WaitIdle();
+	for (auto& mesh : mMeshes)
+		mesh.second.ReleaseCpuData();
+
 	// Initialize constant buffer
 	mObjectCBs = std::make_unique<UploadBuffer<ObjectConstant>>(device, 5, true);
 	mSceneCBs = std::make_unique<UploadBuffer<SceneConstant>>(device, 1, true);
 	mMaterialBuffers = std::make_unique<UploadBuffer<MaterialData>>(device, 4, false);
 	mInstanceBuffers = std::make_unique<UploadBuffer<InstanceData>>(device, 100, false);
+	// Every node is selected at most once, either whole or as the quarter of its parent.
+	mTerrainChunkBuffers = std::make_unique<UploadBuffer<TerrainChunkData>>(device, mTerrainQuadtree.GetNodeCount(), false);
+	mTerrainCBs = std::make_unique<UploadBuffer<TerrainConstant>>(device, 1, true);
+	mTerrainCBs->CopyData(0, mTerrainQuadtree.GetTerrainConstant());
+
+	const auto& patchDatas = mTerrainTessellation.GetPatchDatas();
+	mTerrainPatchBuffers = std::make_unique<UploadBuffer<TerrainPatchData>>(device, (UINT)patchDatas.size(), false);
+	mTerrainPatchBuffers->CopyData(0, patchDatas.data(), (UINT)patchDatas.size());
+	mTessellationCBs = std::make_unique<UploadBuffer<TessellationConstant>>(device, 1, true);
 
 	// Create descriptor heap
 	mCbvSrvUavDescriptor.CreateDescriptorHeap(device, 5);
@@ -150,15 +190,15 @@ void Renderer::Initialize()
 	// Create vertex and pixel shader
 	Shader vertexShader;
 	Shader pixelShader; 
-	vertexShader.CompileShader(L"../../Shaders/dynamicIndexing.hlsl", nullptr, "VSMain", "vs_5_1");
-	pixelShader.CompileShader(L"../../Shaders/dynamicIndexing.hlsl", nullptr, "PSMain", "ps_5_1");
+	vertexShader.CompileShader(L"../../Shaders/dynamicIndexing.hlsl", nullptr, "VSMain", "vs_5_1", &mShaderCache);
+	pixelShader.CompileShader(L"../../Shaders/dynamicIndexing.hlsl", nullptr, "PSMain", "ps_5_1", &mShaderCache);
 	mShaders.insert({ "opaqueVS", std::move(vertexShader) });
 	mShaders.insert({ "opaquePS", std::move(pixelShader) });
 
 	Shader instancingVertexShader;
 	Shader instancingPixelShader;
-	instancingVertexShader.CompileShader(L"../../Shaders/instancing.hlsl", nullptr, "VSMain", "vs_5_1");
-	instancingPixelShader.CompileShader(L"../../Shaders/instancing.hlsl", nullptr, "PSMain", "ps_5_1");
+	instancingVertexShader.CompileShader(L"../../Shaders/instancing.hlsl", nullptr, "VSMain", "vs_5_1", &mShaderCache);
+	instancingPixelShader.CompileShader(L"../../Shaders/instancing.hlsl", nullptr, "PSMain", "ps_5_1", &mShaderCache);
 	mShaders.insert({ "instancingVS", std::move(instancingVertexShader) });
 	mShaders.insert({ "instancingPS", std::move(instancingPixelShader) });
 
@@ -166,19 +206,26 @@ void Renderer::Initialize()
 	Shader terrainHullShader;
 	Shader terrainDomainShader;
 	Shader terrainPixelShader;
-	terrainVertexShader.CompileShader(L"../../Shaders/terrain.hlsl", nullptr, "VSMain", "vs_5_1");
-	terrainHullShader.CompileShader(L"../../Shaders/terrain.hlsl", nullptr, "HSMain", "hs_5_1");
-	terrainDomainShader.CompileShader(L"../../Shaders/terrain.hlsl", nullptr, "DSMain", "ds_5_1");
-	terrainPixelShader.CompileShader(L"../../Shaders/terrain.hlsl", nullptr, "PSMain", "ps_5_1");
+	terrainVertexShader.CompileShader(L"../../Shaders/terrain.hlsl", nullptr, "VSMain", "vs_5_1", &mShaderCache);
+	terrainHullShader.CompileShader(L"../../Shaders/terrain.hlsl", nullptr, "HSMain", "hs_5_1", &mShaderCache);
+	terrainDomainShader.CompileShader(L"../../Shaders/terrain.hlsl", nullptr, "DSMain", "ds_5_1", &mShaderCache);
+	terrainPixelShader.CompileShader(L"../../Shaders/terrain.hlsl", nullptr, "PSMain", "ps_5_1", &mShaderCache);
 	mShaders.insert({ "terrainVS", std::move(terrainVertexShader) });
 	mShaders.insert({ "terrainHS", std::move(terrainHullShader) });
 	mShaders.insert({ "terrainDS", std::move(terrainDomainShader) });
 	mShaders.insert({ "terrainPS", std::move(terrainPixelShader) });
 
+	Shader terrainChunkVertexShader;
+	Shader terrainChunkPixelShader;
+	terrainChunkVertexShader.CompileShader(L"../../Shaders/terrainCdlod.hlsl", nullptr, "VSMain", "vs_5_1", &mShaderCache);
+	terrainChunkPixelShader.CompileShader(L"../../Shaders/terrainCdlod.hlsl", nullptr, "PSMain", "ps_5_1", &mShaderCache);
+	mShaders.insert({ "terrainCdlodVS", std::move(terrainChunkVertexShader) });
+	mShaders.insert({ "terrainCdlodPS", std::move(terrainChunkPixelShader) });
+
 	Shader skyVertexShader;
 	Shader skyPixelShader;
-	skyVertexShader.CompileShader(L"../../Shaders/sky.hlsl", nullptr, "VSMain", "vs_5_1");
-	skyPixelShader.CompileShader(L"../../Shaders/sky.hlsl", nullptr, "PSMain", "ps_5_1");
+	skyVertexShader.CompileShader(L"../../Shaders/sky.hlsl", nullptr, "VSMain", "vs_5_1", &mShaderCache);
+	skyPixelShader.CompileShader(L"../../Shaders/sky.hlsl", nullptr, "PSMain", "ps_5_1", &mShaderCache);
 	mShaders.insert({ "skyVS", std::move(skyVertexShader) });
 	mShaders.insert({ "skyPS", std::move(skyPixelShader) });
 
@@ -187,8 +234,60 @@ void Renderer::Initialize()
 	CreateDefaultPSO(device, "opaque", "default", "opaque");
 	CreateDefaultPSO(device, "instancing", "default", "instancing");
 	CreateTessellationPSO(device, "terrain", "default", "terrain");
+	CreateDefaultPSO(device, "terrainCdlod", "default", "terrainCdlod");
 	CreateSkyboxPSO(device, "sky", "default", "sky");
 
+	// Rebuild a PSO when the sources of its shaders change
+	mShaderHotReloader = std::make_unique<ShaderHotReloader>(mShaderCache);
+	auto watchShaders = [this](const std::string& shaderName, const std::wstring& filename,
+		const std::vector<std::string>& stages, std::function<void()> createPSO)
+	{
+		// "VS" compiles VSMain with vs_5_1 into mShaders[shaderName + "VS"], and so on.
+		std::vector<HotReloadShaderDesc> shaders;
+		for (const auto& stage : stages)
+		{
+			std::string target = stage + "_5_1";
+			std::transform(target.begin(), target.end(), target.begin(), ::tolower);
+			shaders.push_back({ filename, {}, stage + "Main", target });
+		}
+
+		mShaderHotReloader->AddGroup(shaderName, shaders,
+			[this, shaderName, stages, createPSO](std::vector<Shader>& reloadedShaders)
+			{
+				for (size_t i = 0; i < stages.size(); i++)
+					mShaders[shaderName + stages[i]] = reloadedShaders[i];
+				createPSO();
+			});
+	};
+
+	watchShaders("opaque", L"../../Shaders/dynamicIndexing.hlsl", { "VS", "PS" }, [this, device]()
+		{
+			mPSOs.erase("opaque");
+			CreateDefaultPSO(device, "opaque", "default", "opaque");
+		});
+	watchShaders("instancing", L"../../Shaders/instancing.hlsl", { "VS", "PS" }, [this, device]()
+		{
+			mPSOs.erase("instancing");
+			CreateDefaultPSO(device, "instancing", "default", "instancing");
+		});
+	watchShaders("terrain", L"../../Shaders/terrain.hlsl", { "VS", "HS", "DS", "PS" }, [this, device]()
+		{
+			mPSOs.erase("terrain");
+			CreateTessellationPSO(device, "terrain", "default", "terrain");
+		});
+	watchShaders("terrainCdlod", L"../../Shaders/terrainCdlod.hlsl", { "VS", "PS" }, [this, device]()
+		{
+			mPSOs.erase("terrainCdlod");
+			CreateDefaultPSO(device, "terrainCdlod", "default", "terrainCdlod");
+		});
+	watchShaders("sky", L"../../Shaders/sky.hlsl", { "VS", "PS" }, [this, device]()
+		{
+			mPSOs.erase("sky");
+			CreateSkyboxPSO(device, "sky", "default", "sky");
+		});
+
+	mShaderHotReloader->Start();
+
 	BuildRenderItems();
 
 	ExecuteCommandLists(commandList, commandQueue);
@@ -215,6 +314,9 @@ int Renderer::RenderLoop()
 
 			if (!mAppPaused)
 			{
+				// DrawScene waits for the GPU, so the previous PSOs are no longer in use here.
+				mShaderHotReloader->ApplyPendingReloads();
+
 				ProcessKeyboardInput();
 				UpdateData();
 				DrawScene();
@@ -347,6 +449,10 @@ LRESULT CALLBACK Renderer::WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lP
 		{
 			PostQuitMessage(0);
 		}
+		else if (wParam == 'T')
+		{
+			mDrawTerrainChunks = !mDrawTerrainChunks;
+		}
 
 		return 0;
 	}
@@ -484,6 +590,17 @@ void Renderer::ProcessKeyboardInput()
 
 	if (GetAsyncKeyState('D') & 0x8000)
 		mCamera.Strafe(10.0f * dt);
+
+	// Don't fly through the terrain
+	const float eyeHeight = 2.0f;
+	XMFLOAT3 position = mCamera.GetPosition();
+	BoundingBox terrainBounds = mHeightfield.GetBounds();
+	if (std::fabs(position.x) <= terrainBounds.Extents.x && std::fabs(position.z) <= terrainBounds.Extents.z)
+	{
+		float groundHeight = mHeightfield.GetHeight(position.x, position.z);
+		if (position.y < groundHeight + eyeHeight)
+			mCamera.SetPosition(position.x, groundHeight + eyeHeight, position.z);
+	}
 }
 void Renderer::UpdateData()
 {
@@ -491,6 +608,8 @@ void Renderer::UpdateData()
 	UpdateSceneConstants();
 	UpdateMaterialDatas();
 	UpdateInstanceDatas();
+	UpdateTerrainChunks();
+	UpdateTerrainPatches();
 }
 void Renderer::DrawScene()
 {
@@ -516,7 +635,7 @@ void Renderer::DrawScene()
 		mSwapChain.GetCurrentBackBufferIndex(), mDirect3D.GetRtvDescriptorSize());
 	commandList->ClearRenderTargetView(currentRenderTargetView, Colors::Black, 0, nullptr);
 	commandList->ClearDepthStencilView(mDsvDescriptor.GetStartCPUDescriptorHandle(), 
-		D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
+		D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, mDepthStencil.GetClearDepth(), 0, 0, nullptr);
 
 	commandList->OMSetRenderTargets(1, &currentRenderTargetView, true, &mDsvDescriptor.GetStartCPUDescriptorHandle());
 
@@ -541,8 +660,19 @@ void Renderer::DrawScene()
 	commandList->SetPipelineState(mPSOs["opaque"].Get());
 	DrawRenderItems(RenderLayer::Opaque, commandList);
 
-	commandList->SetPipelineState(mPSOs["terrain"].Get());
-	DrawRenderItems(RenderLayer::Terrain, commandList);
+	if (mDrawTerrainChunks)
+	{
+		commandList->SetPipelineState(mPSOs["terrainCdlod"].Get());
+		DrawTerrainChunks(commandList);
+	}
+	else
+	{
+		commandList->SetGraphicsRootShaderResourceView(8, mTerrainPatchBuffers->GetUploadBuffer()->GetGPUVirtualAddress());
+		commandList->SetGraphicsRootConstantBufferView(9, mTessellationCBs->GetUploadBuffer()->GetGPUVirtualAddress());
+
+		commandList->SetPipelineState(mPSOs["terrain"].Get());
+		DrawRenderItems(RenderLayer::Terrain, commandList);
+	}
 
 	commandList->SetPipelineState(mPSOs["instancing"].Get());
 	DrawRenderItems(RenderLayer::Instancing, commandList);
@@ -584,16 +714,13 @@ void Renderer::UpdateSceneConstants()
 {
 	SceneConstant sceneConstant;
 
-	XMFLOAT4X4 view = mCamera.GetView();
-	XMFLOAT4X4 proj = mCamera.GetProj();
-
-	XMMATRIX v = XMLoadFloat4x4(&view);
-	XMMATRIX p = XMLoadFloat4x4(&proj);
-
-	XMStoreFloat4x4(&sceneConstant.view, XMMatrixTranspose(v));
-	XMStoreFloat4x4(&sceneConstant.proj, XMMatrixTranspose(p));
+	XMStoreFloat4x4(&sceneConstant.view, XMMatrixTranspose(XMLoadFloat4x4(&mCamera.GetView())));
+	XMStoreFloat4x4(&sceneConstant.proj, XMMatrixTranspose(XMLoadFloat4x4(&mCamera.GetProj())));
+	XMStoreFloat4x4(&sceneConstant.viewProj, XMMatrixTranspose(XMLoadFloat4x4(&mCamera.GetViewProj())));
+	XMStoreFloat4x4(&sceneConstant.invView, XMMatrixTranspose(XMLoadFloat4x4(&mCamera.GetInverseView())));
 
 	sceneConstant.cameraPosition = mCamera.GetPosition();
+	sceneConstant.farDepth = mCamera.IsReversedZ() ? 0.0f : 1.0f;
 
 	sceneConstant.ambientLight = XMFLOAT4{ 0.25f, 0.15f, 0.35f, 1.0f };
 	sceneConstant.lights[0].direction = XMFLOAT3{ 0.0f, -1.0f, -1.0f };
@@ -643,6 +770,20 @@ void Renderer::UpdateInstanceDatas()
 		}
 	}
 }
+void Renderer::UpdateTerrainChunks()
+{
+	mTerrainQuadtree.Select(mCamera);
+
+	const auto& chunks = mTerrainQuadtree.GetSelection();
+	if (!chunks.empty())
+		mTerrainChunkBuffers->CopyData(0, chunks.data(), (UINT)chunks.size());
+}
+void Renderer::UpdateTerrainPatches()
+{
+	mTerrainTessellation.Update(mCamera, mScreenViewport.Height);
+
+	mTessellationCBs->CopyData(0, mTerrainTessellation.GetTessellationConstant());
+}
 
 void Renderer::EnableDebugLayer()
 {
@@ -701,17 +842,21 @@ void Renderer::CreateRootSignature(ID3D12Device* device, const std::string& root
 	CD3DX12_DESCRIPTOR_RANGE texTable1;
 	texTable1.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 1);
 
-	CD3DX12_ROOT_PARAMETER slotRootParameters[6];
+	CD3DX12_ROOT_PARAMETER slotRootParameters[10];
 	slotRootParameters[0].InitAsConstantBufferView(0);
 	slotRootParameters[1].InitAsConstantBufferView(1);
 	slotRootParameters[2].InitAsShaderResourceView(0, 1);
 	slotRootParameters[3].InitAsShaderResourceView(1, 1);
 	slotRootParameters[4].InitAsDescriptorTable(1, &texTable0, D3D12_SHADER_VISIBILITY_ALL);
 	slotRootParameters[5].InitAsDescriptorTable(1, &texTable1, D3D12_SHADER_VISIBILITY_PIXEL);
+	slotRootParameters[6].InitAsShaderResourceView(5, 1);
+	slotRootParameters[7].InitAsConstantBufferView(5);
+	slotRootParameters[8].InitAsShaderResourceView(6, 1);
+	slotRootParameters[9].InitAsConstantBufferView(6);
 
 	auto samplers = Texture::GetStaticSamplers();
 
-	CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc(6, slotRootParameters,
+	CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc(10, slotRootParameters,
 		(UINT)samplers.size(), samplers.data(), 
 		D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
 
@@ -739,7 +884,7 @@ void Renderer::CreateDefaultPSO(ID3D12Device* device, const std::string& psoName
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc;
 	ZeroMemory(&psoDesc, sizeof(D3D12_GRAPHICS_PIPELINE_STATE_DESC));
 	psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
-	psoDesc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
+	psoDesc.DepthStencilState = mDepthStencil.GetDepthStencilDesc();
 	psoDesc.DSVFormat = mDepthStencil.GetDepthStencilBufferFormat();
 	psoDesc.InputLayout = { mInputLayout.data(), (UINT)mInputLayout.size() };
 	psoDesc.NumRenderTargets = 1;
@@ -765,7 +910,7 @@ void Renderer::CreateTessellationPSO(ID3D12Device* device, const std::string& ps
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc;
 	ZeroMemory(&psoDesc, sizeof(D3D12_GRAPHICS_PIPELINE_STATE_DESC));
 	psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
-	psoDesc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
+	psoDesc.DepthStencilState = mDepthStencil.GetDepthStencilDesc();
 	psoDesc.DSVFormat = mDepthStencil.GetDepthStencilBufferFormat();
 	psoDesc.InputLayout = { mInputLayout.data(), (UINT)mInputLayout.size() };
 	psoDesc.NumRenderTargets = 1;
@@ -794,8 +939,7 @@ void Renderer::CreateSkyboxPSO(ID3D12Device* device, const std::string& psoName,
 	ZeroMemory(&psoDesc, sizeof(D3D12_GRAPHICS_PIPELINE_STATE_DESC));
 	psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
 
-	psoDesc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
-	psoDesc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS_EQUAL;
+	psoDesc.DepthStencilState = mDepthStencil.GetDepthStencilDesc(true);
 
 	psoDesc.DSVFormat = mDepthStencil.GetDepthStencilBufferFormat();
 	psoDesc.InputLayout = { mInputLayout.data(), (UINT)mInputLayout.size() };
@@ -965,15 +1109,32 @@ void Renderer::DrawRenderItems(RenderLayer renderLayer, ID3D12GraphicsCommandLis
 
 	auto renderItems = mAllRenderItems[renderLayer];
 
+	// The meshes share the pool's buffers, they are bound again only when a mesh isn't in the pool.
+	D3D12_GPU_VIRTUAL_ADDRESS boundVertexBuffer = 0;
+	D3D12_GPU_VIRTUAL_ADDRESS boundIndexBuffer = 0;
+	D3D_PRIMITIVE_TOPOLOGY boundPrimitiveType = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+
 	for (auto& renderItem : renderItems)
 	{
 		auto vbv = renderItem.mesh.GetVertexBufferView();
 		auto ibv = renderItem.mesh.GetIndexBufferView();
 		auto primitiveType = renderItem.mesh.GetPrimitiveType();
 
-		commandList->IASetVertexBuffers(0, 1, &vbv);
-		commandList->IASetIndexBuffer(&ibv);
-		commandList->IASetPrimitiveTopology(primitiveType);
+		if (vbv.BufferLocation != boundVertexBuffer)
+		{
+			commandList->IASetVertexBuffers(0, 1, &vbv);
+			boundVertexBuffer = vbv.BufferLocation;
+		}
+		if (ibv.BufferLocation != boundIndexBuffer)
+		{
+			commandList->IASetIndexBuffer(&ibv);
+			boundIndexBuffer = ibv.BufferLocation;
+		}
+		if (primitiveType != boundPrimitiveType)
+		{
+			commandList->IASetPrimitiveTopology(primitiveType);
+			boundPrimitiveType = primitiveType;
+		}
 
 		if (renderItem.instanceCount == 1)
 		{
@@ -994,7 +1155,43 @@ void Renderer::DrawRenderItems(RenderLayer renderLayer, ID3D12GraphicsCommandLis
 		cbvSrvUavDescriptor.Offset(renderItem.diffuseMapIndex, mDirect3D.GetCbvSrvUavDescriptorSize());
 		commandList->SetGraphicsRootDescriptorTable(4, cbvSrvUavDescriptor);
 
-		commandList->DrawIndexedInstanced(renderItem.mesh.GetIndexCount(), 
-			renderItem.instanceCount, 0, 0, 0);
+		commandList->DrawIndexedInstanced(renderItem.mesh.GetIndexCount(), renderItem.instanceCount,
+			renderItem.mesh.GetStartIndexLocation(), renderItem.mesh.GetBaseVertexLocation(), 0);
 	}
+}
+void Renderer::DrawTerrainChunks(ID3D12GraphicsCommandList* commandList)
+{
+	const auto& chunks = mTerrainQuadtree.GetSelection();
+	UINT fullGridChunkCount = mTerrainQuadtree.GetFullGridChunkCount();
+
+	commandList->SetGraphicsRootConstantBufferView(7, mTerrainCBs->GetUploadBuffer()->GetGPUVirtualAddress());
+
+	// Heightmap
+	CD3DX12_GPU_DESCRIPTOR_HANDLE cbvSrvUavDescriptor(mCbvSrvUavDescriptor.GetStartGPUDescriptorHandle());
+	cbvSrvUavDescriptor.Offset(3, mDirect3D.GetCbvSrvUavDescriptorSize());
+	commandList->SetGraphicsRootDescriptorTable(4, cbvSrvUavDescriptor);
+
+	// Both grids are in the geometry pool, one binding serves the two draws.
+	auto vbv = mGeometryPool->GetVertexBufferView();
+	auto ibv = mGeometryPool->GetIndexBufferView();
+	commandList->IASetVertexBuffers(0, 1, &vbv);
+	commandList->IASetIndexBuffer(&ibv);
+	commandList->IASetPrimitiveTopology(mMeshes["terrainChunk"].GetPrimitiveType());
+
+	// SV_InstanceID starts at 0 in every draw, so the half grid chunks get a view starting at their first one.
+	auto drawChunks = [this, commandList](Mesh& mesh, UINT firstChunk, UINT chunkCount)
+	{
+		if (chunkCount == 0)
+			return;
+
+		auto chunkBufferAddress = mTerrainChunkBuffers->GetUploadBuffer()->GetGPUVirtualAddress();
+		chunkBufferAddress += firstChunk * sizeof(TerrainChunkData);
+		commandList->SetGraphicsRootShaderResourceView(6, chunkBufferAddress);
+
+		commandList->DrawIndexedInstanced(mesh.GetIndexCount(), chunkCount,
+			mesh.GetStartIndexLocation(), mesh.GetBaseVertexLocation(), 0);
+	};
+
+	drawChunks(mMeshes["terrainChunk"], 0, fullGridChunkCount);
+	drawChunks(mMeshes["terrainHalfChunk"], fullGridChunkCount, (UINT)chunks.size() - fullGridChunkCount);
 }
\ No newline at end of file
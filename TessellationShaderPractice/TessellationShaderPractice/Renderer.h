@@ -2,14 +2,21 @@
 #include "../../Core/includes/BasicGeometryGenerator.h"
 #include "../../Core/includes/Camera.h"
 #include "../../Core/includes/Command.h"
+#include "../../Core/includes/D3D12GeometryCopyQueue.h"
 #include "../../Core/includes/DepthStencil.h"
 #include "../../Core/includes/Descriptor.h"
 #include "../../Core/includes/Direct3d.h"
+#include "../../Core/includes/GeometryPool.h"
+#include "../../Core/includes/Heightfield.h"
 #include "../../Core/includes/Mesh.h"
 #include "../../Core/includes/Model.h"
 #include "../../Core/includes/Shader.h"
+#include "../../Core/includes/ShaderCache.h"
+#include "../../Core/includes/ShaderHotReloader.h"
 #include "../../Core/includes/Stdafx.h"
 #include "../../Core/includes/SwapChain.h"
+#include "../../Core/includes/TerrainQuadtree.h"
+#include "../../Core/includes/TerrainTessellation.h"
 #include "../../Core/includes/Texture.h"
 #include "../../Core/includes/Timer.h"
 #include "../../Core/includes/UploadBuffer.h"
@@ -70,9 +77,11 @@ struct SceneConstant
 {
 	DirectX::XMFLOAT4X4 view;
 	DirectX::XMFLOAT4X4 proj;
+	DirectX::XMFLOAT4X4 viewProj;
+	DirectX::XMFLOAT4X4 invView;
 
 	DirectX::XMFLOAT3 cameraPosition;
-	float pad0;
+	float farDepth = 1.0f;
 
 	DirectX::XMFLOAT4 ambientLight;
 	std::array<Light, Light::maxNumLights> lights;
@@ -143,6 +152,8 @@ private:
 	void UpdateSceneConstants();
 	void UpdateMaterialDatas();
 	void UpdateInstanceDatas();
+	void UpdateTerrainChunks();
+	void UpdateTerrainPatches();
 
 	void EnableDebugLayer();
 	void CheckMultiSamplingSupport(ID3D12Device* device, DXGI_FORMAT backBufferFormat);
@@ -162,6 +173,7 @@ private:
 
 	void BuildRenderItems();
 	void DrawRenderItems(RenderLayer renderLayer, ID3D12GraphicsCommandList* commandList);
+	void DrawTerrainChunks(ID3D12GraphicsCommandList* commandList);
 private:
 	// Window size variables.
 	UINT mWindowWidth;
@@ -183,6 +195,8 @@ private:
 	CbvSrvUavDescriptor mCbvSrvUavDescriptor;
 
 	std::unordered_map<std::string, Shader> mShaders;
+	ShaderCache mShaderCache{ "ShaderCache" }; // bytecode of previous runs
+	std::unique_ptr<ShaderHotReloader> mShaderHotReloader;
 
 	std::unordered_map<std::string, RootSignature> mRootSignatures; // default count is 1
 	std::unordered_map<std::string, PipelineStateObject> mPSOs; // default count is 1
@@ -194,6 +208,7 @@ private:
 	Timer mTimer;
 
 	std::unordered_map<std::string, Mesh> mMeshes;
+	std::unique_ptr<GeometryPool> mGeometryPool = nullptr; // vertices and indices of every mesh
 	std::unordered_map<std::string, Texture> mTextures;
 	std::unordered_map<std::string, Material> mMaterials;
 
@@ -201,6 +216,17 @@ private:
 	std::unique_ptr<UploadBuffer<SceneConstant>> mSceneCBs = nullptr;
 	std::unique_ptr<UploadBuffer<MaterialData>> mMaterialBuffers = nullptr;
 	std::unique_ptr<UploadBuffer<InstanceData>> mInstanceBuffers = nullptr;
+	std::unique_ptr<UploadBuffer<TerrainChunkData>> mTerrainChunkBuffers = nullptr;
+	std::unique_ptr<UploadBuffer<TerrainConstant>> mTerrainCBs = nullptr;
+	std::unique_ptr<UploadBuffer<TerrainPatchData>> mTerrainPatchBuffers = nullptr;
+	std::unique_ptr<UploadBuffer<TessellationConstant>> mTessellationCBs = nullptr;
+
+	// The heightmap as quadtree chunks, T switches back to the tessellated patches.
+	TerrainQuadtree mTerrainQuadtree;
+	bool mDrawTerrainChunks = true;
+	TerrainTessellation mTerrainTessellation;
+	// CPU copy of the heightmap for queries, the camera stays above the ground.
+	Heightfield mHeightfield;
 
 	std::vector<RenderItem> mOpaqueRenderItems;
 	std::vector<RenderItem> mInstancingRenderItems;